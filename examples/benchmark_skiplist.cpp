@@ -10,11 +10,12 @@
 #include <string_view>
 #include <vector>
 
-#include "skiplist.h"
+#include "fat_skiplist.h"
 
 struct Options {
     std::size_t n = 100000;
     std::size_t reads = 0;
+    std::size_t mixed = 0;
     std::uint32_t seed = 12345;
     int max_level = 16;
     float p = 0.5f;
@@ -26,9 +27,10 @@ static bool starts_with(std::string_view s, std::string_view prefix) {
 
 static void print_usage(const char* prog) {
     std::cout
-        << "Usage: " << prog << " [--n N] [--reads R] [--seed S] [--max-level L] [--p P]\n"
+        << "Usage: " << prog << " [--n N] [--reads R] [--mixed M] [--seed S] [--max-level L] [--p P]\n"
         << "  --n         number of unique keys (default: 100000)\n"
-        << "  --reads     number of lookups (default: n)\n"
+        << "  --reads     number of lookups per read phase (default: n)\n"
+        << "  --mixed     number of delete+insert pairs on the loaded table (default: n)\n"
         << "  --seed      shuffle seed (default: 12345)\n"
         << "  --max-level skiplist max level (default: 16)\n"
         << "  --p         promotion probability (default: 0.5)\n";
@@ -45,6 +47,10 @@ static bool parse_args(int argc, char** argv, Options& opt) {
                 opt.reads = static_cast<std::size_t>(std::stoull(std::string(value)));
                 return true;
             }
+            if (key == "--mixed") {
+                opt.mixed = static_cast<std::size_t>(std::stoull(std::string(value)));
+                return true;
+            }
             if (key == "--seed") {
                 opt.seed = static_cast<std::uint32_t>(std::stoul(std::string(value)));
                 return true;
@@ -87,6 +93,7 @@ static bool parse_args(int argc, char** argv, Options& opt) {
     }
 
     if (opt.reads == 0) opt.reads = opt.n;
+    if (opt.mixed == 0) opt.mixed = opt.n;
     if (opt.n == 0) return false;
     if (opt.max_level <= 0) return false;
     if (!(opt.p > 0.0f && opt.p < 1.0f)) return false;
@@ -119,6 +126,61 @@ static void print_result(std::string_view name, std::string_view phase, std::chr
               << "\n";
 }
 
+/// 一种实现在各阶段的耗时
+struct PhaseTimes {
+    std::chrono::nanoseconds insert{};
+    std::chrono::nanoseconds read{};      // 随机查找
+    std::chrono::nanoseconds seqread{};   // 按 key 升序查找
+    std::chrono::nanoseconds mixed{};
+    std::uint64_t checksum = 0;
+};
+
+/**
+ * @brief 对接口与 SkipList 一致的跳表（SkipList / FatSkipList）依次运行各阶段
+ *
+ * keys 为打乱后的 [0, n)，sorted_keys 为升序的 [0, n)，victims 为混合负载中依次删除的 key。
+ */
+template <class Table>
+static PhaseTimes run_skiplist(const Options& opt, const std::vector<int>& keys,
+                               const std::vector<int>& sorted_keys, const std::vector<int>& victims) {
+    PhaseTimes t;
+    Table sl(opt.max_level, opt.p);
+    t.insert = time_it([&] {
+        for (int k : keys) {
+            sl.insert(k, k);
+        }
+    });
+
+    auto lookups = [&](const std::vector<int>& order) {
+        return time_it([&] {
+            for (std::size_t i = 0; i < opt.reads; ++i) {
+                const int* v = sl.find(order[i % order.size()]);
+                t.checksum += static_cast<std::uint64_t>(v != nullptr ? *v : 0);
+            }
+        });
+    };
+    t.read = lookups(keys);
+    t.seqread = lookups(sorted_keys);
+
+    // 混合负载：每步删除一个已有 key，再插入一个新 key，表的大小保持为 n
+    t.mixed = time_it([&] {
+        for (std::size_t i = 0; i < opt.mixed; ++i) {
+            t.checksum += sl.remove(victims[i]) ? 1 : 0;
+            int k = static_cast<int>(opt.n + i);
+            sl.insert(k, k);
+        }
+    });
+    return t;
+}
+
+static void print_phases(std::string_view name, const Options& opt, const PhaseTimes& t) {
+    print_result(name, "insert ", t.insert, static_cast<std::uint64_t>(opt.n));
+    print_result(name, "read   ", t.read, static_cast<std::uint64_t>(opt.reads));
+    print_result(name, "seqread", t.seqread, static_cast<std::uint64_t>(opt.reads));
+    print_result(name, "mixed  ", t.mixed, static_cast<std::uint64_t>(2 * opt.mixed));
+    std::cout << name << " checksum: " << t.checksum << "\n\n";
+}
+
 int main(int argc, char** argv) {
     Options opt;
     if (!parse_args(argc, argv, opt)) {
@@ -126,62 +188,62 @@ int main(int argc, char** argv) {
         return 2;
     }
 
-    std::vector<int> keys(opt.n);
-    std::iota(keys.begin(), keys.end(), 0);
+    std::vector<int> sorted_keys(opt.n);
+    std::iota(sorted_keys.begin(), sorted_keys.end(), 0);
+    std::vector<int> keys = sorted_keys;
     std::mt19937 rng(opt.seed);
     std::shuffle(keys.begin(), keys.end(), rng);
 
-    std::cout << "Benchmark: SkipList vs std::map\n";
-    std::cout << "n=" << opt.n << " reads=" << opt.reads << " seed=" << opt.seed
-              << " max_level=" << opt.max_level << " p=" << opt.p << "\n";
+    std::cout << "Benchmark: SkipList vs FatSkipList vs std::map\n";
+    std::cout << "n=" << opt.n << " reads=" << opt.reads << " mixed=" << opt.mixed
+              << " seed=" << opt.seed
+              << " max_level=" << opt.max_level << " p=" << opt.p
+              << " fat_node_keys=" << FatSkipList<int, int>::kNodeKeys << "\n";
     std::cout << "Note: build with Release/-O2 for meaningful numbers.\n\n";
 
-    std::uint64_t checksum_skiplist = 0;
-    std::uint64_t checksum_map = 0;
-
-    SkipList<int, int> sl(opt.max_level, opt.p);
-    auto sl_insert = time_it([&] {
-        for (int k : keys) {
-            sl.insert(k, k);
-        }
-    });
+    std::vector<int> victims(opt.mixed);
+    for (std::size_t i = 0; i < opt.mixed; ++i) {
+        victims[i] = i < keys.size() ? keys[i] : static_cast<int>(opt.n + i - keys.size());
+    }
 
-    auto sl_read = time_it([&] {
-        for (std::size_t i = 0; i < opt.reads; ++i) {
-            int k = keys[i % keys.size()];
-            auto v = sl.search(k);
-            checksum_skiplist += static_cast<std::uint64_t>(v.has_value() ? v.value() : 0);
-        }
-    });
+    PhaseTimes skiplist = run_skiplist<SkipList<int, int>>(opt, keys, sorted_keys, victims);
+    PhaseTimes fat = run_skiplist<FatSkipList<int, int>>(opt, keys, sorted_keys, victims);
 
+    PhaseTimes map;
     std::map<int, int> mp;
-    auto mp_insert = time_it([&] {
+    map.insert = time_it([&] {
         for (int k : keys) {
             mp.emplace(k, k);
         }
     });
 
-    auto mp_read = time_it([&] {
-        for (std::size_t i = 0; i < opt.reads; ++i) {
-            int k = keys[i % keys.size()];
-            auto it = mp.find(k);
-            checksum_map += static_cast<std::uint64_t>(it != mp.end() ? it->second : 0);
+    auto map_lookups = [&](const std::vector<int>& order) {
+        return time_it([&] {
+            for (std::size_t i = 0; i < opt.reads; ++i) {
+                auto it = mp.find(order[i % order.size()]);
+                map.checksum += static_cast<std::uint64_t>(it != mp.end() ? it->second : 0);
+            }
+        });
+    };
+    map.read = map_lookups(keys);
+    map.seqread = map_lookups(sorted_keys);
+
+    map.mixed = time_it([&] {
+        for (std::size_t i = 0; i < opt.mixed; ++i) {
+            map.checksum += mp.erase(victims[i]);
+            int k = static_cast<int>(opt.n + i);
+            mp.emplace(k, k);
         }
     });
 
-    print_result("SkipList", "insert", sl_insert, static_cast<std::uint64_t>(opt.n));
-    print_result("SkipList", "read  ", sl_read, static_cast<std::uint64_t>(opt.reads));
-    std::cout << "SkipList checksum: " << checksum_skiplist << "\n\n";
+    print_phases("SkipList", opt, skiplist);
+    print_phases("FatSkipList", opt, fat);
+    print_phases("std::map", opt, map);
 
-    print_result("std::map", "insert", mp_insert, static_cast<std::uint64_t>(opt.n));
-    print_result("std::map", "read  ", mp_read, static_cast<std::uint64_t>(opt.reads));
-    std::cout << "std::map checksum: " << checksum_map << "\n\n";
-
-    if (checksum_skiplist != checksum_map) {
+    if (skiplist.checksum != map.checksum || fat.checksum != map.checksum) {
         std::cerr << "checksum mismatch\n";
         return 1;
     }
 
     return 0;
 }
-
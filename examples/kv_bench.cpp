@@ -0,0 +1,660 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "kv_store.h"
+#include "statistics.h"
+
+/**
+ * @file kv_bench.cpp
+ * @brief KVStore 的基准测试套件（参照 LevelDB db_bench 与 YCSB 的标准负载）
+ *
+ * 依次运行 --benchmarks 中列出的负载，每个负载在 --threads 个线程上执行，报告：
+ * - 吞吐（ops/s、MB/s）与延迟分布（p50 / p99 / p99.9 / max，按操作类型分别统计）；
+ * - 写放大：本负载期间 WAL + L0 落盘 + Compaction 写入的字节数 / 用户写入的 Key+Value 字节数；
+ * - 读放大：每次点查 / Seek 平均访问的 Data Block 数（块缓存的命中 + 未命中，需要启用块缓存）；
+ * - 空间放大：数据目录的总字节数 / 全量扫描得到的存活 Key+Value 字节数。
+ * --json 把配置与全部结果写成一个 JSON 文件，便于在版本之间比较、发现性能回退。
+ */
+
+struct Options {
+    std::string db = "kv_bench_db";
+    std::string benchmarks = "fillseq,fillrandom,overwrite,readrandom,readmissing,seekrandom,deleterandom";
+    std::size_t num = 100000;
+    std::size_t reads = 0;  ///< 0 表示与 num 相同
+    std::size_t threads = 1;
+    std::size_t value_size = 100;
+    std::size_t seek_nexts = 10;
+    std::string distribution = "uniform";
+    double zipf_theta = 0.99;
+    std::string sync = "periodic";
+    std::size_t memtable_size = 4 << 20;
+    std::size_t cache_size = 8 << 20;
+    bool use_existing = false;
+    bool statistics = false;
+    bool mmap = false;
+    std::size_t min_blob_size = 0;
+    std::string json;
+    std::uint32_t seed = 12345;
+};
+
+static bool starts_with(std::string_view s, std::string_view prefix) {
+    return s.size() >= prefix.size() && s.substr(0, prefix.size()) == prefix;
+}
+
+static void print_usage(const char* prog) {
+    std::cout
+        << "Usage: " << prog << " [--benchmarks LIST] [--num N] [--reads R] [--threads T] [--value-size V]\n"
+        << "       [--distribution uniform|zipfian] [--zipf-theta Z] [--sync per-write|group|periodic]\n"
+        << "       [--db DIR] [--use-existing 0|1] [--memtable-size B] [--cache-size B] [--seek-nexts K]\n"
+        << "       [--statistics 0|1] [--mmap 0|1] [--min-blob-size B] [--json FILE] [--seed S]\n"
+        << "  --benchmarks    comma separated, run in order (default: fillseq,fillrandom,overwrite,\n"
+        << "                  readrandom,readmissing,seekrandom,deleterandom). Available:\n"
+        << "                    fillseq, fillrandom, overwrite, readrandom, readmissing, seekrandom,\n"
+        << "                    deleterandom, ycsba, ycsbb, ycsbc, ycsbd, ycsbe, ycsbf\n"
+        << "                  read / seek / ycsb workloads expect the key space to be loaded first\n"
+        << "  --num           key space size and ops of the write workloads (default: 100000)\n"
+        << "  --reads         ops of the read and ycsb workloads (default: num)\n"
+        << "  --threads       concurrent threads per benchmark (default: 1)\n"
+        << "  --value-size    bytes per value (default: 100)\n"
+        << "  --distribution  key choice of the random workloads (default: uniform)\n"
+        << "  --zipf-theta    zipfian skew (default: 0.99)\n"
+        << "  --sync          WAL sync mode (default: periodic)\n"
+        << "  --db            data directory (default: kv_bench_db)\n"
+        << "  --use-existing  keep the existing data directory instead of wiping it (default: 0)\n"
+        << "  --memtable-size memtable size limit in bytes (default: 4194304)\n"
+        << "  --cache-size    block cache capacity in bytes, 0 disables it (default: 8388608)\n"
+        << "  --seek-nexts    entries read after each seek (default: 10)\n"
+        << "  --statistics    collect KVStore statistics and print kv.stats at the end (default: 0)\n"
+        << "  --mmap          read SSTables through read-only memory maps (default: 0)\n"
+        << "  --min-blob-size store values of at least B bytes in blob files, 0 disables it (default: 0)\n"
+        << "  --json          also write machine readable results to FILE\n"
+        << "  --seed          random seed (default: 12345)\n";
+}
+
+static bool parse_args(int argc, char** argv, Options& opt) {
+    auto parse_kv = [&](std::string_view key, std::string_view value) -> bool {
+        try {
+            std::string v(value);
+            if (key == "--db") {
+                opt.db = v;
+            } else if (key == "--benchmarks") {
+                opt.benchmarks = v;
+            } else if (key == "--num") {
+                opt.num = static_cast<std::size_t>(std::stoull(v));
+            } else if (key == "--reads") {
+                opt.reads = static_cast<std::size_t>(std::stoull(v));
+            } else if (key == "--threads") {
+                opt.threads = static_cast<std::size_t>(std::stoull(v));
+            } else if (key == "--value-size") {
+                opt.value_size = static_cast<std::size_t>(std::stoull(v));
+            } else if (key == "--seek-nexts") {
+                opt.seek_nexts = static_cast<std::size_t>(std::stoull(v));
+            } else if (key == "--distribution") {
+                opt.distribution = v;
+            } else if (key == "--zipf-theta") {
+                opt.zipf_theta = std::stod(v);
+            } else if (key == "--sync") {
+                opt.sync = v;
+            } else if (key == "--memtable-size") {
+                opt.memtable_size = static_cast<std::size_t>(std::stoull(v));
+            } else if (key == "--cache-size") {
+                opt.cache_size = static_cast<std::size_t>(std::stoull(v));
+            } else if (key == "--use-existing") {
+                opt.use_existing = std::stoi(v) != 0;
+            } else if (key == "--statistics") {
+                opt.statistics = std::stoi(v) != 0;
+            } else if (key == "--mmap") {
+                opt.mmap = std::stoi(v) != 0;
+            } else if (key == "--min-blob-size") {
+                opt.min_blob_size = static_cast<std::size_t>(std::stoull(v));
+            } else if (key == "--json") {
+                opt.json = v;
+            } else if (key == "--seed") {
+                opt.seed = static_cast<std::uint32_t>(std::stoul(v));
+            } else {
+                return false;
+            }
+            return true;
+        } catch (...) {
+            return false;
+        }
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg(argv[i]);
+        if (arg == "--help" || arg == "-h") return false;
+
+        auto eq = arg.find('=');
+        if (eq != std::string_view::npos) {
+            if (!parse_kv(arg.substr(0, eq), arg.substr(eq + 1))) return false;
+            continue;
+        }
+
+        if (starts_with(arg, "--")) {
+            if (i + 1 >= argc) return false;
+            std::string_view v(argv[++i]);
+            if (!parse_kv(arg, v)) return false;
+            continue;
+        }
+
+        return false;
+    }
+
+    if (opt.reads == 0) opt.reads = opt.num;
+    if (opt.num == 0 || opt.threads == 0) return false;
+    if (opt.distribution != "uniform" && opt.distribution != "zipfian") return false;
+    if (!(opt.zipf_theta > 0.0 && opt.zipf_theta < 1.0)) return false;
+    if (opt.sync != "per-write" && opt.sync != "group" && opt.sync != "periodic") return false;
+    return true;
+}
+
+// ---- Key 与分布 ----
+
+/// 16 字节定宽的十进制 Key：字节序与数值序一致，fillseq 即按 Key 顺序写入
+static std::string make_key(std::uint64_t i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%016llu", static_cast<unsigned long long>(i));
+    return buf;
+}
+
+/**
+ * @brief Zipfian 分布的整数生成器（Gray et al., "Quickly Generating Billion-Record Synthetic Databases"，
+ *        与 YCSB 的 ZipfianGenerator 相同）
+ *
+ * 生成 [0, n) 中的整数，0 最热。构造时需要 O(n) 计算 zeta(n)；之后每次生成 O(1)。
+ */
+class ZipfianGenerator {
+public:
+    ZipfianGenerator(std::uint64_t n, double theta) : n_(n), theta_(theta) {
+        double zeta2 = zeta(2, theta);
+        zetan_ = zeta(n, theta);
+        alpha_ = 1.0 / (1.0 - theta);
+        eta_ = (1.0 - std::pow(2.0 / static_cast<double>(n), 1.0 - theta)) / (1.0 - zeta2 / zetan_);
+    }
+
+    template <typename Rng>
+    std::uint64_t next(Rng& rng) const {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        double uz = u * zetan_;
+        if (uz < 1.0) return 0;
+        if (uz < 1.0 + std::pow(0.5, theta_)) return std::min<std::uint64_t>(1, n_ - 1);
+        auto value = static_cast<std::uint64_t>(static_cast<double>(n_) * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+        return std::min(value, n_ - 1);
+    }
+
+private:
+    std::uint64_t n_;
+    double theta_;
+    double zetan_ = 0.0;
+    double alpha_ = 0.0;
+    double eta_ = 0.0;
+
+    static double zeta(std::uint64_t n, double theta) {
+        double sum = 0.0;
+        for (std::uint64_t i = 1; i <= n; ++i) sum += 1.0 / std::pow(static_cast<double>(i), theta);
+        return sum;
+    }
+};
+
+/// 把热点打散到整个 Key 空间（YCSB 的 scrambled zipfian），避免热点集中在 Key 空间的开头
+static std::uint64_t scramble(std::uint64_t i, std::uint64_t n) {
+    std::uint64_t h = i * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 29;
+    return h % n;
+}
+
+// ---- 负载 ----
+
+enum class OpType { kRead, kWrite, kDelete, kSeek, kRmw, kCount };
+
+static const char* op_name(OpType type) {
+    switch (type) {
+        case OpType::kRead: return "read";
+        case OpType::kWrite: return "write";
+        case OpType::kDelete: return "delete";
+        case OpType::kSeek: return "seek";
+        case OpType::kRmw: return "rmw";
+        case OpType::kCount: break;
+    }
+    return "?";
+}
+
+/// 一个线程的统计
+struct ThreadStats {
+    HistogramData ops[static_cast<std::size_t>(OpType::kCount)];
+    std::uint64_t found = 0;          ///< 读到值的点查 / 读到至少一条的 Seek
+    std::uint64_t bytes = 0;          ///< 读写的 Key+Value 字节数（MB/s）
+    std::uint64_t written_bytes = 0;  ///< 用户写入的 Key+Value 字节数（写放大的分母）
+    std::uint64_t lookups = 0;        ///< 点查与 Seek 次数（读放大的分母）
+};
+
+/// 一个负载的结果
+struct Result {
+    std::string name;
+    std::uint64_t ops = 0;
+    std::uint64_t found = 0;
+    double seconds = 0.0;
+    ThreadStats stats;
+    HistogramData all;  ///< 所有类型操作合并
+    double write_amp = 0.0;
+    double read_amp = 0.0;
+    double space_amp = 0.0;
+    std::uint64_t disk_bytes = 0;
+    std::uint64_t live_bytes = 0;
+};
+
+/**
+ * @brief 一个线程执行负载所需的上下文
+ */
+class Worker {
+public:
+    Worker(KVStore& store, std::size_t index, std::uint32_t seed, std::size_t value_size,
+           const ZipfianGenerator* zipf, const ZipfianGenerator* latest, std::atomic<std::uint64_t>* inserted)
+        : store_(store)
+        , index_(index)
+        , rng_(seed + 7919 * index)
+        , zipf_(zipf)
+        , latest_(latest)
+        , inserted_(inserted)
+        , value_(value_size, static_cast<char>('a' + index % 26)) {}
+
+    ThreadStats stats;
+
+    /// 按 --distribution 选择 [0, n) 中的 Key
+    std::uint64_t choose(std::uint64_t n) {
+        if (zipf_ != nullptr) return scramble(zipf_->next(rng_), n);
+        return std::uniform_int_distribution<std::uint64_t>(0, n - 1)(rng_);
+    }
+
+    /// YCSB D 的 latest 分布：越新插入的 Key 越热（与 YCSB 相同，不受 --distribution 影响）
+    std::uint64_t choose_latest() {
+        std::uint64_t n = inserted_->load(std::memory_order_relaxed);
+        std::uint64_t back = latest_->next(rng_);
+        return back < n ? n - 1 - back : n - 1;
+    }
+
+    std::uint64_t uniform(std::uint64_t lo, std::uint64_t hi) {
+        return std::uniform_int_distribution<std::uint64_t>(lo, hi)(rng_);
+    }
+
+    double coin() { return std::uniform_real_distribution<double>(0.0, 1.0)(rng_); }
+
+    void write(std::uint64_t i) {
+        std::string key = make_key(i);
+        auto start = std::chrono::steady_clock::now();
+        store_.put(key, value_);
+        record(OpType::kWrite, start);
+        stats.bytes += key.size() + value_.size();
+        stats.written_bytes += key.size() + value_.size();
+    }
+
+    void insert() { write(inserted_->fetch_add(1, std::memory_order_relaxed)); }
+
+    void read(std::string_view key) {
+        PinnableValue value;
+        auto start = std::chrono::steady_clock::now();
+        bool found = store_.get(key, &value);
+        record(OpType::kRead, start);
+        ++stats.lookups;
+        if (found) {
+            ++stats.found;
+            stats.bytes += key.size() + value.size();
+        }
+    }
+
+    void erase(std::uint64_t i) {
+        std::string key = make_key(i);
+        auto start = std::chrono::steady_clock::now();
+        store_.del(key);
+        record(OpType::kDelete, start);
+        stats.written_bytes += key.size();
+    }
+
+    void seek(std::uint64_t i, std::size_t nexts) {
+        std::string key = make_key(i);
+        auto start = std::chrono::steady_clock::now();
+        auto it = store_.new_iterator();
+        it->Seek(key);
+        std::size_t n = 0;
+        for (; n < nexts && it->Valid(); ++n, it->Next()) stats.bytes += it->key().size() + it->value().size();
+        record(OpType::kSeek, start);
+        ++stats.lookups;
+        if (n > 0) ++stats.found;
+    }
+
+    void read_modify_write(std::uint64_t i) {
+        std::string key = make_key(i);
+        auto start = std::chrono::steady_clock::now();
+        std::optional<std::string> old = store_.get(key);
+        store_.put(key, value_);
+        record(OpType::kRmw, start);
+        ++stats.lookups;
+        if (old) ++stats.found;
+        stats.bytes += key.size() + value_.size();
+        stats.written_bytes += key.size() + value_.size();
+    }
+
+    std::size_t index() const { return index_; }
+
+private:
+    KVStore& store_;
+    std::size_t index_;
+    std::mt19937_64 rng_;
+    const ZipfianGenerator* zipf_;    ///< 为空表示均匀分布
+    const ZipfianGenerator* latest_;  ///< latest 分布距最新 Key 的偏移
+    std::atomic<std::uint64_t>* inserted_;
+    std::string value_;
+
+    void record(OpType type, std::chrono::steady_clock::time_point start) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        stats.ops[static_cast<std::size_t>(type)].Add(
+            static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+};
+
+/// [begin, end) 按线程均分后第 index 个线程的区间
+static std::pair<std::uint64_t, std::uint64_t> share(std::uint64_t total, std::size_t threads, std::size_t index) {
+    std::uint64_t base = total / threads;
+    std::uint64_t extra = total % threads;
+    std::uint64_t begin = index * base + std::min<std::uint64_t>(index, extra);
+    return {begin, begin + base + (index < extra ? 1 : 0)};
+}
+
+/**
+ * @brief 一个线程执行负载 name 的 [begin, end) 部分
+ *
+ * @return false 如果负载名未知
+ */
+static bool run_workload(const std::string& name, Worker& w, const Options& opt) {
+    auto [begin, end] = share(name.rfind("fill", 0) == 0 || name == "overwrite" || name == "deleterandom"
+                                  ? opt.num
+                                  : opt.reads,
+                              opt.threads, w.index());
+    const std::uint64_t n = opt.num;
+
+    if (name == "fillseq") {
+        for (std::uint64_t i = begin; i < end; ++i) w.write(i);
+    } else if (name == "fillrandom" || name == "overwrite") {
+        for (std::uint64_t i = begin; i < end; ++i) w.write(w.choose(n));
+    } else if (name == "readrandom") {
+        for (std::uint64_t i = begin; i < end; ++i) w.read(make_key(w.choose(n)));
+    } else if (name == "readmissing") {
+        for (std::uint64_t i = begin; i < end; ++i) w.read(make_key(w.choose(n)) + ".");
+    } else if (name == "seekrandom") {
+        for (std::uint64_t i = begin; i < end; ++i) w.seek(w.choose(n), opt.seek_nexts);
+    } else if (name == "deleterandom") {
+        for (std::uint64_t i = begin; i < end; ++i) w.erase(w.choose(n));
+    } else if (name == "ycsba" || name == "ycsbb" || name == "ycsbc") {
+        // A: 50% read / 50% update; B: 95% / 5%; C: 100% read
+        double read_ratio = name == "ycsba" ? 0.5 : name == "ycsbb" ? 0.95 : 1.0;
+        for (std::uint64_t i = begin; i < end; ++i) {
+            if (w.coin() < read_ratio) {
+                w.read(make_key(w.choose(n)));
+            } else {
+                w.write(w.choose(n));
+            }
+        }
+    } else if (name == "ycsbd") {
+        // 95% 读最近插入的 Key / 5% 插入
+        for (std::uint64_t i = begin; i < end; ++i) {
+            if (w.coin() < 0.95) {
+                w.read(make_key(w.choose_latest()));
+            } else {
+                w.insert();
+            }
+        }
+    } else if (name == "ycsbe") {
+        // 95% 短范围扫描（1..100 条）/ 5% 插入
+        for (std::uint64_t i = begin; i < end; ++i) {
+            if (w.coin() < 0.95) {
+                w.seek(w.choose(n), static_cast<std::size_t>(w.uniform(1, 100)));
+            } else {
+                w.insert();
+            }
+        }
+    } else if (name == "ycsbf") {
+        // 50% 读 / 50% 读-改-写
+        for (std::uint64_t i = begin; i < end; ++i) {
+            if (w.coin() < 0.5) {
+                w.read(make_key(w.choose(n)));
+            } else {
+                w.read_modify_write(w.choose(n));
+            }
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/// 写放大与读放大的计算需要的累计计数
+struct StoreCounters {
+    std::uint64_t bytes_written = 0;  ///< WAL + L0 落盘 + Compaction 写入（含 Blob 文件）
+    std::uint64_t block_reads = 0;    ///< 块缓存的命中 + 未命中
+
+    static StoreCounters of(const KVStore& store) {
+        StoreCounters c;
+        FlushStats flush = store.flush_stats();
+        CompactionStats compaction = store.compaction_stats();
+        c.bytes_written = store.wal_stats().bytes + flush.bytes_written + flush.blob_bytes_written +
+                          compaction.bytes_written + compaction.blob_bytes_written;
+        BlockCacheStats cache = store.block_cache_stats();
+        c.block_reads = cache.hits + cache.misses;
+        return c;
+    }
+};
+
+/// 后台落盘 / Compaction 可能在遍历期间删除文件，取不到大小的文件直接跳过
+static std::uint64_t directory_bytes(const std::filesystem::path& dir) {
+    std::uint64_t bytes = 0;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dir, ec)) {
+        std::uint64_t size = entry.file_size(ec);
+        if (!ec) bytes += size;
+    }
+    return bytes;
+}
+
+static std::uint64_t live_bytes(const KVStore& store) {
+    ReadOptions options;
+    options.fill_cache = false;
+    std::uint64_t bytes = 0;
+    auto it = store.new_iterator(options);
+    for (it->SeekToFirst(); it->Valid(); it->Next()) bytes += it->key().size() + it->value().size();
+    return bytes;
+}
+
+static Result run_benchmark(KVStore& store, const Options& opt, const std::string& name,
+                            const ZipfianGenerator* zipf, const ZipfianGenerator& latest,
+                            std::atomic<std::uint64_t>* inserted) {
+    Result result;
+    result.name = name;
+    StoreCounters before = StoreCounters::of(store);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (std::size_t i = 0; i < opt.threads; ++i) {
+        workers.push_back(std::make_unique<Worker>(store, i, opt.seed, opt.value_size, zipf, &latest, inserted));
+    }
+    std::vector<std::thread> threads;
+    std::atomic<bool> unknown{false};
+    auto start = std::chrono::steady_clock::now();
+    for (auto& worker : workers) {
+        threads.emplace_back([&, w = worker.get()] {
+            if (!run_workload(name, *w, opt)) unknown = true;
+        });
+    }
+    for (auto& t : threads) t.join();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (unknown) throw std::runtime_error("unknown benchmark: " + name);
+
+    for (const auto& worker : workers) {
+        for (std::size_t i = 0; i < static_cast<std::size_t>(OpType::kCount); ++i) {
+            result.stats.ops[i].Merge(worker->stats.ops[i]);
+            result.all.Merge(worker->stats.ops[i]);
+        }
+        result.stats.found += worker->stats.found;
+        result.stats.bytes += worker->stats.bytes;
+        result.stats.written_bytes += worker->stats.written_bytes;
+        result.stats.lookups += worker->stats.lookups;
+    }
+    result.ops = result.all.count;
+    result.found = result.stats.found;
+
+    StoreCounters after = StoreCounters::of(store);
+    if (result.stats.written_bytes > 0) {
+        result.write_amp = static_cast<double>(after.bytes_written - before.bytes_written) /
+                           static_cast<double>(result.stats.written_bytes);
+    }
+    if (result.stats.lookups > 0) {
+        result.read_amp = static_cast<double>(after.block_reads - before.block_reads) /
+                          static_cast<double>(result.stats.lookups);
+    }
+    result.disk_bytes = directory_bytes(opt.db);
+    result.live_bytes = live_bytes(store);
+    if (result.live_bytes > 0) {
+        result.space_amp = static_cast<double>(result.disk_bytes) / static_cast<double>(result.live_bytes);
+    }
+    return result;
+}
+
+// ---- 输出 ----
+
+static double micros(double nanos) { return nanos / 1e3; }
+
+static void print_result(const Result& r) {
+    double ops_per_sec = r.seconds > 0 ? static_cast<double>(r.ops) / r.seconds : 0.0;
+    double mb_per_sec = r.seconds > 0 ? static_cast<double>(r.stats.bytes) / (1024.0 * 1024.0) / r.seconds : 0.0;
+    std::printf("%-12s : %10.3f micros/op %10.0f ops/sec %8.1f MB/s", r.name.c_str(),
+                r.ops ? r.seconds * 1e6 / static_cast<double>(r.ops) : 0.0, ops_per_sec, mb_per_sec);
+    if (r.stats.lookups > 0) {
+        std::printf(" (%llu of %llu found)", static_cast<unsigned long long>(r.found),
+                    static_cast<unsigned long long>(r.stats.lookups));
+    }
+    std::printf("\n");
+    for (std::size_t i = 0; i < static_cast<std::size_t>(OpType::kCount); ++i) {
+        const HistogramData& h = r.stats.ops[i];
+        if (h.count == 0) continue;
+        std::printf("  %-7s latency (us): avg=%.2f p50=%.2f p99=%.2f p99.9=%.2f max=%.2f (%llu ops)\n",
+                    op_name(static_cast<OpType>(i)), micros(h.Average()), micros(h.Percentile(0.50)),
+                    micros(h.Percentile(0.99)), micros(h.Percentile(0.999)), micros(static_cast<double>(h.max)),
+                    static_cast<unsigned long long>(h.count));
+    }
+    std::printf("  amplification: write=%.2f read=%.2f blocks/lookup space=%.2f (%.1f MB on disk, %.1f MB live)\n",
+                r.write_amp, r.read_amp, r.space_amp, static_cast<double>(r.disk_bytes) / (1024.0 * 1024.0),
+                static_cast<double>(r.live_bytes) / (1024.0 * 1024.0));
+}
+
+static void write_latency_json(std::ostream& out, const HistogramData& h) {
+    out << "{\"count\": " << h.count << ", \"avg\": " << micros(h.Average())
+        << ", \"p50\": " << micros(h.Percentile(0.50)) << ", \"p99\": " << micros(h.Percentile(0.99))
+        << ", \"p999\": " << micros(h.Percentile(0.999)) << ", \"max\": " << micros(static_cast<double>(h.max)) << "}";
+}
+
+static void write_json(const std::string& path, const Options& opt, const std::vector<Result>& results) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("cannot write " + path);
+    out << "{\n  \"config\": {\"num\": " << opt.num << ", \"reads\": " << opt.reads << ", \"threads\": " << opt.threads
+        << ", \"value_size\": " << opt.value_size << ", \"distribution\": \"" << opt.distribution
+        << "\", \"zipf_theta\": " << opt.zipf_theta << ", \"sync\": \"" << opt.sync
+        << "\", \"memtable_size\": " << opt.memtable_size << ", \"cache_size\": " << opt.cache_size
+        << ", \"mmap\": " << (opt.mmap ? "true" : "false") << ", \"min_blob_size\": " << opt.min_blob_size
+        << ", \"seed\": " << opt.seed << "},\n  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name << "\", \"ops\": " << r.ops
+            << ", \"seconds\": " << r.seconds
+            << ", \"ops_per_sec\": " << (r.seconds > 0 ? static_cast<double>(r.ops) / r.seconds : 0.0)
+            << ", \"bytes\": " << r.stats.bytes << ", \"found\": " << r.found << ", \"lookups\": " << r.stats.lookups
+            << ",\n     \"latency_us\": ";
+        write_latency_json(out, r.all);
+        out << ",\n     \"latency_us_by_op\": {";
+        bool first = true;
+        for (std::size_t op = 0; op < static_cast<std::size_t>(OpType::kCount); ++op) {
+            if (r.stats.ops[op].count == 0) continue;
+            out << (first ? "" : ", ") << "\"" << op_name(static_cast<OpType>(op)) << "\": ";
+            write_latency_json(out, r.stats.ops[op]);
+            first = false;
+        }
+        out << "},\n     \"write_amp\": " << r.write_amp << ", \"read_amp\": " << r.read_amp
+            << ", \"space_amp\": " << r.space_amp << ", \"disk_bytes\": " << r.disk_bytes
+            << ", \"live_bytes\": " << r.live_bytes << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<std::string> names;
+    std::stringstream list(opt.benchmarks);
+    for (std::string name; std::getline(list, name, ',');) {
+        if (!name.empty()) names.push_back(name);
+    }
+
+    KVStoreOptions options;
+    options.sync_mode = opt.sync == "per-write" ? WalSyncMode::kPerWrite
+                        : opt.sync == "group"   ? WalSyncMode::kGroupCommit
+                                                : WalSyncMode::kPeriodic;
+    options.memtable_size_limit = opt.memtable_size;
+    options.block_cache_capacity = opt.cache_size;
+    options.table_options.use_mmap_reads = opt.mmap;
+    options.min_blob_size = opt.min_blob_size;
+    if (opt.statistics) options.statistics = std::make_shared<Statistics>();
+    if (!opt.use_existing) std::filesystem::remove_all(opt.db);
+
+    std::cout << "KVStore benchmark: db=" << opt.db << "\n";
+    std::cout << "num=" << opt.num << " reads=" << opt.reads << " threads=" << opt.threads
+              << " value_size=" << opt.value_size << " distribution=" << opt.distribution
+              << (opt.distribution == "zipfian" ? " theta=" + std::to_string(opt.zipf_theta) : "")
+              << " sync=" << opt.sync << "\n\n";
+
+    std::vector<Result> results;
+    try {
+        KVStore store(opt.db, options);
+        std::unique_ptr<ZipfianGenerator> zipf;
+        if (opt.distribution == "zipfian") zipf = std::make_unique<ZipfianGenerator>(opt.num, opt.zipf_theta);
+        ZipfianGenerator latest(std::max<std::size_t>(opt.num, 2), opt.zipf_theta);
+        std::atomic<std::uint64_t> inserted{opt.num};
+        for (const std::string& name : names) {
+            results.push_back(run_benchmark(store, opt, name, zipf.get(), latest, &inserted));
+            print_result(results.back());
+        }
+        if (opt.statistics) {
+            std::string report;
+            store.get_property("kv.stats", &report);
+            std::cout << "\n" << report;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "kv_bench: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (!opt.json.empty()) {
+        write_json(opt.json, opt, results);
+        std::cout << "\nresults written to " << opt.json << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "kv_client.h"
+
+/**
+ * @file kv_loadgen.cpp
+ * @brief KVServer 的压测客户端：多连接、可配置流水线深度与读写比例
+ *
+ * 每个连接一个线程，循环发送 pipeline 个请求后一次 flush，再读回全部响应；
+ * 延迟按一轮流水线的往返时间统计（即每个请求从发出到收到响应的最长时间）。
+ */
+
+struct Options {
+    std::string host = "127.0.0.1";
+    std::uint16_t port = 7379;
+    std::size_t connections = 8;
+    std::size_t pipeline = 16;
+    std::size_t requests = 200000;
+    std::size_t keys = 100000;
+    std::size_t value_size = 100;
+    double read_ratio = 0.5;
+    std::uint32_t seed = 12345;
+};
+
+static bool starts_with(std::string_view s, std::string_view prefix) {
+    return s.size() >= prefix.size() && s.substr(0, prefix.size()) == prefix;
+}
+
+static void print_usage(const char* prog) {
+    std::cout
+        << "Usage: " << prog << " [--host H] [--port P] [--connections C] [--pipeline D] [--requests N]\n"
+        << "       [--keys K] [--value-size V] [--read-ratio R] [--seed S]\n"
+        << "  --host        server address (default: 127.0.0.1)\n"
+        << "  --port        server port (default: 7379)\n"
+        << "  --connections concurrent connections, one thread each (default: 8)\n"
+        << "  --pipeline    requests in flight per connection (default: 16)\n"
+        << "  --requests    total requests across all connections (default: 200000)\n"
+        << "  --keys        key space size (default: 100000)\n"
+        << "  --value-size  bytes per put value (default: 100)\n"
+        << "  --read-ratio  fraction of requests that are gets (default: 0.5)\n"
+        << "  --seed        random seed (default: 12345)\n";
+}
+
+static bool parse_args(int argc, char** argv, Options& opt) {
+    auto parse_kv = [&](std::string_view key, std::string_view value) -> bool {
+        try {
+            std::string v(value);
+            if (key == "--host") {
+                opt.host = v;
+            } else if (key == "--port") {
+                opt.port = static_cast<std::uint16_t>(std::stoul(v));
+            } else if (key == "--connections") {
+                opt.connections = static_cast<std::size_t>(std::stoull(v));
+            } else if (key == "--pipeline") {
+                opt.pipeline = static_cast<std::size_t>(std::stoull(v));
+            } else if (key == "--requests") {
+                opt.requests = static_cast<std::size_t>(std::stoull(v));
+            } else if (key == "--keys") {
+                opt.keys = static_cast<std::size_t>(std::stoull(v));
+            } else if (key == "--value-size") {
+                opt.value_size = static_cast<std::size_t>(std::stoull(v));
+            } else if (key == "--read-ratio") {
+                opt.read_ratio = std::stod(v);
+            } else if (key == "--seed") {
+                opt.seed = static_cast<std::uint32_t>(std::stoul(v));
+            } else {
+                return false;
+            }
+            return true;
+        } catch (...) {
+            return false;
+        }
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg(argv[i]);
+        if (arg == "--help" || arg == "-h") return false;
+
+        auto eq = arg.find('=');
+        if (eq != std::string_view::npos) {
+            if (!parse_kv(arg.substr(0, eq), arg.substr(eq + 1))) return false;
+            continue;
+        }
+
+        if (starts_with(arg, "--")) {
+            if (i + 1 >= argc) return false;
+            std::string_view v(argv[++i]);
+            if (!parse_kv(arg, v)) return false;
+            continue;
+        }
+
+        return false;
+    }
+
+    if (opt.connections == 0 || opt.pipeline == 0 || opt.keys == 0) return false;
+    if (!(opt.read_ratio >= 0.0 && opt.read_ratio <= 1.0)) return false;
+    return true;
+}
+
+static std::string make_key(std::size_t i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "key%012zu", i);
+    return buf;
+}
+
+struct WorkerResult {
+    std::uint64_t gets = 0;
+    std::uint64_t hits = 0;
+    std::uint64_t puts = 0;
+    std::uint64_t errors = 0;
+    std::vector<std::uint32_t> latencies_us;  ///< 每轮流水线的往返时间
+};
+
+static void run_worker(const Options& opt, std::size_t index, std::size_t requests, WorkerResult* result) {
+    KVClient client(opt.host, opt.port);
+    std::mt19937_64 rng(opt.seed + index);
+    std::uniform_int_distribution<std::size_t> key_dist(0, opt.keys - 1);
+    std::bernoulli_distribution is_read(opt.read_ratio);
+    const std::string value(opt.value_size, static_cast<char>('a' + index % 26));
+
+    std::vector<bool> reads(opt.pipeline);
+    std::size_t done = 0;
+    while (done < requests) {
+        std::size_t depth = std::min(opt.pipeline, requests - done);
+        for (std::size_t i = 0; i < depth; ++i) {
+            std::string key = make_key(key_dist(rng));
+            reads[i] = is_read(rng);
+            if (reads[i]) {
+                client.send_get(key);
+                result->gets += 1;
+            } else {
+                client.send_put(key, value);
+                result->puts += 1;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        client.flush();
+        for (std::size_t i = 0; i < depth; ++i) {
+            ResponseStatus status = client.read_response();
+            if (status == ResponseStatus::kOk && reads[i]) result->hits += 1;
+            if (status == ResponseStatus::kError) result->errors += 1;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        result->latencies_us.push_back(static_cast<std::uint32_t>(elapsed.count()));
+        done += depth;
+    }
+}
+
+static std::uint32_t percentile(const std::vector<std::uint32_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    std::size_t index = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    std::cout << "Load generator: " << opt.host << ":" << opt.port << "\n";
+    std::cout << "connections=" << opt.connections << " pipeline=" << opt.pipeline << " requests=" << opt.requests
+              << " keys=" << opt.keys << " value_size=" << opt.value_size << " read_ratio=" << opt.read_ratio
+              << "\n\n";
+
+    std::vector<WorkerResult> results(opt.connections);
+    std::vector<std::thread> threads;
+    std::atomic<bool> failed{false};
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < opt.connections; ++i) {
+        std::size_t share = opt.requests / opt.connections + (i < opt.requests % opt.connections ? 1 : 0);
+        threads.emplace_back([&, i, share] {
+            try {
+                run_worker(opt, i, share, &results[i]);
+            } catch (const std::exception& e) {
+                std::cerr << "connection " << i << ": " << e.what() << "\n";
+                failed = true;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    WorkerResult total;
+    for (const WorkerResult& r : results) {
+        total.gets += r.gets;
+        total.hits += r.hits;
+        total.puts += r.puts;
+        total.errors += r.errors;
+        total.latencies_us.insert(total.latencies_us.end(), r.latencies_us.begin(), r.latencies_us.end());
+    }
+    std::sort(total.latencies_us.begin(), total.latencies_us.end());
+
+    double seconds = static_cast<double>(elapsed.count()) / 1e9;
+    std::uint64_t ops = total.gets + total.puts;
+    std::cout << "ops=" << ops << " (gets=" << total.gets << " hits=" << total.hits << " puts=" << total.puts
+              << " errors=" << total.errors << ")\n";
+    std::cout << "elapsed: " << seconds * 1e3 << " ms | " << (seconds > 0 ? static_cast<double>(ops) / seconds : 0.0)
+              << " ops/s\n";
+    std::cout << "pipeline round-trip latency (us): p50=" << percentile(total.latencies_us, 0.50)
+              << " p99=" << percentile(total.latencies_us, 0.99) << " p99.9=" << percentile(total.latencies_us, 0.999)
+              << " max=" << (total.latencies_us.empty() ? 0 : total.latencies_us.back()) << "\n";
+    return failed ? 1 : 0;
+}
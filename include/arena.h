@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief 内存池 (Arena)：按块批量申请内存，小对象在块内顺序分配 (Bump Allocation)
+ *
+ * - 每次分配只是移动块内指针，没有 malloc 调用与每个对象的分配头开销；
+ * - 同一时期分配的对象在内存中紧邻，顺序遍历时缓存命中率高；
+ * - 不支持单独释放，所有内存在 Arena 析构时一次性归还（MemTable 的生命周期正好如此）。
+ *
+ * 大于 kBlockSize / 4 的请求单独分配一个块，避免浪费当前块的剩余空间。
+ *
+ * @note 本类非线程安全：分配由唯一的写入者执行；MemoryUsage() 可被其他线程并发读取。
+ */
+class Arena {
+public:
+    static constexpr size_t kBlockSize = 4096;
+
+    Arena() = default;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /// 分配 bytes 字节（不保证对齐，适合存放字符串）
+    char* Allocate(size_t bytes) {
+        if (bytes <= remaining_) {
+            char* result = ptr_;
+            ptr_ += bytes;
+            remaining_ -= bytes;
+            usage_.fetch_add(bytes, std::memory_order_relaxed);
+            return result;
+        }
+        return AllocateFallback(bytes);
+    }
+
+    /// 分配 bytes 字节，按指针大小对齐（适合存放节点结构体）
+    char* AllocateAligned(size_t bytes) {
+        constexpr size_t kAlign = alignof(std::max_align_t) > 8 ? alignof(std::max_align_t) : 8;
+        size_t mod = reinterpret_cast<uintptr_t>(ptr_) & (kAlign - 1);
+        size_t slop = mod == 0 ? 0 : kAlign - mod;
+        size_t needed = bytes + slop;
+        if (needed <= remaining_) {
+            char* result = ptr_ + slop;
+            ptr_ += needed;
+            remaining_ -= needed;
+            usage_.fetch_add(needed, std::memory_order_relaxed);
+            return result;
+        }
+        // 新块由 operator new 分配，天然满足对齐要求
+        return AllocateFallback(bytes);
+    }
+
+    /**
+     * @brief 已占用的内存字节数：已分配的字节 + 对齐填充 + 被弃用的块尾部空间
+     *
+     * 是一个原子计数器，读取开销为一次 relaxed load，可直接用作落盘触发条件。
+     */
+    size_t MemoryUsage() const { return usage_.load(std::memory_order_relaxed); }
+
+    /// 向系统申请的总字节数（所有块之和）
+    size_t ReservedBytes() const { return reserved_; }
+
+private:
+    char* ptr_ = nullptr;
+    size_t remaining_ = 0;
+    size_t reserved_ = 0;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::atomic<size_t> usage_{0};
+
+    char* AllocateFallback(size_t bytes) {
+        if (bytes > kBlockSize / 4) {
+            // 大对象单独占一个块，当前块的剩余空间留给后续的小对象
+            usage_.fetch_add(bytes, std::memory_order_relaxed);
+            return AllocateNewBlock(bytes);
+        }
+        // 当前块剩余空间不足：弃用尾部，换一个新块
+        usage_.fetch_add(remaining_ + bytes, std::memory_order_relaxed);
+        ptr_ = AllocateNewBlock(kBlockSize);
+        remaining_ = kBlockSize;
+        char* result = ptr_;
+        ptr_ += bytes;
+        remaining_ -= bytes;
+        return result;
+    }
+
+    char* AllocateNewBlock(size_t bytes) {
+        blocks_.emplace_back(new char[bytes]);  // 不做零初始化
+        reserved_ += bytes;
+        return blocks_.back().get();
+    }
+};
@@ -0,0 +1,238 @@
+#pragma once
+
+#include "arena.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <random>
+
+/**
+ * @brief MemTable 专用的跳表：节点从 Arena 顺序分配，前进指针塔内联在节点之后
+ *
+ * 与通用的 SkipList<K, V> 相比：
+ * - 节点高度可变，结构为 | Key | next_[0] | next_[1] | ... | next_[height-1] |，
+ *   一次 AllocateAligned 得到整个节点，没有 std::vector 的额外分配与间接寻址；
+ * - 不调用 malloc / free，也不需要 nodes_storage 之类的所有权表，内存随 Arena 一起释放；
+ * - Key 通常是指向 Arena 中编码好的条目的指针，键值数据与节点同样紧凑地存放在 Arena 中。
+ *
+ * 不支持删除：MemTable 用删除标记表达删除，整个跳表在落盘后随 Arena 一起丢弃。
+ *
+ * 并发模型（单写多读）：
+ * - 写入需由调用者串行化（同一时刻至多一个写入者），但 **读取不需要任何锁**，
+ *   可以与写入并发进行，读者永远不会被写入者阻塞（wait-free）。
+ * - 新节点先完整初始化（Key 与本层之后的指针），再用 release store 挂到前驱上；
+ *   读者用 acquire load 读取前进指针，因此看到一个节点时一定也看到它的全部内容。
+ * - 节点从不被摘除或释放，读者持有的节点指针在跳表存活期间始终有效。
+ * - InsertOrAssign 替换已有节点的 Key 同样是一次 release store，读者看到的要么是旧 Key，
+ *   要么是新 Key（二者比较相等，不影响跳表的有序性）。
+ *
+ * @tparam Key 键类型（必须可平凡拷贝，如 const char* / 整数，存放在 std::atomic 中）
+ * @tparam Comparator 比较器，int operator()(const Key& a, const Key& b) const，
+ *         返回负数 / 0 / 正数表示 a 小于 / 等于 / 大于 b
+ */
+template <typename Key, class Comparator>
+class ArenaSkipList {
+private:
+    struct Node;
+
+public:
+    static constexpr int kMaxHeight = 12;
+
+    /**
+     * @param cmp 比较器
+     * @param arena 节点所用的内存池（生命周期必须长于跳表）
+     */
+    ArenaSkipList(Comparator cmp, Arena* arena)
+        : compare_(cmp), arena_(arena), head_(NewNode(Key(), kMaxHeight)), rnd_(0xdeadbeef) {
+        for (int i = 0; i < kMaxHeight; ++i) head_->NoBarrierSetNext(i, nullptr);
+    }
+
+    ArenaSkipList(const ArenaSkipList&) = delete;
+    ArenaSkipList& operator=(const ArenaSkipList&) = delete;
+
+    /**
+     * @brief 插入 key；已存在相等的 Key 时用新 key 替换节点中的旧 key
+     *
+     * 替换不改变节点在跳表中的位置（两者比较相等）。
+     * 调用者必须保证同一时刻只有一个写入者；读者可以并发访问。
+     *
+     * @return true 表示新增了节点，false 表示替换了已有节点
+     */
+    bool InsertOrAssign(const Key& key) {
+        Node* prev[kMaxHeight];
+        Node* x = FindGreaterOrEqual(key, prev);
+        if (x != nullptr && Equal(key, x->GetKey())) {
+            x->SetKey(key);
+            return false;
+        }
+
+        int height = RandomHeight();
+        int max_height = MaxHeight();
+        if (height > max_height) {
+            for (int i = max_height; i < height; ++i) prev[i] = head_;
+            // 读者可能先看到新的高度、后看到新节点：此时 head_ 的高层指针为空，
+            // 读者只会直接下降到下一层，结果依然正确，因此这里不需要同步
+            max_height_.store(height, std::memory_order_relaxed);
+        }
+        x = NewNode(key, height);
+        for (int i = 0; i < height; ++i) {
+            // x 尚未发布，它自己的指针无需屏障；挂到 prev[i] 上的那一次 release store 负责发布
+            x->NoBarrierSetNext(i, prev[i]->NoBarrierNext(i));
+            prev[i]->SetNext(i, x);
+        }
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// 是否存在与 key 相等的条目（可与写入并发调用）
+    bool Contains(const Key& key) const {
+        Node* x = FindGreaterOrEqual(key, nullptr);
+        return x != nullptr && Equal(key, x->GetKey());
+    }
+
+    /// 节点数量
+    size_t Size() const { return size_.load(std::memory_order_relaxed); }
+
+    bool Empty() const { return Size() == 0; }
+
+    /**
+     * @brief 双向有序迭代器
+     *
+     * Next 沿 Level 0 链表前进；节点没有后退指针，Prev 从高层重新查找前驱，O(log n)。
+     * 可与写入并发使用：迭代期间新插入的节点可能被看到，也可能看不到，
+     * 但看到的序列始终是有序的。
+     */
+    class Iterator {
+    public:
+        explicit Iterator(const ArenaSkipList* list) : list_(list) {}
+
+        bool Valid() const { return node_ != nullptr; }
+
+        Key key() const {
+            assert(Valid());
+            return node_->GetKey();
+        }
+
+        void Next() {
+            assert(Valid());
+            node_ = node_->Next(0);
+        }
+
+        /// 后退到最后一个 < key() 的条目，没有时变为无效
+        void Prev() {
+            assert(Valid());
+            node_ = list_->FindLessThan(node_->GetKey());
+        }
+
+        /// 定位到第一个 >= target 的条目
+        void Seek(const Key& target) { node_ = list_->FindGreaterOrEqual(target, nullptr); }
+
+        void SeekToFirst() { node_ = list_->head_->Next(0); }
+
+        void SeekToLast() { node_ = list_->FindLast(); }
+
+    private:
+        const ArenaSkipList* list_;
+        Node* node_ = nullptr;
+    };
+
+private:
+    struct Node {
+        explicit Node(const Key& k) : key_(k) {}
+
+        Key GetKey() const { return key_.load(std::memory_order_acquire); }
+        void SetKey(const Key& k) { key_.store(k, std::memory_order_release); }
+
+        /// 读者使用：acquire 保证看到节点指针时也看到该节点初始化后的内容
+        Node* Next(int level) const { return next_[level].load(std::memory_order_acquire); }
+        /// 写入者使用：release 保证节点内容先于指针对读者可见
+        void SetNext(int level, Node* node) { next_[level].store(node, std::memory_order_release); }
+
+        /// 只在确定没有读者会通过该指针访问到未初始化数据时使用
+        Node* NoBarrierNext(int level) const { return next_[level].load(std::memory_order_relaxed); }
+        void NoBarrierSetNext(int level, Node* node) {
+            next_[level].store(node, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<Key> key_;
+        /// 高度为 h 的节点在其后连续分配 h 个指针，这里只声明第一个
+        std::atomic<Node*> next_[1];
+    };
+
+    Comparator const compare_;
+    Arena* const arena_;
+    Node* const head_;
+    std::atomic<int> max_height_{1};
+    std::atomic<size_t> size_{0};
+    std::minstd_rand rnd_;
+
+    int MaxHeight() const { return max_height_.load(std::memory_order_relaxed); }
+
+    Node* NewNode(const Key& key, int height) {
+        char* mem = arena_->AllocateAligned(sizeof(Node) +
+                                            sizeof(std::atomic<Node*>) * static_cast<size_t>(height - 1));
+        return new (mem) Node(key);
+    }
+
+    /// 以 1/4 的概率逐层晋升（平均每个节点 1.33 个指针）
+    int RandomHeight() {
+        constexpr unsigned kBranching = 4;
+        int height = 1;
+        while (height < kMaxHeight && rnd_() % kBranching == 0) ++height;
+        return height;
+    }
+
+    bool Equal(const Key& a, const Key& b) const { return compare_(a, b) == 0; }
+
+    /// 返回最后一个 < key 的节点，不存在时返回 nullptr
+    Node* FindLessThan(const Key& key) const {
+        Node* x = head_;
+        int level = MaxHeight() - 1;
+        while (true) {
+            Node* next = x->Next(level);
+            if (next != nullptr && compare_(next->GetKey(), key) < 0) {
+                x = next;
+            } else {
+                if (level == 0) return x == head_ ? nullptr : x;
+                --level;
+            }
+        }
+    }
+
+    /// 返回最后一个节点，跳表为空时返回 nullptr
+    Node* FindLast() const {
+        Node* x = head_;
+        int level = MaxHeight() - 1;
+        while (true) {
+            Node* next = x->Next(level);
+            if (next != nullptr) {
+                x = next;
+            } else {
+                if (level == 0) return x == head_ ? nullptr : x;
+                --level;
+            }
+        }
+    }
+
+    /**
+     * @brief 返回第一个 >= key 的节点；prev 非空时填入每一层的前驱
+     */
+    Node* FindGreaterOrEqual(const Key& key, Node** prev) const {
+        Node* x = head_;
+        int level = MaxHeight() - 1;
+        while (true) {
+            Node* next = x->Next(level);
+            if (next != nullptr && compare_(next->GetKey(), key) < 0) {
+                x = next;
+            } else {
+                if (prev != nullptr) prev[level] = x;
+                if (level == 0) return next;
+                --level;
+            }
+        }
+    }
+};
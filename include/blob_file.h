@@ -0,0 +1,286 @@
+#pragma once
+#define _CRT_SECURE_NO_WARNINGS // 禁用 fopen 等不安全警告
+
+#include "block_cache.h"
+#include "coding.h"
+#include "crc32c.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * @file blob_file.h
+ * @brief 键值分离：大 Value 存放在单独的 Blob 文件中，LSM 中只保存指向它的 BlobIndex
+ *
+ * Blob 文件布局：
+ * +-------------+----------+-----+----------+
+ * | Magic (8B)  | Record 1 | ... | Record N |
+ * +-------------+----------+-----+----------+
+ *
+ * 每条记录：
+ * +-------------+-------------+---------------+-----+-------+
+ * | CRC32C (4B) | KeyLen (4B) | ValueLen (4B) | Key | Value |
+ * +-------------+-------------+---------------+-----+-------+
+ * CRC 覆盖两个长度、Key 与 Value。记录中保存 UserKey，读取时一并核对，
+ * 指针错位（例如 MANIFEST 与文件不一致）不会返回别的 Key 的值。
+ *
+ * Blob 文件只追加、写完后不再修改；其中的记录失效（被覆盖、删除或搬迁）后由 Compaction
+ * 累计为垃圾（discard 统计），整个文件全部失效后才删除。
+ */
+
+/**
+ * @brief 指向 Blob 文件中一条记录的指针（作为 ValueType::kBlobIndex 条目的值保存在 SSTable 中）
+ *
+ * 编码为 | FileNumber(8B) | Offset(8B) | Size(8B) |。
+ */
+struct BlobIndex {
+    uint64_t file_number = 0;  ///< Blob 文件编号
+    uint64_t offset = 0;       ///< 记录在文件中的起始偏移
+    uint64_t size = 0;         ///< Value 的长度
+
+    static constexpr size_t kEncodedLength = 24;
+
+    std::string Encode() const {
+        std::string dst;
+        dst.reserve(kEncodedLength);
+        put_fixed64(dst, file_number);
+        put_fixed64(dst, offset);
+        put_fixed64(dst, size);
+        return dst;
+    }
+
+    /// @return false 如果长度不对
+    bool Decode(std::string_view src) {
+        if (src.size() != kEncodedLength) return false;
+        file_number = decode_fixed64(src.data());
+        offset = decode_fixed64(src.data() + 8);
+        size = decode_fixed64(src.data() + 16);
+        return true;
+    }
+};
+
+/// Blob 文件开头的 Magic Number
+inline constexpr uint64_t kBlobFileMagicNumber = 0x626c6f6266696c65ull;  // "blobfile"
+
+/// Blob 记录头的长度：CRC32C + KeyLen + ValueLen
+inline constexpr size_t kBlobRecordHeaderSize = 12;
+
+/**
+ * @brief Blob 文件构造器：顺序追加记录，Finish() 时 fsync
+ *
+ * @note 本类非线程安全。
+ */
+class BlobFileBuilder {
+public:
+    /**
+     * @param filepath 输出文件路径
+     * @param number 文件编号（写入返回的 BlobIndex）
+     * @throw std::runtime_error 文件无法创建
+     */
+    BlobFileBuilder(const std::string& filepath, uint64_t number) : number_(number) {
+        file_ = std::fopen(filepath.c_str(), "wb");
+        if (file_ == nullptr) {
+            throw std::runtime_error("Failed to create blob file: " + filepath);
+        }
+        char magic[8];
+        encode_fixed64(magic, kBlobFileMagicNumber);
+        Write(std::string_view(magic, sizeof(magic)));
+    }
+
+    ~BlobFileBuilder() {
+        if (file_) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    BlobFileBuilder(const BlobFileBuilder&) = delete;
+    BlobFileBuilder& operator=(const BlobFileBuilder&) = delete;
+
+    /**
+     * @brief 追加一条记录
+     *
+     * @return 指向该记录的 BlobIndex
+     * @throw std::runtime_error 写入失败
+     */
+    BlobIndex Add(std::string_view key, std::string_view value) {
+        char header[kBlobRecordHeaderSize];
+        encode_fixed32(header + 4, static_cast<uint32_t>(key.size()));
+        encode_fixed32(header + 8, static_cast<uint32_t>(value.size()));
+        uint32_t crc = crc32c(header + 4, 8);
+        crc = crc32c_extend(crc, key.data(), key.size());
+        crc = crc32c_extend(crc, value.data(), value.size());
+        encode_fixed32(header, crc);
+
+        BlobIndex index{number_, offset_, value.size()};
+        Write(std::string_view(header, sizeof(header)));
+        Write(key);
+        Write(value);
+        blob_count_ += 1;
+        blob_bytes_ += value.size();
+        return index;
+    }
+
+    /**
+     * @brief fflush + fsync 并关闭文件
+     *
+     * @throw std::runtime_error 同步失败
+     */
+    void Finish() {
+        bool synced = std::fflush(file_) == 0;
+#ifdef _WIN32
+        synced = synced && _commit(_fileno(file_)) == 0;
+#else
+        synced = synced && fsync(fileno(file_)) == 0;
+#endif
+        std::fclose(file_);
+        file_ = nullptr;
+        if (!synced) {
+            throw std::runtime_error("Failed to sync blob file");
+        }
+    }
+
+    uint64_t Number() const { return number_; }
+    uint64_t FileSize() const { return offset_; }
+
+    /// 已写入的记录数
+    uint64_t BlobCount() const { return blob_count_; }
+
+    /// 已写入的 Value 总字节数（discard 统计以它为分母）
+    uint64_t BlobBytes() const { return blob_bytes_; }
+
+private:
+    FILE* file_ = nullptr;
+    uint64_t number_;
+    uint64_t offset_ = 0;
+    uint64_t blob_count_ = 0;
+    uint64_t blob_bytes_ = 0;
+
+    void Write(std::string_view data) {
+        if (std::fwrite(data.data(), 1, data.size(), file_) != data.size()) {
+            throw std::runtime_error("Failed to write blob file");
+        }
+        offset_ += data.size();
+    }
+};
+
+/**
+ * @brief Blob 文件读取器
+ *
+ * 按 BlobIndex 读出一条记录（一次 pread），校验 CRC 与 Key 后返回 Value。
+ * 提供块缓存时，读到的 Value 以 (cache_id, offset) 为 Key 放入缓存，与 Data Block 共享容量。
+ *
+ * @note Get 是线程安全的：POSIX 下使用 pread，Windows 下以互斥锁保护 seek + read。
+ */
+class BlobFileReader {
+public:
+    /**
+     * @param filepath Blob 文件路径
+     * @param cache 共享块缓存（可为空）
+     * @throw std::runtime_error 文件无法打开或 Magic Number 不匹配
+     */
+    explicit BlobFileReader(const std::string& filepath, std::shared_ptr<BlockCache> cache = nullptr)
+        : filepath_(filepath), cache_(std::move(cache)) {
+        file_ = std::fopen(filepath.c_str(), "rb");
+        if (file_ == nullptr) {
+            throw std::runtime_error("Failed to open blob file: " + filepath);
+        }
+        if (cache_) cache_id_ = cache_->NewId();
+        char magic[8];
+        try {
+            ReadAt(0, sizeof(magic), magic);
+        } catch (...) {
+            std::fclose(file_);
+            file_ = nullptr;
+            throw;
+        }
+        if (decode_fixed64(magic) != kBlobFileMagicNumber) {
+            std::fclose(file_);
+            file_ = nullptr;
+            throw std::runtime_error("Bad blob file magic number: " + filepath);
+        }
+    }
+
+    ~BlobFileReader() {
+        if (file_) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    BlobFileReader(const BlobFileReader&) = delete;
+    BlobFileReader& operator=(const BlobFileReader&) = delete;
+
+    /**
+     * @brief 读取 index 指向的 Value
+     *
+     * @param key 该记录的 UserKey（与记录中保存的 Key 核对）
+     * @param fill_cache 未命中缓存时是否把 Value 放入缓存
+     * @throw std::runtime_error 读取失败、CRC 不匹配或 Key 不一致
+     */
+    std::shared_ptr<const std::string> Get(const BlobIndex& index, std::string_view key,
+                                           bool fill_cache = true) const {
+        if (cache_) {
+            if (auto cached = cache_->Lookup(cache_id_, index.offset)) {
+                return std::static_pointer_cast<const std::string>(cached);
+            }
+        }
+
+        std::string record(kBlobRecordHeaderSize + key.size() + index.size, '\0');
+        ReadAt(index.offset, record.size(), record.data());
+        if (decode_fixed32(record.data() + 4) != key.size() ||
+            decode_fixed32(record.data() + 8) != index.size ||
+            crc32c(record.data() + 4, record.size() - 4) != decode_fixed32(record.data()) ||
+            std::string_view(record.data() + kBlobRecordHeaderSize, key.size()) != key) {
+            throw std::runtime_error("Corrupted blob record at offset " + std::to_string(index.offset) +
+                                     " in " + filepath_);
+        }
+        auto value = std::make_shared<const std::string>(
+            record.substr(kBlobRecordHeaderSize + key.size()));
+        if (cache_ && fill_cache) {
+            cache_->Insert(cache_id_, index.offset, value, value->size());
+        }
+        return value;
+    }
+
+    const std::string& FilePath() const { return filepath_; }
+
+private:
+    std::string filepath_;
+    FILE* file_ = nullptr;
+    std::shared_ptr<BlockCache> cache_;
+    uint64_t cache_id_ = 0;
+#ifdef _WIN32
+    mutable std::mutex io_mutex_;  ///< Windows 下保护共享文件偏移
+#endif
+
+    void ReadAt(uint64_t offset, size_t n, char* dst) const {
+#ifdef _WIN32
+        std::lock_guard<std::mutex> lock(io_mutex_);
+        if (_fseeki64(file_, static_cast<long long>(offset), SEEK_SET) != 0 ||
+            std::fread(dst, 1, n, file_) != n) {
+            throw std::runtime_error("Failed to read blob file: " + filepath_);
+        }
+#else
+        size_t done = 0;
+        while (done < n) {
+            ssize_t r = ::pread(fileno(file_), dst + done, n - done, static_cast<off_t>(offset + done));
+            if (r <= 0) {
+                throw std::runtime_error("Failed to read blob file: " + filepath_);
+            }
+            done += static_cast<size_t>(r);
+        }
+#endif
+    }
+};
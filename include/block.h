@@ -0,0 +1,332 @@
+#pragma once
+
+#include "coding.h"
+#include "comparator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file block.h
+ * @brief 前缀压缩的 Data Block（格式版本 2 起使用）
+ *
+ * Block 内的 Key 有序，相邻 Key 往往有很长的公共前缀（例如 encode_int_key 的高位字节），
+ * 因此每个 Entry 只存储与前一个 Key 不同的后缀：
+ *
+ * Entry 编码：
+ * +----------------+-------------------+-----------------+-----------------+-------+
+ * | shared(varint) | non_shared(varint)| value_len(varint)| key_delta      | value |
+ * +----------------+-------------------+-----------------+-----------------+-------+
+ *
+ * 每隔 restart_interval 个 Entry 设置一个 **重启点 (Restart Point)**：该 Entry 的 shared 为 0，
+ * 存储完整 Key。Block 末尾是所有重启点的偏移数组：
+ *
+ * +---------+---------+-----+-------------------+-------------------+----------------+
+ * | Entry 1 | Entry 2 | ... | Restart[0] (4B)   | ... Restart[N-1]  | N (4B)         |
+ * +---------+---------+-----+-------------------+-------------------+----------------+
+ *
+ * 点查时先在重启点上二分查找（重启点的 Key 是完整的），再从找到的重启点开始
+ * 最多解码 restart_interval 个 Entry，而不是从 Block 开头线性扫描。
+ */
+
+/**
+ * @brief Block 构建器
+ *
+ * @note 调用者必须保证 Add() 传入的 key 严格升序。
+ */
+class BlockBuilder {
+public:
+    explicit BlockBuilder(int restart_interval = 16)
+        : restart_interval_(restart_interval < 1 ? 1 : restart_interval) {
+        Reset();
+    }
+
+    /// 清空内容，开始构建新的 Block
+    void Reset() {
+        buffer_.clear();
+        restarts_.assign(1, 0);
+        counter_ = 0;
+        last_key_.clear();
+    }
+
+    /**
+     * @brief 追加一个 Entry
+     */
+    void Add(std::string_view key, std::string_view value) {
+        size_t shared = 0;
+        if (counter_ < restart_interval_) {
+            size_t max_shared = std::min(last_key_.size(), key.size());
+            while (shared < max_shared && last_key_[shared] == key[shared]) {
+                ++shared;
+            }
+        } else {
+            restarts_.push_back(static_cast<uint32_t>(buffer_.size()));
+            counter_ = 0;
+        }
+        size_t non_shared = key.size() - shared;
+
+        put_varint32(buffer_, static_cast<uint32_t>(shared));
+        put_varint32(buffer_, static_cast<uint32_t>(non_shared));
+        put_varint32(buffer_, static_cast<uint32_t>(value.size()));
+        buffer_.append(key.data() + shared, non_shared);
+        buffer_.append(value.data(), value.size());
+
+        last_key_.resize(shared);
+        last_key_.append(key.data() + shared, non_shared);
+        ++counter_;
+    }
+
+    /**
+     * @brief 追加重启点数组，返回完整的 Block 内容（在 Reset 之前有效）
+     */
+    const std::string& Finish() {
+        for (uint32_t restart : restarts_) {
+            put_fixed32(buffer_, restart);
+        }
+        put_fixed32(buffer_, static_cast<uint32_t>(restarts_.size()));
+        return buffer_;
+    }
+
+    /// 当前 Block 完成后的预估大小（用于判断是否达到 kBlockSize）
+    size_t CurrentSizeEstimate() const {
+        return buffer_.size() + restarts_.size() * sizeof(uint32_t) + sizeof(uint32_t);
+    }
+
+    bool empty() const { return buffer_.empty(); }
+
+private:
+    int restart_interval_;
+    std::string buffer_;
+    std::vector<uint32_t> restarts_;
+    int counter_ = 0;      ///< 自上一个重启点以来的 Entry 数
+    std::string last_key_;
+};
+
+/**
+ * @brief 只读的 Block 视图（不拥有数据）
+ *
+ * contents 通常是块缓存中的字符串，调用者需保证其生命周期长于 Block 及其迭代器。
+ * comparator 必须与构建时 Key 的排列顺序一致。
+ */
+class Block {
+public:
+    explicit Block(std::string_view contents, const Comparator* comparator = BytewiseComparator())
+        : data_(contents), comparator_(comparator) {
+        if (data_.size() < sizeof(uint32_t)) {
+            corrupted_ = true;
+            return;
+        }
+        num_restarts_ = decode_fixed32(data_.data() + data_.size() - sizeof(uint32_t));
+        uint64_t restarts_size = (static_cast<uint64_t>(num_restarts_) + 1) * sizeof(uint32_t);
+        if (num_restarts_ == 0 || restarts_size > data_.size()) {
+            corrupted_ = true;
+            return;
+        }
+        restarts_offset_ = data_.size() - static_cast<size_t>(restarts_size);
+    }
+
+    /// Block 结构是否损坏（重启点数组越界等）
+    bool corrupted() const { return corrupted_; }
+
+    uint32_t NumRestarts() const { return num_restarts_; }
+
+    /**
+     * @brief Block 内的双向迭代器
+     *
+     * Entry 只能从重启点开始向后解码，因此 Prev 先找到当前 Entry 之前的最后一个重启点，
+     * 再向后解码到当前 Entry 的前一个（至多 restart_interval 个 Entry）。
+     * 遇到损坏的 Entry 时 Valid() 变为 false，且 corrupted() 为 true。
+     */
+    class Iterator {
+    public:
+        explicit Iterator(const Block& block) : block_(block) {
+            if (block_.corrupted_) {
+                corrupted_ = true;
+            }
+        }
+
+        bool Valid() const { return valid_; }
+        bool corrupted() const { return corrupted_; }
+        std::string_view key() const { return key_; }
+        std::string_view value() const { return value_; }
+
+        void SeekToFirst() {
+            if (corrupted_) return;
+            SeekToRestart(0);
+            ParseNext();
+        }
+
+        void Next() {
+            if (valid_) ParseNext();
+        }
+
+        /// 定位到最后一个 Entry
+        void SeekToLast() {
+            if (corrupted_) return;
+            SeekToRestart(block_.num_restarts_ - 1);
+            while (ParseNext() && next_ < block_.restarts_offset_) {
+            }
+        }
+
+        /// 后退到前一个 Entry；当前已是第一个时变为无效
+        void Prev() {
+            if (!valid_) return;
+            const size_t original = current_;
+            if (block_.RestartOffset(0) >= original) {
+                valid_ = false;
+                return;
+            }
+            // 最后一个偏移 < original 的重启点
+            uint32_t left = 0;
+            uint32_t right = block_.num_restarts_ - 1;
+            while (left < right) {
+                uint32_t mid = (left + right + 1) / 2;
+                if (block_.RestartOffset(mid) < original) {
+                    left = mid;
+                } else {
+                    right = mid - 1;
+                }
+            }
+            SeekToRestart(left);
+            while (ParseNext() && next_ < original) {
+            }
+        }
+
+        /**
+         * @brief 定位到第一个 key >= target 的 Entry
+         *
+         * 1. 二分查找最后一个“重启点 Key < target”的重启点；
+         * 2. 从该重启点开始顺序解码，直到 key >= target。
+         */
+        void Seek(std::string_view target) {
+            if (corrupted_) return;
+            uint32_t left = 0;
+            uint32_t right = block_.num_restarts_ - 1;
+            while (left < right) {
+                uint32_t mid = (left + right + 1) / 2;
+                std::string_view mid_key;
+                if (!RestartKey(mid, &mid_key)) {
+                    MarkCorrupted();
+                    return;
+                }
+                if (block_.comparator_->Compare(mid_key, target) < 0) {
+                    left = mid;
+                } else {
+                    right = mid - 1;
+                }
+            }
+
+            SeekToRestart(left);
+            while (ParseNext()) {
+                if (block_.comparator_->Compare(key_, target) >= 0) return;
+            }
+        }
+
+    private:
+        const Block& block_;
+        size_t current_ = 0;     ///< 当前 Entry 的偏移
+        size_t next_ = 0;        ///< 下一个待解码 Entry 的偏移
+        std::string key_;        ///< 当前 Entry 的完整 Key（由前缀 + 后缀拼装）
+        std::string_view value_;
+        bool valid_ = false;
+        bool corrupted_ = false;
+
+        void MarkCorrupted() {
+            valid_ = false;
+            corrupted_ = true;
+        }
+
+        void SeekToRestart(uint32_t index) {
+            key_.clear();
+            valid_ = false;
+            next_ = block_.RestartOffset(index);
+        }
+
+        /// 解码重启点处的完整 Key（不改变迭代器状态）
+        bool RestartKey(uint32_t index, std::string_view* key) const {
+            const char* p = block_.data_.data() + block_.RestartOffset(index);
+            const char* limit = block_.data_.data() + block_.restarts_offset_;
+            uint32_t shared = 0, non_shared = 0, value_len = 0;
+            p = DecodeEntryHeader(p, limit, &shared, &non_shared, &value_len);
+            if (p == nullptr || shared != 0) return false;
+            *key = std::string_view(p, non_shared);
+            return true;
+        }
+
+        /// 解码下一个 Entry；到达末尾或损坏时返回 false
+        bool ParseNext() {
+            const char* p = block_.data_.data() + next_;
+            const char* limit = block_.data_.data() + block_.restarts_offset_;
+            if (p >= limit) {
+                valid_ = false;
+                return false;
+            }
+
+            current_ = next_;
+            uint32_t shared = 0, non_shared = 0, value_len = 0;
+            p = DecodeEntryHeader(p, limit, &shared, &non_shared, &value_len);
+            if (p == nullptr || shared > key_.size()) {
+                MarkCorrupted();
+                return false;
+            }
+            key_.resize(shared);
+            key_.append(p, non_shared);
+            value_ = std::string_view(p + non_shared, value_len);
+            next_ = static_cast<size_t>(p + non_shared + value_len - block_.data_.data());
+            valid_ = true;
+            return true;
+        }
+
+        /// 解码 Entry 头部的三个 varint，并检查 key_delta + value 不越界
+        static const char* DecodeEntryHeader(const char* p, const char* limit, uint32_t* shared,
+                                             uint32_t* non_shared, uint32_t* value_len) {
+            if ((p = get_varint32_ptr(p, limit, shared)) == nullptr) return nullptr;
+            if ((p = get_varint32_ptr(p, limit, non_shared)) == nullptr) return nullptr;
+            if ((p = get_varint32_ptr(p, limit, value_len)) == nullptr) return nullptr;
+            if (static_cast<uint64_t>(limit - p) < static_cast<uint64_t>(*non_shared) + *value_len) {
+                return nullptr;
+            }
+            return p;
+        }
+    };
+
+    /**
+     * @brief 点查
+     *
+     * @return true 找到；false 不存在
+     * @param corrupted [out] 可选，Block 损坏时置为 true
+     */
+    bool Get(std::string_view key, std::string* value, bool* corrupted = nullptr) const {
+        std::string_view view;
+        if (!Get(key, &view, corrupted)) return false;
+        value->assign(view.data(), view.size());
+        return true;
+    }
+
+    /**
+     * @brief 点查（零拷贝）：value 指向 Block 内容本身，与 contents 的生命周期相同
+     */
+    bool Get(std::string_view key, std::string_view* value, bool* corrupted = nullptr) const {
+        Iterator it(*this);
+        it.Seek(key);
+        if (corrupted) *corrupted = it.corrupted();
+        if (!it.Valid() || it.key() != key) return false;
+        *value = it.value();
+        return true;
+    }
+
+private:
+    std::string_view data_;
+    const Comparator* comparator_;
+    uint32_t num_restarts_ = 0;
+    size_t restarts_offset_ = 0;   ///< 重启点数组的起始偏移（即 Entry 区域的末尾）
+    bool corrupted_ = false;
+
+    size_t RestartOffset(uint32_t index) const {
+        uint32_t offset = decode_fixed32(data_.data() + restarts_offset_ + index * sizeof(uint32_t));
+        return offset < restarts_offset_ ? offset : restarts_offset_;
+    }
+};
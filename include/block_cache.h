@@ -0,0 +1,221 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 块缓存统计
+ */
+struct BlockCacheStats {
+    uint64_t hits = 0;          ///< Lookup 命中次数
+    uint64_t misses = 0;        ///< Lookup 未命中次数
+    uint64_t inserts = 0;       ///< Insert 次数
+    uint64_t evictions = 0;     ///< 因容量不足被淘汰的条目数
+    size_t usage = 0;           ///< 当前占用字节数（含固定条目）
+    size_t pinned_usage = 0;    ///< 其中固定 (pinned) 条目占用的字节数
+    size_t capacity = 0;        ///< 总容量
+
+    double hit_rate() const {
+        uint64_t total = hits + misses;
+        return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+    }
+};
+
+/**
+ * @brief 分片 LRU 块缓存，在所有打开的 SSTable 之间共享
+ *
+ * 缓存的是 **已通过 CRC 校验、已解码** 的 Block，命中时既省去磁盘读取，也省去重新校验。
+ *
+ * 设计要点：
+ * 1. **Key = (cache_id, block_offset)**：每个 SSTableReader 打开时通过 NewId() 领取唯一的
+ *    cache_id，因此不同文件（即使文件编号相同、位于不同目录）也不会冲突。
+ * 2. **分片**：按 Key 的哈希分到 2^num_shard_bits 个分片，每个分片独立加锁、独立做 LRU，
+ *    容量平均分配，降低并发读时的锁竞争。
+ * 3. **引用安全**：Value 以 shared_ptr 保存；条目被淘汰时，正在使用它的读请求仍持有引用，
+ *    内存在最后一个引用释放时才回收。
+ * 4. **固定条目 (pinned)**：Index / Filter Block 可以固定在缓存中——计入 usage，
+ *    但不参与 LRU 淘汰，直到显式 Erase（通常在 SSTableReader 析构时）。
+ *
+ * @note 本类是线程安全的。
+ */
+class BlockCache {
+public:
+    /**
+     * @param capacity 总容量（字节），按 charge 计算
+     * @param num_shard_bits 分片数为 2^num_shard_bits
+     */
+    explicit BlockCache(size_t capacity, int num_shard_bits = 4)
+        : capacity_(capacity), shards_(size_t{1} << num_shard_bits) {
+        size_t per_shard = (capacity + shards_.size() - 1) / shards_.size();
+        for (auto& shard : shards_) {
+            shard.capacity = per_shard;
+        }
+    }
+
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    /// 为一个新打开的文件分配唯一的缓存 ID
+    uint64_t NewId() { return next_id_.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * @brief 查询缓存
+     *
+     * @return 命中时返回缓存的对象（并将其移到 LRU 头部），否则返回 nullptr
+     */
+    std::shared_ptr<const void> Lookup(uint64_t id, uint64_t offset) {
+        Key key{id, offset};
+        Shard& shard = ShardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
+            shard.misses += 1;
+            return nullptr;
+        }
+        shard.hits += 1;
+        Entry& entry = *it->second;
+        if (!entry.pinned) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        }
+        return entry.value;
+    }
+
+    /**
+     * @brief 插入（或替换）一个条目
+     *
+     * 非固定条目插入后若超出分片容量，从 LRU 尾部淘汰，直到满足容量。
+     * 单个条目比整个分片还大时不会被缓存（但调用者拿着的 value 依然有效）。
+     *
+     * @param charge 条目占用的字节数
+     * @param pinned 为 true 时固定在缓存中，不参与淘汰
+     */
+    void Insert(uint64_t id, uint64_t offset, std::shared_ptr<const void> value, size_t charge,
+                bool pinned = false) {
+        Key key{id, offset};
+        Shard& shard = ShardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.inserts += 1;
+
+        auto it = shard.map.find(key);
+        if (it != shard.map.end()) {
+            RemoveLocked(shard, it);
+        }
+        if (!pinned && charge > shard.capacity) {
+            return;
+        }
+
+        auto& list = pinned ? shard.pinned : shard.lru;
+        list.push_front(Entry{key, std::move(value), charge, pinned});
+        shard.map.emplace(key, list.begin());
+        shard.usage += charge;
+        if (pinned) shard.pinned_usage += charge;
+
+        while (shard.usage > shard.capacity && !shard.lru.empty()) {
+            auto victim = shard.map.find(shard.lru.back().key);
+            RemoveLocked(shard, victim);
+            shard.evictions += 1;
+        }
+    }
+
+    /**
+     * @brief 删除一个条目（固定条目只能通过 Erase 移除）
+     */
+    void Erase(uint64_t id, uint64_t offset) {
+        Key key{id, offset};
+        Shard& shard = ShardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it != shard.map.end()) {
+            RemoveLocked(shard, it);
+        }
+    }
+
+    /// 汇总所有分片的统计
+    BlockCacheStats Stats() const {
+        BlockCacheStats stats;
+        stats.capacity = capacity_;
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            stats.hits += shard.hits;
+            stats.misses += shard.misses;
+            stats.inserts += shard.inserts;
+            stats.evictions += shard.evictions;
+            stats.usage += shard.usage;
+            stats.pinned_usage += shard.pinned_usage;
+        }
+        return stats;
+    }
+
+    size_t Capacity() const { return capacity_; }
+
+private:
+    struct Key {
+        uint64_t id;
+        uint64_t offset;
+        bool operator==(const Key& other) const { return id == other.id && offset == other.offset; }
+    };
+
+    /// 64 位混合（splitmix64 终结步骤），保证 offset 按 4KB 对齐时分布依然均匀
+    static uint64_t Mix(const Key& key) {
+        uint64_t x = key.id * 0x9e3779b97f4a7c15ull ^ key.offset;
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebull;
+        x ^= x >> 31;
+        return x;
+    }
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return static_cast<size_t>(Mix(key)); }
+    };
+
+    struct Entry {
+        Key key;
+        std::shared_ptr<const void> value;
+        size_t charge;
+        bool pinned;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        size_t capacity = 0;
+        size_t usage = 0;
+        size_t pinned_usage = 0;
+        std::list<Entry> lru;     ///< 非固定条目，头部为最近使用
+        std::list<Entry> pinned;  ///< 固定条目（不淘汰）
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> map;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t inserts = 0;
+        uint64_t evictions = 0;
+    };
+
+    size_t capacity_;
+    std::vector<Shard> shards_;
+    std::atomic<uint64_t> next_id_{1};
+
+    Shard& ShardFor(const Key& key) {
+        // 分片用高位，分片内的哈希表用低位，二者互不相关
+        return shards_[static_cast<size_t>(Mix(key) >> 32) & (shards_.size() - 1)];
+    }
+
+    void RemoveLocked(Shard& shard,
+                      std::unordered_map<Key, std::list<Entry>::iterator, KeyHash>::iterator it) {
+        auto entry = it->second;
+        shard.usage -= entry->charge;
+        if (entry->pinned) {
+            shard.pinned_usage -= entry->charge;
+            shard.pinned.erase(entry);
+        } else {
+            shard.lru.erase(entry);
+        }
+        shard.map.erase(it);
+    }
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+/**
+ * @file coding.h
+ * @brief 定长整数与 Key 的二进制编解码工具
+ *
+ * 与项目中其他模块（WAL / SSTable）保持一致：定长整数按主机字节序（小端）直接 memcpy。
+ */
+
+inline void encode_fixed32(char* dst, uint32_t value) {
+    std::memcpy(dst, &value, sizeof(uint32_t));
+}
+
+inline void encode_fixed64(char* dst, uint64_t value) {
+    std::memcpy(dst, &value, sizeof(uint64_t));
+}
+
+inline uint32_t decode_fixed32(const char* ptr) {
+    uint32_t value;
+    std::memcpy(&value, ptr, sizeof(uint32_t));
+    return value;
+}
+
+inline uint64_t decode_fixed64(const char* ptr) {
+    uint64_t value;
+    std::memcpy(&value, ptr, sizeof(uint64_t));
+    return value;
+}
+
+inline void put_fixed32(std::string& dst, uint32_t value) {
+    dst.append(reinterpret_cast<const char*>(&value), sizeof(uint32_t));
+}
+
+inline void put_fixed64(std::string& dst, uint64_t value) {
+    dst.append(reinterpret_cast<const char*>(&value), sizeof(uint64_t));
+}
+
+/// int Key 的二进制编码长度
+inline constexpr size_t kIntKeySize = 4;
+
+/**
+ * @brief 将 int Key 编码为 4 字节、保序的二进制串
+ *
+ * 编码规则：翻转符号位后按大端序输出。
+ * 这样编码结果按字节序 (memcmp) 比较的顺序与原 int 的大小顺序完全一致，
+ * 既可以直接写入 WAL，也可以作为 SSTable 中的有序 Key 使用。
+ *
+ * 例：-1 -> 7F FF FF FF，0 -> 80 00 00 00，1 -> 80 00 00 01
+ */
+inline std::string encode_int_key(int key) {
+    uint32_t u = static_cast<uint32_t>(key) ^ 0x80000000u;
+    char buf[kIntKeySize] = {
+        static_cast<char>(u >> 24), static_cast<char>(u >> 16),
+        static_cast<char>(u >> 8), static_cast<char>(u)};
+    return std::string(buf, kIntKeySize);
+}
+
+/**
+ * @brief 解码 encode_int_key 生成的 4 字节 Key
+ *
+ * @return false 如果长度不是 4 字节
+ */
+inline bool decode_int_key(std::string_view bytes, int* key) {
+    if (bytes.size() != kIntKeySize) return false;
+    const auto* p = reinterpret_cast<const uint8_t*>(bytes.data());
+    uint32_t u = (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                 (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    *key = static_cast<int>(u ^ 0x80000000u);
+    return true;
+}
+
+/// varint32 的最大编码长度
+inline constexpr size_t kMaxVarint32Length = 5;
+
+/**
+ * @brief 追加 varint32 编码（每字节 7 位有效数据，最高位为 1 表示后面还有字节）
+ *
+ * 小整数只占 1 字节，用于 Block 中的共享前缀长度等通常很小的字段。
+ */
+/// varint32 编码后的字节数
+inline size_t varint32_length(uint32_t value) {
+    size_t n = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++n;
+    }
+    return n;
+}
+
+/**
+ * @brief 把 varint32 写入 dst（至少 kMaxVarint32Length 字节可用）
+ *
+ * @return 写入后的下一个位置
+ */
+inline char* encode_varint32(char* dst, uint32_t value) {
+    while (value >= 0x80) {
+        *dst++ = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    *dst++ = static_cast<char>(value);
+    return dst;
+}
+
+inline void put_varint32(std::string& dst, uint32_t value) {
+    char buf[kMaxVarint32Length];
+    char* end = encode_varint32(buf, value);
+    dst.append(buf, static_cast<size_t>(end - buf));
+}
+
+/**
+ * @brief 从 [p, limit) 解码一个 varint32
+ *
+ * @return 解码后的下一个位置；数据不完整或超过 5 字节时返回 nullptr
+ */
+inline const char* get_varint32_ptr(const char* p, const char* limit, uint32_t* value) {
+    uint32_t result = 0;
+    for (uint32_t shift = 0; shift <= 28 && p < limit; shift += 7) {
+        uint32_t byte = static_cast<uint8_t>(*p++);
+        result |= (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return p;
+        }
+    }
+    return nullptr;
+}
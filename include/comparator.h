@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string_view>
+
+/**
+ * @brief Key 的全序比较器
+ *
+ * MemTable、SSTable 的 Block / Index 查找、Version 的文件范围以及 Compaction 的归并
+ * 都通过同一个比较器决定 Key 的先后顺序。
+ *
+ * 约定：
+ * - Compare(a, b) == 0 当且仅当 a 与 b 的字节完全相同（Bloom Filter 与相等判断按字节进行）；
+ * - Name() 会写入 MANIFEST，用不同名字的比较器打开已有数据目录会被拒绝，
+ *   因此修改排序规则时必须同时修改名字。
+ *
+ * @note 实现必须是线程安全的（通常是无状态的），且生命周期长于使用它的 KVStore。
+ */
+class Comparator {
+public:
+    virtual ~Comparator() = default;
+
+    /// 返回负数 / 0 / 正数表示 a 小于 / 等于 / 大于 b
+    virtual int Compare(std::string_view a, std::string_view b) const = 0;
+
+    /// 比较器的名字（持久化到 MANIFEST，用于检测排序规则不一致）
+    virtual const char* Name() const = 0;
+};
+
+/**
+ * @brief 按字节序 (memcmp) 比较，较短的前缀排在前面（默认比较器）
+ *
+ * encode_int_key 编码的 int Key 在该比较器下的顺序与原 int 的大小顺序一致。
+ */
+class BytewiseComparatorImpl : public Comparator {
+public:
+    int Compare(std::string_view a, std::string_view b) const override { return a.compare(b); }
+
+    const char* Name() const override { return "distributedkv.BytewiseComparator"; }
+};
+
+/// 默认比较器的单例（永不析构）
+inline const Comparator* BytewiseComparator() {
+    static const BytewiseComparatorImpl* const comparator = new BytewiseComparatorImpl();
+    return comparator;
+}
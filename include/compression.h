@@ -0,0 +1,154 @@
+#pragma once
+
+#include "coding.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#if defined(DKV_HAVE_LZ4)
+#include <lz4.h>
+#endif
+#if defined(DKV_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+/**
+ * @file compression.h
+ * @brief SSTable Block 压缩（LZ4 / Zstd，均为可选依赖）
+ *
+ * 压缩库在 CMake 配置阶段探测：找到头文件与库时定义 DKV_HAVE_LZ4 / DKV_HAVE_ZSTD。
+ * 未编译进来的算法在写入端自动退回不压缩（kNone），因此配置始终是安全的；
+ * 读取端遇到本进程不支持的压缩类型会报错（文件来自支持该算法的构建）。
+ *
+ * 压缩后的负载格式：
+ * +-----------------------------+--------------------+
+ * | RawSize (varint32)          | Compressed bytes   |
+ * +-----------------------------+--------------------+
+ * 记录原始大小便于解压时一次分配好输出缓冲区。
+ */
+
+/**
+ * @brief Block 的压缩类型（写入 Block 尾部的类型字节）
+ */
+enum class CompressionType : uint8_t {
+    kNone = 0,  ///< 不压缩
+    kLz4 = 1,   ///< LZ4：压缩 / 解压极快，适合频繁读写的热数据层
+    kZstd = 2   ///< Zstd：压缩率更高、CPU 开销更大，适合冷数据层
+};
+
+/// 本次构建是否支持该压缩类型
+inline bool compression_supported(CompressionType type) {
+    switch (type) {
+        case CompressionType::kNone:
+            return true;
+        case CompressionType::kLz4:
+#if defined(DKV_HAVE_LZ4)
+            return true;
+#else
+            return false;
+#endif
+        case CompressionType::kZstd:
+#if defined(DKV_HAVE_ZSTD)
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+inline const char* compression_name(CompressionType type) {
+    switch (type) {
+        case CompressionType::kNone: return "none";
+        case CompressionType::kLz4: return "lz4";
+        case CompressionType::kZstd: return "zstd";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief 压缩一段数据
+ *
+ * @param type 压缩类型（kNone 或不支持的类型直接返回 false）
+ * @param level Zstd 压缩级别（LZ4 忽略）
+ * @param output [out] 压缩后的负载（含 RawSize 前缀）
+ * @return false 表示未压缩（不支持或压缩失败），调用者应写入原始数据
+ */
+inline bool compress_block(CompressionType type, int level, std::string_view input,
+                           std::string* output) {
+    output->clear();
+    put_varint32(*output, static_cast<uint32_t>(input.size()));
+    [[maybe_unused]] size_t header = output->size();
+    (void)level;
+
+    switch (type) {
+        case CompressionType::kNone:
+            return false;
+        case CompressionType::kLz4: {
+#if defined(DKV_HAVE_LZ4)
+            int bound = LZ4_compressBound(static_cast<int>(input.size()));
+            output->resize(header + static_cast<size_t>(bound));
+            int n = LZ4_compress_default(input.data(), output->data() + header,
+                                         static_cast<int>(input.size()), bound);
+            if (n <= 0) return false;
+            output->resize(header + static_cast<size_t>(n));
+            return true;
+#else
+            return false;
+#endif
+        }
+        case CompressionType::kZstd: {
+#if defined(DKV_HAVE_ZSTD)
+            size_t bound = ZSTD_compressBound(input.size());
+            output->resize(header + bound);
+            size_t n = ZSTD_compress(output->data() + header, bound, input.data(), input.size(),
+                                     level);
+            if (ZSTD_isError(n)) return false;
+            output->resize(header + n);
+            return true;
+#else
+            return false;
+#endif
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 解压 compress_block 生成的负载
+ *
+ * @return false 表示类型不支持或数据损坏
+ */
+inline bool decompress_block(CompressionType type, std::string_view input,
+                             [[maybe_unused]] std::string* output) {
+    uint32_t raw_size = 0;
+    const char* p = get_varint32_ptr(input.data(), input.data() + input.size(), &raw_size);
+    if (p == nullptr) return false;
+    [[maybe_unused]] size_t compressed_size = static_cast<size_t>(input.data() + input.size() - p);
+
+    switch (type) {
+        case CompressionType::kNone:
+            return false;
+        case CompressionType::kLz4: {
+#if defined(DKV_HAVE_LZ4)
+            output->resize(raw_size);
+            int n = LZ4_decompress_safe(p, output->data(), static_cast<int>(compressed_size),
+                                        static_cast<int>(raw_size));
+            return n >= 0 && static_cast<uint32_t>(n) == raw_size;
+#else
+            return false;
+#endif
+        }
+        case CompressionType::kZstd: {
+#if defined(DKV_HAVE_ZSTD)
+            output->resize(raw_size);
+            size_t n = ZSTD_decompress(output->data(), raw_size, p, compressed_size);
+            return !ZSTD_isError(n) && n == raw_size;
+#else
+            return false;
+#endif
+        }
+    }
+    return false;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * @file cpu_affinity.h
+ * @brief 把线程绑定到指定 CPU（仅 Linux 生效，其他平台为空操作）
+ */
+
+/// 可用于绑定的 CPU 数（无法获取时为 1）
+inline unsigned available_cpus() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+/**
+ * @brief 把 native_handle 对应的线程绑定到 cpu % available_cpus()
+ *
+ * @return 是否绑定成功（cpu < 0 或平台不支持时返回 false）
+ */
+inline bool pin_thread_to_cpu(std::thread::native_handle_type handle, int cpu) {
+#ifdef __linux__
+    if (cpu < 0) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<unsigned>(cpu) % available_cpus(), &set);
+    return pthread_setaffinity_np(handle, sizeof(set), &set) == 0;
+#else
+    (void)handle;
+    (void)cpu;
+    return false;
+#endif
+}
+
+inline bool pin_thread_to_cpu(std::thread& thread, int cpu) {
+    return pin_thread_to_cpu(thread.native_handle(), cpu);
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 硬件 CRC 指令的编译期探测
+// - x86-64: SSE4.2 的 crc32 指令（通过 target 属性按函数开启，运行时用 CPUID 检测）
+// - ARMv8 : CRC 扩展的 crc32c* 指令（Linux 下用 getauxval 检测，或编译期已开启）
+#if defined(__x86_64__) || defined(_M_X64)
+#define DKV_CRC32C_X86 1
+#include <nmmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define DKV_TARGET_SSE42
+#else
+#define DKV_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_CRC32) || defined(__linux__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define DKV_CRC32C_ARM64 1
+#include <arm_acle.h>
+#if defined(__ARM_FEATURE_CRC32)
+#define DKV_TARGET_ARM_CRC
+#else
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#define DKV_TARGET_ARM_CRC __attribute__((target("+crc")))
+#endif
+#endif
+
+namespace crc_detail {
+
+/**
+ * @brief Slicing-by-8 查找表
+ *
+ * table[0] 就是经典的“逐字节查表法”表；table[k][i] 表示字节 i 之后再跟 k 个 0 字节时的 CRC 贡献。
+ * 这样每次可以用 8 次查表 + 异或同时处理 8 个字节，消除逐 bit 计算中的分支与循环依赖。
+ *
+ * @tparam Poly 反射形式的多项式（CRC32: 0xEDB88320，CRC32C: 0x82F63B78）
+ */
+template <uint32_t Poly>
+struct SlicingTables {
+    std::array<std::array<uint32_t, 256>, 8> table{};
+
+    constexpr SlicingTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int j = 0; j < 8; ++j) {
+                crc = (crc >> 1) ^ (Poly & (0u - (crc & 1u)));
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) {
+                uint32_t prev = table[k - 1][i];
+                table[k][i] = (prev >> 8) ^ table[0][prev & 0xFF];
+            }
+        }
+    }
+};
+
+/// 编译期生成的查找表（每个多项式 8KB，位于只读数据段）
+template <uint32_t Poly>
+inline constexpr SlicingTables<Poly> kSlicingTables{};
+
+/**
+ * @brief 使用 Slicing-by-8 推进 CRC 状态（可移植的软件实现）
+ *
+ * @param crc 未取反的内部状态（起始为 0xFFFFFFFF）
+ * @return uint32_t 推进后的内部状态（调用者负责最终取反）
+ */
+template <uint32_t Poly>
+inline uint32_t extend_slicing8(uint32_t crc, const char* data, size_t length) {
+    const auto& t = kSlicingTables<Poly>.table;
+    const auto* p = reinterpret_cast<const uint8_t*>(data);
+
+    if constexpr (std::endian::native == std::endian::little) {
+        while (length >= 8) {
+            uint32_t lo;
+            uint32_t hi;
+            std::memcpy(&lo, p, 4);
+            std::memcpy(&hi, p + 4, 4);
+            lo ^= crc;
+            crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^
+                  t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+                  t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^
+                  t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+            p += 8;
+            length -= 8;
+        }
+    }
+    while (length > 0) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xFF];
+        ++p;
+        --length;
+    }
+    return crc;
+}
+
+inline constexpr uint32_t kCrc32cPoly = 0x82F63B78;
+
+#if defined(DKV_CRC32C_X86)
+/**
+ * @brief SSE4.2 crc32 指令实现（每条指令处理 8 字节）
+ */
+DKV_TARGET_SSE42 inline uint32_t extend_sse42(uint32_t crc, const char* data, size_t length) {
+    const auto* p = reinterpret_cast<const uint8_t*>(data);
+    uint64_t c = crc;
+    while (length >= 8) {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        c = _mm_crc32_u64(c, v);
+        p += 8;
+        length -= 8;
+    }
+    uint32_t c32 = static_cast<uint32_t>(c);
+    while (length > 0) {
+        c32 = _mm_crc32_u8(c32, *p);
+        ++p;
+        --length;
+    }
+    return c32;
+}
+
+inline bool cpu_has_sse42() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+#endif
+
+#if defined(DKV_CRC32C_ARM64)
+/**
+ * @brief ARMv8 CRC 扩展实现（crc32cd 每条指令处理 8 字节）
+ */
+DKV_TARGET_ARM_CRC inline uint32_t extend_armv8(uint32_t crc, const char* data, size_t length) {
+    const auto* p = reinterpret_cast<const uint8_t*>(data);
+    while (length >= 8) {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        crc = __crc32cd(crc, v);
+        p += 8;
+        length -= 8;
+    }
+    while (length > 0) {
+        crc = __crc32cb(crc, *p);
+        ++p;
+        --length;
+    }
+    return crc;
+}
+
+inline bool cpu_has_arm_crc() {
+#if defined(__ARM_FEATURE_CRC32)
+    return true;
+#else
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#endif
+}
+#endif
+
+using ExtendFn = uint32_t (*)(uint32_t, const char*, size_t);
+
+/**
+ * @brief 运行时选择 CRC32C 实现：硬件指令优先，否则退化为 Slicing-by-8
+ */
+inline ExtendFn select_crc32c_impl() {
+#if defined(DKV_CRC32C_X86)
+    if (cpu_has_sse42()) return &extend_sse42;
+#elif defined(DKV_CRC32C_ARM64)
+    if (cpu_has_arm_crc()) return &extend_armv8;
+#endif
+    return &extend_slicing8<kCrc32cPoly>;
+}
+
+/// 进程内只探测一次（C++11 起函数内静态变量的初始化是线程安全的）
+inline ExtendFn crc32c_impl() {
+    static const ExtendFn fn = select_crc32c_impl();
+    return fn;
+}
+
+} // namespace crc_detail
+
+/**
+ * @brief 在已有 CRC32C 结果的基础上继续累加计算（Castagnoli 多项式 0x82F63B78）
+ *
+ * 允许对不连续的多段数据分段计算：
+ * crc32c_extend(crc32c(a, n), b, m) == crc32c(a + b, n + m)
+ *
+ * @param init_crc 之前若干段数据的 CRC32C 结果（首段传 0）
+ * @param data 待校验的数据起始地址
+ * @param length 待校验的数据长度（字节数）
+ * @return uint32_t 累加后的 CRC32C 校验和
+ */
+inline uint32_t crc32c_extend(uint32_t init_crc, const char* data, size_t length) {
+    return ~crc_detail::crc32c_impl()(~init_crc, data, length);
+}
+
+/**
+ * @brief 计算 CRC32C 校验和（iSCSI / ext4 / LevelDB 使用的 Castagnoli 多项式）
+ *
+ * 相比 CRC32 (IEEE)，CRC32C 在 x86 (SSE4.2) 与 ARMv8 上都有专用指令，
+ * 不支持时使用 Slicing-by-8 查表实现。
+ */
+inline uint32_t crc32c(const char* data, size_t length) {
+    return crc32c_extend(0, data, length);
+}
+
+/**
+ * @brief 当前进程实际使用的 CRC32C 实现名称（用于基准测试与日志输出）
+ *
+ * @return "sse4.2" / "armv8-crc" / "slicing-by-8"
+ */
+inline const char* crc32c_implementation() {
+    crc_detail::ExtendFn fn = crc_detail::crc32c_impl();
+#if defined(DKV_CRC32C_X86)
+    if (fn == &crc_detail::extend_sse42) return "sse4.2";
+#elif defined(DKV_CRC32C_ARM64)
+    if (fn == &crc_detail::extend_armv8) return "armv8-crc";
+#endif
+    (void)fn;
+    return "slicing-by-8";
+}
@@ -0,0 +1,418 @@
+#pragma once
+
+#include "dbformat.h"
+#include "iterator.h"
+#include "merging_iterator.h"
+#include "sstable_reader.h"
+#include "version_set.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @file db_iterator.h
+ * @brief 范围扫描：SSTable / 层级迭代器，以及面向用户的 DBIterator
+ */
+
+/**
+ * @brief 单个 SSTable 的 InternalIterator
+ *
+ * 内部 Key 格式的表直接产出表中的 Key / Value；更早格式的表中 Key 是 UserKey、
+ * Value 首字节是条目类型，这里把它们转换为序列号 0 的内部 Key 与去掉类型字节的值，
+ * 因此新旧格式的表可以在同一个 MergingIterator 中归并。
+ *
+ * 持有读取器的引用，即使文件随后被 Compaction 淘汰，迭代期间也能继续读取。
+ */
+class TableIterator : public InternalIterator {
+public:
+    /**
+     * @param table 被遍历的表
+     * @param fill_cache 读到的 Data Block 是否放入块缓存
+     */
+    TableIterator(std::shared_ptr<SSTableReader> table, bool fill_cache)
+        : table_(std::move(table)), iter_(*table_, fill_cache), internal_keys_(table_->HasInternalKeys()) {}
+
+    bool Valid() const override { return iter_.Valid(); }
+
+    void SeekToFirst() override {
+        iter_.SeekToFirst();
+        Decode();
+    }
+
+    void SeekToLast() override {
+        iter_.SeekToLast();
+        Decode();
+    }
+
+    void Seek(std::string_view target) override {
+        // 旧格式表中每个 UserKey 只有一个序列号为 0 的版本，它不小于同一 UserKey 的任何内部 Key
+        iter_.Seek(internal_keys_ ? target : extract_user_key(target));
+        Decode();
+    }
+
+    void Next() override {
+        iter_.Next();
+        Decode();
+    }
+
+    void Prev() override {
+        iter_.Prev();
+        Decode();
+    }
+
+    std::string_view key() const override { return internal_keys_ ? iter_.key() : std::string_view(key_); }
+    std::string_view value() const override { return internal_keys_ ? iter_.value() : value_; }
+
+private:
+    std::shared_ptr<SSTableReader> table_;   ///< 必须先于 iter_ 构造
+    SSTableReader::Iterator iter_;
+    bool internal_keys_;
+    std::string key_;                        ///< 旧格式表：转换后的内部 Key
+    std::string_view value_;                 ///< 旧格式表：去掉类型字节的值
+
+    void Decode() {
+        if (internal_keys_ || !iter_.Valid()) return;
+        ValueType type;
+        if (!decode_table_value(iter_.value(), &type, &value_)) {
+            throw std::runtime_error("Malformed value in SSTable: " + table_->FilePath());
+        }
+        key_.clear();
+        append_internal_key(key_, iter_.key(), 0, type);
+    }
+};
+
+/**
+ * @brief L1 及更深的某一层（或其中一段连续文件）的 InternalIterator：文件互不重叠，首尾相接地遍历
+ *
+ * 同一时刻只打开一个文件的迭代器：Seek 先按 Largest 二分查找目标文件，
+ * 当前文件耗尽时再打开下一个（或上一个）文件，因此不需要为每个文件各建一个子迭代器。
+ * 同一个 UserKey 的所有版本总是位于同一个文件中（Compaction 只在 UserKey 变化处切分输出）。
+ */
+class LevelIterator : public InternalIterator {
+public:
+    /**
+     * @param version 持有它保证层内文件在迭代期间不被删除
+     * @param level 被遍历的层（>= 1）
+     * @param fill_cache 读到的 Data Block 是否放入块缓存
+     */
+    LevelIterator(std::shared_ptr<const Version> version, int level, bool fill_cache)
+        : version_(std::move(version))
+        , comparator_(version_->comparator())
+        , files_(&version_->Files(level))
+        , fill_cache_(fill_cache) {}
+
+    /**
+     * @param files 按 Key 有序、互不重叠的文件（Compaction 的输入）
+     * @param comparator UserKey 的比较器
+     * @param fill_cache 读到的 Data Block 是否放入块缓存
+     */
+    LevelIterator(Version::FileList files, const Comparator* comparator, bool fill_cache)
+        : comparator_(comparator), owned_files_(std::move(files)), files_(&owned_files_), fill_cache_(fill_cache) {}
+
+    LevelIterator(const LevelIterator&) = delete;
+    LevelIterator& operator=(const LevelIterator&) = delete;
+
+    bool Valid() const override { return table_ != nullptr && table_->Valid(); }
+
+    void SeekToFirst() override {
+        OpenFile(0);
+        if (table_) table_->SeekToFirst();
+        SkipEmptyFilesForward();
+    }
+
+    void SeekToLast() override {
+        OpenFile(files_->empty() ? 0 : files_->size() - 1);
+        if (table_) table_->SeekToLast();
+        SkipEmptyFilesBackward();
+    }
+
+    void Seek(std::string_view target) override {
+        const Comparator* cmp = comparator_;
+        std::string_view user_key = extract_user_key(target);
+        auto it = std::lower_bound(files_->begin(), files_->end(), user_key,
+                                   [cmp](const std::shared_ptr<TableFile>& file, std::string_view k) {
+                                       return cmp->Compare(file->Largest(), k) < 0;
+                                   });
+        OpenFile(static_cast<size_t>(it - files_->begin()));
+        if (table_) table_->Seek(target);
+        SkipEmptyFilesForward();
+    }
+
+    void Next() override {
+        if (!Valid()) return;
+        table_->Next();
+        SkipEmptyFilesForward();
+    }
+
+    void Prev() override {
+        if (!Valid()) return;
+        table_->Prev();
+        SkipEmptyFilesBackward();
+    }
+
+    std::string_view key() const override { return table_->key(); }
+    std::string_view value() const override { return table_->value(); }
+
+private:
+    std::shared_ptr<const Version> version_;
+    const Comparator* comparator_;
+    Version::FileList owned_files_;
+    const Version::FileList* files_;          ///< 指向 version_ 中的一层或 owned_files_
+    bool fill_cache_;
+    size_t file_index_ = 0;
+    std::unique_ptr<TableIterator> table_;   ///< 当前文件的迭代器；越过两端时为空
+
+    void OpenFile(size_t index) {
+        file_index_ = index;
+        table_.reset();
+        if (index < files_->size()) {
+            table_ = std::make_unique<TableIterator>((*files_)[index]->Reader(), fill_cache_);
+        }
+    }
+
+    void SkipEmptyFilesForward() {
+        while (table_ && !table_->Valid()) {
+            OpenFile(file_index_ + 1);
+            if (table_) table_->SeekToFirst();
+        }
+    }
+
+    void SkipEmptyFilesBackward() {
+        while (table_ && !table_->Valid()) {
+            if (file_index_ == 0) {
+                table_.reset();
+                return;
+            }
+            OpenFile(file_index_ - 1);
+            table_->SeekToLast();
+        }
+    }
+};
+
+/**
+ * @brief 面向用户的有序迭代器：归并所有 MemTable 与 SSTable，按快照产出每个 Key 可见的最新版本
+ *
+ * 由 KVStore::new_iterator() 创建。迭代器持有创建时的 MemTable 集合与 Version 的引用，
+ * 迭代期间的落盘与 Compaction 不会使它失效，其中的文件也不会被删除。
+ *
+ * 一致性快照：只有序列号 <= sequence 的版本可见，每个 UserKey 取其中最新的一个（删除标记则整个 Key
+ * 不出现）。迭代期间的新写入序列号更大，不会被看到；Compaction 保留快照需要的旧版本
+ * （隐式快照由持有的 Version 保证，显式快照由 KVStore 的快照列表保证）。
+ *
+ * 实现参考 LevelDB 的 DBIter：正向时底层迭代器停在产出的条目上；反向时底层迭代器停在
+ * 产出的 Key 的所有版本之前，产出的 Key / Value 保存在 saved_key_ / saved_value_ 中。
+ * 产出的条目是 BlobIndex 时，由 resolver 从 Blob 文件读出 Value，保存在 blob_value_ 中。
+ *
+ * @note 本类非线程安全；key() / value() 的视图在迭代器下一次移动之前有效。
+ */
+class DBIterator {
+public:
+    /// 把 (UserKey, 编码后的 BlobIndex) 解引用为 Value
+    using BlobResolver =
+        std::function<std::shared_ptr<const std::string>(std::string_view user_key, std::string_view blob_index)>;
+
+    /**
+     * @param merged 归并后的内部迭代器（按内部 Key 有序）
+     * @param comparator UserKey 的比较器
+     * @param sequence 快照的序列号
+     * @param pins 迭代期间需要保持存活的对象（MemTable 集合、Version 等）
+     * @param resolver 解引用 BlobIndex 条目（没有 Blob 文件时可为空）
+     */
+    DBIterator(std::unique_ptr<InternalIterator> merged, const Comparator* comparator,
+               SequenceNumber sequence, std::vector<std::shared_ptr<const void>> pins,
+               BlobResolver resolver = nullptr)
+        : pins_(std::move(pins))
+        , iter_(std::move(merged))
+        , comparator_(comparator)
+        , sequence_(sequence)
+        , resolver_(std::move(resolver)) {}
+
+    DBIterator(const DBIterator&) = delete;
+    DBIterator& operator=(const DBIterator&) = delete;
+
+    bool Valid() const { return valid_; }
+
+    /// 迭代器读取的快照序列号
+    SequenceNumber sequence() const { return sequence_; }
+
+    void SeekToFirst() {
+        direction_ = Direction::kForward;
+        iter_->SeekToFirst();
+        FindNextUserEntry(false);
+    }
+
+    void SeekToLast() {
+        direction_ = Direction::kReverse;
+        iter_->SeekToLast();
+        FindPrevUserEntry();
+    }
+
+    /// 定位到第一个 key >= target 的存活条目
+    void Seek(std::string_view target) {
+        direction_ = Direction::kForward;
+        saved_key_ = make_internal_key(target, sequence_, ValueType::kValue);
+        iter_->Seek(saved_key_);
+        FindNextUserEntry(false);
+    }
+
+    void Next() {
+        if (!valid_) return;
+        if (direction_ == Direction::kReverse) {
+            // 底层迭代器位于当前 Key 的所有版本之前：先移回当前 Key 的范围内
+            direction_ = Direction::kForward;
+            if (!iter_->Valid()) {
+                iter_->SeekToFirst();
+            } else {
+                iter_->Next();
+            }
+            if (!iter_->Valid()) {
+                valid_ = false;
+                saved_key_.clear();
+                blob_value_.reset();
+                return;
+            }
+            // saved_key_ 已是当前 UserKey，跳过它的所有版本
+        } else {
+            saved_key_.assign(UserKey(iter_->key()));
+            iter_->Next();
+        }
+        FindNextUserEntry(true);
+    }
+
+    void Prev() {
+        if (!valid_) return;
+        if (direction_ == Direction::kForward) {
+            // 底层迭代器位于当前条目上：后退到当前 UserKey 的所有版本之前
+            saved_key_.assign(UserKey(iter_->key()));
+            while (true) {
+                iter_->Prev();
+                if (!iter_->Valid()) {
+                    valid_ = false;
+                    saved_key_.clear();
+                    ClearSavedValue();
+                    blob_value_.reset();
+                    return;
+                }
+                if (comparator_->Compare(UserKey(iter_->key()), saved_key_) < 0) break;
+            }
+            direction_ = Direction::kReverse;
+        }
+        FindPrevUserEntry();
+    }
+
+    std::string_view key() const {
+        return direction_ == Direction::kForward ? UserKey(iter_->key()) : std::string_view(saved_key_);
+    }
+
+    std::string_view value() const {
+        if (blob_value_) return *blob_value_;
+        return direction_ == Direction::kForward ? iter_->value() : std::string_view(saved_value_);
+    }
+
+private:
+    enum class Direction { kForward, kReverse };
+
+    std::vector<std::shared_ptr<const void>> pins_;   ///< 必须晚于 iter_ 析构
+    std::unique_ptr<InternalIterator> iter_;
+    const Comparator* comparator_;
+    SequenceNumber sequence_;
+    Direction direction_ = Direction::kForward;
+    bool valid_ = false;
+    std::string saved_key_;     ///< 反向：当前 UserKey；正向：被跳过的 UserKey
+    std::string saved_value_;   ///< 反向：当前值
+    BlobResolver resolver_;
+    std::shared_ptr<const std::string> blob_value_;  ///< 当前条目是 BlobIndex 时解引用得到的值
+
+    static std::string_view UserKey(std::string_view internal_key) { return extract_user_key(internal_key); }
+
+    ParsedInternalKey Parse() const {
+        ParsedInternalKey parsed;
+        if (!parse_internal_key(iter_->key(), &parsed)) {
+            throw std::runtime_error("Malformed internal key during iteration");
+        }
+        return parsed;
+    }
+
+    void ClearSavedValue() {
+        if (saved_value_.capacity() > 1 << 20) {
+            std::string().swap(saved_value_);
+        } else {
+            saved_value_.clear();
+        }
+    }
+
+    /**
+     * @brief 正向找到第一个可见的存活条目
+     *
+     * @param skipping 为 true 时跳过 UserKey <= saved_key_ 的条目（越过当前 Key 的旧版本）
+     */
+    void FindNextUserEntry(bool skipping) {
+        blob_value_.reset();
+        for (; iter_->Valid(); iter_->Next()) {
+            ParsedInternalKey parsed = Parse();
+            if (parsed.sequence > sequence_) continue;
+            if (parsed.type == ValueType::kDeletion) {
+                // 删除标记遮蔽该 Key 的所有更老版本
+                saved_key_.assign(parsed.user_key);
+                skipping = true;
+            } else if (skipping && comparator_->Compare(parsed.user_key, saved_key_) <= 0) {
+                // 被遮蔽的旧版本
+            } else {
+                valid_ = true;
+                saved_key_.clear();
+                if (parsed.type == ValueType::kBlobIndex) blob_value_ = Resolve(parsed.user_key, iter_->value());
+                return;
+            }
+        }
+        saved_key_.clear();
+        valid_ = false;
+    }
+
+    /**
+     * @brief 反向找到前一个可见的存活条目：收集一个 UserKey 的所有可见版本，取最新的一个
+     *
+     * 反向遍历时同一 UserKey 的版本从旧到新出现，遇到更小的 UserKey 时才能确定上一个 Key 的结果。
+     */
+    void FindPrevUserEntry() {
+        blob_value_.reset();
+        ValueType value_type = ValueType::kDeletion;
+        for (; iter_->Valid(); iter_->Prev()) {
+            ParsedInternalKey parsed = Parse();
+            if (parsed.sequence > sequence_) continue;
+            if (value_type != ValueType::kDeletion &&
+                comparator_->Compare(parsed.user_key, saved_key_) < 0) {
+                break;  // 已越过一个存活 Key 的所有可见版本
+            }
+            value_type = parsed.type;
+            if (value_type == ValueType::kDeletion) {
+                saved_key_.clear();
+                ClearSavedValue();
+            } else {
+                saved_key_.assign(parsed.user_key);
+                saved_value_.assign(iter_->value());
+            }
+        }
+
+        if (value_type == ValueType::kDeletion) {
+            valid_ = false;
+            saved_key_.clear();
+            ClearSavedValue();
+            direction_ = Direction::kForward;
+        } else {
+            valid_ = true;
+            if (value_type == ValueType::kBlobIndex) blob_value_ = Resolve(saved_key_, saved_value_);
+        }
+    }
+
+    std::shared_ptr<const std::string> Resolve(std::string_view user_key, std::string_view blob_index) const {
+        if (!resolver_) throw std::runtime_error("Blob index found during iteration without a resolver");
+        return resolver_(user_key, blob_index);
+    }
+};
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "coding.h"
+#include "comparator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @file dbformat.h
+ * @brief 存储引擎内部的数据格式约定（条目类型、序列号与内部 Key、SSTable Value 编码）
+ */
+
+/**
+ * @brief 条目类型：正常值、删除标记（Tombstone）或指向 Blob 文件的指针
+ *
+ * LSM-Tree 中删除不能直接“抹掉”数据：旧值可能还躺在更老的 SSTable 里。
+ * 因此删除会写入一条 kDeletion 条目，它在读路径上“遮蔽”所有更老的版本，
+ * 直到 Compaction 确认不存在更老版本后才被真正丢弃。
+ *
+ * kBlobIndex 只出现在 SSTable 中：大 Value 落盘时被分离到 Blob 文件（见 blob_file.h），
+ * 条目的值换成编码后的 BlobIndex，读取时再解引用。
+ */
+enum class ValueType : uint8_t {
+    kDeletion = 0,
+    kValue = 1,
+    kBlobIndex = 2
+};
+
+/**
+ * @brief SSTable 中 Value 的编码：ValueType(1B) | Value Bytes
+ *
+ * SSTableBuilder 本身不关心 Value 的含义，KVStore 落盘时把条目类型编码进 Value 首字节。
+ */
+inline std::string encode_table_value(ValueType type, std::string_view value) {
+    std::string out;
+    out.reserve(1 + value.size());
+    out.push_back(static_cast<char>(type));
+    out.append(value);
+    return out;
+}
+
+/**
+ * @brief 解码 encode_table_value 生成的 Value
+ *
+ * @return false 如果编码为空或类型字节非法
+ */
+inline bool decode_table_value(std::string_view encoded, ValueType* type, std::string_view* value) {
+    if (encoded.empty()) return false;
+    uint8_t t = static_cast<uint8_t>(encoded[0]);
+    if (t != static_cast<uint8_t>(ValueType::kDeletion) && t != static_cast<uint8_t>(ValueType::kValue)) {
+        return false;
+    }
+    *type = static_cast<ValueType>(t);
+    *value = encoded.substr(1);
+    return true;
+}
+
+/**
+ * @brief 写入的序列号：每个 put / del（批次中的每个操作）分配一个，全局单调递增
+ *
+ * 同一个 Key 的多个版本按序列号区分，读请求只看序列号不大于其快照的版本。
+ * 有效的序列号从 1 开始；0 留给没有序列号的旧格式数据（比任何新写入都老）。
+ */
+using SequenceNumber = uint64_t;
+
+/// 序列号的上限：与 ValueType 一起打包进 8 字节的 Tag，只有 56 位可用
+inline constexpr SequenceNumber kMaxSequenceNumber = (uint64_t{1} << 56) - 1;
+
+/// 内部 Key 末尾 Tag 的长度
+inline constexpr size_t kInternalKeyTagSize = 8;
+
+/**
+ * @brief 内部 Key：UserKey | Tag (8B, 小端)，Tag = (Sequence << 8) | ValueType
+ *
+ * MemTable 与新格式 SSTable 中同一个 UserKey 的每个版本都是一条独立的条目，
+ * 按 InternalKeyComparator 排序：UserKey 升序，相同 UserKey 时序列号降序（新版本在前）。
+ */
+inline uint64_t pack_sequence_and_type(SequenceNumber sequence, ValueType type) {
+    return (sequence << 8) | static_cast<uint64_t>(type);
+}
+
+/// 把 user_key 与 Tag 追加为一个内部 Key
+inline void append_internal_key(std::string& dst, std::string_view user_key, SequenceNumber sequence,
+                                ValueType type) {
+    dst.append(user_key.data(), user_key.size());
+    put_fixed64(dst, pack_sequence_and_type(sequence, type));
+}
+
+inline std::string make_internal_key(std::string_view user_key, SequenceNumber sequence, ValueType type) {
+    std::string key;
+    key.reserve(user_key.size() + kInternalKeyTagSize);
+    append_internal_key(key, user_key, sequence, type);
+    return key;
+}
+
+/// 内部 Key 的各个部分（user_key 指向原内部 Key 的内存）
+struct ParsedInternalKey {
+    std::string_view user_key;
+    SequenceNumber sequence = 0;
+    ValueType type = ValueType::kValue;
+};
+
+/**
+ * @brief 解析内部 Key
+ *
+ * @return false 如果长度不足 8 字节或类型字节非法
+ */
+inline bool parse_internal_key(std::string_view internal_key, ParsedInternalKey* result) {
+    if (internal_key.size() < kInternalKeyTagSize) return false;
+    size_t n = internal_key.size() - kInternalKeyTagSize;
+    uint64_t tag = decode_fixed64(internal_key.data() + n);
+    uint8_t type = static_cast<uint8_t>(tag & 0xFF);
+    if (type > static_cast<uint8_t>(ValueType::kBlobIndex)) {
+        return false;
+    }
+    result->user_key = internal_key.substr(0, n);
+    result->sequence = tag >> 8;
+    result->type = static_cast<ValueType>(type);
+    return true;
+}
+
+/// 内部 Key 中的 UserKey（调用者保证长度至少为 8 字节）
+inline std::string_view extract_user_key(std::string_view internal_key) {
+    return internal_key.substr(0, internal_key.size() - kInternalKeyTagSize);
+}
+
+/**
+ * @brief 内部 Key 的比较器：先按用户比较器比较 UserKey，相同时按序列号降序（新版本在前）
+ *
+ * 类型不参与比较：查找 (key, snapshot, 任意类型) 总是定位到序列号不大于 snapshot 的最新版本；
+ * 旧格式 SSTable 中同一个 Key 的值与删除标记序列号都是 0，二者相等，由归并时的新旧顺序决定取舍。
+ */
+class InternalKeyComparator : public Comparator {
+public:
+    explicit InternalKeyComparator(const Comparator* user_comparator) : user_comparator_(user_comparator) {}
+
+    int Compare(std::string_view a, std::string_view b) const override {
+        int r = user_comparator_->Compare(extract_user_key(a), extract_user_key(b));
+        if (r != 0) return r;
+        SequenceNumber aseq = decode_fixed64(a.data() + a.size() - kInternalKeyTagSize) >> 8;
+        SequenceNumber bseq = decode_fixed64(b.data() + b.size() - kInternalKeyTagSize) >> 8;
+        if (aseq > bseq) return -1;
+        if (aseq < bseq) return 1;
+        return 0;
+    }
+
+    const char* Name() const override { return "distributedkv.InternalKeyComparator"; }
+
+    const Comparator* user_comparator() const { return user_comparator_; }
+
+private:
+    const Comparator* user_comparator_;
+};
@@ -0,0 +1,437 @@
+#pragma once
+#include "skiplist.h"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <optional>
+#include <random>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @file fat_skiplist.h
+ * @brief 定宽键的"胖节点"跳表（B-skiplist 布局）
+ *
+ * SkipList<K, V> 每个节点只存一个键，每次比较都要沿 forward 指针解引用到另一块堆内存。
+ * 对 int、int64_t、double 这类定宽、可平凡拷贝的键，FatSkipList 改用以下布局：
+ * - 每个节点按序存放最多 kNodeKeys 个键，键数组连续存放，正好占一个 64 字节缓存行；
+ * - 每一层的 forward 指针旁边缓存后继节点的首键。逐层下沉时只比较这个缓存的首键，不解引用后继；
+ * - 到达 Level 0 的节点后，用一个定长、无分支的循环统计"小于目标的键数"得到目标位置。
+ *   空槽填充为该类型的最大值（浮点数为 +inf），不影响计数。
+ *   编译器可以把这个循环向量化，用一次 SIMD 比较跨过整个节点；
+ * - 节点数约为 SkipList 的 1 / kNodeKeys，层数与指针跳转次数随之减少。
+ *
+ * 与 SkipList 的区别：insert / remove 会在节点内移动键值，
+ * 因此 find 返回的指针以及迭代器都只在下一次 insert / remove 之前有效。
+ * 被删空的节点立即释放；未满的相邻节点不合并。
+ *
+ * @note 本类非线程安全。
+ */
+
+/**
+ * @brief 可以使用 FatSkipList 的键：定宽、可平凡拷贝、按 < 全序比较的算术类型（不含 bool）
+ *
+ * 浮点键不能为 NaN。
+ */
+template <typename K>
+concept PackedSkipListKey = std::is_arithmetic_v<K> && !std::is_same_v<K, bool> &&
+                            std::is_trivially_copyable_v<K> && std::totally_ordered<K>;
+
+/**
+ * @brief 定宽键的胖节点跳表，接口与 SkipList<K, V> 一致
+ */
+template <PackedSkipListKey K, typename V>
+class FatSkipList {
+public:
+    /// 每个节点容纳的键数：键数组占满一个 64 字节缓存行，至少 4 个、至多 16 个
+    static constexpr int kNodeKeys = static_cast<int>(std::clamp<std::size_t>(64 / sizeof(K), 4, 16));
+
+private:
+    /// 空槽填充值：不小于任何合法键，节点内计数时不会被算入
+    static constexpr K padding_key() {
+        if constexpr (std::numeric_limits<K>::has_infinity) {
+            return std::numeric_limits<K>::infinity();
+        } else {
+            return std::numeric_limits<K>::max();
+        }
+    }
+
+    struct FatNode;
+
+    /// 某一层的后继：后继节点的首键与指针放在一起
+    struct Link {
+        K key;
+        FatNode* node;
+    };
+
+    /**
+     * @brief 胖节点。Link 数组紧跟在节点之后，与节点在同一次分配中
+     */
+    struct alignas(Link) alignas(V) FatNode {
+        K keys[kNodeKeys];    // 升序，[count, kNodeKeys) 为 padding_key()
+        V values[kNodeKeys];
+        int count = 0;
+        int height;
+
+        explicit FatNode(int h) : height(h) { std::fill(std::begin(keys), std::end(keys), padding_key()); }
+
+        Link& link(int level) {
+            return reinterpret_cast<Link*>(reinterpret_cast<char*>(this) + sizeof(FatNode))[level];
+        }
+
+        /// 节点内小于 target 的键数，即 target 在节点内的下界位置。定长、无分支，便于向量化
+        int rank(const K& target) const {
+            int r = 0;
+            for (int i = 0; i < kNodeKeys; ++i) {
+                r += keys[i] < target ? 1 : 0;
+            }
+            return r;
+        }
+
+        void insert_at(int pos, K key, V value) {
+            for (int i = count; i > pos; --i) {
+                keys[i] = keys[i - 1];
+                values[i] = std::move(values[i - 1]);
+            }
+            keys[pos] = key;
+            values[pos] = std::move(value);
+            ++count;
+        }
+
+        void erase_at(int pos) {
+            for (int i = pos; i + 1 < count; ++i) {
+                keys[i] = keys[i + 1];
+                values[i] = std::move(values[i + 1]);
+            }
+            --count;
+            keys[count] = padding_key();
+            values[count] = V();
+        }
+    };
+
+    int max_level;      // 跳表允许的最大层数
+    int current_level;  // 当前跳表实际存在的最高层数
+    FatNode* head;      // 哨兵头节点，不存键
+    float p;            // 节点层数晋升的概率因子
+    std::vector<FatNode*> update_;  // insert / remove 记录每层前驱的暂存区，避免每次分配
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> dist;
+
+    int random_level() {
+        int level = 1;
+        while (dist(rng) < p && level < max_level) {
+            level++;
+        }
+        return level;
+    }
+
+    static FatNode* new_node(int height) {
+        static_assert(alignof(FatNode) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+        void* mem = ::operator new(sizeof(FatNode) + sizeof(Link) * static_cast<std::size_t>(height));
+        FatNode* node = new (mem) FatNode(height);
+        for (int i = 0; i < height; ++i) {
+            new (&node->link(i)) Link{padding_key(), nullptr};
+        }
+        return node;
+    }
+
+    static void delete_node(FatNode* node) {
+        node->~FatNode();
+        ::operator delete(node);
+    }
+
+public:
+    /**
+     * @brief FatSkipList 构造函数
+     * @param max_lvl 最大允许层数
+     * @param prob 晋升概率因子，默认 0.5
+     */
+    FatSkipList(int max_lvl, float prob = 0.5f)
+        : max_level(max_lvl),
+          current_level(1),
+          head(new_node(max_lvl)),
+          p(prob),
+          update_(static_cast<std::size_t>(max_lvl), nullptr),
+          rng(std::random_device{}()),
+          dist(0.0f, 1.0f) {}
+
+    ~FatSkipList() {
+        FatNode* node = head->link(0).node;
+        while (node != nullptr) {
+            FatNode* next = node->link(0).node;
+            delete_node(node);
+            node = next;
+        }
+        delete_node(head);
+    }
+
+    FatSkipList(const FatSkipList&) = delete;
+    FatSkipList& operator=(const FatSkipList&) = delete;
+
+    /**
+     * @brief 插入或更新一个键值对
+     *
+     * 目标节点已满时分裂为两半；键大于节点内所有键时（顺序写入）新节点只放这一个键，
+     * 顺序写入因此得到全满的节点。
+     *
+     * @return true 总是成功
+     */
+    bool insert(K key, V value);
+
+    /**
+     * @brief 根据键查找对应的值
+     * @return std::optional<V> 找到则返回值的拷贝，否则返回 std::nullopt
+     */
+    std::optional<V> search(K key) const {
+        const V* value = find(key);
+        if (value == nullptr) return std::nullopt;
+        return *value;
+    }
+
+    /**
+     * @brief 根据键查找对应的值（不拷贝值）
+     * @return const V* 指向节点中的值；键不存在时为 nullptr。指针在下一次 insert / remove 之前有效
+     */
+    const V* find(const K& key) const {
+        auto [node, index] = lower_bound(key);
+        if (node != nullptr && node->keys[index] == key) return &node->values[index];
+        return nullptr;
+    }
+
+    /**
+     * @brief 根据键删除
+     * @return false 键不存在
+     */
+    bool remove(K key);
+
+    /**
+     * @brief 按 key 升序遍历所有键值对
+     * @tparam F 可调用对象，签名为 void(const K& key, const V& value)
+     */
+    template <typename F>
+    void for_each(F&& fn) const {
+        for (FatNode* node = head->link(0).node; node != nullptr; node = node->link(0).node) {
+            for (int i = 0; i < node->count; ++i) fn(node->keys[i], node->values[i]);
+        }
+    }
+
+    /**
+     * @brief 双向有序迭代器，位置为 (节点, 节点内下标)
+     *
+     * Next 为 O(1)；Prev 在节点内为 O(1)，跨节点时从高层重新查找前驱节点，O(log n)。
+     * 任何 insert / remove 都会使迭代器失效。
+     */
+    class Iterator {
+    public:
+        explicit Iterator(const FatSkipList* list) : list_(list) {}
+
+        bool Valid() const { return node_ != nullptr; }
+
+        const K& key() const { return node_->keys[index_]; }
+        const V& value() const { return node_->values[index_]; }
+
+        void Next() {
+            if (node_ && ++index_ == node_->count) {
+                node_ = node_->link(0).node;
+                index_ = 0;
+            }
+        }
+
+        void Prev() {
+            if (!node_) return;
+            if (index_ > 0) {
+                --index_;
+                return;
+            }
+            FatNode* prev = list_->find_less_than(node_->keys[0]);
+            node_ = prev == list_->head ? nullptr : prev;
+            index_ = node_ ? node_->count - 1 : 0;
+        }
+
+        /// 定位到第一个 key >= target 的位置
+        void Seek(const K& target) { std::tie(node_, index_) = list_->lower_bound(target); }
+
+        void SeekToFirst() {
+            node_ = list_->head->link(0).node;
+            index_ = 0;
+        }
+
+        void SeekToLast() {
+            node_ = list_->find_last();
+            index_ = node_ ? node_->count - 1 : 0;
+        }
+
+    private:
+        const FatSkipList* list_;
+        FatNode* node_ = nullptr;
+        int index_ = 0;
+    };
+
+private:
+    /// 最后一个首键 < target 的节点（不存在时为 head）；update 非空时记录每层的这一节点
+    FatNode* find_less_than(const K& target, FatNode** update = nullptr) const {
+        FatNode* current = head;
+        for (int i = current_level - 1; i >= 0; i--) {
+            while (current->link(i).node && current->link(i).key < target) {
+                current = current->link(i).node;
+            }
+            if (update) update[i] = current;
+        }
+        return current;
+    }
+
+    /// 第一个 key >= target 的位置（不存在时节点为 nullptr）
+    std::pair<FatNode*, int> lower_bound(const K& target) const {
+        FatNode* node = find_less_than(target);
+        if (node != head) {
+            int r = node->rank(target);
+            if (r < node->count) return {node, r};
+        }
+        return {node->link(0).node, 0};
+    }
+
+    /// 最后一个节点（跳表为空时为 nullptr）
+    FatNode* find_last() const {
+        FatNode* current = head;
+        for (int i = current_level - 1; i >= 0; i--) {
+            while (current->link(i).node) current = current->link(i).node;
+        }
+        return current == head ? nullptr : current;
+    }
+
+    /// 把高度为 height 的新节点 node 链接在 prev 之后；prev 低于某层时该层的前驱取 update[i]
+    void link_after(FatNode* prev, FatNode* node, FatNode** update) {
+        if (node->height > current_level) {
+            for (int i = current_level; i < node->height; i++) update[i] = head;
+            current_level = node->height;
+        }
+        for (int i = 0; i < node->height; i++) {
+            FatNode* pred = prev != nullptr && i < prev->height ? prev : update[i];
+            node->link(i) = pred->link(i);
+            pred->link(i) = Link{node->keys[0], node};
+        }
+    }
+};
+
+template <PackedSkipListKey K, typename V>
+bool FatSkipList<K, V>::insert(K key, V value) {
+    FatNode** update = update_.data();
+    FatNode* node = find_less_than(key, update);
+
+    // 1. 键已存在：只可能在 node 内部，或者是后继节点的首键
+    if (node != head) {
+        int r = node->rank(key);
+        if (r < node->count && node->keys[r] == key) {
+            node->values[r] = std::move(value);
+            return true;
+        }
+    }
+    FatNode* next = node->link(0).node;
+    if (next && next->keys[0] == key) {
+        next->values[0] = std::move(value);
+        return true;
+    }
+
+    // 2. 空表：新建第一个节点
+    if (node == head && next == nullptr) {
+        FatNode* fresh = new_node(random_level());
+        fresh->insert_at(0, key, std::move(value));
+        link_after(nullptr, fresh, update);
+        return true;
+    }
+
+    // 3. 键小于所有键时放到第一个节点的最前面，否则放入 node
+    FatNode* target = node == head ? next : node;
+    int pos = node == head ? 0 : node->rank(key);
+
+    if (target->count == kNodeKeys) {
+        FatNode* fresh = new_node(random_level());
+        if (pos == target->count) {
+            // 追加到末尾（顺序写入）：新节点只放这个键，target 保持全满
+            fresh->insert_at(0, key, std::move(value));
+            link_after(target, fresh, update);
+            return true;
+        }
+        // 对半分裂，后一半移入新节点
+        int half = kNodeKeys / 2;
+        for (int i = half; i < kNodeKeys; ++i) {
+            fresh->keys[i - half] = target->keys[i];
+            fresh->values[i - half] = std::move(target->values[i]);
+            target->keys[i] = padding_key();
+            target->values[i] = V();
+        }
+        fresh->count = kNodeKeys - half;
+        target->count = half;
+        link_after(target, fresh, update);
+        if (pos > half) {
+            fresh->insert_at(pos - half, key, std::move(value));
+            return true;
+        }
+    }
+
+    target->insert_at(pos, key, std::move(value));
+    if (pos == 0) {
+        // 首键变小：更新各层前驱中缓存的首键（此时各层前驱都是 head）
+        for (int i = 0; i < target->height; i++) update[i]->link(i).key = key;
+    }
+    return true;
+}
+
+template <PackedSkipListKey K, typename V>
+bool FatSkipList<K, V>::remove(K key) {
+    FatNode** update = update_.data();
+    FatNode* node = find_less_than(key, update);
+
+    if (node != head) {
+        int r = node->rank(key);
+        if (r < node->count && node->keys[r] == key) {
+            // 不是首键：节点内删除即可，各层缓存的首键不变
+            node->erase_at(r);
+            return true;
+        }
+    }
+
+    // 键只可能是后继节点的首键；此时 update[i] 正是该节点在各层的前驱
+    FatNode* target = node->link(0).node;
+    if (!target || target->keys[0] != key) return false;
+
+    target->erase_at(0);
+    if (target->count > 0) {
+        for (int i = 0; i < target->height; i++) update[i]->link(i).key = target->keys[0];
+        return true;
+    }
+
+    // 节点已空：逐层断链并释放
+    for (int i = 0; i < target->height; i++) {
+        update[i]->link(i) = target->link(i);
+    }
+    delete_node(target);
+    while (current_level > 1 && head->link(current_level - 1).node == nullptr) {
+        --current_level;
+    }
+    return true;
+}
+
+/**
+ * @brief 按键类型选择跳表实现：满足 PackedSkipListKey 的键使用 FatSkipList，其余使用 SkipList
+ *
+ * 注意两者对 find 指针与迭代器有效期的保证不同（见文件说明）。
+ */
+template <typename K, typename V>
+struct SkipListFor {
+    using type = SkipList<K, V>;
+};
+
+template <PackedSkipListKey K, typename V>
+struct SkipListFor<K, V> {
+    using type = FatSkipList<K, V>;
+};
+
+template <typename K, typename V>
+using FastSkipList = typename SkipListFor<K, V>::type;
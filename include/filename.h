@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+/**
+ * @file filename.h
+ * @brief 数据目录中各类文件的命名规则
+ *
+ * data_dir/
+ * ├── wal.log          当前正在写入的 WAL 段（活跃 MemTable 对应的日志）
+ * ├── wal_000007.log   已封存的 WAL 段（写满后切换，或对应尚未落盘的 Immutable MemTable）
+ * ├── wal_000005.recycle  已落盘、留待复用的 WAL 段（切换时改名为 wal.log 覆盖写入）
+ * ├── L0_000008.sst    SSTable 文件：L<level>_<file_number>.sst
+ * ├── blob_000010.blob Blob 文件：键值分离后的大 Value（见 blob_file.h）
+ * ├── MANIFEST-000009  版本增量日志：记录每次落盘 / Compaction 后的文件集合变化
+ * ├── CURRENT          当前 MANIFEST 的文件名（原子替换）
+ * └── *.tmp            写到一半的临时文件（启动时清理）
+ *
+ * 所有编号共享同一个单调递增的 file_number 计数器，编号越大越新。
+ *
+ * ShardedKVStore 的根目录下是每个分片各自的 data_dir：
+ * root/
+ * ├── SHARDS           分片数（创建时写入，之后必须以相同的分片数打开）
+ * ├── shard_000/       分片 0 的数据目录（结构同上）
+ * └── shard_001/ ...
+ *
+ * RaftNode 的目录下是复制日志与本地状态机：
+ * node_dir/
+ * ├── raft.log         Raft 日志：快照之后的条目（每条是一个带序列号的 kBatch 日志记录）
+ * ├── RAFT_META        Term / VotedFor 与快照位置（原子替换）
+ * ├── db/              状态机（KVStore 的 data_dir）
+ * └── snapshot.tmp/    正在发送或接收的快照（启动时清理）
+ */
+
+/// 当前活跃 WAL 的文件名
+inline constexpr std::string_view kActiveWalName = "wal.log";
+
+/// 记录当前 MANIFEST 文件名的文件
+inline constexpr std::string_view kCurrentFileName = "CURRENT";
+
+/// ShardedKVStore 记录分片数的文件
+inline constexpr std::string_view kShardsFileName = "SHARDS";
+
+/// RaftNode 的日志文件
+inline constexpr std::string_view kRaftLogFileName = "raft.log";
+
+/// RaftNode 的元数据文件（Term / VotedFor / 快照位置）
+inline constexpr std::string_view kRaftMetaFileName = "RAFT_META";
+
+/// RaftNode 状态机（KVStore）的数据目录
+inline constexpr std::string_view kRaftStoreDirName = "db";
+
+/// RaftNode 生成 / 接收快照时使用的临时目录
+inline constexpr std::string_view kRaftSnapshotDirName = "snapshot.tmp";
+
+/// RaftNode 安装快照期间旧状态机目录的临时名字
+inline constexpr std::string_view kRaftOldStoreDirName = "db.old";
+
+/// RaftNode 安装快照期间存在的标记文件，记录正在安装的快照位置
+inline constexpr std::string_view kRaftInstallFileName = "SNAPSHOT_INSTALL";
+
+inline std::string shard_dir_name(size_t index) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "shard_%03zu", index);
+    return buf;
+}
+
+inline std::string manifest_file_name(uint64_t number) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "MANIFEST-%06llu", static_cast<unsigned long long>(number));
+    return buf;
+}
+
+inline std::string wal_segment_name(uint64_t number) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "wal_%06llu.log", static_cast<unsigned long long>(number));
+    return buf;
+}
+
+inline std::string recycled_wal_name(uint64_t number) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "wal_%06llu.recycle", static_cast<unsigned long long>(number));
+    return buf;
+}
+
+inline std::string table_file_name(int level, uint64_t number) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "L%d_%06llu.sst", level, static_cast<unsigned long long>(number));
+    return buf;
+}
+
+inline std::string blob_file_name(uint64_t number) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "blob_%06llu.blob", static_cast<unsigned long long>(number));
+    return buf;
+}
+
+/// 解析 wal_<number><suffix>
+inline bool parse_numbered_wal_name(std::string_view name, std::string_view suffix, uint64_t* number) {
+    constexpr std::string_view prefix = "wal_";
+    if (name.size() <= prefix.size() + suffix.size()) return false;
+    if (name.substr(0, prefix.size()) != prefix) return false;
+    if (name.substr(name.size() - suffix.size()) != suffix) return false;
+    std::string_view digits = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+    uint64_t n = 0;
+    for (char c : digits) {
+        if (c < '0' || c > '9') return false;
+        n = n * 10 + static_cast<uint64_t>(c - '0');
+    }
+    *number = n;
+    return true;
+}
+
+/**
+ * @brief 解析封存 WAL 段的文件名 wal_<number>.log
+ */
+inline bool parse_wal_segment_name(std::string_view name, uint64_t* number) {
+    return parse_numbered_wal_name(name, ".log", number);
+}
+
+/**
+ * @brief 解析待复用 WAL 段的文件名 wal_<number>.recycle
+ */
+inline bool parse_recycled_wal_name(std::string_view name, uint64_t* number) {
+    return parse_numbered_wal_name(name, ".recycle", number);
+}
+
+/**
+ * @brief 解析 SSTable 文件名 L<level>_<number>.sst
+ */
+inline bool parse_table_file_name(std::string_view name, int* level, uint64_t* number) {
+    constexpr std::string_view suffix = ".sst";
+    if (name.size() < 4 + suffix.size() || name[0] != 'L') return false;
+    if (name.substr(name.size() - suffix.size()) != suffix) return false;
+    size_t underscore = name.find('_');
+    if (underscore == std::string_view::npos || underscore == 1) return false;
+
+    int lv = 0;
+    for (char c : name.substr(1, underscore - 1)) {
+        if (c < '0' || c > '9') return false;
+        lv = lv * 10 + (c - '0');
+    }
+    std::string_view digits = name.substr(underscore + 1, name.size() - underscore - 1 - suffix.size());
+    if (digits.empty()) return false;
+    uint64_t n = 0;
+    for (char c : digits) {
+        if (c < '0' || c > '9') return false;
+        n = n * 10 + static_cast<uint64_t>(c - '0');
+    }
+    *level = lv;
+    *number = n;
+    return true;
+}
+
+/**
+ * @brief 解析 MANIFEST 文件名 MANIFEST-<number>
+ */
+inline bool parse_manifest_file_name(std::string_view name, uint64_t* number) {
+    constexpr std::string_view prefix = "MANIFEST-";
+    if (name.size() <= prefix.size() || name.substr(0, prefix.size()) != prefix) return false;
+    uint64_t n = 0;
+    for (char c : name.substr(prefix.size())) {
+        if (c < '0' || c > '9') return false;
+        n = n * 10 + static_cast<uint64_t>(c - '0');
+    }
+    *number = n;
+    return true;
+}
+
+/**
+ * @brief 解析 Blob 文件名 blob_<number>.blob
+ */
+inline bool parse_blob_file_name(std::string_view name, uint64_t* number) {
+    constexpr std::string_view prefix = "blob_";
+    constexpr std::string_view suffix = ".blob";
+    if (name.size() <= prefix.size() + suffix.size()) return false;
+    if (name.substr(0, prefix.size()) != prefix) return false;
+    if (name.substr(name.size() - suffix.size()) != suffix) return false;
+    uint64_t n = 0;
+    for (char c : name.substr(prefix.size(), name.size() - prefix.size() - suffix.size())) {
+        if (c < '0' || c > '9') return false;
+        n = n * 10 + static_cast<uint64_t>(c - '0');
+    }
+    *number = n;
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "dbformat.h"
+
+#include <string_view>
+
+/**
+ * @file iterator.h
+ * @brief 存储引擎内部的有序迭代器接口
+ */
+
+/**
+ * @brief 按内部 Key 顺序产出 (internal key, value) 的双向迭代器
+ *
+ * MemTable、单个 SSTable、L1+ 的一整层文件都以这个接口暴露给 MergingIterator。
+ * key() 是内部 Key（UserKey | Tag，见 dbformat.h），按 InternalKeyComparator 排序：
+ * 同一个 UserKey 的所有版本相邻、新版本在前；删除标记作为 kDeletion 版本照常产出，
+ * 由上层决定是遮蔽还是跳过。条目的类型与序列号用 parse_internal_key 从 key() 中解析。
+ *
+ * 约定：
+ * - key() / value() 只在 Valid() 时调用，视图在迭代器下一次移动之前有效；
+ * - Next / Prev 在 !Valid() 时什么也不做；
+ * - 读取 SSTable 失败时抛出 std::runtime_error。
+ */
+class InternalIterator {
+public:
+    virtual ~InternalIterator() = default;
+
+    virtual bool Valid() const = 0;
+
+    virtual void SeekToFirst() = 0;
+    virtual void SeekToLast() = 0;
+
+    /// 定位到第一个内部 Key >= target 的条目
+    virtual void Seek(std::string_view target) = 0;
+
+    virtual void Next() = 0;
+    virtual void Prev() = 0;
+
+    /// 条目的内部 Key
+    virtual std::string_view key() const = 0;
+    /// 条目的值（kDeletion 时为空）
+    virtual std::string_view value() const = 0;
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "kv_protocol.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#ifndef __linux__
+#error "kv_client.h requires Linux sockets"
+#endif
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @file kv_client.h
+ * @brief KVServer 的阻塞式客户端，支持流水线（协议见 kv_protocol.h）
+ */
+
+/**
+ * @brief 连接一个 KVServer 的客户端
+ *
+ * 两种用法：
+ * - **同步**：put / get / del 发送一个请求并等待其响应。
+ * - **流水线**：send_put / send_get / send_del 只把请求追加到发送缓冲区，flush() 一次性发出，
+ *   随后按发送顺序调用 read_response() 读取同样数量的响应。
+ *
+ * @note 本类非线程安全，每个线程使用自己的连接。
+ */
+class KVClient {
+public:
+    /**
+     * @brief 连接到 host:port（IPv4 地址）
+     *
+     * @throw std::runtime_error 地址无效或连接失败
+     */
+    KVClient(const std::string& host, uint16_t port) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+            throw std::runtime_error("Invalid server address: " + host);
+        }
+        fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd_ < 0) throw_errno("Failed to create socket");
+        if (::connect(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            int saved = errno;
+            ::close(fd_);
+            fd_ = -1;
+            errno = saved;
+            throw_errno("Failed to connect to " + host + ":" + std::to_string(port));
+        }
+        int on = 1;
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+
+    ~KVClient() {
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    KVClient(const KVClient&) = delete;
+    KVClient& operator=(const KVClient&) = delete;
+
+    // ---- 流水线接口 ----
+
+    void send_get(std::string_view key) { queue(RequestOp::kGet, key, {}); }
+    void send_put(std::string_view key, std::string_view value) { queue(RequestOp::kPut, key, value); }
+    void send_del(std::string_view key) { queue(RequestOp::kDelete, key, {}); }
+
+    /// 已发送（或已缓冲）但尚未读取响应的请求数
+    size_t pending() const { return pending_; }
+
+    /**
+     * @brief 发出所有缓冲的请求
+     *
+     * @throw std::runtime_error 连接断开
+     */
+    void flush() {
+        size_t sent = 0;
+        while (sent < output_.size()) {
+            ssize_t n = ::send(fd_, output_.data() + sent, output_.size() - sent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw_errno("Failed to send request");
+            }
+            sent += static_cast<size_t>(n);
+        }
+        output_.clear();
+    }
+
+    /**
+     * @brief 读取下一个响应（必要时先 flush()）
+     *
+     * @param value [out] 可选；kOk 时为 Get 的结果，kError 时为错误信息
+     * @return 响应状态
+     * @throw std::runtime_error 没有待读取的响应、连接断开或响应格式错误
+     */
+    ResponseStatus read_response(std::string* value = nullptr) {
+        if (pending_ == 0) throw std::runtime_error("No pending request");
+        if (!output_.empty()) flush();
+        for (;;) {
+            std::string_view input(input_);
+            input.remove_prefix(input_offset_);
+            ResponseView response;
+            FrameStatus status = parse_response(input, &response);
+            if (status == FrameStatus::kInvalid) throw std::runtime_error("Invalid response frame");
+            if (status == FrameStatus::kOk) {
+                if (value) value->assign(response.value.data(), response.value.size());
+                input_offset_ = input_.size() - input.size();
+                if (input_offset_ == input_.size()) {
+                    input_.clear();
+                    input_offset_ = 0;
+                }
+                --pending_;
+                return response.status;
+            }
+            receive();
+        }
+    }
+
+    // ---- 同步接口 ----
+
+    /// @throw std::runtime_error 服务端返回 kError 或连接断开
+    void put(std::string_view key, std::string_view value) {
+        send_put(key, value);
+        expect_ok();
+    }
+
+    /// @throw std::runtime_error 服务端返回 kError 或连接断开
+    void del(std::string_view key) {
+        send_del(key);
+        expect_ok();
+    }
+
+    /**
+     * @return 值，Key 不存在时返回 std::nullopt
+     * @throw std::runtime_error 服务端返回 kError 或连接断开
+     */
+    std::optional<std::string> get(std::string_view key) {
+        send_get(key);
+        std::string value;
+        ResponseStatus status = read_response(&value);
+        if (status == ResponseStatus::kNotFound) return std::nullopt;
+        if (status == ResponseStatus::kError) throw std::runtime_error("Server error: " + value);
+        return value;
+    }
+
+private:
+    static constexpr size_t kReadChunk = 64 * 1024;
+
+    int fd_ = -1;
+    std::string output_;
+    std::string input_;
+    size_t input_offset_ = 0;
+    size_t pending_ = 0;
+
+    [[noreturn]] static void throw_errno(const std::string& what) {
+        throw std::runtime_error(what + " (" + std::strerror(errno) + ")");
+    }
+
+    void queue(RequestOp op, std::string_view key, std::string_view value) {
+        append_request(output_, op, key, value);
+        ++pending_;
+    }
+
+    void expect_ok() {
+        std::string message;
+        if (read_response(&message) != ResponseStatus::kOk) throw std::runtime_error("Server error: " + message);
+    }
+
+    void receive() {
+        if (input_offset_ > 0) {
+            input_.erase(0, input_offset_);
+            input_offset_ = 0;
+        }
+        size_t old_size = input_.size();
+        input_.resize(old_size + kReadChunk);
+        ssize_t n;
+        do {
+            n = ::recv(fd_, input_.data() + old_size, kReadChunk, 0);
+        } while (n < 0 && errno == EINTR);
+        input_.resize(old_size + (n > 0 ? static_cast<size_t>(n) : 0));
+        if (n == 0) throw std::runtime_error("Connection closed by server");
+        if (n < 0) throw_errno("Failed to receive response");
+    }
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "coding.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @file kv_protocol.h
+ * @brief KVServer 与 KVClient 之间的二进制协议
+ *
+ * 每个请求 / 响应是一个帧（Frame），长度字段按主机字节序（小端）编码，与 WAL / SSTable 一致：
+ * +------------+------------------------------------------------+
+ * | Length(4B) | Body (Length 字节)                              |
+ * +------------+------------------------------------------------+
+ *
+ * 请求 Body：
+ * +--------+-----------------+-----+---------------------------+
+ * | Op(1B) | KeyLen(varint32)| Key | Value（Body 的剩余部分）    |
+ * +--------+-----------------+-----+---------------------------+
+ *
+ * 响应 Body：
+ * +------------+--------------------------------------------------+
+ * | Status(1B) | Value（kGet 命中时）或错误信息（kError 时）         |
+ * +------------+--------------------------------------------------+
+ *
+ * 协议是流水线式的（Pipelining）：客户端可以连续发送多个请求而不等待响应，
+ * 服务端按请求顺序返回响应，因此帧中不需要请求编号。
+ *
+ * kRaftMessage 是副本之间的 Raft 消息（Key 为空，Value 为 encode_raft_message 的结果，
+ * 见 raft_socket_transport.h），单向发送，服务端不返回响应。
+ */
+
+/// 请求类型
+enum class RequestOp : uint8_t {
+    kGet = 1,
+    kPut = 2,
+    kDelete = 3,
+    kRaftMessage = 4,  ///< 副本之间的 Raft 消息（无响应）
+};
+
+/// 响应状态
+enum class ResponseStatus : uint8_t {
+    kOk = 0,        ///< 成功（kGet 时 Value 为查询结果）
+    kNotFound = 1,  ///< kGet 的 Key 不存在
+    kError = 2,     ///< 请求失败，Value 为错误信息
+};
+
+/// 帧长度字段的字节数
+inline constexpr size_t kFrameHeaderSize = 4;
+
+/// 默认允许的最大帧 Body（超过视为协议错误，避免为损坏的长度字段分配巨大缓冲区）
+inline constexpr size_t kDefaultMaxFrameSize = 64u << 20;
+
+/// 解析出的请求（key / value 指向输入缓冲区）
+struct RequestView {
+    RequestOp op = RequestOp::kGet;
+    std::string_view key;
+    std::string_view value;
+};
+
+/// 解析出的响应（value 指向输入缓冲区）
+struct ResponseView {
+    ResponseStatus status = ResponseStatus::kOk;
+    std::string_view value;
+};
+
+/// 帧解析结果
+enum class FrameStatus {
+    kOk,          ///< 解析出一个完整的帧
+    kIncomplete,  ///< 数据不足一个帧，等待更多数据
+    kInvalid,     ///< 帧格式错误或超过大小上限（连接应被关闭）
+};
+
+/**
+ * @brief 追加一个请求帧
+ *
+ * @param out 输出缓冲区（可连续追加多个帧）
+ * @param op 请求类型
+ * @param key 键
+ * @param value 值（仅 kPut 使用）
+ */
+inline void append_request(std::string& out, RequestOp op, std::string_view key, std::string_view value = {}) {
+    uint32_t body = static_cast<uint32_t>(1 + varint32_length(static_cast<uint32_t>(key.size())) + key.size() +
+                                          value.size());
+    put_fixed32(out, body);
+    out.push_back(static_cast<char>(op));
+    put_varint32(out, static_cast<uint32_t>(key.size()));
+    out.append(key.data(), key.size());
+    out.append(value.data(), value.size());
+}
+
+/**
+ * @brief 追加响应帧的头部（长度与状态），value_size 字节的 Value 由调用者随后追加或另行发送
+ */
+inline void append_response_header(std::string& out, ResponseStatus status, size_t value_size) {
+    put_fixed32(out, static_cast<uint32_t>(1 + value_size));
+    out.push_back(static_cast<char>(status));
+}
+
+/// 追加一个完整的响应帧
+inline void append_response(std::string& out, ResponseStatus status, std::string_view value = {}) {
+    append_response_header(out, status, value.size());
+    out.append(value.data(), value.size());
+}
+
+/**
+ * @brief 从 input 开头切出一个帧的 Body
+ *
+ * @param input 输入；成功时去掉已解析的帧
+ * @param body [out] 帧的 Body
+ * @param max_frame_size Body 的大小上限
+ */
+inline FrameStatus next_frame(std::string_view& input, std::string_view* body,
+                              size_t max_frame_size = kDefaultMaxFrameSize) {
+    if (input.size() < kFrameHeaderSize) return FrameStatus::kIncomplete;
+    uint32_t length = decode_fixed32(input.data());
+    if (length == 0 || length > max_frame_size) return FrameStatus::kInvalid;
+    if (input.size() - kFrameHeaderSize < length) return FrameStatus::kIncomplete;
+    *body = input.substr(kFrameHeaderSize, length);
+    input.remove_prefix(kFrameHeaderSize + length);
+    return FrameStatus::kOk;
+}
+
+/**
+ * @brief 从 input 开头解析一个请求
+ *
+ * @param input 输入；成功时去掉已解析的帧
+ * @param request [out] 请求（视图指向 input 的底层缓冲区）
+ * @param max_frame_size Body 的大小上限
+ */
+inline FrameStatus parse_request(std::string_view& input, RequestView* request,
+                                 size_t max_frame_size = kDefaultMaxFrameSize) {
+    std::string_view rest = input;
+    std::string_view body;
+    FrameStatus status = next_frame(rest, &body, max_frame_size);
+    if (status != FrameStatus::kOk) return status;
+
+    uint8_t op = static_cast<uint8_t>(body[0]);
+    if (op < static_cast<uint8_t>(RequestOp::kGet) || op > static_cast<uint8_t>(RequestOp::kRaftMessage)) {
+        return FrameStatus::kInvalid;
+    }
+    const char* limit = body.data() + body.size();
+    uint32_t key_size = 0;
+    const char* p = get_varint32_ptr(body.data() + 1, limit, &key_size);
+    if (p == nullptr || static_cast<size_t>(limit - p) < key_size) return FrameStatus::kInvalid;
+
+    request->op = static_cast<RequestOp>(op);
+    request->key = std::string_view(p, key_size);
+    request->value = std::string_view(p + key_size, static_cast<size_t>(limit - p) - key_size);
+    input = rest;
+    return FrameStatus::kOk;
+}
+
+/**
+ * @brief 从 input 开头解析一个响应
+ *
+ * @param input 输入；成功时去掉已解析的帧
+ * @param response [out] 响应（视图指向 input 的底层缓冲区）
+ * @param max_frame_size Body 的大小上限
+ */
+inline FrameStatus parse_response(std::string_view& input, ResponseView* response,
+                                  size_t max_frame_size = kDefaultMaxFrameSize) {
+    std::string_view rest = input;
+    std::string_view body;
+    FrameStatus status = next_frame(rest, &body, max_frame_size);
+    if (status != FrameStatus::kOk) return status;
+
+    uint8_t code = static_cast<uint8_t>(body[0]);
+    if (code > static_cast<uint8_t>(ResponseStatus::kError)) return FrameStatus::kInvalid;
+    response->status = static_cast<ResponseStatus>(code);
+    response->value = body.substr(1);
+    input = rest;
+    return FrameStatus::kOk;
+}
@@ -0,0 +1,618 @@
+#pragma once
+
+#include "kv_protocol.h"
+#include "kv_store.h"
+#include "pinnable_value.h"
+#include "write_batch.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef __linux__
+#error "kv_server.h requires Linux (epoll)"
+#endif
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/**
+ * @file kv_server.h
+ * @brief KVStore 的网络服务端：多 Reactor 线程的 epoll 事件循环，协议见 kv_protocol.h
+ */
+
+/**
+ * @brief KVServer 的选项
+ */
+struct ServerOptions {
+    std::string host = "0.0.0.0";     ///< 监听的 IPv4 地址
+    uint16_t port = 0;                ///< 监听端口，0 表示由系统分配（见 KVServer::port()）
+    size_t reactor_threads = 4;       ///< Reactor 线程数（每个线程一个 epoll 实例与一个监听 Socket）
+    size_t max_frame_size = kDefaultMaxFrameSize; ///< 单个请求 Body 的大小上限，超过即关闭连接
+
+    /**
+     * @brief 一个 Reactor 攒批的写入达到多少字节时提前提交
+     *
+     * 同一轮 epoll_wait 中所有连接流水线发来的 Put / Delete 合并成一个 WriteBatch，
+     * 作为一条 WAL 记录提交；多个 Reactor 的批次再由 KVStore 的组提交合并成一次 Sync。
+     */
+    size_t max_batch_bytes = 1u << 20;
+
+    /**
+     * @brief 不小于该大小的 Get 结果直接从钉住的 MemTable / Block 内存发送（零拷贝），
+     *        更小的值拷贝进输出缓冲区（避免为小值持有引用）
+     */
+    size_t zero_copy_threshold = 1024;
+
+    int backlog = 1024;               ///< listen() 的等待队列长度
+};
+
+/**
+ * @brief 服务端统计（所有 Reactor 累加）
+ */
+struct ServerStats {
+    uint64_t connections = 0;    ///< 累计接受的连接数
+    uint64_t requests = 0;       ///< 累计处理的请求数
+    uint64_t write_batches = 0;  ///< 提交给 KVStore::write 的批次数
+    uint64_t batched_writes = 0; ///< 这些批次中包含的 Put / Delete 总数
+    uint64_t zero_copy_values = 0; ///< 以零拷贝方式发送的 Get 结果数
+    uint64_t bytes_read = 0;     ///< 从 Socket 读取的字节数
+    uint64_t bytes_written = 0;  ///< 写入 Socket 的字节数
+
+    /// 平均每个批次包含的写入数
+    double avg_batch_size() const {
+        return write_batches == 0 ? 0.0 : static_cast<double>(batched_writes) / static_cast<double>(write_batches);
+    }
+};
+
+/**
+ * @brief KVServer 背后的存储
+ *
+ * 单机部署为本地 KVStore（StoreService）；副本组部署为 RaftNode（RaftService，见 raft_socket_transport.h）。
+ * 方法在 Reactor 线程上调用，可以阻塞（例如等待 fsync 或多数派确认），期间该 Reactor 的其他连接随之等待。
+ */
+class KVService {
+public:
+    virtual ~KVService() = default;
+
+    /**
+     * @return false 表示 Key 不存在
+     * @throw std::runtime_error 读取失败（错误信息作为 kError 响应返回给客户端）
+     */
+    virtual bool get(std::string_view key, PinnableValue* value) = 0;
+
+    /// @throw std::runtime_error 写入失败（批次中每个写入的响应改为 kError）
+    virtual void write(const WriteBatch& batch) = 0;
+};
+
+/**
+ * @brief 以本地 KVStore 为存储（Get 结果钉住 MemTable / Block，可零拷贝发送）
+ */
+class StoreService : public KVService {
+public:
+    explicit StoreService(KVStore& store) : store_(store) {}
+
+    bool get(std::string_view key, PinnableValue* value) override { return store_.get(key, value); }
+    void write(const WriteBatch& batch) override { store_.write(batch); }
+
+private:
+    KVStore& store_;
+};
+
+/// KVServer 收到 kRaftMessage 帧时的回调（参数为帧的 Value，在 Reactor 线程上调用，不得阻塞）
+using RaftFrameHandler = std::function<void(std::string_view)>;
+
+/**
+ * @brief KVStore 的网络服务端
+ *
+ * 架构：
+ * 1. **多 Reactor**：每个 Reactor 线程拥有独立的 epoll 实例，以及一个绑定同一端口的
+ *    SO_REUSEPORT 监听 Socket，由内核在线程间分配新连接；连接此后只由该线程处理，无需加锁。
+ * 2. **流水线与攒批**：边沿触发（EPOLLET）下一次读尽 Socket，解析出缓冲区中所有完整的请求。
+ *    Put / Delete 先追加到 Reactor 的 WriteBatch，本轮事件处理完后作为一条 WAL 记录一次提交，
+ *    之后才发送这些写入的响应；遇到 Get 时先提交已攒的批次，保证同一连接读到自己之前的写入。
+ * 3. **零拷贝响应**：Get 通过 PinnableValue 直接指向 MemTable 的 Arena 或块缓存中的 Block，
+ *    大值以 sendmsg 的 iovec 引用这段内存发送，发送完成后才释放钉住的引用。
+ *
+ * 批次提交失败（例如磁盘写满，KVStore 进入 Fail-Stop）时，其中每个写入的响应改为带错误信息的 kError。
+ *
+ * 设置了 RaftFrameHandler 时，kRaftMessage 帧交给它处理且不返回响应；未设置时视为协议错误。
+ *
+ * @note start() / stop() / stats() 之间不能并发调用；KVServer 不拥有 KVStore / KVService，
+ *       它们必须比服务端存活更久。
+ */
+class KVServer {
+public:
+    KVServer(KVStore& store, const ServerOptions& options = ServerOptions())
+        : owned_service_(std::make_unique<StoreService>(store)), service_(*owned_service_), options_(options) {
+        if (options_.reactor_threads == 0) options_.reactor_threads = 1;
+    }
+
+    KVServer(KVService& service, const ServerOptions& options = ServerOptions())
+        : service_(service), options_(options) {
+        if (options_.reactor_threads == 0) options_.reactor_threads = 1;
+    }
+
+    ~KVServer() { stop(); }
+
+    KVServer(const KVServer&) = delete;
+    KVServer& operator=(const KVServer&) = delete;
+
+    /**
+     * @brief 绑定端口并启动所有 Reactor 线程
+     *
+     * @throw std::runtime_error 地址无效、端口被占用或 epoll 创建失败
+     */
+    void start() {
+        if (!reactors_.empty()) return;
+        uint16_t port = options_.port;
+        try {
+            for (size_t i = 0; i < options_.reactor_threads; ++i) {
+                reactors_.push_back(std::make_unique<Reactor>(*this, port));
+                port = reactors_.front()->port();  // 端口为 0 时其余 Reactor 绑定第一个分配到的端口
+            }
+        } catch (...) {
+            reactors_.clear();
+            throw;
+        }
+        port_ = port;
+        for (auto& reactor : reactors_) reactor->start();
+    }
+
+    /// 停止所有 Reactor 并关闭全部连接（本轮已攒的写入会先提交）；可重复调用
+    void stop() {
+        for (auto& reactor : reactors_) reactor->stop();
+        reactors_.clear();
+    }
+
+    /// 设置 kRaftMessage 帧的处理回调（在 start() 之前调用）
+    void set_raft_handler(RaftFrameHandler handler) { raft_handler_ = std::move(handler); }
+
+    /// 实际监听的端口（start() 之后有效）
+    uint16_t port() const { return port_; }
+
+    /// 所有 Reactor 的统计之和
+    ServerStats stats() const {
+        ServerStats total;
+        for (const auto& reactor : reactors_) reactor->add_stats(&total);
+        return total;
+    }
+
+private:
+    /// 一段待发送的输出：先发送 bytes，再发送 pinned 指向的值
+    struct OutputSegment {
+        std::string bytes;
+        PinnableValue pinned;
+    };
+
+    struct Connection {
+        int fd = -1;
+        std::string input;            ///< 已读取、尚未解析的数据从 input_offset 开始
+        size_t input_offset = 0;
+        std::deque<OutputSegment> output;
+        size_t output_offset = 0;     ///< output.front() 中已发送的字节数
+        bool peer_closed = false;     ///< 对端已关闭写方向：发送完剩余响应后关闭
+        bool broken = false;          ///< 协议错误或 Socket 错误：立即关闭
+
+        /// 追加到最后一段的 bytes（最后一段已带有 pinned 值时新开一段，保持顺序）
+        std::string& output_bytes() {
+            if (output.empty() || !output.back().pinned.empty()) output.emplace_back();
+            return output.back().bytes;
+        }
+    };
+
+    /// 批次中一个写入的响应位置（提交失败时改写为 kError）
+    struct PendingWrite {
+        Connection* connection;
+        size_t segment;
+        size_t offset;
+    };
+
+    /**
+     * @brief 一个事件循环线程及其管理的连接
+     */
+    class Reactor {
+    public:
+        Reactor(KVServer& server, uint16_t port) : server_(server) {
+            epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+            event_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (epoll_fd_ < 0 || event_fd_ < 0) {
+                close_fds();
+                throw_errno("Failed to create epoll instance");
+            }
+            listen_fd_ = open_listener(port);
+            add_fd(event_fd_, EPOLLIN);
+            add_fd(listen_fd_, EPOLLIN);
+        }
+
+        ~Reactor() {
+            stop();
+            for (auto& [fd, connection] : connections_) ::close(fd);
+            close_fds();
+        }
+
+        Reactor(const Reactor&) = delete;
+        Reactor& operator=(const Reactor&) = delete;
+
+        uint16_t port() const { return port_; }
+
+        void start() {
+            thread_ = std::thread([this] {
+                try {
+                    run();
+                } catch (const std::exception& e) {
+                    std::cerr << "[KVServer] Reactor stopped: " << e.what() << std::endl;
+                }
+            });
+        }
+
+        void stop() {
+            if (!thread_.joinable()) return;
+            uint64_t one = 1;
+            [[maybe_unused]] ssize_t n = ::write(event_fd_, &one, sizeof(one));
+            thread_.join();
+        }
+
+        void add_stats(ServerStats* total) const {
+            total->connections += connections_accepted_.load(std::memory_order_relaxed);
+            total->requests += requests_.load(std::memory_order_relaxed);
+            total->write_batches += write_batches_.load(std::memory_order_relaxed);
+            total->batched_writes += batched_writes_.load(std::memory_order_relaxed);
+            total->zero_copy_values += zero_copy_values_.load(std::memory_order_relaxed);
+            total->bytes_read += bytes_read_.load(std::memory_order_relaxed);
+            total->bytes_written += bytes_written_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr int kMaxEvents = 256;
+        static constexpr size_t kReadChunk = 256 * 1024;
+        static constexpr int kMaxIov = 64;
+
+        KVServer& server_;
+        int epoll_fd_ = -1;
+        int event_fd_ = -1;
+        int listen_fd_ = -1;
+        uint16_t port_ = 0;
+        std::thread thread_;
+
+        std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+        std::vector<Connection*> active_;       ///< 本轮有事件的连接
+        WriteBatch batch_;                      ///< 本轮攒下、尚未提交的写入
+        std::vector<PendingWrite> pending_;     ///< batch_ 中每个写入的响应位置
+        std::unique_ptr<char[]> read_buffer_ = std::make_unique<char[]>(kReadChunk);
+
+        std::atomic<uint64_t> connections_accepted_{0};
+        std::atomic<uint64_t> requests_{0};
+        std::atomic<uint64_t> write_batches_{0};
+        std::atomic<uint64_t> batched_writes_{0};
+        std::atomic<uint64_t> zero_copy_values_{0};
+        std::atomic<uint64_t> bytes_read_{0};
+        std::atomic<uint64_t> bytes_written_{0};
+
+        [[noreturn]] static void throw_errno(const std::string& what) {
+            throw std::runtime_error(what + " (" + std::strerror(errno) + ")");
+        }
+
+        /// 只有 Reactor 线程修改计数器，读者使用 relaxed 读取
+        static void bump(std::atomic<uint64_t>& counter, uint64_t n) {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        void close_fds() {
+            for (int* fd : {&listen_fd_, &event_fd_, &epoll_fd_}) {
+                if (*fd >= 0) ::close(*fd);
+                *fd = -1;
+            }
+        }
+
+        void add_fd(int fd, uint32_t events) {
+            epoll_event ev{};
+            ev.events = events;
+            ev.data.fd = fd;
+            if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                int saved = errno;
+                close_fds();
+                errno = saved;
+                throw_errno("epoll_ctl failed");
+            }
+        }
+
+        int open_listener(uint16_t port) {
+            const ServerOptions& options = server_.options_;
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            if (::inet_pton(AF_INET, options.host.c_str(), &addr.sin_addr) != 1) {
+                close_fds();
+                throw std::runtime_error("Invalid listen address: " + options.host);
+            }
+
+            int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                close_fds();
+                throw_errno("Failed to create socket");
+            }
+            int on = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+            if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+                ::listen(fd, options.backlog) != 0) {
+                int saved = errno;
+                ::close(fd);
+                close_fds();
+                errno = saved;
+                throw_errno("Failed to listen on " + options.host + ":" + std::to_string(port));
+            }
+            socklen_t len = sizeof(addr);
+            ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+            port_ = ntohs(addr.sin_port);
+            return fd;
+        }
+
+        void run() {
+            epoll_event events[kMaxEvents];
+            for (;;) {
+                int n = ::epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    throw_errno("epoll_wait failed");
+                }
+                bool stopping = false;
+                active_.clear();
+                for (int i = 0; i < n; ++i) {
+                    int fd = events[i].data.fd;
+                    if (fd == event_fd_) {
+                        stopping = true;
+                    } else if (fd == listen_fd_) {
+                        accept_connections();
+                    } else {
+                        auto it = connections_.find(fd);
+                        if (it == connections_.end()) continue;
+                        Connection* c = it->second.get();
+                        if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                            read_input(c);
+                            process_requests(c);
+                        }
+                        active_.push_back(c);
+                    }
+                }
+
+                // 先提交本轮攒下的写入，再发送响应：客户端收到 kOk 时写入已经持久化
+                commit_batch();
+                for (Connection* c : active_) {
+                    if (!c->broken) send_output(c);
+                    if (c->broken || (c->peer_closed && c->output.empty())) close_connection(c);
+                }
+                if (stopping) return;
+            }
+        }
+
+        void accept_connections() {
+            for (;;) {
+                int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                        std::cerr << "[KVServer] accept failed: " << std::strerror(errno) << std::endl;
+                    }
+                    return;
+                }
+                int on = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                epoll_event ev{};
+                ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+                ev.data.fd = fd;
+                if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                    ::close(fd);
+                    continue;
+                }
+                auto connection = std::make_unique<Connection>();
+                connection->fd = fd;
+                connections_.emplace(fd, std::move(connection));
+                bump(connections_accepted_, 1);
+            }
+        }
+
+        void close_connection(Connection* c) {
+            ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, c->fd, nullptr);
+            ::close(c->fd);
+            connections_.erase(c->fd);
+        }
+
+        /// 边沿触发：读到 EAGAIN 为止
+        void read_input(Connection* c) {
+            for (;;) {
+                ssize_t n = ::recv(c->fd, read_buffer_.get(), kReadChunk, 0);
+                if (n > 0) {
+                    c->input.append(read_buffer_.get(), static_cast<size_t>(n));
+                    bump(bytes_read_, static_cast<uint64_t>(n));
+                    continue;
+                }
+                if (n == 0) {
+                    c->peer_closed = true;
+                } else if (errno == EINTR) {
+                    continue;
+                } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    c->broken = true;
+                }
+                return;
+            }
+        }
+
+        /// 解析并执行缓冲区中所有完整的请求，未完整的尾部留到下次
+        void process_requests(Connection* c) {
+            std::string_view input(c->input);
+            input.remove_prefix(c->input_offset);
+            uint64_t requests = 0;
+            while (!c->broken) {
+                RequestView request;
+                FrameStatus status = parse_request(input, &request, server_.options_.max_frame_size);
+                if (status == FrameStatus::kIncomplete) break;
+                if (status == FrameStatus::kInvalid) {
+                    std::cerr << "[KVServer] Invalid request frame, closing connection" << std::endl;
+                    c->broken = true;
+                    break;
+                }
+                ++requests;
+                switch (request.op) {
+                    case RequestOp::kGet:
+                        commit_batch();
+                        handle_get(c, request.key);
+                        break;
+                    case RequestOp::kPut:
+                        batch_.put(request.key, request.value);
+                        queue_write_response(c);
+                        break;
+                    case RequestOp::kDelete:
+                        batch_.del(request.key);
+                        queue_write_response(c);
+                        break;
+                    case RequestOp::kRaftMessage:
+                        if (!server_.raft_handler_) {
+                            std::cerr << "[KVServer] Raft message on a server without a Raft node, "
+                                         "closing connection" << std::endl;
+                            c->broken = true;
+                            break;
+                        }
+                        server_.raft_handler_(request.value);
+                        break;
+                }
+                if (batch_.rep().size() >= server_.options_.max_batch_bytes) commit_batch();
+            }
+            bump(requests_, requests);
+
+            c->input_offset = c->input.size() - input.size();
+            if (c->input_offset == c->input.size()) {
+                c->input.clear();
+                c->input_offset = 0;
+            } else if (c->input_offset > c->input.size() / 2) {
+                c->input.erase(0, c->input_offset);
+                c->input_offset = 0;
+            }
+        }
+
+        void queue_write_response(Connection* c) {
+            std::string& out = c->output_bytes();
+            pending_.push_back(PendingWrite{c, c->output.size() - 1, out.size() + kFrameHeaderSize});
+            append_response(out, ResponseStatus::kOk);
+        }
+
+        void handle_get(Connection* c, std::string_view key) {
+            PinnableValue value;
+            bool found = false;
+            try {
+                found = server_.service_.get(key, &value);
+            } catch (const std::exception& e) {
+                append_response(c->output_bytes(), ResponseStatus::kError, e.what());
+                return;
+            }
+            if (!found) {
+                append_response(c->output_bytes(), ResponseStatus::kNotFound);
+                return;
+            }
+            std::string& out = c->output_bytes();
+            append_response_header(out, ResponseStatus::kOk, value.size());
+            if (value.pinned() && value.size() >= server_.options_.zero_copy_threshold) {
+                c->output.back().pinned = std::move(value);
+                bump(zero_copy_values_, 1);
+            } else {
+                out.append(value.data(), value.size());
+            }
+        }
+
+        /// 把 batch_ 作为一次 KVStore::write 提交；失败时对应的响应改为 kError
+        void commit_batch() {
+            if (batch_.empty()) return;
+            try {
+                server_.service_.write(batch_);
+            } catch (const std::exception& e) {
+                std::cerr << "[KVServer] Write batch failed: " << e.what() << std::endl;
+                // 从后往前插入错误信息：同一段中较早的响应位置不受影响
+                std::string_view error(e.what());
+                for (auto it = pending_.rbegin(); it != pending_.rend(); ++it) {
+                    std::string& bytes = it->connection->output[it->segment].bytes;
+                    bytes[it->offset] = static_cast<char>(ResponseStatus::kError);
+                    bytes.insert(it->offset + 1, error);
+                    encode_fixed32(&bytes[it->offset - kFrameHeaderSize], static_cast<uint32_t>(1 + error.size()));
+                }
+            }
+            bump(write_batches_, 1);
+            bump(batched_writes_, pending_.size());
+            batch_.clear();
+            pending_.clear();
+        }
+
+        /// 用 sendmsg 把输出段（含零拷贝的值）聚集发送，直到发完或 Socket 缓冲区写满
+        void send_output(Connection* c) {
+            while (!c->output.empty()) {
+                iovec iov[kMaxIov];
+                int count = 0;
+                size_t skip = c->output_offset;
+                for (const OutputSegment& segment : c->output) {
+                    for (std::string_view part : {std::string_view(segment.bytes), segment.pinned.view()}) {
+                        if (skip >= part.size()) {
+                            skip -= part.size();
+                            continue;
+                        }
+                        iov[count].iov_base = const_cast<char*>(part.data() + skip);
+                        iov[count].iov_len = part.size() - skip;
+                        skip = 0;
+                        ++count;
+                        if (count == kMaxIov) break;
+                    }
+                    if (count == kMaxIov) break;
+                }
+                if (count == 0) {
+                    c->output.clear();
+                    c->output_offset = 0;
+                    return;
+                }
+
+                msghdr msg{};
+                msg.msg_iov = iov;
+                msg.msg_iovlen = static_cast<size_t>(count);
+                ssize_t n = ::sendmsg(c->fd, &msg, MSG_NOSIGNAL);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) c->broken = true;
+                    return;  // 等待 EPOLLOUT
+                }
+                bump(bytes_written_, static_cast<uint64_t>(n));
+
+                c->output_offset += static_cast<size_t>(n);
+                while (!c->output.empty()) {
+                    size_t size = c->output.front().bytes.size() + c->output.front().pinned.size();
+                    if (c->output_offset < size) break;
+                    c->output_offset -= size;
+                    c->output.pop_front();
+                }
+            }
+            c->output_offset = 0;
+        }
+    };
+
+    std::unique_ptr<KVService> owned_service_;  ///< 以 KVStore 构造时持有的 StoreService
+    KVService& service_;
+    ServerOptions options_;
+    RaftFrameHandler raft_handler_;
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    uint16_t port_ = 0;
+};
@@ -1,31 +1,183 @@
 #pragma once
 #define _CRT_SECURE_NO_WARNINGS // 禁用 fopen 等不安全警告
 
-#include "skiplist.h"
+#include "blob_file.h"
+#include "block_cache.h"
+#include "coding.h"
+#include "cpu_affinity.h"
+#include "db_iterator.h"
+#include "dbformat.h"
+#include "filename.h"
+#include "memtable.h"
+#include "options.h"
+#include "pinnable_value.h"
+#include "rate_limiter.h"
+#include "replay_worker.h"
+#include "snapshot.h"
+#include "statistics.h"
+#include "sstable_builder.h"
+#include "sstable_reader.h"
+#include "version_edit.h"
+#include "version_set.h"
+#include "wal_reader.h"
 #include "wal_record.h"
+#include "wal_writer.h"
+#include "write_batch.h"
+#include "write_controller.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdio>
+#include <deque>
+#include <exception>
 #include <filesystem>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <set>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
-// 平台兼容性处理：为了调用底层的 Sync API
-// Windows 使用 _commit, Linux/Unix 使用 fsync
-#ifdef _WIN32
-#include <io.h>
-#else
-#include <unistd.h>
-#endif
+/**
+ * @brief WAL 写入统计信息（用于观察组提交的攒批效果）
+ */
+struct WalStats {
+  uint64_t records = 0;        ///< 写入 WAL 的日志记录总数
+  uint64_t bytes = 0;          ///< 写入 WAL 的字节总数
+  uint64_t write_groups = 0;   ///< Leader 执行的批量写入次数（每次对应一次 WAL 写入）
+  uint64_t syncs = 0;          ///< fdatasync / _commit 的调用次数
+  uint64_t max_group_size = 0; ///< 单个批次中包含的最大记录数
+  uint64_t segments = 0;       ///< 切换到新 WAL 段的次数（段写满或冻结 MemTable）
+  uint64_t recycled_segments = 0; ///< 其中复用已落盘旧段的次数
+
+  /// 平均每个批次包含多少条记录（组提交的攒批效果）
+  double avg_group_size() const {
+    return write_groups == 0 ? 0.0
+                             : static_cast<double>(records) / static_cast<double>(write_groups);
+  }
+};
+
+/**
+ * @brief 启动时的恢复统计（用于追踪重启耗时）
+ */
+struct RecoveryStats {
+  uint64_t bytes = 0;                   ///< 成功重放的 WAL 字节数
+  uint64_t records = 0;                 ///< 成功重放的记录数（一个批次计为一条）
+  std::chrono::nanoseconds elapsed{0};  ///< WAL 重放耗时（并行重放时含等待重放线程完成）
+  uint64_t manifest_edits = 0;          ///< 从 MANIFEST 重放的 VersionEdit 数量
+  uint64_t tables = 0;                  ///< 恢复出的 SSTable 数量
+  uint64_t tables_opened = 0;           ///< 启动阶段在后台打开了读取器的 SSTable 数量（recovery_threads > 1）
+  uint64_t flushed_tables = 0;          ///< 恢复的数据直接写成的 L0 SSTable 数量（flush_recovered_memtables）
+  std::chrono::nanoseconds manifest_elapsed{0}; ///< 恢复文件集合（含写入新 MANIFEST）的耗时
+
+  double mb_per_sec() const {
+    if (elapsed.count() <= 0) return 0.0;
+    return (static_cast<double>(bytes) / (1024.0 * 1024.0)) /
+           (static_cast<double>(elapsed.count()) / 1e9);
+  }
+
+  double records_per_sec() const {
+    if (elapsed.count() <= 0) return 0.0;
+    return static_cast<double>(records) * 1e9 / static_cast<double>(elapsed.count());
+  }
+};
+
+/**
+ * @brief MemTable 落盘统计
+ */
+struct FlushStats {
+  uint64_t flushes = 0;        ///< 完成的落盘次数（每次生成一个 L0 SSTable）
+  uint64_t entries = 0;        ///< 写入 SSTable 的条目总数（含删除标记）
+  uint64_t bytes_written = 0;  ///< 写入 SSTable 的字节总数
+  uint64_t blob_bytes_written = 0; ///< 写入 Blob 文件的字节总数（min_blob_size > 0 时）
+  uint64_t write_stalls = 0;   ///< 因达到硬限制（Immutable MemTable / L0 / 待 Compaction 字节）而阻塞写入的次数
+  std::chrono::nanoseconds write_stall_time{0}; ///< 阻塞写入的总时长
+  uint64_t delayed_writes = 0; ///< 因达到软限制而减速等待的写入批次数
+  std::chrono::nanoseconds write_delay{0};      ///< 减速等待的总时长
+};
+
+/**
+ * @brief Compaction 统计
+ */
+struct CompactionStats {
+  uint64_t compactions = 0;        ///< 完成的 Compaction 次数
+  uint64_t input_files = 0;        ///< 输入文件总数
+  uint64_t output_files = 0;       ///< 输出文件总数
+  uint64_t bytes_read = 0;         ///< 输入文件总字节数
+  uint64_t bytes_written = 0;      ///< 输出文件总字节数
+  uint64_t entries_dropped = 0;    ///< 被更新版本遮蔽而丢弃的条目数
+  uint64_t tombstones_dropped = 0; ///< 在最底层被丢弃的删除标记数
+  uint64_t blob_bytes_written = 0; ///< 写入 Blob 文件的字节总数（新分离的 Value 与 GC 搬迁的 Value）
+  uint64_t blobs_relocated = 0;    ///< Blob GC 搬到新 Blob 文件的 Value 数
+  uint64_t blob_bytes_relocated = 0; ///< 其中 Value 的总字节数
+  std::chrono::nanoseconds rate_limit_wait{0}; ///< 因限速而等待的总时长
+};
 
 /**
  * @brief 分布式 KV 存储引擎的核心入口类
  *
  * KVStore 负责统一管理内存中的 MemTable (SkipList) 和磁盘上的持久化文件
  * (WAL/SSTable)。 它对外提供 Put/Get/Del 接口，保证数据在写入内存前先落盘（WAL）。
- * 
- * @note 本类非线程安全，多线程环境下需外部加锁。
+ *
+ * Key 是任意字节串，按 KVStoreOptions::comparator 排序（默认按字节序），WAL、MemTable 与
+ * SSTable 中存储的都是同一份原始字节，写入与重放路径上没有任何格式转换。
+ * int Key 的重载使用 encode_int_key 的 4 字节保序编码，与旧版本写入的数据完全兼容。
+ *
+ * 写入路径与落盘 (Flush)：
+ * 1. 写入先进 WAL (wal.log)，再进活跃 MemTable (mem_)。
+ * 2. mem_ 达到 memtable_size_limit 后被冻结为 Immutable MemTable，同时 wal.log
+ *    被封存（重命名为 wal_<N>.log），新的 mem_ 与新的 wal.log 立即接管写入。
+ * 3. 后台落盘线程把 Immutable MemTable 按 key 有序地写成 L0 SSTable，
+ *    成功后删除对应的封存 WAL 段。落盘期间前台写入不受影响。
+ *
+ * 分层合并 (Leveled Compaction)：
+ * - L0 的文件之间 Key 范围可以重叠；L1 .. L<n> 每层内部文件互不重叠、按 Key 有序，
+ *   且每层有目标大小（逐层乘以 max_bytes_for_level_multiplier）。
+ * - 后台 Compaction 线程在 L0 文件数达到阈值或某层超过目标大小时，挑选该层的文件与
+ *   下一层重叠的文件做多路归并，写出新的下一层文件：同一 Key 只保留最新版本，
+ *   删除标记在确认更深层没有该 Key 时（即落到“最底层”时）被丢弃，空间由此回收。
+ * - Compaction 写入可以通过 compaction_bytes_per_sec 限速，避免挤占前台 I/O。
+ *
+ * 文件集合 (MANIFEST / Version)：
+ * - 每次落盘 / Compaction 对文件集合的修改先作为 VersionEdit 追加到 MANIFEST 并 fsync，
+ *   再安装新的 Version。启动时重放 MANIFEST 即可恢复文件集合，无需扫描并打开每个 SSTable；
+ *   SSTable 的读取器在第一次被读到时才打开。
+ * - 读请求持有 Version 快照的引用，被 Compaction 淘汰的文件在最后一个引用释放后才删除。
+ *
+ * 读取路径：活跃 MemTable -> Immutable MemTable（新到旧）-> L0 SSTable（新到旧）
+ * -> L1 .. L<n>（每层至多一个文件的 Key 范围包含该 Key），命中值或删除标记即停止。
+ * SSTable 的磁盘读取在锁外进行。
+ *
+ * 多版本与快照 (MVCC)：
+ * - 每个写入操作（批次中的每个操作）由 Leader 分配一个单调递增的序列号，随记录写入 WAL，
+ *   并作为内部 Key 的一部分写入 MemTable 与 SSTable；覆盖写与删除都追加新版本，不修改旧版本。
+ * - Leader 把一批写入全部应用到 MemTable 之后才发布其序列号，快照读只看已发布的序列号，
+ *   因此一个 WriteBatch 对快照要么整体可见、要么整体不可见。
+ * - get_snapshot() 记录当前已发布的序列号；带快照的读请求与迭代器无锁地读取该时刻的数据，
+ *   不阻塞写入。落盘与 Compaction 只丢弃被“对最老的存活快照也可见的更新版本”遮蔽的旧版本。
+ * - 序列号在落盘时写入 MANIFEST（LastSequence），WAL 段删除后重启也能继续递增。
+ *
+ * 线程模型：
+ * - 所有写入经由一个写入者队列 (writers_) 串行化。队首的写入者成为 Leader，
+ *   负责把队列中排队的日志记录合并写入 WAL，并按 WalSyncMode 决定如何 Sync。
+ * - MemTable 是单写多读的无锁跳表：Leader 在 mutex_ 之外把整批写入应用到 mem_，
+ *   Get 不获取 mutex_，与写入并发查询 MemTable，不会被写入者阻塞。
+ * - 读请求通过 memtables_ 取得 MemTable 集合（活跃 + Immutable）的快照，
+ *   memtables_mutex_ 只在复制 / 替换这个指针时持有；再取当前 Version，
+ *   两者的获取顺序保证数据不会在 MemTable 与 SSTable 之间“消失”。
+ *
+ * @note 本类是线程安全的，多个线程可以并发调用 put/get/del。
  */
 class KVStore {
 public:
@@ -33,242 +185,2612 @@ public:
    * @brief 构造函数：初始化存储引擎
    *
    * 初始化流程：
-   * 1. 检查数据目录是否存在，若不存在则自动创建。
-   * 2. 以 "ab" (Append + Binary) 模式打开 WAL 文件。
-   *    - 若文件不存在，fopen 会自动创建。
-   *    - 若文件存在，文件指针自动定位到末尾，准备追加写入。
-   * 3. 检查 WAL 文件大小：
-   *    - 若 > 0：说明是崩溃后重启，触发 Recovery 流程（Task 4 实现）。
-   *    - 若 = 0：说明是新实例，无需恢复。
+   * 1. 若未提供共享块缓存，按 block_cache_capacity 创建一个。
+   * 2. 检查数据目录是否存在，若不存在则自动创建；清理上次遗留的 *.tmp 文件。
+   * 3. 从 MANIFEST 恢复文件集合（旧版本创建的目录没有 MANIFEST，改为扫描目录并迁移），
+   *    写入新的 MANIFEST，删除未被引用的 SSTable 与已落盘的 WAL 段（见 recover_versions）。
+   * 4. 按编号顺序重放尚未落盘的封存 WAL 段，最后重放 wal.log（Recovery 流程），
+   *    序列号从 MANIFEST 记录的 LastSequence 与 WAL 记录中的序列号恢复。
+   *    recovery_threads > 1 时操作按 Key 分发给多个重放线程，同时在后台打开全部 SSTable。
+   * 5. 打开 wal.log 继续追加：截断到最后一条有效记录之后（丢弃崩溃留下的半条记录、
+   *    预分配的零或复用段的残留），再按 wal_segment_size 重新预分配。
+   *    重放出的数据不在 mem_ 中（并行重放）或要求直接落盘时，见 install_recovered。
+   * 6. 启动后台落盘线程与 Compaction 线程；若同步策略为 kPeriodic，启动后台周期 fsync 线程；
+   *    设置了 background_cpu 时把这些线程绑定到该 CPU。
    *
    * @param dir 数据存储目录的路径（如 "./data"）
-   * @throw std::runtime_error 如果 WAL 文件无法打开
+   * @param options 存储引擎选项（WAL 同步策略、MemTable 大小等）
+   * @throw std::runtime_error 如果 WAL 文件无法打开，或 MANIFEST 损坏
    */
-  explicit KVStore(const std::string &dir) : data_dir_(dir) {
+  explicit KVStore(const std::string &dir, const KVStoreOptions &options = {})
+      : data_dir_(dir), options_(options), internal_comparator_(options.comparator),
+        mem_(std::make_shared<MemTable>(options.comparator)) {
+    options_.table_options.comparator = options_.comparator;
+    options_.table_options.internal_keys = true;
+    if (!options_.table_options.block_cache && options_.block_cache_capacity > 0) {
+      options_.table_options.block_cache =
+          std::make_shared<BlockCache>(options_.block_cache_capacity);
+    }
+    if (options_.num_levels < 2) {
+      throw std::runtime_error("KVStoreOptions::num_levels must be at least 2");
+    }
+    compact_pointer_.resize(static_cast<size_t>(options_.num_levels));
+    if (options_.compaction_bytes_per_sec > 0) {
+      rate_limiter_ = std::make_unique<RateLimiter>(options_.compaction_bytes_per_sec);
+    }
     if (!std::filesystem::exists(data_dir_)) {
       std::filesystem::create_directories(data_dir_);
       std::cout << "[KVStore] Created data directory: "
                 << std::filesystem::absolute(data_dir_) << std::endl;
     }
 
-    wal_path_ = data_dir_ / "wal.log";
+    wal_path_ = data_dir_ / kActiveWalName;
+    versions_ = std::make_unique<VersionSet>(data_dir_, options_.num_levels, options_.table_options,
+                                             options_.max_manifest_file_size);
+    recover_versions();
+    last_sequence_ = versions_->LastSequence();
 
+    std::vector<std::jthread> table_loaders = open_tables_in_background();
+    for (size_t i = 0; options_.recovery_threads > 1 && i < options_.recovery_threads; ++i) {
+      replay_workers_.push_back(std::make_unique<ReplayWorker>(options_.comparator));
+    }
+
+    bool replayed = false;
+    for (uint64_t number : sealed_logs_) {
+      replay_wal(data_dir_ / wal_segment_name(number));
+      replayed = true;
+    }
+    uint64_t wal_offset = 0;
     if (std::filesystem::exists(wal_path_) && std::filesystem::file_size(wal_path_) > 0) {
-        replay_wal();
-    } else {
-        std::cout << "[KVStore] WAL initialized (New)." << std::endl;
+      wal_offset = replay_wal(wal_path_);
+      replayed = true;
+    }
+    std::vector<std::shared_ptr<MemTable>> recovered = finish_replay();
+    table_loaders.clear();  // 汇合
+    if (!replayed) {
+      std::cout << "[KVStore] WAL initialized (New)." << std::endl;
+    }
+    if (options_.recovery_threads > 1) recovery_stats_.tables_opened = count_open_tables();
+    visible_sequence_.store(last_sequence_, std::memory_order_release);
+
+    wal_ = std::make_unique<WalWriter>(wal_path_, wal_offset, /*reuse=*/false, wal_writer_options());
+    install_recovered(std::move(recovered));
+    install_memtables();
+
+    flush_thread_ = std::thread([this] { background_flush_loop(); });
+    compaction_thread_ = std::thread([this] { background_compaction_loop(); });
+    if (options_.sync_mode == WalSyncMode::kPeriodic) {
+      sync_thread_ = std::thread([this] { periodic_sync_loop(); });
     }
-    // 使用 C 风格 fopen 以便获取底层文件描述符用于 Sync
-    wal_file_ = fopen(wal_path_.string().c_str(), "ab");
-    if (!wal_file_) {
-      throw std::runtime_error("Failed to open WAL file: " +
-                               wal_path_.string());
+    if (options_.background_cpu >= 0) {
+      for (std::thread *t : {&flush_thread_, &compaction_thread_, &sync_thread_}) {
+        if (t->joinable()) pin_thread_to_cpu(*t, options_.background_cpu);
+      }
     }
   }
 
+  KVStore(const KVStore &) = delete;
+  KVStore &operator=(const KVStore &) = delete;
+
   /**
    * @brief 析构函数：资源释放
-   * 
-   * 关闭 WAL 文件句柄，确保缓冲区数据刷新（虽然 OS 也会做，但显式关闭是好习惯）。
+   *
+   * 1. 通知后台落盘线程退出（正在进行的落盘会完成；尚未落盘的 Immutable MemTable
+   *    仍保存在封存的 WAL 段中，下次启动时重放）。正在进行的 Compaction 被中止，
+   *    已写出的临时文件被删除，输入文件保持不变。
+   * 2. 停止周期同步线程，并在关闭前补做一次 fsync，避免 kPeriodic 模式下正常退出也丢数据。
+   * 3. 关闭 WAL，并把 wal.log 截断到实际写入的长度（去掉预分配的空间）。
    */
   ~KVStore() {
-    if (wal_file_) {
-      std::fclose(wal_file_);
-      wal_file_ = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      shutting_down_ = true;
+    }
+    stop_compaction_.store(true, std::memory_order_release);
+    bg_cv_.notify_all();
+    if (flush_thread_.joinable()) {
+      flush_thread_.join();
     }
+    if (compaction_thread_.joinable()) {
+      compaction_thread_.join();
+    }
+    if (sync_thread_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(sync_mutex_);
+        stop_sync_ = true;
+      }
+      sync_cv_.notify_all();
+      sync_thread_.join();
+      try { sync_wal(); } catch (...) {}
+    }
+    wal_.reset();
   }
 
   /**
    * @brief 写入键值对 (Put)
    *
    * 核心时序 (The Invariant)：
-   * 1. Construct: 构造 LogRecord。
-   * 2. WAL: 调用 append_wal 写入磁盘并 Sync。
-   * 3. MemTable: 更新内存数据结构。
+   * 1. Construct: 直接从 key / value 的视图编码日志记录（在锁外完成，序列号待 Leader 填入）。
+   * 2. WAL: 经由写入者队列分配序列号、写入磁盘，并按 WalSyncMode 执行 Sync。
+   * 3. MemTable: 以该序列号写入新版本（由 Leader 按 WAL 顺序执行）。
    *
-   * @param key 键
+   * @param key 键（任意字节串，按 KVStoreOptions::comparator 排序）
    * @param value 值
-   * @throw std::runtime_error 如果 WAL 写入失败
+   * @throw std::runtime_error 如果 WAL 写入失败或后台落盘已失败
+   *
+   * @note 不会为 key / value 创建临时的 std::string：值只被拷贝进 WAL 缓冲区与 MemTable 的 Arena
+   *       各一次，调用者持有的缓冲区在 put 返回后即可复用。
    */
-  void put(int key, const std::string &value) {
-    LogRecord record{LogType::kPut, std::to_string(key), value};
-    append_wal(record);
-    memtable_.insert(key, value);
+  void put(std::string_view key, std::string_view value) {
+    StopWatch timer(statistics(), HistogramType::kPut);
+    RecordTick(statistics(), Ticker::kPuts);
+    RecordTick(statistics(), Ticker::kBytesWritten, key.size() + value.size());
+    Writer w;
+    w.type = LogType::kPut;
+    w.key = key;
+    w.value = value;
+    w.encoded = encode_sequenced_log_record(LogType::kPut, key, value);
+    write_impl(w);
   }
 
+  /// int Key 的便捷重载，等价于 put(encode_int_key(key), value)
+  void put(int key, std::string_view value) { put(encode_int_key(key), value); }
+
   /**
    * @brief 查询键值对 (Get)
    *
-   * 当前仅查询内存中的 MemTable。
+   * 按从新到旧的顺序查询：活跃 MemTable -> Immutable MemTable（新到旧）-> SSTable（L0 新到旧，
+   * 再逐层向下）。任一层命中删除标记即视为不存在，不再查询更老的数据。
+   * 不获取 mutex_：先取 MemTable 集合的快照并无锁查询，未命中时再取当前 Version 的引用
+   * 读取 SSTable。顺序不能颠倒——落盘线程先安装包含新 L0 文件的 Version、后移除 Immutable
+   * MemTable，先取 MemTable 快照保证看不到 Immutable 时一定能看到对应的文件。
+   * 持有 Version 期间即使发生 Compaction，其中的文件也不会被删除。
    *
+   * 值不会被拷贝：value 直接指向命中的 MemTable 的 Arena 或块缓存中的 Data Block，
+   * 并钉住它们（见 PinnableValue）。value 存活期间即使发生落盘、Compaction、缓存淘汰
+   * 或该 key 被覆盖写，视图依然有效且内容不变。
+   *
+   * @param options 读选项：指定 snapshot 时返回该快照中的版本，否则返回最新已发布的版本
+   *                （与 get_snapshot() 相同的隐式快照，WriteBatch 要么全部可见、要么全部不可见）
    * @param key 键
+   * @param value [out] 若存在指向 value；不存在时被 reset()
+   * @return true 存在，false 不存在（或已被删除）
+   * @throw std::runtime_error SSTable 读取失败或校验失败
+   */
+  bool get(const ReadOptions &options, std::string_view key, PinnableValue *value) const {
+    Statistics *stats = statistics();
+    StopWatch timer(stats, HistogramType::kGet);
+    value->reset();
+    // 不指定快照时读已发布的序列号：Leader 释放锁后才把一批写入逐条插入 MemTable，
+    // 读 kMaxSequenceNumber 会看到只应用了一半的 WriteBatch
+    SequenceNumber snapshot = options.snapshot ? options.snapshot->sequence()
+                                               : visible_sequence_.load(std::memory_order_acquire);
+    MemTable::LookupResult result = lookup_memtables(*memtables(), key, snapshot, value);
+    bool found = result == MemTable::LookupResult::kFound;
+    if (result == MemTable::LookupResult::kNotFound) {
+      found = lookup_tables(key, snapshot, *versions_->current(), value, stats);
+    }
+    if (stats) {
+      stats->Record(Ticker::kGets);
+      stats->Record(result == MemTable::LookupResult::kNotFound ? Ticker::kMemtableMisses
+                                                                 : Ticker::kMemtableHits);
+      if (found) {
+        stats->Record(Ticker::kGetHits);
+        stats->Record(Ticker::kBytesRead, value->size());
+      }
+    }
+    return found;
+  }
+
+  /// 读取最新版本，等价于 get(ReadOptions(), key, value)
+  bool get(std::string_view key, PinnableValue *value) const { return get(ReadOptions(), key, value); }
+
+  /// int Key 的便捷重载，等价于 get(encode_int_key(key), value)
+  bool get(int key, PinnableValue *value) const { return get(encode_int_key(key), value); }
+
+  /**
+   * @brief 查询键值对并拷贝出值（语义同 get(options, key, PinnableValue*)）
+   *
    * @return std::optional<std::string> 若存在返回 value，否则返回 std::nullopt
+   * @throw std::runtime_error SSTable 读取失败或校验失败
+   */
+  std::optional<std::string> get(const ReadOptions &options, std::string_view key) const {
+    PinnableValue value;
+    if (!get(options, key, &value)) return std::nullopt;
+    return value.to_string();
+  }
+
+  /// 读取最新版本并拷贝出值
+  std::optional<std::string> get(std::string_view key) const { return get(ReadOptions(), key); }
+
+  /// int Key 的便捷重载，等价于 get(encode_int_key(key))
+  std::optional<std::string> get(int key) const { return get(encode_int_key(key)); }
+
+  /**
+   * @brief 创建一致性读快照：记录当前已发布的序列号，不阻塞写入
+   *
+   * 快照存活期间，之后的覆盖写、删除、落盘与 Compaction 都不影响通过它读到的数据。
+   * 用完后必须调用 release_snapshot()，否则 Compaction 会一直保留它需要的旧版本。
+   */
+  const Snapshot *get_snapshot() {
+    std::lock_guard<std::mutex> lock(snapshots_mutex_);
+    return snapshots_.New(visible_sequence_.load(std::memory_order_acquire));
+  }
+
+  /// 释放 get_snapshot() 返回的快照（之后不能再使用它）
+  void release_snapshot(const Snapshot *snapshot) {
+    std::lock_guard<std::mutex> lock(snapshots_mutex_);
+    snapshots_.Delete(snapshot);
+  }
+
+  /**
+   * @brief 创建遍历全部存活键值对的有序迭代器（支持 Seek / Next / Prev）
+   *
+   * 归并活跃 MemTable、Immutable MemTable、每个 L0 文件以及 L1 起的每一层（层内文件按需打开），
+   * 每个 Key 只返回快照中可见的最新版本，被删除的 Key 不出现。与 get 相同，先取 MemTable 快照、
+   * 再取当前 Version，迭代器持有二者的引用。未指定 options.snapshot 时，在取得二者之后读取
+   * 已发布的序列号作为隐式快照，因此迭代器看到的总是某一时刻的一致视图（见 DBIterator）。
+   * 不获取 mutex_。
+   *
+   * @param options 读选项（快照、是否填充块缓存）
+   * @throw std::runtime_error SSTable 读取失败或校验失败（迭代过程中同样可能抛出）
+   */
+  std::unique_ptr<DBIterator> new_iterator(const ReadOptions &options = ReadOptions()) const {
+    std::shared_ptr<const MemTableSet> set = memtables();
+    std::shared_ptr<const Version> version = versions_->current();
+    // 序列号必须在 Version 之后读取：Compaction 丢弃旧版本的依据不会晚于它（见 smallest_snapshot）
+    SequenceNumber sequence = options.snapshot ? options.snapshot->sequence()
+                                               : visible_sequence_.load(std::memory_order_acquire);
+
+    std::vector<std::unique_ptr<InternalIterator>> children;
+    children.push_back(std::make_unique<MemTable::Iterator>(set->mem.get()));
+    for (const auto &imm : set->imms) children.push_back(std::make_unique<MemTable::Iterator>(imm.get()));
+    const Version::FileList &level0 = version->Files(0);
+    for (auto it = level0.rbegin(); it != level0.rend(); ++it) {
+      children.push_back(std::make_unique<TableIterator>((*it)->Reader(), options.fill_cache));
+    }
+    for (int level = 1; level < version->NumLevels(); ++level) {
+      if (version->Files(level).empty()) continue;
+      children.push_back(std::make_unique<LevelIterator>(version, level, options.fill_cache));
+    }
+
+    auto merged = std::make_unique<MergingIterator>(&internal_comparator_, std::move(children));
+    DBIterator::BlobResolver resolver;
+    if (!version->BlobFiles().empty()) {
+      // pins 保证 version 比迭代器存活更久
+      resolver = [blobs = version.get(), fill_cache = options.fill_cache](std::string_view user_key,
+                                                                          std::string_view blob_index) {
+        return read_blob(*blobs, user_key, blob_index, fill_cache);
+      };
+    }
+    std::vector<std::shared_ptr<const void>> pins{std::move(set), std::move(version)};
+    return std::make_unique<DBIterator>(std::move(merged), options_.comparator, sequence, std::move(pins),
+                                        std::move(resolver));
+  }
+
+  /**
+   * @brief 范围扫描：返回 [begin, end) 内的键值对（按比较器顺序，至多 limit 条）
+   *
+   * @param options 读选项（快照、是否填充块缓存）
+   * @throw std::runtime_error SSTable 读取失败或校验失败
+   */
+  std::vector<std::pair<std::string, std::string>> scan(
+      const ReadOptions &options, std::string_view begin, std::string_view end,
+      size_t limit = std::numeric_limits<size_t>::max()) const {
+    std::vector<std::pair<std::string, std::string>> result;
+    if (limit == 0) return result;
+    auto it = new_iterator(options);
+    for (it->Seek(begin); it->Valid(); it->Next()) {
+      if (options_.comparator->Compare(it->key(), end) >= 0) break;
+      result.emplace_back(it->key(), it->value());
+      if (result.size() >= limit) break;
+    }
+    return result;
+  }
+
+  /// 以隐式快照做范围扫描，等价于 scan(ReadOptions(), begin, end, limit)
+  std::vector<std::pair<std::string, std::string>> scan(
+      std::string_view begin, std::string_view end,
+      size_t limit = std::numeric_limits<size_t>::max()) const {
+    return scan(ReadOptions(), begin, end, limit);
+  }
+
+  /**
+   * @brief 前缀扫描：返回所有以 prefix 开头的键值对（至多 limit 条）
+   *
+   * 要求比较器把共享同一前缀的 Key 排在一起（默认的字节序比较器满足），
+   * 扫描在遇到第一个不以 prefix 开头的 Key 时停止。
+   *
+   * @throw std::runtime_error SSTable 读取失败或校验失败
    */
-  std::optional<std::string> get(int key) { return memtable_.search(key); }
+  std::vector<std::pair<std::string, std::string>> scan_prefix(
+      const ReadOptions &options, std::string_view prefix,
+      size_t limit = std::numeric_limits<size_t>::max()) const {
+    std::vector<std::pair<std::string, std::string>> result;
+    if (limit == 0) return result;
+    auto it = new_iterator(options);
+    for (it->Seek(prefix); it->Valid(); it->Next()) {
+      if (it->key().substr(0, prefix.size()) != prefix) break;
+      result.emplace_back(it->key(), it->value());
+      if (result.size() >= limit) break;
+    }
+    return result;
+  }
+
+  /// 以隐式快照做前缀扫描，等价于 scan_prefix(ReadOptions(), prefix, limit)
+  std::vector<std::pair<std::string, std::string>> scan_prefix(
+      std::string_view prefix, size_t limit = std::numeric_limits<size_t>::max()) const {
+    return scan_prefix(ReadOptions(), prefix, limit);
+  }
 
   /**
    * @brief 删除键值对 (Delete)
    *
    * 同样遵循 WAL 先行原则：
    * 1. 写入 Delete 类型的日志记录。
-   * 2. 在内存中执行删除操作。
+   * 2. 在 MemTable 中写入删除标记（遮蔽更老的数据）。
+   *
+   * 返回值在加入写入队列之前查询得到（可能读 SSTable），不占用串行的写入组：
+   * 与同一个 Key 的并发写入竞争时，返回值反映的是删除前某一时刻的状态。
    *
    * @param key 键
    * @return true 删除成功（Key 存在且被移除）
    * @return false 删除失败（Key 不存在）
    */
-  bool del(int key) {
-    LogRecord record{LogType::kDelete, std::to_string(key), ""};
-    append_wal(record);
-    return memtable_.remove(key);
+  bool del(std::string_view key) {
+    StopWatch timer(statistics(), HistogramType::kDelete);
+    RecordTick(statistics(), Ticker::kDeletes);
+    bool existed = is_visible(key);
+    Writer w;
+    w.type = LogType::kDelete;
+    w.key = key;
+    w.encoded = encode_sequenced_log_record(LogType::kDelete, key, std::string_view());
+    write_impl(w);
+    return existed;
   }
 
-private:
+  /// int Key 的便捷重载，等价于 del(encode_int_key(key))
+  bool del(int key) { return del(encode_int_key(key)); }
+
   /**
-     * @brief [Task 4] 重放 WAL 日志，恢复 MemTable (Crash Recovery)
-     * 
-     * 该函数在数据库启动时被调用，用于将上次非正常关闭（崩溃/断电）时遗留在磁盘上的
-     * WAL 日志记录重新应用到内存中，从而恢复数据一致性。
-     * 
-     * 核心流程 (Read -> Verify -> Apply):
-     * 1. **Read**: 循环读取日志记录的 Header (13B) 和 Payload。
-     * 2. **Verify**: 计算 Payload 的 CRC32 校验和，与 Header 中的 Checksum 比对。
-     *    - 若校验失败或读取不完整，视为崩溃现场，停止重放（Fail-Stop）。
-     * 3. **Apply**: 将验证通过的记录（Put/Delete）重新执行到 MemTable。
-     */
-    void replay_wal() {
-      FILE* fp = fopen(wal_path_.string().c_str(), "rb");
-      if(!fp) {
-        return;
-      }
+   * @brief 原子批量写入 (WriteBatch)
+   *
+   * 整个批次被编码为一条 kBatch 日志记录：一次编码、一次 WAL 写入、一次 Sync，
+   * 随后在同一次加锁中按顺序应用到 MemTable。崩溃重放时整批要么全部恢复，要么全部丢弃。
+   *
+   * @param batch 待提交的批次（空批次直接返回）
+   * @throw std::runtime_error 如果 WAL 写入失败（此时批次中的任何操作都未生效）
+   */
+  void write(const WriteBatch &batch) {
+    if (batch.empty()) return;
+    StopWatch timer(statistics(), HistogramType::kWrite);
+    RecordTick(statistics(), Ticker::kWriteBatches);
+    RecordTick(statistics(), Ticker::kBytesWritten, batch.rep().size());
+    Writer w;
+    w.type = LogType::kBatch;
+    w.batch = &batch;
+    w.encoded = encode_sequenced_log_record(LogType::kBatch, std::string_view(), batch.rep());
+    write_impl(w);
+  }
 
-      std::cout << "[Recovery] Replaying WAL..." << std::endl;
+  /**
+   * @brief 强制落盘：冻结当前 MemTable，并等待所有 Immutable MemTable 写成 SSTable
+   *
+   * 冻结操作同样经由写入者队列完成，保证 WAL 段的切分点与 MemTable 的切换点一致。
+   *
+   * @throw std::runtime_error 如果后台落盘失败
+   */
+  void flush() {
+    Writer w;
+    w.force_flush = true;
+    write_impl(w);
 
-      while(true) {
-        // ... (省略部分变量定义，保持原有逻辑)
-        uint32_t stored_checksum;
-        uint32_t key_len;
-        uint32_t value_len;
-        uint8_t type_u8;
+    std::unique_lock<std::mutex> lock(mutex_);
+    bg_cv_.wait(lock, [this] { return imms_.empty() || !bg_error_.empty() || shutting_down_; });
+    if (!bg_error_.empty()) {
+      throw std::runtime_error("Background work failed: " + bg_error_);
+    }
+  }
 
-        // 1. Read Header (13 Bytes)
-        // 如果读取不足 13 字节，说明文件在 Header 处被截断（崩溃点），停止重放。
-        if(fread(&stored_checksum, 1, 4,fp) != 4) break;
-        if(fread(&key_len, 1, 4, fp) != 4) break;
-        if(fread(&value_len, 1, 4, fp) != 4) break;
-        if(fread(&type_u8, 1, 1, fp) != 1) break;
+  /**
+   * @brief 手动全量 Compaction：先 flush()，再把所有层逐层合并到最深的非空层
+   *
+   * 完成后所有数据位于同一层，被遮蔽的旧版本与删除标记都已清除。
+   * 合并由后台 Compaction 线程执行，本函数阻塞等待其完成。
+   *
+   * @throw std::runtime_error 如果后台落盘或 Compaction 失败
+   */
+  void compact() {
+    flush();
 
-        std::string key;
-        std::string value;
+    std::unique_lock<std::mutex> lock(mutex_);
+    manual_compaction_ = true;
+    bg_cv_.notify_all();
+    bg_cv_.wait(lock, [this] { return !manual_compaction_ || !bg_error_.empty() || shutting_down_; });
+    if (!bg_error_.empty()) {
+      throw std::runtime_error("Background work failed: " + bg_error_);
+    }
+  }
 
-        // 2. Read Payload
-        // 如果 Payload 读取不足，说明文件在 Body 处被截断，停止重放。
-        if(key_len > 0) {
-          key.resize(key_len);
-          if(fread(key.data(), 1, key_len, fp) != key_len) break;
-        }
+  /**
+   * @brief 在新目录 dir 中创建一个一致的 Checkpoint：以 dir 为数据目录打开的 KVStore 看到的数据
+   *        就是 flush() 完成时的全部写入
+   *
+   * 先 flush()，再持有当前 Version（期间 Compaction 不会删除其中的文件），
+   * 把它引用的 SSTable 与 Blob 文件硬链接到 dir（跨文件系统时退回复制），最后写入只含该 Version 的 MANIFEST。
+   * Checkpoint 不含 WAL：flush() 之后的并发写入不在其中。
+   *
+   * @param dir 目标目录（必须不存在）
+   * @throw std::runtime_error dir 已存在、后台落盘失败，或链接 / 写入失败
+   */
+  void create_checkpoint(const std::string &dir) {
+    std::filesystem::path target(dir);
+    if (std::filesystem::exists(target)) {
+      throw std::runtime_error("Checkpoint directory already exists: " + dir);
+    }
+    flush();
 
-        if(value_len > 0) {
-          value.resize(value_len);
-          if(fread(value.data(), 1, value_len, fp) != value_len) break;
-        }
+    std::shared_ptr<const Version> version = versions_->current();
+    std::filesystem::create_directories(target);
+    auto link_file = [&target](const std::filesystem::path &path) {
+      std::filesystem::path link = target / path.filename();
+      std::error_code ec;
+      std::filesystem::create_hard_link(path, link, ec);
+      if (ec) std::filesystem::copy_file(path, link);
+    };
+    for (int level = 0; level < version->NumLevels(); ++level) {
+      for (const auto &file : version->Files(level)) link_file(file->Path());
+    }
+    for (const auto &[number, blob] : version->BlobFiles()) link_file(blob.file->Path());
+    versions_->WriteCheckpoint(target, *version);
+  }
 
-        // 3. Verify Checksum
-        // 重新计算 (KeyLen + ValLen + Type + Payload) 的 CRC32
-        uint32_t payload_total_len = 4 + 4 + 1 + key_len + value_len;
-        std::vector<char> verify_buffer (payload_total_len);
-        char* ptr = verify_buffer.data();
+  /**
+   * @brief 获取启动时 WAL 重放的统计（字节数、记录数、耗时、吞吐）
+   *
+   * 若本次启动没有可重放的 WAL，各项均为 0。
+   */
+  const RecoveryStats &recovery_stats() const { return recovery_stats_; }
 
-        memcpy(ptr, &key_len, 4); ptr += 4;
-        memcpy(ptr, &value_len, 4); ptr += 4;
-        memcpy(ptr, &type_u8, 1); ptr += 1;
+  /**
+   * @brief 获取 WAL 写入统计（记录数、批次数、fsync 次数、平均批大小）
+   */
+  WalStats wal_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wal_stats_;
+  }
 
-        if(key_len > 0) {
-          memcpy(ptr, key.data(), key_len); ptr += key_len;
-        }
-        if(value_len > 0) {
-          memcpy(ptr, value.data(), value_len);
-        }
+  /**
+   * @brief 获取 MemTable 落盘统计
+   */
+  FlushStats flush_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return flush_stats_;
+  }
 
-        uint32_t calculated_crc = crc32(verify_buffer.data(), payload_total_len);
-        if(stored_checksum != calculated_crc) {
-          // 遇到校验错误（中间位翻转或写入未完成），严格模式下应报错。
-          // 这里简单处理为停止重放。
-          std::cerr << "[Recovery] Checksum mismatch! (Truncated or Corrupted). Stopping." << std::endl;
-          break;
-        }
+  /**
+   * @brief 获取块缓存统计（命中 / 未命中 / 淘汰 / 占用）；未使用缓存时各项均为 0
+   */
+  BlockCacheStats block_cache_stats() const {
+    const auto &cache = options_.table_options.block_cache;
+    return cache ? cache->Stats() : BlockCacheStats{};
+  }
 
-        // 4. Apply to MemTable
-        // 将磁盘上的持久化数据恢复到内存结构中
-        LogType type = static_cast<LogType>(type_u8);
-        try {
-          // 反序列化：因为 KVStore 定义为 <int, string>，所以必须将 WAL 中的 string key 转回 int。
-          // 注意：如果磁盘数据损坏导致 key 变成了非数字字符串，stoi 会抛出异常。
-          int key_int = std::stoi(key);
-
-          if(type == LogType::kPut) {
-            memtable_.insert(key_int, value);
-          } else if (type == LogType::kDelete) {
-            memtable_.remove(key_int);
-          }
-        } catch (...) {
-           // 容错处理：忽略损坏的记录（生产环境建议记录 Error 日志）
-           std::cerr << "[Recovery] Failed to parse key: " << key << ". Skipping." << std::endl;
-        }
+  /// 当前等待落盘的 Immutable MemTable 数量
+  size_t num_immutable_memtables() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return imms_.size();
+  }
+
+  /**
+   * @brief 获取 Compaction 统计
+   */
+  CompactionStats compaction_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return compaction_stats_;
+  }
+
+  /// 当前 L0 SSTable 文件数量
+  size_t num_level0_tables() const { return num_tables_at_level(0); }
+
+  /// 第 level 层的 SSTable 文件数量（level 越界时为 0）
+  size_t num_tables_at_level(int level) const { return versions_->current()->NumFiles(level); }
+
+  /// 第 level 层所有 SSTable 的总字节数（level 越界时为 0）
+  uint64_t level_bytes(int level) const { return versions_->current()->LevelBytes(level); }
+
+  /// 当前 MANIFEST 的大小（字节）
+  uint64_t manifest_file_size() const { return versions_->ManifestFileSize(); }
+
+  /// KVStoreOptions::statistics（未启用时为空）
+  Statistics *statistics() const { return options_.statistics.get(); }
+
+  /**
+   * @brief 查询运行时属性，结果为文本
+   *
+   * - "kv.stats"：可读的统计报告：各层文件数与大小、MemTable、WAL、落盘、Compaction、块缓存，
+   *   以及 KVStoreOptions::statistics 中的计数器与延迟直方图（启用时）。
+   * - "kv.prometheus"：同样内容的 Prometheus 文本格式，可直接作为 /metrics 的响应。
+   * - "kv.num-immutable-mem-table"：等待落盘的 Immutable MemTable 数量。
+   * - "kv.cur-size-active-mem-table"：活跃 MemTable 占用的字节数。
+   * - "kv.num-files-at-level<N>"：第 N 层的 SSTable 文件数量。
+   * - "kv.is-write-stopped"：写入是否因达到硬限制而阻塞（"1" / "0"）。
+   * - "kv.actual-delayed-write-rate"：当前的减速速率（字节/秒），"0" 表示未减速。
+   * - "kv.estimate-pending-compaction-bytes"：待 Compaction 字节数的估计值。
+   * - "kv.mmap-bytes" / "kv.mmap-resident-bytes"：TableOptions::use_mmap_reads 时已打开的 SSTable
+   *   映射的总字节数，以及其中驻留在 Page Cache 中的字节数（mincore；未启用 mmap 时为 0）。
+   * - "kv.num-blob-files" / "kv.total-blob-file-size" / "kv.blob-garbage-bytes"：存活的 Blob 文件数、
+   *   总字节数，以及其中已失效的 Value 字节数（discard 统计）。
+   *
+   * 不获取 mutex_ 以外的长时间锁，可以在写入高峰期周期性调用。
+   *
+   * @return false 未知的属性名（value 不变）
+   */
+  bool get_property(std::string_view property, std::string *value) const {
+    constexpr std::string_view kLevelFiles = "kv.num-files-at-level";
+    if (property == "kv.stats") {
+      *value = stats_report();
+    } else if (property == "kv.prometheus") {
+      *value = prometheus_report();
+    } else if (property == "kv.num-immutable-mem-table") {
+      *value = std::to_string(num_immutable_memtables());
+    } else if (property == "kv.is-write-stopped" || property == "kv.actual-delayed-write-rate") {
+      std::lock_guard<std::mutex> lock(mutex_);
+      WriteCondition condition = write_condition();
+      *value = property == "kv.is-write-stopped" ? (condition.stopped ? "1" : "0")
+                                                 : std::to_string(condition.delayed_write_rate);
+    } else if (property == "kv.estimate-pending-compaction-bytes") {
+      *value = std::to_string(estimate_pending_compaction_bytes(*versions_->current()));
+    } else if (property == "kv.mmap-bytes" || property == "kv.mmap-resident-bytes") {
+      auto [mapped, resident] = mmap_usage();
+      *value = std::to_string(property == "kv.mmap-bytes" ? mapped : resident);
+    } else if (property == "kv.num-blob-files" || property == "kv.total-blob-file-size" ||
+               property == "kv.blob-garbage-bytes") {
+      BlobUsage usage = blob_usage(*versions_->current());
+      *value = std::to_string(property == "kv.num-blob-files"       ? usage.files
+                              : property == "kv.total-blob-file-size" ? usage.file_bytes
+                                                                      : usage.garbage_bytes);
+    } else if (property == "kv.cur-size-active-mem-table") {
+      *value = std::to_string(memtables()->mem->approximate_memory_usage());
+    } else if (property.substr(0, kLevelFiles.size()) == kLevelFiles) {
+      std::string_view digits = property.substr(kLevelFiles.size());
+      int level = 0;
+      auto [end, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), level);
+      if (digits.empty() || ec != std::errc() || end != digits.data() + digits.size() || level < 0 ||
+          level >= options_.num_levels) {
+        return false;
       }
-      fclose(fp);
-      std::cout << "[Recovery] WAL replay finished." << std::endl;
+      *value = std::to_string(num_tables_at_level(level));
+    } else {
+      return false;
     }
+    return true;
+  }
+
+private:
+  /// Immutable MemTable 的数量与总字节数（来自读请求使用的 MemTable 集合快照）
+  std::pair<size_t, uint64_t> immutable_memtable_usage() const {
+    std::shared_ptr<const MemTableSet> set = memtables();
+    uint64_t bytes = 0;
+    for (const auto &imm : set->imms) bytes += imm->approximate_memory_usage();
+    return {set->imms.size(), bytes};
+  }
+
   /**
-   * @brief 核心辅助函数：将日志记录持久化到磁盘
-   * 
-   * 实现了数据持久化的“三步走”策略，确保 ACID 中的 Durability（持久性）：
-   * 
-   * 1. **Write (fwrite)**: 
-   *    将数据从 Application Buffer 拷贝到 C Library Buffer (用户态)。
-   *    速度极快，但这只是内存拷贝，未离开当前进程。
-   * 
-   * 2. **Flush (fflush)**: 
-   *    将数据从 C Library Buffer 刷新到 OS Page Cache (内核态)。
-   *    此时如果进程崩溃 (Crash)，数据安全；但如果操作系统崩溃或断电，数据丢失。
-   * 
-   * 3. **Sync (fsync / _commit)**: 
-   *    强制操作系统将 Page Cache 中的数据写入物理磁盘介质。
-   *    这是最慢的一步（机械盘 ms 级，SSD us 级），但能保证断电不丢数据。
-   * 
-   * @param record 待写入的日志记录
-   * @throw std::runtime_error 任何一步 I/O 失败都会抛出异常，触发 Fail-Stop
+   * @brief 当前版本中已打开的 SSTable 映射的总字节数与驻留字节数
+   *
+   * 只统计已打开读取器的文件，不会为了统计而打开文件。
+   */
+  std::pair<uint64_t, uint64_t> mmap_usage() const {
+    std::shared_ptr<const Version> version = versions_->current();
+    uint64_t mapped = 0, resident = 0;
+    for (int level = 0; level < version->NumLevels(); ++level) {
+      for (const auto &file : version->Files(level)) {
+        if (!file->IsOpen()) continue;
+        std::shared_ptr<SSTableReader> reader = file->Reader();
+        mapped += reader->MappedBytes();
+        resident += reader->ResidentBytes();
+      }
+    }
+    return {mapped, resident};
+  }
+
+  /// Blob 文件的数量、总字节数与失效字节数
+  struct BlobUsage {
+    uint64_t files = 0;
+    uint64_t file_bytes = 0;
+    uint64_t garbage_bytes = 0;
+  };
+
+  static BlobUsage blob_usage(const Version &version) {
+    BlobUsage usage;
+    for (const auto &[number, blob] : version.BlobFiles()) {
+      usage.files += 1;
+      usage.file_bytes += blob.file->FileSize();
+      usage.garbage_bytes += blob.garbage_bytes;
+    }
+    return usage;
+  }
+
+  /// get_property("kv.stats")
+  std::string stats_report() const {
+    std::string out;
+    char line[256];
+    out += "** LSM **\nLevel  Files  Size(MB)\n";
+    for (int level = 0; level < options_.num_levels; ++level) {
+      std::snprintf(line, sizeof(line), "L%-5d %5zu %9.2f\n", level, num_tables_at_level(level),
+                    static_cast<double>(level_bytes(level)) / (1024.0 * 1024.0));
+      out += line;
+    }
+    auto [imm_count, imm_bytes] = immutable_memtable_usage();
+    std::snprintf(line, sizeof(line),
+                  "MemTable: active %zu bytes, %zu immutable (%llu bytes), last sequence %llu\n",
+                  memtables()->mem->approximate_memory_usage(), imm_count,
+                  static_cast<unsigned long long>(imm_bytes),
+                  static_cast<unsigned long long>(visible_sequence_.load(std::memory_order_acquire)));
+    out += line;
+
+    WalStats wal = wal_stats();
+    std::snprintf(line, sizeof(line),
+                  "WAL: %llu records, %llu bytes, %llu groups (avg %.2f), %llu syncs, %llu segments\n",
+                  static_cast<unsigned long long>(wal.records), static_cast<unsigned long long>(wal.bytes),
+                  static_cast<unsigned long long>(wal.write_groups), wal.avg_group_size(),
+                  static_cast<unsigned long long>(wal.syncs), static_cast<unsigned long long>(wal.segments));
+    out += line;
+    FlushStats flush = flush_stats();
+    std::snprintf(line, sizeof(line), "Flush: %llu flushes, %llu entries, %llu bytes\n",
+                  static_cast<unsigned long long>(flush.flushes), static_cast<unsigned long long>(flush.entries),
+                  static_cast<unsigned long long>(flush.bytes_written));
+    out += line;
+    std::snprintf(line, sizeof(line),
+                  "Write stalls: %llu stops (%.3f s), %llu delayed batches (%.3f s), pending compaction %llu bytes\n",
+                  static_cast<unsigned long long>(flush.write_stalls),
+                  std::chrono::duration<double>(flush.write_stall_time).count(),
+                  static_cast<unsigned long long>(flush.delayed_writes),
+                  std::chrono::duration<double>(flush.write_delay).count(),
+                  static_cast<unsigned long long>(estimate_pending_compaction_bytes(*versions_->current())));
+    out += line;
+    CompactionStats compaction = compaction_stats();
+    std::snprintf(line, sizeof(line), "Compaction: %llu compactions, %llu bytes read, %llu bytes written\n",
+                  static_cast<unsigned long long>(compaction.compactions),
+                  static_cast<unsigned long long>(compaction.bytes_read),
+                  static_cast<unsigned long long>(compaction.bytes_written));
+    out += line;
+    if (options_.min_blob_size > 0) {
+      BlobUsage blobs = blob_usage(*versions_->current());
+      std::snprintf(line, sizeof(line),
+                    "Blob: %llu files, %llu bytes, %llu garbage bytes, %llu bytes written, %llu relocated\n",
+                    static_cast<unsigned long long>(blobs.files),
+                    static_cast<unsigned long long>(blobs.file_bytes),
+                    static_cast<unsigned long long>(blobs.garbage_bytes),
+                    static_cast<unsigned long long>(flush.blob_bytes_written + compaction.blob_bytes_written),
+                    static_cast<unsigned long long>(compaction.blobs_relocated));
+      out += line;
+    }
+    BlockCacheStats cache = block_cache_stats();
+    std::snprintf(line, sizeof(line), "Block cache: %llu hits, %llu misses (hit rate %.4f), usage %zu / %zu bytes\n",
+                  static_cast<unsigned long long>(cache.hits), static_cast<unsigned long long>(cache.misses),
+                  cache.hit_rate(), cache.usage, cache.capacity);
+    out += line;
+    if (options_.table_options.use_mmap_reads) {
+      auto [mapped, resident] = mmap_usage();
+      std::snprintf(line, sizeof(line), "Mmap: %llu bytes mapped, %llu bytes resident\n",
+                    static_cast<unsigned long long>(mapped), static_cast<unsigned long long>(resident));
+      out += line;
+    }
+
+    if (Statistics *stats = statistics()) {
+      out += "** Statistics **\n";
+      out += stats->ToString();
+    }
+    return out;
+  }
+
+  /// get_property("kv.prometheus")
+  std::string prometheus_report() const {
+    std::string out;
+    auto metric = [&out](const char *name, const char *type, auto value) {
+      out += "# TYPE ";
+      out += name;
+      out += ' ';
+      out += type;
+      out += '\n';
+      out += name;
+      out += ' ';
+      out += std::to_string(value);
+      out += '\n';
+    };
+    out += "# TYPE kv_level_files gauge\n";
+    for (int level = 0; level < options_.num_levels; ++level) {
+      out += "kv_level_files{level=\"" + std::to_string(level) + "\"} " +
+             std::to_string(num_tables_at_level(level)) + "\n";
+    }
+    out += "# TYPE kv_level_bytes gauge\n";
+    for (int level = 0; level < options_.num_levels; ++level) {
+      out += "kv_level_bytes{level=\"" + std::to_string(level) + "\"} " + std::to_string(level_bytes(level)) +
+             "\n";
+    }
+    auto [imm_count, imm_bytes] = immutable_memtable_usage();
+    metric("kv_memtable_bytes", "gauge", memtables()->mem->approximate_memory_usage());
+    metric("kv_immutable_memtables", "gauge", imm_count);
+    metric("kv_immutable_memtable_bytes", "gauge", imm_bytes);
+
+    WalStats wal = wal_stats();
+    metric("kv_wal_records_total", "counter", wal.records);
+    metric("kv_wal_bytes_total", "counter", wal.bytes);
+    metric("kv_wal_write_groups_total", "counter", wal.write_groups);
+    metric("kv_wal_syncs_total", "counter", wal.syncs);
+    FlushStats flush = flush_stats();
+    metric("kv_flushes_total", "counter", flush.flushes);
+    metric("kv_flush_bytes_total", "counter", flush.bytes_written);
+    metric("kv_write_stalls_total", "counter", flush.write_stalls);
+    metric("kv_write_stall_seconds_total", "counter", std::chrono::duration<double>(flush.write_stall_time).count());
+    metric("kv_delayed_writes_total", "counter", flush.delayed_writes);
+    metric("kv_write_delay_seconds_total", "counter", std::chrono::duration<double>(flush.write_delay).count());
+    metric("kv_pending_compaction_bytes", "gauge", estimate_pending_compaction_bytes(*versions_->current()));
+    CompactionStats compaction = compaction_stats();
+    metric("kv_compactions_total", "counter", compaction.compactions);
+    metric("kv_compaction_bytes_read_total", "counter", compaction.bytes_read);
+    metric("kv_compaction_bytes_written_total", "counter", compaction.bytes_written);
+    if (options_.min_blob_size > 0) {
+      BlobUsage blobs = blob_usage(*versions_->current());
+      metric("kv_blob_files", "gauge", blobs.files);
+      metric("kv_blob_file_bytes", "gauge", blobs.file_bytes);
+      metric("kv_blob_garbage_bytes", "gauge", blobs.garbage_bytes);
+      metric("kv_blob_bytes_written_total", "counter", flush.blob_bytes_written + compaction.blob_bytes_written);
+      metric("kv_blobs_relocated_total", "counter", compaction.blobs_relocated);
+    }
+    BlockCacheStats cache = block_cache_stats();
+    metric("kv_block_cache_hits_total", "counter", cache.hits);
+    metric("kv_block_cache_misses_total", "counter", cache.misses);
+    metric("kv_block_cache_usage_bytes", "gauge", cache.usage);
+    metric("kv_block_cache_capacity_bytes", "gauge", cache.capacity);
+    if (options_.table_options.use_mmap_reads) {
+      auto [mapped, resident] = mmap_usage();
+      metric("kv_mmap_bytes", "gauge", mapped);
+      metric("kv_mmap_resident_bytes", "gauge", resident);
+    }
+
+    if (Statistics *stats = statistics()) out += stats->ToPrometheus();
+    return out;
+  }
+
+  /**
+   * @brief 写入者队列中的一个等待项
+   *
+   * 每个 put/del 在自己的栈上构造一个 Writer 并排入 writers_。
+   * Leader 代替它完成 WAL 写入与 MemTable 更新后，把 done 置为 true 并唤醒它。
+   */
+  struct Writer {
+    LogType type = LogType::kPut;
+    std::string_view key;               ///< kPut / kDelete 使用，指向调用者的 key
+    std::string_view value;             ///< 仅 kPut 使用，指向调用者的 value
+    const WriteBatch *batch = nullptr;  ///< 仅 kBatch 使用，指向调用者的批次
+    bool force_flush = false;           ///< flush() 使用：不写 WAL，只强制切换 MemTable
+    std::string encoded;                ///< 已编码好的日志记录（在锁外完成编码，序列号由 Leader 回填）
+    SequenceNumber sequence = 0;        ///< 分配给本次写入的首个序列号（批次占用连续的 count() 个）
+    bool done = false;
+    std::exception_ptr error;           ///< Leader 写盘失败时回填的异常
+    std::condition_variable cv;
+  };
+
+  /// 等待落盘的 Immutable MemTable 及其 WAL 段编号
+  struct ImmutableMemTable {
+    std::shared_ptr<MemTable> mem;
+    uint64_t log_number = 0; ///< 冻结时封存的 WAL 段编号，落盘后删除所有编号 <= 它的段（0 表示不删除）
+    SequenceNumber last_sequence = 0; ///< 落盘后写入 MANIFEST 的 LastSequence（0 表示不推进）
+  };
+
+  /// 读请求看到的 MemTable 集合（不可变；持有引用期间其中的 MemTable 不会被释放）
+  struct MemTableSet {
+    std::shared_ptr<MemTable> mem;               ///< 活跃 MemTable
+    std::vector<std::shared_ptr<MemTable>> imms; ///< Immutable MemTable（新 -> 旧）
+  };
+
+  /**
+   * @brief 一次 Compaction 的输入：level 层的若干文件 + output_level 层与之重叠的文件
+   */
+  struct Compaction {
+    int level = 0;
+    int output_level = 1;
+    /// 挑选输入时的 Version：持有它保证输入文件在运行期间不被删除；
+    /// 其中比 output_level 更深的各层用于判断删除标记能否丢弃（只有 Compaction 线程修改它们）
+    std::shared_ptr<const Version> version;
+    Version::FileList inputs;         ///< level 层的输入（L0 时按编号从新到旧）
+    Version::FileList output_inputs;  ///< output_level 层的输入（按 Key 有序；output_level == level 时为空）
+    std::set<uint64_t> gc_blob_files; ///< 失效比例达到阈值的 Blob 文件：其中存活的 Value 搬到新文件
+  };
+
+  /// Compaction 的输出：新 SSTable、新 Blob 文件，以及各 Blob 文件新增的失效记录
+  struct CompactionOutputs {
+    std::vector<FileMetaData> tables;
+    std::vector<BlobFileMetaData> blob_files;
+    std::map<uint64_t, VersionEdit::BlobGarbage> blob_garbage;
+  };
+
+  /**
+   * @brief 写入主流程：排队 -> (成为 Leader) -> 批量写 WAL -> 更新 MemTable -> 唤醒
+   *
+   * 参考 LevelDB 的写入者队列设计：
+   * 1. 写入者加入队尾，若自己不是队首则睡眠，直到被 Leader 完成或自己成为队首。
+   * 2. 队首写入者成为 Leader，先检查 MemTable 是否已满（必要时冻结并切换 WAL），
+   *    再收集从队首开始的一批写入者（受 group_commit_max_bytes 限制），按队列顺序为它们分配
+   *    连续的序列号并封入各自的日志记录，
+   *    在 **不持有锁** 的情况下把整批记录一次写入 WAL，并只 Sync 一次。
+   * 3. 按队列顺序把整批写入应用到 MemTable，保证 MemTable 的更新顺序与 WAL 一致，
+   *    这样崩溃重放得到的状态与崩溃前完全相同；随后发布本批最大的序列号，
+   *    新的快照与迭代器从此能看到这批写入。
+   * 4. 弹出整批写入者并逐个唤醒，最后唤醒新的队首让它成为下一任 Leader。
+   *
+   * kPerWrite 模式下每批只包含 Leader 自己，等价于原先“每次写入都 fsync”的行为。
+   *
+   * @throw std::runtime_error WAL 写入失败时，批次中的每个写入者都会收到该异常，
+   *        并记录 bg_error_，之后的写入全部失败（Fail-Stop）
    */
-  void append_wal(const LogRecord& record) {
-    std::string data = encode_log_record(record);
+  void write_impl(Writer &w) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    writers_.push_back(&w);
+    leader_cv_.notify_one();
+    while (!w.done && &w != writers_.front()) {
+      w.cv.wait(lock);
+    }
+    if (w.done) {
+      if (w.error) std::rethrow_exception(w.error);
+      return;
+    }
+
+    // 当前线程是 Leader：先为本批写入腾出 MemTable 空间（必要时冻结并切换 WAL）
+    uint64_t delayed_write_rate = 0;
+    try {
+      delayed_write_rate = make_room_for_write(lock, w.force_flush);
+    } catch (...) {
+      writers_.pop_front();
+      if (!writers_.empty()) writers_.front()->cv.notify_one();
+      throw;
+    }
+    if (w.force_flush) {
+      writers_.pop_front();
+      if (!writers_.empty()) writers_.front()->cv.notify_one();
+      return;
+    }
+
+    // 组提交模式下可以额外等待一小段时间，让更多写入者进入队列。
+    if (options_.sync_mode == WalSyncMode::kGroupCommit &&
+        options_.group_commit_max_delay.count() > 0) {
+      leader_cv_.wait_for(lock, options_.group_commit_max_delay,
+                          [this] { return queued_bytes() >= options_.group_commit_max_bytes; });
+    }
+
+    // 收集本批次的写入者（遇到 flush 请求即截断，由它在下一轮切换 MemTable）
+    std::vector<Writer *> group;
+    size_t group_bytes = 0;
+    for (Writer *writer : writers_) {
+      if (writer->force_flush) break;
+      if (!group.empty()) {
+        if (options_.sync_mode == WalSyncMode::kPerWrite) break;
+        if (group_bytes + writer->encoded.size() > options_.group_commit_max_bytes) break;
+      }
+      group.push_back(writer);
+      group_bytes += writer->encoded.size();
+    }
 
-    // Step 1: Write to user-space buffer
-    if(std::fwrite(data.data(), 1, data.size(), wal_file_) != data.size()) {
-        throw std::runtime_error("Failed to write to WAL file");
+    // 序列号在持锁时按队列顺序分配，与 WAL 中的记录顺序一致
+    for (Writer *writer : group) {
+      writer->sequence = last_sequence_ + 1;
+      seal_log_record(&writer->encoded, writer->sequence);
+      last_sequence_ += writer->batch ? writer->batch->count() : 1;
     }
+    SequenceNumber group_last_sequence = last_sequence_;
 
-    // Step 2: Flush to kernel buffer
-    if(std::fflush(wal_file_) != 0) {
-        throw std::runtime_error("WAL flush failed");
+    std::string buffer;
+    if (group.size() == 1) {
+      buffer.swap(w.encoded);
+    } else {
+      buffer.reserve(group_bytes);
+      for (Writer *writer : group) buffer.append(writer->encoded);
+    }
+
+    // 活跃段放不下本批记录时先切换到新段（一批记录总是写在同一个段中）
+    std::exception_ptr error;
+    try {
+      uint64_t used = wal_->size();
+      if (used > 0 && used + buffer.size() > wal_segment_size()) roll_wal();
+    } catch (...) {
+      error = std::current_exception();
     }
 
-    // Step 3: Sync to physical disk
-    #ifdef _WIN32
-        // Windows: _commit 强制将句柄关联的缓冲区刷入磁盘
-        if(_commit(_fileno(wal_file_)) != 0) {
-            throw std::runtime_error("WAL commit failed");
+    // 磁盘 I/O 与 MemTable 更新期间释放锁：其他写入者可以继续排队。
+    // Leader 是唯一的写入者（mem_ 只在 Leader 持锁时切换），MemTable 的读者无需任何锁
+    MemTable *mem = mem_.get();
+    lock.unlock();
+
+    // 减速：Leader 按本批的字节数等待，排在后面的写入者随之一起变慢
+    std::chrono::nanoseconds delay(0);
+    if (!error && delayed_write_rate > 0) {
+      delay = write_controller_.GetDelay(buffer.size(), delayed_write_rate);
+      if (delay.count() > 0) {
+        std::this_thread::sleep_for(delay);
+        if (Statistics *stats = statistics()) {
+          stats->Measure(HistogramType::kWriteDelay, static_cast<uint64_t>(delay.count()));
         }
-    #else
-        // Linux/POSIX: fsync 标准接口
-        if(fsync(fileno(wal_file_)) != 0) {
-            throw std::runtime_error("WAL sync (fsync) failed");
+      }
+    }
+    if (!error) {
+      try {
+        append_wal(buffer);
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }
+    if (!error) {
+      try {
+        for (Writer *writer : group) {
+          if (writer->type == LogType::kPut) {
+            mem->add(writer->sequence, ValueType::kValue, writer->key, writer->value);
+          } else if (writer->type == LogType::kDelete) {
+            mem->add(writer->sequence, ValueType::kDeletion, writer->key, std::string_view());
+          } else {
+            apply_batch(*mem, writer->batch->rep(), writer->sequence);
+          }
         }
-    #endif
+        visible_sequence_.store(group_last_sequence, std::memory_order_release);
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }
+    lock.lock();
+    // WAL 写入或同步失败后无法确认哪些记录已落盘：进入 Fail-Stop，之后的写入都会被拒绝
+    if (error) set_bg_error("wal: " + exception_message(error));
+
+    if (delay.count() > 0) {
+      flush_stats_.delayed_writes += 1;
+      flush_stats_.write_delay += delay;
+    }
+    if (!error) {
+      wal_stats_.records += group.size();
+      wal_stats_.bytes += buffer.size();
+      wal_stats_.write_groups += 1;
+      wal_stats_.max_group_size =
+          std::max<uint64_t>(wal_stats_.max_group_size, group.size());
+      if (options_.sync_mode != WalSyncMode::kPeriodic) wal_stats_.syncs += 1;
+    }
+
+    for (Writer *writer : group) {
+      writers_.pop_front();
+      writer->error = error;
+      writer->done = true;
+      if (writer != &w) writer->cv.notify_one();
+    }
+    if (!writers_.empty()) {
+      writers_.front()->cv.notify_one();
+    }
+    if (error) std::rethrow_exception(error);
   }
 
-private:
-  std::filesystem::path data_dir_;       ///< 数据存储根目录
-  std::filesystem::path wal_path_;       ///< WAL 预写日志文件的完整路径
-  SkipList<int, std::string> memtable_{6}; ///< 内存索引结构（跳表），默认最大层数为 6
-  FILE *wal_file_ = nullptr;             ///< WAL 文件句柄 (C-style FILE* for direct sync access)
+  /**
+   * @brief 保证活跃 MemTable 有空间接收新的写入（调用者为 Leader 且持有 mutex_）
+   *
+   * - 达到写入控制器的某个硬限制（L0 文件数 / 待 Compaction 字节数）：等待后台完成工作后重试。
+   * - mem_ 未满：直接返回。
+   * - mem_ 已满且 Immutable 队列未满：冻结 mem_、封存 wal.log，交给后台线程落盘。
+   * - Immutable 队列已满（落盘跟不上写入）：等待后台线程完成一次落盘后重试。
+   *
+   * @param force 为 true 时只要 mem_ 非空就冻结（flush() 使用，不受写入控制器约束）
+   * @return 本批写入的减速速率（字节/秒），0 表示不需要减速
+   * @throw std::runtime_error 后台落盘已失败，或 WAL 切换失败
+   */
+  uint64_t make_room_for_write(std::unique_lock<std::mutex> &lock, bool force) {
+    while (true) {
+      if (!bg_error_.empty()) {
+        throw std::runtime_error("Background work failed: " + bg_error_);
+      }
+      if (!force && write_condition().stopped) {
+        wait_for_background_work(lock);
+        continue;
+      }
+      if (force ? mem_->empty()
+                : mem_->approximate_memory_usage() < options_.memtable_size_limit) {
+        break;
+      }
+      if (imms_.size() >= options_.max_immutable_memtables) {
+        wait_for_background_work(lock);
+        continue;
+      }
+      switch_memtable();
+      break;
+    }
+    return force ? 0 : write_condition().delayed_write_rate;
+  }
+
+  /// 写入阻塞：等待后台线程完成一次落盘或 Compaction（调用者为 Leader 且持有 mutex_）
+  void wait_for_background_work(std::unique_lock<std::mutex> &lock) {
+    flush_stats_.write_stalls += 1;
+    StopWatch stall(statistics(), HistogramType::kWriteStall);
+    auto start = std::chrono::steady_clock::now();
+    bg_cv_.wait(lock);
+    flush_stats_.write_stall_time += std::chrono::steady_clock::now() - start;
+  }
+
+  /// 写入控制器对当前状态的判定
+  struct WriteCondition {
+    bool stopped = false;             ///< 达到某个硬限制，写入必须等待
+    uint64_t delayed_write_rate = 0;  ///< 减速时允许的速率（字节/秒），0 表示不减速
+  };
+
+  /**
+   * @brief 按 Immutable MemTable 数量、L0 文件数与待 Compaction 字节数判定写入状态
+   *       （调用者需持有 mutex_）
+   *
+   * 每个指标的压力为 (值 - 软限制) / (硬限制 - 软限制)，取最大者；允许的速率为
+   * delayed_write_rate * (1 - 压力)，最低为其 1/20。没有硬限制的指标压力恒为 0。
+   * Immutable MemTable 的硬限制由 make_room_for_write 在冻结 MemTable 时检查。
+   */
+  WriteCondition write_condition() const {
+    WriteCondition condition;
+    double pressure = -1.0;  // < 0 表示所有指标都未达到软限制
+    auto check = [&](double value, double soft, double hard, bool can_stop) {
+      if (can_stop && hard > 0 && value >= hard) {
+        condition.stopped = true;
+      } else if (soft > 0 && value >= soft) {
+        pressure = std::max(pressure, hard > soft ? (value - soft) / (hard - soft) : 0.0);
+      }
+    };
+    check(static_cast<double>(imms_.size()), static_cast<double>(options_.immutable_memtables_slowdown_trigger),
+          static_cast<double>(options_.max_immutable_memtables), false);
+
+    std::shared_ptr<const Version> version = versions_->current();
+    if (options_.level0_compaction_trigger > 0) {
+      // 硬限制低于 Compaction 触发值时 L0 永远降不下来，按触发值处理
+      int stop = options_.level0_stop_writes_trigger > 0
+                     ? std::max(options_.level0_stop_writes_trigger, options_.level0_compaction_trigger)
+                     : 0;
+      check(static_cast<double>(version->NumFiles(0)), options_.level0_slowdown_writes_trigger, stop, true);
+    }
+    if (options_.soft_pending_compaction_bytes_limit > 0 || options_.hard_pending_compaction_bytes_limit > 0) {
+      check(static_cast<double>(estimate_pending_compaction_bytes(*version)),
+            static_cast<double>(options_.soft_pending_compaction_bytes_limit),
+            static_cast<double>(options_.hard_pending_compaction_bytes_limit), true);
+    }
+
+    if (!condition.stopped && pressure >= 0) {
+      double rate = static_cast<double>(options_.delayed_write_rate) * (1.0 - std::min(pressure, 0.95));
+      condition.delayed_write_rate = std::max<uint64_t>(static_cast<uint64_t>(rate), 1);
+    }
+    return condition;
+  }
+
+  /**
+   * @brief 估计 version 中等待 Compaction 的字节数
+   *
+   * L0 达到 level0_compaction_trigger 时计入 L0 的总大小，其余各层（最底层除外）计入超出
+   * 目标大小的部分。估计值大于 0 时 pick_compaction_level 一定能选出一层，
+   * 因此按它阻塞的写入总会被后台 Compaction 唤醒。
+   */
+  uint64_t estimate_pending_compaction_bytes(const Version &version) const {
+    if (options_.level0_compaction_trigger <= 0) return 0;
+    uint64_t bytes = 0;
+    if (version.NumFiles(0) >= static_cast<size_t>(options_.level0_compaction_trigger)) {
+      bytes += version.LevelBytes(0);
+    }
+    for (int level = 1; level + 1 < version.NumLevels(); ++level) {
+      double excess = static_cast<double>(version.LevelBytes(level)) - max_bytes_for_level(level);
+      if (excess > 0) bytes += static_cast<uint64_t>(excess);
+    }
+    return bytes;
+  }
+
+  /**
+   * @brief 冻结当前 MemTable 并切换到新的 WAL 段（调用者为 Leader 且持有 mutex_）
+   *
+   * 1. 封存 wal.log（见 roll_wal），封存段的编号即 Immutable MemTable 的 log_number：
+   *    它及更早的段中只有该 MemTable 及更老数据的日志。
+   * 2. mem_ 放入 Immutable 队列，换上新的空 MemTable，通知后台线程。
+   */
+  void switch_memtable() {
+    uint64_t number = roll_wal();
+    imms_.push_back(ImmutableMemTable{mem_, number, mem_->last_sequence()});
+    mem_ = std::make_shared<MemTable>(options_.comparator);
+    install_memtables();
+    bg_cv_.notify_all();
+  }
+
+  /**
+   * @brief 封存活跃 WAL 段并切换到新段（调用者为 Leader 且持有 mutex_）
+   *
+   * 切换顺序：
+   * 1. Sync 并关闭 wal.log（不截断：预分配的零随段一起保留，复用时不必重新分配），
+   *    重命名为 wal_<N>.log。
+   * 2. 有待复用的旧段时把它改名为 wal.log 覆盖写入，否则新建并预分配 wal.log。
+   *
+   * 3. fsync 数据目录，使改名与新建的 wal.log 在新段接收写入之前持久化。
+   *
+   * 重命名是原子操作：崩溃后启动时，封存段与 wal.log 会按编号顺序被重放。
+   * 段在 MemTable 中途写满时同样调用本函数，此时封存段仍属于活跃的 MemTable，
+   * 它的编号小于该 MemTable 冻结时的编号，随之一起在落盘后删除或复用。
+   *
+   * 任何一步失败都记录 bg_error_（Fail-Stop）：wal.log 可能已被关闭或改名，不能继续写入。
+   *
+   * @return 封存段的编号
+   */
+  uint64_t roll_wal() {
+    uint64_t number = versions_->NewFileNumber();
+    bool reuse = !recycled_logs_.empty();
+    try {
+      std::lock_guard<std::mutex> wal_lock(wal_mutex_);
+      sync_wal();
+      wal_->close(/*truncate=*/false);
+      std::filesystem::rename(wal_path_, data_dir_ / wal_segment_name(number));
+      if (reuse) {
+        std::filesystem::rename(data_dir_ / recycled_wal_name(recycled_logs_.front()), wal_path_);
+        recycled_logs_.pop_front();
+      }
+      wal_ = std::make_unique<WalWriter>(wal_path_, 0, reuse, wal_writer_options());
+      sync_directory(data_dir_);
+    } catch (const std::exception &e) {
+      set_bg_error(std::string("wal: ") + e.what());
+      throw;
+    }
+    sealed_logs_.push_back(number);
+    wal_stats_.segments += 1;
+    if (reuse) wal_stats_.recycled_segments += 1;
+    return number;
+  }
+
+  /// 单个 WAL 段的大小上限（wal_segment_size 为 0 时取 memtable_size_limit 的 9/8）
+  uint64_t wal_segment_size() const {
+    if (options_.wal_segment_size > 0) return options_.wal_segment_size;
+    uint64_t limit = options_.memtable_size_limit;
+    return limit + limit / 8;
+  }
+
+  WalWriterOptions wal_writer_options() const {
+    WalWriterOptions wal_options;
+    wal_options.preallocate_size = options_.wal_preallocate ? wal_segment_size() : 0;
+    wal_options.direct_io = options_.wal_direct_io;
+    return wal_options;
+  }
+
+  /**
+   * @brief 按 mem_ / imms_ 重建 MemTable 集合的快照并发布给读请求
+   *       （调用者需持有 mutex_ 或处于构造阶段）
+   */
+  void install_memtables() {
+    auto set = std::make_shared<MemTableSet>();
+    set->mem = mem_;
+    set->imms.reserve(imms_.size());
+    for (auto it = imms_.rbegin(); it != imms_.rend(); ++it) set->imms.push_back(it->mem);
+    std::lock_guard<std::mutex> lock(memtables_mutex_);
+    memtables_ = std::move(set);
+  }
+
+  /// 当前 MemTable 集合的快照（只在复制指针时短暂持有 memtables_mutex_）
+  std::shared_ptr<const MemTableSet> memtables() const {
+    std::lock_guard<std::mutex> lock(memtables_mutex_);
+    return memtables_;
+  }
+
+  /**
+   * @brief 按从新到旧的顺序查询快照中的所有 MemTable（无锁，可与写入并发）
+   *
+   * @param snapshot 只查看序列号不大于它的版本
+   * @param value [out] kFound 时指向命中的 MemTable 中的值，并钉住该 MemTable
+   * @return 第一个包含该 key 可见版本的 MemTable 的查询结果；都没有时返回 kNotFound
+   */
+  static MemTable::LookupResult lookup_memtables(const MemTableSet &set, std::string_view key,
+                                                 SequenceNumber snapshot, PinnableValue *value) {
+    std::string_view view;
+    MemTable::LookupResult result = set.mem->get(key, &view, snapshot);
+    if (result == MemTable::LookupResult::kFound) value->pin(view, set.mem);
+    for (auto it = set.imms.begin();
+         result == MemTable::LookupResult::kNotFound && it != set.imms.end(); ++it) {
+      result = (*it)->get(key, &view, snapshot);
+      if (result == MemTable::LookupResult::kFound) value->pin(view, *it);
+    }
+    return result;
+  }
+
+  /**
+   * @brief 按从新到旧的顺序查询 version 中 Key 范围包含 key 的 SSTable，
+   *        命中值或删除标记即停止
+   *
+   * L0 的文件可能互相重叠，按编号从新到旧逐个检查；L1 及更深的层内文件互不重叠，
+   * 二分查找至多命中一个文件。越新的文件中版本的序列号越大，第一个含可见版本的文件即为答案。
+   *
+   * @param snapshot 只查看序列号不大于它的版本
+   * @param value [out] 命中值时指向 Data Block 中的值（已去掉类型字节），并钉住该 Block；
+   *        命中 BlobIndex 时指向从 Blob 文件读出的值
+   * @param stats 非空时记录各文件 Bloom Filter 的判定结果
+   * @param resolve_blob 为 false 时命中 BlobIndex 不读取 Blob 文件（value 指向 BlobIndex 本身）
+   * @return true 命中值，false 未命中或命中删除标记
+   */
+  static bool lookup_tables(std::string_view key, SequenceNumber snapshot, const Version &version,
+                            PinnableValue *value, Statistics *stats = nullptr, bool resolve_blob = true) {
+    for (const TableFile *file : version.FilesForKey(key)) {
+      ValueType type;
+      if (!file->Reader()->GetVisible(key, snapshot, &type, value, stats)) continue;
+      if (type == ValueType::kDeletion) {
+        value->reset();
+        return false;
+      }
+      if (type == ValueType::kBlobIndex && resolve_blob) {
+        std::shared_ptr<const std::string> blob = read_blob(version, key, value->view());
+        value->pin(*blob, blob);
+      }
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief 读取 BlobIndex 指向的 Value
+   *
+   * @throw std::runtime_error BlobIndex 损坏、Blob 文件不在 version 中或读取失败
+   */
+  static std::shared_ptr<const std::string> read_blob(const Version &version, std::string_view user_key,
+                                                      std::string_view blob_index, bool fill_cache = true) {
+    BlobIndex index;
+    if (!index.Decode(blob_index)) {
+      throw std::runtime_error("Malformed blob index for key of size " + std::to_string(user_key.size()));
+    }
+    const BlobFile *file = version.FindBlobFile(index.file_number);
+    if (file == nullptr) {
+      throw std::runtime_error("Blob file referenced by SSTable is missing: " +
+                               blob_file_name(index.file_number));
+    }
+    return file->Get(index, user_key, fill_cache);
+  }
+
+  /**
+   * @brief key 当前是否可见（del 的返回值；在加入写入队列之前调用，无需持有 mutex_）
+   */
+  bool is_visible(std::string_view key) const {
+    PinnableValue value;
+    switch (lookup_memtables(*memtables(), key, kMaxSequenceNumber, &value)) {
+      case MemTable::LookupResult::kFound: return true;
+      case MemTable::LookupResult::kDeleted: return false;
+      case MemTable::LookupResult::kNotFound: break;
+    }
+    return lookup_tables(key, kMaxSequenceNumber, *versions_->current(), &value, nullptr,
+                         /*resolve_blob=*/false);
+  }
+
+  /**
+   * @brief 落盘与 Compaction 必须保留的最老版本边界：最老的存活快照，没有快照时为已发布的序列号
+   *
+   * 已发布的序列号单调递增，之后创建的快照与隐式快照都不会小于返回值，
+   * 因此被一个序列号不大于它的新版本遮蔽的旧版本可以安全丢弃。
+   */
+  SequenceNumber smallest_snapshot() const {
+    std::lock_guard<std::mutex> lock(snapshots_mutex_);
+    return snapshots_.empty() ? visible_sequence_.load(std::memory_order_acquire)
+                              : snapshots_.oldest()->sequence();
+  }
+
+  /**
+   * @brief 后台落盘线程主循环
+   *
+   * 每次取出最老的 Immutable MemTable，在 **不持有锁** 的情况下写成 L0 SSTable，
+   * 并把“新增该文件 + 对应 WAL 段已落盘”作为一条 VersionEdit 写入 MANIFEST、安装新 Version；
+   * 完成后重新加锁把它移出队列（新 Version 先于出队可见，读请求不会看到数据“消失”的空窗），
+   * 最后删除已失效的 WAL 段。
+   * 落盘失败时记录 bg_error_，之后的写入都会失败（Fail-Stop），数据仍保存在 WAL 段中。
+   */
+  void background_flush_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      bg_cv_.wait(lock, [this] {
+        return shutting_down_ || (!imms_.empty() && bg_error_.empty());
+      });
+      if (shutting_down_) break;
+
+      ImmutableMemTable imm = imms_.front();
+      lock.unlock();
+
+      std::optional<FileMetaData> file;
+      std::vector<BlobFileMetaData> blobs;
+      uint64_t entries = 0;
+      std::string error;
+      try {
+        StopWatch timer(statistics(), HistogramType::kFlush);
+        file = write_level0_table(*imm.mem, versions_->NewFileNumber(), smallest_snapshot(), &entries, &blobs);
+        VersionEdit edit;
+        for (const BlobFileMetaData &blob : blobs) edit.AddBlobFile(blob);
+        if (file.has_value()) edit.AddFile(0, *file);
+        edit.SetLogNumber(imm.log_number);
+        edit.SetLastSequence(imm.last_sequence);
+        versions_->LogAndApply(&edit);
+      } catch (const std::exception &e) {
+        error = e.what();
+      }
+
+      lock.lock();
+      if (!error.empty()) {
+        bg_error_ = error;
+        std::cerr << "[Flush] Failed to write L0 table: " << error << std::endl;
+      } else {
+        if (file.has_value()) {
+          flush_stats_.flushes += 1;
+          flush_stats_.entries += entries;
+          flush_stats_.bytes_written += file->file_size;
+          for (const BlobFileMetaData &blob : blobs) flush_stats_.blob_bytes_written += blob.file_size;
+        }
+        imms_.pop_front();
+        install_memtables();
+        remove_obsolete_logs(imm.log_number);
+      }
+      bg_cv_.notify_all();
+    }
+  }
+
+  /**
+   * @brief 将一个 Immutable MemTable 写成 L0 SSTable（不持有锁）
+   *
+   * 先写入 <name>.tmp，Finish() 完成 fsync 后再原子重命名为正式文件名，
+   * 保证目录中可见的 SSTable 一定是完整的；改名后 fsync 目录，MANIFEST 登记它、
+   * WAL 段随之回收之前，新文件的目录项已经持久化。空 MemTable 不生成文件。
+   * 表中保存内部 Key；同一个 Key 的旧版本若已被一个序列号不大于 smallest_snapshot 的
+   * 新版本遮蔽，任何快照都读不到它，直接丢弃。
+   * min_blob_size > 0 时，不小于它的 Value 写入 Blob 文件（先于 SSTable 完成 fsync），
+   * 表中保存 kBlobIndex 条目。
+   *
+   * @param smallest_snapshot 最老的存活快照（没有快照时为已发布的序列号）
+   * @param blobs [out] 新写出的 Blob 文件（由调用者与 SSTable 一起登记到 MANIFEST）
+   * @return 新表的元数据；MemTable 为空时返回 std::nullopt
+   */
+  std::optional<FileMetaData> write_level0_table(const MemTable &mem, uint64_t number,
+                                                 SequenceNumber smallest_snapshot, uint64_t *entries,
+                                                 std::vector<BlobFileMetaData> *blobs) {
+    std::filesystem::path final_path = data_dir_ / table_file_name(0, number);
+    std::filesystem::path tmp_path = final_path;
+    tmp_path += ".tmp";
+
+    uint64_t count = 0;
+    FileMetaData file;
+    file.number = number;
+    BlobWriter blob_writer(data_dir_, versions_.get(), options_.blob_file_size);
+    {
+      SSTableBuilder builder(tmp_path.string(), table_options_for_level(0));
+      std::string internal_key;
+      SequenceNumber last_sequence = kMaxSequenceNumber;  // 当前 Key 上一个写出的版本
+      mem.for_each([&](std::string_view key, const MemTable::Entry &entry) {
+        if (count == 0 || options_.comparator->Compare(key, file.largest) != 0) {
+          last_sequence = kMaxSequenceNumber;
+        } else if (last_sequence <= smallest_snapshot) {
+          return;  // 被更新且对所有快照可见的版本遮蔽
+        }
+        last_sequence = entry.sequence;
+        file.largest.assign(key);
+        if (count == 0) file.smallest = file.largest;
+        internal_key.clear();
+        if (separate_value(entry.type, entry.value)) {
+          append_internal_key(internal_key, key, entry.sequence, ValueType::kBlobIndex);
+          builder.Add(internal_key, blob_writer.add(key, entry.value).Encode());
+        } else {
+          append_internal_key(internal_key, key, entry.sequence, entry.type);
+          builder.Add(internal_key, entry.value);
+        }
+        ++count;
+      });
+      blob_writer.finish();
+      builder.Finish();
+      file.file_size = builder.FileSize();
+    }
+
+    *blobs = blob_writer.files();
+    for (const BlobFileMetaData &blob : *blobs) file.blob_files.push_back(blob.number);
+    if (count == 0) {
+      std::filesystem::remove(tmp_path);
+      *entries = 0;
+      return std::nullopt;
+    }
+    std::filesystem::rename(tmp_path, final_path);
+    sync_directory(data_dir_);
+    *entries = count;
+    return file;
+  }
+
+  /// 该条目的值落盘时是否写入 Blob 文件
+  bool separate_value(ValueType type, std::string_view value) const {
+    return type == ValueType::kValue && options_.min_blob_size > 0 && value.size() >= options_.min_blob_size;
+  }
+
+  /**
+   * @brief 落盘 / Compaction 输出的 Blob 文件（写满 blob_file_size 后切换到新文件）
+   *
+   * 与 SSTable 相同，每个文件先写成 <name>.tmp，finish() 完成 fsync 后重命名为正式文件名，
+   * 再 fsync 目录，MANIFEST 引用它之前目录项已经持久化；
+   * 引用它们的 SSTable 登记到 MANIFEST 之前崩溃时，重启后作为未引用文件删除。
+   */
+  class BlobWriter {
+  public:
+    BlobWriter(std::filesystem::path dir, VersionSet *versions, uint64_t file_size_limit)
+        : dir_(std::move(dir)), versions_(versions), file_size_limit_(file_size_limit) {}
+
+    /// 追加一个 Value，返回指向它的 BlobIndex
+    BlobIndex add(std::string_view user_key, std::string_view value) {
+      if (builder_ && builder_->FileSize() >= file_size_limit_) finish();
+      if (!builder_) {
+        uint64_t number = versions_->NewFileNumber();
+        numbers_.push_back(number);
+        builder_ = std::make_unique<BlobFileBuilder>(tmp_path(number).string(), number);
+      }
+      return builder_->Add(user_key, value);
+    }
+
+    /// 完成当前文件：fsync、重命名为正式文件名并 fsync 目录
+    void finish() {
+      if (!builder_) return;
+      builder_->Finish();
+      BlobFileMetaData meta{builder_->Number(), builder_->FileSize(), builder_->BlobCount(),
+                            builder_->BlobBytes()};
+      builder_.reset();
+      std::filesystem::rename(tmp_path(meta.number), dir_ / blob_file_name(meta.number));
+      sync_directory(dir_);
+      files_.push_back(meta);
+    }
+
+    /// 删除已写出的所有文件（失败或中止时）
+    void remove_files() {
+      builder_.reset();
+      for (uint64_t number : numbers_) {
+        std::error_code ec;
+        std::filesystem::remove(tmp_path(number), ec);
+        std::filesystem::remove(dir_ / blob_file_name(number), ec);
+      }
+      files_.clear();
+    }
+
+    /// 当前正在写入的文件编号（没有时为 0）
+    uint64_t current_number() const { return builder_ ? builder_->Number() : 0; }
+
+    /// 当前文件已写入的字节数
+    uint64_t current_file_size() const { return builder_ ? builder_->FileSize() : 0; }
+
+    /// 已完成的文件
+    const std::vector<BlobFileMetaData> &files() const { return files_; }
+
+  private:
+    std::filesystem::path dir_;
+    VersionSet *versions_;
+    uint64_t file_size_limit_;
+    std::unique_ptr<BlobFileBuilder> builder_;
+    std::vector<uint64_t> numbers_;
+    std::vector<BlobFileMetaData> files_;
+
+    std::filesystem::path tmp_path(uint64_t number) const {
+      std::filesystem::path path = dir_ / blob_file_name(number);
+      path += ".tmp";
+      return path;
+    }
+  };
+
+  /**
+   * @brief 构建第 level 层 SSTable 使用的选项（按 compression_per_level 选择压缩算法）
+   */
+  TableOptions table_options_for_level(int level) const {
+    TableOptions table_options = options_.table_options;
+    const auto &per_level = options_.compression_per_level;
+    if (!per_level.empty()) {
+      size_t index = std::min(static_cast<size_t>(level), per_level.size() - 1);
+      table_options.compression = per_level[index];
+    }
+    return table_options;
+  }
+
+  /**
+   * @brief 回收所有编号 <= log_number 的封存 WAL 段（调用者需持有 mutex_）
+   *
+   * 待复用的段不足 wal_recycle_limit 个时改名为 wal_<N>.recycle 留待 roll_wal 复用，否则删除。
+   * 动手之前先 fsync 数据目录：确保取代这些段的 SSTable 与 MANIFEST 的目录项已经持久化，
+   * 否则崩溃后可能既找不到新文件、也没有 WAL 可以重放。目录同步失败时保留这些段，下次再回收。
+   */
+  void remove_obsolete_logs(uint64_t log_number) {
+    if (sealed_logs_.empty() || sealed_logs_.front() > log_number) return;
+    try {
+      sync_directory(data_dir_);
+    } catch (const std::exception &e) {
+      std::cerr << "[Flush] Failed to sync data directory, keeping WAL segments: " << e.what()
+                << std::endl;
+      return;
+    }
+    auto it = sealed_logs_.begin();
+    while (it != sealed_logs_.end() && *it <= log_number) {
+      std::filesystem::path path = data_dir_ / wal_segment_name(*it);
+      std::error_code ec;
+      if (recycled_logs_.size() < options_.wal_recycle_limit) {
+        std::filesystem::rename(path, data_dir_ / recycled_wal_name(*it), ec);
+        if (!ec) recycled_logs_.push_back(*it);
+      } else {
+        std::filesystem::remove(path, ec);
+      }
+      if (ec) {
+        std::cerr << "[Flush] Failed to recycle WAL segment " << *it << ": " << ec.message()
+                  << std::endl;
+      }
+      it = sealed_logs_.erase(it);
+    }
+  }
+
+  /**
+   * @brief 启动时恢复文件集合（仅在构造阶段调用）
+   *
+   * 1. 从 CURRENT 指向的 MANIFEST 重放 VersionEdit，得到文件集合与已落盘的 WAL 段编号。
+   * 2. 列出数据目录：删除上次崩溃遗留的 *.tmp 文件，收集封存的 WAL 段（升序），
+   *    并登记所有已用的文件编号，保证之后分配的编号不会与之冲突。
+   * 3. 若目录没有 MANIFEST（旧版本创建），改为打开每个 SSTable 读出 Key 范围（见 scan_tables）。
+   * 4. 写入新的 MANIFEST（首条记录为完整快照）并切换 CURRENT，删除旧的 MANIFEST。
+   * 5. 删除 MANIFEST 未引用的 SSTable 与 Blob 文件（落盘 / Compaction 写完但未登记，
+   *    或已淘汰但未来得及删除），以及编号 <= LogNumber 的 WAL 段（其数据已全部落盘，回收为待复用的段）。
+   *
+   * @throw std::runtime_error MANIFEST 损坏、引用的 SSTable 或 Blob 文件缺失，或层号超出 num_levels
+   */
+  void recover_versions() {
+    auto start = std::chrono::steady_clock::now();
+    bool has_manifest = versions_->Recover(&recovery_stats_.manifest_edits);
+
+    std::vector<std::pair<int, uint64_t>> tables;
+    std::set<uint64_t> table_numbers;
+    std::set<uint64_t> blob_numbers;
+    for (const auto &entry : std::filesystem::directory_iterator(data_dir_)) {
+      if (!entry.is_regular_file()) continue;
+      std::string name = entry.path().filename().string();
+      uint64_t number = 0;
+      int level = 0;
+      if (entry.path().extension() == ".tmp") {
+        std::error_code ec;
+        std::filesystem::remove(entry.path(), ec);
+      } else if (parse_wal_segment_name(name, &number)) {
+        sealed_logs_.push_back(number);
+        versions_->MarkFileNumberUsed(number);
+      } else if (parse_recycled_wal_name(name, &number)) {
+        if (recycled_logs_.size() < options_.wal_recycle_limit) {
+          recycled_logs_.push_back(number);
+        } else {
+          std::error_code ec;
+          std::filesystem::remove(entry.path(), ec);
+        }
+        versions_->MarkFileNumberUsed(number);
+      } else if (parse_table_file_name(name, &level, &number)) {
+        tables.emplace_back(level, number);
+        table_numbers.insert(number);
+        versions_->MarkFileNumberUsed(number);
+      } else if (parse_blob_file_name(name, &number)) {
+        blob_numbers.insert(number);
+        versions_->MarkFileNumberUsed(number);
+      } else if (parse_manifest_file_name(name, &number)) {
+        versions_->MarkFileNumberUsed(number);
+      }
+    }
+    std::sort(sealed_logs_.begin(), sealed_logs_.end());
+
+    VersionEdit edit;
+    if (has_manifest) {
+      std::shared_ptr<const Version> version = versions_->current();
+      for (int level = 0; level < version->NumLevels(); ++level) {
+        for (const auto &file : version->Files(level)) {
+          if (table_numbers.count(file->Number()) == 0) {
+            throw std::runtime_error("SSTable referenced by MANIFEST is missing: " +
+                                     file->Path().string());
+          }
+        }
+      }
+      for (const auto &[number, blob] : version->BlobFiles()) {
+        if (blob_numbers.count(number) == 0) {
+          throw std::runtime_error("Blob file referenced by MANIFEST is missing: " +
+                                   blob.file->Path().string());
+        }
+      }
+    } else {
+      scan_tables(tables, &edit);
+    }
+    versions_->NewManifest(edit);
+
+    std::shared_ptr<const Version> version = versions_->current();
+    for (const auto &[level, number] : tables) {
+      bool referenced = level < version->NumLevels() &&
+                        std::any_of(version->Files(level).begin(), version->Files(level).end(),
+                                    [number = number](const auto &file) {
+                                      return file->Number() == number;
+                                    });
+      if (!referenced) {
+        std::cout << "[KVStore] Removing unreferenced table " << table_file_name(level, number)
+                  << std::endl;
+        std::error_code ec;
+        std::filesystem::remove(data_dir_ / table_file_name(level, number), ec);
+      }
+    }
+    for (uint64_t number : blob_numbers) {
+      if (version->FindBlobFile(number) == nullptr) {
+        std::cout << "[KVStore] Removing unreferenced blob file " << blob_file_name(number) << std::endl;
+        std::error_code ec;
+        std::filesystem::remove(data_dir_ / blob_file_name(number), ec);
+      }
+    }
+    for (const auto &entry : std::filesystem::directory_iterator(data_dir_)) {
+      uint64_t number = 0;
+      if (parse_manifest_file_name(entry.path().filename().string(), &number) &&
+          number != versions_->ManifestNumber()) {
+        std::error_code ec;
+        std::filesystem::remove(entry.path(), ec);
+      }
+    }
+    remove_obsolete_logs(versions_->LogNumber());
+
+    recovery_stats_.tables = version->TotalFiles();
+    recovery_stats_.manifest_elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << "[Recovery] " << (has_manifest ? "Loaded MANIFEST: " : "Migrated to MANIFEST: ")
+              << recovery_stats_.tables << " tables, " << recovery_stats_.manifest_edits
+              << " edits in " << static_cast<double>(recovery_stats_.manifest_elapsed.count()) / 1e6
+              << " ms" << std::endl;
+  }
+
+  /**
+   * @brief 旧版本目录（没有 MANIFEST）的迁移：打开每个 SSTable 读出 Key 范围，登记到 edit
+   *
+   * 旧版本没有 MANIFEST，Compaction 安装输出后按顺序删除输入。L1 及更深的层内若有文件
+   * 与更新（编号更大）的文件重叠，说明它是已安装输出、但尚未来得及删除的输入，
+   * 其数据已全部包含在新文件中，不予登记（随后作为未引用文件删除）。空表同样不登记。
+   * 表中最大的序列号记为 LastSequence，否则恢复后的读序列号会低于表中的条目而读不到它们。
+   *
+   * @throw std::runtime_error 文件的层号超出 num_levels，或 SSTable 无法打开
+   */
+  void scan_tables(const std::vector<std::pair<int, uint64_t>> &tables, VersionEdit *edit) const {
+    const Comparator *cmp = options_.comparator;
+    std::vector<std::vector<FileMetaData>> levels(static_cast<size_t>(options_.num_levels));
+    SequenceNumber max_sequence = 0;
+    for (const auto &[level, number] : tables) {
+      if (level >= options_.num_levels) {
+        throw std::runtime_error("SSTable level exceeds num_levels: " +
+                                 table_file_name(level, number));
+      }
+      std::optional<FileMetaData> file =
+          open_table(data_dir_ / table_file_name(level, number), number, &max_sequence);
+      if (file.has_value()) levels[static_cast<size_t>(level)].push_back(std::move(*file));
+    }
+
+    for (size_t level = 0; level < levels.size(); ++level) {
+      auto &files = levels[level];
+      std::sort(files.begin(), files.end(),
+                [](const FileMetaData &a, const FileMetaData &b) { return a.number > b.number; });
+      std::vector<FileMetaData> kept;
+      for (FileMetaData &file : files) {
+        bool overlaps = level > 0 &&
+                        std::any_of(kept.begin(), kept.end(), [&](const FileMetaData &newer) {
+                          return cmp->Compare(file.smallest, newer.largest) <= 0 &&
+                                 cmp->Compare(newer.smallest, file.largest) <= 0;
+                        });
+        if (!overlaps) kept.push_back(std::move(file));
+      }
+      for (FileMetaData &file : kept) edit->AddFile(static_cast<int>(level), std::move(file));
+    }
+    edit->SetLastSequence(max_sequence);
+  }
+
+  /**
+   * @brief 打开一个已存在的 SSTable 并读出其元数据（Key 范围与文件大小）
+   *
+   * @param max_sequence 非空时扫描整张表，把其中最大的序列号合并进去（旧格式的表没有序列号）
+   * @return 表为空时返回 std::nullopt
+   */
+  std::optional<FileMetaData> open_table(const std::filesystem::path &path, uint64_t number,
+                                         SequenceNumber *max_sequence = nullptr) const {
+    SSTableReader reader(path.string(), options_.table_options);
+    if (reader.NumBlocks() == 0) return std::nullopt;
+
+    SSTableReader::Iterator it(reader, /*fill_cache=*/false);
+    it.SeekToFirst();
+    if (!it.Valid()) return std::nullopt;
+    FileMetaData file;
+    file.number = number;
+    file.file_size = reader.FileSize();
+    std::string_view largest = reader.Index()->back().last_key;
+    if (reader.HasInternalKeys()) {
+      file.smallest.assign(extract_user_key(it.key()));
+      file.largest.assign(extract_user_key(largest));
+      for (; max_sequence != nullptr && it.Valid(); it.Next()) {
+        ParsedInternalKey parsed;
+        if (parse_internal_key(it.key(), &parsed)) *max_sequence = std::max(*max_sequence, parsed.sequence);
+      }
+    } else {
+      file.smallest.assign(it.key());
+      file.largest.assign(largest);
+    }
+    return file;
+  }
+
+  /// 第 level 层（>= 1）的目标大小
+  double max_bytes_for_level(int level) const {
+    double bytes = static_cast<double>(options_.max_bytes_for_level_base);
+    for (int i = 1; i < level; ++i) bytes *= options_.max_bytes_for_level_multiplier;
+    return bytes;
+  }
+
+  /**
+   * @brief 计算 version 中最需要 Compaction 的层及其分数
+   *
+   * L0 的分数为文件数 / level0_compaction_trigger（L0 文件互相重叠，每个都要在读路径上检查，
+   * 按文件数衡量比按字节数更合理）；其他层为总大小 / 目标大小。最底层不参与。
+   *
+   * @return 分数 >= 1 的最高分层；没有时返回 -1
+   */
+  int pick_compaction_level(const Version &version) const {
+    if (options_.level0_compaction_trigger <= 0) return -1;
+    int best_level = -1;
+    double best_score = 1.0;
+    double score = static_cast<double>(version.NumFiles(0)) / options_.level0_compaction_trigger;
+    if (score >= best_score) {
+      best_level = 0;
+      best_score = score;
+    }
+    for (int level = 1; level + 1 < version.NumLevels(); ++level) {
+      score = static_cast<double>(version.LevelBytes(level)) / max_bytes_for_level(level);
+      if (score >= best_score) {
+        best_level = level;
+        best_score = score;
+      }
+    }
+    return best_level;
+  }
+
+  /**
+   * @brief 挑选一个引用了待 GC Blob 文件的 SSTable（自动 Compaction 开启时）
+   *
+   * 取失效比例最高且达到 blob_garbage_collection_ratio 的 Blob 文件，返回第一个引用它的
+   * SSTable（从 L0 开始逐层查找）。重写该表会把它引用的存活 Value 搬到新文件，
+   * 表中不再引用旧文件；旧文件不再被任何表引用后删除，因此反复挑选一定会结束。
+   *
+   * @return 没有需要 GC 的 Blob 文件时返回空
+   */
+  std::shared_ptr<TableFile> pick_blob_gc_input(const Version &version) const {
+    if (!options_.enable_blob_garbage_collection || options_.level0_compaction_trigger <= 0) return nullptr;
+    uint64_t target = 0;
+    double best_ratio = options_.blob_garbage_collection_ratio;
+    for (const auto &[number, blob] : version.BlobFiles()) {
+      if (blob.GarbageRatio() >= best_ratio) {
+        target = number;
+        best_ratio = blob.GarbageRatio();
+      }
+    }
+    if (target == 0) return nullptr;
+    for (int level = 0; level < version.NumLevels(); ++level) {
+      for (const auto &file : version.Files(level)) {
+        const std::vector<uint64_t> &refs = file->Meta().blob_files;
+        if (std::binary_search(refs.begin(), refs.end(), target)) return file;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief 用 level 层的输入补全一次 Compaction
+   *
+   * 计算输入的 Key 范围，收集 output_level 层与之重叠的文件（output_level == level 时为
+   * 单个文件的原地重写，不收集），并记下需要 GC 的 Blob 文件。
+   */
+  Compaction setup_compaction(std::shared_ptr<const Version> version, int level, int output_level,
+                              Version::FileList inputs) const {
+    Compaction c;
+    c.level = level;
+    c.output_level = output_level;
+    const Comparator *cmp = version->comparator();
+    std::string smallest = inputs.front()->Smallest();
+    std::string largest = inputs.front()->Largest();
+    for (const auto &file : inputs) {
+      if (cmp->Compare(file->Smallest(), smallest) < 0) smallest = file->Smallest();
+      if (cmp->Compare(file->Largest(), largest) > 0) largest = file->Largest();
+    }
+    c.inputs = std::move(inputs);
+    if (output_level != level) c.output_inputs = version->OverlappingFiles(output_level, smallest, largest);
+    if (options_.enable_blob_garbage_collection) {
+      for (const auto &[number, blob] : version->BlobFiles()) {
+        if (blob.GarbageRatio() >= options_.blob_garbage_collection_ratio) c.gc_blob_files.insert(number);
+      }
+    }
+    c.version = std::move(version);
+    return c;
+  }
+
+  /**
+   * @brief 挑选下一次自动 Compaction（调用者需持有 mutex_）
+   *
+   * - L0：所有 L0 文件（它们互相重叠，必须一起下沉才能保持 L1 内部有序）。
+   * - 其他层：按 compact_pointer_ 轮转，选上次合并位置之后的第一个文件，
+   *   使整层的 Key 空间被均匀地逐步合并。
+   * - 没有层需要 Compaction 时，为需要 GC 的 Blob 文件安排一次（见 pick_blob_gc_input）。
+   */
+  std::optional<Compaction> pick_compaction() {
+    std::shared_ptr<const Version> version = versions_->current();
+    int level = pick_compaction_level(*version);
+    if (level < 0) {
+      std::shared_ptr<TableFile> file = pick_blob_gc_input(*version);
+      if (!file) return std::nullopt;
+      if (file->Level() == 0) {
+        Version::FileList inputs(version->Files(0).rbegin(), version->Files(0).rend());
+        return setup_compaction(std::move(version), 0, 1, std::move(inputs));
+      }
+      int file_level = file->Level();
+      return setup_compaction(std::move(version), file_level, file_level, {std::move(file)});
+    }
+
+    const auto &files = version->Files(level);
+    Version::FileList inputs;
+    if (level == 0) {
+      inputs.assign(files.rbegin(), files.rend());  // 从新到旧
+    } else {
+      // 指针为空表示该层还没有做过 Compaction，从第一个文件开始
+      const std::string &pointer = compact_pointer_[static_cast<size_t>(level)];
+      const Comparator *cmp = options_.comparator;
+      auto it = std::find_if(files.begin(), files.end(), [&](const auto &file) {
+        return pointer.empty() || cmp->Compare(file->Largest(), pointer) > 0;
+      });
+      if (it == files.end()) it = files.begin();
+      inputs.push_back(*it);
+      compact_pointer_[static_cast<size_t>(level)] = (*it)->Largest();
+    }
+    return setup_compaction(std::move(version), level, level + 1, std::move(inputs));
+  }
+
+  /**
+   * @brief 挑选手动全量 Compaction 的下一步
+   *
+   * 取最浅的非空层 L，把它的全部文件合并到其下方第一个非空层（没有时为 L + 1，
+   * 且 L0 至少下沉到 L1）。所有数据都位于同一层（L >= 1）时完成。
+   */
+  std::optional<Compaction> pick_manual_compaction() const {
+    std::shared_ptr<const Version> version = versions_->current();
+    int num_levels = version->NumLevels();
+    int level = 0;
+    while (level < num_levels && version->NumFiles(level) == 0) ++level;
+    if (level == num_levels) return std::nullopt;
+
+    int output_level = level + 1;
+    while (output_level < num_levels && version->NumFiles(output_level) == 0) ++output_level;
+    if (output_level == num_levels) {
+      if (level > 0) return std::nullopt;  // 只剩一层
+      output_level = 1;
+    }
+
+    Version::FileList inputs = version->Files(level);
+    if (level == 0) std::reverse(inputs.begin(), inputs.end());
+    return setup_compaction(std::move(version), level, output_level, std::move(inputs));
+  }
+
+  /**
+   * @brief 更深的层中是否可能存在 key（决定删除标记能否丢弃）
+   */
+  static bool key_in_deeper_levels(const Compaction &c, std::string_view key) {
+    for (int level = c.output_level + 1; level < c.version->NumLevels(); ++level) {
+      if (c.version->FindFile(level, key) != nullptr) return true;
+    }
+    return false;
+  }
+
+  /// version 中是否有自动 Compaction 可做（某层超出目标，或有 Blob 文件需要 GC）
+  bool has_compaction_work(const Version &version) const {
+    return pick_compaction_level(version) >= 0 || pick_blob_gc_input(version) != nullptr;
+  }
+
+  /**
+   * @brief 后台 Compaction 线程主循环
+   *
+   * 在锁内挑选输入，在 **不持有锁** 的情况下归并、写出新文件并写入 MANIFEST，
+   * 最后重新加锁更新统计。落盘线程可以与 Compaction 并发运行：期间新生成的 L0 文件
+   * 不属于本次输入，它们比输出更新，仍留在 L0 中优先被读取。
+   * Compaction 失败时记录 bg_error_（Fail-Stop），输入文件保持不变。
+   */
+  void background_compaction_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      bg_cv_.wait(lock, [this] {
+        return shutting_down_ ||
+               (bg_error_.empty() &&
+                (manual_compaction_ || has_compaction_work(*versions_->current())));
+      });
+      if (shutting_down_) break;
+
+      std::optional<Compaction> c = manual_compaction_ ? pick_manual_compaction() : pick_compaction();
+      if (!c.has_value()) {
+        manual_compaction_ = false;
+        bg_cv_.notify_all();
+        continue;
+      }
+      lock.unlock();
+
+      CompactionStats stats;
+      std::string error;
+      bool aborted = false;
+      try {
+        StopWatch timer(statistics(), HistogramType::kCompaction);
+        CompactionOutputs outputs;
+        aborted = !run_compaction(*c, &outputs, &stats);
+        if (!aborted) install_compaction(*c, outputs);
+      } catch (const std::exception &e) {
+        error = e.what();
+      }
+      c.reset();  // 释放输入：若没有读请求还在使用，被淘汰的文件在此删除
+
+      lock.lock();
+      if (aborted) break;
+      if (!error.empty()) {
+        bg_error_ = "compaction: " + error;
+        std::cerr << "[Compaction] Failed: " << error << std::endl;
+      } else {
+        compaction_stats_.compactions += 1;
+        compaction_stats_.input_files += stats.input_files;
+        compaction_stats_.output_files += stats.output_files;
+        compaction_stats_.bytes_read += stats.bytes_read;
+        compaction_stats_.bytes_written += stats.bytes_written;
+        compaction_stats_.entries_dropped += stats.entries_dropped;
+        compaction_stats_.tombstones_dropped += stats.tombstones_dropped;
+        compaction_stats_.blob_bytes_written += stats.blob_bytes_written;
+        compaction_stats_.blobs_relocated += stats.blobs_relocated;
+        compaction_stats_.blob_bytes_relocated += stats.blob_bytes_relocated;
+        compaction_stats_.rate_limit_wait += stats.rate_limit_wait;
+      }
+      bg_cv_.notify_all();
+    }
+  }
+
+  /**
+   * @brief 执行一次 Compaction：多路归并输入文件，写出 output_level 层的新文件（不持有锁）
+   *
+   * 归并规则（smallest 为最老的存活快照，没有快照时为已发布的序列号）：
+   * 1. 所有输入按内部 Key 归并：UserKey 升序，同一 UserKey 的版本按序列号从新到旧。
+   * 2. 某个版本若已被一个序列号不大于 smallest 的更新版本遮蔽，任何快照都读不到它，直接丢弃。
+   * 3. 序列号不大于 smallest 的删除标记若在更深的层中不可能有旧值
+   *    （output_level 是该 Key 的“最底层”），直接丢弃。
+   * 4. 输出文件达到 target_file_size 后切换到新文件，因此一层由多个互不重叠的文件组成；
+   *    只在 UserKey 变化处切分，同一 UserKey 的所有版本总在同一个文件中。
+   * 5. 键值分离：丢弃的 BlobIndex 计为所在 Blob 文件的垃圾；指向 gc_blob_files 的 BlobIndex
+   *    把 Value 搬到新的 Blob 文件（旧记录同样计为垃圾）；不小于 min_blob_size 的内联 Value
+   *    写入新的 Blob 文件。
+   *
+   * 输出先写成 *.tmp，全部完成后才统一重命名并 fsync 目录；中途失败或被中止时删除已写出的文件。
+   *
+   * @return false 表示因析构而中止
+   * @throw std::runtime_error 读取或写入失败
+   */
+  bool run_compaction(const Compaction &c, CompactionOutputs *outputs, CompactionStats *stats) {
+    // 子迭代器从新到旧：level 层的输入（L0 已按从新到旧排列）整体比 output_level 层新
+    std::vector<std::unique_ptr<InternalIterator>> children;
+    for (const auto &file : c.inputs) {
+      children.push_back(std::make_unique<TableIterator>(file->Reader(), /*fill_cache=*/false));
+      stats->bytes_read += file->FileSize();
+      stats->input_files += 1;
+    }
+    for (const auto &file : c.output_inputs) {
+      stats->bytes_read += file->FileSize();
+      stats->input_files += 1;
+    }
+    if (!c.output_inputs.empty()) {
+      children.push_back(
+          std::make_unique<LevelIterator>(c.output_inputs, options_.comparator, /*fill_cache=*/false));
+    }
+    MergingIterator input(&internal_comparator_, std::move(children));
+    const SequenceNumber smallest = smallest_snapshot();
+
+    struct PendingOutput {
+      FileMetaData file;
+      std::set<uint64_t> blob_files;
+      std::filesystem::path tmp_path;
+      std::filesystem::path final_path;
+    };
+    std::vector<PendingOutput> pending;
+    std::unique_ptr<SSTableBuilder> builder;
+    uint64_t charged = 0;  // 当前输出文件已计入限速器的字节数
+    BlobWriter blob_writer(data_dir_, versions_.get(), options_.blob_file_size);
+    uint64_t blob_charged = 0;  // 当前 Blob 文件已计入限速器的字节数
+
+    auto charge = [&](uint64_t file_size) {
+      if (rate_limiter_ && file_size > charged) {
+        stats->rate_limit_wait += rate_limiter_->Request(file_size - charged);
+      }
+      charged = file_size;
+    };
+    auto finish_output = [&] {
+      builder->Finish();
+      charge(builder->FileSize());
+      pending.back().file.file_size = builder->FileSize();
+      pending.back().file.blob_files.assign(pending.back().blob_files.begin(), pending.back().blob_files.end());
+      builder.reset();
+    };
+    auto cleanup = [&] {
+      builder.reset();
+      for (const PendingOutput &out : pending) {
+        std::error_code ec;
+        std::filesystem::remove(out.tmp_path, ec);
+        std::filesystem::remove(out.final_path, ec);
+      }
+      blob_writer.remove_files();
+      *outputs = CompactionOutputs();
+    };
+    auto add_garbage = [&](const BlobIndex &index) {
+      VersionEdit::BlobGarbage &garbage = outputs->blob_garbage[index.file_number];
+      garbage.number = index.file_number;
+      garbage.count += 1;
+      garbage.bytes += index.size;
+    };
+    auto decode_index = [](std::string_view value) {
+      BlobIndex index;
+      if (!index.Decode(value)) throw std::runtime_error("Malformed blob index during compaction");
+      return index;
+    };
+    // 把 value 写入 Blob 文件，返回新的 BlobIndex
+    auto write_blob = [&](std::string_view user_key, std::string_view value) {
+      uint64_t before = blob_writer.current_number();
+      BlobIndex index = blob_writer.add(user_key, value);
+      if (index.file_number != before) blob_charged = 0;
+      uint64_t size = blob_writer.current_file_size();
+      if (rate_limiter_ && size > blob_charged) {
+        stats->rate_limit_wait += rate_limiter_->Request(size - blob_charged);
+      }
+      blob_charged = size;
+      return index;
+    };
+
+    try {
+      std::string current_key;
+      bool has_current = false;
+      SequenceNumber last_sequence = kMaxSequenceNumber;  // 当前 UserKey 上一个版本的序列号
+      TableOptions table_options = table_options_for_level(c.output_level);
+      for (input.SeekToFirst(); input.Valid(); input.Next()) {
+        if (stop_compaction_.load(std::memory_order_acquire)) {
+          cleanup();
+          return false;
+        }
+        ParsedInternalKey parsed;
+        if (!parse_internal_key(input.key(), &parsed)) {
+          throw std::runtime_error("Malformed internal key in SSTable during compaction");
+        }
+        bool new_user_key =
+            !has_current || options_.comparator->Compare(parsed.user_key, current_key) != 0;
+        if (new_user_key) {
+          current_key.assign(parsed.user_key);
+          has_current = true;
+          last_sequence = kMaxSequenceNumber;
+        }
+
+        bool drop = false;
+        if (last_sequence <= smallest) {
+          stats->entries_dropped += 1;
+          drop = true;
+        } else if (parsed.type == ValueType::kDeletion && parsed.sequence <= smallest &&
+                   !key_in_deeper_levels(c, current_key)) {
+          stats->tombstones_dropped += 1;
+          drop = true;
+        }
+        last_sequence = parsed.sequence;
+        if (drop) {
+          if (parsed.type == ValueType::kBlobIndex) add_garbage(decode_index(input.value()));
+          continue;
+        }
+
+        // 当前文件已满且 UserKey 变化时切换到新文件
+        if (builder && new_user_key && builder->FileSize() >= options_.target_file_size &&
+            options_.comparator->Compare(current_key, pending.back().file.largest) != 0) {
+          finish_output();
+        }
+        if (!builder) {
+          PendingOutput out;
+          out.file.number = versions_->NewFileNumber();
+          out.final_path = data_dir_ / table_file_name(c.output_level, out.file.number);
+          out.tmp_path = out.final_path;
+          out.tmp_path += ".tmp";
+          out.file.smallest = current_key;
+          pending.push_back(std::move(out));
+          builder = std::make_unique<SSTableBuilder>(pending.back().tmp_path.string(),
+                                                     table_options);
+          charged = 0;
+        }
+        if (parsed.type == ValueType::kBlobIndex) {
+          BlobIndex index = decode_index(input.value());
+          if (c.gc_blob_files.count(index.file_number)) {
+            std::shared_ptr<const std::string> value =
+                read_blob(*c.version, current_key, input.value(), /*fill_cache=*/false);
+            add_garbage(index);
+            index = write_blob(current_key, *value);
+            stats->blobs_relocated += 1;
+            stats->blob_bytes_relocated += value->size();
+            builder->Add(input.key(), index.Encode());
+          } else {
+            builder->Add(input.key(), input.value());
+          }
+          pending.back().blob_files.insert(index.file_number);
+        } else if (separate_value(parsed.type, input.value())) {
+          BlobIndex index = write_blob(current_key, input.value());
+          builder->Add(make_internal_key(current_key, parsed.sequence, ValueType::kBlobIndex), index.Encode());
+          pending.back().blob_files.insert(index.file_number);
+        } else {
+          builder->Add(input.key(), input.value());
+        }
+        pending.back().file.largest = current_key;
+        charge(builder->FileSize());
+      }
+      if (builder) finish_output();
+      blob_writer.finish();
+
+      for (PendingOutput &out : pending) {
+        std::filesystem::rename(out.tmp_path, out.final_path);
+        stats->bytes_written += out.file.file_size;
+        stats->output_files += 1;
+        outputs->tables.push_back(out.file);
+      }
+      if (!pending.empty()) sync_directory(data_dir_);  // MANIFEST 登记输出之前目录项已持久化
+      outputs->blob_files = blob_writer.files();
+      for (const BlobFileMetaData &blob : outputs->blob_files) stats->blob_bytes_written += blob.file_size;
+    } catch (...) {
+      cleanup();
+      throw;
+    }
+    return true;
+  }
+
+  /**
+   * @brief 安装 Compaction 结果：删除输入、加入输出，作为一条 VersionEdit 写入 MANIFEST（不持有锁）
+   *
+   * 新 Version 原子地替换旧 Version，读请求看到的要么是旧文件集合，要么是新文件集合。
+   * 输入文件（以及因此不再被引用的 Blob 文件）被标记为已淘汰，在持有它们的 Version 全部释放后删除；
+   * 此前崩溃时它们不再被 MANIFEST 引用，重启后作为未引用文件删除。
+   *
+   * @throw std::runtime_error MANIFEST 写入失败（已写出的输出文件被删除）
+   */
+  void install_compaction(const Compaction &c, const CompactionOutputs &outputs) {
+    VersionEdit edit;
+    for (const auto &file : c.inputs) edit.DeleteFile(c.level, file->Number());
+    for (const auto &file : c.output_inputs) edit.DeleteFile(c.output_level, file->Number());
+    for (const BlobFileMetaData &blob : outputs.blob_files) edit.AddBlobFile(blob);
+    for (const FileMetaData &file : outputs.tables) edit.AddFile(c.output_level, file);
+    for (const auto &[number, garbage] : outputs.blob_garbage) {
+      edit.AddBlobGarbage(number, garbage.count, garbage.bytes);
+    }
+    try {
+      versions_->LogAndApply(&edit);
+    } catch (...) {
+      for (const FileMetaData &file : outputs.tables) {
+        std::error_code ec;
+        std::filesystem::remove(data_dir_ / table_file_name(c.output_level, file.number), ec);
+      }
+      for (const BlobFileMetaData &blob : outputs.blob_files) {
+        std::error_code ec;
+        std::filesystem::remove(data_dir_ / blob_file_name(blob.number), ec);
+      }
+      throw;
+    }
+  }
+
+  /**
+   * @brief 将一个批次的全部操作按顺序应用到 mem（调用者为 Leader 或处于构造阶段）
+   *
+   * @param sequence 批次的首个序列号，第 i 个操作使用 sequence + i
+   * @return 批次之后的下一个序列号
+   */
+  static SequenceNumber apply_batch(MemTable &mem, std::string_view rep, SequenceNumber sequence,
+                          KeyEncoding encoding = KeyEncoding::kBinary) {
+    WriteBatch::iterate_rep(rep, [&mem, &sequence](LogType type, std::string_view key,
+                                                   std::string_view value) {
+      if (type == LogType::kPut) {
+        mem.add(sequence++, ValueType::kValue, key, value);
+      } else {
+        mem.add(sequence++, ValueType::kDeletion, key, std::string_view());
+      }
+    }, encoding);
+    return sequence;
+  }
+
+  /// 当前排队中所有写入者的编码字节数之和（调用者需持有 mutex_）
+  size_t queued_bytes() const {
+    size_t bytes = 0;
+    for (const Writer *writer : writers_) bytes += writer->encoded.size();
+    return bytes;
+  }
+
+  /**
+   * @brief 周期同步线程主循环（仅 kPeriodic 模式）
+   *
+   * 每隔 periodic_sync_interval 调用一次 sync_wal()。
+   * fdatasync 只作用于文件描述符，可以与 Leader 的写入并发；
+   * wal_mutex_ 保证同步期间 WAL 不会被 roll_wal 关闭替换。
+   * 同步失败时记录 bg_error_（Fail-Stop）并退出：失败后页缓存中的数据是否落盘已无从得知。
+   */
+  void periodic_sync_loop() {
+    std::unique_lock<std::mutex> lock(sync_mutex_);
+    while (!stop_sync_) {
+      sync_cv_.wait_for(lock, options_.periodic_sync_interval, [this] { return stop_sync_; });
+      if (stop_sync_) break;
+      lock.unlock();
+      std::string error;
+      try {
+        std::lock_guard<std::mutex> wal_lock(wal_mutex_);
+        StopWatch timer(statistics(), HistogramType::kWalSync);
+        sync_wal();
+      } catch (const std::exception &e) {
+        error = e.what();
+      }
+      {
+        std::lock_guard<std::mutex> state_lock(mutex_);
+        if (!error.empty()) {
+          set_bg_error("wal sync: " + error);
+          std::cerr << "[KVStore] Periodic WAL sync failed: " << error << std::endl;
+        } else {
+          wal_stats_.syncs += 1;
+        }
+      }
+      lock.lock();
+      if (!error.empty()) break;
+    }
+  }
+
+  /**
+   * @brief 进入 Fail-Stop（调用者持有 mutex_）：只保留第一个错误，并唤醒等待后台工作的线程
+   */
+  void set_bg_error(const std::string &error) {
+    if (bg_error_.empty()) bg_error_ = error;
+    bg_cv_.notify_all();
+  }
+
+  /// 取出异常的说明文字
+  static std::string exception_message(const std::exception_ptr &error) {
+    try {
+      std::rethrow_exception(error);
+    } catch (const std::exception &e) {
+      return e.what();
+    } catch (...) {
+      return "unknown error";
+    }
+  }
+
+  /**
+   * @brief 将 WAL 在 OS Page Cache 中的数据强制刷入物理磁盘
+   *
+   * @throw std::runtime_error fdatasync / _commit 失败
+   */
+  void sync_wal() { wal_->sync(); }
+
+  /**
+     * @brief [Task 4] 重放 WAL 日志，恢复 MemTable (Crash Recovery)
+     *
+     * 该函数在数据库启动时被调用，用于将上次非正常关闭（崩溃/断电）时遗留在磁盘上的
+     * WAL 日志记录重新应用到内存中，从而恢复数据一致性。
+     *
+     * 核心流程 (Read -> Verify -> Apply):
+     * 1. **Read**: 由 WalReader 以大块 (1MB) 顺序读取，记录以零拷贝视图的形式返回。
+     * 2. **Verify**: WalReader 直接对缓冲区中的原始字节计算 Checksum 并与 Header 比对。
+     *    - 若校验失败或读取不完整，视为崩溃现场，停止重放该文件（Fail-Stop）。
+     * 3. **Apply**: 将验证通过的记录（Put/Delete）重新执行到 MemTable；
+     *    kBatch 记录先校验批次结构，再整体应用（All-or-Nothing）。
+     *
+     * 预分配的空间与 WalWriter 写入的结束标记是全零的 Header，读到即正常结束。
+     * 复用段中残留的旧记录可能恰好完整且校验通过：它们的序列号不大于已恢复的序列号
+     * （旧段的数据早已落盘），或是出现在带序列号的记录之后的旧格式记录，遇到即视为段的结尾。
+     *
+     * 重放结束后输出吞吐（MB/s、records/s），多个 WAL 段的统计累加到 recovery_stats()。
+     *
+     * @param path 待重放的 WAL 文件（wal.log 或封存段 wal_<N>.log）
+     * @return 有效记录的末尾偏移（之后的内容在继续写入 wal.log 前被截断）
+     */
+    uint64_t replay_wal(const std::filesystem::path &path) {
+      WalReader reader(path);
+      if(!reader.is_open()) {
+        return 0;
+      }
+
+      std::cout << "[Recovery] Replaying WAL " << path.filename().string() << "..." << std::endl;
+      auto start = std::chrono::steady_clock::now();
+      uint64_t records = 0;
+
+      LogRecordView record;
+      WalReader::Status status;
+      uint64_t end = 0;
+      bool sequenced = false;
+      while((status = reader.next(record)) == WalReader::Status::kRecord) {
+        bool stale = record.sequence != 0 ? record.sequence <= last_sequence_ : sequenced;
+        if (stale) {
+          std::cout << "[Recovery] Reached stale records of a recycled segment at offset "
+                    << record.offset << "." << std::endl;
+          break;
+        }
+        sequenced = sequenced || record.sequence != 0;
+        ++records;
+        apply_log_record(record);
+        end = record.offset + record.size;
+      }
+
+      if(status == WalReader::Status::kCorrupted) {
+        // 遇到校验错误（中间位翻转或写入未完成），严格模式下应报错。
+        // 这里简单处理为停止重放。
+        std::cerr << "[Recovery] Checksum mismatch! (Truncated or Corrupted). Stopping." << std::endl;
+      } else if(status == WalReader::Status::kTruncated) {
+        std::cerr << "[Recovery] Truncated record at offset " << reader.offset()
+                  << " (incomplete write before crash). Stopping." << std::endl;
+      }
+
+      auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start);
+      recovery_stats_.records += records;
+      recovery_stats_.bytes += end;
+      recovery_stats_.elapsed += elapsed;
+      std::cout << "[Recovery] WAL replay finished: " << records << " records, "
+                << end << " bytes in "
+                << static_cast<double>(elapsed.count()) / 1e6 << " ms ("
+                << recovery_stats_.mb_per_sec() << " MB/s, "
+                << recovery_stats_.records_per_sec() << " records/s)" << std::endl;
+      return end;
+    }
+
+  /**
+   * @brief 将一条通过校验的 WAL 记录应用到 MemTable（仅在构造阶段调用）
+   *
+   * Key 的原始字节直接写入 MemTable，没有任何转换；旧格式的十进制文本 Key 用 std::from_chars
+   * 解析后转换为 encode_int_key 的编码。无法解析的 Key 被跳过并记录错误日志。
+   * 记录中的序列号原样沿用；没有序列号的旧格式记录按重放顺序接在 last_sequence_ 之后分配。
+   * 并行重放时操作经 add_recovered 分发给重放线程，序列号仍在这里（扫描线程上）确定。
+   */
+  void apply_log_record(const LogRecordView &record) {
+    SequenceNumber sequence = record.sequence != 0 ? record.sequence : last_sequence_ + 1;
+    if (record.type == LogType::kBatch) {
+      // 先完整校验批次结构，再整体应用，保证 All-or-Nothing
+      if (!WriteBatch::validate(record.value, record.key_encoding)) {
+        std::cerr << "[Recovery] Malformed write batch at offset " << record.offset
+                  << ". Skipping." << std::endl;
+        return;
+      }
+      SequenceNumber next = sequence;
+      if (replay_workers_.empty()) {
+        next = apply_batch(*mem_, record.value, sequence, record.key_encoding);
+      } else {
+        WriteBatch::iterate_rep(record.value, [this, &next](LogType type, std::string_view key,
+                                                            std::string_view value) {
+          if (type == LogType::kPut) {
+            add_recovered(next++, ValueType::kValue, key, value);
+          } else {
+            add_recovered(next++, ValueType::kDeletion, key, std::string_view());
+          }
+        }, record.key_encoding);
+      }
+      last_sequence_ = std::max(last_sequence_, next - 1);
+      return;
+    }
+
+    std::string scratch;
+    std::string_view key;
+    if (!decode_log_key(record.key, record.key_encoding, &scratch, &key)) {
+      // 容错处理：忽略损坏的记录（生产环境建议记录 Error 日志）
+      std::cerr << "[Recovery] Failed to parse key at offset " << record.offset
+                << ". Skipping." << std::endl;
+      return;
+    }
+    if (record.type == LogType::kPut) {
+      add_recovered(sequence, ValueType::kValue, key, record.value);
+    } else if (record.type == LogType::kDelete) {
+      add_recovered(sequence, ValueType::kDeletion, key, std::string_view());
+    }
+    last_sequence_ = std::max(last_sequence_, sequence);
+  }
+
+  /// 重放的一个操作：顺序重放时写入 mem_，并行重放时交给 Key 哈希对应的重放线程
+  void add_recovered(SequenceNumber sequence, ValueType type, std::string_view key,
+                     std::string_view value) {
+    if (replay_workers_.empty()) {
+      mem_->add(sequence, type, key, value);
+      return;
+    }
+    size_t index = std::hash<std::string_view>{}(key) % replay_workers_.size();
+    replay_workers_[index]->add(sequence, type, key, value);
+  }
+
+  /**
+   * @brief 等待重放线程应用完已分发的全部操作并停止它们（仅在构造阶段调用）
+   *
+   * 等待的时间计入 recovery_stats().elapsed。
+   *
+   * @return 各重放线程的非空 MemTable；顺序重放时数据留在 mem_ 中，返回空集合
+   */
+  std::vector<std::shared_ptr<MemTable>> finish_replay() {
+    std::vector<std::shared_ptr<MemTable>> recovered;
+    if (replay_workers_.empty()) return recovered;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &worker : replay_workers_) {
+      std::shared_ptr<MemTable> mem = worker->finish();
+      if (!mem->empty()) recovered.push_back(std::move(mem));
+    }
+    replay_workers_.clear();
+    recovery_stats_.elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    return recovered;
+  }
+
+  /**
+   * @brief recovery_threads > 1 时，在后台线程上打开当前 Version 中全部 SSTable 的读取器
+   *
+   * 打开读取器即读入 Footer、Index 与 Filter，与 WAL 重放同时进行；
+   * 返回的线程在析构时汇合。打开失败的文件留到第一次读取时再报告错误。
+   */
+  std::vector<std::jthread> open_tables_in_background() const {
+    std::vector<std::jthread> threads;
+    if (options_.recovery_threads <= 1) return threads;
+    auto files = std::make_shared<Version::FileList>();
+    std::shared_ptr<const Version> version = versions_->current();
+    for (int level = 0; level < version->NumLevels(); ++level) {
+      files->insert(files->end(), version->Files(level).begin(), version->Files(level).end());
+    }
+    auto next = std::make_shared<std::atomic<size_t>>(0);
+    size_t count = std::min(options_.recovery_threads, files->size());
+    for (size_t i = 0; i < count; ++i) {
+      threads.emplace_back([files, next] {
+        for (size_t index; (index = next->fetch_add(1)) < files->size();) {
+          try {
+            (*files)[index]->Reader();
+          } catch (const std::exception &e) {
+            std::cerr << "[Recovery] Failed to open " << (*files)[index]->Path().filename().string()
+                      << ": " << e.what() << std::endl;
+          }
+        }
+      });
+    }
+    return threads;
+  }
+
+  /// 当前 Version 中读取器已打开的 SSTable 数量
+  uint64_t count_open_tables() const {
+    std::shared_ptr<const Version> version = versions_->current();
+    uint64_t count = 0;
+    for (int level = 0; level < version->NumLevels(); ++level) {
+      for (const auto &file : version->Files(level)) count += file->IsOpen() ? 1 : 0;
+    }
+    return count;
+  }
+
+  /**
+   * @brief 安装重放出的数据（仅在构造阶段、打开 wal.log 之后调用）
+   *
+   * recovered 为空（顺序重放）时数据留在 mem_ 中继续接收写入，与以前一致；
+   * 但 flush_recovered_memtables 要求直接落盘时，把 mem_ 当作唯一的一份重放结果。
+   *
+   * 先封存 wal.log（其中的记录都已在重放结果中），新写入进入新的 wal.log，然后：
+   * - flush_recovered_memtables：每份结果在各自的线程上写成一个 L0 SSTable，
+   *   一条 VersionEdit 登记全部文件、封存段的编号与 LastSequence，随后回收全部已重放的 WAL 段。
+   * - 否则依次放入 Immutable 队列交给后台落盘。只有最后一份带上封存段的编号与最大序列号：
+   *   它落盘之前 MANIFEST 的 LogNumber / LastSequence 不变，中途崩溃时 WAL 段仍会被完整重放。
+   *
+   * @throw std::runtime_error WAL 切换、SSTable 或 MANIFEST 写入失败
+   */
+  void install_recovered(std::vector<std::shared_ptr<MemTable>> recovered) {
+    if (recovered.empty() && options_.flush_recovered_memtables && !mem_->empty()) {
+      recovered.push_back(std::exchange(mem_, std::make_shared<MemTable>(options_.comparator)));
+    }
+    if (recovered.empty()) return;
+    uint64_t log_number = roll_wal();
+
+    if (!options_.flush_recovered_memtables) {
+      for (size_t i = 0; i < recovered.size(); ++i) {
+        bool last = i + 1 == recovered.size();
+        imms_.push_back(ImmutableMemTable{recovered[i], last ? log_number : 0,
+                                          last ? last_sequence_ : 0});
+      }
+      return;
+    }
+
+    std::vector<uint64_t> numbers;
+    for (size_t i = 0; i < recovered.size(); ++i) numbers.push_back(versions_->NewFileNumber());
+    std::vector<std::optional<FileMetaData>> files(recovered.size());
+    std::vector<std::vector<BlobFileMetaData>> blobs(recovered.size());
+    std::vector<uint64_t> entries(recovered.size());
+    std::vector<std::exception_ptr> errors(recovered.size());
+    {
+      std::vector<std::jthread> writers;
+      for (size_t i = 0; i < recovered.size(); ++i) {
+        writers.emplace_back([&, i] {
+          try {
+            files[i] = write_level0_table(*recovered[i], numbers[i], last_sequence_, &entries[i], &blobs[i]);
+          } catch (...) {
+            errors[i] = std::current_exception();
+          }
+        });
+      }
+    }
+    for (const std::exception_ptr &error : errors) {
+      if (error) std::rethrow_exception(error);
+    }
+
+    VersionEdit edit;
+    for (size_t i = 0; i < files.size(); ++i) {
+      if (!files[i].has_value()) continue;
+      flush_stats_.flushes += 1;
+      flush_stats_.entries += entries[i];
+      flush_stats_.bytes_written += files[i]->file_size;
+      recovery_stats_.flushed_tables += 1;
+      for (const BlobFileMetaData &blob : blobs[i]) {
+        flush_stats_.blob_bytes_written += blob.file_size;
+        edit.AddBlobFile(blob);
+      }
+      edit.AddFile(0, *files[i]);
+    }
+    edit.SetLogNumber(log_number);
+    edit.SetLastSequence(last_sequence_);
+    versions_->LogAndApply(&edit);
+    remove_obsolete_logs(log_number);
+  }
+
+  /**
+   * @brief 核心辅助函数：将日志记录持久化到磁盘
+   *
+   * 实现了数据持久化的“两步走”策略，确保 ACID 中的 Durability（持久性）：
+   *
+   * 1. **Write (pwrite)**:
+   *    WalWriter 把数据直接写入 OS Page Cache (内核态)，没有 stdio 缓冲区，也不需要 fflush；
+   *    开启 wal_direct_io 时绕过 Page Cache 直接提交给设备。
+   *    此时如果进程崩溃 (Crash)，数据安全；但如果操作系统崩溃或断电，数据丢失。
+   *
+   * 2. **Sync (fdatasync / _commit)**:
+   *    强制操作系统将 Page Cache 中的数据写入物理磁盘介质。
+   *    这是最慢的一步（机械盘 ms 级，SSD us 级），但能保证断电不丢数据。
+   *    段已预分配，文件大小不变，fdatasync 不必同时提交 inode 元数据。
+   *
+   * 组提交模式下 data 是整批记录拼接后的结果，两步走只执行一次；
+   * kPeriodic 模式下跳过第 2 步，由后台线程周期性完成。
+   *
+   * @param data 一条或多条已编码日志记录拼接而成的字节序列
+   * @throw std::runtime_error 任何一步 I/O 失败都会抛出异常；write_impl 随之记录 bg_error_，
+   *        之后的写入全部失败（Fail-Stop）
+   */
+  void append_wal(const std::string& data) {
+    // Step 1: Write to kernel buffer (or the device with O_DIRECT)
+    wal_->append(data);
+
+    // Step 2: Sync to physical disk
+    if (options_.sync_mode != WalSyncMode::kPeriodic) {
+        StopWatch timer(statistics(), HistogramType::kWalSync);
+        sync_wal();
+    }
+  }
+
+private:
+  std::filesystem::path data_dir_;       ///< 数据存储根目录
+  std::filesystem::path wal_path_;       ///< 活跃 WAL (wal.log) 的完整路径
+  KVStoreOptions options_;               ///< 存储引擎选项
+  InternalKeyComparator internal_comparator_; ///< 按 options_.comparator 排序 UserKey 的内部 Key 比较器
+  std::shared_ptr<MemTable> mem_;        ///< 活跃 MemTable（接收新写入）
+  std::deque<ImmutableMemTable> imms_;   ///< 等待落盘的 Immutable MemTable（旧 -> 新）
+  /// 读请求使用的 MemTable 集合快照，mem_ / imms_ 变化时由 install_memtables() 替换
+  std::shared_ptr<const MemTableSet> memtables_;
+  mutable std::mutex memtables_mutex_;   ///< 只保护 memtables_ 指针本身的复制与替换
+  std::vector<uint64_t> sealed_logs_;    ///< 尚未删除的封存 WAL 段编号（升序）
+  std::deque<uint64_t> recycled_logs_;   ///< 待复用的旧 WAL 段（wal_<N>.recycle）编号
+  /// 文件集合（每层的 SSTable）、MANIFEST 与文件编号分配（WAL 段、SSTable、MANIFEST 共用）
+  std::unique_ptr<VersionSet> versions_;
+  std::unique_ptr<WalWriter> wal_;       ///< 活跃 WAL 段 (wal.log) 的写入器
+  /// 并行重放的应用线程（仅在构造阶段、recovery_threads > 1 时非空）
+  std::vector<std::unique_ptr<ReplayWorker>> replay_workers_;
+
+  mutable std::mutex mutex_;             ///< 保护 mem_ / imms_ 的切换、writers_ 与各项统计
+  std::deque<Writer *> writers_;         ///< 写入者队列，队首为当前 Leader
+  WriteController write_controller_;     ///< 减速的令牌桶（只由 Leader 使用）
+  SequenceNumber last_sequence_ = 0;     ///< 已分配的最大序列号（Leader 持有 mutex_ 时或构造阶段修改）
+  /// 已发布的最大序列号：不大于它的写入都已应用到 MemTable（Leader 无锁写，读者无锁读）
+  std::atomic<SequenceNumber> visible_sequence_{0};
+  mutable std::mutex snapshots_mutex_;   ///< 保护 snapshots_
+  SnapshotList snapshots_;               ///< 存活的快照（按序列号非降序）
+  std::condition_variable leader_cv_;    ///< 组提交 Leader 攒批等待用
+  WalStats wal_stats_;                   ///< WAL 写入统计
+  RecoveryStats recovery_stats_;         ///< 启动时 WAL 重放统计（构造完成后只读）
+  FlushStats flush_stats_;               ///< MemTable 落盘统计
+  CompactionStats compaction_stats_;     ///< Compaction 统计
+
+  std::thread flush_thread_;             ///< 后台落盘线程
+  std::condition_variable bg_cv_;        ///< 落盘 / Compaction 任务与完成通知
+  bool shutting_down_ = false;
+  std::string bg_error_;                 ///< WAL、后台落盘或 Compaction 失败原因（非空即进入 Fail-Stop）
+
+  std::thread compaction_thread_;        ///< 后台 Compaction 线程
+  std::atomic<bool> stop_compaction_{false}; ///< 析构时置位，中止进行中的 Compaction（无锁读取）
+  bool manual_compaction_ = false;       ///< compact() 请求的全量 Compaction 尚未完成
+  std::vector<std::string> compact_pointer_; ///< 每层上次 Compaction 结束的 Key（轮转选文件）
+  std::unique_ptr<RateLimiter> rate_limiter_; ///< Compaction 写入限速（未限速时为空）
+
+  std::mutex wal_mutex_;                 ///< 保护 wal_ 的切换与周期 fdatasync
+  std::thread sync_thread_;              ///< 周期同步线程（仅 kPeriodic）
+  std::mutex sync_mutex_;
+  std::condition_variable sync_cv_;
+  bool stop_sync_ = false;
 };
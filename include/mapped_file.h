@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @file mapped_file.h
+ * @brief 只读内存映射文件（POSIX mmap；其他平台 Open 返回空，调用者退回普通读取）
+ */
+
+/**
+ * @brief 把整个文件以只读方式映射到内存
+ *
+ * 映射在对象析构时解除；以 shared_ptr 持有时，指向映射内存的视图（例如钉在
+ * PinnableValue 中的值）可以让映射比打开它的 SSTableReader 存活更久。
+ *
+ * @note 本类是线程安全的（映射建立后只读）。
+ */
+class MappedFile {
+public:
+    /// 访问模式提示（madvise）
+    enum class Advice {
+        kWillNeed,  ///< 即将访问：内核提前把这些页读入 Page Cache
+        kRandom,    ///< 随机访问：缺页时不做预读
+    };
+
+    /**
+     * @brief 映射 path 的前 size 字节
+     *
+     * @return 映射失败或平台不支持时返回空
+     */
+    static std::shared_ptr<const MappedFile> Open(const std::string& path, uint64_t size) {
+#ifndef _WIN32
+        if (size == 0) return nullptr;
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return nullptr;
+        void* base = ::mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);  // 映射不依赖文件描述符
+        if (base == MAP_FAILED) return nullptr;
+        return std::shared_ptr<const MappedFile>(new MappedFile(static_cast<const char*>(base), static_cast<size_t>(size)));
+#else
+        (void)path;
+        (void)size;
+        return nullptr;
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        ::munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    /**
+     * @brief 对 [offset, offset + length) 所在的页给出访问模式提示（越界部分被截断；失败时忽略）
+     */
+    void Advise(uint64_t offset, uint64_t length, Advice advice) const {
+#ifndef _WIN32
+        if (offset >= size_ || length == 0) return;
+        length = std::min<uint64_t>(length, size_ - offset);
+        size_t page = PageSize();
+        size_t begin = static_cast<size_t>(offset) / page * page;
+        size_t end = static_cast<size_t>(offset + length);
+        ::madvise(const_cast<char*>(data_) + begin, end - begin,
+                  advice == Advice::kWillNeed ? MADV_WILLNEED : MADV_RANDOM);
+#else
+        (void)offset;
+        (void)length;
+        (void)advice;
+#endif
+    }
+
+    /**
+     * @brief 映射中当前驻留在物理内存（Page Cache）中的字节数（按页计，mincore）
+     */
+    uint64_t ResidentBytes() const {
+#ifndef _WIN32
+        size_t page = PageSize();
+        size_t pages = (size_ + page - 1) / page;
+#ifdef __linux__
+        std::vector<unsigned char> vec(pages);
+#else
+        std::vector<char> vec(pages);
+#endif
+        if (::mincore(const_cast<char*>(data_), size_, vec.data()) != 0) return 0;
+        uint64_t resident = 0;
+        for (size_t i = 0; i < pages; ++i) {
+            if (vec[i] & 1) resident += page;
+        }
+        return std::min<uint64_t>(resident, size_);
+#else
+        return 0;
+#endif
+    }
+
+private:
+    MappedFile(const char* data, size_t size) : data_(data), size_(size) {}
+
+#ifndef _WIN32
+    static size_t PageSize() {
+        static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        return page;
+    }
+#endif
+
+    const char* data_;
+    size_t size_;
+};
@@ -0,0 +1,303 @@
+#pragma once
+
+#include "arena.h"
+#include "arena_skiplist.h"
+#include "coding.h"
+#include "comparator.h"
+#include "dbformat.h"
+#include "iterator.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief MemTable：基于跳表的内存写缓冲
+ *
+ * 与直接使用 SkipList<K, V> 相比，MemTable 增加了 LSM-Tree 必需的能力：
+ * 1. **删除标记 (Tombstone)**：del 不再从跳表中摘除节点，而是写入一条 kDeletion 条目，
+ *    从而在读路径上遮蔽 Immutable MemTable / SSTable 中的旧值。
+ * 2. **多版本 (MVCC)**：每次写入都带一个序列号，同一个 Key 的每个版本都是一个独立的节点，
+ *    读请求按快照的序列号选择可见的最新版本，覆盖写不会影响正在读旧版本的快照。
+ * 3. **内存用量统计**：Arena 的占用字节数，供 KVStore 判断何时冻结并落盘。
+ *
+ * 存储布局：跳表节点与条目都从同一个 Arena 顺序分配，写入路径上没有 malloc。
+ * 每个条目被编码为一段连续的字节，跳表的 Key 即指向它的指针：
+ * +--------------------+---------+----------+----------------------+-------+
+ * | KeyLen (varint32)  | UserKey | Tag (8B) | ValueLen (varint32)  | Value |
+ * +--------------------+---------+----------+----------------------+-------+
+ * UserKey | Tag 即内部 Key（见 dbformat.h），KeyLen 是它的长度；条目按 InternalKeyComparator 排序：
+ * UserKey 按构造时传入的比较器升序，相同 UserKey 时序列号降序。
+ *
+ * @note 单写多读：add / put / del 需由调用者串行化（KVStore 的写入者队列保证同一时刻只有一个 Leader）；
+ *       get / for_each 不需要任何锁，可与写入并发调用。条目一经写入便不再修改，
+ *       新版本作为新节点原子地链入跳表，读者看到的总是完整的条目。
+ */
+class MemTable {
+public:
+    /// for_each 访问到的条目：类型 + 序列号 + 值（kDeletion 时值为空；视图在 MemTable 存活期间有效）
+    struct Entry {
+        ValueType type = ValueType::kValue;
+        SequenceNumber sequence = 0;
+        std::string_view value;
+    };
+
+    /// get() 的查询结果
+    enum class LookupResult {
+        kFound,    ///< 找到有效值
+        kDeleted,  ///< 找到删除标记：key 已被删除，不应再查询更老的数据
+        kNotFound  ///< 本 MemTable 中没有该 key 在快照内可见的记录
+    };
+
+    /// @param comparator UserKey 的排序方式，生命周期必须长于 MemTable
+    explicit MemTable(const Comparator* comparator = BytewiseComparator())
+        : user_comparator_(comparator), table_(KeyComparator{InternalKeyComparator(comparator)}, &arena_) {}
+
+    MemTable(const MemTable&) = delete;
+    MemTable& operator=(const MemTable&) = delete;
+
+    /**
+     * @brief 写入 key 的一个新版本
+     *
+     * @param sequence 序列号（同一个 key 的版本必须互不相同；KVStore 保证全局单调递增）
+     * @param type 正常值或删除标记
+     * @param key 用户 Key
+     * @param value 值（kDeletion 时忽略）
+     */
+    void add(SequenceNumber sequence, ValueType type, std::string_view key, std::string_view value) {
+        uint32_t internal_len = static_cast<uint32_t>(key.size() + kInternalKeyTagSize);
+        uint32_t value_len = static_cast<uint32_t>(value.size());
+        char* buf = arena_.Allocate(varint32_length(internal_len) + internal_len +
+                                    varint32_length(value_len) + value.size());
+        char* p = encode_varint32(buf, internal_len);
+        if (!key.empty()) std::memcpy(p, key.data(), key.size());
+        p += key.size();
+        encode_fixed64(p, pack_sequence_and_type(sequence, type));
+        p += kInternalKeyTagSize;
+        p = encode_varint32(p, value_len);
+        if (!value.empty()) std::memcpy(p, value.data(), value.size());
+        table_.InsertOrAssign(buf);  // (key, sequence) 互不相同，总是插入新节点
+        if (sequence > last_sequence_.load(std::memory_order_relaxed)) {
+            last_sequence_.store(sequence, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 写入一个新值，序列号取 last_sequence() + 1（单独使用 MemTable 时的便捷接口）
+     */
+    void put(std::string_view key, std::string_view value) {
+        add(last_sequence() + 1, ValueType::kValue, key, value);
+    }
+
+    /**
+     * @brief 写入删除标记，序列号取 last_sequence() + 1
+     */
+    void del(std::string_view key) { add(last_sequence() + 1, ValueType::kDeletion, key, std::string_view()); }
+
+    /**
+     * @brief 查询 key 在快照 snapshot 中可见（序列号 <= snapshot）的最新版本
+     *
+     * @param key 键
+     * @param value [out] kFound 时填入值
+     * @param snapshot 快照的序列号，默认读取最新版本
+     * @return LookupResult kFound / kDeleted / kNotFound
+     */
+    LookupResult get(std::string_view key, std::string* value,
+                     SequenceNumber snapshot = kMaxSequenceNumber) const {
+        std::string_view view;
+        LookupResult result = get(key, &view, snapshot);
+        if (result == LookupResult::kFound) value->assign(view.data(), view.size());
+        return result;
+    }
+
+    /**
+     * @brief 查询 key（零拷贝）
+     *
+     * @param value [out] kFound 时指向 Arena 中的值；条目一经写入便不再修改，
+     *        视图在 MemTable 存活期间有效（即使之后该 key 被覆盖写）
+     */
+    LookupResult get(std::string_view key, std::string_view* value,
+                     SequenceNumber snapshot = kMaxSequenceNumber) const {
+        LookupKey lookup(key, snapshot);
+        Table::Iterator it(&table_);
+        it.Seek(lookup.entry());
+        if (!it.Valid()) return LookupResult::kNotFound;
+        const char* found = it.key();
+        ParsedInternalKey parsed = decode_internal_key(found);
+        if (user_comparator_->Compare(parsed.user_key, key) != 0) {
+            return LookupResult::kNotFound;
+        }
+        if (parsed.type == ValueType::kDeletion) return LookupResult::kDeleted;
+        *value = decode_value(found);
+        return LookupResult::kFound;
+    }
+
+    /**
+     * @brief 近似内存占用（Arena 已分配的字节数，含跳表节点；只增不减，每个版本都会计入）
+     */
+    size_t approximate_memory_usage() const { return arena_.MemoryUsage(); }
+
+    bool empty() const { return table_.Empty(); }
+
+    /// 已写入的最大序列号（空表为 0）
+    SequenceNumber last_sequence() const { return last_sequence_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 按 (key 升序, 序列号降序) 遍历所有条目（含删除标记与被覆盖的旧版本），用于落盘
+     *
+     * @tparam F 签名为 void(std::string_view key, const Entry& entry)（视图在 MemTable 存活期间有效）
+     */
+    template <typename F>
+    void for_each(F&& fn) const {
+        Table::Iterator it(&table_);
+        for (it.SeekToFirst(); it.Valid(); it.Next()) {
+            const char* entry = it.key();
+            ParsedInternalKey parsed = decode_internal_key(entry);
+            fn(parsed.user_key, Entry{parsed.type, parsed.sequence, decode_value(entry)});
+        }
+    }
+
+private:
+    /// 按条目开头的内部 Key 比较两个编码后的条目
+    struct KeyComparator {
+        InternalKeyComparator comparator;
+
+        int operator()(const char* a, const char* b) const {
+            return comparator.Compare(decode_key(a), decode_key(b));
+        }
+    };
+
+    using Table = ArenaSkipList<const char*, KeyComparator>;
+
+public:
+    /**
+     * @brief 按内部 Key 顺序遍历条目（含删除标记与旧版本）的双向迭代器
+     *
+     * key() 为内部 Key（UserKey | Tag），Seek 的目标同样是内部 Key。
+     * 不需要任何锁，可与写入并发使用：迭代期间写入的版本可能被看到，也可能看不到
+     * （它们的序列号大于迭代开始时已发布的序列号，上层按快照过滤）。
+     * 视图在 MemTable 存活期间有效，调用者需保证 MemTable 比迭代器活得久。
+     */
+    class Iterator : public InternalIterator {
+    public:
+        explicit Iterator(const MemTable* mem) : iter_(&mem->table_) {}
+
+        bool Valid() const override { return iter_.Valid(); }
+
+        void SeekToFirst() override {
+            iter_.SeekToFirst();
+            Load();
+        }
+
+        void SeekToLast() override {
+            iter_.SeekToLast();
+            Load();
+        }
+
+        void Seek(std::string_view target) override {
+            LookupKey lookup(target);
+            iter_.Seek(lookup.entry());
+            Load();
+        }
+
+        void Next() override {
+            if (!iter_.Valid()) return;
+            iter_.Next();
+            Load();
+        }
+
+        void Prev() override {
+            if (!iter_.Valid()) return;
+            iter_.Prev();
+            Load();
+        }
+
+        std::string_view key() const override { return key_; }
+        std::string_view value() const override { return value_; }
+
+    private:
+        Table::Iterator iter_;
+        std::string_view key_;
+        std::string_view value_;
+
+        void Load() {
+            if (!iter_.Valid()) return;
+            const char* entry = iter_.key();
+            key_ = decode_key(entry);
+            value_ = decode_value(entry);
+        }
+    };
+
+private:
+    /// 查找用的 Key：与条目同样以长度前缀的内部 Key 开头（后面没有值），短 Key 编码在栈上
+    class LookupKey {
+    public:
+        /// 查找 (user_key, sequence) 处或之后的第一个条目，即快照 sequence 可见的最新版本
+        LookupKey(std::string_view user_key, SequenceNumber sequence) {
+            char* p = Reserve(user_key.size() + kInternalKeyTagSize);
+            if (!user_key.empty()) std::memcpy(p, user_key.data(), user_key.size());
+            encode_fixed64(p + user_key.size(), pack_sequence_and_type(sequence, ValueType::kValue));
+        }
+
+        /// 查找内部 Key internal_key 处或之后的第一个条目
+        explicit LookupKey(std::string_view internal_key) {
+            char* p = Reserve(internal_key.size());
+            if (!internal_key.empty()) std::memcpy(p, internal_key.data(), internal_key.size());
+        }
+
+        LookupKey(const LookupKey&) = delete;
+        LookupKey& operator=(const LookupKey&) = delete;
+
+        const char* entry() const { return entry_; }
+
+    private:
+        char space_[128];
+        std::string heap_;
+        const char* entry_ = nullptr;
+
+        /// 写入长度前缀，返回内部 Key 的写入位置
+        char* Reserve(size_t internal_len) {
+            char* lookup = space_;
+            size_t needed = varint32_length(static_cast<uint32_t>(internal_len)) + internal_len;
+            if (needed > sizeof(space_)) {
+                heap_.resize(needed);
+                lookup = heap_.data();
+            }
+            entry_ = lookup;
+            return encode_varint32(lookup, static_cast<uint32_t>(internal_len));
+        }
+    };
+
+    const Comparator* user_comparator_;
+    Arena arena_;
+    Table table_;
+    std::atomic<SequenceNumber> last_sequence_{0};
+
+    /// 条目开头的长度前缀内部 Key（条目由本类写入，长度前缀总是完整的）
+    static std::string_view decode_key(const char* entry) {
+        uint32_t len = 0;
+        const char* p = get_varint32_ptr(entry, entry + kMaxVarint32Length, &len);
+        return std::string_view(p, len);
+    }
+
+    static ParsedInternalKey decode_internal_key(const char* entry) {
+        std::string_view internal_key = decode_key(entry);
+        uint64_t tag = decode_fixed64(internal_key.data() + internal_key.size() - kInternalKeyTagSize);
+        ParsedInternalKey result;
+        result.user_key = extract_user_key(internal_key);
+        result.sequence = tag >> 8;
+        result.type = static_cast<ValueType>(tag & 0xFF);
+        return result;
+    }
+
+    static std::string_view decode_value(const char* entry) {
+        std::string_view key = decode_key(entry);
+        const char* p = key.data() + key.size();
+        uint32_t len = 0;
+        p = get_varint32_ptr(p, p + kMaxVarint32Length, &len);
+        return std::string_view(p, len);
+    }
+};
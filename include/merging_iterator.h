@@ -0,0 +1,157 @@
+#pragma once
+
+#include "comparator.h"
+#include "iterator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 把多个有序的 InternalIterator 归并成一个按内部 Key 有序的序列
+ *
+ * 子迭代器按从新到旧的顺序传入（活跃 MemTable、Immutable MemTable、L0 新到旧、L1、L2 ...）。
+ * 同一个 UserKey 的不同版本按序列号从新到旧依次产出，由上层（DBIterator / Compaction）
+ * 按快照决定取舍；内部 Key 完全相同的条目（旧格式 SSTable 中没有序列号、统一视为 0 的版本，
+ * 或落盘前后同时可见的同一条目）只产出下标最小（最新）的子迭代器中的那一条。
+ *
+ * 实现：所有有效的子迭代器放在一个二叉堆中，正向时堆顶是 Key 最小者、反向时是 Key 最大者，
+ * Key 相同时下标小者在上。每次 Next / Prev 弹出所有与当前 Key 相等的子迭代器，
+ * 各自移动一步后放回，代价为 O(m log k)（m 为相等的条目数，k 为子迭代器数）。
+ *
+ * 切换方向时（Next 之后 Prev，或反之），先把所有子迭代器重新定位到当前 Key 的另一侧，
+ * 再重建堆，代价为 O(k) 次 Seek。
+ *
+ * @note 本类非线程安全。
+ */
+class MergingIterator : public InternalIterator {
+public:
+    /**
+     * @param comparator 内部 Key 的比较器（与所有子迭代器的顺序一致，通常是 InternalKeyComparator）
+     * @param children 子迭代器，按从新到旧排列
+     */
+    MergingIterator(const Comparator* comparator,
+                    std::vector<std::unique_ptr<InternalIterator>> children)
+        : comparator_(comparator), children_(std::move(children)) {
+        heap_.reserve(children_.size());
+    }
+
+    bool Valid() const override { return !heap_.empty(); }
+
+    void SeekToFirst() override {
+        for (auto& child : children_) child->SeekToFirst();
+        RebuildHeap(Direction::kForward);
+    }
+
+    void SeekToLast() override {
+        for (auto& child : children_) child->SeekToLast();
+        RebuildHeap(Direction::kReverse);
+    }
+
+    void Seek(std::string_view target) override {
+        for (auto& child : children_) child->Seek(target);
+        RebuildHeap(Direction::kForward);
+    }
+
+    void Next() override {
+        if (!Valid()) return;
+        if (direction_ != Direction::kForward) {
+            // 所有子迭代器都移到当前 Key 之后
+            std::string current(key());
+            for (auto& child : children_) {
+                child->Seek(current);
+                if (child->Valid() && comparator_->Compare(child->key(), current) == 0) child->Next();
+            }
+            RebuildHeap(Direction::kForward);
+            return;
+        }
+        AdvanceCurrentKey();
+    }
+
+    void Prev() override {
+        if (!Valid()) return;
+        if (direction_ != Direction::kReverse) {
+            // 所有子迭代器都移到当前 Key 之前
+            std::string current(key());
+            for (auto& child : children_) {
+                child->Seek(current);
+                if (child->Valid()) {
+                    child->Prev();
+                } else {
+                    child->SeekToLast();
+                }
+            }
+            RebuildHeap(Direction::kReverse);
+            return;
+        }
+        AdvanceCurrentKey();
+    }
+
+    std::string_view key() const override { return Current()->key(); }
+    std::string_view value() const override { return Current()->value(); }
+
+private:
+    enum class Direction { kForward, kReverse };
+
+    const Comparator* comparator_;
+    std::vector<std::unique_ptr<InternalIterator>> children_;
+    std::vector<size_t> heap_;              ///< 有效子迭代器的下标
+    std::vector<size_t> advanced_;          ///< AdvanceCurrentKey 的临时空间
+    Direction direction_ = Direction::kForward;
+
+    InternalIterator* Current() const { return children_[heap_.front()].get(); }
+
+    /// std::push_heap 等使用的“a 应排在 b 之下”
+    bool Below(size_t a, size_t b) const {
+        int c = comparator_->Compare(children_[a]->key(), children_[b]->key());
+        if (c == 0) return a > b;
+        return direction_ == Direction::kForward ? c > 0 : c < 0;
+    }
+
+    void RebuildHeap(Direction direction) {
+        direction_ = direction;
+        heap_.clear();
+        for (size_t i = 0; i < children_.size(); ++i) {
+            if (children_[i]->Valid()) heap_.push_back(i);
+        }
+        std::make_heap(heap_.begin(), heap_.end(), [this](size_t a, size_t b) { return Below(a, b); });
+    }
+
+    /**
+     * @brief 沿当前方向越过当前 Key：弹出所有 Key 相等的子迭代器，各移动一步后放回
+     *
+     * 胜出者最后移动，比较期间它的 key() 视图保持有效，不需要拷贝当前 Key。
+     */
+    void AdvanceCurrentKey() {
+        auto below = [this](size_t a, size_t b) { return Below(a, b); };
+        std::pop_heap(heap_.begin(), heap_.end(), below);
+        size_t winner = heap_.back();
+        heap_.pop_back();
+
+        advanced_.clear();
+        std::string_view current = children_[winner]->key();
+        while (!heap_.empty() && comparator_->Compare(Current()->key(), current) == 0) {
+            std::pop_heap(heap_.begin(), heap_.end(), below);
+            advanced_.push_back(heap_.back());
+            heap_.pop_back();
+        }
+        advanced_.push_back(winner);
+
+        for (size_t index : advanced_) {
+            InternalIterator* child = children_[index].get();
+            if (direction_ == Direction::kForward) {
+                child->Next();
+            } else {
+                child->Prev();
+            }
+            if (child->Valid()) {
+                heap_.push_back(index);
+                std::push_heap(heap_.begin(), heap_.end(), below);
+            }
+        }
+    }
+};
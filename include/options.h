@@ -0,0 +1,340 @@
+#pragma once
+
+#include "comparator.h"
+#include "compression.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class BlockCache;
+class Snapshot;
+class Statistics;
+
+/**
+ * @brief WAL 同步（落盘）策略
+ *
+ * - kPerWrite: 每次写入都执行 fwrite + fflush + fsync（最强持久性，吞吐受限于磁盘 fsync 速率）。
+ * - kGroupCommit: 组提交。并发写入者把日志记录排入队列，由一个 Leader 线程
+ *   一次性写入整批记录并只做一次 fsync，Sync 完成后统一唤醒所有等待者。
+ *   持久性与 kPerWrite 相同（返回即已落盘），但多个写入者共摊一次 fsync 的代价。
+ * - kPeriodic: 周期性/异步同步。写入只刷到 OS Page Cache（fflush），
+ *   由后台线程每隔 periodic_sync_interval 执行一次 fsync。
+ *   进程崩溃不丢数据，但断电时可能丢失最近一个周期内的写入。
+ */
+enum class WalSyncMode {
+    kPerWrite,
+    kGroupCommit,
+    kPeriodic
+};
+
+/**
+ * @brief SSTable 的构建与读取选项
+ */
+struct TableOptions {
+    /**
+     * @brief Key 的排序方式（构建与读取都必须一致）
+     *
+     * KVStore 会用 KVStoreOptions::comparator 覆盖此字段。
+     */
+    const Comparator* comparator = BytewiseComparator();
+
+    /**
+     * @brief Key 是否为带序列号的内部 Key（构建时生效）
+     *
+     * 为 true 时写出格式版本 Footer::kFormatInternalKeys：Key 为 | UserKey | Tag(8B) |，
+     * 按 InternalKeyComparator(comparator) 升序添加，Bloom Filter 建立在 UserKey 上。
+     * KVStore 写出的表总是设为 true；读取端按 Footer 中的格式版本自动识别。
+     */
+    bool internal_keys = false;
+
+    /**
+     * @brief Bloom Filter 每个 Key 占用的位数（构建时生效）
+     *
+     * 10 位约 1% 假阳性率；设为 0 则不生成过滤器。
+     */
+    int bloom_bits_per_key = 10;
+
+    /**
+     * @brief Data Block 中每隔多少个 Entry 设置一个重启点（构建时生效）
+     *
+     * 越大前缀压缩率越高，但点查需要顺序解码的 Entry 越多。
+     */
+    int block_restart_interval = 16;
+
+    /**
+     * @brief Data Block 的压缩算法（构建时生效）
+     *
+     * 压缩后节省不到 1/8 的 Block 以原始形式存储；本次构建未编译进该算法时同样退回不压缩。
+     * 读取端根据每个 Block 尾部的类型字节解压，与此选项无关。
+     */
+    CompressionType compression = CompressionType::kNone;
+
+    /// Zstd 压缩级别（仅 compression 为 kZstd 时生效）
+    int zstd_level = 3;
+
+    /// 读取时使用的共享块缓存；为空表示每次都从磁盘读取 Data Block
+    std::shared_ptr<BlockCache> block_cache;
+
+    /**
+     * @brief Index / Filter Block 是否也放入 block_cache（计入缓存容量）
+     *
+     * 为 false 时它们常驻在各自的 SSTableReader 中，不受缓存容量约束。
+     */
+    bool cache_index_and_filter_blocks = false;
+
+    /**
+     * @brief 放入缓存的 Index / Filter Block 是否固定（不参与 LRU 淘汰）
+     *
+     * 仅在 cache_index_and_filter_blocks 为 true 时生效。
+     * 为 false 时它们可能被淘汰，下次查询会重新从磁盘读取并解析。
+     */
+    bool pin_index_and_filter_blocks = true;
+
+    /**
+     * @brief 以只读内存映射 (mmap) 的方式读取整张表（读取时生效）
+     *
+     * 未压缩的 Data Block 直接在映射上解析，值钉住映射本身，不经过 block_cache、也不做拷贝；
+     * 压缩的 Block 仍按原路径解压后放入缓存。打开时对 Index / Filter 区域给出 MADV_WILLNEED、
+     * 对 Data 区域给出 MADV_RANDOM 提示。映射失败或平台不支持时自动退回 pread。
+     * 适合数据集能被 Page Cache 容纳的只读 / 读多写少负载。
+     */
+    bool use_mmap_reads = false;
+};
+
+/**
+ * @brief KVStore 的可配置选项
+ *
+ * 所有字段都有合理的默认值，默认行为与最初的实现一致（每次写入都 fsync）。
+ */
+struct KVStoreOptions {
+    /**
+     * @brief Key 的排序方式，默认按字节序
+     *
+     * 比较器的名字记录在 MANIFEST 中，之后必须用同名的比较器打开同一目录。
+     * 指针由调用者持有，生命周期必须长于 KVStore。
+     */
+    const Comparator* comparator = BytewiseComparator();
+
+    /// WAL 同步策略，默认每次写入都 fsync
+    WalSyncMode sync_mode = WalSyncMode::kPerWrite;
+
+    /**
+     * @brief 组提交时 Leader 最多等待多久来攒批（仅 kGroupCommit 生效）
+     *
+     * 为 0 时 Leader 不主动等待，只带走“它开始写盘时已经在排队”的写入者；
+     * 设为几十到几百微秒可以在低并发时也攒出更大的批次，代价是单次写入延迟略增。
+     */
+    std::chrono::microseconds group_commit_max_delay{0};
+
+    /// 单个组提交批次的最大字节数，达到后 Leader 不再等待、立即落盘
+    std::size_t group_commit_max_bytes = 1 << 20;
+
+    /// 周期同步模式下后台 fsync 的间隔（仅 kPeriodic 生效）
+    std::chrono::milliseconds periodic_sync_interval{100};
+
+    /**
+     * @brief 单个 WAL 段的大小上限（字节），0 表示取 memtable_size_limit 的 9/8
+     *
+     * 活跃段写满后封存为 wal_<N>.log 并切换到新段；冻结 MemTable 时同样切换。
+     * 新段按该大小预分配，因此正常情况下一个段恰好容纳一个 MemTable 的日志。
+     */
+    std::uint64_t wal_segment_size = 0;
+
+    /// 新 WAL 段是否用 fallocate 预分配 wal_segment_size 字节（之后的 Sync 只需 fdatasync）
+    bool wal_preallocate = true;
+
+    /**
+     * @brief 最多保留多少个已落盘的 WAL 段供复用，0 表示直接删除
+     *
+     * 复用的段已经分配好磁盘块，覆盖写入不需要再分配空间或修改文件大小。
+     */
+    std::size_t wal_recycle_limit = 2;
+
+    /**
+     * @brief 以 O_DIRECT 写 WAL（仅 Linux）：按 4KB 对齐整块写入，绕过 Page Cache
+     *
+     * WAL 只在恢复时读取一次，不必占用 Page Cache；文件系统不支持时退回普通写入。
+     */
+    bool wal_direct_io = false;
+
+    /**
+     * @brief 后台线程（落盘、Compaction、周期同步）绑定的 CPU，-1 表示不绑定（仅 Linux 生效）
+     *
+     * ShardedKVStore 把每个分片的后台线程绑定到该分片的核心上，分片之间不争用 CPU 缓存。
+     */
+    int background_cpu = -1;
+
+    /**
+     * @brief 启动恢复使用的线程数，1 表示在构造线程上顺序重放 WAL（默认）
+     *
+     * 大于 1 时：构造线程顺序读取并校验各 WAL 段，把每个操作按 Key 的哈希分发给
+     * recovery_threads 个重放线程，各自写入独立的 MemTable（同一 Key 总在同一个线程上，
+     * 先后由序列号决定）；与此同时，另开 recovery_threads 个线程打开 MANIFEST 中全部
+     * SSTable 的读取器（Index 与 Filter），重启后的第一批读请求不必再等待。
+     * 重放出的 MemTable 作为 Immutable MemTable 交给后台落盘。
+     */
+    std::size_t recovery_threads = 1;
+
+    /**
+     * @brief 恢复结束时直接把重放出的 MemTable 写成 L0 SSTable，并回收对应的 WAL 段
+     *
+     * 恢复的数据不必留在内存中等待后台落盘；代价是构造函数多一次 SSTable 写入与 fsync。
+     */
+    bool flush_recovered_memtables = false;
+
+    /// 活跃 MemTable 的大小上限（字节），超过后冻结为 Immutable 并由后台线程落盘为 L0 SSTable
+    std::size_t memtable_size_limit = 4 << 20;
+
+    /**
+     * @brief 允许同时存在的 Immutable MemTable 数量上限
+     *
+     * 落盘速度跟不上写入速度时，达到该上限后新的写入会阻塞，直到后台完成一次落盘（写入停顿）。
+     */
+    std::size_t max_immutable_memtables = 2;
+
+    /**
+     * @brief Immutable MemTable 数量达到该值时开始减速写入，0 表示不减速（默认）
+     *
+     * 写入控制器的三组软 / 硬限制（Immutable MemTable 数量、L0 文件数、待 Compaction 字节数）：
+     * - 任一指标达到软限制：每批写入按 delayed_write_rate 的令牌桶等待，指标越接近硬限制
+     *   允许的速率越低（线性下降，最低为 delayed_write_rate 的 1/20）；
+     * - 任一指标达到硬限制：写入阻塞，直到后台落盘 / Compaction 把它降下来。
+     * 减速把延迟均匀摊到每一批写入上，持续过载时 p99 保持平稳，而不是周期性地停顿数秒。
+     * Immutable MemTable 的硬限制即 max_immutable_memtables。
+     */
+    std::size_t immutable_memtables_slowdown_trigger = 0;
+
+    /**
+     * @brief 减速状态下允许的最大写入速率（字节/秒，按 WAL 记录大小计）
+     *
+     * 指标刚达到软限制时使用该速率，之后随压力线性降低。
+     */
+    std::uint64_t delayed_write_rate = 16 << 20;
+
+    /// LSM-Tree 的层数（L0 .. L<num_levels-1>），最后一层为最底层
+    int num_levels = 7;
+
+    /// L0 文件数达到该值时触发 L0 -> L1 的 Compaction；0 表示关闭自动 Compaction
+    int level0_compaction_trigger = 4;
+
+    /**
+     * @brief L0 文件数达到该值时开始减速写入，0 表示不减速（默认）
+     *
+     * 与 level0_stop_writes_trigger 一样只在自动 Compaction 开启时生效（否则 L0 不会减少）。
+     */
+    int level0_slowdown_writes_trigger = 0;
+
+    /// L0 文件数达到该值时阻塞写入，直到 Compaction 把 L0 降下来；0 表示不阻塞（默认）
+    int level0_stop_writes_trigger = 0;
+
+    /**
+     * @brief 待 Compaction 字节数的估计值达到该值时开始减速写入，0 表示不减速（默认）
+     *
+     * 估计值为：L0 达到 level0_compaction_trigger 时的 L0 总大小，加上其余各层（最底层除外）
+     * 超出目标大小的部分。
+     */
+    std::uint64_t soft_pending_compaction_bytes_limit = 0;
+
+    /// 待 Compaction 字节数的估计值达到该值时阻塞写入；0 表示不阻塞（默认）
+    std::uint64_t hard_pending_compaction_bytes_limit = 0;
+
+    /**
+     * @brief L1 的目标大小（字节）；L<n> 的目标为 max_bytes_for_level_base * multiplier^(n-1)
+     *
+     * 某层总大小超过目标时，后台线程从该层挑选一个文件与下一层合并。
+     */
+    std::size_t max_bytes_for_level_base = 10 << 20;
+
+    /// 相邻两层目标大小的倍数
+    int max_bytes_for_level_multiplier = 10;
+
+    /// Compaction 输出文件的目标大小（字节），达到后切换到新文件
+    std::size_t target_file_size = 2 << 20;
+
+    /**
+     * @brief Compaction 写入的限速（字节/秒），0 表示不限速
+     *
+     * 限速只作用于 Compaction，不影响 MemTable 落盘，避免前台写入因此停顿。
+     */
+    std::uint64_t compaction_bytes_per_sec = 0;
+
+    /**
+     * @brief MANIFEST 的大小上限（字节），0 表示不限制
+     *
+     * 每次落盘 / Compaction 都向 MANIFEST 追加一条记录；首条快照之后追加的记录超过上限时，
+     * 写入一个新的 MANIFEST（首条记录为当前文件集合的快照）并删除旧的，
+     * 保证启动时需要重放的记录数有界。
+     */
+    std::uint64_t max_manifest_file_size = 64 << 20;
+
+    /**
+     * @brief 键值分离的阈值（字节）：不小于该值的 Value 落盘时写入 Blob 文件，0 表示不分离（默认）
+     *
+     * 分离后 SSTable 中只保存 24 字节的 BlobIndex，Compaction 只搬动 Key 与指针，
+     * 大 Value 不再随层层合并被反复重写；代价是读取多一次 Blob 文件的随机读。
+     * Value 在落盘（与 Compaction）时分离，WAL 与 MemTable 中仍保存完整的 Value。
+     */
+    std::size_t min_blob_size = 0;
+
+    /// 单个 Blob 文件的大小上限（字节），达到后切换到新文件
+    std::uint64_t blob_file_size = 256 << 20;
+
+    /**
+     * @brief 是否回收 Blob 文件中的垃圾（被覆盖、删除的 Value）
+     *
+     * Compaction 丢弃或搬迁 BlobIndex 时累计各 Blob 文件的失效字节（discard 统计）；
+     * 失效比例达到 blob_garbage_collection_ratio 的文件，其余存活的 Value 在下一次
+     * 经过它的 Compaction 中被搬到新的 Blob 文件。没有其他 Compaction 可做时，后台线程
+     * 会专门为失效比例最高的文件安排一次 Compaction。文件不再被任何 SSTable 引用后删除。
+     */
+    bool enable_blob_garbage_collection = true;
+
+    /// 触发 Blob GC 的失效比例（失效字节 / Value 总字节）
+    double blob_garbage_collection_ratio = 0.5;
+
+    /// SSTable 的构建与读取选项
+    TableOptions table_options;
+
+    /**
+     * @brief 按层级指定压缩算法，覆盖 table_options.compression
+     *
+     * 第 i 项用于 Level i，层数多于配置项时沿用最后一项；为空时所有层级都使用
+     * table_options.compression。典型配置为热数据层 kLz4、冷数据层 kZstd，
+     * 例如 {kNone, kLz4, kZstd}。
+     */
+    std::vector<CompressionType> compression_per_level;
+
+    /**
+     * @brief 块缓存容量（字节）
+     *
+     * 仅在 table_options.block_cache 为空时生效：KVStore 会创建一个该容量的缓存；
+     * 为 0 则不使用缓存。多个 KVStore 可以通过 table_options.block_cache 共享同一个缓存。
+     */
+    std::size_t block_cache_capacity = 8 << 20;
+
+    /**
+     * @brief 运行时统计（计数器与延迟直方图，见 statistics.h），为空表示不收集（默认）
+     *
+     * 收集时每次读写多两次读取时钟与几次无竞争的原子加；可以在多个 KVStore 之间共享，
+     * 结果通过 KVStore::get_property("kv.stats") / ("kv.prometheus") 导出。
+     */
+    std::shared_ptr<Statistics> statistics;
+};
+
+/**
+ * @brief 单次读请求（get / new_iterator / scan）的选项
+ */
+struct ReadOptions {
+    /**
+     * @brief 读取的快照（KVStore::get_snapshot() 返回）
+     *
+     * 为空时：get 读取每个 Key 当前最新的版本；迭代器与 scan 使用创建时已发布的序列号作为隐式快照。
+     */
+    const Snapshot* snapshot = nullptr;
+
+    /// 读到的 Data Block 是否放入块缓存（大范围的一次性扫描可关闭，避免冲掉热点数据）
+    bool fill_cache = true;
+};
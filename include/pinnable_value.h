@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * @brief 零拷贝读取的结果：指向存储内部内存的视图，并“钉住”(pin) 该内存
+ *
+ * KVStore::get(key, &value) 不再把值拷贝进 std::string，而是让 PinnableValue 直接指向
+ * - MemTable 的 Arena 中的条目（钉住该 MemTable），或
+ * - 块缓存中已解压的 Data Block（钉住该 Block）。
+ *
+ * 钉住的内存在 PinnableValue 存活期间始终有效：MemTable 被落盘释放、Block 被缓存淘汰，
+ * 只是放弃了各自的引用，内存在最后一个引用（可能就是本对象）释放时才回收。
+ * 因此 4–64 KB 的大值读取只需要一次查找，没有任何按值大小计费的拷贝。
+ *
+ * 需要长期保存时调用 to_string() 拷贝出来，或用 reset() 尽早释放钉住的内存。
+ *
+ * @note 本类非线程安全；可以移动，不可拷贝（避免无意中延长大块内存的生命周期）。
+ */
+class PinnableValue {
+public:
+    PinnableValue() = default;
+
+    PinnableValue(PinnableValue&& other) noexcept { *this = std::move(other); }
+
+    PinnableValue& operator=(PinnableValue&& other) noexcept {
+        if (this == &other) return *this;
+        owner_ = std::move(other.owner_);
+        owned_ = other.owned_;
+        if (owned_) {
+            // 短字符串的移动是拷贝，视图必须重新指向自己的缓冲区
+            size_t offset = static_cast<size_t>(other.view_.data() - other.buffer_.data());
+            buffer_ = std::move(other.buffer_);
+            view_ = std::string_view(buffer_.data() + offset, other.view_.size());
+        } else {
+            buffer_.clear();
+            view_ = other.view_;
+        }
+        other.reset();
+        return *this;
+    }
+
+    PinnableValue(const PinnableValue&) = delete;
+    PinnableValue& operator=(const PinnableValue&) = delete;
+
+    /**
+     * @brief 指向 owner 所拥有的内存中的 view，并持有 owner 的引用
+     *
+     * @param view 值的视图，必须位于 owner 管理的内存中
+     * @param owner 被钉住的对象（MemTable、缓存的 Block 等）
+     */
+    void pin(std::string_view view, std::shared_ptr<const void> owner) {
+        owner_ = std::move(owner);
+        owned_ = false;
+        buffer_.clear();
+        view_ = view;
+    }
+
+    /// 拷贝一份值由自身持有（没有可钉住的内存时使用）
+    void assign(std::string_view value) {
+        owner_.reset();
+        owned_ = true;
+        buffer_.assign(value.data(), value.size());
+        view_ = buffer_;
+    }
+
+    /// 去掉视图开头的 n 个字节（例如 SSTable Value 的类型字节）
+    void remove_prefix(size_t n) { view_.remove_prefix(n); }
+
+    /// 释放钉住的内存，恢复为空
+    void reset() {
+        owner_.reset();
+        owned_ = false;
+        buffer_.clear();
+        view_ = std::string_view();
+    }
+
+    /// 是否钉住了外部内存（false 表示为空或值由自身持有）
+    bool pinned() const { return owner_ != nullptr; }
+
+    const char* data() const { return view_.data(); }
+    size_t size() const { return view_.size(); }
+    bool empty() const { return view_.empty(); }
+
+    /// 值的视图（在本对象被修改或析构之前有效）
+    std::string_view view() const { return view_; }
+    operator std::string_view() const { return view_; }
+
+    std::string to_string() const { return std::string(view_); }
+
+private:
+    std::shared_ptr<const void> owner_;
+    bool owned_ = false;   ///< 视图指向自身的 buffer_（assign 之后，可能又被 remove_prefix 缩短）
+    std::string buffer_;
+    std::string_view view_;
+};
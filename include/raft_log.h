@@ -0,0 +1,362 @@
+#pragma once
+#define _CRT_SECURE_NO_WARNINGS // 禁用 fopen 等不安全警告
+
+#include "coding.h"
+#include "crc32c.h"
+#include "filename.h"
+#include "wal_reader.h"
+#include "wal_record.h"
+#include "wal_writer.h"
+#include "write_batch.h"
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file raft_log.h
+ * @brief Raft 的持久化状态：日志条目的编码、raft.log 与 RAFT_META
+ */
+
+/**
+ * @brief 一条 Raft 日志条目
+ *
+ * 条目直接使用 WAL 的日志记录格式，即一条带序列号的 kBatch 记录：
+ * +--------------------------------+-------------+----------------------+---------------+
+ * | Header (Checksum/KeyLen/...)   | Term (8B)   | WriteBatch rep       | Index (8B)    |
+ * +--------------------------------+-------------+----------------------+---------------+
+ *   记录的 Key 是 Term，Value 是 WriteBatch 的二进制表示，Sequence 是日志索引。
+ *
+ * 同一份字节既写入 raft.log，也原样放进 AppendEntries，接收方用记录自带的 Checksum 校验，
+ * 复制不需要另一套编码。Value 为空批次的条目是 Leader 当选时追加的 no-op。
+ */
+struct RaftEntry {
+    uint64_t term = 0;
+    uint64_t index = 0;
+    std::string record;  ///< 编码后的日志记录
+
+    /// 条目携带的 WriteBatch 负载
+    std::string_view batch() const {
+        constexpr size_t kOverhead = kLogRecordHeaderSize + 8 + kLogRecordSequenceSize;
+        return std::string_view(record).substr(kLogRecordHeaderSize + 8, record.size() - kOverhead);
+    }
+};
+
+/**
+ * @brief 构造一条 Raft 条目
+ *
+ * @param batch WriteBatch::rep()；空批次（只有 Count=0 头部）表示 no-op
+ */
+inline RaftEntry make_raft_entry(uint64_t term, uint64_t index, std::string_view batch) {
+    char key[8];
+    encode_fixed64(key, term);
+    RaftEntry entry;
+    entry.term = term;
+    entry.index = index;
+    entry.record = encode_sequenced_log_record(LogType::kBatch, std::string_view(key, sizeof(key)), batch);
+    seal_log_record(&entry.record, index);
+    return entry;
+}
+
+/**
+ * @brief 把一条已通过校验的日志记录解释为 Raft 条目
+ *
+ * view 来自 WalReader::next() 或 decode_log_record()，记录的字节从 view.key 之前的 Header 开始。
+ *
+ * @return false 如果记录不是 Raft 条目的格式，或其中的 WriteBatch 结构损坏
+ */
+inline bool parse_raft_entry(const LogRecordView& view, RaftEntry* entry) {
+    if (view.type != LogType::kBatch || view.key_encoding != KeyEncoding::kBinary || view.key.size() != 8 ||
+        view.sequence == 0 || !WriteBatch::validate(view.value)) {
+        return false;
+    }
+    entry->term = decode_fixed64(view.key.data());
+    entry->index = view.sequence;
+    entry->record.assign(view.key.data() - kLogRecordHeaderSize, view.size);
+    return true;
+}
+
+/**
+ * @brief 一个节点的 Raft 持久化状态
+ *
+ * - **raft.log**：快照位置之后的条目，按索引顺序追加（WalWriter，可预分配），
+ *   与 Leader 冲突时截断后缀；启动时用 WalReader 读出有效前缀，崩溃留下的半条记录被截掉。
+ * - **RAFT_META**：currentTerm、votedFor 与快照位置 (snapshot_index, snapshot_term)，
+ *   每次修改都写临时文件、fsync 后原子改名。
+ *
+ * 压缩（compact）先持久化新的快照位置，再把保留的条目重写为新的 raft.log；
+ * 在两步之间崩溃时，旧文件中 <= snapshot_index 的条目在启动时被跳过。
+ *
+ * @note 本类非线程安全，由调用者串行化；唯一的例外是 sync()，
+ *       它可以与 append() / truncate() 并发，使 fdatasync 不阻塞新条目的追加。
+ */
+class RaftLog {
+public:
+    /**
+     * @brief 打开（或创建）dir 中的 Raft 状态
+     *
+     * @param dir 目录（不存在时创建）
+     * @param preallocate_size raft.log 的预分配大小（字节），0 表示不预分配
+     * @throw std::runtime_error RAFT_META 损坏或文件无法打开
+     */
+    explicit RaftLog(const std::filesystem::path& dir, uint64_t preallocate_size = 0)
+        : dir_(dir), path_(dir / kRaftLogFileName) {
+        writer_options_.preallocate_size = preallocate_size;
+        std::filesystem::create_directories(dir_);
+        load_meta();
+        writer_ = std::make_unique<WalWriter>(path_, load_entries(), /*reuse=*/false, writer_options_);
+    }
+
+    RaftLog(const RaftLog&) = delete;
+    RaftLog& operator=(const RaftLog&) = delete;
+
+    // ---- 选举状态 ----
+
+    uint64_t term() const { return term_; }
+
+    /// 本任期投票给的节点，0 表示尚未投票
+    uint64_t voted_for() const { return voted_for_; }
+
+    /**
+     * @brief 持久化 currentTerm 与 votedFor（返回前已 fsync）
+     *
+     * @throw std::runtime_error 写入失败
+     */
+    void save_hard_state(uint64_t term, uint64_t voted_for) {
+        write_meta(term, voted_for, snapshot_index_, snapshot_term_);
+        term_ = term;
+        voted_for_ = voted_for;
+    }
+
+    // ---- 日志 ----
+
+    /// 最近一次快照（压缩）覆盖到的索引，0 表示没有快照
+    uint64_t snapshot_index() const { return snapshot_index_; }
+    uint64_t snapshot_term() const { return snapshot_term_; }
+
+    /// 内存中第一条条目的索引
+    uint64_t first_index() const { return snapshot_index_ + 1; }
+    uint64_t last_index() const { return snapshot_index_ + entries_.size(); }
+    uint64_t last_term() const { return entries_.empty() ? snapshot_term_ : entries_.back().term; }
+
+    /**
+     * @brief index 处条目的 Term
+     *
+     * index == snapshot_index() 时返回快照的 Term；已被压缩或超出末尾时返回 std::nullopt。
+     */
+    std::optional<uint64_t> term_at(uint64_t index) const {
+        if (index == snapshot_index_) return snapshot_term_;
+        if (index < snapshot_index_ || index > last_index()) return std::nullopt;
+        return entries_[index - first_index()].term;
+    }
+
+    /// first_index() <= index <= last_index()
+    const RaftEntry& entry(uint64_t index) const { return entries_[index - first_index()]; }
+
+    /**
+     * @brief 读取 [lo, hi] 中的条目，总字节数不超过 max_bytes（但至少返回一条）
+     *
+     * first_index() <= lo <= hi <= last_index()
+     */
+    std::vector<RaftEntry> entries(uint64_t lo, uint64_t hi, size_t max_bytes) const {
+        std::vector<RaftEntry> result;
+        size_t bytes = 0;
+        for (uint64_t index = lo; index <= hi; ++index) {
+            const RaftEntry& e = entry(index);
+            if (!result.empty() && bytes + e.record.size() > max_bytes) break;
+            bytes += e.record.size();
+            result.push_back(e);
+        }
+        return result;
+    }
+
+    /**
+     * @brief 追加一条条目（写入文件，但不保证落盘，见 sync()）
+     *
+     * @throw std::runtime_error 索引不连续或写入失败
+     */
+    void append(RaftEntry entry) {
+        if (entry.index != last_index() + 1) {
+            throw std::runtime_error("Raft log append out of order: index " + std::to_string(entry.index) +
+                                     " after " + std::to_string(last_index()));
+        }
+        offsets_.push_back(writer_->size());
+        writer_->append(entry.record);
+        entries_.push_back(std::move(entry));
+    }
+
+    /**
+     * @brief 删除 index 及之后的全部条目（与 Leader 的日志冲突）
+     *
+     * index 必须大于 snapshot_index()：快照覆盖的条目已提交，不会被截断。
+     */
+    void truncate(uint64_t index) {
+        if (index <= snapshot_index_) throw std::runtime_error("Raft log truncate below snapshot");
+        if (index > last_index()) return;
+        size_t keep = static_cast<size_t>(index - first_index());
+        writer_->truncate(offsets_[keep]);
+        entries_.resize(keep);
+        offsets_.resize(keep);
+    }
+
+    /**
+     * @brief 把已追加的条目刷入磁盘
+     *
+     * 可以与 append() / truncate() 并发：刷入的至少是调用前已追加的全部条目。
+     *
+     * @throw std::runtime_error 同步失败
+     */
+    void sync() {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        writer_->sync();
+    }
+
+    /**
+     * @brief 丢弃 index 及之前的条目，快照位置前移到 index（状态机已持久化到 index 之后调用）
+     *
+     * @throw std::runtime_error index 超出末尾或写入失败
+     */
+    void compact(uint64_t index) {
+        if (index <= snapshot_index_) return;
+        std::optional<uint64_t> term = term_at(index);
+        if (!term) throw std::runtime_error("Raft log compact beyond last index");
+        write_meta(term_, voted_for_, index, *term);
+        size_t drop = static_cast<size_t>(index - snapshot_index_);
+        entries_.erase(entries_.begin(), entries_.begin() + static_cast<std::ptrdiff_t>(drop));
+        snapshot_index_ = index;
+        snapshot_term_ = *term;
+        rewrite();
+    }
+
+    /**
+     * @brief 安装快照：若 (index, term) 与本地条目吻合则保留其后的条目，否则丢弃全部条目
+     *
+     * @throw std::runtime_error 写入失败
+     */
+    void reset(uint64_t index, uint64_t term) {
+        if (term_at(index) == term) {
+            compact(index);
+            return;
+        }
+        write_meta(term_, voted_for_, index, term);
+        entries_.clear();
+        snapshot_index_ = index;
+        snapshot_term_ = term;
+        rewrite();
+    }
+
+    /// raft.log 中有效数据的字节数
+    uint64_t bytes() const { return writer_->size(); }
+
+private:
+    static constexpr size_t kMetaSize = 4 + 8 * 4;  ///< Checksum | Term | VotedFor | SnapshotIndex | SnapshotTerm
+
+    std::filesystem::path dir_;
+    std::filesystem::path path_;
+    WalWriterOptions writer_options_;
+    std::mutex writer_mutex_;  ///< 保护 writer_ 的替换（compact / reset）与 sync() 的并发
+    std::unique_ptr<WalWriter> writer_;
+    std::deque<RaftEntry> entries_;  ///< [first_index(), last_index()]
+    std::deque<uint64_t> offsets_;   ///< entries_[i] 在 raft.log 中的偏移
+
+    uint64_t term_ = 0;
+    uint64_t voted_for_ = 0;
+    uint64_t snapshot_index_ = 0;
+    uint64_t snapshot_term_ = 0;
+
+    void load_meta() {
+        std::filesystem::path path = dir_ / kRaftMetaFileName;
+        if (!std::filesystem::exists(path)) return;
+        std::ifstream in(path, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (data.size() != kMetaSize || crc32c(data.data() + 4, kMetaSize - 4) != decode_fixed32(data.data())) {
+            throw std::runtime_error("Corrupted " + path.string());
+        }
+        term_ = decode_fixed64(data.data() + 4);
+        voted_for_ = decode_fixed64(data.data() + 12);
+        snapshot_index_ = decode_fixed64(data.data() + 20);
+        snapshot_term_ = decode_fixed64(data.data() + 28);
+    }
+
+    /// 原子地替换 RAFT_META（临时文件 fsync 后改名）
+    void write_meta(uint64_t term, uint64_t voted_for, uint64_t snapshot_index, uint64_t snapshot_term) {
+        std::string data(kMetaSize, '\0');
+        encode_fixed64(&data[4], term);
+        encode_fixed64(&data[12], voted_for);
+        encode_fixed64(&data[20], snapshot_index);
+        encode_fixed64(&data[28], snapshot_term);
+        encode_fixed32(&data[0], crc32c(data.data() + 4, kMetaSize - 4));
+
+        std::filesystem::path tmp = dir_ / (std::string(kRaftMetaFileName) + ".tmp");
+        {
+            WalWriter file(tmp, 0, /*reuse=*/false);
+            file.append(data);
+            file.sync();
+        }
+        std::filesystem::rename(tmp, dir_ / kRaftMetaFileName);
+    }
+
+    /**
+     * @brief 读出 raft.log 中快照位置之后的连续条目
+     *
+     * 遇到半条记录、损坏的记录或不连续的索引时停止；
+     * 若快照位置处的条目 Term 与快照不符（安装快照时崩溃），丢弃全部条目。
+     *
+     * @return 有效前缀的长度（WalWriter 从这里继续追加）
+     */
+    uint64_t load_entries() {
+        if (!std::filesystem::exists(path_)) return 0;
+        WalReader reader(path_);
+        uint64_t end = 0;
+        LogRecordView view;
+        RaftEntry entry;
+        while (reader.next(view) == WalReader::Status::kRecord) {
+            if (!parse_raft_entry(view, &entry)) break;
+            if (entry.index <= snapshot_index_) {
+                if (entry.index == snapshot_index_ && entry.term != snapshot_term_) {
+                    entries_.clear();
+                    offsets_.clear();
+                    return 0;
+                }
+            } else if (entry.index == last_index() + 1) {
+                offsets_.push_back(view.offset);
+                entries_.push_back(std::move(entry));
+            } else {
+                break;
+            }
+            end = reader.offset();
+        }
+        return end;
+    }
+
+    /// 把内存中的条目重写为新的 raft.log（临时文件 fsync 后改名，再重新打开）
+    void rewrite() {
+        std::filesystem::path tmp = dir_ / (std::string(kRaftLogFileName) + ".tmp");
+        std::deque<uint64_t> offsets;
+        uint64_t size = 0;
+        {
+            WalWriter file(tmp, 0, /*reuse=*/false);
+            for (const RaftEntry& e : entries_) {
+                offsets.push_back(file.size());
+                file.append(e.record);
+            }
+            file.sync();
+            size = file.size();
+        }
+
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        writer_.reset();
+        std::filesystem::rename(tmp, path_);
+        writer_ = std::make_unique<WalWriter>(path_, size, /*reuse=*/false, writer_options_);
+        offsets_ = std::move(offsets);
+    }
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "coding.h"
+#include "raft_log.h"
+#include "wal_reader.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @file raft_message.h
+ * @brief Raft 节点之间的消息及其二进制编码
+ */
+
+/// 消息类型
+enum class RaftMessageType : uint8_t {
+    kVote = 1,               ///< RequestVote
+    kVoteResponse = 2,
+    kAppend = 3,             ///< AppendEntries（携带条目）
+    kAppendResponse = 4,
+    kHeartbeat = 5,          ///< 心跳：只推进 commit 与续约，不做日志一致性检查
+    kHeartbeatResponse = 6,
+    kSnapshot = 7,           ///< InstallSnapshot：状态机的 SSTable 文件
+    kSnapshotResponse = 8,
+};
+
+/**
+ * @brief 一条 Raft 消息
+ *
+ * 各字段的含义随类型而定：
+ * | 类型             | log_term / index                    | commit             | reject / hint              |
+ * |------------------|-------------------------------------|--------------------|----------------------------|
+ * | kVote            | 候选人最后一条日志的 Term / 索引      | -                  | -                          |
+ * | kVoteResponse    | -                                   | -                  | reject：拒绝投票           |
+ * | kAppend          | entries 之前一条的 Term / 索引        | Leader 的 commit   | -                          |
+ * | kAppendResponse  | - / 已与 Leader 一致的最后索引        | -                  | reject 时 hint 为本地末尾  |
+ * | kHeartbeat       | -                                   | 可推进到的 commit  | -                          |
+ * | kSnapshot        | 快照的 Term / 索引                   | -                  | -                          |
+ * | kSnapshotResponse| - / 已安装的快照索引                  | -                  | reject：安装失败           |
+ *
+ * context 由 Leader 填入发送时刻（steady_clock 纳秒），响应原样带回，用于计算读租约。
+ */
+struct RaftMessage {
+    RaftMessageType type = RaftMessageType::kHeartbeat;
+    uint64_t from = 0;
+    uint64_t to = 0;
+    uint64_t term = 0;
+    uint64_t log_term = 0;
+    uint64_t index = 0;
+    uint64_t commit = 0;
+    bool reject = false;
+    uint64_t hint = 0;
+    uint64_t context = 0;
+    std::vector<RaftEntry> entries;                            ///< kAppend
+    std::vector<std::pair<std::string, std::string>> files;    ///< kSnapshot：文件名与内容
+};
+
+/**
+ * @brief 编码一条消息
+ *
+ * +---------+-----------------------------------------------------------+-------------+
+ * | Type(1B)| From | To | Term | LogTerm | Index | Commit | Hint | Context (各 8B)     |
+ * +---------+-----------------------------------------------------------+-------------+
+ * | Reject(1B) | EntryCount(varint32) | 条目的日志记录 ... | FileCount(varint32) | 文件 ... |
+ * +-----------------------------------------------------------------------------------+
+ *
+ * 条目就是 raft.log 中的日志记录（自带长度与 Checksum）；文件编码为
+ * | NameLen(varint32) | Name | DataLen(8B) | Data |。
+ */
+inline std::string encode_raft_message(const RaftMessage& msg) {
+    std::string out;
+    size_t size = 1 + 8 * 8 + 1 + 2 * kMaxVarint32Length;
+    for (const RaftEntry& e : msg.entries) size += e.record.size();
+    for (const auto& [name, data] : msg.files) size += kMaxVarint32Length + name.size() + 8 + data.size();
+    out.reserve(size);
+
+    out.push_back(static_cast<char>(msg.type));
+    for (uint64_t v : {msg.from, msg.to, msg.term, msg.log_term, msg.index, msg.commit, msg.hint, msg.context}) {
+        put_fixed64(out, v);
+    }
+    out.push_back(msg.reject ? 1 : 0);
+    put_varint32(out, static_cast<uint32_t>(msg.entries.size()));
+    for (const RaftEntry& e : msg.entries) out.append(e.record);
+    put_varint32(out, static_cast<uint32_t>(msg.files.size()));
+    for (const auto& [name, data] : msg.files) {
+        put_varint32(out, static_cast<uint32_t>(name.size()));
+        out.append(name);
+        put_fixed64(out, data.size());
+        out.append(data);
+    }
+    return out;
+}
+
+/**
+ * @brief 不解码整条消息，只读出接收者编号（用于按 To 分发）
+ *
+ * @return false 如果数据短于固定头部
+ */
+inline bool peek_raft_message_target(std::string_view data, uint64_t* to) {
+    if (data.size() < 1 + 8 * 2) return false;
+    *to = decode_fixed64(data.data() + 1 + 8);
+    return true;
+}
+
+/**
+ * @brief 解码一条消息
+ *
+ * @return false 如果数据被截断、类型未知，或任一条目的 Checksum / 结构校验失败
+ */
+inline bool decode_raft_message(std::string_view data, RaftMessage* msg) {
+    constexpr size_t kFixedSize = 1 + 8 * 8 + 1;
+    if (data.size() < kFixedSize) return false;
+    const char* p = data.data();
+    const char* limit = data.data() + data.size();
+
+    uint8_t type = static_cast<uint8_t>(*p++);
+    if (type < static_cast<uint8_t>(RaftMessageType::kVote) ||
+        type > static_cast<uint8_t>(RaftMessageType::kSnapshotResponse)) {
+        return false;
+    }
+    msg->type = static_cast<RaftMessageType>(type);
+    for (uint64_t* v : {&msg->from, &msg->to, &msg->term, &msg->log_term, &msg->index, &msg->commit, &msg->hint,
+                        &msg->context}) {
+        *v = decode_fixed64(p);
+        p += 8;
+    }
+    msg->reject = *p++ != 0;
+
+    uint32_t count = 0;
+    if ((p = get_varint32_ptr(p, limit, &count)) == nullptr) return false;
+    msg->entries.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        LogRecordView view;
+        RaftEntry entry;
+        if (!decode_log_record(std::string_view(p, static_cast<size_t>(limit - p)), &view) ||
+            !parse_raft_entry(view, &entry)) {
+            return false;
+        }
+        p += view.size;
+        msg->entries.push_back(std::move(entry));
+    }
+
+    if ((p = get_varint32_ptr(p, limit, &count)) == nullptr) return false;
+    msg->files.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t name_len = 0;
+        if ((p = get_varint32_ptr(p, limit, &name_len)) == nullptr) return false;
+        if (static_cast<size_t>(limit - p) < static_cast<size_t>(name_len) + 8) return false;
+        std::string name(p, name_len);
+        p += name_len;
+        uint64_t data_len = decode_fixed64(p);
+        p += 8;
+        if (static_cast<uint64_t>(limit - p) < data_len) return false;
+        msg->files.emplace_back(std::move(name), std::string(p, static_cast<size_t>(data_len)));
+        p += data_len;
+    }
+    return p == limit;
+}
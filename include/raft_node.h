@@ -0,0 +1,1109 @@
+#pragma once
+
+#include "filename.h"
+#include "kv_store.h"
+#include "options.h"
+#include "raft_log.h"
+#include "raft_message.h"
+#include "raft_transport.h"
+#include "write_batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <set>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @file raft_node.h
+ * @brief 用 Raft 在多个节点之间复制写入，每个节点的状态机是一个本地 KVStore
+ */
+
+/**
+ * @brief RaftNode 的选项
+ */
+struct RaftOptions {
+    RaftOptions() {
+        // raft.log 已在应答前 fsync，状态机可以从日志重放，本地 WAL 不必再逐次 fsync
+        store_options.sync_mode = WalSyncMode::kPeriodic;
+    }
+
+    /// 本节点的编号（非 0）
+    uint64_t id = 1;
+
+    /// 集群全部成员的编号（包含本节点）
+    std::vector<uint64_t> peers;
+
+    /// Leader 发送心跳的间隔
+    std::chrono::milliseconds heartbeat_interval{50};
+
+    /// 选举超时在 [min, max) 中随机选取；min 同时是 Leader 读租约的时长上限
+    std::chrono::milliseconds election_timeout_min{300};
+    std::chrono::milliseconds election_timeout_max{600};
+
+    /// 单条 AppendEntries 携带的条目数与字节数上限
+    size_t max_entries_per_message = 256;
+    size_t max_bytes_per_message = 1 << 20;
+
+    /// 发给一个 Follower、尚未收到响应的 AppendEntries 数量上限（流水线深度）
+    size_t max_inflight_messages = 16;
+
+    /// 租约内的线性一致读直接读本地状态机；false 时每次读都经过一轮心跳（ReadIndex）
+    bool lease_reads = true;
+
+    /// 租约时长 = election_timeout_min × (1 − lease_clock_drift)，为节点间的时钟频率偏差留出余量
+    double lease_clock_drift = 0.1;
+
+    /// 快照位置之后已应用的条目超过 snapshot_threshold + snapshot_retain 时，
+    /// 落盘状态机并压缩日志（0 表示不压缩）
+    uint64_t snapshot_threshold = 10000;
+
+    /// 压缩时保留的最近条目数：稍慢的 Follower 可以直接追赶，不必安装快照
+    uint64_t snapshot_retain = 1000;
+
+    /// raft.log 的预分配大小
+    uint64_t log_preallocate_size = 16 << 20;
+
+    /// put / del / write / get 等待完成的最长时间
+    std::chrono::milliseconds request_timeout{5000};
+
+    /// 状态机 KVStore 的选项
+    KVStoreOptions store_options;
+};
+
+/// 节点角色
+enum class RaftRole {
+    kFollower,
+    kCandidate,
+    kLeader,
+};
+
+/**
+ * @brief 节点状态的快照（用于监控与测试）
+ */
+struct RaftStatus {
+    uint64_t id = 0;
+    RaftRole role = RaftRole::kFollower;
+    uint64_t term = 0;
+    uint64_t leader = 0;            ///< 已知的 Leader，0 表示未知
+    uint64_t commit = 0;            ///< 已提交的最大索引
+    uint64_t applied = 0;           ///< 已应用到状态机的最大索引
+    uint64_t last_index = 0;        ///< 本地日志的最后索引
+    uint64_t snapshot_index = 0;    ///< 本地日志的快照位置
+};
+
+/**
+ * @brief RaftNode 的统计
+ */
+struct RaftStats {
+    uint64_t proposals = 0;            ///< 作为 Leader 接受的写入（每个写入一条日志条目）
+    uint64_t append_messages = 0;      ///< 发出的 AppendEntries
+    uint64_t appended_entries = 0;     ///< AppendEntries 携带的条目总数
+    uint64_t log_syncs = 0;            ///< raft.log 的 fsync 次数
+    uint64_t applied_batches = 0;      ///< 应用到状态机的合并批次数
+    uint64_t lease_reads = 0;          ///< 在租约内直接完成的线性一致读
+    uint64_t read_index_reads = 0;     ///< 经过一轮心跳确认的线性一致读
+    uint64_t elections = 0;            ///< 发起的选举次数
+    uint64_t snapshots_sent = 0;       ///< 发出的快照
+    uint64_t snapshots_installed = 0;  ///< 安装的快照
+
+    /// 每条 AppendEntries 平均携带的条目数
+    double avg_entries_per_append() const {
+        return append_messages ? static_cast<double>(appended_entries) / static_cast<double>(append_messages) : 0.0;
+    }
+};
+
+/**
+ * @brief 一个 Raft 副本：复制日志 + 本地 KVStore 状态机
+ *
+ * 写入 (put / del / write) 在 Leader 上编码为一条日志条目（即 WAL 的 kBatch 记录，见 RaftEntry），
+ * 复制到多数派并提交后应用到每个副本的 KVStore。
+ *
+ * 复制路径：
+ * - **批量 + 流水线**：复制线程每轮把新追加的全部条目打包进 AppendEntries，
+ *   处于复制状态 (kReplicate) 的 Follower 不等上一条的响应就继续发送，最多 max_inflight_messages 条；
+ *   被拒绝时退回探测状态 (kProbe)，按 Follower 提示的末尾索引回退。
+ * - **fsync 与网络并行**：复制线程先发出 AppendEntries，再对本地 raft.log 执行 fdatasync；
+ *   Leader 自己的 match 在 fsync 完成后才计入多数派。Follower 同样在 fsync 完成后才应答，
+ *   fsync 期间继续接收并追加后续条目，应答按批合并。
+ * - **应用**：应用线程把一段已提交的条目合并成一个 WriteBatch 写入 KVStore。
+ *
+ * 读取：
+ * - get() 是线性一致读，只能在 Leader 上调用。Leader 当选后先提交一条本任期的 no-op；
+ *   之后若多数派在 election_timeout_min × (1 − lease_clock_drift) 之内确认过它的心跳（租约），
+ *   直接等待状态机应用到当前 commit 后读本地 KVStore，不需要一轮网络往返；
+ *   租约过期或关闭 lease_reads 时，先发一轮心跳确认自己仍是 Leader (ReadIndex)。
+ *   租约的安全性依赖于：Follower 在最近 election_timeout_min 内收到过 Leader 的消息时拒绝投票。
+ * - local_get() 读本地状态机，可能落后于 Leader。
+ *
+ * 快照：
+ * - 快照位置之后已应用的条目足够多时，应用线程 flush() 状态机并压缩日志
+ *   （保留最近 snapshot_retain 条）。重启时从快照位置之后重放已提交的条目：
+ *   条目都是覆盖写，对已包含其中部分写入的状态机重复应用结果相同。
+ * - Follower 需要的条目已被压缩时，Leader 用 KVStore::create_checkpoint() 生成状态机的
+ *   SSTable 文件集合发送给它；Follower 用这些文件替换自己的 KVStore 目录。
+ *
+ * @note 本类是线程安全的。
+ */
+class RaftNode {
+public:
+    /**
+     * @brief 打开（或创建）dir 中的副本并加入 transport
+     *
+     * 状态机位于 dir/db；raft.log 与 RAFT_META 位于 dir（见 filename.h）。
+     *
+     * @throw std::runtime_error 选项无效、RAFT_META 损坏或 KVStore 打开失败
+     */
+    RaftNode(const std::string& dir, const RaftOptions& options, RaftTransport& transport)
+        : dir_(dir)
+        , options_(options)
+        , transport_(transport)
+        , log_(dir_, options.log_preallocate_size)
+        , rng_(std::random_device{}() ^ options.id) {
+        if (options_.id == 0 ||
+            std::count(options_.peers.begin(), options_.peers.end(), options_.id) != 1 ||
+            std::set<uint64_t>(options_.peers.begin(), options_.peers.end()).size() != options_.peers.size()) {
+            throw std::runtime_error("RaftOptions::peers must list every member once, including id");
+        }
+        if (options_.election_timeout_min <= options_.heartbeat_interval ||
+            options_.election_timeout_max <= options_.election_timeout_min) {
+            throw std::runtime_error("RaftOptions: heartbeat < election_timeout_min < election_timeout_max required");
+        }
+
+        recover_snapshot_install();
+        store_ = std::make_unique<KVStore>((dir_ / kRaftStoreDirName).string(), options_.store_options);
+
+        log_.sync();
+        synced_index_ = log_.last_index();
+        commit_ = applied_ = log_.snapshot_index();
+        for (uint64_t peer : options_.peers) {
+            if (peer != options_.id) peers_[peer] = Progress{};
+        }
+        reset_election_timer(Clock::now());
+
+        transport_.attach(options_.id, [this](RaftMessage msg) { receive(std::move(msg)); });
+        ticker_thread_ = std::thread([this] { ticker_loop(); });
+        replicate_thread_ = std::thread([this] { replicate_loop(); });
+        apply_thread_ = std::thread([this] { apply_loop(); });
+    }
+
+    /**
+     * @brief 退出集群并停止后台线程；等待中的写入与读取抛出异常
+     */
+    ~RaftNode() {
+        transport_.detach(options_.id);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        tick_cv_.notify_all();
+        replicate_cv_.notify_all();
+        apply_cv_.notify_all();
+        applied_cv_.notify_all();
+        for (std::thread* t : {&ticker_thread_, &replicate_thread_, &apply_thread_}) {
+            if (t->joinable()) t->join();
+        }
+    }
+
+    RaftNode(const RaftNode&) = delete;
+    RaftNode& operator=(const RaftNode&) = delete;
+
+    /**
+     * @brief 写入键值对：复制到多数派并应用到本地状态机后返回
+     *
+     * @throw std::runtime_error 本节点不是 Leader、超时、条目被新 Leader 覆盖或节点正在关闭
+     */
+    void put(std::string_view key, std::string_view value) {
+        WriteBatch batch;
+        batch.put(key, value);
+        write(batch);
+    }
+
+    /// 删除键（语义同 put）
+    void del(std::string_view key) {
+        WriteBatch batch;
+        batch.del(key);
+        write(batch);
+    }
+
+    /**
+     * @brief 原子地提交一个 WriteBatch（一条日志条目）
+     *
+     * @throw std::runtime_error 同 put()
+     */
+    void write(const WriteBatch& batch) {
+        if (batch.empty()) return;
+        Proposal proposal;
+        std::unique_lock<std::mutex> lock(mutex_);
+        check_leader();
+        uint64_t index = log_.last_index() + 1;
+        proposal.term = log_.term();
+        log_.append(make_raft_entry(proposal.term, index, batch.rep()));
+        proposals_[index] = &proposal;
+        ++stats_.proposals;
+        replicate_cv_.notify_one();
+
+        auto deadline = Clock::now() + options_.request_timeout;
+        applied_cv_.wait_until(lock, deadline, [&] { return proposal.done || stopping_; });
+        if (!proposal.done) {
+            proposals_.erase(index);
+            throw std::runtime_error(stopping_ ? "RaftNode is shutting down" : "Raft proposal timed out");
+        }
+        if (!proposal.ok) {
+            throw std::runtime_error("Raft proposal was overwritten by a new leader");
+        }
+    }
+
+    /**
+     * @brief 线性一致读（只能在 Leader 上调用）
+     *
+     * @return 值，Key 不存在时返回 std::nullopt
+     * @throw std::runtime_error 本节点不是 Leader、无法确认 Leader 身份（超时）或节点正在关闭
+     */
+    std::optional<std::string> get(std::string_view key) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            check_leader();
+            auto deadline = Clock::now() + options_.request_timeout;
+
+            // 本任期的 no-op 提交之前，commit_ 可能落后于前任已提交的条目
+            wait_or_throw(lock, applied_cv_, deadline, [&] { return commit_ >= leader_start_index_; });
+            uint64_t read_index = commit_;
+            if (options_.lease_reads && Clock::now() < lease_expiry()) {
+                ++stats_.lease_reads;
+            } else {
+                uint64_t start = now_ns();
+                broadcast_heartbeat();
+                wait_or_throw(lock, ack_cv_, deadline, [&] { return quorum_ack_context() >= start; });
+                ++stats_.read_index_reads;
+            }
+            wait_or_throw(lock, applied_cv_, deadline, [&] { return applied_ >= read_index; });
+        }
+        std::shared_lock<std::shared_mutex> store_lock(store_mutex_);
+        check_store();
+        return store_->get(key);
+    }
+
+    /**
+     * @brief 读本地状态机（不保证线性一致，Follower 上可能读到旧值）
+     *
+     * @throw std::runtime_error 节点已失败（例如安装快照后无法打开状态机）
+     */
+    std::optional<std::string> local_get(std::string_view key) const {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_.empty()) throw std::runtime_error("RaftNode failed: " + error_);
+        }
+        std::shared_lock<std::shared_mutex> store_lock(store_mutex_);
+        check_store();
+        return store_->get(key);
+    }
+
+    bool is_leader() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return role_ == RaftRole::kLeader;
+    }
+
+    RaftStatus status() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        RaftStatus s;
+        s.id = options_.id;
+        s.role = role_;
+        s.term = log_.term();
+        s.leader = leader_;
+        s.commit = commit_;
+        s.applied = applied_;
+        s.last_index = log_.last_index();
+        s.snapshot_index = log_.snapshot_index();
+        return s;
+    }
+
+    RaftStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// Leader 视角下一个 Follower 的复制进度
+    struct Progress {
+        enum class State { kProbe, kReplicate, kSnapshot };
+        State state = State::kProbe;
+        uint64_t next = 1;                ///< 下一条要发送的索引
+        uint64_t match = 0;               ///< 已确认与 Leader 一致的最后索引
+        bool paused = false;              ///< kProbe：已发出一条探测，等待响应或下一次心跳
+        std::deque<uint64_t> inflight;    ///< kReplicate：已发出未确认的 AppendEntries 的末尾索引
+        uint64_t ack_context = 0;         ///< 收到的响应中最新的发送时刻（租约）
+        Clock::time_point last_contact;   ///< 最近一次收到任何响应的时刻（Check Quorum）
+        Clock::time_point last_progress;  ///< 最近一次收到 AppendEntries / 快照响应的时刻
+    };
+
+    /// 一个等待提交的写入
+    struct Proposal {
+        uint64_t term = 0;
+        bool done = false;
+        bool ok = false;
+    };
+
+    std::filesystem::path dir_;
+    RaftOptions options_;
+    RaftTransport& transport_;
+
+    mutable std::mutex mutex_;  ///< 保护以下全部 Raft 状态与 log_
+    RaftLog log_;
+    RaftRole role_ = RaftRole::kFollower;
+    uint64_t leader_ = 0;
+    uint64_t commit_ = 0;
+    uint64_t applied_ = 0;
+    uint64_t synced_index_ = 0;        ///< raft.log 中已 fsync 的最后索引
+    uint64_t log_epoch_ = 0;           ///< 每次截断日志时递增：正在进行的 fsync 不能推进 synced_index_
+    uint64_t leader_start_index_ = 0;  ///< 本任期 no-op 的索引
+    std::set<uint64_t> votes_;
+    std::map<uint64_t, Progress> peers_;
+    std::map<uint64_t, Proposal*> proposals_;
+    std::vector<RaftMessage> pending_acks_;      ///< Follower：等待 fsync 后发出的 AppendEntries 响应
+    std::optional<RaftMessage> pending_snapshot_; ///< Follower：等待应用线程安装的快照
+    std::set<uint64_t> snapshot_requests_;       ///< Leader：等待应用线程生成快照的 Follower
+    Clock::time_point election_deadline_;
+    Clock::time_point next_heartbeat_;
+    Clock::time_point leader_contact_;           ///< Follower：最近一次收到 Leader 消息的时刻
+    std::mt19937_64 rng_;
+    RaftStats stats_;
+    std::string error_;                          ///< raft.log 写入 / 快照失败后的错误，节点停止参与复制
+    bool stopping_ = false;
+
+    std::condition_variable tick_cv_;
+    std::condition_variable replicate_cv_;
+    std::condition_variable apply_cv_;
+    std::condition_variable applied_cv_;  ///< applied_ / commit_ 推进，或 Proposal 完成
+    std::condition_variable ack_cv_;      ///< 收到心跳 / 复制响应（ReadIndex 等待）
+
+    /// 读请求持有共享锁，安装快照替换 store_ 时持有独占锁；
+    /// 应用线程是唯一修改 store_ 的线程，它自己访问 store_ 时不必加锁。
+    /// 同时需要两把锁时先取 store_mutex_ 再取 mutex_
+    mutable std::shared_mutex store_mutex_;
+    std::unique_ptr<KVStore> store_;
+
+    std::thread ticker_thread_;
+    std::thread replicate_thread_;
+    std::thread apply_thread_;
+
+    static uint64_t now_ns() {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+    }
+
+    size_t quorum() const { return options_.peers.size() / 2 + 1; }
+
+    void check_leader() const {
+        if (!error_.empty()) throw std::runtime_error("RaftNode failed: " + error_);
+        if (stopping_) throw std::runtime_error("RaftNode is shutting down");
+        if (role_ != RaftRole::kLeader) {
+            throw std::runtime_error("Not the Raft leader (leader: " + std::to_string(leader_) + ")");
+        }
+    }
+
+    /// 状态机不可用（安装快照失败后 store_ 为空）时抛出异常；调用者持有 store_mutex_
+    void check_store() const {
+        if (!store_) throw std::runtime_error("RaftNode state machine is unavailable");
+    }
+
+    /// 等待 pred 成立；超时、失去 Leader 身份或关闭时抛出异常
+    template <typename Pred>
+    void wait_or_throw(std::unique_lock<std::mutex>& lock, std::condition_variable& cv, Clock::time_point deadline,
+                       Pred pred) {
+        bool ok = cv.wait_until(lock, deadline, [&] { return pred() || stopping_ || role_ != RaftRole::kLeader; });
+        check_leader();
+        if (!ok || !pred()) throw std::runtime_error("Raft read timed out");
+    }
+
+    // ---- 选举 ----
+
+    void reset_election_timer(Clock::time_point now) {
+        auto span = options_.election_timeout_max - options_.election_timeout_min;
+        std::uniform_int_distribution<int64_t> dist(0, span.count() - 1);
+        election_deadline_ = now + options_.election_timeout_min + std::chrono::milliseconds(dist(rng_));
+    }
+
+    void become_follower(uint64_t term, uint64_t leader) {
+        if (term > log_.term()) log_.save_hard_state(term, 0);
+        if (role_ == RaftRole::kLeader) ack_cv_.notify_all();
+        role_ = RaftRole::kFollower;
+        leader_ = leader;
+        snapshot_requests_.clear();
+        reset_election_timer(Clock::now());
+        applied_cv_.notify_all();
+    }
+
+    void campaign(Clock::time_point now) {
+        log_.save_hard_state(log_.term() + 1, options_.id);
+        role_ = RaftRole::kCandidate;
+        leader_ = 0;
+        votes_ = {options_.id};
+        ++stats_.elections;
+        reset_election_timer(now);
+        if (votes_.size() >= quorum()) {
+            become_leader(now);
+            return;
+        }
+        for (const auto& [peer, progress] : peers_) {
+            RaftMessage msg;
+            msg.type = RaftMessageType::kVote;
+            msg.to = peer;
+            msg.log_term = log_.last_term();
+            msg.index = log_.last_index();
+            send(std::move(msg));
+        }
+    }
+
+    void become_leader(Clock::time_point now) {
+        role_ = RaftRole::kLeader;
+        leader_ = options_.id;
+        for (auto& [peer, p] : peers_) {
+            p = Progress{};
+            p.next = log_.last_index() + 1;
+            // 当选时刻视为一次联系：刚当选时不会因为还没有响应而被 Check Quorum 判定失联
+            p.last_contact = now;
+            p.last_progress = now;
+        }
+        leader_start_index_ = log_.last_index() + 1;
+        log_.append(make_raft_entry(log_.term(), leader_start_index_, WriteBatch().rep()));
+        next_heartbeat_ = now;
+        replicate_cv_.notify_one();
+        tick_cv_.notify_one();
+    }
+
+    // ---- 发送 ----
+
+    void send(RaftMessage msg) {
+        msg.from = options_.id;
+        msg.term = log_.term();
+        transport_.send(std::move(msg));
+    }
+
+    void send_heartbeat(uint64_t peer, const Progress& p, uint64_t context) {
+        RaftMessage msg;
+        msg.type = RaftMessageType::kHeartbeat;
+        msg.to = peer;
+        msg.commit = std::min(commit_, p.match);
+        msg.context = context;
+        send(std::move(msg));
+    }
+
+    void broadcast_heartbeat() {
+        uint64_t context = now_ns();
+        for (const auto& [peer, p] : peers_) send_heartbeat(peer, p, context);
+    }
+
+    /**
+     * @brief 按复制状态向 peer 发送尽可能多的 AppendEntries
+     *
+     * kProbe 每次只发一条并暂停；kReplicate 持续发送直到没有新条目或达到流水线深度。
+     * 需要的条目已被压缩时转入 kSnapshot，交给应用线程生成快照。
+     */
+    void send_appends(uint64_t peer) {
+        Progress& p = peers_[peer];
+        for (;;) {
+            if (p.state == Progress::State::kSnapshot) return;
+            if (p.state == Progress::State::kProbe && p.paused) return;
+            if (p.state == Progress::State::kReplicate &&
+                (p.inflight.size() >= options_.max_inflight_messages || p.next > log_.last_index())) {
+                return;
+            }
+
+            std::optional<uint64_t> prev_term = log_.term_at(p.next - 1);
+            if (!prev_term) {
+                p.state = Progress::State::kSnapshot;
+                p.last_progress = Clock::now();
+                snapshot_requests_.insert(peer);
+                apply_cv_.notify_one();
+                return;
+            }
+            RaftMessage msg;
+            msg.type = RaftMessageType::kAppend;
+            msg.to = peer;
+            msg.index = p.next - 1;
+            msg.log_term = *prev_term;
+            msg.commit = commit_;
+            msg.context = now_ns();
+            if (p.next <= log_.last_index()) {
+                uint64_t hi = std::min(log_.last_index(), p.next + options_.max_entries_per_message - 1);
+                msg.entries = log_.entries(p.next, hi, options_.max_bytes_per_message);
+            }
+            ++stats_.append_messages;
+            stats_.appended_entries += msg.entries.size();
+
+            if (p.state == Progress::State::kProbe) {
+                p.paused = true;
+                send(std::move(msg));
+                return;
+            }
+            p.next = msg.entries.back().index + 1;
+            p.inflight.push_back(p.next - 1);
+            send(std::move(msg));
+        }
+    }
+
+    /// 多数派已确认的最新发送时刻（本节点自身视为“现在”）
+    uint64_t quorum_ack_context() const {
+        std::vector<uint64_t> acks = {std::numeric_limits<uint64_t>::max()};
+        for (const auto& [peer, p] : peers_) acks.push_back(p.ack_context);
+        std::sort(acks.begin(), acks.end(), std::greater<uint64_t>());
+        return acks[quorum() - 1];
+    }
+
+    /// Leader 租约的到期时刻
+    Clock::time_point lease_expiry() const {
+        auto lease = std::chrono::duration_cast<Clock::duration>(options_.election_timeout_min *
+                                                                 (1.0 - options_.lease_clock_drift));
+        uint64_t acked = quorum_ack_context();
+        if (acked == std::numeric_limits<uint64_t>::max()) return Clock::now() + lease;
+        return Clock::time_point(std::chrono::nanoseconds(acked)) + lease;
+    }
+
+    /// 多数派的 match（Leader 自己的按已 fsync 的位置计算）推进 commit_；只提交本任期的条目
+    void maybe_commit() {
+        std::vector<uint64_t> matches = {synced_index_};
+        for (const auto& [peer, p] : peers_) matches.push_back(p.match);
+        std::sort(matches.begin(), matches.end(), std::greater<uint64_t>());
+        uint64_t index = matches[quorum() - 1];
+        if (index > commit_ && log_.term_at(index) == log_.term()) {
+            commit_ = index;
+            apply_cv_.notify_one();
+        }
+    }
+
+    // ---- 接收 ----
+
+    void receive(RaftMessage msg) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || !error_.empty()) return;
+        Clock::time_point now = Clock::now();
+        try {
+            if (msg.term > log_.term()) {
+                bool from_leader = msg.type == RaftMessageType::kAppend || msg.type == RaftMessageType::kHeartbeat ||
+                                   msg.type == RaftMessageType::kSnapshot;
+                // 仍在 Leader 租约内时忽略更高任期的投票请求：既保证租约读的安全，
+                // 也避免被分区后重新加入的节点打断正常工作的 Leader
+                if (msg.type == RaftMessageType::kVote &&
+                    (role_ == RaftRole::kLeader ||
+                     (leader_ != 0 && now - leader_contact_ < options_.election_timeout_min))) {
+                    return;
+                }
+                become_follower(msg.term, from_leader ? msg.from : 0);
+            } else if (msg.term < log_.term()) {
+                // 让过期的 Leader 得知新的任期并退位
+                if (msg.type == RaftMessageType::kAppend || msg.type == RaftMessageType::kHeartbeat ||
+                    msg.type == RaftMessageType::kSnapshot) {
+                    RaftMessage resp;
+                    resp.type = RaftMessageType::kAppendResponse;
+                    resp.to = msg.from;
+                    resp.reject = true;
+                    send(std::move(resp));
+                }
+                return;
+            }
+
+            switch (msg.type) {
+                case RaftMessageType::kVote: handle_vote(msg, now); break;
+                case RaftMessageType::kVoteResponse: handle_vote_response(msg, now); break;
+                case RaftMessageType::kAppend: handle_append(std::move(msg), now); break;
+                case RaftMessageType::kAppendResponse: handle_append_response(msg, now); break;
+                case RaftMessageType::kHeartbeat: handle_heartbeat(msg, now); break;
+                case RaftMessageType::kHeartbeatResponse: handle_heartbeat_response(msg, now); break;
+                case RaftMessageType::kSnapshot: handle_snapshot(std::move(msg), now); break;
+                case RaftMessageType::kSnapshotResponse: handle_snapshot_response(msg, now); break;
+            }
+        } catch (const std::exception& e) {
+            fail(e.what());
+        }
+    }
+
+    /// 持久化状态写入失败：停止参与复制，等待中的请求收到异常
+    void fail(const std::string& error) {
+        error_ = error;
+        role_ = RaftRole::kFollower;
+        leader_ = 0;
+        applied_cv_.notify_all();
+        ack_cv_.notify_all();
+    }
+
+    /// 收到当前 Leader 的消息：记录 Leader 并推迟选举
+    void follow(uint64_t leader, Clock::time_point now) {
+        if (role_ != RaftRole::kFollower || leader_ != leader) {
+            role_ = RaftRole::kFollower;
+            leader_ = leader;
+        }
+        leader_contact_ = now;
+        reset_election_timer(now);
+    }
+
+    void handle_vote(const RaftMessage& msg, Clock::time_point now) {
+        bool up_to_date = msg.log_term > log_.last_term() ||
+                          (msg.log_term == log_.last_term() && msg.index >= log_.last_index());
+        bool grant = up_to_date && leader_ == 0 && (log_.voted_for() == 0 || log_.voted_for() == msg.from);
+        if (grant) {
+            log_.save_hard_state(log_.term(), msg.from);
+            reset_election_timer(now);
+        }
+        RaftMessage resp;
+        resp.type = RaftMessageType::kVoteResponse;
+        resp.to = msg.from;
+        resp.reject = !grant;
+        send(std::move(resp));
+    }
+
+    void handle_vote_response(const RaftMessage& msg, Clock::time_point now) {
+        if (role_ != RaftRole::kCandidate || msg.reject) return;
+        votes_.insert(msg.from);
+        if (votes_.size() >= quorum()) become_leader(now);
+    }
+
+    void handle_append(RaftMessage msg, Clock::time_point now) {
+        follow(msg.from, now);
+        RaftMessage resp;
+        resp.type = RaftMessageType::kAppendResponse;
+        resp.to = msg.from;
+        resp.context = msg.context;
+
+        if (msg.index < commit_) {
+            // 已提交的条目一定与 Leader 一致
+            resp.index = commit_;
+        } else if (log_.term_at(msg.index) != msg.log_term) {
+            resp.reject = true;
+            resp.index = msg.index;
+            resp.hint = log_.last_index();
+            send(std::move(resp));
+            return;
+        } else {
+            for (RaftEntry& entry : msg.entries) {
+                if (entry.index <= log_.last_index()) {
+                    if (log_.term_at(entry.index) == entry.term) continue;
+                    log_.truncate(entry.index);
+                    ++log_epoch_;
+                    synced_index_ = std::min(synced_index_, entry.index - 1);
+                }
+                log_.append(std::move(entry));
+            }
+            resp.index = msg.index + msg.entries.size();
+            uint64_t commit = std::min(msg.commit, resp.index);
+            if (commit > commit_) {
+                commit_ = commit;
+                apply_cv_.notify_one();
+            }
+        }
+
+        if (resp.index <= synced_index_) {
+            send(std::move(resp));
+        } else {
+            resp.from = options_.id;
+            resp.term = log_.term();
+            pending_acks_.push_back(std::move(resp));
+            replicate_cv_.notify_one();
+        }
+    }
+
+    void handle_append_response(const RaftMessage& msg, Clock::time_point now) {
+        if (role_ != RaftRole::kLeader) return;
+        auto it = peers_.find(msg.from);
+        if (it == peers_.end()) return;
+        Progress& p = it->second;
+        p.ack_context = std::max(p.ack_context, msg.context);
+        p.last_contact = now;
+        p.last_progress = now;
+        ack_cv_.notify_all();
+
+        if (msg.reject) {
+            // 过期的拒绝：对应的条目已确认，或不是当前这条探测的响应
+            if (msg.index <= p.match) return;
+            if (p.state == Progress::State::kProbe && msg.index != p.next - 1) return;
+            p.next = std::max(p.match + 1, std::min(msg.index, msg.hint + 1));
+            p.state = Progress::State::kProbe;
+            p.paused = false;
+            p.inflight.clear();
+        } else {
+            p.match = std::max(p.match, msg.index);
+            p.next = std::max(p.next, p.match + 1);
+            while (!p.inflight.empty() && p.inflight.front() <= msg.index) p.inflight.pop_front();
+            if (p.state == Progress::State::kProbe) {
+                p.state = Progress::State::kReplicate;
+                p.paused = false;
+                p.next = p.match + 1;
+                p.inflight.clear();
+            }
+            maybe_commit();
+        }
+        send_appends(msg.from);
+    }
+
+    void handle_heartbeat(const RaftMessage& msg, Clock::time_point now) {
+        follow(msg.from, now);
+        uint64_t commit = std::min(msg.commit, log_.last_index());
+        if (commit > commit_) {
+            commit_ = commit;
+            apply_cv_.notify_one();
+        }
+        RaftMessage resp;
+        resp.type = RaftMessageType::kHeartbeatResponse;
+        resp.to = msg.from;
+        resp.context = msg.context;
+        send(std::move(resp));
+    }
+
+    void handle_heartbeat_response(const RaftMessage& msg, Clock::time_point now) {
+        if (role_ != RaftRole::kLeader) return;
+        auto it = peers_.find(msg.from);
+        if (it == peers_.end()) return;
+        Progress& p = it->second;
+        p.ack_context = std::max(p.ack_context, msg.context);
+        p.last_contact = now;
+        ack_cv_.notify_all();
+
+        // 长时间没有复制进展（消息在分区中丢失，或快照没有回音）：从 match 重新探测
+        auto silence = now - p.last_progress;
+        bool stalled = false;
+        if (p.state == Progress::State::kReplicate) {
+            stalled = !p.inflight.empty() && silence > 2 * options_.heartbeat_interval;
+        } else if (p.state == Progress::State::kSnapshot) {
+            stalled = silence > options_.request_timeout;
+        }
+        if (stalled) {
+            p.state = Progress::State::kProbe;
+            p.next = p.match + 1;
+            p.inflight.clear();
+        }
+        if (p.state == Progress::State::kProbe) p.paused = false;
+        if (p.match < log_.last_index()) send_appends(msg.from);
+    }
+
+    void handle_snapshot(RaftMessage msg, Clock::time_point now) {
+        follow(msg.from, now);
+        if (msg.index <= commit_) {
+            RaftMessage resp;
+            resp.type = RaftMessageType::kSnapshotResponse;
+            resp.to = msg.from;
+            resp.index = commit_;
+            send(std::move(resp));
+            return;
+        }
+        pending_snapshot_ = std::move(msg);
+        apply_cv_.notify_one();
+    }
+
+    void handle_snapshot_response(const RaftMessage& msg, Clock::time_point now) {
+        if (role_ != RaftRole::kLeader) return;
+        auto it = peers_.find(msg.from);
+        if (it == peers_.end()) return;
+        Progress& p = it->second;
+        p.last_contact = now;
+        p.last_progress = now;
+        if (!msg.reject) p.match = std::max(p.match, msg.index);
+        p.next = p.match + 1;
+        p.state = Progress::State::kProbe;
+        p.paused = false;
+        p.inflight.clear();
+        send_appends(msg.from);
+    }
+
+    // ---- 后台线程 ----
+
+    /// 选举超时与心跳
+    void ticker_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            Clock::time_point now = Clock::now();
+            try {
+                if (!error_.empty()) {
+                    // 节点已失败：不再发起选举
+                } else if (role_ == RaftRole::kLeader) {
+                    if (now >= next_heartbeat_) {
+                        broadcast_heartbeat();
+                        next_heartbeat_ = now + options_.heartbeat_interval;
+                    }
+                    // Check Quorum：超过最长选举超时仍联系不上多数派，说明已被分区，主动退位
+                    size_t reachable = 1;
+                    for (const auto& [peer, p] : peers_) {
+                        if (now - p.last_contact < options_.election_timeout_max) ++reachable;
+                    }
+                    if (reachable < quorum()) become_follower(log_.term(), 0);
+                } else if (now >= election_deadline_) {
+                    campaign(now);
+                }
+            } catch (const std::exception& e) {
+                fail(e.what());
+            }
+            Clock::time_point wake = role_ == RaftRole::kLeader ? next_heartbeat_ : election_deadline_;
+            tick_cv_.wait_until(lock, wake);
+        }
+    }
+
+    /**
+     * @brief 复制线程：发出新条目的 AppendEntries，然后 fsync raft.log
+     *
+     * 发送在 fsync 之前：Follower 的写盘与 Leader 的 fsync 同时进行。
+     * fsync 期间新到达的写入在下一轮合并为一批发送、一次 fsync。
+     */
+    void replicate_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            replicate_cv_.wait(lock, [this] { return stopping_ || log_.last_index() > synced_index_; });
+            if (stopping_) break;
+            if (!error_.empty()) {
+                synced_index_ = log_.last_index();
+                continue;
+            }
+            if (role_ == RaftRole::kLeader) {
+                for (const auto& [peer, p] : peers_) send_appends(peer);
+            }
+
+            uint64_t target = log_.last_index();
+            uint64_t epoch = log_epoch_;
+            lock.unlock();
+            std::string error;
+            try {
+                log_.sync();
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+            lock.lock();
+            if (!error.empty()) {
+                fail(error);
+                continue;
+            }
+            ++stats_.log_syncs;
+            if (epoch != log_epoch_) continue;  // fsync 期间日志被截断，同步到的条目可能已被替换
+            synced_index_ = std::max(synced_index_, target);
+
+            std::vector<RaftMessage> acks;
+            for (RaftMessage& ack : pending_acks_) {
+                if (ack.index <= synced_index_) {
+                    transport_.send(std::move(ack));
+                } else {
+                    acks.push_back(std::move(ack));
+                }
+            }
+            pending_acks_ = std::move(acks);
+            if (role_ == RaftRole::kLeader) maybe_commit();
+        }
+    }
+
+    /// 应用线程：应用已提交的条目、压缩日志、生成 / 安装快照（状态机只由这个线程写入）
+    void apply_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            // 失败后不再触碰状态机（安装快照失败时 store_ 可能为空），只等待关闭
+            apply_cv_.wait(lock, [this] {
+                return stopping_ || (error_.empty() && (commit_ > applied_ || pending_snapshot_.has_value() ||
+                                                        !snapshot_requests_.empty()));
+            });
+            if (stopping_) break;
+            try {
+                if (pending_snapshot_) {
+                    RaftMessage msg = std::move(*pending_snapshot_);
+                    pending_snapshot_.reset();
+                    install_snapshot(lock, std::move(msg));
+                } else if (!snapshot_requests_.empty()) {
+                    uint64_t peer = *snapshot_requests_.begin();
+                    snapshot_requests_.erase(snapshot_requests_.begin());
+                    send_snapshot(lock, peer);
+                } else {
+                    apply_committed(lock);
+                }
+            } catch (const std::exception& e) {
+                fail(e.what());
+            }
+        }
+    }
+
+    /// 把 (applied_, commit_] 合并为一个 WriteBatch 写入状态机
+    void apply_committed(std::unique_lock<std::mutex>& lock) {
+        uint64_t lo = applied_ + 1;
+        uint64_t hi = lo;
+        WriteBatch batch;
+        for (; hi <= commit_ && batch.byte_size() < options_.max_bytes_per_message; ++hi) {
+            WriteBatch::iterate_rep(log_.entry(hi).batch(), [&](LogType type, std::string_view key,
+                                                                std::string_view value) {
+                if (type == LogType::kPut) {
+                    batch.put(key, value);
+                } else {
+                    batch.del(key);
+                }
+            });
+        }
+        --hi;
+
+        lock.unlock();
+        if (!batch.empty()) store_->write(batch);
+        lock.lock();
+
+        for (auto it = proposals_.lower_bound(lo); it != proposals_.end() && it->first <= hi;) {
+            it->second->done = true;
+            it->second->ok = log_.term_at(it->first) == it->second->term;
+            it = proposals_.erase(it);
+        }
+        applied_ = hi;
+        ++stats_.applied_batches;
+        applied_cv_.notify_all();
+
+        if (options_.snapshot_threshold > 0 &&
+            applied_ - log_.snapshot_index() >= options_.snapshot_threshold + options_.snapshot_retain) {
+            uint64_t applied = applied_;
+            lock.unlock();
+            store_->flush();
+            lock.lock();
+            if (applied > options_.snapshot_retain) log_.compact(applied - options_.snapshot_retain);
+        }
+    }
+
+    /// Leader：生成状态机的 Checkpoint（恰好对应 applied_）发送给 peer
+    void send_snapshot(std::unique_lock<std::mutex>& lock, uint64_t peer) {
+        if (role_ != RaftRole::kLeader) return;
+        uint64_t term = log_.term();
+        RaftMessage msg;
+        msg.type = RaftMessageType::kSnapshot;
+        msg.to = peer;
+        msg.index = applied_;
+        msg.log_term = *log_.term_at(applied_);
+
+        lock.unlock();
+        std::filesystem::path dir = dir_ / kRaftSnapshotDirName;
+        std::filesystem::remove_all(dir);
+        store_->create_checkpoint(dir.string());
+        for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+            std::ifstream in(entry.path(), std::ios::binary);
+            msg.files.emplace_back(entry.path().filename().string(),
+                                   std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>()));
+        }
+        std::filesystem::remove_all(dir);
+        lock.lock();
+
+        if (role_ != RaftRole::kLeader || log_.term() != term) return;
+        msg.context = now_ns();
+        ++stats_.snapshots_sent;
+        send(std::move(msg));
+    }
+
+    /**
+     * @brief Follower：用收到的 SSTable 文件替换状态机目录，再让日志从快照位置继续
+     *
+     * 步骤（每一步之后崩溃，重启时都由 recover_snapshot_install() 完成或回滚）：
+     * 1. 文件写入 snapshot.tmp 并逐个 fsync；
+     * 2. 写入 SNAPSHOT_INSTALL 标记（记录快照位置）并 fsync；
+     * 3. 关闭状态机，db 改名为 db.old，snapshot.tmp 改名为 db，fsync 父目录；
+     * 4. log_.reset() 把快照位置写入 RAFT_META，这是安装生效的提交点；
+     * 5. 删除 db.old 与标记，打开新的状态机。
+     * 提交点之前崩溃时回滚到旧状态机（RAFT_META 仍是旧位置，Leader 会重发快照）；之后则保留新状态机。
+     */
+    void install_snapshot(std::unique_lock<std::mutex>& lock, RaftMessage msg) {
+        namespace fs = std::filesystem;
+        RaftMessage resp;
+        resp.type = RaftMessageType::kSnapshotResponse;
+        resp.to = msg.from;
+        if (msg.index <= applied_) {
+            resp.index = commit_;
+            send(std::move(resp));
+            return;
+        }
+
+        lock.unlock();
+        fs::path staging = dir_ / kRaftSnapshotDirName;
+        fs::path db = dir_ / kRaftStoreDirName;
+        fs::path old = dir_ / kRaftOldStoreDirName;
+        fs::remove_all(staging);
+        fs::create_directories(staging);
+        for (const auto& [name, data] : msg.files) {
+            if (fs::path(name).filename() != name) {
+                throw std::runtime_error("Invalid file name in Raft snapshot: " + name);
+            }
+            WalWriter file(staging / name, 0, /*reuse=*/false);
+            file.append(data);
+            file.sync();
+        }
+        sync_directory(staging);
+        {
+            WalWriter marker(dir_ / kRaftInstallFileName, 0, /*reuse=*/false);
+            marker.append(std::to_string(msg.index) + "\n");
+            marker.sync();
+        }
+        sync_directory(dir_);
+
+        {
+            // 读请求在替换期间等待；锁顺序为 store_mutex_ → mutex_
+            std::unique_lock<std::shared_mutex> store_lock(store_mutex_);
+            store_.reset();
+            fs::remove_all(old);
+            fs::rename(db, old);
+            fs::rename(staging, db);
+            sync_directory(dir_);
+
+            lock.lock();
+            log_.reset(msg.index, msg.log_term);
+            ++log_epoch_;
+            synced_index_ = std::max(std::min(synced_index_, log_.last_index()), msg.index);
+            commit_ = std::max(commit_, msg.index);
+            applied_ = msg.index;
+            lock.unlock();
+
+            fs::remove_all(old);
+            fs::remove(dir_ / kRaftInstallFileName);
+            sync_directory(dir_);
+            store_ = std::make_unique<KVStore>(db.string(), options_.store_options);
+        }
+        lock.lock();
+
+        ++stats_.snapshots_installed;
+        applied_cv_.notify_all();
+
+        resp.index = msg.index;
+        send(std::move(resp));
+    }
+
+    /**
+     * @brief 打开状态机之前，完成或回滚上次崩溃时未完成的快照安装（见 install_snapshot）
+     *
+     * SNAPSHOT_INSTALL 存在说明安装未完成：RAFT_META 已记录该快照位置时保留新的 db，
+     * 否则丢弃（可能不完整的）新 db 并把 db.old 改回 db。
+     */
+    void recover_snapshot_install() {
+        namespace fs = std::filesystem;
+        fs::path marker = dir_ / kRaftInstallFileName;
+        fs::path db = dir_ / kRaftStoreDirName;
+        fs::path old = dir_ / kRaftOldStoreDirName;
+        if (fs::exists(marker)) {
+            uint64_t target = 0;
+            {
+                std::ifstream in(marker);
+                // 标记不完整说明崩溃时尚未改名任何目录，按回滚处理（db 仍是旧状态机）
+                if (!(in >> target)) target = std::numeric_limits<uint64_t>::max();
+            }
+            if (log_.snapshot_index() >= target && fs::exists(db)) {
+                fs::remove_all(old);
+            } else if (fs::exists(old)) {
+                fs::remove_all(db);
+                fs::rename(old, db);
+            }
+            fs::remove(marker);
+            sync_directory(dir_);
+        }
+        fs::remove_all(dir_ / kRaftSnapshotDirName);
+    }
+};
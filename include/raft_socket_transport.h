@@ -0,0 +1,388 @@
+#pragma once
+
+#include "kv_protocol.h"
+#include "kv_server.h"
+#include "raft_message.h"
+#include "raft_node.h"
+#include "raft_transport.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#ifndef __linux__
+#error "raft_socket_transport.h requires Linux sockets"
+#endif
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/**
+ * @file raft_socket_transport.h
+ * @brief 跨进程部署 RaftNode：基于 TCP 的 RaftTransport，以及把 RaftNode 作为 KVServer 存储的 RaftService
+ */
+
+/**
+ * @brief SocketRaftTransport 的选项
+ */
+struct RaftSocketOptions {
+    std::string host = "0.0.0.0";     ///< Raft 端口监听的 IPv4 地址
+    uint16_t port = 0;                ///< Raft 端口，0 表示由系统分配（见 SocketRaftTransport::port()）
+
+    /**
+     * @brief 单条 Raft 消息编码后的大小上限（收发两端都检查）
+     *
+     * InstallSnapshot 把状态机的全部 SSTable 放在一条消息中，上限需要大于状态机的数据量；
+     * 帧长度字段为 32 位，上限不能超过 4 GiB。超过上限的消息在发送端丢弃。
+     */
+    size_t max_frame_size = 1u << 30;
+
+    /// 发往一个 Peer、尚未写入 Socket 的字节数上限：超过时丢弃新消息（Raft 会重传）
+    size_t max_queue_bytes = 256u << 20;
+
+    std::chrono::milliseconds connect_timeout{1000};    ///< 建立连接的超时
+    std::chrono::milliseconds send_timeout{5000};       ///< 单次 send() 没有任何进展的超时，超时后断开重连
+    std::chrono::milliseconds reconnect_backoff{100};   ///< 连接失败后等待多久再重试
+};
+
+/**
+ * @brief 基于 TCP 的 Raft 消息传输
+ *
+ * - **接收**：内部持有一个单 Reactor 的 KVServer 监听 Raft 端口，复用 kv_protocol.h 的帧格式：
+ *   每条消息是一个 kRaftMessage 请求帧（Value 为 encode_raft_message 的结果），没有响应。
+ *   Reactor 只按 To 把消息放进对应节点的 RaftInbox，解码与回调在投递线程上进行，不阻塞 epoll 循环。
+ *   Raft 流量使用独立端口，而不是与客户端共用 KVServer：客户端写入在 Reactor 上阻塞等待多数派确认，
+ *   若确认消息也要经过同一个 Reactor，就会互相等待。
+ * - **发送**：每个 Peer 一个发送队列与发送线程，维持一条到对端 Raft 端口的长连接，
+ *   把队列中的帧一次聚集写出；连接失败或断开时丢弃已排队的消息，退避后重连。
+ *
+ * 用法：构造 → add_peer() 登记其他成员 → start() → 构造 RaftNode；RaftNode 必须先于传输析构。
+ *
+ * @note 本类是线程安全的；start() 只能调用一次。
+ */
+class SocketRaftTransport : public RaftTransport {
+public:
+    explicit SocketRaftTransport(const RaftSocketOptions& options = RaftSocketOptions())
+        : options_(options)
+        , server_(reject_service_, ServerOptions{options.host, options.port, 1, options.max_frame_size}) {
+        if (options_.max_frame_size > UINT32_MAX - 16) {
+            throw std::runtime_error("RaftSocketOptions::max_frame_size must be below 4 GiB");
+        }
+        server_.set_raft_handler([this](std::string_view data) { deliver(data); });
+    }
+
+    ~SocketRaftTransport() override {
+        server_.stop();
+        std::map<uint64_t, std::unique_ptr<Peer>> peers;
+        std::map<uint64_t, std::shared_ptr<RaftInbox>> inboxes;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            peers.swap(peers_);
+            inboxes.swap(inboxes_);
+        }
+        for (auto& [id, peer] : peers) peer->stop();
+        for (auto& [id, inbox] : inboxes) inbox->stop();
+    }
+
+    SocketRaftTransport(const SocketRaftTransport&) = delete;
+    SocketRaftTransport& operator=(const SocketRaftTransport&) = delete;
+
+    /**
+     * @brief 登记成员 id 的 Raft 端口地址（IPv4）
+     *
+     * @throw std::runtime_error 地址无效或 id 已登记
+     */
+    void add_peer(uint64_t id, const std::string& host, uint16_t port) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+            throw std::runtime_error("Invalid Raft peer address: " + host);
+        }
+        auto peer = std::make_unique<Peer>(*this, addr, host + ":" + std::to_string(port));
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!peers_.emplace(id, std::move(peer)).second) {
+            throw std::runtime_error("Raft peer " + std::to_string(id) + " is already registered");
+        }
+    }
+
+    /**
+     * @brief 开始监听 Raft 端口
+     *
+     * @throw std::runtime_error 地址无效或端口被占用
+     */
+    void start() { server_.start(); }
+
+    /// 实际监听的 Raft 端口（start() 之后有效）
+    uint16_t port() const { return server_.port(); }
+
+    void send(RaftMessage msg) override {
+        std::string frame;
+        append_request(frame, RequestOp::kRaftMessage, {}, encode_raft_message(msg));
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = peers_.find(msg.to);
+        if (it == peers_.end() || frame.size() - kFrameHeaderSize > options_.max_frame_size ||
+            !it->second->push(std::move(frame))) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        messages_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void attach(uint64_t id, RaftMessageHandler handler) override {
+        auto inbox = std::make_shared<RaftInbox>(std::move(handler));
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!inboxes_.emplace(id, inbox).second) {
+            inbox->stop();
+            throw std::runtime_error("Raft node " + std::to_string(id) + " is already attached");
+        }
+    }
+
+    void detach(uint64_t id) override {
+        std::shared_ptr<RaftInbox> inbox;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = inboxes_.find(id);
+            if (it == inboxes_.end()) return;
+            inbox = std::move(it->second);
+            inboxes_.erase(it);
+        }
+        inbox->stop();
+    }
+
+    /// 已放入发送队列的消息数
+    uint64_t messages() const { return messages_.load(std::memory_order_relaxed); }
+
+    /// 已写入 Socket 的字节数（含帧头）
+    uint64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+    /// 因目标未知、消息过大、队列已满或连接失败而丢弃的消息数
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    /// Raft 端口上的客户端请求一律失败（内部 KVServer 只转发 kRaftMessage）
+    class RejectService : public KVService {
+    public:
+        bool get(std::string_view, PinnableValue*) override { throw std::runtime_error(kMessage); }
+        void write(const WriteBatch&) override { throw std::runtime_error(kMessage); }
+
+    private:
+        static constexpr const char* kMessage = "This port only serves Raft messages";
+    };
+
+    /// 一个 Peer 的发送队列、连接与发送线程
+    class Peer {
+    public:
+        Peer(SocketRaftTransport& transport, const sockaddr_in& addr, std::string name)
+            : transport_(transport), addr_(addr), name_(std::move(name)) {
+            thread_ = std::thread([this] { run(); });
+        }
+
+        /// @return false 表示队列已满（调用者持有 transport_.mutex_）
+        bool push(std::string frame) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (queued_bytes_ + frame.size() > transport_.options_.max_queue_bytes && !queue_.empty()) {
+                    return false;
+                }
+                queued_bytes_ += frame.size();
+                queue_.push_back(std::move(frame));
+            }
+            cv_.notify_one();
+            return true;
+        }
+
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stopping_) return;
+                stopping_ = true;
+                if (fd_ >= 0) ::shutdown(fd_, SHUT_RDWR);  // 打断阻塞中的 send()
+            }
+            cv_.notify_one();
+            thread_.join();
+        }
+
+    private:
+        static constexpr int kMaxIov = 64;
+
+        SocketRaftTransport& transport_;
+        sockaddr_in addr_;
+        std::string name_;
+        std::mutex mutex_;  ///< 保护 queue_ / queued_bytes_ / stopping_ / fd_
+        std::condition_variable cv_;
+        std::deque<std::string> queue_;
+        size_t queued_bytes_ = 0;
+        bool stopping_ = false;
+        int fd_ = -1;
+        std::thread thread_;
+
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (;;) {
+                cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (stopping_) break;
+                if (fd_ < 0) {
+                    lock.unlock();
+                    int fd = connect_peer();
+                    lock.lock();
+                    if (fd < 0) {
+                        drop_queue();
+                        cv_.wait_for(lock, transport_.options_.reconnect_backoff, [this] { return stopping_; });
+                        continue;
+                    }
+                    fd_ = fd;
+                    if (stopping_) break;
+                }
+
+                std::deque<std::string> frames;
+                frames.swap(queue_);
+                queued_bytes_ = 0;
+                int fd = fd_;
+                lock.unlock();
+                int error = send_frames(fd, frames);
+                lock.lock();
+                if (error != 0) {
+                    if (!stopping_) {
+                        std::cerr << "[SocketRaftTransport] Send to " << name_ << " failed: "
+                                  << std::strerror(error) << ", reconnecting" << std::endl;
+                    }
+                    ::close(fd_);
+                    fd_ = -1;
+                    transport_.dropped_.fetch_add(frames.size(), std::memory_order_relaxed);
+                }
+            }
+            if (fd_ >= 0) ::close(fd_);
+            fd_ = -1;
+        }
+
+        /// 连接失败时丢弃已排队的消息（调用者持有 mutex_）
+        void drop_queue() {
+            size_t dropped = queue_.size();
+            queue_.clear();
+            queued_bytes_ = 0;
+            transport_.dropped_.fetch_add(dropped, std::memory_order_relaxed);
+        }
+
+        /// 带超时的非阻塞连接，成功后切回阻塞模式并设置发送超时；失败返回 -1
+        int connect_peer() {
+            int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) return -1;
+            int rc = ::connect(fd, reinterpret_cast<const sockaddr*>(&addr_), sizeof(addr_));
+            if (rc != 0 && errno == EINPROGRESS) {
+                pollfd pfd{fd, POLLOUT, 0};
+                int timeout = static_cast<int>(transport_.options_.connect_timeout.count());
+                int error = ETIMEDOUT;
+                socklen_t len = sizeof(error);
+                if (::poll(&pfd, 1, timeout) == 1) ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+                rc = error == 0 ? 0 : -1;
+            }
+            if (rc != 0) {
+                ::close(fd);
+                return -1;
+            }
+
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+            int on = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            auto ms = transport_.options_.send_timeout.count();
+            timeval tv{static_cast<time_t>(ms / 1000), static_cast<suseconds_t>((ms % 1000) * 1000)};
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+            return fd;
+        }
+
+        /// 用 sendmsg 聚集写出全部帧；成功发出的帧从 frames 中移除，失败返回 errno
+        int send_frames(int fd, std::deque<std::string>& frames) {
+            size_t offset = 0;  // frames.front() 中已发送的字节数
+            while (!frames.empty()) {
+                iovec iov[kMaxIov];
+                int count = 0;
+                for (const std::string& frame : frames) {
+                    size_t skip = count == 0 ? offset : 0;
+                    iov[count].iov_base = const_cast<char*>(frame.data() + skip);
+                    iov[count].iov_len = frame.size() - skip;
+                    if (++count == kMaxIov) break;
+                }
+                msghdr msg{};
+                msg.msg_iov = iov;
+                msg.msg_iovlen = static_cast<size_t>(count);
+                ssize_t n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    return errno;
+                }
+                transport_.bytes_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+                offset += static_cast<size_t>(n);
+                while (!frames.empty() && offset >= frames.front().size()) {
+                    offset -= frames.front().size();
+                    frames.pop_front();
+                }
+            }
+            return 0;
+        }
+    };
+
+    /// Reactor 线程上收到一个 kRaftMessage 帧：按 To 放入对应节点的接收队列
+    void deliver(std::string_view data) {
+        uint64_t to = 0;
+        if (!peek_raft_message_target(data, &to)) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = inboxes_.find(to);
+        if (it != inboxes_.end()) it->second->push(std::string(data));
+    }
+
+    RaftSocketOptions options_;
+    RejectService reject_service_;
+    KVServer server_;
+
+    /// 保护 peers_ / inboxes_；持有时可以再取 Peer 的锁，反之不行（统计用原子变量，发送线程不取本锁）
+    std::mutex mutex_;
+    std::map<uint64_t, std::unique_ptr<Peer>> peers_;
+    std::map<uint64_t, std::shared_ptr<RaftInbox>> inboxes_;
+    std::atomic<uint64_t> messages_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+/**
+ * @brief 以 RaftNode 为存储的 KVService：客户端经 KVServer 访问一个副本组
+ *
+ * Get 是线性一致读，Put / Delete 攒成的批次作为一条日志条目提交，两者都只能在 Leader 上成功；
+ * 在 Follower 上返回 kError（"Not the Raft leader (leader: N)"），客户端据此改连 Leader。
+ */
+class RaftService : public KVService {
+public:
+    explicit RaftService(RaftNode& node) : node_(node) {}
+
+    bool get(std::string_view key, PinnableValue* value) override {
+        std::optional<std::string> result = node_.get(key);
+        if (!result) return false;
+        value->assign(*result);
+        return true;
+    }
+
+    void write(const WriteBatch& batch) override { node_.write(batch); }
+
+private:
+    RaftNode& node_;
+};
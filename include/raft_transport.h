@@ -0,0 +1,193 @@
+#pragma once
+
+#include "raft_message.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+/**
+ * @file raft_transport.h
+ * @brief RaftNode 之间的消息传输接口，以及进程内的实现 LocalRaftNetwork
+ *        （跨进程的 TCP 实现见 raft_socket_transport.h）
+ */
+
+/// 收到消息时的回调
+using RaftMessageHandler = std::function<void(RaftMessage)>;
+
+/**
+ * @brief Raft 消息传输
+ *
+ * Raft 本身容忍消息丢失、重复与乱序，实现只需尽力投递。
+ * send() 在 RaftNode 持有内部锁时调用，**不得阻塞**（写入发送队列后立即返回）。
+ */
+class RaftTransport {
+public:
+    virtual ~RaftTransport() = default;
+
+    /// 把 msg 发送给 msg.to
+    virtual void send(RaftMessage msg) = 0;
+
+    /// 注册节点 id 的接收回调（回调在传输层的线程上串行调用）
+    virtual void attach(uint64_t id, RaftMessageHandler handler) = 0;
+
+    /// 注销节点 id：返回后回调不会再被调用（不能在回调内部调用）
+    virtual void detach(uint64_t id) = 0;
+};
+
+/**
+ * @brief 一个节点的接收队列与投递线程
+ *
+ * push() 只把编码后的消息入队，投递线程解码后串行调用回调，发送方（或网络线程）不会被回调阻塞。
+ */
+class RaftInbox {
+public:
+    explicit RaftInbox(RaftMessageHandler handler) : handler_(std::move(handler)) {
+        thread_ = std::thread([this] { run(); });
+    }
+
+    void push(std::string data) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(data));
+        }
+        cv_.notify_one();
+    }
+
+    /// 停止投递线程：返回后回调不会再被调用；可重复调用
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) return;
+            stopping_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+private:
+    RaftMessageHandler handler_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::string> queue_;
+    bool stopping_ = false;
+    std::thread thread_;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) return;
+            std::string data = std::move(queue_.front());
+            queue_.pop_front();
+            lock.unlock();
+            RaftMessage msg;
+            if (decode_raft_message(data, &msg)) handler_(std::move(msg));
+            lock.lock();
+        }
+    }
+};
+
+/**
+ * @brief 进程内的 Raft 网络：每个节点一个接收队列与投递线程
+ *
+ * 消息在发送时编码、投递时解码（与真实网络一样经过 encode_raft_message / decode_raft_message），
+ * 用于测试与单机多副本部署。disconnect() 模拟网络分区：与该节点之间的消息在发送时被丢弃。
+ *
+ * @note 本类是线程安全的。
+ */
+class LocalRaftNetwork : public RaftTransport {
+public:
+    ~LocalRaftNetwork() override {
+        std::map<uint64_t, std::shared_ptr<RaftInbox>> endpoints;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            endpoints.swap(endpoints_);
+        }
+        for (auto& [id, endpoint] : endpoints) endpoint->stop();
+    }
+
+    void send(RaftMessage msg) override {
+        std::string data = encode_raft_message(msg);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (disconnected_.count(msg.from) != 0 || disconnected_.count(msg.to) != 0) {
+            ++dropped_;
+            return;
+        }
+        auto it = endpoints_.find(msg.to);
+        if (it == endpoints_.end()) {
+            ++dropped_;
+            return;
+        }
+        ++messages_;
+        bytes_ += data.size();
+        it->second->push(std::move(data));
+    }
+
+    void attach(uint64_t id, RaftMessageHandler handler) override {
+        auto endpoint = std::make_shared<RaftInbox>(std::move(handler));
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!endpoints_.emplace(id, endpoint).second) {
+            endpoint->stop();
+            throw std::runtime_error("Raft node " + std::to_string(id) + " is already attached");
+        }
+    }
+
+    void detach(uint64_t id) override {
+        std::shared_ptr<RaftInbox> endpoint;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = endpoints_.find(id);
+            if (it == endpoints_.end()) return;
+            endpoint = std::move(it->second);
+            endpoints_.erase(it);
+        }
+        endpoint->stop();
+    }
+
+    /// 切断节点 id 与其他所有节点之间的消息（双向）
+    void disconnect(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        disconnected_.insert(id);
+    }
+
+    /// 恢复节点 id 的连通
+    void connect(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        disconnected_.erase(id);
+    }
+
+    /// 已投递的消息数
+    uint64_t messages() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return messages_;
+    }
+
+    /// 已投递消息的编码总字节数
+    uint64_t bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bytes_;
+    }
+
+    /// 因分区或目标不存在而丢弃的消息数
+    uint64_t dropped() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return dropped_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::map<uint64_t, std::shared_ptr<RaftInbox>> endpoints_;
+    std::set<uint64_t> disconnected_;
+    uint64_t messages_ = 0;
+    uint64_t bytes_ = 0;
+    uint64_t dropped_ = 0;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "coding.h"
+#include "comparator.h"
+#include "dbformat.h"
+#include "memtable.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/**
+ * @file replay_worker.h
+ * @brief 并行 WAL 重放中的一个应用线程：把分发给它的操作写入自己的 MemTable
+ */
+
+/**
+ * @brief WAL 并行重放的应用线程
+ *
+ * 扫描线程顺序读取并校验 WAL，把每个操作按 Key 分发给固定的一个 ReplayWorker，
+ * 因此同一个 Key 的全部版本都由同一个线程、按 WAL 中的顺序写入同一个 MemTable；
+ * 版本之间的先后由序列号决定（内部 Key 按序列号降序），与写入 MemTable 的线程无关。
+ *
+ * 操作在扫描线程一侧先编码进一个块 (chunk)，块满后整块交给应用线程，减少同步次数：
+ * +---------------+---------+-------------------+-----+---------------------+-------+
+ * | Sequence (8B) | Type(1B)| KeyLen (varint32) | Key | ValueLen (varint32) | Value |
+ * +---------------+---------+-------------------+-----+---------------------+-------+
+ * 排队中的块数有上限，应用跟不上扫描时 add() 阻塞，重放占用的额外内存有界。
+ *
+ * @note add() / finish() 只能由同一个（扫描）线程调用。
+ */
+class ReplayWorker {
+public:
+    explicit ReplayWorker(const Comparator* comparator)
+        : mem_(std::make_shared<MemTable>(comparator)), thread_([this] { run(); }) {}
+
+    ~ReplayWorker() { stop(); }
+
+    ReplayWorker(const ReplayWorker&) = delete;
+    ReplayWorker& operator=(const ReplayWorker&) = delete;
+
+    /// 追加一个操作（kDeletion 时 value 为空）
+    void add(SequenceNumber sequence, ValueType type, std::string_view key, std::string_view value) {
+        put_fixed64(chunk_, sequence);
+        chunk_.push_back(static_cast<char>(type));
+        put_varint32(chunk_, static_cast<uint32_t>(key.size()));
+        chunk_.append(key);
+        put_varint32(chunk_, static_cast<uint32_t>(value.size()));
+        chunk_.append(value);
+        if (chunk_.size() >= kChunkSize) submit();
+    }
+
+    /**
+     * @brief 等待全部操作应用完毕并停止线程
+     *
+     * @return 重放出的 MemTable（之后不再被修改）
+     */
+    std::shared_ptr<MemTable> finish() {
+        if (!chunk_.empty()) submit();
+        stop();
+        return mem_;
+    }
+
+private:
+    static constexpr size_t kChunkSize = 64 * 1024;  ///< 块的目标大小
+    static constexpr size_t kMaxPendingChunks = 8;   ///< 排队中的块数上限
+
+    std::shared_ptr<MemTable> mem_;
+    std::string chunk_;  ///< 扫描线程正在填充的块
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::string> chunks_;
+    bool done_ = false;
+    std::thread thread_;
+
+    void submit() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return chunks_.size() < kMaxPendingChunks; });
+        chunks_.push_back(std::move(chunk_));
+        chunk_.clear();
+        lock.unlock();
+        cv_.notify_all();
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        cv_.notify_all();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return done_ || !chunks_.empty(); });
+            if (chunks_.empty()) return;
+            std::string chunk = std::move(chunks_.front());
+            chunks_.pop_front();
+            lock.unlock();
+            cv_.notify_all();
+            apply(chunk);
+            lock.lock();
+        }
+    }
+
+    /// 块由本进程的 add() 编码，格式总是完整的
+    void apply(std::string_view chunk) {
+        const char* p = chunk.data();
+        const char* limit = p + chunk.size();
+        while (p < limit) {
+            SequenceNumber sequence = decode_fixed64(p);
+            ValueType type = static_cast<ValueType>(p[8]);
+            uint32_t key_len = 0;
+            uint32_t value_len = 0;
+            p = get_varint32_ptr(p + 9, limit, &key_len);
+            std::string_view key(p, key_len);
+            p = get_varint32_ptr(p + key_len, limit, &value_len);
+            mem_->add(sequence, type, key, std::string_view(p, value_len));
+            p += value_len;
+        }
+    }
+};
@@ -0,0 +1,355 @@
+#pragma once
+
+#include "block_cache.h"
+#include "cpu_affinity.h"
+#include "filename.h"
+#include "kv_store.h"
+#include "options.h"
+#include "pinnable_value.h"
+#include "write_batch.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @file sharded_kv_store.h
+ * @brief 按 Key 的哈希把数据分布到 N 个独立 KVStore 的分片存储（Shared-Nothing）
+ */
+
+/**
+ * @brief ShardedKVStore 的选项
+ */
+struct ShardedKVStoreOptions {
+    /// 分片数，0 表示取 CPU 核数；创建后固定，之后必须以相同的分片数打开
+    size_t num_shards = 0;
+
+    /// 是否把分片 i 的工作线程与后台线程绑定到 CPU i（仅 Linux 生效）
+    bool pin_to_cores = true;
+
+    /**
+     * @brief 每个分片的 KVStore 选项
+     *
+     * memtable_size_limit 等按分片计算；未提供 table_options.block_cache 时，
+     * 按 block_cache_capacity 创建一个所有分片共享的块缓存（而不是每个分片一个）。
+     */
+    KVStoreOptions shard_options;
+};
+
+/**
+ * @brief 哈希分片的 KVStore
+ *
+ * 单个 KVStore 只有一个 MemTable、一个 WAL 与一个写入者队列，所有写入都经过同一个 Leader。
+ * ShardedKVStore 把 Key 按哈希路由到 N 个完全独立的 KVStore（各自的子目录、WAL、MemTable、
+ * 后台线程），不同分片的写入互不等待，写吞吐随分片数（核数）扩展。
+ *
+ * - **单 Key 操作** 在调用线程上直接访问对应分片（KVStore 本身线程安全），没有线程切换。
+ * - **multi_get / 跨分片 write** 按分片分组，由各分片绑定在自己核心上的工作线程并行执行，
+ *   调用线程负责其中一组。
+ *
+ * 一致性语义：
+ * - 同一分片内的 WriteBatch 仍是原子的（一条 WAL 记录）。
+ * - 跨分片的 WriteBatch 拆成每个分片一个子批次并行提交，**崩溃时不保证跨分片原子性**
+ *   （部分分片的子批次可能已持久化）；write() 抛出异常时同样可能有部分分片已生效。
+ * - 哈希分区不保持 Key 的顺序，范围扫描需要对 shard(i) 逐个进行。
+ *
+ * @note 本类是线程安全的。
+ */
+class ShardedKVStore {
+public:
+    /**
+     * @param dir 根目录；分片 i 的数据位于 dir/shard_<i>
+     * @param options 选项
+     * @throw std::runtime_error 已有目录的分片数与 options.num_shards 不一致，或任一分片打开失败
+     */
+    explicit ShardedKVStore(const std::string& dir, const ShardedKVStoreOptions& options = {})
+        : root_(dir), options_(options) {
+        std::filesystem::create_directories(root_);
+        size_t shards = resolve_shard_count();
+
+        KVStoreOptions shard_options = options_.shard_options;
+        if (!shard_options.table_options.block_cache && shard_options.block_cache_capacity > 0) {
+            shard_options.table_options.block_cache =
+                std::make_shared<BlockCache>(shard_options.block_cache_capacity);
+        }
+        for (size_t i = 0; i < shards; ++i) {
+            int cpu = options_.pin_to_cores ? static_cast<int>(i) : -1;
+            shard_options.background_cpu = cpu;
+            shards_.push_back(std::make_unique<Shard>((root_ / shard_dir_name(i)).string(), shard_options, cpu));
+        }
+    }
+
+    ShardedKVStore(const ShardedKVStore&) = delete;
+    ShardedKVStore& operator=(const ShardedKVStore&) = delete;
+
+    size_t num_shards() const { return shards_.size(); }
+
+    /// Key 所在的分片下标
+    size_t shard_index(std::string_view key) const { return static_cast<size_t>(shard_hash(key) % shards_.size()); }
+
+    /// 直接访问某个分片（统计信息、扫描、快照等按分片进行的操作）
+    KVStore& shard(size_t index) { return shards_[index]->store; }
+    const KVStore& shard(size_t index) const { return shards_[index]->store; }
+
+    /// @throw std::runtime_error 同 KVStore::put
+    void put(std::string_view key, std::string_view value) { store_for(key).put(key, value); }
+    void put(int key, std::string_view value) { put(encode_int_key(key), value); }
+
+    /// @throw std::runtime_error 同 KVStore::get
+    std::optional<std::string> get(std::string_view key) const { return store_for(key).get(key); }
+    std::optional<std::string> get(int key) const { return get(encode_int_key(key)); }
+
+    /// 零拷贝读取，语义同 KVStore::get(key, PinnableValue*)
+    bool get(std::string_view key, PinnableValue* value) const { return store_for(key).get(key, value); }
+
+    /// @return true 删除前 Key 存在
+    bool del(std::string_view key) { return store_for(key).del(key); }
+    bool del(int key) { return del(encode_int_key(key)); }
+
+    /**
+     * @brief 批量写入：按分片拆成子批次，涉及多个分片时并行提交
+     *
+     * 只涉及一个分片时与 KVStore::write 完全相同（原子）；跨分片时见类注释中的一致性语义。
+     *
+     * @throw std::runtime_error 任一分片提交失败（其余分片的子批次可能已生效）
+     */
+    void write(const WriteBatch& batch) {
+        if (batch.empty()) return;
+        std::vector<WriteBatch> parts(shards_.size());
+        std::vector<size_t> touched;
+        batch.iterate([&](LogType type, std::string_view key, std::string_view value) {
+            size_t index = shard_index(key);
+            if (parts[index].empty()) touched.push_back(index);
+            if (type == LogType::kPut) {
+                parts[index].put(key, value);
+            } else {
+                parts[index].del(key);
+            }
+        });
+        run_on_shards(touched, [&](size_t index) { shards_[index]->store.write(parts[index]); });
+    }
+
+    /**
+     * @brief 并行点查：按分片分组后由各分片的工作线程同时查询
+     *
+     * @return 与 keys 一一对应的结果，不存在的 Key 为 std::nullopt
+     * @throw std::runtime_error 任一分片读取失败
+     */
+    std::vector<std::optional<std::string>> multi_get(const std::vector<std::string_view>& keys) const {
+        std::vector<std::optional<std::string>> results(keys.size());
+        std::vector<std::vector<size_t>> groups(shards_.size());
+        std::vector<size_t> touched;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            size_t index = shard_index(keys[i]);
+            if (groups[index].empty()) touched.push_back(index);
+            groups[index].push_back(i);
+        }
+        run_on_shards(touched, [&](size_t index) {
+            const KVStore& store = shards_[index]->store;
+            for (size_t i : groups[index]) results[i] = store.get(keys[i]);
+        });
+        return results;
+    }
+
+    /// 所有分片并行强制落盘（语义同 KVStore::flush）
+    void flush() {
+        run_on_shards(all_shards(), [&](size_t index) { shards_[index]->store.flush(); });
+    }
+
+    /// 所有分片并行执行全量 Compaction（语义同 KVStore::compact）
+    void compact() {
+        run_on_shards(all_shards(), [&](size_t index) { shards_[index]->store.compact(); });
+    }
+
+    /// 所有分片的 WAL 统计之和（max_group_size 取最大值）
+    WalStats wal_stats() const {
+        WalStats total;
+        for (const auto& shard : shards_) {
+            WalStats s = shard->store.wal_stats();
+            total.records += s.records;
+            total.bytes += s.bytes;
+            total.write_groups += s.write_groups;
+            total.syncs += s.syncs;
+            total.max_group_size = std::max(total.max_group_size, s.max_group_size);
+            total.segments += s.segments;
+            total.recycled_segments += s.recycled_segments;
+        }
+        return total;
+    }
+
+    /**
+     * @brief 分片路由使用的 64 位哈希（FNV-1a + 终结混合）
+     *
+     * 必须在版本之间保持不变，否则已有数据会被路由到错误的分片。
+     * 与 BloomFilter::Hash 不同源，避免同一分片内 Key 的过滤器探测位置相关。
+     */
+    static uint64_t shard_hash(std::string_view key) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (char c : key) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 0x100000001b3ull;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return h;
+    }
+
+private:
+    /**
+     * @brief 分片的工作线程：执行 multi_get / 跨分片 write 中属于本分片的部分
+     */
+    class Worker {
+    public:
+        explicit Worker(int cpu) {
+            thread_ = std::thread([this] { run(); });
+            pin_thread_to_cpu(thread_, cpu);
+        }
+
+        ~Worker() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_one();
+            thread_.join();
+        }
+
+        Worker(const Worker&) = delete;
+        Worker& operator=(const Worker&) = delete;
+
+        void submit(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                tasks_.push_back(std::move(task));
+            }
+            cv_.notify_one();
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<std::function<void()>> tasks_;
+        bool stop_ = false;
+        std::thread thread_;
+
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (;;) {
+                cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty()) return;
+                std::function<void()> task = std::move(tasks_.front());
+                tasks_.pop_front();
+                lock.unlock();
+                task();
+                lock.lock();
+            }
+        }
+    };
+
+    struct Shard {
+        Shard(const std::string& dir, const KVStoreOptions& options, int cpu) : store(dir, options), worker(cpu) {}
+
+        KVStore store;
+        Worker worker;
+    };
+
+    std::filesystem::path root_;
+    ShardedKVStoreOptions options_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    KVStore& store_for(std::string_view key) { return shards_[shard_index(key)]->store; }
+    const KVStore& store_for(std::string_view key) const { return shards_[shard_index(key)]->store; }
+
+    std::vector<size_t> all_shards() const {
+        std::vector<size_t> indexes(shards_.size());
+        for (size_t i = 0; i < indexes.size(); ++i) indexes[i] = i;
+        return indexes;
+    }
+
+    /**
+     * @brief 对 indexes 中的每个分片执行 fn(index)：除最后一个外交给各分片的工作线程，
+     *        最后一个在调用线程上执行，全部完成后返回
+     *
+     * @throw 任一 fn 抛出的第一个异常（其余分片仍会执行完毕）
+     */
+    template <typename Fn>
+    void run_on_shards(const std::vector<size_t>& indexes, Fn&& fn) const {
+        if (indexes.empty()) return;
+        if (indexes.size() == 1) {
+            fn(indexes.front());
+            return;
+        }
+        std::vector<std::exception_ptr> errors(indexes.size());
+        std::latch done(static_cast<std::ptrdiff_t>(indexes.size() - 1));
+        for (size_t i = 0; i + 1 < indexes.size(); ++i) {
+            shards_[indexes[i]]->worker.submit([&, i] {
+                try {
+                    fn(indexes[i]);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+                done.count_down();
+            });
+        }
+        try {
+            fn(indexes.back());
+        } catch (...) {
+            errors.back() = std::current_exception();
+        }
+        done.wait();
+        for (const std::exception_ptr& error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * @brief 新目录写入 SHARDS 文件；已有目录校验分片数一致
+     *
+     * SHARDS 先写入临时文件并 fsync，改名后再 fsync 根目录（与 VersionSet::SetCurrentFile
+     * 切换 CURRENT 的步骤相同），之后才创建分片：崩溃后不会出现分片目录已有数据、
+     * SHARDS 却为空或缺失的状态。
+     */
+    size_t resolve_shard_count() {
+        size_t shards = options_.num_shards > 0 ? options_.num_shards : available_cpus();
+        std::filesystem::path path = root_ / kShardsFileName;
+        if (std::filesystem::exists(path)) {
+            std::ifstream in(path);
+            size_t existing = 0;
+            if (!(in >> existing) || existing == 0) {
+                throw std::runtime_error("Corrupted shard count file: " + path.string());
+            }
+            if (options_.num_shards > 0 && options_.num_shards != existing) {
+                throw std::runtime_error("Store " + root_.string() + " has " + std::to_string(existing) +
+                                         " shards, cannot open with " + std::to_string(options_.num_shards));
+            }
+            return existing;
+        }
+
+        std::filesystem::path tmp = path;
+        tmp += ".tmp";
+        {
+            WalWriter out(tmp, 0, /*reuse=*/false);
+            out.append(std::to_string(shards) + "\n");
+            out.sync();
+        }
+        std::filesystem::rename(tmp, path);
+        sync_directory(root_);
+        return shards;
+    }
+};
@@ -1,8 +1,10 @@
 #pragma once
+#include <algorithm>
 #include <vector>
 #include <memory>
 #include <random>
 #include <optional>
+#include <utility>
 /**
  * @brief 跳表节点结构体
  * @tparam K 键类型
@@ -26,7 +28,7 @@ struct Node {
      * @param level 节点的高度（层数）
      */
     Node(K k, V v, int level)
-        : key(k), value(v), forward(level, nullptr) {}
+        : key(std::move(k)), value(std::move(v)), forward(level, nullptr) {}
 };
 
 /**
@@ -40,7 +42,14 @@ private:
     Node<K, V>* head;   // 跳表的头节点（哨兵节点）
     float p;            // 节点层数晋升的概率因子
 
-    std::vector<std::unique_ptr<Node<K, V>>> nodes_storage;
+    /**
+     * @brief 被删除节点的空闲链表，按高度分桶（free_nodes[h - 1] 存放高度为 h 的节点）
+     *
+     * 节点由跳表侵入式地持有（链表本身即所有权），删除时直接摘链，不需要在所有权表中查找。
+     * 摘下的节点放入空闲链表，之后插入同样高度的节点时直接复用，省去一次 new / delete；
+     * 空闲节点的总数不超过历史上的最大节点数，在析构时统一释放。
+     */
+    std::vector<std::vector<Node<K, V>*>> free_nodes;
     std::mt19937 rng;
     std::uniform_real_distribution<float> dist;
 
@@ -59,6 +68,22 @@ private:
         return level;
     }
 
+    /**
+     * @brief 创建一个高度为 level 的节点，优先复用空闲链表中同样高度的节点
+     */
+    Node<K, V>* new_node(K key, V value, int level) {
+        auto& bucket = free_nodes[level - 1];
+        if (bucket.empty()) {
+            return new Node<K, V>(std::move(key), std::move(value), level);
+        }
+        Node<K, V>* node = bucket.back();
+        bucket.pop_back();
+        node->key = std::move(key);
+        node->value = std::move(value);
+        std::fill(node->forward.begin(), node->forward.end(), nullptr);
+        return node;
+    }
+
 public:
     /**
      * @brief SkipList 构造函数
@@ -69,22 +94,39 @@ public:
         : max_level(max_lvl),
           current_level(1),
           p(prob),
+          free_nodes(static_cast<size_t>(max_lvl)),
           rng(std::random_device{}()),
           dist(0.0f, 1.0f) {
         // 创建哨兵头节点，其高度为最大层数
-        auto head_node = std::make_unique<Node<K, V>>(K(), V(), max_level);
-        head = head_node.get();
-        nodes_storage.push_back(std::move(head_node));
+        head = new Node<K, V>(K(), V(), max_level);
     }
 
     /**
      * @brief 析构函数，负责释放跳表中所有节点的内存
+     *
+     * 节点沿 Level 0 链表逐个释放，随后释放空闲链表中的节点与头节点。
      */
-    ~SkipList() = default;
+    ~SkipList() {
+        Node<K, V>* node = head->forward[0];
+        while (node != nullptr) {
+            Node<K, V>* next = node->forward[0];
+            delete node;
+            node = next;
+        }
+        for (auto& bucket : free_nodes) {
+            for (Node<K, V>* free_node : bucket) delete free_node;
+        }
+        delete head;
+    }
+
+    SkipList(const SkipList&) = delete;
+    SkipList& operator=(const SkipList&) = delete;
 
     /**
      * @brief 插入或更新一个键值对
      * 
+     * 参数按值传递并在内部移动到节点中：调用者传入 std::move(value) 时大值不发生拷贝。
+     *
      * @param key 待插入的键
      * @param value 待插入的值
      * @return true 插入成功
@@ -98,7 +140,16 @@ public:
      * @param key 待查找的键
      * @return std::optional<V> 如果找到则返回包含值的 optional，否则返回 std::nullopt
      */
-    std::optional<V> search(K key);
+    std::optional<V> search(K key) const;
+
+    /**
+     * @brief 根据键查找对应的值（不拷贝值）
+     *
+     * @param key 待查找的键
+     * @return const V* 指向节点中的值；键不存在时为 nullptr。
+     *         指针在该键被覆盖写、删除或跳表析构之前有效
+     */
+    const V* find(const K& key) const;
 
     /**
      * @brief 根据键删除节点
@@ -108,6 +159,87 @@ public:
      * @return false 键不存在，删除失败
      */
     bool remove(K key);
+
+    /**
+     * @brief 按 key 升序遍历所有节点（沿 Level 0 链表）
+     *
+     * 用于 MemTable 落盘：有序地把每个键值对交给 SSTableBuilder。
+     *
+     * @tparam F 可调用对象，签名为 void(const K& key, const V& value)
+     */
+    template <typename F>
+    void for_each(F&& fn) const {
+        for (Node<K, V>* node = head->forward[0]; node != nullptr; node = node->forward[0]) {
+            fn(node->key, node->value);
+        }
+    }
+
+    /**
+     * @brief 双向有序迭代器
+     *
+     * Next 沿 Level 0 链表前进，O(1)；节点没有后退指针，Prev 从高层重新查找前驱，O(log n)。
+     * insert 不会使迭代器失效；remove 掉迭代器所在的节点后迭代器失效。
+     */
+    class Iterator {
+    public:
+        explicit Iterator(const SkipList* list) : list_(list) {}
+
+        bool Valid() const { return node_ != nullptr; }
+
+        const K& key() const { return node_->key; }
+        const V& value() const { return node_->value; }
+
+        void Next() {
+            if (node_) node_ = node_->forward[0];
+        }
+
+        void Prev() {
+            if (node_) node_ = list_->find_less_than(node_->key);
+        }
+
+        /// 定位到第一个 key >= target 的节点
+        void Seek(const K& target) { node_ = list_->find_greater_or_equal(target); }
+
+        void SeekToFirst() { node_ = list_->head->forward[0]; }
+
+        void SeekToLast() { node_ = list_->find_last(); }
+
+    private:
+        const SkipList* list_;
+        Node<K, V>* node_ = nullptr;
+    };
+
+private:
+    /// 第一个 key >= target 的节点（不存在时为 nullptr）
+    Node<K, V>* find_greater_or_equal(const K& target) const {
+        Node<K, V>* current = head;
+        for (int i = current_level - 1; i >= 0; i--) {
+            while (current->forward[i] && current->forward[i]->key < target) {
+                current = current->forward[i];
+            }
+        }
+        return current->forward[0];
+    }
+
+    /// 最后一个 key < target 的节点（不存在时为 nullptr）
+    Node<K, V>* find_less_than(const K& target) const {
+        Node<K, V>* current = head;
+        for (int i = current_level - 1; i >= 0; i--) {
+            while (current->forward[i] && current->forward[i]->key < target) {
+                current = current->forward[i];
+            }
+        }
+        return current == head ? nullptr : current;
+    }
+
+    /// 最后一个节点（跳表为空时为 nullptr）
+    Node<K, V>* find_last() const {
+        Node<K, V>* current = head;
+        for (int i = current_level - 1; i >= 0; i--) {
+            while (current->forward[i]) current = current->forward[i];
+        }
+        return current == head ? nullptr : current;
+    }
 };
 
 template <typename K, typename V>
@@ -130,7 +262,7 @@ bool SkipList<K, V>::insert(K key, V value) {
     // current 现在指向 Level 0 的前驱，检查它的下一个节点
     current = current->forward[0];
     if(current && current->key == key){
-        current->value = value; // Key 存在，更新 Value
+        current->value = std::move(value); // Key 存在，更新 Value
         return true;
     }
 
@@ -146,10 +278,8 @@ bool SkipList<K, V>::insert(K key, V value) {
         current_level = new_level;
     }
 
-    // 6. 创建新节点
-    // 使用 make_unique 创建节点，确保异常安全
-    auto new_node = std::make_unique<Node<K,V>>(key, value, new_level);
-    Node<K, V>* ptr = new_node.get(); // 获取裸指针用于链表操作
+    // 6. 创建新节点（优先复用被删除的同高度节点）
+    Node<K, V>* ptr = new_node(std::move(key), std::move(value), new_level);
 
     // 7. 逐层调整指针，将新节点插入链表
     for(int i = 0; i < new_level; i++){
@@ -158,14 +288,18 @@ bool SkipList<K, V>::insert(K key, V value) {
         // 前驱指向新节点
         update[i]->forward[i] = ptr;
     }
-
-    // 8. 将新节点的所有权移交给 nodes_storage 管理，避免内存泄漏
-    nodes_storage.push_back(std::move(new_node));
     return true;
 }
 
 template <typename K, typename V>
-std::optional<V> SkipList<K, V>::search(K key){
+std::optional<V> SkipList<K, V>::search(K key) const {
+    const V* value = find(key);
+    if (value == nullptr) return std::nullopt;
+    return *value;
+}
+
+template <typename K, typename V>
+const V* SkipList<K, V>::find(const K& key) const {
     // 从头结点（哨兵）出发。head 不存有效数据，只用于统一边界处理
     Node<K, V>* current = head;
 
@@ -183,11 +317,10 @@ std::optional<V> SkipList<K, V>::search(K key){
     // 候选命中节点是 Level 0 的下一个节点
     current = current->forward[0];
     if(current && current->key == key) {
-        // 命中：返回一个“有值”的 optional
-        return current->value;
+        // 命中：返回指向节点中值的指针，由调用者决定是否拷贝
+        return &current->value;
     }
-    // 未命中：返回一个“空”的 optional
-    return std::nullopt;
+    return nullptr;
 }
 
 template <typename K, typename V>
@@ -200,7 +333,9 @@ bool SkipList<K, V>::remove(K key){
      * 2) 在第 0 层确认目标节点是否存在；
      * 3) 逐层断链（把前驱的 forward 指向目标的后继）；
      * 4) 必要时收缩 current_level；
-     * 5) 从 nodes_storage 中擦除该节点以回收内存。
+     * 5) 把节点放入空闲链表，供之后的插入复用。
+     *
+     * 每一步都是 O(log n) 的，整体复杂度与 insert / search 相同。
      */
 
     // update[i] 记录第 i 层中“目标 key 的前驱节点”
@@ -237,12 +372,9 @@ bool SkipList<K, V>::remove(K key){
         --current_level;
     }
 
-    // 断链仅保证“逻辑不可达”；要回收内存，需要把对应节点从 nodes_storage 中擦除
-    for(auto it = nodes_storage.begin(); it != nodes_storage.end(); ++it) {
-        if(it->get() == target) {
-            nodes_storage.erase(it);
-            break;
-        }
-    }
+    // 断链后节点已不可达：尽早释放键值持有的资源，节点本身放入空闲链表
+    target->key = K();
+    target->value = V();
+    free_nodes[target->forward.size() - 1].push_back(target);
     return true;
 }
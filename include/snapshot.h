@@ -0,0 +1,80 @@
+#pragma once
+
+#include "dbformat.h"
+
+/**
+ * @file snapshot.h
+ * @brief 读快照：KVStore::get_snapshot() 返回的句柄与 KVStore 内部的快照列表
+ */
+
+/**
+ * @brief 一致性读快照：记录创建时已发布的序列号
+ *
+ * 通过 ReadOptions::snapshot 传给 get / new_iterator / scan 后，读请求只看到序列号不大于
+ * sequence() 的版本，即创建快照那一刻的数据；之后的写入、落盘与 Compaction 都不影响它。
+ * 快照存活期间 Compaction 保留它需要的旧版本，用完后必须调用 KVStore::release_snapshot()。
+ *
+ * 句柄由 KVStore 分配与释放，调用者不能自行构造或 delete。
+ */
+class Snapshot {
+public:
+    SequenceNumber sequence() const { return sequence_; }
+
+private:
+    friend class SnapshotList;
+
+    explicit Snapshot(SequenceNumber sequence) : sequence_(sequence) {}
+    ~Snapshot() = default;
+
+    SequenceNumber sequence_;
+    Snapshot* prev_ = nullptr;
+    Snapshot* next_ = nullptr;
+};
+
+/**
+ * @brief 存活快照的双向链表（按创建顺序，即序列号非降序）
+ *
+ * 新快照追加到表尾，释放时 O(1) 摘除；表头即最老的快照，Compaction 据此决定保留哪些旧版本。
+ *
+ * @note 非线程安全，由 KVStore 的 snapshots_mutex_ 保护。
+ */
+class SnapshotList {
+public:
+    SnapshotList() : head_(0) {
+        head_.prev_ = &head_;
+        head_.next_ = &head_;
+    }
+
+    ~SnapshotList() {
+        // 未释放的快照随 KVStore 一起回收
+        while (!empty()) Delete(head_.next_);
+    }
+
+    SnapshotList(const SnapshotList&) = delete;
+    SnapshotList& operator=(const SnapshotList&) = delete;
+
+    bool empty() const { return head_.next_ == &head_; }
+
+    /// 最老（序列号最小）的快照；列表为空时不应调用
+    const Snapshot* oldest() const { return head_.next_; }
+
+    /// 创建一个快照（sequence 不得小于表尾快照的序列号）
+    const Snapshot* New(SequenceNumber sequence) {
+        Snapshot* snapshot = new Snapshot(sequence);
+        snapshot->next_ = &head_;
+        snapshot->prev_ = head_.prev_;
+        snapshot->prev_->next_ = snapshot;
+        snapshot->next_->prev_ = snapshot;
+        return snapshot;
+    }
+
+    void Delete(const Snapshot* snapshot) {
+        Snapshot* s = const_cast<Snapshot*>(snapshot);
+        s->prev_->next_ = s->next_;
+        s->next_->prev_ = s->prev_;
+        delete s;
+    }
+
+private:
+    Snapshot head_;   ///< 哨兵
+};
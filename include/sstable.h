@@ -16,12 +16,34 @@ struct BlockHandle {
  * 从中获取 Index Block 的位置，进而加载索引，最后才能查找数据。
  */
 struct Footer {
-    // 指向 Metaindex Block (用于存储 Bloom Filter 等元数据，本周暂不实现，留空)
+    // 指向 Metaindex Block（size 为 0 表示没有元数据，如旧文件或未启用 Bloom Filter）
+    // Metaindex Entry 格式与 Index Entry 相同：| NameLen(4B) | Name | Offset(8B) | Size(8B) |
     BlockHandle metaindex_handle;
 
+    // Metaindex 中 Bloom Filter Block 的名字
+    static constexpr std::string_view kBloomFilterMetaKey = "filter.bloom";
+
     // 指向 Index Block (用于存储 Data Block 的索引)
     BlockHandle index_handle;
 
+    // 格式版本：编码在 metaindex_handle 的 4 字节填充区（Footer 偏移 16）
+    // - kFormatLegacy (0): 旧文件，Block 校验和为 CRC32 (IEEE)
+    // - kFormatCrc32c (1): Block 校验和为 CRC32C
+    // - kFormatPrefixBlocks (2): Data Block 使用前缀压缩 + 重启点（见 block.h）
+    //   版本 0 / 1 的 Data Block 为 | KeyLen(4B) | ValueLen(4B) | Key | Value | 的平铺格式
+    // - kFormatBlockTrailer (3): Block 尾部为 | CompressionType(1B) | CRC32C(4B) |，
+    //   CRC 覆盖内容与类型字节；更早的版本尾部只有 4 字节 CRC（隐含不压缩）
+    // - kFormatInternalKeys (4): Block 格式同版本 3，Key 为内部 Key | UserKey | Tag(8B) |
+    //   （见 dbformat.h），Bloom Filter 建立在 UserKey 上；由 TableOptions::internal_keys 选择
+    static constexpr uint32_t kFormatLegacy = 0;
+    static constexpr uint32_t kFormatCrc32c = 1;
+    static constexpr uint32_t kFormatPrefixBlocks = 2;
+    static constexpr uint32_t kFormatBlockTrailer = 3;
+    static constexpr uint32_t kFormatInternalKeys = 4;
+    static constexpr uint32_t kCurrentFormatVersion = kFormatInternalKeys;
+    static constexpr size_t kFormatVersionOffset = 16;
+    uint32_t format_version = kCurrentFormatVersion;
+
     // 魔数：用于校验文件是否为合法的 SSTable 文件
     // 0xdb4775248b80fb57 (Little Endian: 57 fb 80 8b 24 75 47 db)
     // 来源于 "DB" + 随机数，防止误读取非 SSTable 文件
@@ -1,13 +1,26 @@
 #pragma once
 
+#include "block.h"
+#include "bloom_filter.h"
+#include "compression.h"
+#include "dbformat.h"     // extract_user_key
+#include "options.h"      // TableOptions
 #include "sstable.h"      // BlockHandle, Footer
-#include "wal_record.h"   // crc32 函数
+#include "wal_record.h"   // crc32c 函数
 
 #include <cstdint>
 #include <cstdio>
 #include <cstring>        // memset, memcpy
 #include <stdexcept>      // runtime_error
 #include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 /**
  * @brief SSTable 文件构造器
@@ -17,12 +30,17 @@
  * 核心流程：
  * 1. 用户调用 Add(key, value) 追加 KV 对
  * 2. 当缓冲区达到 4KB 时，自动写入一个 Data Block
- * 3. 用户调用 Finish() 完成构建，写入 Index Block 和 Footer
+ * 3. 用户调用 Finish() 完成构建，写入 Filter Block、Metaindex Block、Index Block 和 Footer
  *
  * 文件布局：
- * +----------------+----------------+-----+-------------+--------+
- * | Data Block 1   | Data Block 2   | ... | Index Block | Footer |
- * +----------------+----------------+-----+-------------+--------+
+ * +--------------+-----+--------------+-----------------+-------------+--------+
+ * | Data Block 1 | ... | Filter Block | Metaindex Block | Index Block | Footer |
+ * +--------------+-----+--------------+-----------------+-------------+--------+
+ *
+ * Filter Block 与 Metaindex Block 仅在启用 Bloom Filter 时存在。
+ *
+ * 每个 Block 之后是 5 字节尾部：| CompressionType(1B) | CRC32C(4B) |。
+ * 只有 Data Block 会按 TableOptions::compression 压缩，其余 Block 类型字节恒为 kNone。
  *
  * @note 本类非线程安全，需在单线程环境下使用。
  * @note 调用者必须保证 Add() 传入的 key 是有序的（升序）。
@@ -33,12 +51,15 @@ public:
      * @brief 构造函数：打开输出文件并初始化内部状态
      *
      * @param filepath 输出 SSTable 文件的完整路径（如 "./data/L0_001.sst"）
+     * @param options 构建选项（Bloom Filter 位数等）
      * @throw std::runtime_error 如果文件无法创建
      */
-    explicit SSTableBuilder(const std::string& filepath)
-        : file_(nullptr)
+    explicit SSTableBuilder(const std::string& filepath, const TableOptions& options = {})
+        : options_(options)
+        , file_(nullptr)
         , offset_(0)
         , finished_(false)
+        , data_block_(options.block_restart_interval)
         , current_block_handle_{0, 0} {
         file_ = fopen(filepath.c_str(), "wb");
         if (file_ == nullptr) {
@@ -57,8 +78,11 @@ public:
             if (!finished_) {
                 try { Finish(); } catch (...) {}
             }
-            std::fclose(file_);
-            file_ = nullptr;
+            // Finish() 成功时已关闭文件并把 file_ 置空，这里只处理未完成的情况
+            if (file_) {
+                std::fclose(file_);
+                file_ = nullptr;
+            }
         }
     }
 
@@ -68,29 +92,21 @@ public:
     /**
      * @brief 添加一个键值对到 SSTable
      *
-     * 将 KV 对编码后追加到当前 Data Block 缓冲区。
-     * 当缓冲区大小达到 4KB 时，自动触发 WriteBlock()。
+     * 将 KV 对追加到当前 Data Block（前缀压缩 + 重启点，格式见 block.h）。
+     * 当 Block 预估大小达到 4KB 时，自动触发 WriteBlock()。
      *
-     * Entry 编码格式：
-     * +------------+--------------+-----------+-------------+
-     * | KeyLen(4B) | ValueLen(4B) | Key Bytes | Value Bytes |
-     * +------------+--------------+-----------+-------------+
-     *
-     * @param key 键（必须按升序添加）
+     * @param key 键（必须按升序添加；internal_keys 时为内部 Key，过滤器只使用其中的 UserKey）
      * @param value 值
      */
-    void Add(const std::string& key, const std::string& value) {
-        uint32_t key_len = static_cast<uint32_t>(key.size());
-        uint32_t value_len = static_cast<uint32_t>(value.size());
-
-        AppendUint32(data_block_buffer_, key_len);
-        AppendUint32(data_block_buffer_, value_len);
-        data_block_buffer_.append(key);
-        data_block_buffer_.append(value);
+    void Add(std::string_view key, std::string_view value) {
+        data_block_.Add(key, value);
 
-        last_key_ = key;
+        last_key_.assign(key.data(), key.size());
+        if (options_.bloom_bits_per_key > 0) {
+            key_hashes_.push_back(BloomFilter::Hash(options_.internal_keys ? extract_user_key(key) : key));
+        }
 
-        if (data_block_buffer_.size() >= kBlockSize) {
+        if (data_block_.CurrentSizeEstimate() >= kBlockSize) {
             WriteBlock();
         }
     }
@@ -100,9 +116,11 @@ public:
      *
      * 执行以下步骤：
      * 1. 如果缓冲区还有数据，写入最后一个 Data Block
-     * 2. 写入 Index Block（包含所有 Block 的索引信息）
-     * 3. 写入 Footer（固定 48 字节，包含 Index Block 位置和魔数）
-     * 4. 关闭文件
+     * 2. 写入 Filter Block 与 Metaindex Block（启用 Bloom Filter 且表非空时）
+     * 3. 写入 Index Block（包含所有 Block 的索引信息）
+     * 4. 写入 Footer（固定 48 字节，包含 Metaindex / Index Block 位置和魔数）
+     * 5. fflush + fsync，保证返回后文件内容已落盘（KVStore 随后会重命名并删除 WAL 段）
+     * 6. 关闭文件
      *
      * @throw std::runtime_error 如果写入失败或重复调用
      */
@@ -111,44 +129,71 @@ public:
             throw std::runtime_error("Finish() called twice");
         }
 
-        if (!data_block_buffer_.empty()) {
+        if (!data_block_.empty()) {
             WriteBlock();
         }
 
+        BlockHandle metaindex_handle;
+        if (!key_hashes_.empty()) {
+            std::string filter = BloomFilter::Create(key_hashes_, options_.bloom_bits_per_key);
+            BlockHandle filter_handle = WriteRawBlock(filter);
+
+            std::string metaindex;
+            AppendUint32(metaindex, static_cast<uint32_t>(Footer::kBloomFilterMetaKey.size()));
+            metaindex.append(Footer::kBloomFilterMetaKey);
+            AppendUint64(metaindex, filter_handle.offset);
+            AppendUint64(metaindex, filter_handle.size);
+            metaindex_handle = WriteRawBlock(metaindex);
+        }
+
         BlockHandle index_handle;
         if (!index_block_buffer_.empty()) {
-            uint32_t crc = crc32(index_block_buffer_.data(), index_block_buffer_.size());
-            AppendUint32(index_block_buffer_, crc);
-
-            index_handle.offset = offset_;
-            index_handle.size = index_block_buffer_.size();
-
-            std::fwrite(index_block_buffer_.data(), 1, index_block_buffer_.size(), file_);
-            offset_ += index_block_buffer_.size();
+            index_handle = WriteRawBlock(index_block_buffer_);
         }
 
-        WriteFooter(index_handle);
+        WriteFooter(metaindex_handle, index_handle);
 
         finished_ = true;
+        bool synced = std::fflush(file_) == 0;
+#ifdef _WIN32
+        synced = synced && _commit(_fileno(file_)) == 0;
+#else
+        synced = synced && fsync(fileno(file_)) == 0;
+#endif
         std::fclose(file_);
         file_ = nullptr;
+        if (!synced) {
+            throw std::runtime_error("Failed to sync SSTable file");
+        }
     }
 
     uint64_t FileSize() const { return offset_; }
     bool Finished() const { return finished_; }
 
+    /// 以压缩形式写入的 Data Block 数量
+    uint64_t NumCompressedBlocks() const { return compressed_blocks_; }
+
+    /// 所有 Data Block 压缩前的总字节数（不含尾部）
+    uint64_t RawDataBytes() const { return raw_data_bytes_; }
+
 private:
     static constexpr size_t kBlockSize = 4096;
     static constexpr size_t kFooterSize = 48;
+    static constexpr size_t kBlockTrailerSize = 5;
 
+    TableOptions options_;
     FILE* file_;
     uint64_t offset_;
     bool finished_;
 
-    std::string data_block_buffer_;
+    BlockBuilder data_block_;
     std::string index_block_buffer_;
     std::string last_key_;
     BlockHandle current_block_handle_;
+    std::vector<uint32_t> key_hashes_;  ///< 所有 Key 的哈希，Finish 时构建 Bloom Filter
+    std::string compressed_;            ///< 压缩输出缓冲区（跨 Block 复用）
+    uint64_t compressed_blocks_ = 0;
+    uint64_t raw_data_bytes_ = 0;
 
     /**
      * @brief 追加 uint32_t 到缓冲区（小端序）
@@ -168,14 +213,15 @@ private:
     }
 
     /**
-     * @brief 将当前缓冲区内容写入文件作为一个 Data Block
+     * @brief 将当前 Data Block 写入文件
      *
      * 核心步骤：
-     * 1. 计算 CRC32 校验和并追加到缓冲区末尾
-     * 2. 将整个 Block 写入文件
-     * 3. 记录 BlockHandle（offset, size）
-     * 4. 在 Index Block 缓冲区中追加一条索引记录
-     * 5. 清空 Data Block 缓冲区
+     * 1. 追加重启点数组，完成 Block 编码
+     * 2. 按 options_.compression 尝试压缩；节省不到 1/8 时放弃，写入原始内容
+     * 3. 将 Block 与其尾部（类型 + CRC32C）写入文件
+     * 4. 记录 BlockHandle（offset, size）
+     * 5. 在 Index Block 缓冲区中追加一条索引记录
+     * 6. 重置 Data Block 构建器
      *
      * Index Entry 格式：
      * +------------+-----------+-------------+-------------+
@@ -183,26 +229,49 @@ private:
      * +------------+-----------+-------------+-------------+
      */
     void WriteBlock() {
-        if (data_block_buffer_.empty()) return;
-
-        uint32_t crc = crc32(data_block_buffer_.data(), data_block_buffer_.size());
-        AppendUint32(data_block_buffer_, crc);
-
-        size_t block_size = data_block_buffer_.size();
-        if (std::fwrite(data_block_buffer_.data(), 1, block_size, file_) != block_size) {
-            throw std::runtime_error("Failed to write Data Block");
+        if (data_block_.empty()) return;
+
+        const std::string& raw = data_block_.Finish();
+        raw_data_bytes_ += raw.size();
+        if (compress_block(options_.compression, options_.zstd_level, raw, &compressed_) &&
+            compressed_.size() < raw.size() - raw.size() / 8) {
+            current_block_handle_ = WriteRawBlock(compressed_, options_.compression);
+            compressed_blocks_ += 1;
+        } else {
+            current_block_handle_ = WriteRawBlock(raw);
         }
 
-        current_block_handle_.offset = offset_;
-        current_block_handle_.size = block_size;
-        offset_ += block_size;
-
         AppendUint32(index_block_buffer_, static_cast<uint32_t>(last_key_.size()));
         index_block_buffer_.append(last_key_);
         AppendUint64(index_block_buffer_, current_block_handle_.offset);
         AppendUint64(index_block_buffer_, current_block_handle_.size);
 
-        data_block_buffer_.clear();
+        data_block_.Reset();
+    }
+
+    /**
+     * @brief 写入一个 Block 及其 5 字节尾部
+     *
+     * 尾部格式：| CompressionType(1B) | CRC32C(4B) |，CRC 覆盖 contents 与类型字节，
+     * 因此类型字节损坏同样能被发现。
+     *
+     * @param contents Block 内容（压缩时为压缩后的负载）
+     * @param type contents 的压缩类型
+     * @return 该 Block 的位置（size 含尾部）
+     */
+    BlockHandle WriteRawBlock(std::string_view contents,
+                              CompressionType type = CompressionType::kNone) {
+        char trailer[kBlockTrailerSize];
+        trailer[0] = static_cast<char>(type);
+        uint32_t crc = crc32c(contents.data(), contents.size());
+        encode_fixed32(trailer + 1, crc32c_extend(crc, trailer, 1));
+        if (std::fwrite(contents.data(), 1, contents.size(), file_) != contents.size() ||
+            std::fwrite(trailer, 1, sizeof(trailer), file_) != sizeof(trailer)) {
+            throw std::runtime_error("Failed to write block");
+        }
+        BlockHandle handle{offset_, contents.size() + sizeof(trailer)};
+        offset_ += handle.size;
+        return handle;
     }
 
     /**
@@ -218,12 +287,21 @@ private:
      * - size: 8 字节
      * - padding: 4 字节（填充）
      *
+     * metaindex_handle 的填充区用于存放格式版本号 (Footer::format_version)，
+     * 读取端据此选择 Block 校验算法与尾部格式（旧文件为 0，即 CRC32）。
+     *
      * Magic Number 用于校验文件是否为合法的 SSTable。
      */
-    void WriteFooter(const BlockHandle& index_handle) {
+    void WriteFooter(const BlockHandle& metaindex_handle, const BlockHandle& index_handle) {
         char footer_buf[kFooterSize];
         std::memset(footer_buf, 0, kFooterSize);
 
+        std::memcpy(footer_buf, &metaindex_handle.offset, sizeof(uint64_t));
+        std::memcpy(footer_buf + 8, &metaindex_handle.size, sizeof(uint64_t));
+
+        uint32_t version = options_.internal_keys ? Footer::kFormatInternalKeys : Footer::kFormatBlockTrailer;
+        std::memcpy(footer_buf + Footer::kFormatVersionOffset, &version, sizeof(uint32_t));
+
         std::memcpy(footer_buf + 20, &index_handle.offset, sizeof(uint64_t));
         std::memcpy(footer_buf + 28, &index_handle.size, sizeof(uint64_t));
 
@@ -0,0 +1,926 @@
+#pragma once
+#define _CRT_SECURE_NO_WARNINGS // 禁用 fopen 等不安全警告
+
+#include "block.h"
+#include "block_cache.h"
+#include "bloom_filter.h"
+#include "coding.h"
+#include "compression.h"
+#include "dbformat.h"
+#include "mapped_file.h"
+#include "options.h"      // TableOptions
+#include "pinnable_value.h"
+#include "sstable.h"      // BlockHandle, Footer
+#include "statistics.h"
+#include "wal_record.h"   // crc32 / crc32c 函数
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+/**
+ * @brief SSTable 文件读取器
+ *
+ * 与 SSTableBuilder 对应，负责把磁盘上的 SSTable 读回来并提供点查 (Get)。
+ *
+ * 打开流程（构造函数中一次完成）：
+ * 1. 读取文件末尾 48 字节的 Footer，校验 Magic Number 与格式版本。
+ * 2. 若 Footer 中有 Metaindex Block，从中找到 Bloom Filter Block 并加载。
+ * 3. 按 Footer 中的 index_handle 读出 Index Block，校验 CRC 后解析为内存数组。
+ *    Index 中每一项是某个 Data Block 的 **最后一个 Key** 及其 BlockHandle。
+ *
+ * 点查流程：
+ * 0. 先查 Bloom Filter：判定不存在则直接返回，不产生任何磁盘 I/O。
+ * 1. 在 Index 数组上二分查找第一个 last_key >= key 的 Data Block
+ *    （只有这个 Block 可能包含 key）。
+ * 2. 先查块缓存；未命中时读出该 Block（一次 pread），校验 CRC、按需解压后放入缓存，
+ *    因此缓存中保存的是解压后的内容，重复命中不再付出解压代价。
+ * 3. 在 Block 内查找：格式版本 >= 2 的前缀压缩 Block 先二分查找重启点，再解码一小段；
+ *    旧版本的平铺 Block 从头顺序扫描。
+ *
+ * Index / Filter Block 的归属由 TableOptions 决定：
+ * - 默认常驻在 Reader 中（不计入缓存容量）；
+ * - cache_index_and_filter_blocks = true 时放入共享缓存，可选择固定或参与 LRU 淘汰。
+ *
+ * use_mmap_reads 时整张表被只读映射：未压缩的 Data Block 直接在映射上解析（不拷贝、不进缓存），
+ * 其余 Block 的读取也从映射中取数据；映射失败时退回 pread。
+ *
+ * Key 按 options.comparator 比较，必须与构建该表时 Key 的写入顺序一致。
+ * 格式版本 kFormatInternalKeys 的表中 Key 为内部 Key，改按 InternalKeyComparator(options.comparator)
+ * 比较（由 Footer 自动识别），Bloom Filter 按其中的 UserKey 查询。
+ *
+ * @note Get 是线程安全的：POSIX 下使用 pread（不共享文件偏移），
+ *       Windows 下以互斥锁保护 seek + read。
+ */
+class SSTableReader {
+public:
+    /// Index Block 中的一项：一个 Data Block 的最后一个 Key 及其位置
+    struct IndexEntry {
+        std::string last_key;
+        BlockHandle handle;
+    };
+
+    /// 一个 Data Block 的内容及其持有者（块缓存中的字符串或整个文件映射），owner 为空表示没有 Block
+    struct BlockContents {
+        std::string_view data;
+        std::shared_ptr<const void> owner;
+    };
+
+    /**
+     * @brief 打开 SSTable 文件并加载 Index Block
+     *
+     * @param filepath SSTable 文件路径
+     * @param options 读取选项（块缓存、Index / Filter Block 的缓存策略）
+     * @throw std::runtime_error 文件无法打开、Footer 非法、格式版本不支持或 Index Block 损坏
+     */
+    explicit SSTableReader(const std::string& filepath, const TableOptions& options = {})
+        : filepath_(filepath)
+        , comparator_(options.comparator)
+        , internal_comparator_(options.comparator)
+        , cache_(options.block_cache)
+        , cache_meta_blocks_(options.block_cache && options.cache_index_and_filter_blocks)
+        , pin_meta_blocks_(options.pin_index_and_filter_blocks) {
+        if (cache_) {
+            cache_id_ = cache_->NewId();
+        }
+        std::error_code ec;
+        file_size_ = std::filesystem::file_size(filepath, ec);
+        if (ec) {
+            throw std::runtime_error("Failed to stat SSTable file: " + filepath);
+        }
+        if (file_size_ < Footer::kEncodedLength) {
+            throw std::runtime_error("SSTable file too short: " + filepath);
+        }
+
+        file_ = std::fopen(filepath.c_str(), "rb");
+        if (file_ == nullptr) {
+            throw std::runtime_error("Failed to open SSTable file: " + filepath);
+        }
+
+        if (options.use_mmap_reads) {
+            mapped_ = MappedFile::Open(filepath, file_size_);
+        }
+
+        try {
+            ReadFooter();
+            if (HasInternalKeys()) comparator_ = &internal_comparator_;
+            ReadMetaindexBlock();
+            AdviseMapping();
+            ReadIndexBlock();
+            if (mapped_) {
+                verified_blocks_ = NumBlocks();
+                verified_ = std::make_unique<std::atomic<uint64_t>[]>((verified_blocks_ + 63) / 64);
+            }
+        } catch (...) {
+            std::fclose(file_);
+            file_ = nullptr;
+            throw;
+        }
+    }
+
+    ~SSTableReader() {
+        if (cache_meta_blocks_ && pin_meta_blocks_) {
+            // 解除固定：Reader 关闭后这些 Block 不再有用
+            if (footer_.index_handle.size > 0) cache_->Erase(cache_id_, footer_.index_handle.offset);
+            if (filter_handle_.size > 0) cache_->Erase(cache_id_, filter_handle_.offset);
+        }
+        if (file_) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+        if (delete_on_close_.load(std::memory_order_acquire)) {
+            std::error_code ec;
+            std::filesystem::remove(filepath_, ec);
+        }
+    }
+
+    SSTableReader(const SSTableReader&) = delete;
+    SSTableReader& operator=(const SSTableReader&) = delete;
+
+    /**
+     * @brief 点查一个 Key
+     *
+     * @param key 待查找的 Key
+     * @param value [out] 找到时填入 Value
+     * @return true 找到；false 表中不存在该 Key
+     * @throw std::runtime_error Data Block 读取失败或 CRC 校验失败
+     */
+    bool Get(std::string_view key, std::string* value) const {
+        PinnableValue pinned;
+        if (!Get(key, &pinned)) return false;
+        value->assign(pinned.data(), pinned.size());
+        return true;
+    }
+
+    /**
+     * @brief 点查一个 Key（零拷贝；内部 Key 格式的表中 key 为完整的内部 Key）
+     *
+     * value 直接指向（块缓存中的）Data Block 并钉住该 Block：即使 Block 随后被缓存淘汰，
+     * 在 value 释放之前内存依然有效。
+     *
+     * @throw std::runtime_error Data Block 读取失败或 CRC 校验失败
+     */
+    bool Get(std::string_view key, PinnableValue* value) const {
+        if (!KeyMayMatch(HasInternalKeys() ? extract_user_key(key) : key)) {
+            filter_skips_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return SearchBlocks(key, value);
+    }
+
+    /**
+     * @brief 查询 user_key 在快照 snapshot 中可见的最新版本（KVStore 的读路径）
+     *
+     * - 内部 Key 格式：查找第一个 >= (user_key, snapshot) 的内部 Key，UserKey 相同即命中，
+     *   类型取自 Tag；
+     * - 更早的格式：Key 即 UserKey，视为序列号 0 的唯一版本，类型取自 Value 的首字节。
+     *
+     * @param type [out] 命中时的条目类型
+     * @param value [out] 命中值（或 BlobIndex）时指向 Data Block 中的值（不含类型字节），并钉住该 Block
+     * @param stats 非空时记录 Bloom Filter 的判定结果（kBloomUseful / kBloomPositive / kBloomTruePositive）
+     * @return true 命中（值或删除标记）；false 表中没有快照可见的版本
+     * @throw std::runtime_error Data Block 读取失败、CRC 校验失败或条目损坏
+     */
+    bool GetVisible(std::string_view user_key, SequenceNumber snapshot, ValueType* type,
+                    PinnableValue* value, Statistics* stats = nullptr) const {
+        // 两种格式的过滤器都建立在 UserKey 上
+        if (!KeyMayMatch(user_key)) {
+            filter_skips_.fetch_add(1, std::memory_order_relaxed);
+            RecordTick(stats, Ticker::kBloomUseful);
+            return false;
+        }
+        bool hit = HasInternalKeys() ? GetVisibleInternal(user_key, snapshot, type, value)
+                                     : GetVisibleLegacy(user_key, type, value);
+        if (HasFilter()) {
+            RecordTick(stats, Ticker::kBloomPositive);
+            if (hit) RecordTick(stats, Ticker::kBloomTruePositive);
+        }
+        return hit;
+    }
+
+    /**
+     * @brief 仅查询 Bloom Filter（无磁盘 I/O）
+     *
+     * @return false 表示 key 一定不在表中；没有过滤器时恒为 true
+     */
+    bool KeyMayMatch(std::string_view key) const {
+        if (filter_handle_.size == 0) return true;
+        return BloomFilter::KeyMayMatch(key, *Filter());
+    }
+
+    /// 是否带有 Bloom Filter
+    bool HasFilter() const { return filter_handle_.size > 0; }
+
+    /// Get 因 Bloom Filter 判定不存在而直接返回的次数
+    uint64_t FilterSkips() const { return filter_skips_.load(std::memory_order_relaxed); }
+
+    /// 文件路径
+    const std::string& FilePath() const { return filepath_; }
+
+    /// 文件大小（字节）
+    uint64_t FileSize() const { return file_size_; }
+
+    /// Footer 中记录的格式版本
+    uint32_t FormatVersion() const { return footer_.format_version; }
+
+    /// 表中的 Key 是否为内部 Key（格式版本 kFormatInternalKeys）
+    bool HasInternalKeys() const { return footer_.format_version >= Footer::kFormatInternalKeys; }
+
+    /// Data Block 数量
+    size_t NumBlocks() const { return Index()->size(); }
+
+    /// 内存映射的字节数（未使用 mmap 读取时为 0）
+    uint64_t MappedBytes() const { return mapped_ ? mapped_->size() : 0; }
+
+    /// 映射中当前驻留在 Page Cache 中的字节数（未使用 mmap 读取时为 0）
+    uint64_t ResidentBytes() const { return mapped_ ? mapped_->ResidentBytes() : 0; }
+
+    /**
+     * @brief Reader 析构（最后一个引用释放）时删除文件
+     *
+     * Compaction 淘汰的表可能仍被并发的读请求引用；推迟到关闭文件之后再删除，
+     * 既不会读到已删除的文件，也兼容 Windows 上不能删除已打开文件的限制。
+     */
+    void DeleteFileOnClose() { delete_on_close_.store(true, std::memory_order_release); }
+
+    /**
+     * @brief Index（按 last_key 升序）
+     *
+     * Index 由 Reader 持有或已固定在缓存中时直接返回；
+     * 未固定且已被淘汰时重新从磁盘读取、解析并放回缓存。
+     */
+    std::shared_ptr<const std::vector<IndexEntry>> Index() const {
+        if (index_) return index_;
+        if (auto cached = cache_->Lookup(cache_id_, footer_.index_handle.offset)) {
+            return std::static_pointer_cast<const std::vector<IndexEntry>>(cached);
+        }
+        auto index = LoadIndexBlock();
+        cache_->Insert(cache_id_, footer_.index_handle.offset, index, IndexCharge(*index));
+        return index;
+    }
+
+    /**
+     * @brief 按 Key 顺序遍历整张表的双向迭代器（Compaction 与范围扫描的输入）
+     *
+     * 逐个加载 Data Block，Block 内使用 Block::Iterator（格式版本 >= 2）或按平铺格式解码
+     * （版本 0 / 1）。迭代器持有 Index 与当前 Block 的引用，Reader 必须比迭代器活得久。
+     * key() / value() 指向当前 Block，在迭代器移动之前有效。
+     *
+     * @throw std::runtime_error Block 读取、校验失败或内容损坏
+     */
+    class Iterator {
+    public:
+        /**
+         * @param table 被遍历的表
+         * @param fill_cache 读到的 Data Block 是否放入块缓存
+         */
+        explicit Iterator(const SSTableReader& table, bool fill_cache = true)
+            : table_(table), index_(table.Index()), fill_cache_(fill_cache) {}
+
+        bool Valid() const { return valid_; }
+        std::string_view key() const { return key_; }
+        std::string_view value() const { return value_; }
+
+        void SeekToFirst() {
+            block_index_ = 0;
+            LoadBlock();
+            if (block_.owner) block_iter_->SeekToFirst();
+            SkipEmptyBlocks();
+        }
+
+        /// 定位到第一个 key >= target 的 Entry
+        void Seek(std::string_view target) {
+            const Comparator* cmp = table_.comparator_;
+            auto it = std::lower_bound(index_->begin(), index_->end(), target,
+                                       [cmp](const IndexEntry& entry, std::string_view k) {
+                                           return cmp->Compare(entry.last_key, k) < 0;
+                                       });
+            block_index_ = static_cast<size_t>(it - index_->begin());
+            LoadBlock();
+            if (block_.owner) block_iter_->Seek(target);
+            SkipEmptyBlocks();
+        }
+
+        void Next() {
+            if (!valid_) return;
+            block_iter_->Next();
+            SkipEmptyBlocks();
+        }
+
+        /// 定位到表中最后一个 Entry
+        void SeekToLast() {
+            if (index_->empty()) {
+                block_index_ = 0;
+                LoadBlock();
+                valid_ = false;
+                return;
+            }
+            block_index_ = index_->size() - 1;
+            LoadBlock();
+            block_iter_->SeekToLast();
+            SkipEmptyBlocksBackward();
+        }
+
+        void Prev() {
+            if (!valid_) return;
+            block_iter_->Prev();
+            SkipEmptyBlocksBackward();
+        }
+
+    private:
+        /**
+         * @brief 版本 0 / 1 平铺 Block 的顺序游标（接口与 Block::Iterator 一致）
+         */
+        class FlatBlockIterator {
+        public:
+            FlatBlockIterator(std::string_view data, const Comparator* cmp)
+                : data_(data), cmp_(cmp) {}
+            bool Valid() const { return valid_; }
+            bool corrupted() const { return corrupted_; }
+            std::string_view key() const { return key_; }
+            std::string_view value() const { return value_; }
+            void SeekToFirst() { next_ = 0; ParseNext(); }
+            void Next() { if (valid_) ParseNext(); }
+            void Seek(std::string_view target) {
+                SeekToFirst();
+                while (valid_ && cmp_->Compare(key_, target) < 0) ParseNext();
+            }
+            /// 平铺格式没有重启点，只能从头顺序解码（仅用于旧格式文件）
+            void SeekToLast() {
+                SeekToFirst();
+                while (valid_ && next_ < data_.size()) ParseNext();
+            }
+            void Prev() {
+                if (!valid_) return;
+                const size_t original = current_;
+                SeekToFirst();
+                if (current_ >= original) {
+                    valid_ = false;
+                    return;
+                }
+                while (valid_ && next_ < original) ParseNext();
+            }
+
+        private:
+            std::string_view data_;
+            const Comparator* cmp_;
+            size_t current_ = 0;
+            size_t next_ = 0;
+            std::string_view key_;
+            std::string_view value_;
+            bool valid_ = false;
+            bool corrupted_ = false;
+
+            void ParseNext() {
+                valid_ = false;
+                current_ = next_;
+                if (next_ >= data_.size()) return;
+                if (data_.size() - next_ < 8) { corrupted_ = true; return; }
+                uint32_t key_len = decode_fixed32(data_.data() + next_);
+                uint32_t value_len = decode_fixed32(data_.data() + next_ + 4);
+                size_t pos = next_ + 8;
+                if (data_.size() - pos < static_cast<uint64_t>(key_len) + value_len) {
+                    corrupted_ = true;
+                    return;
+                }
+                key_ = data_.substr(pos, key_len);
+                value_ = data_.substr(pos + key_len, value_len);
+                next_ = pos + key_len + value_len;
+                valid_ = true;
+            }
+        };
+
+        /// 统一两种 Block 格式的游标
+        class BlockCursor {
+        public:
+            BlockCursor(std::string_view data, bool prefix, const Comparator* cmp)
+                : block_(data, cmp), prefix_(prefix), prefix_iter_(block_), flat_iter_(data, cmp) {}
+            bool Valid() const { return prefix_ ? prefix_iter_.Valid() : flat_iter_.Valid(); }
+            bool corrupted() const {
+                return prefix_ ? prefix_iter_.corrupted() : flat_iter_.corrupted();
+            }
+            std::string_view key() const { return prefix_ ? prefix_iter_.key() : flat_iter_.key(); }
+            std::string_view value() const {
+                return prefix_ ? prefix_iter_.value() : flat_iter_.value();
+            }
+            void SeekToFirst() { prefix_ ? prefix_iter_.SeekToFirst() : flat_iter_.SeekToFirst(); }
+            void Next() { prefix_ ? prefix_iter_.Next() : flat_iter_.Next(); }
+            void Seek(std::string_view t) { prefix_ ? prefix_iter_.Seek(t) : flat_iter_.Seek(t); }
+            void SeekToLast() { prefix_ ? prefix_iter_.SeekToLast() : flat_iter_.SeekToLast(); }
+            void Prev() { prefix_ ? prefix_iter_.Prev() : flat_iter_.Prev(); }
+
+        private:
+            Block block_;
+            bool prefix_;
+            Block::Iterator prefix_iter_;   ///< 引用 block_，因此 BlockCursor 不可移动
+            FlatBlockIterator flat_iter_;
+        };
+
+        const SSTableReader& table_;
+        std::shared_ptr<const std::vector<IndexEntry>> index_;
+        bool fill_cache_;
+        size_t block_index_ = 0;
+        BlockContents block_;                        ///< 当前 Block 内容（保证 block_iter_ 有效）
+        std::unique_ptr<BlockCursor> block_iter_;
+        std::string_view key_;
+        std::string_view value_;
+        bool valid_ = false;
+
+        /// 加载 block_index_ 指向的 Block；越过最后一个 Block 时 block_.owner 为空
+        void LoadBlock() {
+            block_iter_.reset();
+            block_ = {};
+            if (block_index_ >= index_->size()) return;
+            block_ = table_.DataBlock(block_index_, (*index_)[block_index_].handle, fill_cache_);
+            block_iter_ = std::make_unique<BlockCursor>(
+                block_.data, table_.footer_.format_version >= Footer::kFormatPrefixBlocks,
+                table_.comparator_);
+        }
+
+        /// 当前 Block 耗尽时前进到下一个 Block；同时检查损坏并更新 key_ / value_
+        void SkipEmptyBlocks() {
+            while (block_.owner) {
+                if (block_iter_->corrupted()) {
+                    throw std::runtime_error("Malformed data block in SSTable: " +
+                                             table_.filepath_);
+                }
+                if (block_iter_->Valid()) {
+                    key_ = block_iter_->key();
+                    value_ = block_iter_->value();
+                    valid_ = true;
+                    return;
+                }
+                ++block_index_;
+                LoadBlock();
+                if (block_.owner) block_iter_->SeekToFirst();
+            }
+            valid_ = false;
+        }
+
+        /// 当前 Block 耗尽时后退到上一个 Block 的最后一个 Entry
+        void SkipEmptyBlocksBackward() {
+            while (block_.owner) {
+                if (block_iter_->corrupted()) {
+                    throw std::runtime_error("Malformed data block in SSTable: " +
+                                             table_.filepath_);
+                }
+                if (block_iter_->Valid()) {
+                    key_ = block_iter_->key();
+                    value_ = block_iter_->value();
+                    valid_ = true;
+                    return;
+                }
+                if (block_index_ == 0) {
+                    block_iter_.reset();
+                    block_ = {};
+                    break;
+                }
+                --block_index_;
+                LoadBlock();
+                block_iter_->SeekToLast();
+            }
+            valid_ = false;
+        }
+    };
+
+private:
+    /// Get 的 Index / Data Block 查找部分（已通过 Bloom Filter）
+    bool SearchBlocks(std::string_view key, PinnableValue* value) const {
+        // 二分查找：第一个 last_key >= key 的 Block
+        std::shared_ptr<const std::vector<IndexEntry>> index = Index();
+        auto it = std::lower_bound(index->begin(), index->end(), key,
+                                   [this](const IndexEntry& entry, std::string_view k) {
+                                       return comparator_->Compare(entry.last_key, k) < 0;
+                                   });
+        if (it == index->end()) {
+            return false;  // key 比表中最大的 Key 还大
+        }
+
+        BlockContents block = DataBlock(static_cast<size_t>(it - index->begin()), it->handle);
+        std::string_view found;
+        if (footer_.format_version < Footer::kFormatPrefixBlocks) {
+            if (!SearchLegacyBlock(block.data, key, &found)) return false;
+        } else {
+            bool corrupted = false;
+            bool hit = Block(block.data, comparator_).Get(key, &found, &corrupted);
+            if (corrupted) {
+                throw std::runtime_error("Malformed data block in SSTable: " + filepath_);
+            }
+            if (!hit) return false;
+        }
+        value->pin(found, std::move(block.owner));
+        return true;
+    }
+
+    /// GetVisible 在内部 Key 格式的表中查找（已通过 Bloom Filter）
+    bool GetVisibleInternal(std::string_view user_key, SequenceNumber snapshot, ValueType* type,
+                            PinnableValue* value) const {
+        std::string lookup = make_internal_key(user_key, snapshot, ValueType::kValue);
+        std::shared_ptr<const std::vector<IndexEntry>> index = Index();
+        auto it = std::lower_bound(index->begin(), index->end(), lookup,
+                                   [this](const IndexEntry& entry, std::string_view k) {
+                                       return comparator_->Compare(entry.last_key, k) < 0;
+                                   });
+        if (it == index->end()) return false;
+
+        BlockContents block = DataBlock(static_cast<size_t>(it - index->begin()), it->handle);
+        Block contents(block.data, comparator_);
+        Block::Iterator iter(contents);
+        iter.Seek(lookup);
+        if (iter.corrupted()) {
+            throw std::runtime_error("Malformed data block in SSTable: " + filepath_);
+        }
+        ParsedInternalKey parsed;
+        if (!iter.Valid()) return false;
+        if (!parse_internal_key(iter.key(), &parsed)) {
+            throw std::runtime_error("Malformed internal key in SSTable: " + filepath_);
+        }
+        if (internal_comparator_.user_comparator()->Compare(parsed.user_key, user_key) != 0) return false;
+        *type = parsed.type;
+        if (parsed.type != ValueType::kDeletion) value->pin(iter.value(), std::move(block.owner));
+        return true;
+    }
+
+    /// GetVisible 在更早格式的表中查找（已通过 Bloom Filter）：类型取自 Value 的首字节
+    bool GetVisibleLegacy(std::string_view key, ValueType* type, PinnableValue* value) const {
+        if (!SearchBlocks(key, value)) return false;
+        std::string_view decoded;
+        if (!decode_table_value(value->view(), type, &decoded)) {
+            throw std::runtime_error("Malformed value in SSTable: " + filepath_);
+        }
+        value->remove_prefix(value->size() - decoded.size());
+        return true;
+    }
+
+    std::string filepath_;
+    const Comparator* comparator_;                 ///< 表中 Key 的比较器（内部 Key 格式时指向 internal_comparator_）
+    InternalKeyComparator internal_comparator_;
+    FILE* file_ = nullptr;
+    uint64_t file_size_ = 0;
+    Footer footer_;
+    BlockHandle filter_handle_;                    ///< size 为 0 表示没有过滤器
+
+    std::shared_ptr<BlockCache> cache_;            ///< 共享块缓存（可为空）
+    uint64_t cache_id_ = 0;                        ///< 本文件在缓存中的 ID
+    bool cache_meta_blocks_ = false;               ///< Index / Filter Block 放入缓存
+    bool pin_meta_blocks_ = true;                  ///< 放入缓存时是否固定
+
+    /// Reader 持有的 Index / Filter（放入缓存且未固定时为空，每次从缓存获取）
+    std::shared_ptr<const std::vector<IndexEntry>> index_;
+    std::shared_ptr<const std::string> filter_;
+    std::shared_ptr<const MappedFile> mapped_;     ///< use_mmap_reads 时整个文件的映射（失败时为空）
+    /// mmap 读取时每个未压缩 Data Block 一位：已校验过 CRC（按 Index 中的序号）
+    std::unique_ptr<std::atomic<uint64_t>[]> verified_;
+    size_t verified_blocks_ = 0;
+    mutable std::atomic<uint64_t> filter_skips_{0};
+    std::atomic<bool> delete_on_close_{false};
+#ifdef _WIN32
+    mutable std::mutex io_mutex_;  ///< Windows 下保护共享文件偏移
+#endif
+
+    /**
+     * @brief 从 offset 处读取 n 字节
+     *
+     * @throw std::runtime_error 读取失败或数据不足
+     */
+    void ReadAt(uint64_t offset, size_t n, char* dst) const {
+        if (mapped_) {
+            if (offset > mapped_->size() || n > mapped_->size() - offset) {
+                throw std::runtime_error("Failed to read SSTable file: " + filepath_);
+            }
+            std::memcpy(dst, mapped_->data() + offset, n);
+            return;
+        }
+#ifdef _WIN32
+        std::lock_guard<std::mutex> lock(io_mutex_);
+        if (_fseeki64(file_, static_cast<long long>(offset), SEEK_SET) != 0 ||
+            std::fread(dst, 1, n, file_) != n) {
+            throw std::runtime_error("Failed to read SSTable file: " + filepath_);
+        }
+#else
+        size_t done = 0;
+        while (done < n) {
+            ssize_t r = ::pread(fileno(file_), dst + done, n - done,
+                                static_cast<off_t>(offset + done));
+            if (r <= 0) {
+                throw std::runtime_error("Failed to read SSTable file: " + filepath_);
+            }
+            done += static_cast<size_t>(r);
+        }
+#endif
+    }
+
+    /**
+     * @brief 读取一个 Block，校验尾部 CRC 并解压，返回原始内容
+     *
+     * - 格式版本 0：尾部为 4 字节 CRC32 (IEEE)
+     * - 格式版本 1 / 2：尾部为 4 字节 CRC32C
+     * - 格式版本 >= 3：尾部为 | CompressionType(1B) | CRC32C(4B) |，CRC 覆盖内容与类型字节
+     *
+     * 使用 mmap 读取时直接在映射上校验，只在返回时拷贝一次（或解压）。
+     *
+     * @throw std::runtime_error CRC 不匹配、压缩类型未知 / 本次构建不支持，或解压失败
+     */
+    std::string ReadBlock(const BlockHandle& handle) const {
+        size_t trailer_size = BlockTrailerSize(handle);
+        std::string block;
+        std::string_view raw_block;
+        if (mapped_) {
+            raw_block = std::string_view(mapped_->data() + handle.offset, static_cast<size_t>(handle.size));
+        } else {
+            block.resize(static_cast<size_t>(handle.size));
+            ReadAt(handle.offset, block.size(), block.data());
+            raw_block = block;
+        }
+
+        CompressionType type;
+        std::string_view contents = VerifyBlock(raw_block, trailer_size, &type);
+        if (type == CompressionType::kNone) {
+            if (mapped_) return std::string(contents);
+            block.resize(contents.size());
+            return block;
+        }
+        if (!compression_supported(type)) {
+            throw std::runtime_error(std::string("Unsupported block compression (") +
+                                     compression_name(type) + ") in SSTable: " + filepath_);
+        }
+        std::string raw;
+        if (!decompress_block(type, contents, &raw)) {
+            throw std::runtime_error("Failed to decompress block in SSTable: " + filepath_);
+        }
+        return raw;
+    }
+
+    /**
+     * @brief 校验 Block Handle 位于文件之内，返回该格式版本的 Block 尾部长度
+     *
+     * @throw std::runtime_error Handle 越界或比尾部还短
+     */
+    size_t BlockTrailerSize(const BlockHandle& handle) const {
+        const size_t trailer_size = footer_.format_version >= Footer::kFormatBlockTrailer ? 5 : 4;
+        if (handle.size < trailer_size || handle.offset > file_size_ ||
+            handle.size > file_size_ - handle.offset) {
+            throw std::runtime_error("Invalid block handle in SSTable: " + filepath_);
+        }
+        return trailer_size;
+    }
+
+    /**
+     * @brief 校验带尾部的 Block 的 CRC，返回去掉尾部的（可能被压缩的）内容及其压缩类型
+     *
+     * @throw std::runtime_error CRC 不匹配
+     */
+    std::string_view VerifyBlock(std::string_view block, size_t trailer_size,
+                                 CompressionType* type) const {
+        const bool typed = trailer_size == 5;
+        size_t data_size = block.size() - trailer_size;
+        uint32_t stored_crc = decode_fixed32(block.data() + block.size() - 4);
+        uint32_t actual_crc;
+        if (footer_.format_version == Footer::kFormatLegacy) {
+            actual_crc = crc32(block.data(), data_size);
+        } else {
+            // 版本 >= 3 时 CRC 额外覆盖紧随内容之后的类型字节
+            actual_crc = crc32c(block.data(), data_size + (typed ? 1 : 0));
+        }
+        if (stored_crc != actual_crc) {
+            throw std::runtime_error("Block checksum mismatch in SSTable: " + filepath_);
+        }
+        *type = typed ? static_cast<CompressionType>(block[data_size]) : CompressionType::kNone;
+        return block.substr(0, data_size);
+    }
+
+    /**
+     * @brief 在旧格式（版本 0 / 1）的平铺 Block 中顺序查找
+     *
+     * Entry 格式：| KeyLen(4B) | ValueLen(4B) | Key | Value |
+     */
+    bool SearchLegacyBlock(std::string_view block, std::string_view key,
+                           std::string_view* value) const {
+        size_t pos = 0;
+        while (pos < block.size()) {
+            if (block.size() - pos < 8) break;
+            uint32_t key_len = decode_fixed32(block.data() + pos);
+            uint32_t value_len = decode_fixed32(block.data() + pos + 4);
+            pos += 8;
+            if (block.size() - pos < static_cast<uint64_t>(key_len) + value_len) break;
+
+            std::string_view entry_key(block.data() + pos, key_len);
+            if (entry_key == key) {
+                *value = std::string_view(block.data() + pos + key_len, value_len);
+                return true;
+            }
+            if (comparator_->Compare(entry_key, key) > 0) {
+                return false;  // Block 内有序，已经越过目标位置
+            }
+            pos += static_cast<size_t>(key_len) + value_len;
+        }
+        if (pos != block.size()) {
+            throw std::runtime_error("Malformed data block in SSTable: " + filepath_);
+        }
+        return false;
+    }
+
+    /// Index 在缓存中的计费：Key 字节数 + 每项的固定开销
+    static size_t IndexCharge(const std::vector<IndexEntry>& index) {
+        size_t charge = sizeof(index) + index.size() * sizeof(IndexEntry);
+        for (const IndexEntry& entry : index) charge += entry.last_key.size();
+        return charge;
+    }
+
+    /**
+     * @brief 获取第 block_index 个 Data Block：先查缓存，未命中时读盘校验并放入缓存
+     *
+     * 使用 mmap 读取时，未压缩的 Block 直接返回映射中的视图（持有者为映射），不经过缓存；
+     * 映射是只读的，每个 Block 只在第一次访问时校验 CRC，之后由 verified_ 位图跳过。
+     * 压缩的 Block 只看尾部的类型字节，直接走缓存路径（未命中时由 ReadBlock 校验并解压）。
+     *
+     * @param block_index Block 在 Index 中的序号（用于 verified_ 位图）
+     * @param fill_cache 为 false 时未命中的 Block 不放入缓存（Compaction 等一次性的顺序读取，
+     *                   避免把热点 Block 挤出缓存）
+     */
+    BlockContents DataBlock(size_t block_index, const BlockHandle& handle, bool fill_cache = true) const {
+        if (mapped_) {
+            size_t trailer_size = BlockTrailerSize(handle);
+            std::string_view raw(mapped_->data() + handle.offset, static_cast<size_t>(handle.size));
+            bool compressed = trailer_size == 5 &&
+                              static_cast<CompressionType>(raw[raw.size() - trailer_size]) != CompressionType::kNone;
+            if (!compressed) {
+                std::atomic<uint64_t>* word = block_index < verified_blocks_ ? &verified_[block_index / 64] : nullptr;
+                const uint64_t bit = uint64_t{1} << (block_index % 64);
+                if (word && (word->load(std::memory_order_acquire) & bit) != 0) {
+                    return {raw.substr(0, raw.size() - trailer_size), mapped_};
+                }
+                CompressionType type;
+                std::string_view contents = VerifyBlock(raw, trailer_size, &type);
+                if (word) word->fetch_or(bit, std::memory_order_release);
+                return {contents, mapped_};
+            }
+        }
+        if (cache_) {
+            if (auto cached = cache_->Lookup(cache_id_, handle.offset)) {
+                auto block = std::static_pointer_cast<const std::string>(cached);
+                return {*block, std::move(block)};
+            }
+        }
+        auto block = std::make_shared<const std::string>(ReadBlock(handle));
+        if (cache_ && fill_cache) {
+            cache_->Insert(cache_id_, handle.offset, block, block->size());
+        }
+        return {*block, std::move(block)};
+    }
+
+    /// Bloom Filter（持有方式同 Index）
+    std::shared_ptr<const std::string> Filter() const {
+        if (filter_) return filter_;
+        if (auto cached = cache_->Lookup(cache_id_, filter_handle_.offset)) {
+            return std::static_pointer_cast<const std::string>(cached);
+        }
+        auto filter = std::make_shared<const std::string>(ReadBlock(filter_handle_));
+        cache_->Insert(cache_id_, filter_handle_.offset, filter, filter->size());
+        return filter;
+    }
+
+    /**
+     * @brief 读取并校验 Footer（布局见 SSTableBuilder::WriteFooter）
+     */
+    void ReadFooter() {
+        char buf[Footer::kEncodedLength];
+        ReadAt(file_size_ - Footer::kEncodedLength, sizeof(buf), buf);
+
+        if (decode_fixed64(buf + 40) != Footer::kTableMagicNumber) {
+            throw std::runtime_error("Bad SSTable magic number: " + filepath_);
+        }
+        footer_.metaindex_handle.offset = decode_fixed64(buf);
+        footer_.metaindex_handle.size = decode_fixed64(buf + 8);
+        footer_.format_version = decode_fixed32(buf + Footer::kFormatVersionOffset);
+        footer_.index_handle.offset = decode_fixed64(buf + 20);
+        footer_.index_handle.size = decode_fixed64(buf + 28);
+
+        if (footer_.format_version > Footer::kCurrentFormatVersion) {
+            throw std::runtime_error("Unsupported SSTable format version " +
+                                     std::to_string(footer_.format_version) + ": " + filepath_);
+        }
+    }
+
+    /**
+     * @brief 解析 Index / Metaindex 格式的 Block：| KeyLen(4B) | Key | Offset(8B) | Size(8B) |
+     */
+    std::vector<IndexEntry> ParseHandleBlock(const std::string& block, const char* what) const {
+        std::vector<IndexEntry> entries;
+        size_t pos = 0;
+        while (pos < block.size()) {
+            if (block.size() - pos < 4) break;
+            uint32_t key_len = decode_fixed32(block.data() + pos);
+            pos += 4;
+            if (block.size() - pos < static_cast<uint64_t>(key_len) + 16) break;
+
+            IndexEntry entry;
+            entry.last_key.assign(block.data() + pos, key_len);
+            pos += key_len;
+            entry.handle.offset = decode_fixed64(block.data() + pos);
+            entry.handle.size = decode_fixed64(block.data() + pos + 8);
+            pos += 16;
+            entries.push_back(std::move(entry));
+        }
+        if (pos != block.size()) {
+            throw std::runtime_error(std::string("Malformed ") + what + " block in SSTable: " +
+                                     filepath_);
+        }
+        return entries;
+    }
+
+    /**
+     * @brief 读取 Metaindex Block，加载其中登记的 Bloom Filter
+     *
+     * 旧文件或未启用过滤器的文件 metaindex_handle.size 为 0，此时不加载任何元数据。
+     * 无法识别的元数据名字被忽略，便于以后扩展。
+     * 打开时总会读一次 Filter Block 以校验其 CRC。
+     */
+    void ReadMetaindexBlock() {
+        if (footer_.metaindex_handle.size == 0) return;
+
+        std::string block = ReadBlock(footer_.metaindex_handle);
+        for (const IndexEntry& entry : ParseHandleBlock(block, "metaindex")) {
+            if (entry.last_key == Footer::kBloomFilterMetaKey) {
+                filter_handle_ = entry.handle;
+            }
+        }
+        if (filter_handle_.size == 0) return;
+
+        auto filter = std::make_shared<const std::string>(ReadBlock(filter_handle_));
+        if (cache_meta_blocks_) {
+            cache_->Insert(cache_id_, filter_handle_.offset, filter, filter->size(),
+                           pin_meta_blocks_);
+        }
+        if (!cache_meta_blocks_ || pin_meta_blocks_) {
+            filter_ = std::move(filter);
+        }
+    }
+
+    /**
+     * @brief 按区域给映射设置访问模式提示
+     *
+     * 文件布局为 | Data Blocks | Filter | Metaindex | Index | Footer |：
+     * Data 区域随机访问（MADV_RANDOM，避免预读把无关的页带进 Page Cache）；
+     * 之后的元数据区域马上就要读取且会反复使用（MADV_WILLNEED）。
+     */
+    void AdviseMapping() const {
+        if (!mapped_) return;
+        uint64_t data_end = file_size_ - Footer::kEncodedLength;
+        if (filter_handle_.size > 0) data_end = std::min(data_end, filter_handle_.offset);
+        if (footer_.metaindex_handle.size > 0) {
+            data_end = std::min(data_end, footer_.metaindex_handle.offset);
+        }
+        if (footer_.index_handle.size > 0) data_end = std::min(data_end, footer_.index_handle.offset);
+        mapped_->Advise(0, data_end, MappedFile::Advice::kRandom);
+        mapped_->Advise(data_end, file_size_ - data_end, MappedFile::Advice::kWillNeed);
+    }
+
+    /**
+     * @brief 读取 Index Block，按缓存策略决定由 Reader 持有还是放入缓存
+     *
+     * 空表（没有任何 Data Block）的 index_handle.size 为 0。
+     */
+    void ReadIndexBlock() {
+        if (footer_.index_handle.size > 0 &&
+            footer_.index_handle.offset + footer_.index_handle.size >
+                file_size_ - Footer::kEncodedLength) {
+            throw std::runtime_error("Invalid index handle in SSTable: " + filepath_);
+        }
+
+        auto index = LoadIndexBlock();
+        if (cache_meta_blocks_ && footer_.index_handle.size > 0) {
+            cache_->Insert(cache_id_, footer_.index_handle.offset, index, IndexCharge(*index),
+                           pin_meta_blocks_);
+            if (!pin_meta_blocks_) return;
+        }
+        index_ = std::move(index);
+    }
+
+    /**
+     * @brief 从磁盘读取并解析 Index Block
+     *
+     * Index Entry 格式：| KeyLen(4B) | Key | Offset(8B) | Size(8B) |
+     */
+    std::shared_ptr<const std::vector<IndexEntry>> LoadIndexBlock() const {
+        if (footer_.index_handle.size == 0) {
+            return std::make_shared<const std::vector<IndexEntry>>();
+        }
+        return std::make_shared<const std::vector<IndexEntry>>(
+            ParseHandleBlock(ReadBlock(footer_.index_handle), "index"));
+    }
+};
@@ -0,0 +1,326 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/**
+ * @file statistics.h
+ * @brief KVStore 的运行时统计：计数器 (Ticker) 与延迟直方图 (Histogram)
+ */
+
+/**
+ * @brief 计数器
+ */
+enum class Ticker : uint32_t {
+    kPuts,               ///< put 次数
+    kDeletes,            ///< del 次数
+    kWriteBatches,       ///< write(WriteBatch) 次数
+    kGets,               ///< get 次数
+    kGetHits,            ///< 其中读到值的次数
+    kBytesWritten,       ///< put / write 提交的用户数据字节数（Key + Value / 批次内容）
+    kBytesRead,          ///< get 读到的 Value 字节数
+    kMemtableHits,       ///< 在 MemTable 中得到结果（值或删除标记）的 get 次数
+    kMemtableMisses,     ///< 需要继续查询 SSTable 的 get 次数
+    kBloomUseful,        ///< Bloom Filter 判定不存在、省去一次 Data Block 读取的次数
+    kBloomPositive,      ///< Bloom Filter 判定可能存在的次数
+    kBloomTruePositive,  ///< 其中表中确实有该 Key（值或删除标记）的次数
+    kCount
+};
+
+/**
+ * @brief 直方图（单位均为纳秒）
+ */
+enum class HistogramType : uint32_t {
+    kPut,          ///< put 延迟（含排队、WAL 写入与 Sync）
+    kGet,          ///< get 延迟
+    kDelete,       ///< del 延迟
+    kWrite,        ///< write(WriteBatch) 延迟
+    kWalSync,      ///< 一次 WAL fdatasync 的耗时
+    kWriteStall,   ///< 写入因达到硬限制（Immutable MemTable / L0 / 待 Compaction 字节）而阻塞的时长
+    kWriteDelay,   ///< 一批写入因减速（达到软限制）而等待的时长
+    kFlush,        ///< 一次 MemTable 落盘（写 L0 SSTable + MANIFEST）的耗时
+    kCompaction,   ///< 一次 Compaction 的耗时
+    kCount
+};
+
+/// 计数器的名字（kv.stats 中为 "kv." + 名字，Prometheus 中为 "kv_" + 名字 + "_total"）
+inline const char* TickerName(Ticker ticker) {
+    static constexpr const char* kNames[] = {
+        "puts", "deletes", "write_batches", "gets", "get_hits", "bytes_written", "bytes_read",
+        "memtable_hits", "memtable_misses", "bloom_useful", "bloom_positive", "bloom_true_positive",
+    };
+    static_assert(std::size(kNames) == static_cast<size_t>(Ticker::kCount));
+    return kNames[static_cast<size_t>(ticker)];
+}
+
+/// 直方图的名字（Prometheus 中为 "kv_" + 名字 + "_seconds"）
+inline const char* HistogramName(HistogramType type) {
+    static constexpr const char* kNames[] = {
+        "put", "get", "delete", "write", "wal_sync", "write_stall", "write_delay", "flush", "compaction",
+    };
+    static_assert(std::size(kNames) == static_cast<size_t>(HistogramType::kCount));
+    return kNames[static_cast<size_t>(type)];
+}
+
+/**
+ * @brief 直方图：Statistics 的合并结果，也可以单线程直接记录（kv_bench 的每线程直方图）
+ *
+ * 分桶为对数-线性：每个 2 的幂区间再等分为 16 个子桶，覆盖整个 uint64 范围，
+ * 相对误差不超过 1/16（分位数在桶内线性插值，实际误差更小）。
+ */
+struct HistogramData {
+    static constexpr size_t kSubBits = 4;
+    static constexpr size_t kSubBuckets = size_t{1} << kSubBits;
+    static constexpr size_t kNumBuckets = (64 - kSubBits + 1) * kSubBuckets;
+
+    std::array<uint64_t, kNumBuckets> buckets{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    /// value 所在的桶
+    static size_t BucketIndex(uint64_t value) {
+        if (value < kSubBuckets) return static_cast<size_t>(value);
+        size_t shift = static_cast<size_t>(63 - std::countl_zero(value)) - kSubBits;
+        return (shift + 1) * kSubBuckets + (static_cast<size_t>(value >> shift) & (kSubBuckets - 1));
+    }
+
+    /// 第 index 个桶的下界（含）
+    static uint64_t BucketLow(size_t index) {
+        if (index < kSubBuckets) return index;
+        size_t shift = index / kSubBuckets - 1;
+        return static_cast<uint64_t>(kSubBuckets + index % kSubBuckets) << shift;
+    }
+
+    /// 加入一个样本（非线程安全）
+    void Add(uint64_t value) {
+        ++buckets[BucketIndex(value)];
+        ++count;
+        sum += value;
+        max = std::max(max, value);
+    }
+
+    /// 合并另一个直方图
+    void Merge(const HistogramData& other) {
+        for (size_t i = 0; i < kNumBuckets; ++i) buckets[i] += other.buckets[i];
+        count += other.count;
+        sum += other.sum;
+        max = std::max(max, other.max);
+    }
+
+    double Average() const { return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count); }
+
+    /**
+     * @brief 第 p 分位（0 <= p <= 1），在所在桶内按均匀分布插值，不超过 max
+     */
+    double Percentile(double p) const {
+        if (count == 0) return 0.0;
+        double rank = p * static_cast<double>(count);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kNumBuckets; ++i) {
+            if (buckets[i] == 0) continue;
+            if (static_cast<double>(seen + buckets[i]) >= rank) {
+                double low = static_cast<double>(BucketLow(i));
+                double high = i + 1 < kNumBuckets ? static_cast<double>(BucketLow(i + 1)) : low;
+                double fraction = (rank - static_cast<double>(seen)) / static_cast<double>(buckets[i]);
+                return std::min(low + (high - low) * fraction, static_cast<double>(max));
+            }
+            seen += buckets[i];
+        }
+        return static_cast<double>(max);
+    }
+};
+
+/**
+ * @brief 低开销的统计收集器，可在多个 KVStore（例如 ShardedKVStore 的各个分片）之间共享
+ *
+ * 计数器与直方图按线程分片：每个线程第一次记录时领取一个槽位，之后总是写入
+ * 槽位对应的分片（分片数为不小于 CPU 核数的 2 的幂，上限 32，分片按缓存行对齐），
+ * 写入只是一次无竞争的 relaxed 原子加，线程之间不共享缓存行。
+ * 读取时把所有分片相加，因此读到的是近似的实时值：与并发写入之间没有快照一致性。
+ *
+ * @note 本类是线程安全的。
+ */
+class Statistics {
+public:
+    Statistics() : num_shards_(ShardCount()), shards_(std::make_unique<Shard[]>(num_shards_)) {}
+
+    Statistics(const Statistics&) = delete;
+    Statistics& operator=(const Statistics&) = delete;
+
+    /// 计数器加 count
+    void Record(Ticker ticker, uint64_t count = 1) {
+        LocalShard().tickers[static_cast<size_t>(ticker)].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    /// 向直方图中加入一个样本（纳秒）
+    void Measure(HistogramType type, uint64_t nanos) {
+        Shard::Histogram& h = LocalShard().histograms[static_cast<size_t>(type)];
+        h.buckets[HistogramData::BucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+        h.count.fetch_add(1, std::memory_order_relaxed);
+        h.sum.fetch_add(nanos, std::memory_order_relaxed);
+        uint64_t max = h.max.load(std::memory_order_relaxed);
+        while (nanos > max && !h.max.compare_exchange_weak(max, nanos, std::memory_order_relaxed)) {
+        }
+    }
+
+    /// 计数器当前值（所有分片之和）
+    uint64_t Get(Ticker ticker) const {
+        uint64_t total = 0;
+        for (size_t i = 0; i < num_shards_; ++i) {
+            total += shards_[i].tickers[static_cast<size_t>(ticker)].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    /// 直方图当前内容（所有分片合并）
+    HistogramData GetHistogram(HistogramType type) const {
+        HistogramData data;
+        for (size_t i = 0; i < num_shards_; ++i) {
+            const Shard::Histogram& h = shards_[i].histograms[static_cast<size_t>(type)];
+            for (size_t b = 0; b < HistogramData::kNumBuckets; ++b) {
+                data.buckets[b] += h.buckets[b].load(std::memory_order_relaxed);
+            }
+            data.count += h.count.load(std::memory_order_relaxed);
+            data.sum += h.sum.load(std::memory_order_relaxed);
+            data.max = std::max(data.max, h.max.load(std::memory_order_relaxed));
+        }
+        return data;
+    }
+
+    /// 清零全部计数器与直方图（与并发写入之间不保证原子性）
+    void Reset() {
+        for (size_t i = 0; i < num_shards_; ++i) {
+            for (auto& ticker : shards_[i].tickers) ticker.store(0, std::memory_order_relaxed);
+            for (auto& h : shards_[i].histograms) {
+                for (auto& bucket : h.buckets) bucket.store(0, std::memory_order_relaxed);
+                h.count.store(0, std::memory_order_relaxed);
+                h.sum.store(0, std::memory_order_relaxed);
+                h.max.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief 可读的文本报告：每行一个计数器，直方图给出次数、平均值与分位数（微秒）
+     */
+    std::string ToString() const {
+        std::string out;
+        char line[256];
+        for (size_t i = 0; i < static_cast<size_t>(Ticker::kCount); ++i) {
+            auto ticker = static_cast<Ticker>(i);
+            std::snprintf(line, sizeof(line), "kv.%s COUNT : %llu\n", TickerName(ticker),
+                          static_cast<unsigned long long>(Get(ticker)));
+            out += line;
+        }
+        for (size_t i = 0; i < static_cast<size_t>(HistogramType::kCount); ++i) {
+            auto type = static_cast<HistogramType>(i);
+            HistogramData h = GetHistogram(type);
+            std::snprintf(line, sizeof(line),
+                          "kv.%s.micros COUNT : %llu AVG : %.2f P50 : %.2f P99 : %.2f P99.9 : %.2f MAX : %.2f\n",
+                          HistogramName(type), static_cast<unsigned long long>(h.count), h.Average() / 1e3,
+                          h.Percentile(0.5) / 1e3, h.Percentile(0.99) / 1e3, h.Percentile(0.999) / 1e3,
+                          static_cast<double>(h.max) / 1e3);
+            out += line;
+        }
+        return out;
+    }
+
+    /**
+     * @brief Prometheus 文本格式（exposition format 0.0.4）
+     *
+     * 计数器导出为 counter（kv_<name>_total），直方图导出为 summary（kv_<name>_seconds，
+     * 分位数 0.5 / 0.9 / 0.99 / 0.999，以及 _sum 与 _count）。
+     */
+    std::string ToPrometheus() const {
+        std::string out;
+        char line[256];
+        for (size_t i = 0; i < static_cast<size_t>(Ticker::kCount); ++i) {
+            auto ticker = static_cast<Ticker>(i);
+            std::snprintf(line, sizeof(line), "# TYPE kv_%s_total counter\nkv_%s_total %llu\n", TickerName(ticker),
+                          TickerName(ticker), static_cast<unsigned long long>(Get(ticker)));
+            out += line;
+        }
+        for (size_t i = 0; i < static_cast<size_t>(HistogramType::kCount); ++i) {
+            auto type = static_cast<HistogramType>(i);
+            const char* name = HistogramName(type);
+            HistogramData h = GetHistogram(type);
+            std::snprintf(line, sizeof(line), "# TYPE kv_%s_seconds summary\n", name);
+            out += line;
+            for (double q : {0.5, 0.9, 0.99, 0.999}) {
+                std::snprintf(line, sizeof(line), "kv_%s_seconds{quantile=\"%g\"} %.9f\n", name, q,
+                              h.Percentile(q) / 1e9);
+                out += line;
+            }
+            std::snprintf(line, sizeof(line), "kv_%s_seconds_sum %.9f\nkv_%s_seconds_count %llu\n", name,
+                          static_cast<double>(h.sum) / 1e9, name, static_cast<unsigned long long>(h.count));
+            out += line;
+        }
+        return out;
+    }
+
+private:
+    struct alignas(64) Shard {
+        struct Histogram {
+            std::array<std::atomic<uint64_t>, HistogramData::kNumBuckets> buckets{};
+            std::atomic<uint64_t> count{0};
+            std::atomic<uint64_t> sum{0};
+            std::atomic<uint64_t> max{0};
+        };
+        std::array<std::atomic<uint64_t>, static_cast<size_t>(Ticker::kCount)> tickers{};
+        std::array<Histogram, static_cast<size_t>(HistogramType::kCount)> histograms{};
+    };
+
+    size_t num_shards_;
+    std::unique_ptr<Shard[]> shards_;
+
+    static size_t ShardCount() {
+        size_t cpus = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        return std::min<size_t>(std::bit_ceil(cpus), 32);
+    }
+
+    /// 当前线程的分片：线程第一次调用时按顺序领取槽位，之后固定不变
+    Shard& LocalShard() {
+        static std::atomic<size_t> next_slot{0};
+        thread_local const size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed);
+        return shards_[slot & (num_shards_ - 1)];
+    }
+};
+
+/// stats 为空时什么也不做
+inline void RecordTick(Statistics* stats, Ticker ticker, uint64_t count = 1) {
+    if (stats) stats->Record(ticker, count);
+}
+
+/**
+ * @brief 计时器：析构时把经过的时间记入 stats 的直方图；stats 为空时不读取时钟
+ */
+class StopWatch {
+public:
+    StopWatch(Statistics* stats, HistogramType type)
+        : stats_(stats), type_(type), start_(stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point()) {}
+
+    ~StopWatch() {
+        if (!stats_) return;
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        stats_->Measure(type_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    StopWatch(const StopWatch&) = delete;
+    StopWatch& operator=(const StopWatch&) = delete;
+
+private:
+    Statistics* stats_;
+    HistogramType type_;
+    std::chrono::steady_clock::time_point start_;
+};
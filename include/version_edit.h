@@ -0,0 +1,299 @@
+#pragma once
+
+#include "coding.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @file version_edit.h
+ * @brief MANIFEST 中的一条记录：对文件集合的一次增量修改
+ */
+
+/**
+ * @brief 一个 SSTable 文件的元数据（MANIFEST 中持久化的部分）
+ */
+struct FileMetaData {
+    uint64_t number = 0;     ///< 文件编号
+    uint64_t file_size = 0;  ///< 文件大小（字节）
+    std::string smallest;    ///< 表中最小的 Key（按比较器的顺序）
+    std::string largest;     ///< 表中最大的 Key
+    std::vector<uint64_t> blob_files;  ///< 表中 BlobIndex 引用的 Blob 文件编号（升序，无重复）
+};
+
+/**
+ * @brief 一个 Blob 文件的元数据（MANIFEST 中持久化的部分）
+ */
+struct BlobFileMetaData {
+    uint64_t number = 0;      ///< 文件编号
+    uint64_t file_size = 0;   ///< 文件大小（字节）
+    uint64_t blob_count = 0;  ///< 记录数
+    uint64_t blob_bytes = 0;  ///< Value 总字节数
+};
+
+/**
+ * @brief 版本增量 (Version Edit)
+ *
+ * 每次落盘 / Compaction 都把“新增了哪些文件、删除了哪些文件”记录为一个 VersionEdit，
+ * 追加到 MANIFEST。启动时按顺序重放所有 Edit 即可得到最新的文件集合，
+ * 无需扫描目录、打开每个 SSTable。
+ *
+ * 编码为一串 Tag + 字段：
+ * +-------------------+--------------------------------------------------------------+
+ * | kLogNumber (1)    | Number(8B)                                                   |
+ * | kNextFileNumber(2)| Number(8B)                                                   |
+ * | kDeletedFile (3)  | Level(varint) | Number(8B)                                   |
+ * | kNewFile (4)      | Level(varint) | Number(8B) | Size(8B) | Smallest | Largest   |
+ * | kComparator (5)   | Name                                                         |
+ * | kLastSequence (6) | Sequence(8B)                                                 |
+ * | kNewFileWithBlobs | kNewFile 的字段 | Count(varint) | BlobNumber(8B) ...          |
+ * |   (7)             |                                                              |
+ * | kNewBlobFile (8)  | Number(8B) | Size(8B) | BlobCount(8B) | BlobBytes(8B)         |
+ * | kBlobGarbage (9)  | Number(8B) | Count(8B) | Bytes(8B)                             |
+ * +-------------------+--------------------------------------------------------------+
+ * Smallest / Largest / Name 编码为 | Len(varint) | Bytes |。
+ * 不引用 Blob 文件的 SSTable 仍编码为 kNewFile，未启用键值分离时 MANIFEST 格式不变。
+ * kBlobGarbage 是增量：同一个文件的多条记录累加。
+ */
+class VersionEdit {
+public:
+    /// 编号 <= number 的 WAL 段中的数据已全部落盘，启动时不再重放
+    void SetLogNumber(uint64_t number) {
+        has_log_number_ = true;
+        log_number_ = number;
+    }
+
+    /// 下一个可用的文件编号
+    void SetNextFileNumber(uint64_t number) {
+        has_next_file_number_ = true;
+        next_file_number_ = number;
+    }
+
+    /// 已落盘数据中最大的序列号：WAL 段删除后，重启时据此继续分配序列号
+    void SetLastSequence(uint64_t sequence) {
+        has_last_sequence_ = true;
+        last_sequence_ = sequence;
+    }
+
+    /// 比较器的名字（只写入 MANIFEST 的快照记录）
+    void SetComparatorName(std::string_view name) {
+        has_comparator_ = true;
+        comparator_.assign(name);
+    }
+
+    void AddFile(int level, FileMetaData file) { new_files_.emplace_back(level, std::move(file)); }
+
+    void DeleteFile(int level, uint64_t number) { deleted_files_.emplace_back(level, number); }
+
+    void AddBlobFile(BlobFileMetaData file) { new_blob_files_.push_back(file); }
+
+    /// Blob 文件 number 中又有 count 条、共 bytes 字节的 Value 失效
+    void AddBlobGarbage(uint64_t number, uint64_t count, uint64_t bytes) {
+        blob_garbage_.push_back({number, count, bytes});
+    }
+
+    bool HasLogNumber() const { return has_log_number_; }
+    uint64_t LogNumber() const { return log_number_; }
+    bool HasNextFileNumber() const { return has_next_file_number_; }
+    uint64_t NextFileNumber() const { return next_file_number_; }
+    bool HasLastSequence() const { return has_last_sequence_; }
+    uint64_t LastSequence() const { return last_sequence_; }
+    bool HasComparatorName() const { return has_comparator_; }
+    const std::string& ComparatorName() const { return comparator_; }
+    const std::vector<std::pair<int, FileMetaData>>& NewFiles() const { return new_files_; }
+    const std::vector<std::pair<int, uint64_t>>& DeletedFiles() const { return deleted_files_; }
+    const std::vector<BlobFileMetaData>& NewBlobFiles() const { return new_blob_files_; }
+
+    /// 失效的 Blob：文件编号、记录数、字节数
+    struct BlobGarbage {
+        uint64_t number = 0;
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+    const std::vector<BlobGarbage>& BlobGarbageList() const { return blob_garbage_; }
+
+    std::string Encode() const {
+        std::string dst;
+        if (has_comparator_) {
+            dst.push_back(static_cast<char>(kComparator));
+            PutLengthPrefixed(dst, comparator_);
+        }
+        if (has_log_number_) {
+            dst.push_back(static_cast<char>(kLogNumber));
+            put_fixed64(dst, log_number_);
+        }
+        if (has_next_file_number_) {
+            dst.push_back(static_cast<char>(kNextFileNumber));
+            put_fixed64(dst, next_file_number_);
+        }
+        if (has_last_sequence_) {
+            dst.push_back(static_cast<char>(kLastSequence));
+            put_fixed64(dst, last_sequence_);
+        }
+        for (const auto& [level, number] : deleted_files_) {
+            dst.push_back(static_cast<char>(kDeletedFile));
+            put_varint32(dst, static_cast<uint32_t>(level));
+            put_fixed64(dst, number);
+        }
+        for (const BlobFileMetaData& blob : new_blob_files_) {
+            dst.push_back(static_cast<char>(kNewBlobFile));
+            put_fixed64(dst, blob.number);
+            put_fixed64(dst, blob.file_size);
+            put_fixed64(dst, blob.blob_count);
+            put_fixed64(dst, blob.blob_bytes);
+        }
+        for (const auto& [level, file] : new_files_) {
+            dst.push_back(static_cast<char>(file.blob_files.empty() ? kNewFile : kNewFileWithBlobs));
+            put_varint32(dst, static_cast<uint32_t>(level));
+            put_fixed64(dst, file.number);
+            put_fixed64(dst, file.file_size);
+            PutLengthPrefixed(dst, file.smallest);
+            PutLengthPrefixed(dst, file.largest);
+            if (!file.blob_files.empty()) {
+                put_varint32(dst, static_cast<uint32_t>(file.blob_files.size()));
+                for (uint64_t number : file.blob_files) put_fixed64(dst, number);
+            }
+        }
+        for (const BlobGarbage& garbage : blob_garbage_) {
+            dst.push_back(static_cast<char>(kBlobGarbage));
+            put_fixed64(dst, garbage.number);
+            put_fixed64(dst, garbage.count);
+            put_fixed64(dst, garbage.bytes);
+        }
+        return dst;
+    }
+
+    /**
+     * @brief 解码 Encode() 的结果
+     *
+     * @return false 如果遇到未知 Tag 或数据不完整
+     */
+    bool Decode(std::string_view src) {
+        *this = VersionEdit();
+        const char* p = src.data();
+        const char* limit = src.data() + src.size();
+        while (p < limit) {
+            uint8_t tag = static_cast<uint8_t>(*p++);
+            uint32_t level = 0;
+            switch (tag) {
+                case kLogNumber:
+                    if (!GetFixed64(&p, limit, &log_number_)) return false;
+                    has_log_number_ = true;
+                    break;
+                case kNextFileNumber:
+                    if (!GetFixed64(&p, limit, &next_file_number_)) return false;
+                    has_next_file_number_ = true;
+                    break;
+                case kLastSequence:
+                    if (!GetFixed64(&p, limit, &last_sequence_)) return false;
+                    has_last_sequence_ = true;
+                    break;
+                case kDeletedFile: {
+                    uint64_t number = 0;
+                    if ((p = get_varint32_ptr(p, limit, &level)) == nullptr) return false;
+                    if (!GetFixed64(&p, limit, &number)) return false;
+                    deleted_files_.emplace_back(static_cast<int>(level), number);
+                    break;
+                }
+                case kNewFile:
+                case kNewFileWithBlobs: {
+                    FileMetaData file;
+                    if ((p = get_varint32_ptr(p, limit, &level)) == nullptr) return false;
+                    if (!GetFixed64(&p, limit, &file.number) ||
+                        !GetFixed64(&p, limit, &file.file_size) ||
+                        !GetLengthPrefixed(&p, limit, &file.smallest) ||
+                        !GetLengthPrefixed(&p, limit, &file.largest)) {
+                        return false;
+                    }
+                    if (tag == kNewFileWithBlobs) {
+                        uint32_t count = 0;
+                        if ((p = get_varint32_ptr(p, limit, &count)) == nullptr) return false;
+                        if (static_cast<uint64_t>(limit - p) < uint64_t{count} * 8) return false;
+                        file.blob_files.resize(count);
+                        for (uint64_t& number : file.blob_files) GetFixed64(&p, limit, &number);
+                    }
+                    new_files_.emplace_back(static_cast<int>(level), std::move(file));
+                    break;
+                }
+                case kNewBlobFile: {
+                    BlobFileMetaData blob;
+                    if (!GetFixed64(&p, limit, &blob.number) ||
+                        !GetFixed64(&p, limit, &blob.file_size) ||
+                        !GetFixed64(&p, limit, &blob.blob_count) ||
+                        !GetFixed64(&p, limit, &blob.blob_bytes)) {
+                        return false;
+                    }
+                    new_blob_files_.push_back(blob);
+                    break;
+                }
+                case kBlobGarbage: {
+                    BlobGarbage garbage;
+                    if (!GetFixed64(&p, limit, &garbage.number) ||
+                        !GetFixed64(&p, limit, &garbage.count) ||
+                        !GetFixed64(&p, limit, &garbage.bytes)) {
+                        return false;
+                    }
+                    blob_garbage_.push_back(garbage);
+                    break;
+                }
+                case kComparator:
+                    if (!GetLengthPrefixed(&p, limit, &comparator_)) return false;
+                    has_comparator_ = true;
+                    break;
+                default:
+                    return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    enum Tag : uint8_t {
+        kLogNumber = 1,
+        kNextFileNumber = 2,
+        kDeletedFile = 3,
+        kNewFile = 4,
+        kComparator = 5,
+        kLastSequence = 6,
+        kNewFileWithBlobs = 7,
+        kNewBlobFile = 8,
+        kBlobGarbage = 9
+    };
+
+    bool has_comparator_ = false;
+    bool has_log_number_ = false;
+    bool has_next_file_number_ = false;
+    bool has_last_sequence_ = false;
+    uint64_t log_number_ = 0;
+    uint64_t next_file_number_ = 0;
+    uint64_t last_sequence_ = 0;
+    std::string comparator_;
+    std::vector<std::pair<int, uint64_t>> deleted_files_;
+    std::vector<std::pair<int, FileMetaData>> new_files_;
+    std::vector<BlobFileMetaData> new_blob_files_;
+    std::vector<BlobGarbage> blob_garbage_;
+
+    static void PutLengthPrefixed(std::string& dst, std::string_view value) {
+        put_varint32(dst, static_cast<uint32_t>(value.size()));
+        dst.append(value.data(), value.size());
+    }
+
+    static bool GetFixed64(const char** p, const char* limit, uint64_t* value) {
+        if (limit - *p < 8) return false;
+        *value = decode_fixed64(*p);
+        *p += 8;
+        return true;
+    }
+
+    static bool GetLengthPrefixed(const char** p, const char* limit, std::string* value) {
+        uint32_t len = 0;
+        const char* q = get_varint32_ptr(*p, limit, &len);
+        if (q == nullptr || static_cast<uint64_t>(limit - q) < len) return false;
+        value->assign(q, len);
+        *p = q + len;
+        return true;
+    }
+};
@@ -0,0 +1,827 @@
+#pragma once
+#define _CRT_SECURE_NO_WARNINGS // 禁用 fopen 等不安全警告
+
+#include "blob_file.h"
+#include "coding.h"
+#include "crc32c.h"
+#include "filename.h"
+#include "options.h"
+#include "sstable_reader.h"
+#include "version_edit.h"
+#include "wal_writer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * @file version_set.h
+ * @brief 文件集合的版本管理：TableFile / BlobFile / Version / VersionSet 与 MANIFEST 日志
+ */
+
+/**
+ * @brief 一个存活的 SSTable 文件：元数据 + 按需打开的读取器
+ *
+ * - 读取器在第一次 Reader() 时才打开（读取 Footer / Index / Filter），
+ *   因此启动时只需从 MANIFEST 恢复元数据，不必打开每个文件。
+ * - TableFile 由所有引用它的 Version 共享。Compaction 删除它后调用 MarkObsolete()，
+ *   最后一个引用它的 Version 释放时（没有读请求再使用它）才真正删除文件。
+ *
+ * @note 本类是线程安全的。
+ */
+class TableFile {
+public:
+    TableFile(std::filesystem::path path, int level, FileMetaData meta,
+              std::shared_ptr<const TableOptions> options)
+        : path_(std::move(path)), level_(level), meta_(std::move(meta)), options_(std::move(options)) {}
+
+    ~TableFile() {
+        if (!obsolete_.load(std::memory_order_acquire)) return;
+        if (reader_) {
+            // 仍有读请求持有读取器时，由它关闭文件后再删除
+            reader_->DeleteFileOnClose();
+        } else {
+            std::error_code ec;
+            std::filesystem::remove(path_, ec);
+        }
+    }
+
+    TableFile(const TableFile&) = delete;
+    TableFile& operator=(const TableFile&) = delete;
+
+    int Level() const { return level_; }
+    uint64_t Number() const { return meta_.number; }
+    uint64_t FileSize() const { return meta_.file_size; }
+    const std::string& Smallest() const { return meta_.smallest; }
+    const std::string& Largest() const { return meta_.largest; }
+    const FileMetaData& Meta() const { return meta_; }
+    const std::filesystem::path& Path() const { return path_; }
+
+    /**
+     * @brief 获取读取器，第一次调用时打开文件
+     *
+     * @throw std::runtime_error 文件无法打开或已损坏
+     */
+    std::shared_ptr<SSTableReader> Reader() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!reader_) {
+            reader_ = std::make_shared<SSTableReader>(path_.string(), *options_);
+        }
+        return reader_;
+    }
+
+    /// 读取器是否已打开
+    bool IsOpen() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return reader_ != nullptr;
+    }
+
+    /// 标记为已淘汰：最后一个引用释放时删除文件
+    void MarkObsolete() { obsolete_.store(true, std::memory_order_release); }
+
+private:
+    std::filesystem::path path_;
+    int level_;
+    FileMetaData meta_;
+    std::shared_ptr<const TableOptions> options_;
+    mutable std::mutex mutex_;
+    mutable std::shared_ptr<SSTableReader> reader_;
+    std::atomic<bool> obsolete_{false};
+};
+
+/**
+ * @brief 一个存活的 Blob 文件：元数据 + 按需打开的读取器
+ *
+ * 生命周期与 TableFile 相同：由引用它的 Version 共享，不再被任何 SSTable 引用后
+ * 由 LogAndApply() 标记为已淘汰，最后一个引用释放时删除文件。
+ *
+ * @note 本类是线程安全的。
+ */
+class BlobFile {
+public:
+    BlobFile(std::filesystem::path path, BlobFileMetaData meta, std::shared_ptr<const TableOptions> options)
+        : path_(std::move(path)), meta_(meta), options_(std::move(options)) {}
+
+    ~BlobFile() {
+        if (!obsolete_.load(std::memory_order_acquire)) return;
+        reader_.reset();
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+    }
+
+    BlobFile(const BlobFile&) = delete;
+    BlobFile& operator=(const BlobFile&) = delete;
+
+    uint64_t Number() const { return meta_.number; }
+    uint64_t FileSize() const { return meta_.file_size; }
+    const BlobFileMetaData& Meta() const { return meta_; }
+    const std::filesystem::path& Path() const { return path_; }
+
+    /**
+     * @brief 读取 index 指向的 Value，第一次调用时打开文件
+     *
+     * @throw std::runtime_error 文件无法打开、读取失败或记录损坏
+     */
+    std::shared_ptr<const std::string> Get(const BlobIndex& index, std::string_view user_key,
+                                           bool fill_cache = true) const {
+        std::shared_ptr<BlobFileReader> reader;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!reader_) {
+                reader_ = std::make_shared<BlobFileReader>(path_.string(), options_->block_cache);
+            }
+            reader = reader_;
+        }
+        return reader->Get(index, user_key, fill_cache);
+    }
+
+    /// 标记为已淘汰：最后一个引用释放时删除文件
+    void MarkObsolete() { obsolete_.store(true, std::memory_order_release); }
+
+private:
+    std::filesystem::path path_;
+    BlobFileMetaData meta_;
+    std::shared_ptr<const TableOptions> options_;
+    mutable std::mutex mutex_;
+    mutable std::shared_ptr<BlobFileReader> reader_;
+    std::atomic<bool> obsolete_{false};
+};
+
+/**
+ * @brief 某一时刻的文件集合快照（不可变）
+ *
+ * 读请求与 Compaction 持有 shared_ptr<const Version>，期间即使有新的落盘 / Compaction 安装，
+ * 它看到的文件集合也不会变化，其中的文件也不会被删除（引用计数）。
+ *
+ * - L0 按文件编号升序，文件之间 Key 范围可以重叠；
+ * - L1 及更深的层按 Smallest 升序，层内文件互不重叠；
+ * - Blob 文件按编号索引，并带有 Compaction 累计的垃圾统计（discard 统计）。
+ */
+class Version {
+public:
+    using FileList = std::vector<std::shared_ptr<TableFile>>;
+
+    /// 一个 Blob 文件及其中已失效的记录
+    struct BlobFileState {
+        std::shared_ptr<BlobFile> file;
+        uint64_t garbage_count = 0;
+        uint64_t garbage_bytes = 0;
+
+        /// 失效字节占 Value 总字节的比例
+        double GarbageRatio() const {
+            uint64_t total = file->Meta().blob_bytes;
+            return total == 0 ? 1.0 : static_cast<double>(garbage_bytes) / static_cast<double>(total);
+        }
+    };
+    using BlobFileMap = std::map<uint64_t, BlobFileState>;
+
+    explicit Version(int num_levels, const Comparator* comparator = BytewiseComparator())
+        : comparator_(comparator), files_(static_cast<size_t>(num_levels)) {}
+
+    int NumLevels() const { return static_cast<int>(files_.size()); }
+
+    /// 第 level 层的文件（level 必须合法）
+    const FileList& Files(int level) const { return files_[static_cast<size_t>(level)]; }
+
+    size_t NumFiles(int level) const {
+        if (level < 0 || level >= NumLevels()) return 0;
+        return Files(level).size();
+    }
+
+    uint64_t LevelBytes(int level) const {
+        if (level < 0 || level >= NumLevels()) return 0;
+        uint64_t bytes = 0;
+        for (const auto& file : Files(level)) bytes += file->FileSize();
+        return bytes;
+    }
+
+    size_t TotalFiles() const {
+        size_t n = 0;
+        for (const auto& files : files_) n += files.size();
+        return n;
+    }
+
+    /**
+     * @brief 在 L1 及更深的某一层中查找 Key 范围包含 key 的文件（二分查找）
+     *
+     * @return 不存在时返回 nullptr
+     */
+    const TableFile* FindFile(int level, std::string_view key) const {
+        const FileList& files = Files(level);
+        auto it = std::lower_bound(files.begin(), files.end(), key,
+                                   [this](const std::shared_ptr<TableFile>& file, std::string_view k) {
+                                       return comparator_->Compare(file->Largest(), k) < 0;
+                                   });
+        if (it == files.end() || comparator_->Compare(key, (*it)->Smallest()) < 0) return nullptr;
+        return it->get();
+    }
+
+    /**
+     * @brief Key 范围包含 key 的所有文件，按从新到旧排列（L0 新到旧，再逐层向下）
+     */
+    std::vector<const TableFile*> FilesForKey(std::string_view key) const {
+        std::vector<const TableFile*> result;
+        const FileList& level0 = Files(0);
+        for (auto it = level0.rbegin(); it != level0.rend(); ++it) {
+            if (comparator_->Compare(key, (*it)->Smallest()) >= 0 &&
+                comparator_->Compare(key, (*it)->Largest()) <= 0) {
+                result.push_back(it->get());
+            }
+        }
+        for (int level = 1; level < NumLevels(); ++level) {
+            if (const TableFile* file = FindFile(level, key)) result.push_back(file);
+        }
+        return result;
+    }
+
+    /// 第 level 层中 Key 范围与 [smallest, largest] 重叠的文件
+    FileList OverlappingFiles(int level, std::string_view smallest, std::string_view largest) const {
+        FileList result;
+        for (const auto& file : Files(level)) {
+            if (comparator_->Compare(file->Largest(), smallest) >= 0 &&
+                comparator_->Compare(file->Smallest(), largest) <= 0) {
+                result.push_back(file);
+            }
+        }
+        return result;
+    }
+
+    /// 文件 Key 范围所用的比较器
+    const Comparator* comparator() const { return comparator_; }
+
+    /// 所有存活的 Blob 文件（按编号升序）
+    const BlobFileMap& BlobFiles() const { return blob_files_; }
+
+    /// @return 不存在时返回 nullptr
+    const BlobFile* FindBlobFile(uint64_t number) const {
+        auto it = blob_files_.find(number);
+        return it == blob_files_.end() ? nullptr : it->second.file.get();
+    }
+
+private:
+    friend class VersionSet;
+    const Comparator* comparator_;
+    std::vector<FileList> files_;
+    BlobFileMap blob_files_;
+};
+
+/**
+ * @brief 管理当前 Version、文件编号分配与 MANIFEST 日志
+ *
+ * MANIFEST 是 VersionEdit 的追加日志，每条记录格式为：
+ * +--------------+--------------+-----------------------+
+ * | CRC32C (4B)  | Length (4B)  | VersionEdit (Length)  |
+ * +--------------+--------------+-----------------------+
+ * CRC 覆盖 Length 与 Payload。CURRENT 文件保存当前 MANIFEST 的文件名，通过
+ * “写临时文件 + fsync + 重命名”原子替换。
+ *
+ * 生命周期：
+ * 1. Recover()：读取 CURRENT 指向的 MANIFEST，按顺序重放所有 Edit 得到最新的文件集合。
+ * 2. NewManifest()：把当前文件集合写成一个快照 Edit，作为新 MANIFEST 的第一条记录，
+ *    切换 CURRENT 并删除旧 MANIFEST（每次启动都会执行，MANIFEST 过大时也会执行）。
+ * 3. LogAndApply()：每次落盘 / Compaction 追加一条 Edit 并 fsync，成功后才安装新 Version。
+ *    MANIFEST 中的记录一定先于文件集合的变化落盘，崩溃后重放得到的状态总是一致的。
+ *
+ * @note 本类是线程安全的：LogAndApply / NewManifest 相互串行，current() 可并发调用。
+ */
+class VersionSet {
+public:
+    /**
+     * @param dir 数据目录
+     * @param num_levels 层数
+     * @param table_options 打开 SSTable 时使用的选项
+     * @param max_manifest_file_size 快照之后追加的记录超过该大小时写入新的 MANIFEST（0 表示不限制）
+     */
+    VersionSet(std::filesystem::path dir, int num_levels, const TableOptions& table_options,
+               uint64_t max_manifest_file_size = 64 << 20)
+        : dir_(std::move(dir))
+        , num_levels_(num_levels)
+        , table_options_(std::make_shared<const TableOptions>(table_options))
+        , max_manifest_file_size_(max_manifest_file_size)
+        , current_(std::make_shared<const Version>(num_levels, table_options.comparator)) {}
+
+    ~VersionSet() {
+        if (manifest_) {
+            std::fclose(manifest_);
+            manifest_ = nullptr;
+        }
+    }
+
+    VersionSet(const VersionSet&) = delete;
+    VersionSet& operator=(const VersionSet&) = delete;
+
+    /**
+     * @brief 从 CURRENT 指向的 MANIFEST 恢复文件集合
+     *
+     * MANIFEST 末尾不完整的记录（写到一半时崩溃）被忽略：它对应的修改从未被安装。
+     *
+     * @param edits [out] 可选，重放的 Edit 数量
+     * @return false 表示没有 CURRENT 文件（新目录或旧版本创建的目录）
+     * @throw std::runtime_error MANIFEST 缺失、中间记录损坏，文件的层号超出 num_levels，
+     *        或 MANIFEST 记录的比较器与 table_options.comparator 不同名
+     */
+    bool Recover(uint64_t* edits = nullptr) {
+        std::filesystem::path current_path = dir_ / kCurrentFileName;
+        if (!std::filesystem::exists(current_path)) return false;
+
+        std::string current = ReadFile(current_path);
+        while (!current.empty() && (current.back() == '\n' || current.back() == '\r')) {
+            current.pop_back();
+        }
+        uint64_t manifest_number = 0;
+        if (!parse_manifest_file_name(current, &manifest_number)) {
+            throw std::runtime_error("Invalid CURRENT file in " + dir_.string());
+        }
+        std::filesystem::path manifest_path = dir_ / current;
+        if (!std::filesystem::exists(manifest_path)) {
+            throw std::runtime_error("MANIFEST referenced by CURRENT is missing: " +
+                                     manifest_path.string());
+        }
+        std::string data = ReadFile(manifest_path);
+
+        // 直接在按层的有序表上累积所有 Edit，最后一次性构造 Version
+        std::vector<std::map<uint64_t, FileMetaData>> levels(static_cast<size_t>(num_levels_));
+        std::map<uint64_t, BlobFileMetaData> blob_files;
+        std::map<uint64_t, std::pair<uint64_t, uint64_t>> blob_garbage;  // number -> (count, bytes)
+        std::string comparator_name;  // 旧版本写入的 MANIFEST 没有记录，视为默认的字节序
+        uint64_t log_number = 0;
+        uint64_t last_sequence = 0;
+        uint64_t next_file_number = manifest_number + 1;
+        uint64_t count = 0;
+        size_t pos = 0;
+        while (data.size() - pos >= kRecordHeaderSize) {
+            uint32_t stored_crc = decode_fixed32(data.data() + pos);
+            uint32_t length = decode_fixed32(data.data() + pos + 4);
+            if (data.size() - pos - kRecordHeaderSize < length) break;  // 末尾不完整的记录
+
+            size_t record_end = pos + kRecordHeaderSize + length;
+            if (crc32c(data.data() + pos + 4, 4 + length) != stored_crc) {
+                if (record_end == data.size()) break;  // 最后一条记录写到一半
+                throw std::runtime_error("Corrupted record in " + manifest_path.string());
+            }
+
+            VersionEdit edit;
+            if (!edit.Decode(std::string_view(data.data() + pos + kRecordHeaderSize, length))) {
+                throw std::runtime_error("Malformed version edit in " + manifest_path.string());
+            }
+            for (const auto& [level, number] : edit.DeletedFiles()) {
+                CheckLevel(level);
+                levels[static_cast<size_t>(level)].erase(number);
+            }
+            for (const auto& [level, file] : edit.NewFiles()) {
+                CheckLevel(level);
+                levels[static_cast<size_t>(level)][file.number] = file;
+            }
+            for (const BlobFileMetaData& blob : edit.NewBlobFiles()) blob_files[blob.number] = blob;
+            for (const auto& garbage : edit.BlobGarbageList()) {
+                blob_garbage[garbage.number].first += garbage.count;
+                blob_garbage[garbage.number].second += garbage.bytes;
+            }
+            if (edit.HasComparatorName()) comparator_name = edit.ComparatorName();
+            if (edit.HasLogNumber()) log_number = std::max(log_number, edit.LogNumber());
+            if (edit.HasLastSequence()) last_sequence = std::max(last_sequence, edit.LastSequence());
+            if (edit.HasNextFileNumber()) {
+                next_file_number = std::max(next_file_number, edit.NextFileNumber());
+            }
+            ++count;
+            pos = record_end;
+        }
+
+        if (!comparator_name.empty() && comparator_name != table_options_->comparator->Name()) {
+            throw std::runtime_error("Comparator mismatch in " + dir_.string() + ": MANIFEST uses " +
+                                     comparator_name + ", opened with " +
+                                     table_options_->comparator->Name());
+        }
+
+        auto version = std::make_shared<Version>(num_levels_, table_options_->comparator);
+        for (int level = 0; level < num_levels_; ++level) {
+            for (auto& [number, file] : levels[static_cast<size_t>(level)]) {
+                version->files_[static_cast<size_t>(level)].push_back(NewTableFile(level, std::move(file)));
+            }
+            SortFiles(level, &version->files_[static_cast<size_t>(level)]);
+        }
+        for (const auto& [number, blob] : blob_files) {
+            auto garbage = blob_garbage.find(number);
+            version->blob_files_[number] = {NewBlobFile(blob),
+                                            garbage == blob_garbage.end() ? 0 : garbage->second.first,
+                                            garbage == blob_garbage.end() ? 0 : garbage->second.second};
+        }
+        RemoveUnreferencedBlobFiles(version.get());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_ = std::move(version);
+        log_number_ = log_number;
+        last_sequence_ = last_sequence;
+        manifest_number_ = manifest_number;
+        MarkFileNumberUsed(next_file_number - 1);
+        if (edits) *edits = count;
+        return true;
+    }
+
+    /**
+     * @brief 把 (当前文件集合 + edit) 写成新的 MANIFEST，并切换 CURRENT
+     *
+     * 新 MANIFEST 的唯一一条记录是完整的快照，因此 edit 与快照原子地生效：
+     * 启动时把扫描得到的旧文件作为 edit 传入，不会出现 CURRENT 已切换、文件却未登记的中间状态。
+     *
+     * @throw std::runtime_error 写入或 fsync 失败（CURRENT 保持不变）
+     */
+    void NewManifest(const VersionEdit& edit = VersionEdit()) {
+        std::lock_guard<std::mutex> write_lock(write_mutex_);
+        CheckNotFailed();
+        std::shared_ptr<const Version> version = Apply(*current(), edit);
+        uint64_t log_number = edit.HasLogNumber() ? std::max(LogNumber(), edit.LogNumber()) : LogNumber();
+        uint64_t last_sequence =
+            edit.HasLastSequence() ? std::max(LastSequence(), edit.LastSequence()) : LastSequence();
+        NewManifestLocked(*version, log_number, last_sequence);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_ = std::move(version);
+        log_number_ = log_number;
+        last_sequence_ = last_sequence;
+    }
+
+    /**
+     * @brief 追加一条 Edit 到 MANIFEST（fsync 后）并安装新的 Version
+     *
+     * edit 中被删除的文件、以及因此不再被任何 SSTable 引用的 Blob 文件在旧 Version 全部释放后删除。
+     * 写入失败后本对象进入失败状态，之后的调用都会抛出异常（MANIFEST 末尾可能已有半条记录）。
+     *
+     * @param edit 待应用的修改；函数会填入 next_file_number
+     * @throw std::runtime_error 写入或 fsync 失败，或之前已失败
+     */
+    void LogAndApply(VersionEdit* edit) {
+        std::lock_guard<std::mutex> write_lock(write_mutex_);
+        CheckNotFailed();
+        if (manifest_ == nullptr) {
+            throw std::runtime_error("LogAndApply called before NewManifest");
+        }
+
+        std::shared_ptr<const Version> base = current();
+        edit->SetNextFileNumber(next_file_number_.load(std::memory_order_relaxed));
+        std::shared_ptr<const Version> version = Apply(*base, *edit);
+        uint64_t log_number =
+            edit->HasLogNumber() ? std::max(LogNumber(), edit->LogNumber()) : LogNumber();
+        uint64_t last_sequence =
+            edit->HasLastSequence() ? std::max(LastSequence(), edit->LastSequence()) : LastSequence();
+
+        try {
+            WriteRecord(edit->Encode());
+        } catch (...) {
+            failed_ = true;
+            throw;
+        }
+
+        for (const auto& [level, number] : edit->DeletedFiles()) {
+            for (const auto& file : base->Files(level)) {
+                if (file->Number() == number) file->MarkObsolete();
+            }
+        }
+        for (const auto& [number, blob] : base->BlobFiles()) {
+            if (version->BlobFiles().count(number) == 0) blob.file->MarkObsolete();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            current_ = version;
+            log_number_ = log_number;
+            last_sequence_ = last_sequence;
+        }
+
+        // 只按快照之后追加的字节数判断，避免文件很多（快照本身很大）时每次都切换
+        if (max_manifest_file_size_ > 0 &&
+            manifest_size_ - snapshot_size_ > max_manifest_file_size_) {
+            try {
+                NewManifestLocked(*version, log_number, last_sequence);
+            } catch (...) {
+                // 旧 MANIFEST 依然完整有效，本次修改已经生效，下次再尝试切换
+            }
+        }
+    }
+
+    /**
+     * @brief 在另一个目录 dir 中写入只含 version 快照的 MANIFEST，并让 dir 中的 CURRENT 指向它
+     *
+     * 用于 Checkpoint：调用者先把 version 引用的 SSTable 与 Blob 文件链接或复制到 dir，
+     * 之后以 dir 为数据目录打开的 KVStore 恰好看到 version 的文件集合。本对象的 MANIFEST 不受影响。
+     *
+     * @throw std::runtime_error 写入或 fsync 失败
+     */
+    void WriteCheckpoint(const std::filesystem::path& dir, const Version& version) {
+        std::lock_guard<std::mutex> write_lock(write_mutex_);
+        uint64_t number = NewFileNumber();
+        std::filesystem::path path = dir / manifest_file_name(number);
+        std::string record = EncodeRecord(SnapshotEdit(version, LogNumber(), LastSequence()).Encode());
+        FILE* file = std::fopen(path.string().c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("Failed to create MANIFEST: " + path.string());
+        }
+        bool ok = std::fwrite(record.data(), 1, record.size(), file) == record.size();
+        ok = SyncFile(file) && ok;
+        std::fclose(file);
+        if (!ok) {
+            throw std::runtime_error("Failed to write MANIFEST: " + path.string());
+        }
+        SetCurrentFile(dir, number);
+    }
+
+    /// 当前 Version
+    std::shared_ptr<const Version> current() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return current_;
+    }
+
+    /// 分配一个新的文件编号（WAL 段、SSTable、Blob 文件、MANIFEST 共用）
+    uint64_t NewFileNumber() { return next_file_number_.fetch_add(1, std::memory_order_relaxed); }
+
+    /// 保证之后分配的编号都大于 number（启动时登记目录中已存在的文件）
+    void MarkFileNumberUsed(uint64_t number) {
+        uint64_t next = next_file_number_.load(std::memory_order_relaxed);
+        while (next <= number &&
+               !next_file_number_.compare_exchange_weak(next, number + 1, std::memory_order_relaxed)) {
+        }
+    }
+
+    /// 编号 <= LogNumber() 的 WAL 段已全部落盘
+    uint64_t LogNumber() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return log_number_;
+    }
+
+    /// 已落盘数据中最大的序列号（MANIFEST 中记录的 LastSequence）
+    uint64_t LastSequence() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_sequence_;
+    }
+
+    /// 当前 MANIFEST 的编号（尚未创建时为 0）
+    uint64_t ManifestNumber() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return manifest_number_;
+    }
+
+    /// 当前 MANIFEST 的大小（字节）
+    uint64_t ManifestFileSize() const {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        return manifest_size_;
+    }
+
+private:
+    static constexpr size_t kRecordHeaderSize = 8;
+
+    std::filesystem::path dir_;
+    int num_levels_;
+    std::shared_ptr<const TableOptions> table_options_;
+    uint64_t max_manifest_file_size_;
+
+    mutable std::mutex write_mutex_;   ///< 串行化 MANIFEST 写入（LogAndApply / NewManifest）
+    FILE* manifest_ = nullptr;         ///< 当前 MANIFEST（受 write_mutex_ 保护）
+    uint64_t manifest_size_ = 0;
+    uint64_t snapshot_size_ = 0;       ///< 当前 MANIFEST 首条快照记录的大小
+    bool failed_ = false;
+
+    mutable std::mutex mutex_;         ///< 保护 current_ / log_number_ / last_sequence_ / manifest_number_
+    std::shared_ptr<const Version> current_;
+    uint64_t log_number_ = 0;
+    uint64_t last_sequence_ = 0;
+    uint64_t manifest_number_ = 0;
+    std::atomic<uint64_t> next_file_number_{1};
+
+    void CheckLevel(int level) const {
+        if (level < 0 || level >= num_levels_) {
+            throw std::runtime_error("MANIFEST references level " + std::to_string(level) +
+                                     " beyond num_levels in " + dir_.string());
+        }
+    }
+
+    void CheckNotFailed() const {
+        if (failed_) throw std::runtime_error("MANIFEST is in a failed state: " + dir_.string());
+    }
+
+    std::shared_ptr<TableFile> NewTableFile(int level, FileMetaData meta) const {
+        std::filesystem::path path = dir_ / table_file_name(level, meta.number);
+        return std::make_shared<TableFile>(std::move(path), level, std::move(meta), table_options_);
+    }
+
+    std::shared_ptr<BlobFile> NewBlobFile(const BlobFileMetaData& meta) const {
+        return std::make_shared<BlobFile>(dir_ / blob_file_name(meta.number), meta, table_options_);
+    }
+
+    /**
+     * @brief 移除不再被任何 SSTable 引用的 Blob 文件
+     *
+     * Blob 文件的存活只由 SSTable 的引用决定；垃圾统计只用于挑选 GC 的对象，
+     * 统计偏差不会导致仍被引用的文件被删除。
+     */
+    static void RemoveUnreferencedBlobFiles(Version* version) {
+        if (version->blob_files_.empty()) return;
+        std::set<uint64_t> referenced;
+        for (const auto& files : version->files_) {
+            for (const auto& file : files) {
+                referenced.insert(file->Meta().blob_files.begin(), file->Meta().blob_files.end());
+            }
+        }
+        for (auto it = version->blob_files_.begin(); it != version->blob_files_.end();) {
+            it = referenced.count(it->first) ? std::next(it) : version->blob_files_.erase(it);
+        }
+    }
+
+    void SortFiles(int level, Version::FileList* files) const {
+        if (level == 0) {
+            std::sort(files->begin(), files->end(),
+                      [](const auto& a, const auto& b) { return a->Number() < b->Number(); });
+        } else {
+            const Comparator* cmp = table_options_->comparator;
+            std::sort(files->begin(), files->end(), [cmp](const auto& a, const auto& b) {
+                return cmp->Compare(a->Smallest(), b->Smallest()) < 0;
+            });
+        }
+    }
+
+    /// 在 base 上应用 edit，生成新的 Version（未受影响的文件与 base 共享）
+    std::shared_ptr<const Version> Apply(const Version& base, const VersionEdit& edit) const {
+        auto version = std::make_shared<Version>(base);
+        for (const auto& [level, number] : edit.DeletedFiles()) {
+            CheckLevel(level);
+            auto& files = version->files_[static_cast<size_t>(level)];
+            files.erase(std::remove_if(files.begin(), files.end(),
+                                       [number = number](const auto& file) {
+                                           return file->Number() == number;
+                                       }),
+                        files.end());
+        }
+        std::vector<bool> touched(static_cast<size_t>(num_levels_), false);
+        for (const auto& [level, file] : edit.NewFiles()) {
+            CheckLevel(level);
+            version->files_[static_cast<size_t>(level)].push_back(NewTableFile(level, file));
+            touched[static_cast<size_t>(level)] = true;
+        }
+        for (int level = 0; level < num_levels_; ++level) {
+            if (touched[static_cast<size_t>(level)]) {
+                SortFiles(level, &version->files_[static_cast<size_t>(level)]);
+            }
+        }
+        for (const BlobFileMetaData& blob : edit.NewBlobFiles()) {
+            version->blob_files_[blob.number] = {NewBlobFile(blob), 0, 0};
+        }
+        for (const auto& garbage : edit.BlobGarbageList()) {
+            auto it = version->blob_files_.find(garbage.number);
+            if (it == version->blob_files_.end()) continue;
+            it->second.garbage_count += garbage.count;
+            it->second.garbage_bytes += garbage.bytes;
+        }
+        if (!edit.DeletedFiles().empty() || !edit.NewBlobFiles().empty()) {
+            RemoveUnreferencedBlobFiles(version.get());
+        }
+        return version;
+    }
+
+    /**
+     * @brief 创建新的 MANIFEST（首条记录为 version 的快照）并切换 CURRENT（持有 write_mutex_）
+     */
+    void NewManifestLocked(const Version& version, uint64_t log_number, uint64_t last_sequence) {
+        uint64_t number = NewFileNumber();
+        std::filesystem::path path = dir_ / manifest_file_name(number);
+        FILE* file = std::fopen(path.string().c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("Failed to create MANIFEST: " + path.string());
+        }
+
+        VersionEdit snapshot = SnapshotEdit(version, log_number, last_sequence);
+
+        FILE* old_manifest = manifest_;
+        uint64_t old_size = manifest_size_;
+        uint64_t old_snapshot_size = snapshot_size_;
+        manifest_ = file;
+        manifest_size_ = 0;
+        try {
+            WriteRecord(snapshot.Encode());
+            snapshot_size_ = manifest_size_;
+            SetCurrentFile(dir_, number);
+        } catch (...) {
+            std::fclose(file);
+            manifest_ = old_manifest;
+            manifest_size_ = old_size;
+            snapshot_size_ = old_snapshot_size;
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+            throw;
+        }
+
+        uint64_t old_number = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            old_number = manifest_number_;
+            manifest_number_ = number;
+        }
+        if (old_manifest) std::fclose(old_manifest);
+        if (old_number != 0) {
+            std::error_code ec;
+            std::filesystem::remove(dir_ / manifest_file_name(old_number), ec);
+        }
+    }
+
+    /// 描述 version 完整文件集合的快照记录（MANIFEST 的首条记录）
+    VersionEdit SnapshotEdit(const Version& version, uint64_t log_number, uint64_t last_sequence) const {
+        VersionEdit snapshot;
+        snapshot.SetComparatorName(table_options_->comparator->Name());
+        snapshot.SetLogNumber(log_number);
+        snapshot.SetLastSequence(last_sequence);
+        snapshot.SetNextFileNumber(next_file_number_.load(std::memory_order_relaxed));
+        for (int level = 0; level < num_levels_; ++level) {
+            for (const auto& table : version.Files(level)) snapshot.AddFile(level, table->Meta());
+        }
+        for (const auto& [number, blob] : version.BlobFiles()) {
+            snapshot.AddBlobFile(blob.file->Meta());
+            if (blob.garbage_count > 0 || blob.garbage_bytes > 0) {
+                snapshot.AddBlobGarbage(number, blob.garbage_count, blob.garbage_bytes);
+            }
+        }
+        return snapshot;
+    }
+
+    /**
+     * @brief 原子地把 dir 中的 CURRENT 指向 MANIFEST-<number>
+     *
+     * 改名后 fsync 目录，新 MANIFEST 与 CURRENT 的目录项随之持久化；
+     * 返回之后调用者才能删除旧的 MANIFEST 或因此失效的 WAL 段。
+     */
+    static void SetCurrentFile(const std::filesystem::path& dir, uint64_t number) {
+        std::filesystem::path tmp = dir / (std::string(kCurrentFileName) + ".tmp");
+        FILE* file = std::fopen(tmp.string().c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("Failed to create " + tmp.string());
+        }
+        std::string contents = manifest_file_name(number) + "\n";
+        bool ok = std::fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+        ok = SyncFile(file) && ok;
+        std::fclose(file);
+        if (!ok) {
+            throw std::runtime_error("Failed to write " + tmp.string());
+        }
+        std::filesystem::rename(tmp, dir / kCurrentFileName);
+        sync_directory(dir);
+    }
+
+    /// MANIFEST 记录的编码：Checksum(4B) | Length(4B) | Payload
+    static std::string EncodeRecord(const std::string& payload) {
+        std::string record(kRecordHeaderSize, '\0');
+        encode_fixed32(&record[4], static_cast<uint32_t>(payload.size()));
+        record.append(payload);
+        encode_fixed32(&record[0], crc32c(record.data() + 4, 4 + payload.size()));
+        return record;
+    }
+
+    /// 向当前 MANIFEST 追加一条记录并 fsync
+    void WriteRecord(const std::string& payload) {
+        std::string record = EncodeRecord(payload);
+        if (std::fwrite(record.data(), 1, record.size(), manifest_) != record.size() ||
+            !SyncFile(manifest_)) {
+            throw std::runtime_error("Failed to write MANIFEST in " + dir_.string());
+        }
+        manifest_size_ += record.size();
+    }
+
+    static bool SyncFile(FILE* file) {
+        if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    static std::string ReadFile(const std::filesystem::path& path) {
+        FILE* file = std::fopen(path.string().c_str(), "rb");
+        if (file == nullptr) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+        std::string data;
+        char buf[64 * 1024];
+        size_t n;
+        while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) data.append(buf, n);
+        bool failed = std::ferror(file) != 0;
+        std::fclose(file);
+        if (failed) {
+            throw std::runtime_error("Failed to read " + path.string());
+        }
+        return data;
+    }
+};
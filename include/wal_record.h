@@ -5,25 +5,40 @@
 #include <cstdint>
 #include <cstring> // for memcpy
 
+#include <charconv>
+#include <string_view>
+
+#include "coding.h"
+#include "crc32c.h"
 
 /**
  * @brief 计算 CRC32 校验和（多项式 0xEDB88320，初值 0xFFFFFFFF，结果取反）。
  *
+ * 旧版本 WAL 记录与 SSTable 使用的校验算法，现仅用于读取旧格式文件。
+ * 实现为 Slicing-by-8 查表法，结果与逐 bit 计算完全一致。
+ * 新写入的数据统一使用 crc32c()（见 crc32c.h）。
+ *
  * @param data 待校验的数据起始地址。
  * @param length 待校验的数据长度（字节数）。
  * @return uint32_t CRC32 校验和。
  */
 inline uint32_t crc32(const char* data, size_t length) {
-    uint32_t crc = 0xFFFFFFFF;
-    for(size_t i = 0; i < length; i++) {
-        uint8_t byte = static_cast<uint8_t> (data[i]);
-        crc = crc ^ byte;
-        for(int j = 0; j < 8; j++) {
-            uint32_t mask = -(crc & 1);
-            crc = (crc >> 1) ^ (0xEDB88320 & mask);
-        }
-    }
-    return ~crc;
+    return ~crc_detail::extend_slicing8<0xEDB88320>(0xFFFFFFFF, data, length);
+}
+
+/**
+ * @brief 校验和算法类型（写入 WAL 记录的 Type 字节 / SSTable Footer 的格式版本中）
+ */
+enum class ChecksumType : uint8_t {
+    kCrc32 = 0,  ///< 旧格式：CRC32 (IEEE)
+    kCrc32c = 1  ///< 新格式：CRC32C (Castagnoli)，可使用硬件指令加速
+};
+
+/**
+ * @brief 按指定算法计算校验和
+ */
+inline uint32_t compute_checksum(ChecksumType type, const char* data, size_t length) {
+    return type == ChecksumType::kCrc32c ? crc32c(data, length) : crc32(data, length);
 }
 
 /**
@@ -31,12 +46,61 @@ inline uint32_t crc32(const char* data, size_t length) {
  *
  * - kPut: 写入/更新键值对
  * - kDelete: 删除键
+ * - kBatch: 原子批量写入，Value 为 WriteBatch 的二进制表示（Key 为空），
+ *   整批由同一个 Checksum 保护，重放时要么全部生效要么全部丢弃
  */
 enum class LogType : uint8_t {
     kPut = 0,
-    kDelete = 1
+    kDelete = 1,
+    kBatch = 2
+};
+
+/**
+ * @brief Type 字节的格式标志位
+ *
+ * Type 字节的低 5 位是 LogType，高 3 位是格式标志：
+ * - bit 7 (kLogTypeCrc32cFlag): Checksum 算法。0 = CRC32（旧格式），1 = CRC32C（默认）
+ * - bit 6 (kLogTypeBinaryKeyFlag): Key 编码。0 = 十进制文本（旧格式，如 "123"），
+ *   1 = 原始字节串（默认；int Key 即 encode_int_key 的 4 字节保序编码）
+ * - bit 5 (kLogTypeSequenceFlag): 1 = Value 之后附加 8 字节的序列号（见 encode_sequenced_log_record）
+ *
+ * 标志位保证旧 WAL 文件仍可被新版本重放。
+ */
+inline constexpr uint8_t kLogTypeCrc32cFlag = 0x80;
+inline constexpr uint8_t kLogTypeBinaryKeyFlag = 0x40;
+inline constexpr uint8_t kLogTypeSequenceFlag = 0x20;
+inline constexpr uint8_t kLogTypeMask = 0x1F;
+
+/**
+ * @brief WAL 中 Key 的编码方式
+ */
+enum class KeyEncoding : uint8_t {
+    kDecimal = 0, ///< 旧格式：int Key 的十进制文本
+    kBinary = 1   ///< 新格式：Key 的原始字节
 };
 
+/**
+ * @brief 把 WAL 中的 Key 还原为存储引擎使用的字节串 Key（不抛异常）
+ *
+ * - kBinary：Key 就是原始字节，*out 直接指向 key，不做任何拷贝或转换；
+ * - kDecimal：旧格式的十进制 int，转换为 encode_int_key 的编码后存入 scratch，*out 指向 scratch。
+ *
+ * @return false 如果旧格式的 Key 不是合法的十进制 int
+ */
+inline bool decode_log_key(std::string_view key, KeyEncoding encoding, std::string* scratch,
+                           std::string_view* out) {
+    if (encoding == KeyEncoding::kBinary) {
+        *out = key;
+        return true;
+    }
+    int value = 0;
+    auto [end, ec] = std::from_chars(key.data(), key.data() + key.size(), value);
+    if (ec != std::errc() || end != key.data() + key.size() || key.empty()) return false;
+    *scratch = encode_int_key(value);
+    *out = *scratch;
+    return true;
+}
+
 /**
  * @brief 一条 WAL 日志记录（逻辑层表示）。
  */
@@ -46,26 +110,43 @@ struct LogRecord {
     std::string value;
 };
 
+/// 日志记录 Header 长度：Checksum(4) + KeyLen(4) + ValueLen(4) + Type(1)
+inline constexpr size_t kLogRecordHeaderSize = 13;
+
+/// 带序列号的记录在 Value 之后附加的 Sequence 长度
+inline constexpr size_t kLogRecordSequenceSize = 8;
+
 /**
  * @brief 将一条日志记录编码为二进制字节序列。
  *
  * 编码格式（与 Learning_Manual 约定一致）：
  * - Checksum (4B) | KeyLen (4B) | ValueLen (4B) | Type (1B) | Key | Value
  *
- * 其中 Checksum 为对后续字段（从 KeyLen 起直到 Value 结束）的 CRC32：
- * - CRC32( KeyLen | ValueLen | Type | Key | Value )
+ * 其中 Checksum 为对后续字段（从 KeyLen 起直到 Value 结束）的校验和：
+ * - CRC32C( KeyLen | ValueLen | Type | Key | Value )，Type 最高位置 1
+ * - 或旧格式 CRC32( ... )，Type 最高位为 0
+ *
+ * 直接从 key / value 的视图编码，调用者的数据只被拷贝一次（进入返回的缓冲区）。
  *
- * @param record 待编码的日志记录。
+ * @param type 记录类型
+ * @param key 键的原始字节
+ * @param value 值
+ * @param checksum 校验和算法，默认 CRC32C；kCrc32 仅用于兼容性测试与旧格式工具。
+ * @param key_encoding key 的编码方式（写入 Type 字节的 bit 6），
+ *        默认 kBinary；kDecimal 仅用于兼容性测试与旧格式工具。
  * @return std::string 编码后的字节序列（可直接写入 WAL 文件）。
  */
-inline std::string encode_log_record(const LogRecord& record) {
-    uint32_t key_len = static_cast<uint32_t> (record.key.size());
-    uint32_t value_len = static_cast<uint32_t> (record.value.size());
+inline std::string encode_log_record(LogType type, std::string_view key, std::string_view value,
+                                     ChecksumType checksum = ChecksumType::kCrc32c,
+                                     KeyEncoding key_encoding = KeyEncoding::kBinary) {
+    uint32_t key_len = static_cast<uint32_t> (key.size());
+    uint32_t value_len = static_cast<uint32_t> (value.size());
 
     uint32_t total_len = 4 + 4 + 4 + 1 + key_len + value_len;
 
     std::string buffer;
-    buffer.resize(total_len);
+    buffer.reserve(total_len);
+    buffer.resize(kLogRecordHeaderSize);
     char* ptr = buffer.data();
 
     ptr += 4;
@@ -76,22 +157,70 @@ inline std::string encode_log_record(const LogRecord& record) {
     memcpy(ptr, &value_len, sizeof(uint32_t));
     ptr += sizeof(uint32_t);
 
-    uint8_t type_val = static_cast<uint8_t> (record.type);
+    uint8_t type_val = static_cast<uint8_t> (type);
+    if(checksum == ChecksumType::kCrc32c) {
+        type_val |= kLogTypeCrc32cFlag;
+    }
+    if(key_encoding == KeyEncoding::kBinary) {
+        type_val |= kLogTypeBinaryKeyFlag;
+    }
     memcpy(ptr, &type_val, sizeof(uint8_t));
-    ptr += sizeof(uint8_t);
 
-    if(key_len > 0) {
-        memcpy(ptr, record.key.data(), key_len);
-        ptr += key_len;
-    }
+    buffer.append(key.data(), key_len);
+    buffer.append(value.data(), value_len);
 
-    if(value_len > 0) {
-        memcpy(ptr, record.value.data(), value_len);
-        ptr += value_len;
-    }
+    uint32_t crc = compute_checksum(checksum, buffer.data() + 4, total_len - 4);
+    memcpy(buffer.data(), &crc, sizeof(uint32_t));
 
-    uint32_t checksum = crc32(buffer.data() + 4, total_len - 4);
-    memcpy(buffer.data(), &checksum, sizeof(uint32_t));
+    return buffer;
+}
 
+/**
+ * @brief 将一条日志记录编码为二进制字节序列（格式与参数含义同上）
+ */
+inline std::string encode_log_record(const LogRecord& record,
+                                     ChecksumType checksum = ChecksumType::kCrc32c,
+                                     KeyEncoding key_encoding = KeyEncoding::kBinary) {
+    return encode_log_record(record.type, record.key, record.value, checksum, key_encoding);
+}
+
+/**
+ * @brief 编码一条带序列号的日志记录（CRC32C、原始字节 Key），序列号暂不填写
+ *
+ * 编码格式：
+ * - Checksum (4B) | KeyLen (4B) | ValueLen (4B) | Type (1B) | Key | Value | Sequence (8B)
+ *
+ * Type 的 bit 5 置 1；Sequence 是该记录第一个操作的序列号（kBatch 的第 i 个操作为 Sequence + i）。
+ *
+ * 序列号由 Leader 在组提交时才分配，而编码在锁外完成：返回的记录中 Sequence 为 0，
+ * Checksum 字段暂存不含 Sequence 的部分校验和，必须经 seal_log_record() 填入序列号后才能写入 WAL。
+ * 把 Sequence 放在末尾使得封口只需对 8 字节继续累加 CRC32C，不必重新校验整条记录。
+ */
+inline std::string encode_sequenced_log_record(LogType type, std::string_view key, std::string_view value) {
+    uint32_t key_len = static_cast<uint32_t>(key.size());
+    uint32_t value_len = static_cast<uint32_t>(value.size());
+
+    std::string buffer;
+    buffer.reserve(kLogRecordHeaderSize + key.size() + value.size() + kLogRecordSequenceSize);
+    buffer.resize(kLogRecordHeaderSize);
+    encode_fixed32(buffer.data() + 4, key_len);
+    encode_fixed32(buffer.data() + 8, value_len);
+    buffer[12] = static_cast<char>(static_cast<uint8_t>(type) | kLogTypeCrc32cFlag |
+                                   kLogTypeBinaryKeyFlag | kLogTypeSequenceFlag);
+    buffer.append(key.data(), key.size());
+    buffer.append(value.data(), value.size());
+
+    encode_fixed32(buffer.data(), crc32c(buffer.data() + 4, buffer.size() - 4));
+    buffer.append(kLogRecordSequenceSize, '\0');
     return buffer;
 }
+
+/**
+ * @brief 为 encode_sequenced_log_record() 编码的记录填入序列号并补全 Checksum（只能调用一次）
+ */
+inline void seal_log_record(std::string* record, uint64_t sequence) {
+    char* trailer = record->data() + record->size() - kLogRecordSequenceSize;
+    encode_fixed64(trailer, sequence);
+    encode_fixed32(record->data(), crc32c_extend(decode_fixed32(record->data()), trailer,
+                                                 kLogRecordSequenceSize));
+}
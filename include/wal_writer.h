@@ -0,0 +1,347 @@
+#pragma once
+#define _CRT_SECURE_NO_WARNINGS // 禁用 fopen 等不安全警告
+
+#include "wal_record.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// 平台兼容性处理：Windows 走 stdio + _commit，POSIX 直接使用文件描述符
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief WalWriter 的选项
+ */
+struct WalWriterOptions {
+    /**
+     * @brief 打开时把文件预分配到的大小（字节），0 表示不预分配
+     *
+     * 预分配后追加写入不再改变文件大小，fdatasync 无需提交 inode 的大小变化；
+     * 预分配区域读出为全零，WalReader 把全零的 Header 视为日志结尾。
+     */
+    uint64_t preallocate_size = 0;
+
+    /// 以 O_DIRECT 打开（仅 Linux；文件系统不支持时退回普通写入，见 WalWriter::direct_io()）
+    bool direct_io = false;
+};
+
+/**
+ * @brief 一个 WAL 段的顺序写入器
+ *
+ * 与 stdio 的 fopen("ab") + fwrite + fflush 相比：
+ * 1. **无用户态缓冲**：每次 append() 直接 pwrite 到记录末尾的偏移，少一次内存拷贝，
+ *    也不需要 fflush。
+ * 2. **预分配**：新文件打开时用 fallocate 分配 preallocate_size 字节，之后 sync() 只需 fdatasync。
+ * 3. **复用**：reuse 模式打开一个已落盘的旧段，从偏移 0 覆盖写入，不再分配新的块。
+ *    每次写入都在数据后附带一个全零的 Header 作为结束标记（由下一次写入覆盖），
+ *    重放时不会把旧段残留的记录当作新数据。
+ * 4. **O_DIRECT**（可选）：写入经 4KB 对齐的缓冲区以整块为单位落盘，绕过 Page Cache，
+ *    避免 WAL 与 SSTable 争用缓存；未写满的尾块以零填充，下次写入时整块重写。
+ *
+ * 析构或 close(true) 时把文件截断到实际写入的长度，正常关闭的目录中不残留预分配的零。
+ *
+ * @note append() 只能由一个线程调用；sync() 可以与 append() 并发（只作用于文件描述符）。
+ */
+class WalWriter {
+public:
+    /// O_DIRECT 要求的缓冲区地址、文件偏移与写入长度的对齐单位
+    static constexpr size_t kDirectIoAlignment = 4096;
+
+    /**
+     * @brief 打开一个 WAL 段
+     *
+     * @param path 文件路径（不存在时创建）
+     * @param offset 从该偏移开始追加（重放后有效记录的末尾）；非 reuse 模式下其后的内容被截断
+     * @param reuse 复用旧段：从 offset 覆盖写入，不截断、不预分配，并立即在 offset 处写入结束标记
+     * @param options 预分配与 O_DIRECT 选项
+     * @throw std::runtime_error 文件无法打开或预分配失败
+     */
+    WalWriter(const std::filesystem::path& path, uint64_t offset, bool reuse,
+              const WalWriterOptions& options = {})
+        : path_(path.string())
+        , size_(offset)
+        , reuse_(reuse)
+        , preallocate_size_(reuse ? 0 : options.preallocate_size) {
+#ifdef _WIN32
+        file_ = std::fopen(path_.c_str(), std::filesystem::exists(path) ? "r+b" : "w+b");
+        if (!file_) throw std::runtime_error("Failed to open WAL file: " + path_);
+        if (!reuse_) {
+            if (_chsize_s(_fileno(file_), static_cast<__int64>(size_)) != 0 ||
+                (options.preallocate_size > size_ &&
+                 _chsize_s(_fileno(file_), static_cast<__int64>(options.preallocate_size)) != 0)) {
+                throw std::runtime_error("Failed to preallocate WAL file: " + path_);
+            }
+        }
+#else
+        fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) throw_errno("Failed to open WAL file");
+        if (!reuse_) {
+            if (::ftruncate(fd_, static_cast<off_t>(size_)) != 0) throw_errno("Failed to truncate WAL file");
+            if (options.preallocate_size > size_) preallocate(options.preallocate_size);
+        }
+        if (options.direct_io) open_direct();
+#endif
+        // 复用段开头仍是旧记录：先写结束标记，尚未写入任何记录时崩溃也不会重放它们
+        if (reuse_) append({});
+    }
+
+    ~WalWriter() {
+        try {
+            close(/*truncate=*/true);
+        } catch (...) {
+        }
+    }
+
+    WalWriter(const WalWriter&) = delete;
+    WalWriter& operator=(const WalWriter&) = delete;
+
+    /// 已写入的有效字节数（下一条记录的偏移）
+    uint64_t size() const { return size_; }
+
+    /// 是否复用了旧段
+    bool reused() const { return reuse_; }
+
+    /// 是否真正以 O_DIRECT 写入
+    bool direct_io() const { return direct_io_; }
+
+    /**
+     * @brief 在有效数据末尾写入 data（不保证落盘，见 sync()）
+     *
+     * @throw std::runtime_error 写入失败
+     */
+    void append(std::string_view data) {
+        size_t terminator = reuse_ ? kLogRecordHeaderSize : 0;
+#ifdef _WIN32
+        std::string buffer(data);
+        buffer.append(terminator, '\0');
+        if (_fseeki64(file_, static_cast<__int64>(size_), SEEK_SET) != 0 ||
+            std::fwrite(buffer.data(), 1, buffer.size(), file_) != buffer.size() ||
+            std::fflush(file_) != 0) {
+            throw std::runtime_error("Failed to write to WAL file: " + path_);
+        }
+#else
+        if (direct_io_) {
+            append_direct(data, terminator);
+        } else if (terminator == 0) {
+            write_at(data.data(), data.size(), size_);
+        } else {
+            std::string buffer;
+            buffer.reserve(data.size() + terminator);
+            buffer.append(data.data(), data.size());
+            buffer.append(terminator, '\0');
+            write_at(buffer.data(), buffer.size(), size_);
+        }
+#endif
+        size_ += data.size();
+    }
+
+    /**
+     * @brief 把已写入的数据刷入物理磁盘（fdatasync / _commit）
+     *
+     * @throw std::runtime_error 同步失败
+     */
+    void sync() {
+#ifdef _WIN32
+        // Windows: _commit 强制将句柄关联的缓冲区刷入磁盘
+        if (_commit(_fileno(file_)) != 0) {
+            throw std::runtime_error("WAL commit failed");
+        }
+#elif defined(__APPLE__)
+        if (::fsync(fd_) != 0) {
+            throw std::runtime_error("WAL sync (fsync) failed");
+        }
+#else
+        // 预分配后文件大小不变，fdatasync 只需写回数据块
+        if (::fdatasync(fd_) != 0) {
+            throw std::runtime_error("WAL sync (fdatasync) failed");
+        }
+#endif
+    }
+
+    /**
+     * @brief 丢弃 offset 之后的全部内容，下一次 append() 从 offset 写入
+     *
+     * 用于 Raft 日志在与 Leader 冲突时截断后缀。截断后按原先的 preallocate_size 重新预分配，
+     * 被丢弃的区域读出为全零。可以与 sync() 并发，但不能与 append() 并发。
+     *
+     * @param offset 新的有效长度（不超过 size()）
+     * @throw std::runtime_error 截断失败，或以 O_DIRECT 写入（不支持截断）
+     */
+    void truncate(uint64_t offset) {
+        if (offset > size_) throw std::runtime_error("WAL truncate beyond end: " + path_);
+#ifdef _WIN32
+        if (_chsize_s(_fileno(file_), static_cast<__int64>(offset)) != 0 ||
+            (preallocate_size_ > offset &&
+             _chsize_s(_fileno(file_), static_cast<__int64>(preallocate_size_)) != 0)) {
+            throw std::runtime_error("Failed to truncate WAL file: " + path_);
+        }
+#else
+        if (direct_io_) throw std::runtime_error("WAL truncate is not supported with O_DIRECT: " + path_);
+        if (::ftruncate(fd_, static_cast<off_t>(offset)) != 0) throw_errno("Failed to truncate WAL file");
+        if (preallocate_size_ > offset) preallocate(preallocate_size_);
+#endif
+        size_ = offset;
+        if (reuse_) append({});
+    }
+
+    /**
+     * @brief 关闭文件（可重复调用）
+     *
+     * @param truncate 为 true 时先截断到 size()，去掉预分配的零与复用段的残留记录
+     */
+    void close(bool truncate) {
+#ifdef _WIN32
+        if (!file_) return;
+        if (truncate) _chsize_s(_fileno(file_), static_cast<__int64>(size_));
+        std::fclose(file_);
+        file_ = nullptr;
+#else
+        if (fd_ < 0) return;
+        int rc = truncate ? ::ftruncate(fd_, static_cast<off_t>(size_)) : 0;
+        ::close(fd_);
+        fd_ = -1;
+        if (rc != 0) throw_errno("Failed to truncate WAL file");
+#endif
+    }
+
+private:
+    std::string path_;
+    uint64_t size_;
+    bool reuse_;
+    uint64_t preallocate_size_;
+    bool direct_io_ = false;
+#ifdef _WIN32
+    FILE* file_ = nullptr;
+#else
+    int fd_ = -1;
+
+    /// O_DIRECT 写入用的对齐缓冲区：开头保存未写满的尾块 [tail_offset_, size_)
+    struct AlignedDeleter {
+        void operator()(char* p) const { std::free(p); }
+    };
+    std::unique_ptr<char, AlignedDeleter> aligned_;
+    size_t aligned_capacity_ = 0;
+
+    [[noreturn]] void throw_errno(const char* what) const {
+        throw std::runtime_error(std::string(what) + ": " + path_ + " (" + std::strerror(errno) + ")");
+    }
+
+    static uint64_t align_down(uint64_t n) { return n & ~static_cast<uint64_t>(kDirectIoAlignment - 1); }
+    static uint64_t align_up(uint64_t n) { return align_down(n + kDirectIoAlignment - 1); }
+
+    void preallocate(uint64_t size) {
+#ifdef __linux__
+        // 不带 FALLOC_FL_KEEP_SIZE：文件大小一次到位，之后的写入不修改 inode 大小
+        if (::fallocate(fd_, 0, 0, static_cast<off_t>(size)) == 0) return;
+        if (errno != EOPNOTSUPP && errno != ENOSYS) throw_errno("Failed to preallocate WAL file");
+#endif
+        // 不支持 fallocate 的文件系统：退化为扩展文件大小（稀疏文件），同样读出为零
+        if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) throw_errno("Failed to preallocate WAL file");
+    }
+
+    void write_at(const char* data, size_t n, uint64_t offset) {
+        while (n > 0) {
+            ssize_t written = ::pwrite(fd_, data, n, static_cast<off_t>(offset));
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw_errno("Failed to write to WAL file");
+            }
+            data += written;
+            n -= static_cast<size_t>(written);
+            offset += static_cast<uint64_t>(written);
+        }
+    }
+
+    void reserve_aligned(size_t capacity) {
+        if (capacity <= aligned_capacity_) return;
+        capacity = static_cast<size_t>(align_up(std::max(capacity, 2 * aligned_capacity_)));
+        void* p = nullptr;
+        if (::posix_memalign(&p, kDirectIoAlignment, capacity) != 0) throw std::bad_alloc();
+        if (aligned_) std::memcpy(p, aligned_.get(), aligned_capacity_);
+        aligned_.reset(static_cast<char*>(p));
+        aligned_capacity_ = capacity;
+    }
+
+    /**
+     * @brief 切换到 O_DIRECT：先用普通读取载入未写满的尾块，再以 O_DIRECT 重新打开
+     */
+    void open_direct() {
+#ifdef O_DIRECT
+        uint64_t tail_offset = align_down(size_);
+        size_t tail = static_cast<size_t>(size_ - tail_offset);
+        reserve_aligned(kDirectIoAlignment * 16);
+        if (tail > 0 && ::pread(fd_, aligned_.get(), tail, static_cast<off_t>(tail_offset)) !=
+                            static_cast<ssize_t>(tail)) {
+            throw_errno("Failed to read WAL tail");
+        }
+        int direct = ::open(path_.c_str(), O_WRONLY | O_DIRECT);
+        if (direct < 0) {
+            if (errno == EINVAL) return;  // 文件系统不支持 O_DIRECT（如 tmpfs），保持普通写入
+            throw_errno("Failed to open WAL file with O_DIRECT");
+        }
+        ::close(fd_);
+        fd_ = direct;
+        direct_io_ = true;
+#endif
+    }
+
+    /**
+     * @brief O_DIRECT 写入：尾块 + data + 结束标记，零填充到整块后从尾块起点写出
+     */
+    void append_direct(std::string_view data, size_t terminator) {
+        uint64_t tail_offset = align_down(size_);
+        size_t tail = static_cast<size_t>(size_ - tail_offset);
+        size_t used = tail + data.size();
+        size_t padded = static_cast<size_t>(align_up(used + terminator));
+        reserve_aligned(padded);
+        char* buf = aligned_.get();
+        std::memcpy(buf + tail, data.data(), data.size());
+        std::memset(buf + used, 0, padded - used);
+        write_at(buf, padded, tail_offset);
+
+        // 新的尾块移到缓冲区开头，供下一次写入整块重写
+        size_t keep_from = static_cast<size_t>(align_down(used));
+        std::memmove(buf, buf + keep_from, used - keep_from);
+    }
+#endif
+};
+
+/**
+ * @brief fsync 目录，使其中新建、改名、删除的目录项持久化
+ *
+ * "写临时文件 → fsync → rename" 之后调用，保证崩溃后看到的是改名后的文件。
+ * Windows 不支持对目录 fsync，直接返回。
+ *
+ * @throw std::runtime_error 打开或同步目录失败
+ */
+inline void sync_directory(const std::filesystem::path& dir) {
+#ifndef _WIN32
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open directory " + dir.string() + ": " + std::strerror(errno));
+    }
+    int rc = ::fsync(fd);
+    ::close(fd);
+    if (rc != 0) {
+        throw std::runtime_error("Failed to sync directory " + dir.string());
+    }
+#else
+    (void)dir;
+#endif
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "coding.h"
+#include "wal_record.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief 原子批量写入：收集多个 Put/Delete，作为一条 WAL 记录整体落盘
+ *
+ * 内部表示 rep_ 直接就是 WAL 中 kBatch 记录的 Value 部分，避免二次编码：
+ * +-----------+---------------------------------------------------------+
+ * | Count(4B) | Op 1 | Op 2 | ... | Op N                                |
+ * +-----------+---------------------------------------------------------+
+ *
+ * 每个 Op 的编码：
+ * +---------+------------+--------------+-----+-------+
+ * | Type(1B)| KeyLen(4B) | ValueLen(4B) | Key | Value |
+ * +---------+------------+--------------+-----+-------+
+ *
+ * Key 为原始字节串（与单条 WAL 记录一致）；int 重载使用 encode_int_key 的 4 字节编码。
+ *
+ * 整个 rep_ 被封装进一条 LogRecord{kBatch, "", rep_}，由同一个 Checksum 保护，
+ * 因此重放时要么整批生效，要么整批丢弃（All-or-Nothing）。
+ *
+ * @note 本类非线程安全；提交给 KVStore::write 后可以复用（调用 clear()）。
+ */
+class WriteBatch {
+public:
+    WriteBatch() { clear(); }
+
+    /**
+     * @brief 追加一次写入
+     * @param key 键（任意字节串）
+     * @param value 值
+     */
+    void put(std::string_view key, std::string_view value) {
+        append_op(LogType::kPut, key, value);
+    }
+
+    /// int Key 的便捷重载，等价于 put(encode_int_key(key), value)
+    void put(int key, std::string_view value) { put(encode_int_key(key), value); }
+
+    /**
+     * @brief 追加一次删除
+     * @param key 键（任意字节串）
+     */
+    void del(std::string_view key) {
+        append_op(LogType::kDelete, key, std::string_view());
+    }
+
+    /// int Key 的便捷重载，等价于 del(encode_int_key(key))
+    void del(int key) { del(encode_int_key(key)); }
+
+    /// 清空批次，恢复到只有 Count=0 头部的状态
+    void clear() {
+        rep_.assign(kHeaderSize, '\0');
+        count_ = 0;
+    }
+
+    /// 批次中的操作数
+    uint32_t count() const { return count_; }
+
+    bool empty() const { return count_ == 0; }
+
+    /// 编码后的批次大小（字节），可用于控制单批上限
+    size_t byte_size() const { return rep_.size(); }
+
+    /// 批次的二进制表示（即 kBatch 记录的 Value）
+    const std::string& rep() const { return rep_; }
+
+    /**
+     * @brief 按追加顺序遍历批次中的每个操作
+     *
+     * @tparam Handler 可调用对象，签名为 void(LogType type, std::string_view key, std::string_view value)
+     * @return false 若 rep_ 结构损坏（长度越界 / 类型非法 / key 无法解析）
+     */
+    template <typename Handler>
+    bool iterate(Handler&& handler) const {
+        return iterate_rep(rep_, handler);
+    }
+
+    /**
+     * @brief 校验一段 kBatch 负载的结构合法性（不应用任何操作）
+     *
+     * replay_wal 在应用批次之前先完整校验一遍，保证“要么全部应用，要么全部跳过”。
+     */
+    static bool validate(std::string_view rep, KeyEncoding encoding = KeyEncoding::kBinary) {
+        return iterate_rep(rep, [](LogType, std::string_view, std::string_view) {}, encoding);
+    }
+
+    /**
+     * @brief 解析并遍历一段 kBatch 负载
+     *
+     * @tparam Handler 签名为 void(LogType type, std::string_view key, std::string_view value)
+     * @param encoding Key 编码方式；旧版本 WAL 中的批次为十进制文本 Key，
+     *        会被转换为 encode_int_key 的编码后再交给 handler
+     * @return false 若结构损坏；此时 handler 可能已被调用了部分次数，
+     *         调用者应先用 validate() 校验再应用。
+     */
+    template <typename Handler>
+    static bool iterate_rep(std::string_view rep, Handler&& handler,
+                            KeyEncoding encoding = KeyEncoding::kBinary) {
+        if (rep.size() < kHeaderSize) return false;
+        uint32_t count = 0;
+        std::memcpy(&count, rep.data(), sizeof(uint32_t));
+
+        size_t pos = kHeaderSize;
+        std::string scratch;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (rep.size() - pos < kOpHeaderSize) return false;
+            uint8_t type_u8 = static_cast<uint8_t>(rep[pos]);
+            uint32_t key_len = 0;
+            uint32_t value_len = 0;
+            std::memcpy(&key_len, rep.data() + pos + 1, sizeof(uint32_t));
+            std::memcpy(&value_len, rep.data() + pos + 5, sizeof(uint32_t));
+            pos += kOpHeaderSize;
+
+            if (rep.size() - pos < static_cast<uint64_t>(key_len) + value_len) return false;
+            std::string_view key(rep.data() + pos, key_len);
+            std::string_view value(rep.data() + pos + key_len, value_len);
+            pos += static_cast<size_t>(key_len) + value_len;
+
+            LogType type = static_cast<LogType>(type_u8);
+            if (type != LogType::kPut && type != LogType::kDelete) return false;
+
+            std::string_view decoded;
+            if (!decode_log_key(key, encoding, &scratch, &decoded)) return false;
+
+            handler(type, decoded, value);
+        }
+        return pos == rep.size();
+    }
+
+private:
+    static constexpr size_t kHeaderSize = 4;          ///< Count(4B)
+    static constexpr size_t kOpHeaderSize = 1 + 4 + 4; ///< Type + KeyLen + ValueLen
+
+    std::string rep_;
+    uint32_t count_ = 0;
+
+    void append_op(LogType type, std::string_view key, std::string_view value) {
+        uint32_t key_len = static_cast<uint32_t>(key.size());
+        uint32_t value_len = static_cast<uint32_t>(value.size());
+        uint8_t type_val = static_cast<uint8_t>(type);
+
+        rep_.append(reinterpret_cast<const char*>(&type_val), sizeof(uint8_t));
+        rep_.append(reinterpret_cast<const char*>(&key_len), sizeof(uint32_t));
+        rep_.append(reinterpret_cast<const char*>(&value_len), sizeof(uint32_t));
+        rep_.append(key);
+        rep_.append(value);
+
+        ++count_;
+        std::memcpy(rep_.data(), &count_, sizeof(uint32_t));
+    }
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief 写入减速 (slowdown) 的令牌桶
+ *
+ * 后台落盘 / Compaction 跟不上写入时，KVStore 按压力算出一个允许的写入速率（字节/秒），
+ * 每批写入先向本类申请配额：令牌按当前速率持续补充，桶容量为 kBurst 时长的配额，
+ * 不足时返回需要等待的时长，由调用者在不持有锁的情况下睡眠。
+ * 与 RateLimiter 的区别是速率随每次申请变化（压力越大速率越低），且本类只计算、不睡眠。
+ *
+ * 每批写入按其字节数等待，延迟被均匀摊到每一批上，而不是积压到硬限制后一次停顿数秒。
+ *
+ * @note 本类不是线程安全的：KVStore 只在写入 Leader 上调用（同一时刻只有一个 Leader）。
+ */
+class WriteController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// 桶容量对应的时长：速率为 R 时最多攒下 R * kBurst 字节的配额
+    static constexpr std::chrono::milliseconds kBurst{1};
+
+    /**
+     * @brief 以 bytes_per_sec 的速率放行 bytes 字节
+     *
+     * @param bytes_per_sec 本次的允许速率（> 0）
+     * @param now 当前时间（测试可指定）
+     * @return 调用者需要等待的时长；配额足够时为 0
+     */
+    std::chrono::nanoseconds GetDelay(uint64_t bytes, uint64_t bytes_per_sec, Clock::time_point now = Clock::now()) {
+        double rate = static_cast<double>(std::max<uint64_t>(bytes_per_sec, 1));
+        double burst = rate * std::chrono::duration<double>(kBurst).count();
+        if (!started_) {
+            started_ = true;
+            tokens_ = burst;
+        } else if (now > last_refill_) {
+            double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+            tokens_ = std::min(burst, tokens_ + elapsed * rate);
+        }
+        last_refill_ = std::max(last_refill_, now);
+
+        // 令牌可以透支为负：等待结束时恰好补回，下一批写入在此基础上继续计算
+        tokens_ -= static_cast<double>(bytes);
+        if (tokens_ >= 0) return std::chrono::nanoseconds(0);
+        return std::chrono::nanoseconds(static_cast<int64_t>(-tokens_ * 1e9 / rate));
+    }
+
+private:
+    bool started_ = false;
+    double tokens_ = 0.0;
+    Clock::time_point last_refill_;
+};
@@ -0,0 +1,179 @@
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include <pthread.h>
+
+#include "kv_server.h"
+#include "kv_store.h"
+#include "raft_node.h"
+#include "raft_socket_transport.h"
+
+static std::string get_arg_value(int argc, char** argv, const std::string& key,
+                                 const std::string& default_value) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (key == argv[i]) {
+            return argv[i + 1];
+        }
+    }
+    return default_value;
+}
+
+static bool parse_sync_mode(const std::string& name, WalSyncMode* mode) {
+    if (name == "per-write") {
+        *mode = WalSyncMode::kPerWrite;
+    } else if (name == "group") {
+        *mode = WalSyncMode::kGroupCommit;
+    } else if (name == "periodic") {
+        *mode = WalSyncMode::kPeriodic;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/// Raft 成员的 Raft 端口地址
+struct RaftPeerAddress {
+    std::string host;
+    uint16_t port = 0;
+};
+
+/// 解析 "1=10.0.0.1:7400,2=10.0.0.2:7400,..."
+static bool parse_raft_peers(const std::string& spec, std::map<uint64_t, RaftPeerAddress>* peers) {
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t eq = item.find('=');
+        size_t colon = item.rfind(':');
+        if (eq == std::string::npos || colon == std::string::npos || colon < eq) return false;
+        try {
+            uint64_t id = std::stoull(item.substr(0, eq));
+            unsigned long port = std::stoul(item.substr(colon + 1));
+            if (id == 0 || port == 0 || port > 65535) return false;
+            if (!peers->emplace(id, RaftPeerAddress{item.substr(eq + 1, colon - eq - 1), static_cast<uint16_t>(port)})
+                     .second) {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return !peers->empty();
+}
+
+static void print_usage(const char* prog) {
+    std::cout
+        << "Usage: " << prog << " [--data DIR] [--host ADDR] [--port PORT] [--threads N] [--sync MODE]\n"
+        << "       [--raft-id N --raft-peers ID=HOST:PORT,...]\n"
+        << "  --data     data directory (default: ./data)\n"
+        << "  --host     listen address (default: 0.0.0.0)\n"
+        << "  --port     listen port (default: 7379)\n"
+        << "  --threads  reactor threads (default: 4)\n"
+        << "  --sync     WAL sync mode: per-write | group | periodic (default: group; periodic with Raft)\n"
+        << "  --raft-id     run as member N of a Raft group (clients must talk to the leader)\n"
+        << "  --raft-peers  Raft ports of all members, including this one (whose port is listened on)\n";
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--help" || std::string(argv[i]) == "-h") {
+            print_usage(argv[0]);
+            return 0;
+        }
+    }
+
+    KVStoreOptions store_options;
+    ServerOptions server_options;
+    uint64_t raft_id = 0;
+    std::map<uint64_t, RaftPeerAddress> raft_peers;
+    try {
+        server_options.host = get_arg_value(argc, argv, "--host", "0.0.0.0");
+        server_options.port = static_cast<uint16_t>(std::stoul(get_arg_value(argc, argv, "--port", "7379")));
+        server_options.reactor_threads = std::stoul(get_arg_value(argc, argv, "--threads", "4"));
+        raft_id = std::stoull(get_arg_value(argc, argv, "--raft-id", "0"));
+    } catch (const std::exception&) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    // raft.log 已在应答前 fsync，Raft 模式下状态机默认不再逐次 fsync（见 RaftOptions）
+    if (!parse_sync_mode(get_arg_value(argc, argv, "--sync", raft_id != 0 ? "periodic" : "group"),
+                         &store_options.sync_mode)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    if (raft_id != 0 && (!parse_raft_peers(get_arg_value(argc, argv, "--raft-peers", ""), &raft_peers) ||
+                         raft_peers.count(raft_id) == 0)) {
+        std::cerr << "[KVServer] --raft-peers must list every member as ID=HOST:PORT, including --raft-id"
+                  << std::endl;
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    // 在创建任何线程之前屏蔽 SIGINT / SIGTERM：所有线程继承该屏蔽字，信号只由主线程的 sigwait 接收
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    try {
+        std::string data_dir = get_arg_value(argc, argv, "--data", "./data");
+        std::unique_ptr<KVStore> store;
+        std::unique_ptr<SocketRaftTransport> transport;
+        std::unique_ptr<RaftNode> node;
+        std::unique_ptr<RaftService> service;
+        std::unique_ptr<KVServer> server;
+        if (raft_id == 0) {
+            store = std::make_unique<KVStore>(data_dir, store_options);
+            server = std::make_unique<KVServer>(*store, server_options);
+        } else {
+            RaftSocketOptions raft_socket_options;
+            raft_socket_options.host = server_options.host;
+            raft_socket_options.port = raft_peers[raft_id].port;
+            transport = std::make_unique<SocketRaftTransport>(raft_socket_options);
+            RaftOptions raft_options;
+            raft_options.id = raft_id;
+            raft_options.store_options = store_options;
+            for (const auto& [id, address] : raft_peers) {
+                raft_options.peers.push_back(id);
+                if (id != raft_id) transport->add_peer(id, address.host, address.port);
+            }
+            transport->start();
+            node = std::make_unique<RaftNode>(data_dir, raft_options, *transport);
+            service = std::make_unique<RaftService>(*node);
+            server = std::make_unique<KVServer>(*service, server_options);
+            std::cout << "[KVServer] Raft member " << raft_id << " of " << raft_peers.size()
+                      << ", Raft port " << transport->port() << std::endl;
+        }
+        server->start();
+        std::cout << "[KVServer] Listening on " << server_options.host << ":" << server->port() << " with "
+                  << server_options.reactor_threads << " reactor threads" << std::endl;
+
+        int signal = 0;
+        sigwait(&signals, &signal);
+        std::cout << "[KVServer] Received signal " << signal << ", shutting down" << std::endl;
+
+        ServerStats stats = server->stats();
+        server->stop();
+        std::cout << "[KVServer] " << stats.connections << " connections, " << stats.requests << " requests, "
+                  << stats.write_batches << " write batches (avg " << stats.avg_batch_size() << " writes)";
+        if (store) {
+            WalStats wal = store->wal_stats();
+            std::cout << ", " << wal.syncs << " WAL syncs (avg group " << wal.avg_group_size() << ")" << std::endl;
+        } else {
+            RaftStats raft = node->stats();
+            std::cout << ", " << raft.proposals << " Raft proposals, " << raft.log_syncs << " raft.log syncs, "
+                      << transport->dropped() << " dropped Raft messages" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[KVServer] " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
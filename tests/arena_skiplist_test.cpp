@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include "arena.h"
+#include "arena_skiplist.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct IntComparator {
+        int operator()(uint64_t a, uint64_t b) const { return a < b ? -1 : (a > b ? 1 : 0); }
+    };
+
+    /// 按 Key 的高 32 位比较，低 32 位作为“值”，用于验证 InsertOrAssign 的替换语义
+    struct HighBitsComparator {
+        int operator()(uint64_t a, uint64_t b) const {
+            return IntComparator()(a >> 32, b >> 32);
+        }
+    };
+
+    using IntList = ArenaSkipList<uint64_t, IntComparator>;
+}
+
+/**
+ * @brief 空表：Contains 为 false，迭代器无效
+ */
+TEST(ArenaSkipListTest, Empty) {
+    Arena arena;
+    IntList list(IntComparator(), &arena);
+    EXPECT_TRUE(list.Empty());
+    EXPECT_FALSE(list.Contains(10));
+
+    IntList::Iterator it(&list);
+    it.SeekToFirst();
+    EXPECT_FALSE(it.Valid());
+    it.Seek(100);
+    EXPECT_FALSE(it.Valid());
+}
+
+/**
+ * @brief 随机插入后与 std::set 对照：Contains、有序遍历与 Seek 结果一致
+ */
+TEST(ArenaSkipListTest, MatchesStdSet) {
+    Arena arena;
+    IntList list(IntComparator(), &arena);
+    std::set<uint64_t> expected;
+    std::mt19937_64 rng(1000);
+    for (int i = 0; i < 5000; ++i) {
+        uint64_t key = rng() % 4000;
+        EXPECT_EQ(list.InsertOrAssign(key), expected.insert(key).second);
+    }
+    EXPECT_EQ(list.Size(), expected.size());
+
+    for (uint64_t key = 0; key < 4000; ++key) {
+        ASSERT_EQ(list.Contains(key), expected.count(key) == 1) << key;
+    }
+
+    IntList::Iterator it(&list);
+    it.SeekToFirst();
+    for (uint64_t key : expected) {
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), key);
+        it.Next();
+    }
+    EXPECT_FALSE(it.Valid());
+
+    for (uint64_t target : {uint64_t{0}, uint64_t{1}, uint64_t{1999}, uint64_t{3999}, uint64_t{5000}}) {
+        it.Seek(target);
+        auto expect_it = expected.lower_bound(target);
+        if (expect_it == expected.end()) {
+            EXPECT_FALSE(it.Valid());
+        } else {
+            ASSERT_TRUE(it.Valid());
+            EXPECT_EQ(it.key(), *expect_it);
+        }
+    }
+}
+
+/**
+ * @brief 相等的 Key 替换已有节点，不新增节点、不改变顺序
+ */
+TEST(ArenaSkipListTest, InsertOrAssignReplacesEqualKey) {
+    Arena arena;
+    ArenaSkipList<uint64_t, HighBitsComparator> list(HighBitsComparator(), &arena);
+    EXPECT_TRUE(list.InsertOrAssign((uint64_t{2} << 32) | 1));
+    EXPECT_TRUE(list.InsertOrAssign((uint64_t{1} << 32) | 1));
+    EXPECT_FALSE(list.InsertOrAssign((uint64_t{2} << 32) | 7));
+    EXPECT_EQ(list.Size(), 2u);
+
+    ArenaSkipList<uint64_t, HighBitsComparator>::Iterator it(&list);
+    it.Seek(uint64_t{2} << 32);
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.key() & 0xffffffff, 7u);
+}
+
+/**
+ * @brief 节点从 Arena 分配：插入只增加 Arena 用量（平均每个节点不超过 Key + 少量指针）
+ */
+TEST(ArenaSkipListTest, NodesLiveInArena) {
+    Arena arena;
+    IntList list(IntComparator(), &arena);
+    size_t before = arena.MemoryUsage();
+    constexpr int kNodes = 10000;
+    for (int i = 0; i < kNodes; ++i) list.InsertOrAssign(static_cast<uint64_t>(i));
+    size_t per_node = (arena.MemoryUsage() - before) / kNodes;
+    EXPECT_GE(per_node, sizeof(uint64_t) + sizeof(void*));
+    EXPECT_LE(per_node, sizeof(uint64_t) + 4 * sizeof(void*));
+}
+
+/**
+ * @brief 一个写入者与多个读者并发：读者无需加锁，始终看到有序序列，
+ *        且写入者已经发布的 Key 一定能被找到
+ */
+TEST(ArenaSkipListTest, ConcurrentReadersDuringInsert) {
+    constexpr int kReaders = 4;
+    constexpr uint64_t kKeys = 20000;
+
+    // 乱序插入，读者的遍历与查找会落在写入者正在修改的位置附近
+    std::vector<uint64_t> keys;
+    for (uint64_t k = 0; k < kKeys; ++k) keys.push_back(k);
+    std::shuffle(keys.begin(), keys.end(), std::minstd_rand(7));
+
+    Arena arena;
+    IntList list(IntComparator(), &arena);
+    std::atomic<size_t> published{0};  // keys[0, published) 已插入
+    std::atomic<bool> done{false};
+    std::atomic<int> failures{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < kReaders; ++r) {
+        readers.emplace_back([&, r] {
+            std::minstd_rand rnd(static_cast<unsigned>(r + 1));
+            while (!done.load(std::memory_order_acquire)) {
+                size_t n = published.load(std::memory_order_acquire);
+                if (n > 0 && !list.Contains(keys[rnd() % n])) failures.fetch_add(1);
+
+                IntList::Iterator it(&list);
+                uint64_t prev = 0;
+                size_t seen = 0;
+                for (it.SeekToFirst(); it.Valid() && seen < 256; it.Next(), ++seen) {
+                    if (seen > 0 && it.key() <= prev) failures.fetch_add(1);
+                    prev = it.key();
+                }
+            }
+        });
+    }
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        list.InsertOrAssign(keys[i]);
+        published.store(i + 1, std::memory_order_release);
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& t : readers) t.join();
+
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(list.Size(), kKeys);
+}
+
+/**
+ * @brief 反向迭代：SeekToLast / Prev 与 std::set 的逆序一致
+ */
+TEST(ArenaSkipListTest, ReverseIteration) {
+    Arena arena;
+    IntList list(IntComparator(), &arena);
+    IntList::Iterator it(&list);
+    it.SeekToLast();
+    EXPECT_FALSE(it.Valid());
+
+    std::set<uint64_t> expected;
+    std::mt19937_64 rng(7);
+    for (int i = 0; i < 2000; ++i) {
+        uint64_t key = rng() % 10000;
+        list.InsertOrAssign(key);
+        expected.insert(key);
+    }
+
+    it.SeekToLast();
+    for (auto e = expected.rbegin(); e != expected.rend(); ++e) {
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), *e);
+        it.Prev();
+    }
+    EXPECT_FALSE(it.Valid());
+
+    it.Seek(5000);
+    ASSERT_TRUE(it.Valid());
+    it.Prev();
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.key(), *std::prev(expected.lower_bound(5000)));
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include "arena.h"
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 分配的内存互不重叠，写入的内容保持不变
+ */
+TEST(ArenaTest, AllocationsDoNotOverlap) {
+    Arena arena;
+    std::mt19937 rng(301);
+    std::vector<std::pair<char*, size_t>> allocated;
+    for (int i = 0; i < 2000; ++i) {
+        size_t bytes = i % 50 == 0 ? 6000 : 1 + rng() % 200;  // 偶尔混入大对象
+        char* p = (i % 2 == 0) ? arena.Allocate(bytes) : arena.AllocateAligned(bytes);
+        std::memset(p, static_cast<char>(i % 256), bytes);
+        allocated.emplace_back(p, bytes);
+    }
+    for (size_t i = 0; i < allocated.size(); ++i) {
+        const auto& [p, bytes] = allocated[i];
+        for (size_t b = 0; b < bytes; ++b) {
+            ASSERT_EQ(p[b], static_cast<char>(i % 256)) << "allocation " << i;
+        }
+    }
+}
+
+/**
+ * @brief AllocateAligned 返回按指针大小对齐的地址
+ */
+TEST(ArenaTest, AlignedAllocations) {
+    Arena arena;
+    arena.Allocate(3);
+    for (int i = 0; i < 100; ++i) {
+        char* p = arena.AllocateAligned(static_cast<size_t>(i % 7 + 1));
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % sizeof(void*), 0u);
+        arena.Allocate(1);
+    }
+}
+
+/**
+ * @brief MemoryUsage 随分配单调增长，且不小于已分配的字节数、不大于向系统申请的字节数
+ */
+TEST(ArenaTest, MemoryUsageTracksAllocations) {
+    Arena arena;
+    EXPECT_EQ(arena.MemoryUsage(), 0u);
+
+    size_t requested = 0;
+    size_t last = 0;
+    for (int i = 0; i < 1000; ++i) {
+        size_t bytes = static_cast<size_t>(i % 300 + 1);
+        arena.Allocate(bytes);
+        requested += bytes;
+        EXPECT_GT(arena.MemoryUsage(), last);
+        last = arena.MemoryUsage();
+    }
+    EXPECT_GE(arena.MemoryUsage(), requested);
+    EXPECT_LE(arena.MemoryUsage(), arena.ReservedBytes());
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include "blob_file.h"
+#include "block_cache.h"
+#include "filename.h"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @file blob_file_test.cpp
+ * @brief Blob 文件（键值分离）的单元测试
+ *
+ * 测试目标：
+ * 1. 验证 BlobIndex 编解码往返
+ * 2. 验证写入的每条记录都能按 BlobIndex 读回，统计与文件大小一致
+ * 3. 验证记录损坏、Key 不一致、Magic Number 错误时报错
+ * 4. 验证读到的 Value 放入块缓存
+ */
+
+namespace fs = std::filesystem;
+
+namespace {
+    const std::string kTestDir = "./test_data_blob";
+
+    std::string BlobPath(uint64_t number) { return (fs::path(kTestDir) / blob_file_name(number)).string(); }
+}
+
+class BlobFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fs::remove_all(kTestDir);
+        fs::create_directories(kTestDir);
+    }
+
+    void TearDown() override { fs::remove_all(kTestDir); }
+};
+
+/**
+ * @brief 编码后再解码得到相同的指针；长度不对时拒绝
+ */
+TEST(BlobIndexTest, EncodeDecodeRoundTrip) {
+    BlobIndex index{7, uint64_t{1} << 40, 123456};
+    std::string encoded = index.Encode();
+    EXPECT_EQ(encoded.size(), BlobIndex::kEncodedLength);
+
+    BlobIndex decoded;
+    ASSERT_TRUE(decoded.Decode(encoded));
+    EXPECT_EQ(decoded.file_number, 7u);
+    EXPECT_EQ(decoded.offset, uint64_t{1} << 40);
+    EXPECT_EQ(decoded.size, 123456u);
+    EXPECT_FALSE(decoded.Decode(std::string_view(encoded.data(), encoded.size() - 1)));
+}
+
+/**
+ * @brief 写入的记录都能读回；文件名可以解析
+ */
+TEST_F(BlobFileTest, WriteAndRead) {
+    std::vector<BlobIndex> indexes;
+    uint64_t bytes = 0;
+    {
+        BlobFileBuilder builder(BlobPath(5), 5);
+        for (int i = 0; i < 100; ++i) {
+            std::string value(static_cast<size_t>(i * 37 % 5000), static_cast<char>('a' + i % 26));
+            bytes += value.size();
+            indexes.push_back(builder.Add("key" + std::to_string(i), value));
+        }
+        EXPECT_EQ(builder.BlobCount(), 100u);
+        EXPECT_EQ(builder.BlobBytes(), bytes);
+        builder.Finish();
+        EXPECT_EQ(fs::file_size(BlobPath(5)), builder.FileSize());
+    }
+
+    uint64_t number = 0;
+    ASSERT_TRUE(parse_blob_file_name(blob_file_name(5), &number));
+    EXPECT_EQ(number, 5u);
+    EXPECT_FALSE(parse_blob_file_name("blob_x.blob", &number));
+    EXPECT_FALSE(parse_blob_file_name("L0_000005.sst", &number));
+
+    BlobFileReader reader(BlobPath(5));
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(indexes[i].file_number, 5u);
+        auto value = reader.Get(indexes[i], "key" + std::to_string(i));
+        ASSERT_NE(value, nullptr);
+        EXPECT_EQ(*value, std::string(static_cast<size_t>(i * 37 % 5000), static_cast<char>('a' + i % 26)));
+    }
+}
+
+/**
+ * @brief 记录损坏、Key 不一致或 Magic Number 错误时抛出异常
+ */
+TEST_F(BlobFileTest, DetectsCorruption) {
+    BlobIndex index;
+    {
+        BlobFileBuilder builder(BlobPath(1), 1);
+        builder.Add("a", "first value");
+        index = builder.Add("b", "second value");
+        builder.Finish();
+    }
+    {
+        BlobFileReader reader(BlobPath(1));
+        EXPECT_EQ(*reader.Get(index, "b"), "second value");
+        EXPECT_THROW(reader.Get(index, "c"), std::runtime_error);
+        BlobIndex wrong_size = index;
+        wrong_size.size -= 1;
+        EXPECT_THROW(reader.Get(wrong_size, "b"), std::runtime_error);
+    }
+
+    {
+        std::fstream f(BlobPath(1), std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(static_cast<std::streamoff>(index.offset + kBlobRecordHeaderSize + 1 + 3));
+        f.put('X');
+    }
+    {
+        BlobFileReader reader(BlobPath(1));
+        EXPECT_THROW(reader.Get(index, "b"), std::runtime_error);
+    }
+
+    {
+        std::fstream f(BlobPath(1), std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(0);
+        f.put('\0');
+    }
+    EXPECT_THROW(BlobFileReader reader(BlobPath(1)), std::runtime_error);
+}
+
+/**
+ * @brief 提供块缓存时，读到的 Value 放入缓存，之后的读取直接命中
+ */
+TEST_F(BlobFileTest, CachesValues) {
+    BlobIndex index;
+    {
+        BlobFileBuilder builder(BlobPath(2), 2);
+        index = builder.Add("key", std::string(1000, 'v'));
+        builder.Finish();
+    }
+    auto cache = std::make_shared<BlockCache>(1 << 20);
+    BlobFileReader reader(BlobPath(2), cache);
+
+    reader.Get(index, "key", /*fill_cache=*/false);
+    EXPECT_EQ(cache->Stats().inserts, 0u);
+    auto first = reader.Get(index, "key");
+    EXPECT_EQ(cache->Stats().inserts, 1u);
+    auto second = reader.Get(index, "key");
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(cache->Stats().hits, 1u);
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include "block_cache.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    std::shared_ptr<const void> MakeValue(const std::string& s) {
+        return std::make_shared<const std::string>(s);
+    }
+
+    std::string ValueOf(const std::shared_ptr<const void>& p) {
+        return p ? *std::static_pointer_cast<const std::string>(p) : std::string("<null>");
+    }
+}
+
+/**
+ * @brief 基本的插入 / 查询 / 删除，以及命中统计
+ */
+TEST(BlockCacheTest, InsertLookupErase) {
+    BlockCache cache(1 << 20);
+    uint64_t id = cache.NewId();
+
+    EXPECT_EQ(cache.Lookup(id, 0), nullptr);
+    cache.Insert(id, 0, MakeValue("block0"), 100);
+    cache.Insert(id, 4096, MakeValue("block1"), 100);
+
+    EXPECT_EQ(ValueOf(cache.Lookup(id, 0)), "block0");
+    EXPECT_EQ(ValueOf(cache.Lookup(id, 4096)), "block1");
+    EXPECT_EQ(cache.Lookup(id + 1, 0), nullptr) << "different file id must not collide";
+
+    cache.Erase(id, 0);
+    EXPECT_EQ(cache.Lookup(id, 0), nullptr);
+
+    BlockCacheStats stats = cache.Stats();
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_EQ(stats.inserts, 2u);
+    EXPECT_EQ(stats.usage, 100u);
+    EXPECT_DOUBLE_EQ(stats.hit_rate(), 0.4);
+}
+
+/**
+ * @brief 重复插入同一个 Key 会替换旧值，usage 不会重复计入
+ */
+TEST(BlockCacheTest, InsertReplaces) {
+    BlockCache cache(1 << 20);
+    cache.Insert(1, 0, MakeValue("old"), 100);
+    cache.Insert(1, 0, MakeValue("new"), 50);
+    EXPECT_EQ(ValueOf(cache.Lookup(1, 0)), "new");
+    EXPECT_EQ(cache.Stats().usage, 50u);
+}
+
+/**
+ * @brief 超出容量时淘汰最久未使用的条目（单分片便于验证顺序）
+ */
+TEST(BlockCacheTest, EvictsLeastRecentlyUsed) {
+    BlockCache cache(300, /*num_shard_bits=*/0);
+    cache.Insert(1, 0, MakeValue("a"), 100);
+    cache.Insert(1, 1, MakeValue("b"), 100);
+    cache.Insert(1, 2, MakeValue("c"), 100);
+
+    // 访问 a，使 b 成为最久未使用
+    EXPECT_NE(cache.Lookup(1, 0), nullptr);
+    cache.Insert(1, 3, MakeValue("d"), 100);
+
+    EXPECT_NE(cache.Lookup(1, 0), nullptr);
+    EXPECT_EQ(cache.Lookup(1, 1), nullptr);
+    EXPECT_NE(cache.Lookup(1, 2), nullptr);
+    EXPECT_NE(cache.Lookup(1, 3), nullptr);
+
+    BlockCacheStats stats = cache.Stats();
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_LE(stats.usage, stats.capacity);
+}
+
+/**
+ * @brief 被淘汰的条目在调用者手中依然有效
+ */
+TEST(BlockCacheTest, EvictedValueStaysAliveWhileReferenced) {
+    BlockCache cache(100, 0);
+    cache.Insert(1, 0, MakeValue("keep me"), 100);
+    auto held = cache.Lookup(1, 0);
+    cache.Insert(1, 1, MakeValue("other"), 100);
+
+    EXPECT_EQ(cache.Lookup(1, 0), nullptr);
+    EXPECT_EQ(ValueOf(held), "keep me");
+}
+
+/**
+ * @brief 固定条目计入 usage 但不被淘汰，只能通过 Erase 移除
+ */
+TEST(BlockCacheTest, PinnedEntriesAreNotEvicted) {
+    BlockCache cache(300, 0);
+    cache.Insert(1, 0, MakeValue("index"), 200, /*pinned=*/true);
+    cache.Insert(1, 1, MakeValue("b"), 100);
+    cache.Insert(1, 2, MakeValue("c"), 100);
+
+    EXPECT_EQ(ValueOf(cache.Lookup(1, 0)), "index");
+    EXPECT_EQ(cache.Lookup(1, 1), nullptr);
+    EXPECT_NE(cache.Lookup(1, 2), nullptr);
+
+    BlockCacheStats stats = cache.Stats();
+    EXPECT_EQ(stats.pinned_usage, 200u);
+    EXPECT_EQ(stats.usage, 300u);
+
+    cache.Erase(1, 0);
+    stats = cache.Stats();
+    EXPECT_EQ(stats.pinned_usage, 0u);
+    EXPECT_EQ(stats.usage, 100u);
+}
+
+/**
+ * @brief 比分片容量还大的条目不会被缓存
+ */
+TEST(BlockCacheTest, OversizedEntryIsNotCached) {
+    BlockCache cache(100, 0);
+    cache.Insert(1, 0, MakeValue("huge"), 1000);
+    EXPECT_EQ(cache.Lookup(1, 0), nullptr);
+    EXPECT_EQ(cache.Stats().usage, 0u);
+}
+
+/**
+ * @brief 多线程并发插入与查询，容量约束始终成立
+ */
+TEST(BlockCacheTest, ConcurrentAccess) {
+    BlockCache cache(64 * 1024);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, t] {
+            for (uint64_t i = 0; i < 5000; ++i) {
+                uint64_t offset = (i % 500) * 4096;
+                if (!cache.Lookup(t, offset)) {
+                    cache.Insert(t, offset, MakeValue(std::to_string(i)), 256);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    BlockCacheStats stats = cache.Stats();
+    EXPECT_EQ(stats.hits + stats.misses, 20000u);
+    EXPECT_GT(stats.evictions, 0u);
+    EXPECT_LE(stats.usage, stats.capacity + 16 * 256);
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include "block.h"
+#include "coding.h"
+
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    std::string MakeKey(int i) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "user%08d", i);
+        return buf;
+    }
+
+    std::vector<std::pair<std::string, std::string>> MakeEntries(int n, int step = 1) {
+        std::vector<std::pair<std::string, std::string>> entries;
+        for (int i = 0; i < n; i += step) {
+            entries.emplace_back(MakeKey(i), "value" + std::to_string(i));
+        }
+        return entries;
+    }
+
+    std::string BuildBlock(const std::vector<std::pair<std::string, std::string>>& entries,
+                           int restart_interval) {
+        BlockBuilder builder(restart_interval);
+        for (const auto& [key, value] : entries) builder.Add(key, value);
+        return builder.Finish();
+    }
+}
+
+/**
+ * @brief varint32 编解码：边界值与截断输入
+ */
+TEST(CodingTest, Varint32RoundTrip) {
+    std::vector<uint32_t> values = {0, 1, 127, 128, 300, 16383, 16384, (1u << 21) - 1,
+                                    1u << 21, (1u << 28) + 5, std::numeric_limits<uint32_t>::max()};
+    std::string buf;
+    for (uint32_t v : values) put_varint32(buf, v);
+
+    const char* p = buf.data();
+    const char* limit = buf.data() + buf.size();
+    for (uint32_t expected : values) {
+        uint32_t actual = 0;
+        p = get_varint32_ptr(p, limit, &actual);
+        ASSERT_NE(p, nullptr);
+        EXPECT_EQ(actual, expected);
+    }
+    EXPECT_EQ(p, limit);
+
+    std::string one;
+    put_varint32(one, 1u << 20);
+    uint32_t v = 0;
+    EXPECT_EQ(get_varint32_ptr(one.data(), one.data() + one.size() - 1, &v), nullptr);
+}
+
+/**
+ * @brief 不同重启间隔下，所有 Key 都能被点查到，不存在的 Key 返回 false
+ */
+TEST(BlockTest, GetWithVariousRestartIntervals) {
+    auto entries = MakeEntries(400, 2);
+    for (int interval : {1, 2, 16, 1000}) {
+        std::string contents = BuildBlock(entries, interval);
+        Block block(contents);
+        ASSERT_FALSE(block.corrupted());
+
+        std::string value;
+        for (const auto& [key, expected] : entries) {
+            ASSERT_TRUE(block.Get(key, &value)) << key << " interval=" << interval;
+            EXPECT_EQ(value, expected);
+        }
+        for (int i = 1; i < 400; i += 2) {
+            EXPECT_FALSE(block.Get(MakeKey(i), &value)) << MakeKey(i);
+        }
+        EXPECT_FALSE(block.Get("", &value));
+        EXPECT_FALSE(block.Get("zzzz", &value));
+    }
+}
+
+/**
+ * @brief 迭代器按顺序还原每个完整 Key；Seek 定位到第一个 >= target 的 Entry
+ */
+TEST(BlockTest, IterateAndSeek) {
+    auto entries = MakeEntries(100, 2);
+    std::string contents = BuildBlock(entries, 4);
+    Block block(contents);
+
+    Block::Iterator it(block);
+    it.SeekToFirst();
+    for (const auto& [key, value] : entries) {
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), key);
+        EXPECT_EQ(it.value(), value);
+        it.Next();
+    }
+    EXPECT_FALSE(it.Valid());
+    EXPECT_FALSE(it.corrupted());
+
+    it.Seek(MakeKey(51));
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.key(), MakeKey(52));
+
+    it.Seek("");
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.key(), MakeKey(0));
+
+    it.Seek(MakeKey(99));
+    EXPECT_FALSE(it.Valid());
+}
+
+/**
+ * @brief 重启点数量 = ceil(n / interval)，前缀共享使 Block 明显变小
+ */
+TEST(BlockTest, RestartsAndPrefixSharing) {
+    auto entries = MakeEntries(100);
+    std::string shared = BuildBlock(entries, 16);
+    std::string unshared = BuildBlock(entries, 1);
+
+    EXPECT_EQ(Block(shared).NumRestarts(), 7u);
+    EXPECT_EQ(Block(unshared).NumRestarts(), 100u);
+    EXPECT_LT(shared.size(), unshared.size() * 3 / 4);
+
+    BlockBuilder builder;
+    builder.Add("a", "1");
+    size_t estimate = builder.CurrentSizeEstimate();
+    EXPECT_EQ(estimate, builder.Finish().size());
+}
+
+/**
+ * @brief 空 Block：可以解析，查询返回 false
+ */
+TEST(BlockTest, EmptyBlock) {
+    BlockBuilder builder;
+    EXPECT_TRUE(builder.empty());
+    std::string contents = builder.Finish();
+    Block block(contents);
+    EXPECT_FALSE(block.corrupted());
+
+    std::string value;
+    EXPECT_FALSE(block.Get("a", &value));
+    Block::Iterator it(block);
+    it.SeekToFirst();
+    EXPECT_FALSE(it.Valid());
+}
+
+/**
+ * @brief 损坏的 Block：重启点数组越界、Entry 长度越界时报告 corrupted
+ */
+TEST(BlockTest, DetectsCorruption) {
+    std::string value;
+    bool corrupted = false;
+
+    EXPECT_TRUE(Block("ab").corrupted());
+
+    std::string huge_restarts(8, '\0');
+    encode_fixed32(&huge_restarts[4], 1000);
+    EXPECT_TRUE(Block(huge_restarts).corrupted());
+
+    std::string contents = BuildBlock(MakeEntries(10), 16);
+    contents[1] = static_cast<char>(0x7f);  // 第一个 Entry 的 non_shared 远超 Block 大小
+    Block block(contents);
+    ASSERT_FALSE(block.corrupted());
+    EXPECT_FALSE(block.Get(MakeKey(3), &value, &corrupted));
+    EXPECT_TRUE(corrupted);
+}
+
+/**
+ * @brief 反向迭代：SeekToLast + Prev 走遍所有 Entry，并能与 Seek / Next 交替使用
+ */
+TEST(BlockTest, ReverseIteration) {
+    auto entries = MakeEntries(100, 2);
+    for (int interval : {1, 3, 16}) {
+        std::string contents = BuildBlock(entries, interval);
+        Block block(contents);
+
+        Block::Iterator it(block);
+        it.SeekToLast();
+        for (auto e = entries.rbegin(); e != entries.rend(); ++e) {
+            ASSERT_TRUE(it.Valid()) << interval;
+            EXPECT_EQ(it.key(), e->first);
+            EXPECT_EQ(it.value(), e->second);
+            it.Prev();
+        }
+        EXPECT_FALSE(it.Valid());
+        EXPECT_FALSE(it.corrupted());
+
+        it.Seek(MakeKey(51));
+        it.Prev();
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), MakeKey(50));
+        it.Next();
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), MakeKey(52));
+    }
+
+    std::string empty = BlockBuilder().Finish();
+    Block empty_block(empty);
+    Block::Iterator it(empty_block);
+    it.SeekToLast();
+    EXPECT_FALSE(it.Valid());
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "bloom_filter.h"
+#include "coding.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+    std::string BuildFilter(int n, int bits_per_key) {
+        std::vector<uint32_t> hashes;
+        for (int i = 0; i < n; ++i) {
+            hashes.push_back(BloomFilter::Hash(encode_int_key(i)));
+        }
+        return BloomFilter::Create(hashes, bits_per_key);
+    }
+
+    double FalsePositiveRate(const std::string& filter) {
+        int hits = 0;
+        constexpr int kProbes = 10000;
+        for (int i = 0; i < kProbes; ++i) {
+            if (BloomFilter::KeyMayMatch(encode_int_key(i + 1000000000), filter)) ++hits;
+        }
+        return static_cast<double>(hits) / kProbes;
+    }
+}
+
+/**
+ * @brief 空过滤器：不包含任何 Key
+ */
+TEST(BloomFilterTest, EmptyFilter) {
+    std::string filter = BloomFilter::Create({}, 10);
+    EXPECT_FALSE(BloomFilter::KeyMayMatch("hello", filter));
+    EXPECT_FALSE(BloomFilter::KeyMayMatch("", filter));
+}
+
+/**
+ * @brief 少量 Key：已加入的一定命中，其他 Key 基本不命中
+ */
+TEST(BloomFilterTest, SmallFilter) {
+    std::vector<uint32_t> hashes = {BloomFilter::Hash("hello"), BloomFilter::Hash("world")};
+    std::string filter = BloomFilter::Create(hashes, 10);
+    EXPECT_TRUE(BloomFilter::KeyMayMatch("hello", filter));
+    EXPECT_TRUE(BloomFilter::KeyMayMatch("world", filter));
+    EXPECT_FALSE(BloomFilter::KeyMayMatch("x", filter));
+    EXPECT_FALSE(BloomFilter::KeyMayMatch("foo", filter));
+}
+
+/**
+ * @brief 不同规模下无假阴性，假阳性率接近理论值（10 bits/key 约 1%）
+ */
+TEST(BloomFilterTest, VaryingLengths) {
+    for (int n : {1, 10, 100, 1000, 10000}) {
+        std::string filter = BuildFilter(n, 10);
+        EXPECT_LE(filter.size(), static_cast<size_t>(n) * 10 / 8 + 40) << n;
+
+        for (int i = 0; i < n; ++i) {
+            ASSERT_TRUE(BloomFilter::KeyMayMatch(encode_int_key(i), filter))
+                << "false negative, n=" << n << " key=" << i;
+        }
+        // 很小的过滤器只有几十到一百多位，统计波动较大，放宽阈值
+        EXPECT_LE(FalsePositiveRate(filter), n < 100 ? 0.05 : 0.02) << n;
+    }
+}
+
+/**
+ * @brief bits_per_key 越大，假阳性率越低
+ */
+TEST(BloomFilterTest, MoreBitsLowerFalsePositives) {
+    double fp6 = FalsePositiveRate(BuildFilter(5000, 6));
+    double fp16 = FalsePositiveRate(BuildFilter(5000, 16));
+    EXPECT_LT(fp16, fp6);
+    EXPECT_LE(fp16, 0.005);
+}
+
+/**
+ * @brief 无法识别的过滤器编码保守地返回“可能存在”
+ */
+TEST(BloomFilterTest, UnknownEncodingMatchesEverything) {
+    EXPECT_TRUE(BloomFilter::KeyMayMatch("a", ""));
+    EXPECT_TRUE(BloomFilter::KeyMayMatch("a", std::string(8, '\0') + '\x1f'));
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "compression.h"
+
+#include <random>
+#include <string>
+
+namespace {
+    /// 类 JSON 的可压缩数据
+    std::string CompressibleData(size_t n) {
+        std::string data;
+        int i = 0;
+        while (data.size() < n) {
+            data += "{\"id\":" + std::to_string(i++) + ",\"status\":\"active\",\"region\":\"cn-east\"}";
+        }
+        data.resize(n);
+        return data;
+    }
+
+    const CompressionType kCodecs[] = {CompressionType::kLz4, CompressionType::kZstd};
+}
+
+/**
+ * @brief kNone 总是受支持，且从不产生压缩输出
+ */
+TEST(CompressionTest, NoneNeverCompresses) {
+    EXPECT_TRUE(compression_supported(CompressionType::kNone));
+    std::string out;
+    EXPECT_FALSE(compress_block(CompressionType::kNone, 3, CompressibleData(4096), &out));
+}
+
+/**
+ * @brief 已编译进来的算法：压缩后明显变小，且能无损解压
+ */
+TEST(CompressionTest, SupportedCodecsRoundTrip) {
+    std::string input = CompressibleData(4096);
+    for (CompressionType type : kCodecs) {
+        if (!compression_supported(type)) continue;
+        std::string compressed;
+        ASSERT_TRUE(compress_block(type, 3, input, &compressed)) << compression_name(type);
+        EXPECT_LT(compressed.size(), input.size() / 2) << compression_name(type);
+
+        std::string output;
+        ASSERT_TRUE(decompress_block(type, compressed, &output)) << compression_name(type);
+        EXPECT_EQ(output, input);
+    }
+}
+
+/**
+ * @brief 未编译进来的算法：压缩与解压都返回 false（调用者退回不压缩）
+ */
+TEST(CompressionTest, UnsupportedCodecsFallBack) {
+    for (CompressionType type : kCodecs) {
+        if (compression_supported(type)) continue;
+        std::string out;
+        EXPECT_FALSE(compress_block(type, 3, CompressibleData(4096), &out));
+        EXPECT_FALSE(decompress_block(type, "\x10garbage", &out));
+    }
+}
+
+/**
+ * @brief 截断或篡改的压缩负载被识别为损坏
+ */
+TEST(CompressionTest, RejectsCorruptPayload) {
+    std::string input = CompressibleData(4096);
+    for (CompressionType type : kCodecs) {
+        if (!compression_supported(type)) continue;
+        std::string compressed;
+        ASSERT_TRUE(compress_block(type, 3, input, &compressed));
+
+        std::string output;
+        EXPECT_FALSE(decompress_block(type, compressed.substr(0, compressed.size() / 2), &output))
+            << compression_name(type);
+        EXPECT_FALSE(decompress_block(type, "", &output)) << compression_name(type);
+    }
+}
+
+/**
+ * @brief 随机数据压缩不了多少（SSTableBuilder 据此退回原始 Block）
+ */
+TEST(CompressionTest, RandomDataDoesNotShrink) {
+    std::mt19937 rng(42);
+    std::string input(4096, '\0');
+    for (char& c : input) c = static_cast<char>(rng());
+    for (CompressionType type : kCodecs) {
+        if (!compression_supported(type)) continue;
+        std::string compressed;
+        if (compress_block(type, 3, input, &compressed)) {
+            EXPECT_GE(compressed.size(), input.size() - input.size() / 8) << compression_name(type);
+        }
+    }
+}
@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include "fat_skiplist.h"
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @file fat_skiplist_test.cpp
+ * @brief FatSkipList（定宽键胖节点跳表）的单元测试
+ *
+ * 测试目标：
+ * 1. 验证按键类型选择实现：算术键使用 FatSkipList，其余键仍使用 SkipList
+ * 2. 验证节点分裂（顺序 / 逆序 / 随机写入）后所有键仍可查到
+ * 3. 验证删除首键、删空节点后各层缓存的首键与链接正确（与 std::map 对拍）
+ * 4. 验证迭代器的 Seek / Prev / SeekToLast 跨节点移动
+ * 5. 验证类型最大值、浮点 +inf 这类与空槽填充值相等的键
+ */
+
+static_assert(std::is_same_v<FastSkipList<int, int>, FatSkipList<int, int>>);
+static_assert(std::is_same_v<FastSkipList<double, std::string>, FatSkipList<double, std::string>>);
+static_assert(std::is_same_v<FastSkipList<std::string, int>, SkipList<std::string, int>>);
+static_assert(std::is_same_v<FastSkipList<bool, int>, SkipList<bool, int>>);
+static_assert(FatSkipList<int32_t, int>::kNodeKeys == 16);
+static_assert(FatSkipList<int64_t, int>::kNodeKeys == 8);
+
+/**
+ * @brief 空表查找与删除都未命中
+ */
+TEST(FatSkipListTest, EmptyList) {
+    FatSkipList<int, std::string> list(16);
+    EXPECT_FALSE(list.search(1).has_value());
+    EXPECT_EQ(list.find(1), nullptr);
+    EXPECT_FALSE(list.remove(1));
+    FatSkipList<int, std::string>::Iterator it(&list);
+    it.SeekToFirst();
+    EXPECT_FALSE(it.Valid());
+    it.SeekToLast();
+    EXPECT_FALSE(it.Valid());
+}
+
+/**
+ * @brief 顺序、逆序写入都跨越多个节点；重复写入表现为更新
+ */
+TEST(FatSkipListTest, SequentialAndReverseInsert) {
+    for (bool reverse : {false, true}) {
+        FatSkipList<int, std::string> list(12);
+        const int n = 1000;
+        for (int i = 0; i < n; ++i) {
+            int k = reverse ? n - 1 - i : i;
+            list.insert(k, "v" + std::to_string(k));
+        }
+        for (int i = 0; i < n; ++i) {
+            auto v = list.search(i);
+            ASSERT_TRUE(v.has_value()) << i;
+            EXPECT_EQ(*v, "v" + std::to_string(i));
+        }
+        EXPECT_FALSE(list.search(-1).has_value());
+        EXPECT_FALSE(list.search(n).has_value());
+
+        list.insert(0, "first");
+        list.insert(n - 1, "last");
+        EXPECT_EQ(*list.search(0), "first");
+        EXPECT_EQ(*list.search(n - 1), "last");
+
+        int expected = 0;
+        list.for_each([&](int key, const std::string&) { EXPECT_EQ(key, expected++); });
+        EXPECT_EQ(expected, n);
+    }
+}
+
+/**
+ * @brief 随机插入 / 删除与 std::map 对拍，覆盖分裂、删除首键与删空节点
+ */
+TEST(FatSkipListTest, RandomOpsMatchStdMap) {
+    FatSkipList<int, int> list(16);
+    std::map<int, int> model;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> key_dist(0, 2000);
+
+    for (int step = 0; step < 50000; ++step) {
+        int key = key_dist(rng);
+        if (rng() % 3 == 0) {
+            bool removed = model.erase(key) == 1;
+            EXPECT_EQ(list.remove(key), removed) << "step " << step;
+        } else {
+            list.insert(key, step);
+            model[key] = step;
+        }
+        if (step % 5000 == 0) {
+            for (int k = 0; k <= 2000; ++k) {
+                auto it = model.find(k);
+                const int* v = list.find(k);
+                ASSERT_EQ(v != nullptr, it != model.end()) << k;
+                if (v) {
+                    EXPECT_EQ(*v, it->second);
+                }
+            }
+        }
+    }
+
+    std::vector<std::pair<int, int>> items;
+    list.for_each([&](int k, int v) { items.emplace_back(k, v); });
+    std::vector<std::pair<int, int>> expected(model.begin(), model.end());
+    EXPECT_EQ(items, expected);
+
+    // 全部删除后表为空
+    for (const auto& [k, v] : model) ASSERT_TRUE(list.remove(k));
+    FatSkipList<int, int>::Iterator it(&list);
+    it.SeekToFirst();
+    EXPECT_FALSE(it.Valid());
+}
+
+/**
+ * @brief 迭代器双向移动与 Seek 跨越节点边界
+ */
+TEST(FatSkipListTest, IteratorSeekAndPrev) {
+    FatSkipList<int64_t, int64_t> list(12);
+    for (int64_t i = 0; i < 200; ++i) list.insert(i * 10, i);
+
+    FatSkipList<int64_t, int64_t>::Iterator it(&list);
+    it.Seek(55);
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.key(), 60);
+    it.Seek(-5);
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.key(), 0);
+    it.Seek(1991);
+    EXPECT_FALSE(it.Valid());
+
+    it.SeekToLast();
+    for (int64_t i = 199; i >= 0; --i) {
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), i * 10);
+        EXPECT_EQ(it.value(), i);
+        it.Prev();
+    }
+    EXPECT_FALSE(it.Valid());
+
+    it.SeekToFirst();
+    for (int64_t i = 0; i < 200; ++i) {
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), i * 10);
+        it.Next();
+    }
+    EXPECT_FALSE(it.Valid());
+}
+
+/**
+ * @brief 与空槽填充值相等的键（整数最大值、浮点 +inf）可以正常写入、查找与删除
+ */
+TEST(FatSkipListTest, KeysEqualToPadding) {
+    FatSkipList<int, int> ints(8);
+    const int max = std::numeric_limits<int>::max();
+    const int min = std::numeric_limits<int>::min();
+    ints.insert(max, 1);
+    ints.insert(min, 2);
+    ints.insert(0, 3);
+    EXPECT_EQ(*ints.search(max), 1);
+    EXPECT_EQ(*ints.search(min), 2);
+    EXPECT_TRUE(ints.remove(max));
+    EXPECT_FALSE(ints.search(max).has_value());
+
+    FatSkipList<double, int> doubles(8);
+    const double inf = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < 100; ++i) doubles.insert(i * 0.5, i);
+    doubles.insert(inf, -1);
+    doubles.insert(-inf, -2);
+    EXPECT_EQ(*doubles.search(inf), -1);
+    EXPECT_EQ(*doubles.search(-inf), -2);
+    EXPECT_EQ(*doubles.search(49.5), 99);
+    EXPECT_FALSE(doubles.search(0.25).has_value());
+
+    FatSkipList<double, int>::Iterator it(&doubles);
+    it.SeekToLast();
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.key(), inf);
+    it.SeekToFirst();
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.key(), -inf);
+}
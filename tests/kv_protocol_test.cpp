@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "kv_protocol.h"
+
+#include <string>
+#include <string_view>
+
+/**
+ * @file kv_protocol_test.cpp
+ * @brief 服务端二进制协议的编解码测试
+ */
+
+/**
+ * @brief 流水线：多个请求拼接在一个缓冲区中，按顺序逐个解析，视图指向原缓冲区
+ */
+TEST(KVProtocolTest, ParsesPipelinedRequests) {
+    std::string wire;
+    append_request(wire, RequestOp::kPut, "key", "value");
+    append_request(wire, RequestOp::kGet, std::string(300, 'k'));
+    append_request(wire, RequestOp::kDelete, std::string("\0bin", 4));
+    append_request(wire, RequestOp::kPut, "", "");
+
+    std::string_view input(wire);
+    RequestView request;
+    ASSERT_EQ(parse_request(input, &request), FrameStatus::kOk);
+    EXPECT_EQ(request.op, RequestOp::kPut);
+    EXPECT_EQ(request.key, "key");
+    EXPECT_EQ(request.value, "value");
+    EXPECT_GE(request.key.data(), wire.data());
+    EXPECT_LT(request.key.data(), wire.data() + wire.size());
+
+    ASSERT_EQ(parse_request(input, &request), FrameStatus::kOk);
+    EXPECT_EQ(request.op, RequestOp::kGet);
+    EXPECT_EQ(request.key, std::string(300, 'k'));
+    EXPECT_TRUE(request.value.empty());
+
+    ASSERT_EQ(parse_request(input, &request), FrameStatus::kOk);
+    EXPECT_EQ(request.op, RequestOp::kDelete);
+    EXPECT_EQ(request.key, std::string_view("\0bin", 4));
+
+    ASSERT_EQ(parse_request(input, &request), FrameStatus::kOk);
+    EXPECT_TRUE(request.key.empty());
+    EXPECT_TRUE(input.empty());
+    EXPECT_EQ(parse_request(input, &request), FrameStatus::kIncomplete);
+}
+
+/**
+ * @brief 不完整的帧返回 kIncomplete 且不消耗输入，补齐后可以解析
+ */
+TEST(KVProtocolTest, IncompleteFrameConsumesNothing) {
+    std::string wire;
+    append_request(wire, RequestOp::kPut, "key", std::string(1000, 'v'));
+    for (size_t cut : {size_t{0}, size_t{3}, size_t{4}, wire.size() - 1}) {
+        std::string_view input(wire.data(), cut);
+        RequestView request;
+        EXPECT_EQ(parse_request(input, &request), FrameStatus::kIncomplete) << cut;
+        EXPECT_EQ(input.size(), cut);
+    }
+    std::string_view input(wire);
+    RequestView request;
+    EXPECT_EQ(parse_request(input, &request), FrameStatus::kOk);
+}
+
+/**
+ * @brief 格式错误：未知操作、Key 长度越界、空帧、超过大小上限
+ */
+TEST(KVProtocolTest, RejectsInvalidFrames) {
+    RequestView request;
+    {
+        std::string wire;
+        append_request(wire, RequestOp::kGet, "key");
+        wire[kFrameHeaderSize] = 9;
+        std::string_view input(wire);
+        EXPECT_EQ(parse_request(input, &request), FrameStatus::kInvalid);
+    }
+    {
+        std::string wire;
+        put_fixed32(wire, 2);
+        wire.push_back(static_cast<char>(RequestOp::kGet));
+        wire.push_back(5);  // Key 长度 5，但 Body 中没有 Key
+        std::string_view input(wire);
+        EXPECT_EQ(parse_request(input, &request), FrameStatus::kInvalid);
+    }
+    {
+        std::string wire;
+        put_fixed32(wire, 0);
+        std::string_view input(wire);
+        EXPECT_EQ(parse_request(input, &request), FrameStatus::kInvalid);
+    }
+    {
+        std::string wire;
+        append_request(wire, RequestOp::kPut, "key", std::string(100, 'v'));
+        std::string_view input(wire);
+        EXPECT_EQ(parse_request(input, &request, 64), FrameStatus::kInvalid);
+    }
+}
+
+/**
+ * @brief 响应：头部与 Value 分开追加（零拷贝发送的方式）与一次追加的结果相同
+ */
+TEST(KVProtocolTest, ResponseRoundTrip) {
+    std::string wire;
+    append_response(wire, ResponseStatus::kOk, "value");
+    append_response(wire, ResponseStatus::kNotFound);
+    append_response(wire, ResponseStatus::kError, "disk full");
+
+    std::string split;
+    append_response_header(split, ResponseStatus::kOk, 5);
+    split += "value";
+    EXPECT_EQ(wire.substr(0, split.size()), split);
+
+    std::string_view input(wire);
+    ResponseView response;
+    ASSERT_EQ(parse_response(input, &response), FrameStatus::kOk);
+    EXPECT_EQ(response.status, ResponseStatus::kOk);
+    EXPECT_EQ(response.value, "value");
+    ASSERT_EQ(parse_response(input, &response), FrameStatus::kOk);
+    EXPECT_EQ(response.status, ResponseStatus::kNotFound);
+    EXPECT_TRUE(response.value.empty());
+    ASSERT_EQ(parse_response(input, &response), FrameStatus::kOk);
+    EXPECT_EQ(response.status, ResponseStatus::kError);
+    EXPECT_EQ(response.value, "disk full");
+    EXPECT_TRUE(input.empty());
+}
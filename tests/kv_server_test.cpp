@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include "kv_client.h"
+#include "kv_server.h"
+
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+
+/**
+ * @file kv_server_test.cpp
+ * @brief KVServer 端到端测试：流水线、攒批提交、零拷贝大值与多连接并发
+ */
+
+namespace fs = std::filesystem;
+
+class KVServerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = "test_data_kv_server";
+        fs::remove_all(dir_);
+    }
+
+    void TearDown() override { fs::remove_all(dir_); }
+
+    static std::string key(int i) { return "key" + std::to_string(i); }
+
+    std::string dir_;
+};
+
+/**
+ * @brief 同步接口：Put / Get / Delete 的基本语义，二进制 Key 与空值
+ */
+TEST_F(KVServerTest, BasicOperations) {
+    KVStore store(dir_);
+    KVServer server(store, ServerOptions{"127.0.0.1", 0, 2});
+    server.start();
+    ASSERT_NE(server.port(), 0);
+
+    KVClient client("127.0.0.1", server.port());
+    EXPECT_FALSE(client.get("missing").has_value());
+    client.put("alpha", "1");
+    client.put(std::string("\0key", 4), "");
+    EXPECT_EQ(client.get("alpha").value_or(""), "1");
+    EXPECT_EQ(client.get(std::string("\0key", 4)).value_or("x"), "");
+    client.del("alpha");
+    EXPECT_FALSE(client.get("alpha").has_value());
+
+    // 写入对嵌入的 KVStore 同样可见
+    EXPECT_EQ(store.get(std::string("\0key", 4)).value_or("x"), "");
+    EXPECT_FALSE(store.get("alpha").has_value());
+}
+
+/**
+ * @brief 流水线：一次发出的写入被合并成少量批次提交，响应按请求顺序返回，
+ *        之后的读取能看到同一流水线中更早的写入
+ */
+TEST_F(KVServerTest, PipelinedWritesAreBatched) {
+    KVStore store(dir_);
+    KVServer server(store, ServerOptions{"127.0.0.1", 0, 1});
+    server.start();
+
+    KVClient client("127.0.0.1", server.port());
+    const int n = 1000;
+    for (int i = 0; i < n; ++i) client.send_put(key(i), "v" + std::to_string(i));
+    client.send_get(key(7));
+    client.send_del(key(7));
+    client.send_get(key(7));
+    client.send_get(key(n - 1));
+    client.flush();
+
+    for (int i = 0; i < n; ++i) ASSERT_EQ(client.read_response(), ResponseStatus::kOk) << i;
+    std::string value;
+    EXPECT_EQ(client.read_response(&value), ResponseStatus::kOk);
+    EXPECT_EQ(value, "v7");
+    EXPECT_EQ(client.read_response(), ResponseStatus::kOk);
+    EXPECT_EQ(client.read_response(), ResponseStatus::kNotFound);
+    EXPECT_EQ(client.read_response(&value), ResponseStatus::kOk);
+    EXPECT_EQ(value, "v" + std::to_string(n - 1));
+    EXPECT_EQ(client.pending(), 0u);
+
+    ServerStats stats = server.stats();
+    EXPECT_EQ(stats.requests, static_cast<uint64_t>(n + 4));
+    EXPECT_EQ(stats.batched_writes, static_cast<uint64_t>(n + 1));
+    EXPECT_LT(stats.write_batches, static_cast<uint64_t>(n / 4)) << "pipelined writes should share WAL records";
+    EXPECT_LT(store.wal_stats().records, static_cast<uint64_t>(n / 4));
+}
+
+/**
+ * @brief 大值通过钉住的内存零拷贝发送（MemTable 与落盘后的块缓存两条路径）
+ */
+TEST_F(KVServerTest, LargeValuesAreSentZeroCopy) {
+    KVStore store(dir_);
+    KVServer server(store, ServerOptions{"127.0.0.1", 0, 1});
+    server.start();
+
+    KVClient client("127.0.0.1", server.port());
+    std::vector<std::string> values;
+    for (int i = 0; i < 8; ++i) {
+        values.push_back(std::string(static_cast<size_t>(4096 << (i % 5)), static_cast<char>('a' + i)));
+        client.put(key(i), values.back());
+    }
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 8; ++i) client.send_get(key(i));
+        for (int i = 0; i < 8; ++i) {
+            std::string value;
+            ASSERT_EQ(client.read_response(&value), ResponseStatus::kOk);
+            EXPECT_EQ(value, values[static_cast<size_t>(i)]);
+        }
+        store.flush();  // 第二轮从 SSTable 的块缓存读取
+    }
+    EXPECT_GT(server.stats().zero_copy_values, 0u);
+}
+
+/**
+ * @brief 多连接并发写入与读取，分布在多个 Reactor 上，全部结果正确且可在重启后恢复
+ */
+TEST_F(KVServerTest, ConcurrentClients) {
+    const int clients = 8;
+    const int per_client = 500;
+    {
+        KVStoreOptions options;
+        options.sync_mode = WalSyncMode::kGroupCommit;
+        KVStore store(dir_, options);
+        KVServer server(store, ServerOptions{"127.0.0.1", 0, 4});
+        server.start();
+
+        std::vector<std::thread> threads;
+        std::vector<int> failures(clients, 0);
+        for (int c = 0; c < clients; ++c) {
+            threads.emplace_back([&, c] {
+                KVClient client("127.0.0.1", server.port());
+                for (int i = 0; i < per_client; i += 50) {
+                    for (int j = i; j < i + 50; ++j) client.send_put(key(c * per_client + j), "c" + std::to_string(c));
+                    for (int j = i; j < i + 50; ++j) {
+                        if (client.read_response() != ResponseStatus::kOk) ++failures[static_cast<size_t>(c)];
+                    }
+                }
+                for (int j = 0; j < per_client; ++j) {
+                    if (client.get(key(c * per_client + j)) != "c" + std::to_string(c)) {
+                        ++failures[static_cast<size_t>(c)];
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        for (int c = 0; c < clients; ++c) EXPECT_EQ(failures[static_cast<size_t>(c)], 0) << c;
+        EXPECT_EQ(server.stats().connections, static_cast<uint64_t>(clients));
+    }
+
+    KVStore store(dir_);
+    for (int c = 0; c < clients; ++c) {
+        EXPECT_EQ(store.get(key(c * per_client + per_client - 1)).value_or(""), "c" + std::to_string(c));
+    }
+}
+
+/**
+ * @brief 协议错误（包括发给没有 Raft 节点的服务端的 kRaftMessage）只关闭出错的连接，
+ *        服务端继续为其他连接服务
+ */
+TEST_F(KVServerTest, InvalidFrameClosesConnection) {
+    KVStore store(dir_);
+    KVServer server(store, ServerOptions{"127.0.0.1", 0, 1});
+    server.start();
+
+    std::string raft_frame;
+    append_request(raft_frame, RequestOp::kRaftMessage, {}, "raft");
+    for (std::string frame : {std::string("\x05\x00\x00\x00\x09garbage", 12), raft_frame}) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(server.port());
+        ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        ASSERT_EQ(::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)), 0);
+        ASSERT_GT(::send(fd, frame.data(), frame.size(), MSG_NOSIGNAL), 0);
+        char buf[16];
+        EXPECT_EQ(::recv(fd, buf, sizeof(buf), 0), 0) << "server should close the connection";
+        ::close(fd);
+    }
+
+    KVClient client("127.0.0.1", server.port());
+    client.put("still", "alive");
+    EXPECT_EQ(client.get("still").value_or(""), "alive");
+}
@@ -1,6 +1,14 @@
 #include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
+#include <limits>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
 #include "kv_store.h"
 #include "wal_record.h"
 
@@ -127,9 +135,9 @@ TEST_F(KVStoreTest, WALPersistenceCheck) {
     std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
     
     // 应该能找到 key 和 value 的痕迹
-    // 注意：int key=1 被转为 string "1"
+    // 注意：int key=1 被编码为 4 字节的保序二进制 (80 00 00 01)
     EXPECT_NE(content.find("persistent_val"), std::string::npos);
-    EXPECT_NE(content.find("1"), std::string::npos); // key "1"
+    EXPECT_NE(content.find(encode_int_key(1)), std::string::npos); // key 1
 }
 
 /**
@@ -268,8 +276,7 @@ TEST_F(WALReplayTest, TruncateMidRecord) {
     }
 
     fs::path wal_path = fs::path(test_dir_) / "wal.log";
-    LogRecord r1{LogType::kPut, "1", "v1"};
-    const auto r1_encoded = encode_log_record(r1);
+    const auto r1_encoded = encode_sequenced_log_record(LogType::kPut, encode_int_key(1), "v1");
     fs::resize_file(wal_path, r1_encoded.size() + 6);
 
     {
@@ -295,8 +302,8 @@ TEST_F(WALReplayTest, CorruptMiddleRecordStopsAtPrefix) {
     std::vector<size_t> record_sizes;
     record_sizes.reserve(10);
     for (int i = 1; i <= 10; ++i) {
-        LogRecord r{LogType::kPut, std::to_string(i), "v" + std::to_string(i)};
-        record_sizes.push_back(encode_log_record(r).size());
+        record_sizes.push_back(
+            encode_sequenced_log_record(LogType::kPut, encode_int_key(i), "v" + std::to_string(i)).size());
     }
 
     size_t offset = 0;
@@ -322,3 +329,1865 @@ TEST_F(WALReplayTest, CorruptMiddleRecordStopsAtPrefix) {
         }
     }
 }
+
+/**
+ * @brief WAL 同步策略测试（kPerWrite / kGroupCommit / kPeriodic）
+ */
+class WalSyncModeTest : public KVStoreTest {};
+
+/**
+ * @brief 默认 kPerWrite：每条记录单独成批，每次写入都 fsync 一次
+ */
+TEST_F(WalSyncModeTest, PerWriteSyncsEveryRecord) {
+    KVStore store(test_dir_);
+    for (int i = 0; i < 10; ++i) {
+        store.put(i, "v" + std::to_string(i));
+    }
+    store.del(3);
+
+    WalStats stats = store.wal_stats();
+    EXPECT_EQ(stats.records, 11u);
+    EXPECT_EQ(stats.write_groups, 11u);
+    EXPECT_EQ(stats.syncs, 11u);
+    EXPECT_EQ(stats.max_group_size, 1u);
+}
+
+/**
+ * @brief 组提交：多线程并发写入时，多条记录共享一次 fsync，且重启后全部可恢复
+ */
+TEST_F(WalSyncModeTest, GroupCommitBatchesConcurrentWriters) {
+    constexpr int kThreads = 8;
+    constexpr int kPerThread = 50;
+
+    KVStoreOptions options;
+    options.sync_mode = WalSyncMode::kGroupCommit;
+    options.group_commit_max_delay = std::chrono::microseconds(2000);
+
+    {
+        KVStore store(test_dir_, options);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&store, t] {
+                for (int i = 0; i < kPerThread; ++i) {
+                    int key = t * kPerThread + i;
+                    store.put(key, "v" + std::to_string(key));
+                }
+            });
+        }
+        for (auto& th : threads) th.join();
+
+        WalStats stats = store.wal_stats();
+        EXPECT_EQ(stats.records, static_cast<uint64_t>(kThreads * kPerThread));
+        EXPECT_EQ(stats.syncs, stats.write_groups);
+        EXPECT_LT(stats.write_groups, stats.records) << "writers should have shared fsyncs";
+        EXPECT_GT(stats.avg_group_size(), 1.0);
+    }
+
+    {
+        KVStore store(test_dir_, options);
+        for (int key = 0; key < kThreads * kPerThread; ++key) {
+            auto v = store.get(key);
+            ASSERT_TRUE(v.has_value()) << "key " << key;
+            EXPECT_EQ(v.value(), "v" + std::to_string(key));
+        }
+    }
+}
+
+/**
+ * @brief 组提交下 del 的返回值仍由 MemTable 的真实结果决定
+ */
+TEST_F(WalSyncModeTest, GroupCommitDeleteResult) {
+    KVStoreOptions options;
+    options.sync_mode = WalSyncMode::kGroupCommit;
+    KVStore store(test_dir_, options);
+
+    store.put(1, "one");
+    EXPECT_TRUE(store.del(1));
+    EXPECT_FALSE(store.del(1));
+    EXPECT_FALSE(store.get(1).has_value());
+}
+
+/**
+ * @brief 周期同步：写入不等待 fsync，正常关闭后数据仍可恢复
+ */
+TEST_F(WalSyncModeTest, PeriodicSyncRecoversAfterClose) {
+    KVStoreOptions options;
+    options.sync_mode = WalSyncMode::kPeriodic;
+    options.periodic_sync_interval = std::chrono::milliseconds(5);
+
+    {
+        KVStore store(test_dir_, options);
+        for (int i = 0; i < 100; ++i) {
+            store.put(i, "p" + std::to_string(i));
+        }
+        EXPECT_EQ(store.wal_stats().records, 100u);
+    }
+
+    {
+        KVStore store(test_dir_, options);
+        for (int i = 0; i < 100; ++i) {
+            auto v = store.get(i);
+            ASSERT_TRUE(v.has_value());
+            EXPECT_EQ(v.value(), "p" + std::to_string(i));
+        }
+    }
+}
+
+/**
+ * @brief WriteBatch：多键原子写入测试
+ */
+class WriteBatchStoreTest : public KVStoreTest {};
+
+/**
+ * @brief 一个批次只产生一条 WAL 记录、一次 fsync，并整体应用到 MemTable
+ */
+TEST_F(WriteBatchStoreTest, AppliesBatchWithSingleRecord) {
+    KVStore store(test_dir_);
+    store.put(100, "old");
+
+    WriteBatch batch;
+    for (int i = 0; i < 50; ++i) {
+        batch.put(i, "b" + std::to_string(i));
+    }
+    batch.del(100);
+    store.write(batch);
+
+    WalStats stats = store.wal_stats();
+    EXPECT_EQ(stats.records, 2u);
+    EXPECT_EQ(stats.syncs, 2u);
+
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_EQ(store.get(i).value_or(""), "b" + std::to_string(i));
+    }
+    EXPECT_FALSE(store.get(100).has_value());
+}
+
+/**
+ * @brief 批次内同一 key 的多次操作按顺序生效，且重启后可恢复
+ */
+TEST_F(WriteBatchStoreTest, RecoversBatchInOrder) {
+    {
+        KVStore store(test_dir_);
+        WriteBatch batch;
+        batch.put(1, "a");
+        batch.put(1, "b");
+        batch.put(2, "x");
+        batch.del(2);
+        store.write(batch);
+        store.put(3, "after");
+    }
+
+    {
+        KVStore store(test_dir_);
+        EXPECT_EQ(store.get(1).value_or(""), "b");
+        EXPECT_FALSE(store.get(2).has_value());
+        EXPECT_EQ(store.get(3).value_or(""), "after");
+    }
+}
+
+/**
+ * @brief 批次记录在中途被截断时，整批都不应被恢复（All-or-Nothing）
+ */
+TEST_F(WriteBatchStoreTest, TornBatchIsDiscardedEntirely) {
+    size_t single_size = 0;
+    {
+        KVStore store(test_dir_);
+        store.put(1, "keep");
+        single_size = store.wal_stats().bytes;  // 预分配期间文件大小不反映写入量
+
+        WriteBatch batch;
+        for (int i = 10; i < 20; ++i) {
+            batch.put(i, "lost" + std::to_string(i));
+        }
+        store.write(batch);
+    }
+
+    fs::path wal_path = fs::path(test_dir_) / "wal.log";
+    uint64_t full_size = fs::file_size(wal_path);
+    fs::resize_file(wal_path, single_size + (full_size - single_size) / 2);
+
+    {
+        KVStore store(test_dir_);
+        EXPECT_EQ(store.get(1).value_or(""), "keep");
+        for (int i = 10; i < 20; ++i) {
+            EXPECT_FALSE(store.get(i).has_value()) << "key " << i;
+        }
+    }
+}
+
+/**
+ * @brief 空批次不写 WAL
+ */
+TEST_F(WriteBatchStoreTest, EmptyBatchIsNoop) {
+    KVStore store(test_dir_);
+    WriteBatch batch;
+    store.write(batch);
+    EXPECT_EQ(store.wal_stats().records, 0u);
+}
+
+/**
+ * @brief 并发读取不会看到只应用了一半的批次：
+ *        批次先写 b_i、再写大量填充、最后写 a_i，读到 b_i 时必须也能读到 a_i
+ */
+TEST_F(WriteBatchStoreTest, ConcurrentReadersNeverSeeTornBatch) {
+    KVStoreOptions options;
+    options.sync_mode = WalSyncMode::kPeriodic;
+    KVStore store(test_dir_, options);
+    const int rounds = 100;
+
+    std::thread writer([&] {
+        for (int i = 0; i < rounds; ++i) {
+            WriteBatch batch;
+            batch.put("b" + std::to_string(i), "1");
+            for (int f = 0; f < 2000; ++f) batch.put("filler" + std::to_string(f), std::to_string(i));
+            batch.put("a" + std::to_string(i), "1");
+            store.write(batch);
+        }
+    });
+
+    int torn = 0;
+    for (int i = 0; i < rounds; ++i) {
+        while (!store.get("b" + std::to_string(i)).has_value()) std::this_thread::yield();
+        if (!store.get("a" + std::to_string(i)).has_value()) ++torn;
+    }
+    writer.join();
+    EXPECT_EQ(torn, 0);
+}
+
+/**
+ * @brief 兼容性：旧格式（CRC32 校验）的 WAL 记录仍可正常重放
+ */
+TEST_F(WALReplayTest, ReplaysLegacyCrc32Records) {
+    fs::create_directories(test_dir_);
+    {
+        std::ofstream wal(fs::path(test_dir_) / "wal.log", std::ios::binary);
+        std::string r1 = encode_log_record(LogRecord{LogType::kPut, "1", "legacy"},
+                                           ChecksumType::kCrc32, KeyEncoding::kDecimal);
+        std::string r2 = encode_log_record(LogRecord{LogType::kPut, encode_int_key(2), "mixed"});
+        wal.write(r1.data(), static_cast<std::streamsize>(r1.size()));
+        wal.write(r2.data(), static_cast<std::streamsize>(r2.size()));
+    }
+
+    KVStore store(test_dir_);
+    EXPECT_EQ(store.get(1).value_or(""), "legacy");
+    EXPECT_EQ(store.get(2).value_or(""), "mixed");
+}
+
+/**
+ * @brief 兼容性：旧格式的十进制文本 Key（包括旧格式批次）仍可重放
+ */
+TEST_F(WALReplayTest, ReplaysLegacyDecimalKeys) {
+    fs::create_directories(test_dir_);
+    {
+        std::ofstream wal(fs::path(test_dir_) / "wal.log", std::ios::binary);
+        std::string r1 = encode_log_record(LogRecord{LogType::kPut, "-42", "neg"},
+                                           ChecksumType::kCrc32c, KeyEncoding::kDecimal);
+        std::string r2 = encode_log_record(LogRecord{LogType::kPut, "1234", "four_chars"},
+                                           ChecksumType::kCrc32c, KeyEncoding::kDecimal);
+        std::string r3 = encode_log_record(LogRecord{LogType::kDelete, "-42", ""},
+                                           ChecksumType::kCrc32c, KeyEncoding::kDecimal);
+        for (const auto* r : {&r1, &r2, &r3}) {
+            wal.write(r->data(), static_cast<std::streamsize>(r->size()));
+        }
+    }
+
+    KVStore store(test_dir_);
+    EXPECT_FALSE(store.get(-42).has_value());
+    EXPECT_EQ(store.get(1234).value_or(""), "four_chars");
+}
+
+/**
+ * @brief 负数 Key 与大 Value 经过二进制 Key 编码后同样可以恢复
+ */
+TEST_F(WALReplayTest, RecoversNegativeKeysAndLargeValues) {
+    const std::string big(3 << 20, 'x'); // 大于 WalReader 的默认缓冲区
+    {
+        KVStore store(test_dir_);
+        store.put(-7, "minus_seven");
+        store.put(std::numeric_limits<int>::min(), "min");
+        store.put(std::numeric_limits<int>::max(), big);
+        store.put(8, "after_big");
+    }
+
+    KVStore store(test_dir_);
+    EXPECT_EQ(store.get(-7).value_or(""), "minus_seven");
+    EXPECT_EQ(store.get(std::numeric_limits<int>::min()).value_or(""), "min");
+    EXPECT_EQ(store.get(std::numeric_limits<int>::max()).value_or(""), big);
+    EXPECT_EQ(store.get(8).value_or(""), "after_big");
+}
+
+/**
+ * @brief 重放统计：记录数与字节数与 WAL 内容一致
+ */
+TEST_F(WALReplayTest, ReportsRecoveryThroughput) {
+    {
+        KVStore store(test_dir_);
+        for (int i = 0; i < 500; ++i) {
+            store.put(i, "value_" + std::to_string(i));
+        }
+    }
+    // 正常关闭时 wal.log 被截断到实际长度；重新打开后会再次预分配
+    uint64_t wal_size = fs::file_size(fs::path(test_dir_) / "wal.log");
+
+    KVStore store(test_dir_);
+    const RecoveryStats& stats = store.recovery_stats();
+    EXPECT_EQ(stats.records, 500u);
+    EXPECT_EQ(stats.bytes, wal_size);
+    EXPECT_GT(stats.elapsed.count(), 0);
+    EXPECT_GT(stats.records_per_sec(), 0.0);
+    EXPECT_GT(stats.mb_per_sec(), 0.0);
+}
+
+/**
+ * @brief MemTable 冻结与后台落盘 (Flush) 测试
+ */
+class FlushTest : public KVStoreTest {
+protected:
+    size_t count_files(const std::string& prefix, const std::string& ext) const {
+        size_t n = 0;
+        for (const auto& entry : fs::directory_iterator(test_dir_)) {
+            std::string name = entry.path().filename().string();
+            if (name.rfind(prefix, 0) == 0 && entry.path().extension() == ext) ++n;
+        }
+        return n;
+    }
+};
+
+/**
+ * @brief MemTable 超过上限后被冻结并落盘为 L0 SSTable，对应的封存 WAL 段随后被删除
+ */
+TEST_F(FlushTest, FlushesFullMemTableToLevel0) {
+    KVStoreOptions options;
+    options.memtable_size_limit = 4 * 1024;
+    options.level0_compaction_trigger = 0;  // 只观察落盘
+
+    KVStore store(test_dir_, options);
+    std::string value(100, 'x');
+    for (int i = 0; i < 200; ++i) {
+        store.put(i, value);
+    }
+    store.flush();
+
+    FlushStats stats = store.flush_stats();
+    EXPECT_GE(stats.flushes, 2u);
+    EXPECT_EQ(stats.entries, 200u);
+    EXPECT_GT(stats.bytes_written, 200u * value.size());
+    EXPECT_EQ(store.num_immutable_memtables(), 0u);
+    EXPECT_EQ(store.num_level0_tables(), stats.flushes);
+
+    EXPECT_EQ(count_files("L0_", ".sst"), stats.flushes);
+    EXPECT_EQ(count_files("wal_", ".log"), 0u) << "sealed WAL segments should be recycled or deleted";
+    EXPECT_LE(count_files("wal_", ".recycle"), options.wal_recycle_limit);
+    ASSERT_TRUE(fs::exists(fs::path(test_dir_) / "wal.log"));
+    WalReader reader(fs::path(test_dir_) / "wal.log");
+    LogRecordView record;
+    EXPECT_EQ(reader.next(record), WalReader::Status::kEof) << "active WAL should be empty";
+}
+
+/**
+ * @brief 未满的 MemTable 不触发落盘；空 MemTable 调用 flush() 不生成文件
+ */
+TEST_F(FlushTest, FlushOfEmptyMemTableIsNoop) {
+    KVStore store(test_dir_);
+    store.put(1, "one");
+    EXPECT_EQ(store.num_level0_tables(), 0u);
+
+    store.flush();
+    EXPECT_EQ(store.num_level0_tables(), 1u);
+
+    store.flush();
+    EXPECT_EQ(store.num_level0_tables(), 1u);
+    EXPECT_EQ(store.flush_stats().flushes, 1u);
+}
+
+/**
+ * @brief 落盘时删除标记也写入 SSTable（用于遮蔽更老层中的旧值）
+ */
+TEST_F(FlushTest, TombstonesAreFlushed) {
+    KVStore store(test_dir_);
+    store.put(1, "one");
+    store.put(2, "two");
+    EXPECT_TRUE(store.del(1));
+    store.flush();
+
+    EXPECT_EQ(store.flush_stats().entries, 2u);
+}
+
+/**
+ * @brief 启动时按编号顺序重放封存的 WAL 段，最后重放 wal.log
+ */
+TEST_F(FlushTest, ReplaysSealedSegmentsInOrder) {
+    fs::path dir(test_dir_);
+    {
+        KVStore store(test_dir_);
+        store.put(1, "old");
+        store.put(2, "two");
+    }
+    fs::rename(dir / "wal.log", dir / wal_segment_name(3));
+    {
+        KVStore store(test_dir_);
+        store.put(1, "new");
+        store.del(2);
+    }
+    fs::rename(dir / "wal.log", dir / wal_segment_name(7));
+    {
+        KVStore store(test_dir_);
+        store.put(3, "three");
+    }
+
+    KVStore store(test_dir_);
+    EXPECT_EQ(store.get(1).value_or(""), "new");
+    EXPECT_FALSE(store.get(2).has_value());
+    EXPECT_EQ(store.get(3).value_or(""), "three");
+    EXPECT_EQ(store.recovery_stats().records, 5u);
+}
+
+/**
+ * @brief 活跃段写满后切换到新段：MemTable 尚未冻结时封存段同样被重放
+ */
+TEST_F(FlushTest, RollsWalSegmentWhenFull) {
+    KVStoreOptions options;
+    options.wal_segment_size = 4 * 1024;
+    std::string value(100, 'x');
+    {
+        KVStore store(test_dir_, options);
+        for (int i = 0; i < 200; ++i) {
+            store.put(i, value + std::to_string(i));
+        }
+        EXPECT_GE(store.wal_stats().segments, 5u);
+        EXPECT_EQ(store.num_level0_tables(), 0u);
+        EXPECT_EQ(count_files("wal_", ".log"), store.wal_stats().segments);
+    }
+
+    KVStore store(test_dir_, options);
+    EXPECT_EQ(store.recovery_stats().records, 200u);
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_EQ(store.get(i).value_or(""), value + std::to_string(i));
+    }
+}
+
+/**
+ * @brief 落盘后的 WAL 段被改名为 wal_<N>.recycle 并在切换时复用；
+ *        复用段中残留的旧记录在崩溃恢复时不会被重放
+ */
+TEST_F(FlushTest, RecyclesFlushedSegments) {
+    KVStoreOptions options;
+    options.memtable_size_limit = 4 * 1024;
+    options.level0_compaction_trigger = 0;
+    const std::string crash_dir = test_dir_ + "_crash";
+    fs::remove_all(crash_dir);
+    {
+        KVStore store(test_dir_, options);
+        for (int round = 0; round < 5; ++round) {
+            for (int i = 0; i < 40; ++i) {
+                store.put(i, "round" + std::to_string(round) + std::string(100, 'v'));
+            }
+            store.flush();
+        }
+        store.del(7);
+        EXPECT_GT(store.wal_stats().recycled_segments, 0u);
+        size_t recycled = count_files("wal_", ".recycle");
+        EXPECT_GT(recycled, 0u);
+        EXPECT_LE(recycled, options.wal_recycle_limit);
+
+        // 运行中的目录即崩溃现场：wal.log 是复用段，结尾之后仍残留旧记录
+        fs::copy(test_dir_, crash_dir, fs::copy_options::recursive);
+    }
+
+    for (const std::string& dir : {crash_dir, test_dir_}) {
+        KVStore store(dir, options);
+        EXPECT_EQ(store.recovery_stats().records, 1u) << dir;
+        for (int i = 0; i < 40; ++i) {
+            if (i == 7) {
+                EXPECT_FALSE(store.get(i).has_value());
+            } else {
+                ASSERT_EQ(store.get(i).value_or(""), "round4" + std::string(100, 'v')) << dir;
+            }
+        }
+    }
+    fs::remove_all(crash_dir);
+}
+
+/**
+ * @brief wal_direct_io：对齐写入的 WAL 在崩溃与正常关闭后都能完整恢复
+ */
+TEST_F(FlushTest, DirectIoWalRecovers) {
+    KVStoreOptions options;
+    options.wal_direct_io = true;
+    options.wal_segment_size = 16 * 1024;
+    const std::string crash_dir = test_dir_ + "_crash";
+    fs::remove_all(crash_dir);
+    {
+        KVStore store(test_dir_, options);
+        for (int i = 0; i < 300; ++i) {
+            store.put(i, std::string(static_cast<size_t>(i % 97), 'd'));
+        }
+        fs::copy(test_dir_, crash_dir, fs::copy_options::recursive);
+    }
+
+    for (const std::string& dir : {crash_dir, test_dir_}) {
+        KVStore store(dir, options);
+        EXPECT_EQ(store.recovery_stats().records, 300u) << dir;
+        for (int i = 0; i < 300; ++i) {
+            ASSERT_EQ(store.get(i).value_or("missing"), std::string(static_cast<size_t>(i % 97), 'd')) << dir;
+        }
+    }
+    fs::remove_all(crash_dir);
+}
+
+/**
+ * @brief 新文件编号不会与已有的 WAL 段 / SSTable 冲突；遗留的 *.tmp 文件在启动时被清理
+ */
+TEST_F(FlushTest, ResumesFileNumbersAndRemovesTempFiles) {
+    fs::path dir(test_dir_);
+    fs::create_directories(dir);
+    { std::ofstream(dir / (table_file_name(0, 41) + ".tmp")) << "partial"; }
+
+    {
+        KVStore store(test_dir_);
+        store.put(1, "one");
+        store.flush();
+    }
+    EXPECT_FALSE(fs::exists(dir / (table_file_name(0, 41) + ".tmp")));
+
+    {
+        KVStore store(test_dir_);
+        store.put(2, "two");
+        store.flush();
+    }
+
+    std::vector<uint64_t> numbers;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        int level = 0;
+        uint64_t number = 0;
+        if (parse_table_file_name(entry.path().filename().string(), &level, &number)) {
+            EXPECT_EQ(level, 0);
+            numbers.push_back(number);
+        }
+    }
+    ASSERT_EQ(numbers.size(), 2u);
+    EXPECT_NE(numbers[0], numbers[1]);
+}
+
+/**
+ * @brief 多线程持续写入时，落盘在后台进行，所有写入都成功返回
+ */
+TEST_F(FlushTest, ConcurrentWritesDuringFlush) {
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 500;
+
+    KVStoreOptions options;
+    options.sync_mode = WalSyncMode::kGroupCommit;
+    options.memtable_size_limit = 16 * 1024;
+
+    KVStore store(test_dir_, options);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&store, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                store.put(t * kPerThread + i, std::string(64, 'a' + t));
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    store.flush();
+
+    FlushStats stats = store.flush_stats();
+    EXPECT_GT(stats.flushes, 1u);
+    EXPECT_EQ(stats.entries, static_cast<uint64_t>(kThreads * kPerThread));
+    EXPECT_EQ(count_files("wal_", ".log"), 0u);
+}
+
+/**
+ * @brief 读请求不获取写入锁：写入、冻结与后台落盘期间，已写入的 Key 始终可读
+ */
+TEST_F(FlushTest, ReadsNeverMissWrittenKeysDuringFlush) {
+    constexpr int kKeys = 3000;
+
+    KVStoreOptions options;
+    options.sync_mode = WalSyncMode::kPeriodic;
+    options.memtable_size_limit = 8 * 1024;
+
+    KVStore store(test_dir_, options);
+    std::atomic<int> written{0};
+    std::atomic<int> failures{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&, r] {
+            std::minstd_rand rnd(static_cast<unsigned>(r + 1));
+            int n;
+            while ((n = written.load(std::memory_order_acquire)) < kKeys) {
+                if (n == 0) continue;
+                int key = static_cast<int>(rnd() % static_cast<unsigned>(n));
+                if (store.get(key) != std::to_string(key)) failures.fetch_add(1);
+            }
+        });
+    }
+    for (int i = 0; i < kKeys; ++i) {
+        store.put(i, std::to_string(i));
+        written.store(i + 1, std::memory_order_release);
+    }
+    for (auto& t : readers) t.join();
+
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_GT(store.flush_stats().flushes, 0u);
+}
+
+/**
+ * @brief 落盘后的数据由 SSTable 提供读取，重启后依然可读
+ */
+TEST_F(FlushTest, ReadsFlushedDataAfterRestart) {
+    KVStoreOptions options;
+    options.memtable_size_limit = 4 * 1024;
+
+    {
+        KVStore store(test_dir_, options);
+        for (int i = 0; i < 300; ++i) {
+            store.put(i, "v" + std::to_string(i));
+        }
+        store.put(7, "seven");
+        store.flush();
+        ASSERT_GE(store.flush_stats().flushes, 2u);
+
+        for (int i = 0; i < 300; ++i) {
+            std::string expected = i == 7 ? "seven" : "v" + std::to_string(i);
+            EXPECT_EQ(store.get(i).value_or("<missing>"), expected) << "key " << i;
+        }
+        EXPECT_FALSE(store.get(300).has_value());
+        EXPECT_FALSE(store.get(-1).has_value());
+    }
+
+    KVStore store(test_dir_, options);
+    EXPECT_EQ(store.recovery_stats().records, 0u) << "flushed data must not be replayed";
+    for (int i = 0; i < 300; ++i) {
+        std::string expected = i == 7 ? "seven" : "v" + std::to_string(i);
+        EXPECT_EQ(store.get(i).value_or("<missing>"), expected) << "key " << i;
+    }
+}
+
+/**
+ * @brief 并行重放：多个 WAL 段中的覆盖写、删除与批次按序列号恢复，结果与顺序重放相同；
+ *        重放出的 MemTable 落盘前崩溃（不落盘直接关闭）时，下次启动仍完整重放
+ */
+TEST_F(FlushTest, ParallelReplayMatchesSerialReplay) {
+    KVStoreOptions options;
+    options.wal_segment_size = 8 * 1024;
+    options.level0_compaction_trigger = 0;
+    std::map<int, std::string> model;
+    {
+        KVStore store(test_dir_, options);
+        std::mt19937 rng(7);
+        for (int i = 0; i < 2000; ++i) {
+            int key = static_cast<int>(rng() % 300);
+            if (i % 7 == 0) {
+                store.del(key);
+                model.erase(key);
+            } else if (i % 50 == 0) {
+                WriteBatch batch;
+                batch.put(key, "batch" + std::to_string(i));
+                batch.del(key + 1);
+                store.write(batch);
+                model[key] = "batch" + std::to_string(i);
+                model.erase(key + 1);
+            } else {
+                store.put(key, "v" + std::to_string(i));
+                model[key] = "v" + std::to_string(i);
+            }
+        }
+        ASSERT_GE(store.wal_stats().segments, 3u);
+    }
+
+    auto verify = [&](KVStore& store) {
+        for (int key = 0; key <= 300; ++key) {
+            auto it = model.find(key);
+            ASSERT_EQ(store.get(key).value_or("<missing>"), it == model.end() ? "<missing>" : it->second)
+                << "key " << key;
+        }
+    };
+
+    options.recovery_threads = 4;
+    {
+        KVStore store(test_dir_, options);
+        EXPECT_EQ(store.recovery_stats().records, 2000u);
+        verify(store);
+        store.put(1000, "after");
+        model[1000] = "after";
+    }
+
+    options.recovery_threads = 1;
+    KVStore store(test_dir_, options);
+    verify(store);
+    EXPECT_EQ(store.get(1000).value_or(""), "after");
+    store.put(0, "newest");
+    EXPECT_EQ(store.get(0).value_or(""), "newest");
+}
+
+/**
+ * @brief flush_recovered_memtables：重放的数据在构造阶段直接写成 L0 SSTable，WAL 段被回收，
+ *        再次启动时没有需要重放的记录
+ */
+TEST_F(FlushTest, FlushesRecoveredMemTablesOnStartup) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    options.wal_recycle_limit = 0;
+    for (size_t threads : {1u, 3u}) {
+        fs::remove_all(test_dir_);
+        {
+            KVStore store(test_dir_, options);
+            for (int i = 0; i < 300; ++i) store.put(i, "v" + std::to_string(i));
+            store.del(5);
+        }
+
+        KVStoreOptions reopen = options;
+        reopen.recovery_threads = threads;
+        reopen.flush_recovered_memtables = true;
+        {
+            KVStore store(test_dir_, reopen);
+            EXPECT_EQ(store.recovery_stats().records, 301u);
+            EXPECT_GE(store.recovery_stats().flushed_tables, 1u);
+            EXPECT_LE(store.recovery_stats().flushed_tables, threads);
+            EXPECT_EQ(store.num_level0_tables(), store.recovery_stats().flushed_tables);
+            EXPECT_EQ(store.num_immutable_memtables(), 0u);
+            EXPECT_EQ(count_files("wal_", ".log"), 0u);
+            EXPECT_FALSE(store.get(5).has_value());
+            EXPECT_EQ(store.get(299).value_or(""), "v299");
+            store.put(5, "five");
+        }
+
+        KVStore store(test_dir_, options);
+        EXPECT_EQ(store.recovery_stats().records, 1u) << threads;
+        EXPECT_EQ(store.get(5).value_or(""), "five");
+        EXPECT_EQ(store.get(0).value_or(""), "v0");
+    }
+}
+
+/**
+ * @brief recovery_threads > 1 时启动阶段在后台打开全部 SSTable 的读取器（Index 与 Filter）
+ */
+TEST_F(FlushTest, ParallelRecoveryOpensTables) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    {
+        KVStore store(test_dir_, options);
+        for (int round = 0; round < 4; ++round) {
+            for (int i = 0; i < 50; ++i) store.put(round * 100 + i, "v");
+            store.flush();
+        }
+    }
+    {
+        KVStore store(test_dir_, options);
+        EXPECT_EQ(store.recovery_stats().tables_opened, 0u);
+    }
+
+    options.recovery_threads = 2;
+    KVStore store(test_dir_, options);
+    EXPECT_EQ(store.recovery_stats().tables_opened, 4u);
+    EXPECT_EQ(store.get(349).value_or(""), "v");
+}
+
+/**
+ * @brief 新的删除标记遮蔽 SSTable 中的旧值；del 能识别只存在于 SSTable 中的 key
+ */
+TEST_F(FlushTest, TombstoneShadowsFlushedValue) {
+    {
+        KVStore store(test_dir_);
+        store.put(1, "one");
+        store.put(2, "two");
+        store.flush();
+
+        EXPECT_TRUE(store.del(1));
+        EXPECT_FALSE(store.del(1));
+        EXPECT_FALSE(store.del(3));
+        EXPECT_FALSE(store.get(1).has_value());
+        EXPECT_EQ(store.get(2).value_or(""), "two");
+    }
+    {
+        KVStore store(test_dir_);
+        EXPECT_FALSE(store.get(1).has_value());
+        store.flush();
+        EXPECT_FALSE(store.get(1).has_value());
+        store.put(1, "again");
+        store.flush();
+    }
+
+    KVStore store(test_dir_);
+    EXPECT_EQ(store.get(1).value_or(""), "again");
+    EXPECT_EQ(store.get(2).value_or(""), "two");
+}
+
+/**
+ * @brief 落盘后的读取经过块缓存；多个 KVStore 可以共享同一个缓存
+ */
+TEST_F(FlushTest, ReadsGoThroughBlockCache) {
+    KVStoreOptions options;
+    options.table_options.block_cache = std::make_shared<BlockCache>(1 << 20);
+
+    KVStore store(test_dir_, options);
+    for (int i = 0; i < 100; ++i) {
+        store.put(i, "v" + std::to_string(i));
+    }
+    store.flush();
+
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_EQ(store.get(i).value_or(""), "v" + std::to_string(i));
+        }
+    }
+    BlockCacheStats stats = store.block_cache_stats();
+    EXPECT_GT(stats.hits, stats.misses);
+    EXPECT_EQ(stats.capacity, 1u << 20);
+    EXPECT_EQ(options.table_options.block_cache->Stats().hits, stats.hits);
+}
+
+/**
+ * @brief block_cache_capacity = 0 时不使用缓存，读取依然正确
+ */
+TEST_F(FlushTest, BlockCacheCanBeDisabled) {
+    KVStoreOptions options;
+    options.block_cache_capacity = 0;
+
+    KVStore store(test_dir_, options);
+    store.put(1, "one");
+    store.flush();
+    EXPECT_EQ(store.get(1).value_or(""), "one");
+    EXPECT_EQ(store.block_cache_stats().capacity, 0u);
+}
+
+/**
+ * @brief compression_per_level 覆盖 L0 的压缩算法；压缩后的表重启后依然可读
+ *
+ * 未编译进来的算法退回不压缩，此时只验证读取正确。
+ */
+TEST_F(FlushTest, CompressesLevel0TablesPerLevel) {
+    const std::string value =
+        "{\"status\":\"active\",\"region\":\"cn-east-1\",\"tags\":[\"a\",\"b\",\"c\"]}";
+    uint64_t plain_bytes = 0;
+    {
+        KVStore store(test_dir_);
+        for (int i = 0; i < 1000; ++i) store.put(i, value);
+        store.flush();
+        plain_bytes = store.flush_stats().bytes_written;
+    }
+    fs::remove_all(test_dir_);
+
+    KVStoreOptions options;
+    options.compression_per_level = {CompressionType::kLz4, CompressionType::kZstd};
+    {
+        KVStore store(test_dir_, options);
+        for (int i = 0; i < 1000; ++i) store.put(i, value);
+        store.flush();
+        uint64_t bytes = store.flush_stats().bytes_written;
+        if (compression_supported(CompressionType::kLz4)) {
+            EXPECT_LT(bytes, plain_bytes / 2);
+        } else {
+            EXPECT_EQ(bytes, plain_bytes);
+        }
+    }
+
+    KVStore store(test_dir_, options);
+    for (int i = 0; i < 1000; i += 17) {
+        EXPECT_EQ(store.get(i).value_or(""), value) << i;
+    }
+}
+
+// ==========================================
+// Compaction
+// ==========================================
+
+class CompactionTest : public FlushTest {
+protected:
+    /// 轮询等待后台线程达到某个状态（最多 10 秒）
+    template <typename Pred>
+    static bool wait_until(Pred pred) {
+        for (int i = 0; i < 1000; ++i) {
+            if (pred()) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return pred();
+    }
+
+    size_t count_tables() const {
+        size_t n = 0;
+        for (const auto& entry : fs::directory_iterator(test_dir_)) {
+            int level = 0;
+            uint64_t number = 0;
+            if (parse_table_file_name(entry.path().filename().string(), &level, &number)) ++n;
+        }
+        return n;
+    }
+};
+
+/**
+ * @brief L0 文件数达到阈值后自动合并到 L1，输入文件被删除
+ */
+TEST_F(CompactionTest, Level0TriggerCompactsIntoLevel1) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 3;
+
+    KVStore store(test_dir_, options);
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 100; ++i) {
+            store.put(i, "r" + std::to_string(round) + "_" + std::to_string(i));
+        }
+        store.flush();
+    }
+
+    ASSERT_TRUE(wait_until([&] { return store.compaction_stats().compactions >= 1; }));
+    EXPECT_EQ(store.num_level0_tables(), 0u);
+    EXPECT_GE(store.num_tables_at_level(1), 1u);
+
+    CompactionStats stats = store.compaction_stats();
+    EXPECT_EQ(stats.input_files, 3u);
+    EXPECT_EQ(stats.entries_dropped, 200u) << "two older versions of each key are shadowed";
+    EXPECT_EQ(count_tables(), store.num_tables_at_level(1));
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(store.get(i).value_or(""), "r2_" + std::to_string(i));
+    }
+}
+
+/**
+ * @brief 全量 Compaction 丢弃被遮蔽的旧版本与删除标记；结果在重启后保持不变
+ */
+TEST_F(CompactionTest, ManualCompactionDropsShadowedVersionsAndTombstones) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;  // 只由 compact() 触发
+
+    {
+        KVStore store(test_dir_, options);
+        for (int i = 0; i < 100; ++i) store.put(i, "old");
+        store.flush();
+        for (int i = 0; i < 50; ++i) store.put(i, "new");
+        store.flush();
+        for (int i = 0; i < 10; ++i) EXPECT_TRUE(store.del(i));
+        store.compact();
+
+        EXPECT_EQ(store.num_level0_tables(), 0u);
+        EXPECT_EQ(count_tables(), store.num_tables_at_level(1));
+        CompactionStats stats = store.compaction_stats();
+        EXPECT_EQ(stats.compactions, 1u);
+        EXPECT_EQ(stats.tombstones_dropped, 10u);
+        EXPECT_EQ(stats.entries_dropped, 50u + 10u);
+
+        for (int i = 0; i < 100; ++i) {
+            std::optional<std::string> value = store.get(i);
+            if (i < 10) {
+                EXPECT_FALSE(value.has_value()) << i;
+            } else {
+                EXPECT_EQ(value.value_or(""), i < 50 ? "new" : "old") << i;
+            }
+        }
+        EXPECT_FALSE(store.del(3));
+    }
+
+    KVStore store(test_dir_, options);
+    EXPECT_EQ(store.num_tables_at_level(1), count_tables());
+    EXPECT_FALSE(store.get(3).has_value());
+    EXPECT_EQ(store.get(30).value_or(""), "new");
+    EXPECT_EQ(store.get(70).value_or(""), "old");
+}
+
+/**
+ * @brief 数据沉到多层时，上层的删除标记在确认更深层没有旧值前不会被丢弃
+ *
+ * 极小的层目标大小让数据迅速沉到最底层；随机写入 / 删除期间和之后，
+ * 读结果始终与参照模型一致。
+ */
+TEST_F(CompactionTest, DeletesStayDeletedAcrossLevels) {
+    KVStoreOptions options;
+    options.memtable_size_limit = 8 * 1024;
+    options.num_levels = 4;
+    options.level0_compaction_trigger = 2;
+    options.max_bytes_for_level_base = 8 * 1024;
+    options.max_bytes_for_level_multiplier = 2;
+    options.target_file_size = 8 * 1024;
+
+    std::map<int, std::string> model;
+    std::mt19937 rng(2024);
+    {
+        KVStore store(test_dir_, options);
+        for (int i = 0; i < 6000; ++i) {
+            int key = static_cast<int>(rng() % 800);
+            if (rng() % 4 == 0) {
+                EXPECT_EQ(store.del(key), model.erase(key) > 0) << "op " << i;
+            } else {
+                std::string value = std::to_string(i) + std::string(40, 'v');
+                store.put(key, value);
+                model[key] = value;
+            }
+            if (i % 1000 == 999) {
+                for (int k = 0; k < 800; k += 7) {
+                    auto it = model.find(k);
+                    ASSERT_EQ(store.get(k), it == model.end() ? std::nullopt
+                                                             : std::optional<std::string>(it->second))
+                        << "key " << k << " after op " << i;
+                }
+            }
+        }
+        store.compact();
+        EXPECT_GT(store.num_tables_at_level(options.num_levels - 1), 0u);
+        EXPECT_GT(store.compaction_stats().compactions, 1u);
+        EXPECT_GT(store.compaction_stats().tombstones_dropped, 0u);
+    }
+
+    KVStore store(test_dir_, options);
+    for (int k = 0; k < 800; ++k) {
+        auto it = model.find(k);
+        ASSERT_EQ(store.get(k),
+                  it == model.end() ? std::nullopt : std::optional<std::string>(it->second))
+            << "key " << k;
+    }
+}
+
+/**
+ * @brief Compaction 写入受 compaction_bytes_per_sec 限速
+ */
+TEST_F(CompactionTest, RateLimitsCompactionWrites) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    options.compaction_bytes_per_sec = 256 * 1024;
+
+    KVStore store(test_dir_, options);
+    for (int i = 0; i < 1000; ++i) store.put(i, std::string(100, 'x'));
+    store.compact();
+
+    CompactionStats stats = store.compaction_stats();
+    ASSERT_GT(stats.bytes_written, 64u * 1024);
+    EXPECT_GT(stats.rate_limit_wait.count(), 0);
+}
+
+/**
+ * @brief 启动时删除与更新文件重叠的 L1 旧文件（Compaction 安装输出后、删除输入前崩溃的残留）
+ */
+TEST_F(CompactionTest, RemovesLeftoverCompactionInputsOnStartup) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    {
+        KVStore store(test_dir_, options);
+        for (int i = 0; i < 10; ++i) store.put(i, "fresh");
+        store.compact();
+        ASSERT_EQ(store.num_tables_at_level(1), 1u);
+    }
+
+    // 模拟残留：编号更小（更旧）、Key 范围重叠的 L1 文件
+    fs::path stale = fs::path(test_dir_) / table_file_name(1, 0);
+    {
+        SSTableBuilder builder(stale.string());
+        builder.Add(encode_int_key(5), encode_table_value(ValueType::kValue, "stale"));
+        builder.Finish();
+    }
+
+    KVStore store(test_dir_, options);
+    EXPECT_EQ(store.num_tables_at_level(1), 1u);
+    EXPECT_EQ(store.get(5).value_or(""), "fresh");
+    EXPECT_FALSE(fs::exists(stale));
+}
+
+/**
+ * @brief 重启时从 MANIFEST 恢复文件集合：不重放已落盘的 WAL 段，读取器按需打开
+ */
+TEST_F(CompactionTest, RestartRecoversTablesFromManifest) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    {
+        KVStore store(test_dir_, options);
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < 50; ++i) store.put(round * 100 + i, "v" + std::to_string(i));
+            store.flush();
+        }
+        store.del(120);
+        store.flush();
+        ASSERT_EQ(store.num_level0_tables(), 4u);
+    }
+    EXPECT_TRUE(fs::exists(fs::path(test_dir_) / kCurrentFileName));
+
+    KVStore store(test_dir_, options);
+    EXPECT_EQ(store.num_level0_tables(), 4u);
+    EXPECT_EQ(store.recovery_stats().tables, 4u);
+    EXPECT_GE(store.recovery_stats().manifest_edits, 1u);
+    EXPECT_EQ(store.recovery_stats().records, 0u);  // 数据都已落盘，没有 WAL 需要重放
+    EXPECT_EQ(store.get(249).value_or(""), "v49");
+    EXPECT_FALSE(store.get(120).has_value());
+    EXPECT_EQ(store.get(0).value_or(""), "v0");
+
+    // 每次启动都写入新的 MANIFEST 并删除旧的
+    size_t manifests = 0;
+    for (const auto& entry : fs::directory_iterator(test_dir_)) {
+        uint64_t number = 0;
+        if (parse_manifest_file_name(entry.path().filename().string(), &number)) ++manifests;
+    }
+    EXPECT_EQ(manifests, 1u);
+}
+
+/**
+ * @brief 没有 MANIFEST 的旧目录在启动时通过扫描迁移，之后的重启使用 MANIFEST
+ */
+TEST_F(CompactionTest, MigratesDirectoryWithoutManifest) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    {
+        KVStore store(test_dir_, options);
+        for (int i = 0; i < 100; ++i) store.put(i, "old");
+        store.compact();
+        for (int i = 0; i < 10; ++i) store.put(i, "new");
+        store.flush();
+    }
+    for (const auto& entry : fs::directory_iterator(test_dir_)) {
+        uint64_t number = 0;
+        std::string name = entry.path().filename().string();
+        if (name == kCurrentFileName || parse_manifest_file_name(name, &number)) {
+            fs::remove(entry.path());
+        }
+    }
+
+    {
+        KVStore store(test_dir_, options);
+        EXPECT_EQ(store.recovery_stats().manifest_edits, 0u);
+        EXPECT_EQ(store.num_level0_tables(), 1u);
+        EXPECT_EQ(store.num_tables_at_level(1), 1u);
+        EXPECT_EQ(store.get(5).value_or(""), "new");
+        EXPECT_EQ(store.get(50).value_or(""), "old");
+    }
+    EXPECT_TRUE(fs::exists(fs::path(test_dir_) / kCurrentFileName));
+
+    KVStore store(test_dir_, options);
+    EXPECT_GE(store.recovery_stats().manifest_edits, 1u);
+    EXPECT_EQ(store.get(5).value_or(""), "new");
+}
+
+/**
+ * @brief MANIFEST 引用的 SSTable 缺失时拒绝启动
+ */
+TEST_F(CompactionTest, MissingTableReferencedByManifestFailsStartup) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    {
+        KVStore store(test_dir_, options);
+        store.put(1, "a");
+        store.flush();
+    }
+    for (const auto& entry : fs::directory_iterator(test_dir_)) {
+        int level = 0;
+        uint64_t number = 0;
+        if (parse_table_file_name(entry.path().filename().string(), &level, &number)) {
+            fs::remove(entry.path());
+        }
+    }
+    EXPECT_THROW(KVStore(test_dir_, options), std::runtime_error);
+}
+
+// ==========================================
+// 字节串 Key 与自定义比较器
+// ==========================================
+
+namespace {
+    /// 按字节序的逆序排列
+    class ReverseComparator : public Comparator {
+    public:
+        int Compare(std::string_view a, std::string_view b) const override {
+            return BytewiseComparator()->Compare(b, a);
+        }
+        const char* Name() const override { return "test.ReverseComparator"; }
+    };
+
+    std::string string_key(int i) { return "user:" + std::to_string(i); }
+}
+
+/**
+ * @brief 任意字节串 Key 经过 MemTable、落盘、Compaction 与重启后都能按原样读出
+ */
+TEST_F(CompactionTest, BinaryKeysSurviveFlushCompactionAndRestart) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    std::string nul("\0k\0", 3);
+    {
+        KVStore store(test_dir_, options);
+        store.put("", "empty");
+        store.put(nul, "nul");
+        for (int i = 0; i < 200; ++i) store.put(string_key(i), "v" + std::to_string(i));
+        store.flush();
+        for (int i = 0; i < 200; i += 2) store.del(string_key(i));
+        store.put("user:", "prefix");
+        store.flush();
+        store.compact();
+        EXPECT_EQ(store.num_level0_tables(), 0u);
+    }
+
+    KVStore store(test_dir_, options);
+    EXPECT_EQ(store.get("").value_or("<missing>"), "empty");
+    EXPECT_EQ(store.get(nul).value_or("<missing>"), "nul");
+    EXPECT_FALSE(store.get(std::string_view(nul.data(), 2)).has_value());
+    EXPECT_EQ(store.get("user:").value_or("<missing>"), "prefix");
+    for (int i = 0; i < 200; ++i) {
+        if (i % 2 == 0) {
+            EXPECT_FALSE(store.get(string_key(i)).has_value()) << i;
+        } else {
+            EXPECT_EQ(store.get(string_key(i)).value_or(""), "v" + std::to_string(i)) << i;
+        }
+    }
+    // int 重载与其 encode_int_key 编码指向同一个 Key
+    store.put(42, "int");
+    EXPECT_EQ(store.get(encode_int_key(42)).value_or(""), "int");
+}
+
+/**
+ * @brief 自定义比较器贯穿 MemTable、SSTable、Version 与 Compaction：
+ *        多层文件按逆序排列时读取结果依然正确
+ */
+TEST_F(CompactionTest, CustomComparatorOrdersAllLevels) {
+    ReverseComparator reverse;
+    KVStoreOptions options;
+    options.comparator = &reverse;
+    options.level0_compaction_trigger = 0;
+    options.target_file_size = 4 * 1024;  // Compaction 输出多个文件，覆盖层内二分查找
+    {
+        KVStore store(test_dir_, options);
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < 300; ++i) {
+                store.put(string_key(i), "r" + std::to_string(round) + std::string(32, 'x'));
+            }
+            store.flush();
+        }
+        store.compact();
+        EXPECT_GT(store.num_tables_at_level(1), 1u);
+        store.put(string_key(7), "fresh");
+    }
+
+    KVStore store(test_dir_, options);
+    EXPECT_EQ(store.get(string_key(7)).value_or(""), "fresh");
+    for (int i = 0; i < 300; ++i) {
+        if (i == 7) continue;
+        EXPECT_EQ(store.get(string_key(i)).value_or(""), "r2" + std::string(32, 'x')) << i;
+    }
+    EXPECT_FALSE(store.get("user:300").has_value());
+}
+
+/**
+ * @brief 用不同名字的比较器打开已有目录时拒绝启动（避免按错误的顺序读取数据）
+ */
+TEST_F(CompactionTest, ComparatorMismatchFailsStartup) {
+    {
+        KVStore store(test_dir_);
+        store.put("a", "1");
+        store.flush();
+    }
+    ReverseComparator reverse;
+    KVStoreOptions options;
+    options.comparator = &reverse;
+    EXPECT_THROW(KVStore(test_dir_, options), std::runtime_error);
+
+    KVStore store(test_dir_);
+    EXPECT_EQ(store.get("a").value_or(""), "1");
+}
+
+/**
+ * @brief 零拷贝读取：值分别钉住 MemTable 与缓存的 Block，落盘、覆盖写与 Compaction 之后依然有效
+ */
+TEST_F(CompactionTest, PinnedGetSurvivesFlushAndCompaction) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    KVStore store(test_dir_, options);
+
+    std::string big(32 * 1024, 'm');
+    store.put("mem", big);
+    PinnableValue from_mem;
+    ASSERT_TRUE(store.get("mem", &from_mem));
+    EXPECT_TRUE(from_mem.pinned());
+
+    store.flush();  // 钉住的 MemTable 已被移出读路径
+    store.put("mem", "overwritten");
+    EXPECT_EQ(from_mem.view(), big);
+
+    PinnableValue from_table;
+    store.put("table", "on disk");
+    store.flush();
+    ASSERT_TRUE(store.get("table", &from_table));
+    EXPECT_TRUE(from_table.pinned());
+    EXPECT_EQ(from_table.view(), "on disk");
+
+    store.del("table");
+    store.compact();  // 输入文件被删除，Block 仍由 from_table 持有
+    EXPECT_EQ(from_table.view(), "on disk");
+    EXPECT_EQ(from_mem.view(), big);
+
+    PinnableValue missing;
+    EXPECT_FALSE(store.get("table", &missing));
+    EXPECT_TRUE(missing.empty());
+    ASSERT_TRUE(store.get("mem", &missing));
+    EXPECT_EQ(missing.view(), "overwritten");
+}
+
+class ScanTest : public CompactionTest {
+protected:
+    static std::string scan_key(int i) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "row%05d", i);
+        return buf;
+    }
+};
+
+/**
+ * @brief 数据分布在活跃 MemTable、L0 与 L1 时，正向 / 反向遍历都与 std::map 模型一致：
+ *        每个 Key 只出现最新的值，删除的 Key 不出现
+ */
+TEST_F(ScanTest, IteratorMatchesModelAcrossLevels) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    options.target_file_size = 4 * 1024;  // L1 有多个文件，覆盖层内迭代器的换文件
+    KVStore store(test_dir_, options);
+
+    std::map<std::string, std::string> model;
+    std::mt19937 rng(2024);
+    auto random_ops = [&](int n, int round) {
+        for (int i = 0; i < n; ++i) {
+            std::string key = scan_key(static_cast<int>(rng() % 800));
+            if (rng() % 4 == 0) {
+                store.del(key);
+                model.erase(key);
+            } else {
+                std::string value = "v" + std::to_string(round) + "_" + std::to_string(i);
+                store.put(key, value);
+                model[key] = value;
+            }
+        }
+    };
+    random_ops(1500, 0);
+    store.compact();  // -> L1
+    ASSERT_GT(store.num_tables_at_level(1), 1u);
+    random_ops(400, 1);
+    store.flush();    // -> L0
+    random_ops(400, 2);
+    store.flush();
+    random_ops(200, 3);  // 留在活跃 MemTable
+    ASSERT_GE(store.num_level0_tables(), 1u);
+
+    auto it = store.new_iterator();
+    auto expected = model.begin();
+    for (it->SeekToFirst(); it->Valid(); it->Next(), ++expected) {
+        ASSERT_NE(expected, model.end());
+        ASSERT_EQ(it->key(), expected->first);
+        EXPECT_EQ(it->value(), expected->second);
+    }
+    EXPECT_EQ(expected, model.end());
+
+    auto rexpected = model.rbegin();
+    for (it->SeekToLast(); it->Valid(); it->Prev(), ++rexpected) {
+        ASSERT_NE(rexpected, model.rend());
+        ASSERT_EQ(it->key(), rexpected->first);
+        EXPECT_EQ(it->value(), rexpected->second);
+    }
+    EXPECT_EQ(rexpected, model.rend());
+
+    // 方向切换
+    it->Seek(scan_key(400));
+    auto pos = model.lower_bound(scan_key(400));
+    ASSERT_TRUE(it->Valid());
+    it->Prev();
+    --pos;
+    ASSERT_TRUE(it->Valid());
+    EXPECT_EQ(it->key(), pos->first);
+    it->Next();
+    ++pos;
+    EXPECT_EQ(it->key(), pos->first);
+}
+
+/**
+ * @brief 范围扫描与前缀扫描：[begin, end) 边界、limit 与删除标记
+ */
+TEST_F(ScanTest, RangeAndPrefixScan) {
+    KVStore store(test_dir_);
+    for (int i = 0; i < 100; ++i) store.put(scan_key(i), std::to_string(i));
+    store.put("other:1", "x");
+    store.flush();
+    store.del(scan_key(11));
+    store.put(scan_key(12), "twelve");
+
+    auto range = store.scan(scan_key(10), scan_key(15));
+    std::vector<std::pair<std::string, std::string>> expected = {
+        {scan_key(10), "10"}, {scan_key(12), "twelve"}, {scan_key(13), "13"}, {scan_key(14), "14"}};
+    EXPECT_EQ(range, expected);
+
+    EXPECT_EQ(store.scan(scan_key(10), scan_key(15), 2).size(), 2u);
+    EXPECT_TRUE(store.scan(scan_key(15), scan_key(15)).empty());
+
+    EXPECT_EQ(store.scan_prefix("row").size(), 99u);
+    EXPECT_EQ(store.scan_prefix("row0009").size(), 10u);
+    auto other = store.scan_prefix("other:");
+    ASSERT_EQ(other.size(), 1u);
+    EXPECT_EQ(other[0].second, "x");
+    EXPECT_TRUE(store.scan_prefix("zzz").empty());
+}
+
+/**
+ * @brief 迭代器持有创建时的 Version：期间的 Compaction 删除输入文件后仍能读完
+ */
+TEST_F(ScanTest, IteratorSurvivesCompaction) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    KVStore store(test_dir_, options);
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 300; ++i) store.put(scan_key(i), "r" + std::to_string(round));
+        store.flush();
+    }
+
+    ReadOptions read_options;
+    read_options.fill_cache = false;
+    auto it = store.new_iterator(read_options);
+    it->SeekToFirst();
+    ASSERT_TRUE(it->Valid());
+    store.compact();
+    EXPECT_EQ(store.num_level0_tables(), 0u);
+
+    int count = 0;
+    for (; it->Valid(); it->Next()) {
+        EXPECT_EQ(it->value(), "r2");
+        ++count;
+    }
+    EXPECT_EQ(count, 300);
+}
+
+// ==========================================
+// Snapshots (MVCC)
+// ==========================================
+
+class SnapshotTest : public ScanTest {};
+
+/**
+ * @brief 快照读到创建时的数据：之后的覆盖写、删除、落盘与全量 Compaction 都不影响它
+ */
+TEST_F(SnapshotTest, SnapshotReadsSurviveOverwriteFlushAndCompaction) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    KVStore store(test_dir_, options);
+    for (int i = 0; i < 100; ++i) store.put(scan_key(i), "v1");
+    store.flush();
+
+    const Snapshot* snapshot = store.get_snapshot();
+    ReadOptions at_snapshot;
+    at_snapshot.snapshot = snapshot;
+
+    for (int i = 0; i < 100; i += 2) store.put(scan_key(i), "v2");
+    for (int i = 0; i < 10; ++i) EXPECT_TRUE(store.del(scan_key(i)));
+    store.put(scan_key(500), "new");
+
+    auto check = [&](const char* phase) {
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_EQ(store.get(at_snapshot, scan_key(i)).value_or("<none>"), "v1") << phase << " " << i;
+            std::string latest = i < 10 ? "<none>" : (i % 2 == 0 ? "v2" : "v1");
+            EXPECT_EQ(store.get(scan_key(i)).value_or("<none>"), latest) << phase << " " << i;
+        }
+        EXPECT_FALSE(store.get(at_snapshot, scan_key(500)).has_value()) << phase;
+        EXPECT_EQ(store.get(scan_key(500)).value_or(""), "new") << phase;
+
+        auto rows = store.scan(at_snapshot, scan_key(0), scan_key(1000));
+        ASSERT_EQ(rows.size(), 100u) << phase;
+        for (const auto& [key, value] : rows) EXPECT_EQ(value, "v1") << phase << " " << key;
+        EXPECT_EQ(store.scan(scan_key(0), scan_key(1000)).size(), 91u) << phase;
+    };
+    check("memtable");
+    store.flush();
+    check("flushed");
+    store.compact();
+    check("compacted");
+
+    store.release_snapshot(snapshot);
+}
+
+/**
+ * @brief 存活快照需要的旧版本与删除标记在 Compaction 中保留；释放快照后再次 Compaction 才被丢弃
+ */
+TEST_F(SnapshotTest, CompactionKeepsVersionsUntilSnapshotReleased) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    KVStore store(test_dir_, options);
+    for (int i = 0; i < 50; ++i) store.put(i, "old");
+    store.flush();
+
+    const Snapshot* snapshot = store.get_snapshot();
+    for (int i = 0; i < 50; ++i) store.put(i, "new");
+    for (int i = 0; i < 5; ++i) store.del(i);
+    store.compact();
+
+    CompactionStats stats = store.compaction_stats();
+    EXPECT_EQ(stats.entries_dropped, 0u);
+    EXPECT_EQ(stats.tombstones_dropped, 0u);
+    ReadOptions at_snapshot;
+    at_snapshot.snapshot = snapshot;
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_EQ(store.get(at_snapshot, encode_int_key(i)).value_or(""), "old") << i;
+    }
+    EXPECT_FALSE(store.get(3).has_value());
+
+    store.release_snapshot(snapshot);
+    store.put(49, "new");  // 新的 L0 文件与 L1 重叠，compact() 会重写 L1
+    store.compact();
+    stats = store.compaction_stats();
+    EXPECT_EQ(stats.tombstones_dropped, 5u);
+    // 50 个 "old"、5 个被删除标记遮蔽的 "new"，以及 key 49 上一次写入的 "new"
+    EXPECT_EQ(stats.entries_dropped, 50u + 5u + 1u);
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_EQ(store.get(i).value_or("<none>"), i < 5 ? "<none>" : "new") << i;
+    }
+}
+
+/**
+ * @brief 快照迭代器与批量写入：批次要么整体可见要么整体不可见
+ */
+TEST_F(SnapshotTest, SnapshotIteratorSeesWholeBatchesOnly) {
+    KVStore store(test_dir_);
+    WriteBatch first;
+    for (int i = 0; i < 20; ++i) first.put(scan_key(i), "a");
+    store.write(first);
+
+    const Snapshot* snapshot = store.get_snapshot();
+    WriteBatch second;
+    for (int i = 0; i < 20; ++i) second.put(scan_key(i), "b");
+    second.del(scan_key(0));
+    store.write(second);
+
+    ReadOptions at_snapshot;
+    at_snapshot.snapshot = snapshot;
+    auto it = store.new_iterator(at_snapshot);
+    int count = 0;
+    for (it->SeekToLast(); it->Valid(); it->Prev(), ++count) EXPECT_EQ(it->value(), "a");
+    EXPECT_EQ(count, 20);
+
+    auto latest = store.scan_prefix("row");
+    ASSERT_EQ(latest.size(), 19u);
+    EXPECT_EQ(latest.front().first, scan_key(1));
+    EXPECT_EQ(latest.front().second, "b");
+    store.release_snapshot(snapshot);
+}
+
+/**
+ * @brief 序列号在重启后继续递增：WAL 已全部落盘删除时由 MANIFEST 恢复，否则由 WAL 记录恢复
+ */
+TEST_F(SnapshotTest, SequenceNumbersSurviveRestart) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    {
+        KVStore store(test_dir_, options);
+        store.put("k", "first");
+        store.flush();  // WAL 段落盘后被删除
+    }
+    {
+        KVStore store(test_dir_, options);
+        const Snapshot* snapshot = store.get_snapshot();
+        EXPECT_GE(snapshot->sequence(), 1u);
+        store.put("k", "second");  // 只存在于 WAL 中
+        store.release_snapshot(snapshot);
+    }
+    {
+        KVStore store(test_dir_, options);
+        EXPECT_EQ(store.get("k").value_or(""), "second");
+        const Snapshot* snapshot = store.get_snapshot();
+        EXPECT_GE(snapshot->sequence(), 2u);
+        store.put("k", "third");
+        store.compact();
+        ReadOptions at_snapshot;
+        at_snapshot.snapshot = snapshot;
+        EXPECT_EQ(store.get(at_snapshot, "k").value_or(""), "second");
+        EXPECT_EQ(store.get("k").value_or(""), "third");
+        store.release_snapshot(snapshot);
+    }
+}
+
+/**
+ * @brief 启用 statistics 后记录读写次数、延迟与 Bloom Filter 判定，并通过 get_property 导出
+ */
+TEST_F(FlushTest, RecordsStatisticsAndExportsProperties) {
+    KVStoreOptions options;
+    options.statistics = std::make_shared<Statistics>();
+    options.level0_compaction_trigger = 0;
+    KVStore store(test_dir_, options);
+
+    for (int i = 0; i < 100; ++i) store.put(i * 2, "v" + std::to_string(i * 2));
+    store.flush();
+    store.del(0);
+    WriteBatch batch;
+    batch.put("batched", "x");
+    store.write(batch);
+
+    EXPECT_EQ(store.get(2).value_or(""), "v2");           // SSTable 命中
+    EXPECT_FALSE(store.get(0).has_value());               // MemTable 中的删除标记
+    EXPECT_FALSE(store.get(1).has_value());               // 在表的 Key 范围内，由 Bloom Filter 判定
+    EXPECT_EQ(store.get("batched").value_or(""), "x");    // MemTable 命中
+
+    Statistics& stats = *options.statistics;
+    EXPECT_EQ(stats.Get(Ticker::kPuts), 100u);
+    EXPECT_EQ(stats.Get(Ticker::kDeletes), 1u);
+    EXPECT_EQ(stats.Get(Ticker::kWriteBatches), 1u);
+    EXPECT_EQ(stats.Get(Ticker::kGets), 4u);
+    EXPECT_EQ(stats.Get(Ticker::kGetHits), 2u);
+    EXPECT_EQ(stats.Get(Ticker::kBytesRead), 3u);
+    EXPECT_EQ(stats.Get(Ticker::kMemtableHits), 2u);
+    EXPECT_EQ(stats.Get(Ticker::kMemtableMisses), 2u);
+    EXPECT_EQ(stats.Get(Ticker::kBloomUseful) + stats.Get(Ticker::kBloomPositive), 2u);
+    EXPECT_EQ(stats.Get(Ticker::kBloomTruePositive), 1u);
+    EXPECT_EQ(stats.GetHistogram(HistogramType::kPut).count, 100u);
+    EXPECT_EQ(stats.GetHistogram(HistogramType::kGet).count, 4u);
+    EXPECT_EQ(stats.GetHistogram(HistogramType::kFlush).count, 1u);
+    EXPECT_EQ(stats.GetHistogram(HistogramType::kWalSync).count, store.wal_stats().syncs);
+
+    std::string value;
+    ASSERT_TRUE(store.get_property("kv.num-files-at-level0", &value));
+    EXPECT_EQ(value, "1");
+    ASSERT_TRUE(store.get_property("kv.num-immutable-mem-table", &value));
+    EXPECT_EQ(value, "0");
+    ASSERT_TRUE(store.get_property("kv.stats", &value));
+    EXPECT_NE(value.find("kv.puts COUNT : 100"), std::string::npos) << value;
+    ASSERT_TRUE(store.get_property("kv.prometheus", &value));
+    EXPECT_NE(value.find("kv_level_files{level=\"0\"} 1\n"), std::string::npos) << value;
+    EXPECT_NE(value.find("kv_flushes_total 1\n"), std::string::npos) << value;
+    EXPECT_NE(value.find("kv_get_seconds_count 4\n"), std::string::npos) << value;
+    EXPECT_FALSE(store.get_property("kv.num-files-at-level99", &value));
+    EXPECT_FALSE(store.get_property("kv.unknown", &value));
+}
+
+/**
+ * @brief L0 文件数达到减速阈值后，写入按 delayed_write_rate 的令牌桶减速
+ */
+TEST_F(FlushTest, SlowsDownWritesPastL0SoftLimit) {
+    KVStoreOptions options;
+    options.sync_mode = WalSyncMode::kPeriodic;
+    options.level0_compaction_trigger = 100;  // 测试期间不会触发 Compaction
+    options.level0_slowdown_writes_trigger = 1;
+    options.delayed_write_rate = 100 << 10;   // 100KB/s
+    KVStore store(test_dir_, options);
+
+    std::string value;
+    ASSERT_TRUE(store.get_property("kv.actual-delayed-write-rate", &value));
+    EXPECT_EQ(value, "0");
+    store.put("first", "v");
+    store.flush();
+    ASSERT_TRUE(store.get_property("kv.actual-delayed-write-rate", &value));
+    EXPECT_EQ(value, std::to_string(100 << 10));
+    ASSERT_TRUE(store.get_property("kv.is-write-stopped", &value));
+    EXPECT_EQ(value, "0");
+
+    // 约 20KB 的 WAL 记录在 100KB/s 下至少需要约 0.2s
+    std::string payload(1000, 'x');
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 20; ++i) store.put(i, payload);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(150));
+
+    FlushStats stats = store.flush_stats();
+    EXPECT_GT(stats.delayed_writes, 0u);
+    EXPECT_GT(stats.write_delay.count(), 0);
+    EXPECT_EQ(stats.write_stalls, 0u);
+    EXPECT_EQ(store.get(19).value_or(""), payload);
+}
+
+/**
+ * @brief 持续过载时写入在软 / 硬限制之间减速与阻塞，但总会被后台工作唤醒，数据完整
+ *
+ * 包括配置错误的情形：L0 硬限制低于 Compaction 触发值时按触发值处理；
+ * 待 Compaction 字节数的硬限制只有 1 字节时，每次有待做的 Compaction 都会阻塞写入。
+ */
+TEST_F(FlushTest, OverloadedWritesAreThrottledWithoutDeadlock) {
+    KVStoreOptions options;
+    options.sync_mode = WalSyncMode::kPeriodic;
+    options.memtable_size_limit = 16 << 10;
+    options.max_immutable_memtables = 2;
+    options.immutable_memtables_slowdown_trigger = 1;
+    options.level0_compaction_trigger = 3;
+    options.level0_slowdown_writes_trigger = 2;
+    options.level0_stop_writes_trigger = 1;  // 低于触发值，按 3 处理
+    options.max_bytes_for_level_base = 32 << 10;
+    options.target_file_size = 16 << 10;
+    options.soft_pending_compaction_bytes_limit = 1;
+    options.hard_pending_compaction_bytes_limit = 1;
+    options.delayed_write_rate = 64 << 20;
+    KVStore store(test_dir_, options);
+
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 1000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&store, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                store.put(t * kPerThread + i, std::string(100, static_cast<char>('a' + t)));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    for (int t = 0; t < kThreads; ++t) {
+        for (int i = 0; i < kPerThread; i += 97) {
+            ASSERT_EQ(store.get(t * kPerThread + i).value_or(""), std::string(100, static_cast<char>('a' + t)));
+        }
+    }
+    FlushStats stats = store.flush_stats();
+    EXPECT_GT(stats.write_stalls + stats.delayed_writes, 0u);
+    EXPECT_GT(store.compaction_stats().compactions, 0u);
+    std::string value;
+    ASSERT_TRUE(store.get_property("kv.estimate-pending-compaction-bytes", &value));
+}
+
+/**
+ * @brief use_mmap_reads：落盘后的表通过映射读取，块缓存不再插入 Data Block，属性报告映射与驻留字节数
+ */
+TEST_F(FlushTest, MmapReadsReportResidentBytes) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    options.table_options.use_mmap_reads = true;
+    std::string value;
+    {
+        KVStore store(test_dir_, options);
+        for (int i = 0; i < 2000; ++i) store.put(i, std::string(100, static_cast<char>('a' + i % 26)));
+        store.flush();
+
+        ASSERT_TRUE(store.get_property("kv.mmap-bytes", &value));
+        EXPECT_EQ(value, "0");  // 读取器按需打开
+        for (int i = 0; i < 2000; ++i) {
+            ASSERT_EQ(store.get(i).value_or(""), std::string(100, static_cast<char>('a' + i % 26))) << i;
+        }
+        PinnableValue pinned;
+        ASSERT_TRUE(store.get(5, &pinned));
+        EXPECT_EQ(store.block_cache_stats().inserts, 0u);
+
+        ASSERT_TRUE(store.get_property("kv.mmap-bytes", &value));
+        EXPECT_EQ(std::stoull(value), store.level_bytes(0));
+        ASSERT_TRUE(store.get_property("kv.mmap-resident-bytes", &value));
+        EXPECT_GT(std::stoull(value), 0u);
+        EXPECT_LE(std::stoull(value), store.level_bytes(0));
+        ASSERT_TRUE(store.get_property("kv.stats", &value));
+        EXPECT_NE(value.find("Mmap: "), std::string::npos) << value;
+
+        store.compact();  // 旧表被淘汰，钉住的值依然指向有效的映射
+        EXPECT_EQ(store.num_level0_tables(), 0u);
+        EXPECT_EQ(pinned.view(), std::string(100, 'f'));
+    }
+}
+
+class BlobTest : public ScanTest {
+protected:
+    static std::string large_value(int i, char tag) {
+        return std::string(1000 + i % 7, tag) + std::to_string(i);
+    }
+
+    size_t count_blob_files() const {
+        size_t n = 0;
+        for (const auto& entry : fs::directory_iterator(test_dir_)) {
+            uint64_t number = 0;
+            if (parse_blob_file_name(entry.path().filename().string(), &number)) ++n;
+        }
+        return n;
+    }
+
+    static uint64_t property(const KVStore& store, std::string_view name) {
+        std::string value;
+        EXPECT_TRUE(store.get_property(name, &value)) << name;
+        return std::stoull(value);
+    }
+};
+
+/**
+ * @brief min_blob_size：大 Value 落盘时写入 Blob 文件，get / 正反向迭代 / 快照 / 重启 / Checkpoint
+ *        都读到原值；小 Value 仍内联在 SSTable 中
+ */
+TEST_F(BlobTest, SeparatesLargeValues) {
+    KVStoreOptions options;
+    options.level0_compaction_trigger = 0;
+    options.min_blob_size = 512;
+    auto expected = [](int i) { return i % 2 == 0 ? large_value(i, 'v') : "small" + std::to_string(i); };
+    std::string checkpoint = test_dir_ + "_checkpoint";
+    fs::remove_all(checkpoint);
+    {
+        KVStore store(test_dir_, options);
+        for (int i = 0; i < 200; ++i) store.put(scan_key(i), expected(i));
+        store.flush();
+
+        EXPECT_EQ(property(store, "kv.num-blob-files"), 1u);
+        EXPECT_EQ(count_blob_files(), 1u);
+        FlushStats flush = store.flush_stats();
+        EXPECT_GT(flush.blob_bytes_written, 100u * 1000u);
+        EXPECT_LT(flush.bytes_written, flush.blob_bytes_written / 4) << "table only holds blob indexes";
+        EXPECT_EQ(property(store, "kv.total-blob-file-size"), flush.blob_bytes_written);
+
+        for (int i = 0; i < 200; ++i) EXPECT_EQ(store.get(scan_key(i)).value_or(""), expected(i)) << i;
+        auto it = store.new_iterator();
+        int i = 0;
+        for (it->SeekToFirst(); it->Valid(); it->Next(), ++i) {
+            ASSERT_EQ(it->key(), scan_key(i));
+            ASSERT_EQ(it->value(), expected(i));
+        }
+        EXPECT_EQ(i, 200);
+        for (it->SeekToLast(); it->Valid(); it->Prev()) {
+            --i;
+            ASSERT_EQ(it->key(), scan_key(i));
+            ASSERT_EQ(it->value(), expected(i));
+        }
+        EXPECT_EQ(i, 0);
+
+        // 快照读到覆盖前的值；覆盖后的旧值在 Compaction 时计为垃圾
+        PinnableValue pinned;
+        ASSERT_TRUE(store.get(scan_key(0), &pinned));
+        const Snapshot* snapshot = store.get_snapshot();
+        store.put(scan_key(0), large_value(0, 'w'));
+        store.del(scan_key(2));
+        store.compact();
+        ReadOptions at_snapshot;
+        at_snapshot.snapshot = snapshot;
+        EXPECT_EQ(store.get(at_snapshot, scan_key(0)).value_or(""), expected(0));
+        EXPECT_EQ(store.get(at_snapshot, scan_key(2)).value_or(""), expected(2));
+        store.release_snapshot(snapshot);
+        EXPECT_EQ(pinned.view(), expected(0));
+        EXPECT_EQ(store.get(scan_key(0)).value_or(""), large_value(0, 'w'));
+        EXPECT_FALSE(store.get(scan_key(2)).has_value());
+
+        std::string stats;
+        ASSERT_TRUE(store.get_property("kv.stats", &stats));
+        EXPECT_NE(stats.find("Blob: "), std::string::npos) << stats;
+        store.create_checkpoint(checkpoint);
+    }
+
+    for (const std::string& dir : {test_dir_, checkpoint}) {
+        KVStore store(dir, options);
+        EXPECT_EQ(store.get(scan_key(0)).value_or(""), large_value(0, 'w'));
+        EXPECT_FALSE(store.get(scan_key(2)).has_value());
+        for (int i = 3; i < 200; ++i) EXPECT_EQ(store.get(scan_key(i)).value_or(""), expected(i)) << i;
+    }
+    fs::remove_all(checkpoint);
+}
+
+/**
+ * @brief Blob GC：Compaction 丢弃旧版本时累计失效字节；失效比例达到阈值的文件中存活的 Value
+ *        被搬到新文件，旧文件删除；所有 Key 删除后不再有 Blob 文件
+ */
+TEST_F(BlobTest, GarbageCollectionRelocatesLiveValues) {
+    KVStoreOptions options;
+    options.min_blob_size = 512;
+    options.blob_garbage_collection_ratio = 0.5;
+    {
+        KVStore store(test_dir_, options);
+        for (int i = 0; i < 100; ++i) store.put(scan_key(i), large_value(i, 'a'));
+        store.flush();
+        for (int i = 0; i < 60; ++i) store.put(scan_key(i), large_value(i, 'b'));
+        store.flush();
+        EXPECT_EQ(property(store, "kv.num-blob-files"), 2u);
+
+        // 合并后第一个文件有 60% 的 Value 失效，后台 GC 把其余 40 个搬走并删除它
+        store.compact();
+        ASSERT_TRUE(wait_until([&] { return store.compaction_stats().blobs_relocated >= 40; }));
+        ASSERT_TRUE(wait_until([&] { return count_blob_files() == 2; }));
+        EXPECT_EQ(store.compaction_stats().blobs_relocated, 40u);
+        EXPECT_EQ(property(store, "kv.num-blob-files"), 2u);
+        EXPECT_EQ(property(store, "kv.blob-garbage-bytes"), 0u);
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_EQ(store.get(scan_key(i)).value_or(""), large_value(i, i < 60 ? 'b' : 'a')) << i;
+        }
+    }
+    {
+        KVStore store(test_dir_, options);
+        EXPECT_EQ(property(store, "kv.num-blob-files"), 2u);
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_EQ(store.get(scan_key(i)).value_or(""), large_value(i, i < 60 ? 'b' : 'a')) << i;
+        }
+        for (int i = 0; i < 100; ++i) store.del(scan_key(i));
+        store.compact();
+        ASSERT_TRUE(wait_until([&] { return count_blob_files() == 0; }));
+        EXPECT_EQ(property(store, "kv.num-blob-files"), 0u);
+    }
+}
@@ -0,0 +1,326 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "dbformat.h"
+#include "filename.h"
+#include "memtable.h"
+#include "pinnable_value.h"
+
+/**
+ * @brief 基本写入与查询
+ */
+TEST(MemTableTest, PutGet) {
+    MemTable mem;
+    EXPECT_TRUE(mem.empty());
+
+    mem.put(encode_int_key(1), "one");
+    mem.put(encode_int_key(2), "two");
+    mem.put(encode_int_key(1), "uno");
+
+    std::string value;
+    EXPECT_EQ(mem.get(encode_int_key(1), &value), MemTable::LookupResult::kFound);
+    EXPECT_EQ(value, "uno");
+    EXPECT_EQ(mem.get(encode_int_key(2), &value), MemTable::LookupResult::kFound);
+    EXPECT_EQ(value, "two");
+    EXPECT_EQ(mem.get(encode_int_key(3), &value), MemTable::LookupResult::kNotFound);
+    EXPECT_FALSE(mem.empty());
+}
+
+/**
+ * @brief 删除写入删除标记，而不是直接移除节点
+ */
+TEST(MemTableTest, DeleteWritesTombstone) {
+    MemTable mem;
+    mem.put(encode_int_key(1), "one");
+    mem.del(encode_int_key(1));
+    mem.del(encode_int_key(2));
+
+    std::string value;
+    EXPECT_EQ(mem.get(encode_int_key(1), &value), MemTable::LookupResult::kDeleted);
+    EXPECT_EQ(mem.get(encode_int_key(2), &value), MemTable::LookupResult::kDeleted);
+
+    mem.put(encode_int_key(1), "again");
+    EXPECT_EQ(mem.get(encode_int_key(1), &value), MemTable::LookupResult::kFound);
+    EXPECT_EQ(value, "again");
+}
+
+/**
+ * @brief 内存用量随写入单调增长
+ */
+TEST(MemTableTest, MemoryUsageGrows) {
+    MemTable mem;
+    mem.put(encode_int_key(1), std::string(1000, 'x'));
+    size_t after_put = mem.approximate_memory_usage();
+    EXPECT_GE(after_put, 1000u);
+
+    mem.del(encode_int_key(1));
+    EXPECT_GT(mem.approximate_memory_usage(), after_put);
+}
+
+/**
+ * @brief for_each 按 key 升序遍历，删除标记同样可见
+ */
+TEST(MemTableTest, ForEachIsSorted) {
+    MemTable mem;
+    mem.put(encode_int_key(5), "five");
+    mem.put(encode_int_key(-3), "minus three");
+    mem.del(encode_int_key(2));
+    mem.put(encode_int_key(0), "zero");
+
+    std::vector<std::pair<int, ValueType>> seen;
+    mem.for_each([&](std::string_view key, const MemTable::Entry& entry) {
+        int k = 0;
+        EXPECT_TRUE(decode_int_key(key, &k));
+        seen.emplace_back(k, entry.type);
+    });
+
+    ASSERT_EQ(seen.size(), 4u);
+    EXPECT_EQ(seen[0], std::make_pair(-3, ValueType::kValue));
+    EXPECT_EQ(seen[1], std::make_pair(0, ValueType::kValue));
+    EXPECT_EQ(seen[2], std::make_pair(2, ValueType::kDeletion));
+    EXPECT_EQ(seen[3], std::make_pair(5, ValueType::kValue));
+}
+
+/**
+ * @brief SSTable 中的 Value 编码：类型字节 + 原始值
+ */
+TEST(DbFormatTest, TableValueRoundTrip) {
+    std::string encoded = encode_table_value(ValueType::kValue, "hello");
+    ValueType type;
+    std::string_view value;
+    ASSERT_TRUE(decode_table_value(encoded, &type, &value));
+    EXPECT_EQ(type, ValueType::kValue);
+    EXPECT_EQ(value, "hello");
+
+    encoded = encode_table_value(ValueType::kDeletion, "");
+    ASSERT_TRUE(decode_table_value(encoded, &type, &value));
+    EXPECT_EQ(type, ValueType::kDeletion);
+    EXPECT_TRUE(value.empty());
+
+    EXPECT_FALSE(decode_table_value("", &type, &value));
+    EXPECT_FALSE(decode_table_value(std::string(1, '\x07'), &type, &value));
+}
+
+/**
+ * @brief 数据文件命名与解析
+ */
+TEST(FileNameTest, RoundTrip) {
+    uint64_t number = 0;
+    int level = -1;
+
+    EXPECT_EQ(wal_segment_name(12), "wal_000012.log");
+    ASSERT_TRUE(parse_wal_segment_name("wal_000012.log", &number));
+    EXPECT_EQ(number, 12u);
+
+    EXPECT_EQ(table_file_name(0, 7), "L0_000007.sst");
+    ASSERT_TRUE(parse_table_file_name("L0_000007.sst", &level, &number));
+    EXPECT_EQ(level, 0);
+    EXPECT_EQ(number, 7u);
+
+    EXPECT_FALSE(parse_wal_segment_name("wal.log", &number));
+    EXPECT_FALSE(parse_wal_segment_name("wal_12.log.tmp", &number));
+    EXPECT_FALSE(parse_table_file_name("L0_000007.sst.tmp", &level, &number));
+    EXPECT_FALSE(parse_table_file_name("data.sst", &level, &number));
+}
+
+/**
+ * @brief 覆盖写的新值长度不同、值很大（超过 Arena 块大小）或包含 '\0' 时都能正确读回
+ */
+TEST(MemTableTest, OverwriteWithDifferentSizes) {
+    MemTable mem;
+    std::string big(10000, 'b');
+    std::string binary("a\0b\0c", 5);
+    mem.put(encode_int_key(7), "short");
+    mem.put(encode_int_key(7), big);
+    mem.put(encode_int_key(8), binary);
+    mem.put(encode_int_key(9), "");
+
+    std::string value;
+    ASSERT_EQ(mem.get(encode_int_key(7), &value), MemTable::LookupResult::kFound);
+    EXPECT_EQ(value, big);
+    ASSERT_EQ(mem.get(encode_int_key(8), &value), MemTable::LookupResult::kFound);
+    EXPECT_EQ(value, binary);
+    ASSERT_EQ(mem.get(encode_int_key(9), &value), MemTable::LookupResult::kFound);
+    EXPECT_TRUE(value.empty());
+
+    mem.put(encode_int_key(7), "s");
+    ASSERT_EQ(mem.get(encode_int_key(7), &value), MemTable::LookupResult::kFound);
+    EXPECT_EQ(value, "s");
+
+    // 覆盖写保留旧版本：key 7 有 3 个版本
+    size_t count = 0;
+    mem.for_each([&](std::string_view, const MemTable::Entry&) { ++count; });
+    EXPECT_EQ(count, 5u);
+    EXPECT_GE(mem.approximate_memory_usage(), big.size());
+}
+
+/**
+ * @brief 读者与覆盖写并发：不加锁也只会读到某一次写入的完整值，不会读到半新半旧的条目
+ */
+TEST(MemTableTest, ConcurrentReadsDuringOverwrite) {
+    constexpr int kKeys = 64;
+    constexpr int kRounds = 200;
+
+    MemTable mem;
+    for (int k = 0; k < kKeys; ++k) mem.put(encode_int_key(k), std::string(1, 'a'));
+
+    std::atomic<bool> done{false};
+    std::atomic<int> failures{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            std::string value;
+            while (!done.load(std::memory_order_acquire)) {
+                for (int k = 0; k < kKeys; ++k) {
+                    // 每次写入的值都由同一个字符重复而成，长度随轮次变化
+                    if (mem.get(encode_int_key(k), &value) != MemTable::LookupResult::kFound ||
+                        value.empty() || value.find_first_not_of(value[0]) != std::string::npos) {
+                        failures.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+
+    for (int round = 1; round < kRounds; ++round) {
+        for (int k = 0; k < kKeys; ++k) {
+            std::string value(static_cast<size_t>(round % 50 + 1), static_cast<char>('a' + round % 26));
+            mem.put(encode_int_key(k), value);
+        }
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& t : readers) t.join();
+    EXPECT_EQ(failures.load(), 0);
+}
+
+namespace {
+    /// 按字节序的逆序排列
+    class ReverseComparator : public Comparator {
+    public:
+        int Compare(std::string_view a, std::string_view b) const override {
+            return BytewiseComparator()->Compare(b, a);
+        }
+        const char* Name() const override { return "test.ReverseComparator"; }
+    };
+}
+
+/**
+ * @brief 任意字节串 Key：长度不同、互为前缀、含 '\0' 的 Key 互不混淆，顺序由比较器决定
+ */
+TEST(MemTableTest, BinaryKeysWithCustomComparator) {
+    std::string nul("a\0", 2);
+    std::string long_key(300, 'k');  // 超过 get() 的栈上缓冲区
+    std::vector<std::string> keys = {"", "a", nul, "ab", "b", long_key};
+
+    ReverseComparator reverse;
+    for (const Comparator* cmp : {BytewiseComparator(), static_cast<const Comparator*>(&reverse)}) {
+        MemTable mem(cmp);
+        for (const std::string& key : keys) mem.put(key, "v" + key);
+        mem.del("b");
+
+        std::string value;
+        for (const std::string& key : keys) {
+            if (key == "b") {
+                EXPECT_EQ(mem.get(key, &value), MemTable::LookupResult::kDeleted);
+                continue;
+            }
+            ASSERT_EQ(mem.get(key, &value), MemTable::LookupResult::kFound) << cmp->Name();
+            EXPECT_EQ(value, "v" + key);
+        }
+        EXPECT_EQ(mem.get(std::string("a\0\0", 3), &value), MemTable::LookupResult::kNotFound);
+        EXPECT_EQ(mem.get(std::string(299, 'k'), &value), MemTable::LookupResult::kNotFound);
+
+        std::vector<std::string> seen;
+        mem.for_each([&](std::string_view key, const MemTable::Entry&) {
+            if (seen.empty() || seen.back() != key) seen.emplace_back(key);  // 只记录每个 Key 的最新版本
+        });
+        ASSERT_EQ(seen.size(), keys.size());
+        for (size_t i = 1; i < seen.size(); ++i) {
+            EXPECT_LT(cmp->Compare(seen[i - 1], seen[i]), 0) << cmp->Name() << " at " << i;
+        }
+    }
+}
+
+/**
+ * @brief 零拷贝查询：视图指向 Arena 中的条目，之后的覆盖写不会改变它
+ */
+TEST(MemTableTest, ViewGetSurvivesOverwrite) {
+    MemTable mem;
+    mem.put("k", std::string(5000, 'a'));
+
+    std::string_view view;
+    ASSERT_EQ(mem.get("k", &view), MemTable::LookupResult::kFound);
+    mem.put("k", "b");
+    mem.put("other", std::string(5000, 'c'));
+    EXPECT_EQ(view, std::string(5000, 'a'));
+
+    std::string_view latest;
+    ASSERT_EQ(mem.get("k", &latest), MemTable::LookupResult::kFound);
+    EXPECT_EQ(latest, "b");
+    mem.del("k");
+    EXPECT_EQ(mem.get("k", &latest), MemTable::LookupResult::kDeleted);
+}
+
+/**
+ * @brief 多版本：按快照序列号读到当时的版本；for_each 按序列号从新到旧访问同一 Key 的所有版本
+ */
+TEST(MemTableTest, SnapshotReadsSeeOlderVersions) {
+    MemTable mem;
+    mem.add(10, ValueType::kValue, "k", "v10");
+    mem.add(20, ValueType::kDeletion, "k", "");
+    mem.add(30, ValueType::kValue, "k", "v30");
+    mem.add(25, ValueType::kValue, "j", "j25");
+    EXPECT_EQ(mem.last_sequence(), 30u);
+
+    std::string value;
+    EXPECT_EQ(mem.get("k", &value, 9), MemTable::LookupResult::kNotFound);
+    ASSERT_EQ(mem.get("k", &value, 10), MemTable::LookupResult::kFound);
+    EXPECT_EQ(value, "v10");
+    ASSERT_EQ(mem.get("k", &value, 19), MemTable::LookupResult::kFound);
+    EXPECT_EQ(value, "v10");
+    EXPECT_EQ(mem.get("k", &value, 20), MemTable::LookupResult::kDeleted);
+    EXPECT_EQ(mem.get("k", &value, 29), MemTable::LookupResult::kDeleted);
+    ASSERT_EQ(mem.get("k", &value), MemTable::LookupResult::kFound);
+    EXPECT_EQ(value, "v30");
+    EXPECT_EQ(mem.get("j", &value, 24), MemTable::LookupResult::kNotFound);
+
+    std::vector<std::pair<std::string, SequenceNumber>> seen;
+    mem.for_each([&](std::string_view key, const MemTable::Entry& entry) {
+        seen.emplace_back(std::string(key), entry.sequence);
+    });
+    std::vector<std::pair<std::string, SequenceNumber>> expected = {
+        {"j", 25}, {"k", 30}, {"k", 20}, {"k", 10}};
+    EXPECT_EQ(seen, expected);
+
+    // put / del 接在已有的最大序列号之后
+    mem.put("k", "v31");
+    EXPECT_EQ(mem.last_sequence(), 31u);
+}
+
+/**
+ * @brief PinnableValue：自持有的短值在移动后仍指向新对象自己的缓冲区
+ */
+TEST(PinnableValueTest, OwnedValueSurvivesMove) {
+    PinnableValue value;
+    value.assign("xshort");
+    value.remove_prefix(1);
+    EXPECT_FALSE(value.pinned());
+
+    PinnableValue moved(std::move(value));
+    EXPECT_TRUE(value.empty());
+    EXPECT_EQ(moved.view(), "short");
+
+    auto owner = std::make_shared<const std::string>("pinned bytes");
+    PinnableValue pinned;
+    pinned.pin(*owner, owner);
+    EXPECT_EQ(owner.use_count(), 2);
+    moved = std::move(pinned);
+    EXPECT_TRUE(moved.pinned());
+    EXPECT_EQ(moved.to_string(), "pinned bytes");
+    moved.reset();
+    EXPECT_EQ(owner.use_count(), 1);
+}
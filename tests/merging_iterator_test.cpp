@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include "comparator.h"
+#include "dbformat.h"
+#include "memtable.h"
+#include "merging_iterator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @file merging_iterator_test.cpp
+ * @brief MergingIterator 的单元测试
+ *
+ * 测试目标：
+ * 1. 同一 UserKey 的所有版本按序列号从新到旧产出；内部 Key 完全相同时只产出下标最小者
+ * 2. 正向、反向遍历及二者交替时与 std::map 模型一致
+ */
+
+namespace {
+    std::string MakeKey(int i) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "k%05d", i);
+        return buf;
+    }
+
+    /// 迭代器当前条目的可读形式：user_key@sequence 与值（删除标记为 "<del>"）
+    std::pair<std::string, std::string> Describe(const InternalIterator& it) {
+        ParsedInternalKey parsed;
+        EXPECT_TRUE(parse_internal_key(it.key(), &parsed));
+        return {std::string(parsed.user_key) + "@" + std::to_string(parsed.sequence),
+                parsed.type == ValueType::kDeletion ? "<del>" : std::string(it.value())};
+    }
+
+    struct InternalKeyLess {
+        InternalKeyComparator comparator{BytewiseComparator()};
+        bool operator()(const std::string& a, const std::string& b) const {
+            return comparator.Compare(a, b) < 0;
+        }
+    };
+
+    /// 随机写入若干个 MemTable（越新的表序列号越大），模型保存全部版本
+    struct Fixture {
+        std::vector<std::unique_ptr<MemTable>> tables;                 ///< 新 -> 旧
+        std::map<std::string, std::string, InternalKeyLess> model;     ///< 内部 Key -> 值
+        InternalKeyComparator comparator{BytewiseComparator()};
+
+        Fixture(int num_tables, int keys_per_table, uint32_t seed) {
+            std::mt19937 rng(seed);
+            SequenceNumber sequence = 0;
+            for (int t = 0; t < num_tables; ++t) tables.push_back(std::make_unique<MemTable>());
+            // 从最老的表写到最新的表，序列号全局递增
+            for (int t = num_tables - 1; t >= 0; --t) {
+                for (int i = 0; i < keys_per_table; ++i) {
+                    std::string key = MakeKey(static_cast<int>(rng() % 500));
+                    ValueType type = rng() % 5 == 0 ? ValueType::kDeletion : ValueType::kValue;
+                    std::string value =
+                        type == ValueType::kValue ? "t" + std::to_string(t) + "_" + std::to_string(i) : "";
+                    tables[t]->add(++sequence, type, key, value);
+                    model[make_internal_key(key, sequence, type)] = value;
+                }
+            }
+        }
+
+        std::unique_ptr<MergingIterator> NewIterator() const {
+            std::vector<std::unique_ptr<InternalIterator>> children;
+            for (const auto& table : tables) {
+                children.push_back(std::make_unique<MemTable::Iterator>(table.get()));
+            }
+            return std::make_unique<MergingIterator>(&comparator, std::move(children));
+        }
+    };
+}
+
+/**
+ * @brief 同一 UserKey 的版本从新到旧依次产出，删除标记照常产出
+ */
+TEST(MergingIteratorTest, YieldsAllVersionsNewestFirst) {
+    MemTable newest, middle, oldest;
+    oldest.add(1, ValueType::kValue, "a", "old");
+    oldest.add(2, ValueType::kValue, "b", "old");
+    oldest.add(3, ValueType::kValue, "d", "old");
+    middle.add(4, ValueType::kValue, "a", "mid");
+    middle.add(5, ValueType::kDeletion, "b", "");
+    newest.add(6, ValueType::kValue, "a", "new");
+    newest.add(7, ValueType::kValue, "c", "new");
+
+    InternalKeyComparator comparator(BytewiseComparator());
+    std::vector<std::unique_ptr<InternalIterator>> children;
+    children.push_back(std::make_unique<MemTable::Iterator>(&newest));
+    children.push_back(std::make_unique<MemTable::Iterator>(&middle));
+    children.push_back(std::make_unique<MemTable::Iterator>(&oldest));
+    MergingIterator it(&comparator, std::move(children));
+
+    std::vector<std::pair<std::string, std::string>> seen;
+    for (it.SeekToFirst(); it.Valid(); it.Next()) seen.push_back(Describe(it));
+    std::vector<std::pair<std::string, std::string>> expected = {
+        {"a@6", "new"}, {"a@4", "mid"}, {"a@1", "old"}, {"b@5", "<del>"},
+        {"b@2", "old"}, {"c@7", "new"},  {"d@3", "old"}};
+    EXPECT_EQ(seen, expected);
+
+    seen.clear();
+    for (it.SeekToLast(); it.Valid(); it.Prev()) seen.push_back(Describe(it));
+    std::reverse(seen.begin(), seen.end());
+    EXPECT_EQ(seen, expected);
+
+    it.Seek(make_internal_key("a", 5, ValueType::kValue));
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(Describe(it).first, "a@4");
+}
+
+/**
+ * @brief 内部 Key 完全相同（如旧格式表中序列号均为 0 的版本）时只产出最新子迭代器中的条目
+ */
+TEST(MergingIteratorTest, IdenticalInternalKeysDeduplicated) {
+    MemTable newer, older;
+    older.add(0, ValueType::kValue, "a", "older");
+    older.add(0, ValueType::kValue, "b", "older");
+    newer.add(0, ValueType::kDeletion, "a", "");
+
+    InternalKeyComparator comparator(BytewiseComparator());
+    std::vector<std::unique_ptr<InternalIterator>> children;
+    children.push_back(std::make_unique<MemTable::Iterator>(&newer));
+    children.push_back(std::make_unique<MemTable::Iterator>(&older));
+    MergingIterator it(&comparator, std::move(children));
+
+    std::vector<std::pair<std::string, std::string>> seen;
+    for (it.SeekToFirst(); it.Valid(); it.Next()) seen.push_back(Describe(it));
+    std::vector<std::pair<std::string, std::string>> expected = {{"a@0", "<del>"}, {"b@0", "older"}};
+    EXPECT_EQ(seen, expected);
+}
+
+/**
+ * @brief 随机数据：正向、反向遍历与模型一致
+ */
+TEST(MergingIteratorTest, MatchesModelInBothDirections) {
+    Fixture fx(5, 300, 42);
+    auto it = fx.NewIterator();
+
+    auto expected = fx.model.begin();
+    for (it->SeekToFirst(); it->Valid(); it->Next(), ++expected) {
+        ASSERT_NE(expected, fx.model.end());
+        EXPECT_EQ(it->key(), expected->first);
+        EXPECT_EQ(it->value(), expected->second);
+    }
+    EXPECT_EQ(expected, fx.model.end());
+
+    auto rexpected = fx.model.rbegin();
+    for (it->SeekToLast(); it->Valid(); it->Prev(), ++rexpected) {
+        ASSERT_NE(rexpected, fx.model.rend());
+        EXPECT_EQ(it->key(), rexpected->first);
+        EXPECT_EQ(it->value(), rexpected->second);
+    }
+    EXPECT_EQ(rexpected, fx.model.rend());
+}
+
+/**
+ * @brief Seek 之后随机交替 Next / Prev（覆盖方向切换时子迭代器的重新定位）
+ */
+TEST(MergingIteratorTest, RandomDirectionChanges) {
+    Fixture fx(4, 200, 7);
+    auto it = fx.NewIterator();
+    std::mt19937 rng(99);
+
+    for (int round = 0; round < 50; ++round) {
+        std::string target = make_internal_key(MakeKey(static_cast<int>(rng() % 520)),
+                                               rng() % 1000, ValueType::kValue);
+        it->Seek(target);
+        auto expected = fx.model.lower_bound(target);
+        for (int step = 0; step < 40; ++step) {
+            if (expected == fx.model.end()) {
+                ASSERT_FALSE(it->Valid());
+                break;
+            }
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(it->key(), expected->first) << "round " << round << " step " << step;
+            EXPECT_EQ(it->value(), expected->second);
+            if (rng() % 2 == 0) {
+                it->Next();
+                ++expected;
+            } else {
+                if (expected == fx.model.begin()) {
+                    it->Prev();
+                    ASSERT_FALSE(it->Valid());
+                    break;
+                }
+                it->Prev();
+                --expected;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 没有子迭代器或所有子迭代器为空时始终无效
+ */
+TEST(MergingIteratorTest, EmptyChildren) {
+    InternalKeyComparator comparator(BytewiseComparator());
+    MergingIterator none(&comparator, {});
+    none.SeekToFirst();
+    EXPECT_FALSE(none.Valid());
+
+    MemTable a, b;
+    std::vector<std::unique_ptr<InternalIterator>> children;
+    children.push_back(std::make_unique<MemTable::Iterator>(&a));
+    children.push_back(std::make_unique<MemTable::Iterator>(&b));
+    MergingIterator it(&comparator, std::move(children));
+    it.SeekToLast();
+    EXPECT_FALSE(it.Valid());
+    it.Seek(make_internal_key("x", kMaxSequenceNumber, ValueType::kValue));
+    EXPECT_FALSE(it.Valid());
+}
@@ -0,0 +1,262 @@
+#include <gtest/gtest.h>
+#include "raft_log.h"
+#include "raft_message.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @file raft_log_test.cpp
+ * @brief RaftLog（Raft 持久化日志）与 Raft 消息编码的单元测试
+ */
+
+namespace fs = std::filesystem;
+
+class RaftLogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = "test_data_raft_log";
+        fs::remove_all(dir_);
+    }
+
+    void TearDown() override { fs::remove_all(dir_); }
+
+    static RaftEntry entry(uint64_t term, uint64_t index) {
+        WriteBatch batch;
+        batch.put("key" + std::to_string(index), "value" + std::to_string(index));
+        return make_raft_entry(term, index, batch.rep());
+    }
+
+    static void append_range(RaftLog& log, uint64_t term, uint64_t lo, uint64_t hi) {
+        for (uint64_t i = lo; i <= hi; ++i) log.append(entry(term, i));
+    }
+
+    std::string dir_;
+};
+
+/**
+ * @brief 条目就是一条带序列号的 kBatch 日志记录：Key 为 Term，Sequence 为索引，Value 为 WriteBatch
+ */
+TEST_F(RaftLogTest, EntryIsSequencedBatchRecord) {
+    RaftEntry e = entry(7, 42);
+    LogRecordView view;
+    ASSERT_TRUE(decode_log_record(e.record, &view));
+    EXPECT_EQ(view.type, LogType::kBatch);
+    EXPECT_EQ(view.sequence, 42u);
+    EXPECT_EQ(decode_fixed64(view.key.data()), 7u);
+    EXPECT_EQ(view.value, e.batch());
+
+    RaftEntry parsed;
+    ASSERT_TRUE(parse_raft_entry(view, &parsed));
+    EXPECT_EQ(parsed.term, 7u);
+    EXPECT_EQ(parsed.index, 42u);
+    EXPECT_EQ(parsed.record, e.record);
+
+    RaftEntry noop = make_raft_entry(3, 1, WriteBatch().rep());
+    ASSERT_TRUE(decode_log_record(noop.record, &view));
+    ASSERT_TRUE(parse_raft_entry(view, &parsed));
+    EXPECT_EQ(parsed.batch(), WriteBatch().rep());
+
+    std::string plain = encode_log_record({LogType::kPut, "k", "v"});
+    ASSERT_TRUE(decode_log_record(plain, &view));
+    EXPECT_FALSE(parse_raft_entry(view, &parsed)) << "not a raft entry";
+}
+
+/**
+ * @brief 条目追加后重新打开：索引、Term 与内容保持不变，可以继续追加
+ */
+TEST_F(RaftLogTest, AppendsAndReopens) {
+    {
+        RaftLog log(dir_, 64 * 1024);
+        EXPECT_EQ(log.last_index(), 0u);
+        EXPECT_EQ(log.last_term(), 0u);
+        append_range(log, 1, 1, 5);
+        append_range(log, 2, 6, 10);
+        log.sync();
+        EXPECT_THROW(log.append(entry(2, 12)), std::runtime_error);
+    }
+    RaftLog log(dir_, 64 * 1024);
+    EXPECT_EQ(log.first_index(), 1u);
+    EXPECT_EQ(log.last_index(), 10u);
+    EXPECT_EQ(log.last_term(), 2u);
+    EXPECT_EQ(log.term_at(5), 1u);
+    EXPECT_EQ(log.term_at(6), 2u);
+    EXPECT_EQ(log.term_at(0), 0u);
+    EXPECT_FALSE(log.term_at(11).has_value());
+    EXPECT_EQ(log.entry(3).record, entry(1, 3).record);
+
+    std::vector<RaftEntry> batch = log.entries(2, 9, 1);
+    ASSERT_EQ(batch.size(), 1u) << "at least one entry even above the byte limit";
+    batch = log.entries(2, 9, 1 << 20);
+    ASSERT_EQ(batch.size(), 8u);
+    EXPECT_EQ(batch.front().index, 2u);
+    EXPECT_EQ(batch.back().index, 9u);
+
+    log.append(entry(3, 11));
+    EXPECT_EQ(log.last_index(), 11u);
+}
+
+/**
+ * @brief 截断冲突的后缀：被截掉的条目重启后不会出现，新条目接在截断处
+ */
+TEST_F(RaftLogTest, TruncatesConflictingSuffix) {
+    {
+        RaftLog log(dir_);
+        append_range(log, 1, 1, 8);
+        log.truncate(5);
+        EXPECT_EQ(log.last_index(), 4u);
+        append_range(log, 2, 5, 6);
+        log.sync();
+    }
+    RaftLog log(dir_);
+    EXPECT_EQ(log.last_index(), 6u);
+    EXPECT_EQ(log.term_at(4), 1u);
+    EXPECT_EQ(log.term_at(5), 2u);
+    EXPECT_EQ(log.term_at(6), 2u);
+}
+
+/**
+ * @brief 崩溃留下的半条记录被丢弃，之后的追加覆盖它
+ */
+TEST_F(RaftLogTest, DiscardsTornTail) {
+    {
+        RaftLog log(dir_);
+        append_range(log, 1, 1, 3);
+    }
+    uint64_t size = fs::file_size(fs::path(dir_) / kRaftLogFileName);
+    {
+        std::string partial = entry(1, 4).record;
+        std::ofstream out(fs::path(dir_) / kRaftLogFileName, std::ios::binary | std::ios::app);
+        out.write(partial.data(), static_cast<std::streamsize>(partial.size() / 2));
+    }
+    {
+        RaftLog log(dir_);
+        EXPECT_EQ(log.last_index(), 3u);
+        EXPECT_EQ(log.bytes(), size);
+        log.append(entry(2, 4));
+    }
+    RaftLog log(dir_);
+    EXPECT_EQ(log.last_index(), 4u);
+    EXPECT_EQ(log.term_at(4), 2u);
+}
+
+/**
+ * @brief currentTerm / votedFor 在重启后保持
+ */
+TEST_F(RaftLogTest, PersistsHardState) {
+    {
+        RaftLog log(dir_);
+        EXPECT_EQ(log.term(), 0u);
+        EXPECT_EQ(log.voted_for(), 0u);
+        log.save_hard_state(5, 3);
+    }
+    RaftLog log(dir_);
+    EXPECT_EQ(log.term(), 5u);
+    EXPECT_EQ(log.voted_for(), 3u);
+
+    {
+        std::fstream f(fs::path(dir_) / kRaftMetaFileName, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(6);
+        f.put('\x7f');
+    }
+    EXPECT_THROW(RaftLog corrupted(dir_), std::runtime_error);
+}
+
+/**
+ * @brief 压缩：快照位置前移并持久化，保留的条目重写到新文件，之后仍可追加与截断
+ */
+TEST_F(RaftLogTest, CompactsPrefix) {
+    {
+        RaftLog log(dir_);
+        log.save_hard_state(2, 1);
+        append_range(log, 1, 1, 6);
+        append_range(log, 2, 7, 10);
+        log.compact(7);
+        EXPECT_EQ(log.snapshot_index(), 7u);
+        EXPECT_EQ(log.snapshot_term(), 2u);
+        EXPECT_EQ(log.first_index(), 8u);
+        EXPECT_EQ(log.term_at(7), 2u);
+        EXPECT_FALSE(log.term_at(6).has_value()) << "compacted";
+        EXPECT_EQ(log.entry(8).record, entry(2, 8).record);
+        log.append(entry(2, 11));
+        log.truncate(11);
+        log.sync();
+    }
+    RaftLog log(dir_);
+    EXPECT_EQ(log.term(), 2u) << "hard state survives compaction";
+    EXPECT_EQ(log.snapshot_index(), 7u);
+    EXPECT_EQ(log.last_index(), 10u);
+    EXPECT_EQ(log.last_term(), 2u);
+    EXPECT_THROW(log.truncate(7), std::runtime_error);
+}
+
+/**
+ * @brief 安装快照：快照位置的条目吻合时保留其后缀，否则丢弃全部条目
+ */
+TEST_F(RaftLogTest, ResetToSnapshot) {
+    {
+        RaftLog log(dir_);
+        append_range(log, 1, 1, 10);
+        log.reset(6, 1);
+        EXPECT_EQ(log.snapshot_index(), 6u);
+        EXPECT_EQ(log.last_index(), 10u) << "matching suffix is kept";
+
+        log.reset(20, 3);
+        EXPECT_EQ(log.snapshot_index(), 20u);
+        EXPECT_EQ(log.last_index(), 20u);
+        EXPECT_EQ(log.last_term(), 3u);
+        append_range(log, 3, 21, 22);
+    }
+    RaftLog log(dir_);
+    EXPECT_EQ(log.snapshot_index(), 20u);
+    EXPECT_EQ(log.last_index(), 22u);
+}
+
+/**
+ * @brief 消息编码往返：全部字段、条目与快照文件；截断或篡改条目的数据被拒绝
+ */
+TEST(RaftMessageTest, RoundTrip) {
+    RaftMessage msg;
+    msg.type = RaftMessageType::kAppend;
+    msg.from = 1;
+    msg.to = 2;
+    msg.term = 9;
+    msg.log_term = 8;
+    msg.index = 100;
+    msg.commit = 99;
+    msg.hint = 7;
+    msg.context = 123456789;
+    msg.reject = true;
+    WriteBatch batch;
+    batch.put("a", "1");
+    batch.del("b");
+    msg.entries.push_back(make_raft_entry(9, 101, batch.rep()));
+    msg.entries.push_back(make_raft_entry(9, 102, WriteBatch().rep()));
+    msg.files.emplace_back("L0_000001.sst", std::string(1000, 'x'));
+    msg.files.emplace_back("CURRENT", "MANIFEST-000002\n");
+
+    std::string data = encode_raft_message(msg);
+    RaftMessage decoded;
+    ASSERT_TRUE(decode_raft_message(data, &decoded));
+    EXPECT_EQ(decoded.type, msg.type);
+    EXPECT_EQ(decoded.from, 1u);
+    EXPECT_EQ(decoded.to, 2u);
+    EXPECT_EQ(decoded.term, 9u);
+    EXPECT_EQ(decoded.log_term, 8u);
+    EXPECT_EQ(decoded.index, 100u);
+    EXPECT_EQ(decoded.commit, 99u);
+    EXPECT_EQ(decoded.hint, 7u);
+    EXPECT_EQ(decoded.context, 123456789u);
+    EXPECT_TRUE(decoded.reject);
+    ASSERT_EQ(decoded.entries.size(), 2u);
+    EXPECT_EQ(decoded.entries[0].record, msg.entries[0].record);
+    EXPECT_EQ(decoded.entries[1].index, 102u);
+    EXPECT_EQ(decoded.files, msg.files);
+
+    EXPECT_FALSE(decode_raft_message(std::string_view(data).substr(0, data.size() - 1), &decoded));
+    std::string corrupted = data;
+    corrupted[1 + 8 * 8 + 1 + 1 + kLogRecordHeaderSize + 9] ^= 1;  // 第一条条目的 WriteBatch
+    EXPECT_FALSE(decode_raft_message(corrupted, &decoded));
+}
@@ -0,0 +1,375 @@
+#include <gtest/gtest.h>
+#include "raft_node.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file raft_node_test.cpp
+ * @brief RaftNode（Raft 复制）的集成测试：多个节点经 LocalRaftNetwork 组成集群
+ */
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+class RaftNodeTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = "test_data_raft_node";
+        fs::remove_all(dir_);
+        network_ = std::make_unique<LocalRaftNetwork>();
+    }
+
+    void TearDown() override {
+        nodes_.clear();
+        network_.reset();
+        fs::remove_all(dir_);
+    }
+
+    /// 创建 n 个节点的集群（编号 1..n），此时尚未启动
+    void create_cluster(size_t n, std::function<void(RaftOptions&)> tweak = {}) {
+        options_.clear();
+        nodes_.clear();
+        for (uint64_t id = 1; id <= n; ++id) {
+            RaftOptions o;
+            o.id = id;
+            for (uint64_t peer = 1; peer <= n; ++peer) o.peers.push_back(peer);
+            o.heartbeat_interval = 20ms;
+            o.election_timeout_min = 150ms;
+            o.election_timeout_max = 300ms;
+            o.request_timeout = 3000ms;
+            o.log_preallocate_size = 1 << 20;
+            o.store_options.memtable_size_limit = 256 * 1024;
+            if (tweak) tweak(o);
+            options_.push_back(o);
+            nodes_.emplace_back();
+        }
+    }
+
+    void start(uint64_t id) {
+        nodes_[id - 1] = std::make_unique<RaftNode>(node_dir(id), options_[id - 1], *network_);
+    }
+
+    void start_all() {
+        for (uint64_t id = 1; id <= nodes_.size(); ++id) start(id);
+    }
+
+    void stop(uint64_t id) { nodes_[id - 1].reset(); }
+
+    RaftNode& node(uint64_t id) { return *nodes_[id - 1]; }
+
+    std::string node_dir(uint64_t id) const { return (fs::path(dir_) / ("node" + std::to_string(id))).string(); }
+
+    /// 等待恰好一个正在运行的节点成为 Leader，返回其编号
+    uint64_t wait_leader(uint64_t excluded = 0) {
+        uint64_t leader = 0;
+        EXPECT_TRUE(eventually([&] {
+            leader = 0;
+            for (uint64_t id = 1; id <= nodes_.size(); ++id) {
+                if (id != excluded && nodes_[id - 1] && nodes_[id - 1]->is_leader()) {
+                    if (leader != 0) return false;
+                    leader = id;
+                }
+            }
+            return leader != 0;
+        })) << "no leader elected";
+        return leader;
+    }
+
+    static bool eventually(const std::function<bool()>& pred, std::chrono::milliseconds timeout = 10s) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (pred()) return true;
+            std::this_thread::sleep_for(5ms);
+        }
+        return pred();
+    }
+
+    /// 等待节点 id 的本地状态机中 key 的值变为 expected
+    bool replicated(uint64_t id, const std::string& key, const std::string& expected) {
+        return eventually([&] { return node(id).local_get(key).value_or("") == expected; });
+    }
+
+    static std::string key(int i) { return "key" + std::to_string(i); }
+    static std::string value(int i) { return "value" + std::to_string(i); }
+
+    std::string dir_;
+    std::unique_ptr<LocalRaftNetwork> network_;
+    std::vector<RaftOptions> options_;
+    std::vector<std::unique_ptr<RaftNode>> nodes_;
+};
+
+/**
+ * @brief 单节点集群：自己就是多数派，当选后立即可读写
+ */
+TEST_F(RaftNodeTest, SingleNodeCluster) {
+    create_cluster(1);
+    start_all();
+    ASSERT_EQ(wait_leader(), 1u);
+    node(1).put("a", "1");
+    node(1).del("a");
+    node(1).put("b", "2");
+    EXPECT_FALSE(node(1).get("a").has_value());
+    EXPECT_EQ(node(1).get("b").value_or(""), "2");
+
+    RaftStatus status = node(1).status();
+    EXPECT_EQ(status.role, RaftRole::kLeader);
+    EXPECT_EQ(status.commit, status.last_index);
+    EXPECT_EQ(status.applied, status.commit);
+    EXPECT_EQ(status.last_index, 4u) << "no-op + three writes";
+}
+
+/**
+ * @brief 三节点：选出唯一的 Leader，写入复制到所有副本；Follower 拒绝读写
+ */
+TEST_F(RaftNodeTest, ReplicatesWritesToFollowers) {
+    create_cluster(3);
+    start_all();
+    uint64_t leader = wait_leader();
+
+    WriteBatch batch;
+    for (int i = 0; i < 50; ++i) batch.put(key(i), value(i));
+    node(leader).write(batch);
+    for (int i = 50; i < 100; ++i) node(leader).put(key(i), value(i));
+    node(leader).del(key(7));
+
+    for (uint64_t id = 1; id <= 3; ++id) {
+        EXPECT_TRUE(replicated(id, key(99), value(99))) << "node " << id;
+        EXPECT_TRUE(eventually([&] { return !node(id).local_get(key(7)).has_value(); }));
+        EXPECT_EQ(node(id).local_get(key(0)).value_or(""), value(0));
+        if (id == leader) continue;
+        EXPECT_EQ(node(id).status().leader, leader);
+        EXPECT_THROW(node(id).put("x", "y"), std::runtime_error);
+        EXPECT_THROW(node(id).get("x"), std::runtime_error);
+    }
+    EXPECT_EQ(node(leader).get(key(42)).value_or(""), value(42));
+}
+
+/**
+ * @brief 并发写入：AppendEntries 按批携带多条条目，多次写入共享一次 fsync
+ */
+TEST_F(RaftNodeTest, BatchesConcurrentProposals) {
+    create_cluster(3);
+    start_all();
+    uint64_t leader = wait_leader();
+
+    constexpr int kThreads = 8;
+    constexpr int kWrites = 100;
+    std::vector<std::thread> writers;
+    std::atomic<int> failures{0};
+    for (int t = 0; t < kThreads; ++t) {
+        writers.emplace_back([&, t] {
+            for (int i = 0; i < kWrites; ++i) {
+                try {
+                    node(leader).put(key(t * kWrites + i), value(i));
+                } catch (const std::exception&) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto& w : writers) w.join();
+    ASSERT_EQ(failures, 0);
+
+    RaftStats stats = node(leader).stats();
+    EXPECT_EQ(stats.proposals, static_cast<uint64_t>(kThreads * kWrites));
+    EXPECT_LT(stats.log_syncs, stats.proposals) << "concurrent proposals share a log fsync";
+    EXPECT_GT(stats.avg_entries_per_append(), 1.0);
+    for (uint64_t id = 1; id <= 3; ++id) {
+        EXPECT_TRUE(replicated(id, key(kThreads * kWrites - 1), value(kWrites - 1)));
+    }
+}
+
+/**
+ * @brief 租约读：心跳持续得到确认时读取不需要额外的网络往返；关闭租约后每次读都走 ReadIndex
+ */
+TEST_F(RaftNodeTest, LeaseReadsSkipQuorumRound) {
+    create_cluster(3);
+    start_all();
+    uint64_t leader = wait_leader();
+    node(leader).put("k", "v");
+    ASSERT_TRUE(eventually([&] {
+        node(leader).get("k");
+        return node(leader).stats().lease_reads > 0;
+    }));
+
+    uint64_t messages = network_->messages();
+    RaftStats before = node(leader).stats();
+    for (int i = 0; i < 100; ++i) EXPECT_EQ(node(leader).get("k").value_or(""), "v");
+    RaftStats after = node(leader).stats();
+    EXPECT_GE(after.lease_reads - before.lease_reads, 90u);
+    EXPECT_LT(network_->messages() - messages, 100u) << "lease reads send no messages";
+
+    nodes_.clear();
+    create_cluster(3, [](RaftOptions& o) { o.lease_reads = false; });
+    start_all();
+    leader = wait_leader();
+    EXPECT_EQ(node(leader).get("k").value_or(""), "v") << "state survives restart";
+    for (int i = 0; i < 10; ++i) node(leader).get("k");
+    EXPECT_EQ(node(leader).stats().lease_reads, 0u);
+    EXPECT_GE(node(leader).stats().read_index_reads, 11u);
+}
+
+/**
+ * @brief Leader 宕机：剩余多数派选出新 Leader，已提交的写入不丢失；旧节点重启后追上
+ */
+TEST_F(RaftNodeTest, FailsOverToNewLeader) {
+    create_cluster(3);
+    start_all();
+    uint64_t leader = wait_leader();
+    for (int i = 0; i < 20; ++i) node(leader).put(key(i), value(i));
+    uint64_t old_term = node(leader).status().term;
+
+    stop(leader);
+    uint64_t next = wait_leader(leader);
+    ASSERT_NE(next, leader);
+    EXPECT_GT(node(next).status().term, old_term);
+    for (int i = 0; i < 20; ++i) EXPECT_EQ(node(next).get(key(i)).value_or(""), value(i));
+    node(next).put("after", "failover");
+
+    start(leader);
+    EXPECT_TRUE(replicated(leader, "after", "failover"));
+    EXPECT_EQ(node(leader).local_get(key(5)).value_or(""), value(5));
+    EXPECT_FALSE(node(leader).is_leader());
+}
+
+/**
+ * @brief 被分区的 Leader 联系不上多数派后退位，分区期间的写入失败；恢复连通后追上新 Leader
+ */
+TEST_F(RaftNodeTest, PartitionedLeaderStepsDown) {
+    create_cluster(3, [](RaftOptions& o) { o.request_timeout = 500ms; });
+    start_all();
+    uint64_t leader = wait_leader();
+    node(leader).put("before", "1");
+
+    network_->disconnect(leader);
+    EXPECT_THROW(node(leader).put("lost", "x"), std::runtime_error);
+    EXPECT_TRUE(eventually([&] { return !node(leader).is_leader(); })) << "check quorum";
+    EXPECT_THROW(node(leader).get("before"), std::runtime_error);
+
+    uint64_t next = wait_leader(leader);
+    node(next).put("during", "2");
+    network_->connect(leader);
+    EXPECT_TRUE(replicated(leader, "during", "2"));
+    EXPECT_FALSE(node(leader).local_get("lost").has_value()) << "uncommitted entry was overwritten";
+    EXPECT_FALSE(node(next).get("lost").has_value());
+}
+
+/**
+ * @brief 落后太多的 Follower：需要的条目已被压缩，Leader 发送 SSTable 快照，Follower 安装后继续复制
+ */
+TEST_F(RaftNodeTest, InstallsSnapshotOnLaggingFollower) {
+    create_cluster(3, [](RaftOptions& o) {
+        o.snapshot_threshold = 50;
+        o.snapshot_retain = 10;
+    });
+    start_all();
+    uint64_t leader = wait_leader();
+    uint64_t lagging = leader % 3 + 1;
+    node(leader).put(key(0), value(0));
+    ASSERT_TRUE(replicated(lagging, key(0), value(0)));
+
+    network_->disconnect(lagging);
+    for (int i = 1; i < 300; ++i) node(leader).put(key(i), value(i));
+    node(leader).del(key(0));
+    EXPECT_GT(node(leader).status().snapshot_index, 100u) << "leader compacted its log";
+
+    network_->connect(lagging);
+    EXPECT_TRUE(replicated(lagging, key(299), value(299)));
+    EXPECT_TRUE(eventually([&] { return node(lagging).stats().snapshots_installed > 0; }));
+    EXPECT_GT(node(leader).stats().snapshots_sent, 0u);
+    EXPECT_FALSE(node(lagging).local_get(key(0)).has_value());
+    for (int i = 1; i < 300; i += 37) EXPECT_EQ(node(lagging).local_get(key(i)).value_or(""), value(i));
+
+    node(leader).put("after", "snapshot");
+    EXPECT_TRUE(replicated(lagging, "after", "snapshot"));
+
+    // 安装的快照在重启后依然有效
+    stop(lagging);
+    start(lagging);
+    EXPECT_GT(node(lagging).status().snapshot_index, 0u);
+    EXPECT_EQ(node(lagging).local_get(key(150)).value_or(""), value(150));
+}
+
+/**
+ * @brief 整个集群重启：从 RAFT_META、raft.log 与状态机恢复，数据与任期保持
+ */
+TEST_F(RaftNodeTest, RecoversAfterFullRestart) {
+    create_cluster(3, [](RaftOptions& o) {
+        o.snapshot_threshold = 40;
+        o.snapshot_retain = 5;
+    });
+    start_all();
+    uint64_t leader = wait_leader();
+    for (int i = 0; i < 120; ++i) node(leader).put(key(i), value(i));
+    node(leader).del(key(3));
+    uint64_t term = node(leader).status().term;
+
+    for (uint64_t id = 1; id <= 3; ++id) stop(id);
+    start_all();
+    leader = wait_leader();
+    EXPECT_GT(node(leader).status().term, term);
+    EXPECT_FALSE(node(leader).get(key(3)).has_value());
+    for (int i = 0; i < 120; i += 7) {
+        if (i == 3) continue;
+        EXPECT_EQ(node(leader).get(key(i)).value_or(""), value(i));
+    }
+    for (uint64_t id = 1; id <= 3; ++id) EXPECT_TRUE(replicated(id, key(119), value(119)));
+}
+
+/**
+ * @brief 安装快照时崩溃：RAFT_META 尚未记录新快照位置时回滚到旧状态机，已记录时保留新状态机
+ */
+TEST_F(RaftNodeTest, RecoversInterruptedSnapshotInstall) {
+    create_cluster(1);
+    start(1);
+    wait_leader();
+    node(1).put("old", "state");
+    stop(1);
+
+    fs::path dir = node_dir(1);
+    auto write_marker = [&](const std::string& contents) {
+        std::ofstream out(dir / kRaftInstallFileName);
+        out << contents;
+    };
+    auto replace_store = [&] {
+        fs::rename(dir / kRaftStoreDirName, dir / kRaftOldStoreDirName);
+        KVStore store((dir / kRaftStoreDirName).string(), options_[0].store_options);
+        store.put("new", "state");
+    };
+
+    // 1. 新 db 已改名就位，但快照位置未提交：回滚
+    replace_store();
+    write_marker("1000000\n");
+    start(1);
+    wait_leader();
+    EXPECT_EQ(node(1).get("old").value_or(""), "state");
+    EXPECT_FALSE(node(1).get("new").has_value());
+    EXPECT_FALSE(fs::exists(dir / kRaftOldStoreDirName));
+    EXPECT_FALSE(fs::exists(dir / kRaftInstallFileName));
+    stop(1);
+
+    // 2. 标记写了一半就崩溃（目录尚未改名）：db 原样保留
+    write_marker("");
+    start(1);
+    wait_leader();
+    EXPECT_EQ(node(1).get("old").value_or(""), "state");
+    EXPECT_FALSE(fs::exists(dir / kRaftInstallFileName));
+    stop(1);
+
+    // 3. 快照位置已提交（RAFT_META 的快照位置不小于标记）：保留新 db，删除 db.old
+    replace_store();
+    write_marker("0\n");
+    start(1);
+    wait_leader();
+    EXPECT_EQ(node(1).get("new").value_or(""), "state");
+    EXPECT_FALSE(fs::exists(dir / kRaftOldStoreDirName));
+    EXPECT_FALSE(fs::exists(dir / kRaftInstallFileName));
+}
@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include "kv_client.h"
+#include "kv_server.h"
+#include "raft_socket_transport.h"
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file raft_socket_transport_test.cpp
+ * @brief SocketRaftTransport 的集成测试：三个 RaftNode 经回环 TCP 组成集群，客户端经 KVServer 访问
+ */
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+class RaftSocketTransportTest : public ::testing::Test {
+protected:
+    /// 一个成员：Raft 端口上的传输、副本与客户端端口上的 KVServer
+    struct Member {
+        std::unique_ptr<SocketRaftTransport> transport;
+        std::unique_ptr<RaftNode> node;
+        std::unique_ptr<RaftService> service;
+        std::unique_ptr<KVServer> server;
+    };
+
+    static constexpr uint64_t kMembers = 3;
+
+    void SetUp() override {
+        dir_ = "test_data_raft_socket";
+        fs::remove_all(dir_);
+        members_.resize(kMembers);
+        raft_ports_.assign(kMembers, 0);
+    }
+
+    void TearDown() override {
+        members_.clear();
+        fs::remove_all(dir_);
+    }
+
+    RaftOptions options(uint64_t id) const {
+        RaftOptions o;
+        o.id = id;
+        for (uint64_t peer = 1; peer <= kMembers; ++peer) o.peers.push_back(peer);
+        o.heartbeat_interval = 20ms;
+        o.election_timeout_min = 150ms;
+        o.election_timeout_max = 300ms;
+        o.request_timeout = 3000ms;
+        o.log_preallocate_size = 1 << 20;
+        o.snapshot_threshold = 64;
+        o.snapshot_retain = 16;
+        return o;
+    }
+
+    /// 在 raft_ports_[id - 1] 上（0 表示由系统分配）创建成员 id 的传输并开始监听
+    void open_transport(uint64_t id) {
+        RaftSocketOptions o;
+        o.host = "127.0.0.1";
+        o.port = raft_ports_[id - 1];
+        o.reconnect_backoff = 20ms;
+        members_[id - 1].transport = std::make_unique<SocketRaftTransport>(o);
+        members_[id - 1].transport->start();
+        raft_ports_[id - 1] = members_[id - 1].transport->port();
+    }
+
+    /// 登记其他成员的地址，启动副本与客户端端口
+    void start_member(uint64_t id) {
+        Member& m = members_[id - 1];
+        for (uint64_t peer = 1; peer <= kMembers; ++peer) {
+            if (peer != id) m.transport->add_peer(peer, "127.0.0.1", raft_ports_[peer - 1]);
+        }
+        m.node = std::make_unique<RaftNode>(node_dir(id), options(id), *m.transport);
+        m.service = std::make_unique<RaftService>(*m.node);
+        m.server = std::make_unique<KVServer>(*m.service, ServerOptions{"127.0.0.1", 0, 1});
+        m.server->start();
+    }
+
+    void start_all() {
+        for (uint64_t id = 1; id <= kMembers; ++id) open_transport(id);
+        for (uint64_t id = 1; id <= kMembers; ++id) start_member(id);
+    }
+
+    /// 按依赖的逆序关闭：副本必须先于它的传输析构
+    void stop_member(uint64_t id) {
+        Member& m = members_[id - 1];
+        m.server.reset();
+        m.service.reset();
+        m.node.reset();
+        m.transport.reset();
+    }
+
+    RaftNode& node(uint64_t id) { return *members_[id - 1].node; }
+
+    uint16_t client_port(uint64_t id) { return members_[id - 1].server->port(); }
+
+    std::string node_dir(uint64_t id) const { return (fs::path(dir_) / ("node" + std::to_string(id))).string(); }
+
+    /// 等待恰好一个正在运行的成员成为 Leader，返回其编号
+    uint64_t wait_leader() {
+        uint64_t leader = 0;
+        EXPECT_TRUE(eventually([&] {
+            leader = 0;
+            for (uint64_t id = 1; id <= kMembers; ++id) {
+                if (members_[id - 1].node && members_[id - 1].node->is_leader()) {
+                    if (leader != 0) return false;
+                    leader = id;
+                }
+            }
+            return leader != 0;
+        })) << "no leader elected";
+        return leader;
+    }
+
+    static bool eventually(const std::function<bool()>& pred, std::chrono::milliseconds timeout = 10s) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (pred()) return true;
+            std::this_thread::sleep_for(5ms);
+        }
+        return pred();
+    }
+
+    bool replicated(uint64_t id, const std::string& key, const std::string& expected) {
+        return eventually([&] { return node(id).local_get(key).value_or("") == expected; });
+    }
+
+    std::string dir_;
+    std::vector<Member> members_;
+    std::vector<uint16_t> raft_ports_;
+};
+
+/**
+ * @brief 经 TCP 选出 Leader；客户端在 Leader 上的写入复制到所有 Follower，
+ *        在 Follower 上的读写返回 kError 并指明 Leader
+ */
+TEST_F(RaftSocketTransportTest, ReplicatesClientWritesAcrossMembers) {
+    start_all();
+    uint64_t leader = wait_leader();
+    ASSERT_NE(leader, 0u);
+
+    KVClient client("127.0.0.1", client_port(leader));
+    client.put("alpha", "1");
+    for (int i = 0; i < 100; ++i) client.send_put("key" + std::to_string(i), "v" + std::to_string(i));
+    client.send_del("alpha");
+    client.flush();
+    for (int i = 0; i <= 100; ++i) ASSERT_EQ(client.read_response(), ResponseStatus::kOk) << i;
+    EXPECT_FALSE(client.get("alpha").has_value());
+    EXPECT_EQ(client.get("key99").value_or(""), "v99");
+
+    uint64_t follower = leader % kMembers + 1;
+    for (uint64_t id = 1; id <= kMembers; ++id) {
+        EXPECT_TRUE(replicated(id, "key99", "v99")) << "member " << id;
+        EXPECT_FALSE(node(id).local_get("alpha").has_value());
+    }
+
+    KVClient follower_client("127.0.0.1", client_port(follower));
+    try {
+        follower_client.put("beta", "2");
+        FAIL() << "write on a follower should fail";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("Not the Raft leader"), std::string::npos) << e.what();
+    }
+
+    // Raft 端口只转发 Raft 消息
+    KVClient raft_port_client("127.0.0.1", raft_ports_[leader - 1]);
+    EXPECT_THROW(raft_port_client.get("key1"), std::runtime_error);
+    EXPECT_GT(members_[leader - 1].transport->messages(), 0u);
+    EXPECT_GT(members_[leader - 1].transport->bytes(), 0u);
+}
+
+/**
+ * @brief Follower 停机期间的消息被丢弃，日志已被压缩；它在原端口重启后，
+ *        Leader 重新连接并通过 InstallSnapshot 让它追上
+ */
+TEST_F(RaftSocketTransportTest, RestartedFollowerCatchesUpWithSnapshot) {
+    start_all();
+    uint64_t leader = wait_leader();
+    ASSERT_NE(leader, 0u);
+    uint64_t follower = leader % kMembers + 1;
+    stop_member(follower);
+
+    KVClient client("127.0.0.1", client_port(leader));
+    for (int i = 0; i < 300; ++i) client.put("key" + std::to_string(i), "v" + std::to_string(i));
+    EXPECT_TRUE(eventually([&] { return node(leader).status().snapshot_index > 0; }));
+    EXPECT_TRUE(eventually([&] { return members_[leader - 1].transport->dropped() > 0; }));
+
+    open_transport(follower);
+    start_member(follower);
+    EXPECT_TRUE(replicated(follower, "key299", "v299"));
+    EXPECT_EQ(node(follower).local_get("key0").value_or(""), "v0");
+    EXPECT_GE(node(follower).stats().snapshots_installed, 1u);
+}
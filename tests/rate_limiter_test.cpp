@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include "rate_limiter.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 限速为 0 时从不等待
+ */
+TEST(RateLimiterTest, UnlimitedNeverWaits) {
+    RateLimiter limiter(0);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(limiter.Request(1 << 20).count(), 0);
+    }
+}
+
+/**
+ * @brief 桶容量之内的突发请求不等待
+ */
+TEST(RateLimiterTest, BurstWithinBucketDoesNotWait) {
+    RateLimiter limiter(1 << 20, 64 * 1024);
+    EXPECT_EQ(limiter.Request(32 * 1024).count(), 0);
+    EXPECT_EQ(limiter.Request(32 * 1024).count(), 0);
+    EXPECT_GT(limiter.Request(32 * 1024).count(), 0);
+}
+
+/**
+ * @brief 长期平均速率不超过限速值（多线程共享同一个限速器）
+ */
+TEST(RateLimiterTest, EnforcesAverageRate) {
+    constexpr uint64_t kRate = 4 << 20;   // 4 MB/s
+    constexpr uint64_t kChunk = 64 * 1024;
+    RateLimiter limiter(kRate);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&limiter] {
+            for (int i = 0; i < 8; ++i) limiter.Request(kChunk);
+        });
+    }
+    for (auto& th : threads) th.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // 2 MB，扣除初始的 0.4 MB 桶容量，至少需要 0.4 秒
+    uint64_t total = 4 * 8 * kChunk;
+    EXPECT_EQ(limiter.TotalBytes(), total);
+    EXPECT_GE(elapsed, 0.35);
+    EXPECT_GT(limiter.TotalWait().count(), 0);
+}
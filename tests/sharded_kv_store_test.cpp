@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include "sharded_kv_store.h"
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file sharded_kv_store_test.cpp
+ * @brief ShardedKVStore（哈希分片存储）的单元测试
+ */
+
+namespace fs = std::filesystem;
+
+class ShardedKVStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = "test_data_sharded";
+        fs::remove_all(dir_);
+    }
+
+    void TearDown() override { fs::remove_all(dir_); }
+
+    static ShardedKVStoreOptions options(size_t shards) {
+        ShardedKVStoreOptions o;
+        o.num_shards = shards;
+        return o;
+    }
+
+    static std::string key(int i) { return "key" + std::to_string(i); }
+
+    std::string dir_;
+};
+
+/**
+ * @brief Key 按哈希分布到各自的分片目录，单 Key 操作只落在对应的分片
+ */
+TEST_F(ShardedKVStoreTest, RoutesKeysToShards) {
+    ShardedKVStore store(dir_, options(4));
+    ASSERT_EQ(store.num_shards(), 4u);
+    for (int i = 0; i < 400; ++i) store.put(key(i), "v" + std::to_string(i));
+    store.del(key(3));
+
+    std::vector<size_t> per_shard(4, 0);
+    for (int i = 0; i < 400; ++i) {
+        size_t index = store.shard_index(key(i));
+        ASSERT_LT(index, 4u);
+        ++per_shard[index];
+        if (i == 3) {
+            EXPECT_FALSE(store.get(key(i)).has_value());
+            continue;
+        }
+        EXPECT_EQ(store.get(key(i)).value_or(""), "v" + std::to_string(i));
+        EXPECT_EQ(store.shard(index).get(key(i)).value_or(""), "v" + std::to_string(i));
+        EXPECT_FALSE(store.shard((index + 1) % 4).get(key(i)).has_value());
+    }
+    for (size_t n : per_shard) EXPECT_GT(n, 50u) << "hash should spread keys evenly";
+    for (size_t i = 0; i < 4; ++i) EXPECT_TRUE(fs::exists(fs::path(dir_) / shard_dir_name(i) / "wal.log"));
+    EXPECT_EQ(store.wal_stats().records, 401u);
+}
+
+/**
+ * @brief 跨分片 WriteBatch 拆成每个分片一个子批次：每个分片只写一条 WAL 记录
+ */
+TEST_F(ShardedKVStoreTest, CrossShardBatch) {
+    ShardedKVStore store(dir_, options(4));
+    store.put(key(0), "old");
+
+    WriteBatch batch;
+    for (int i = 0; i < 100; ++i) batch.put(key(i), "batch");
+    batch.del(key(0));
+    store.write(batch);
+
+    EXPECT_FALSE(store.get(key(0)).has_value());
+    for (int i = 1; i < 100; ++i) EXPECT_EQ(store.get(key(i)).value_or(""), "batch");
+    for (size_t i = 0; i < 4; ++i) {
+        WalStats s = store.shard(i).wal_stats();
+        EXPECT_LE(s.records, 2u) << "shard " << i;  // 最多一次 put + 一个子批次
+    }
+}
+
+/**
+ * @brief multi_get 的结果与 keys 一一对应（含不存在与重复的 Key）
+ */
+TEST_F(ShardedKVStoreTest, MultiGet) {
+    ShardedKVStore store(dir_, options(3));
+    for (int i = 0; i < 100; i += 2) store.put(key(i), std::to_string(i));
+
+    std::vector<std::string> owned;
+    for (int i = 0; i < 100; ++i) owned.push_back(key(i));
+    owned.push_back(key(10));
+    std::vector<std::string_view> keys(owned.begin(), owned.end());
+
+    auto results = store.multi_get(keys);
+    ASSERT_EQ(results.size(), keys.size());
+    for (int i = 0; i < 100; ++i) {
+        if (i % 2 == 0) {
+            EXPECT_EQ(results[static_cast<size_t>(i)].value_or(""), std::to_string(i));
+        } else {
+            EXPECT_FALSE(results[static_cast<size_t>(i)].has_value());
+        }
+    }
+    EXPECT_EQ(results.back().value_or(""), "10");
+    EXPECT_TRUE(store.multi_get({}).empty());
+}
+
+/**
+ * @brief 重新打开：数据按同样的路由恢复；分片数不一致时拒绝打开
+ */
+TEST_F(ShardedKVStoreTest, ReopenRequiresSameShardCount) {
+    {
+        ShardedKVStore store(dir_, options(4));
+        for (int i = 0; i < 200; ++i) store.put(i, "v" + std::to_string(i));
+        store.flush();
+        store.put(1000, "unflushed");
+    }
+    {
+        ShardedKVStore store(dir_, options(0));  // 0：沿用目录中记录的分片数
+        EXPECT_EQ(store.num_shards(), 4u);
+        for (int i = 0; i < 200; ++i) ASSERT_EQ(store.get(i).value_or(""), "v" + std::to_string(i));
+        EXPECT_EQ(store.get(1000).value_or(""), "unflushed");
+    }
+    EXPECT_THROW(ShardedKVStore(dir_, options(8)), std::runtime_error);
+}
+
+/**
+ * @brief 多线程并发写入不同分片，flush / compact 在所有分片上并行执行
+ */
+TEST_F(ShardedKVStoreTest, ConcurrentWriters) {
+    ShardedKVStoreOptions o = options(4);
+    o.shard_options.memtable_size_limit = 16 * 1024;
+    o.shard_options.sync_mode = WalSyncMode::kGroupCommit;
+    ShardedKVStore store(dir_, o);
+
+    const int threads = 4;
+    const int per_thread = 1000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < per_thread; ++i) store.put(key(t * per_thread + i), std::string(64, 'a' + t));
+        });
+    }
+    for (auto& w : workers) w.join();
+    store.flush();
+    store.compact();
+
+    for (int t = 0; t < threads; ++t) {
+        for (int i = 0; i < per_thread; i += 37) {
+            ASSERT_EQ(store.get(key(t * per_thread + i)).value_or(""), std::string(64, 'a' + t));
+        }
+    }
+    size_t tables = 0;
+    for (size_t i = 0; i < store.num_shards(); ++i) tables += store.shard(i).flush_stats().flushes;
+    EXPECT_GE(tables, 4u);
+}
@@ -2,6 +2,7 @@
 #include "skiplist.h"
 
 #include <algorithm>
+#include <map>
 #include <random> 
 #include <string>
 #include <unordered_map>
@@ -9,7 +10,7 @@
 
 /**
  * @file skiplist_test.cpp
- * @brief SkipList 的单元测试（当前覆盖 insert/search）
+ * @brief SkipList 的单元测试（覆盖 insert/search/remove）
  *
  * 这些测试的核心目标不是验证“随机性”，而是验证跳表在不同路径下的基础不变量：
  * - 插入后可查到；未插入查不到
@@ -296,3 +297,104 @@ TEST(SkipListTest, RemoveWorksWhenAllNodesMaxLevel) {
         }
     }
 }
+
+namespace {
+    /// 统计存活实例数的值类型，用于检查节点（及其键值）是否被正确释放
+    struct Tracked {
+        static inline int live = 0;
+        int v = 0;
+        Tracked() { ++live; }
+        explicit Tracked(int x) : v(x) { ++live; }
+        Tracked(const Tracked& o) : v(o.v) { ++live; }
+        Tracked& operator=(const Tracked&) = default;
+        ~Tracked() { --live; }
+    };
+}
+
+/**
+ * @brief 删除后再插入会复用空闲节点；反复增删后内容正确，析构时所有节点都被释放
+ */
+TEST(SkipListTest, MixedInsertDeleteReusesNodes) {
+    {
+        SkipList<int, Tracked> kv(12);
+        std::unordered_map<int, int> expected;
+        std::mt19937 rng(77);
+        for (int round = 0; round < 20000; ++round) {
+            int key = static_cast<int>(rng() % 500);
+            if (rng() % 2 == 0) {
+                kv.insert(key, Tracked(round));
+                expected[key] = round;
+            } else {
+                EXPECT_EQ(kv.remove(key), expected.erase(key) == 1);
+            }
+        }
+        for (int key = 0; key < 500; ++key) {
+            auto v = kv.search(key);
+            auto it = expected.find(key);
+            if (it == expected.end()) {
+                EXPECT_FALSE(v.has_value()) << key;
+            } else {
+                ASSERT_TRUE(v.has_value()) << key;
+                EXPECT_EQ(v->v, it->second);
+            }
+        }
+    }
+    EXPECT_EQ(Tracked::live, 0);
+}
+
+/**
+ * @brief find 返回指向节点中值的指针，不拷贝值；insert 可以移动大值进跳表
+ */
+TEST(SkipListTest, FindReturnsPointerWithoutCopy) {
+    SkipList<int, std::string> kv(8);
+    std::string big(4096, 'v');
+    const char* data = big.data();
+    kv.insert(1, std::move(big));
+
+    const std::string* found = kv.find(1);
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found->data(), data) << "value should be moved, not copied";
+    EXPECT_EQ(kv.find(2), nullptr);
+    EXPECT_EQ(kv.search(1).value_or(""), std::string(4096, 'v'));
+}
+
+/**
+ * @brief 双向迭代器：正向、反向遍历与 Seek 结果与 std::map 一致
+ */
+TEST(SkipListTest, IteratorSeekNextPrev) {
+    SkipList<int, int> kv(12);
+    std::map<int, int> expected;
+    std::mt19937 rng(5);
+    for (int i = 0; i < 2000; ++i) {
+        int key = static_cast<int>(rng() % 5000);
+        kv.insert(key, i);
+        expected[key] = i;
+    }
+    for (int key = 0; key < 5000; key += 3) {
+        if (kv.remove(key)) expected.erase(key);
+    }
+
+    SkipList<int, int>::Iterator it(&kv);
+    it.SeekToFirst();
+    for (const auto& [key, value] : expected) {
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), key);
+        EXPECT_EQ(it.value(), value);
+        it.Next();
+    }
+    EXPECT_FALSE(it.Valid());
+
+    it.SeekToLast();
+    for (auto e = expected.rbegin(); e != expected.rend(); ++e) {
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), e->first);
+        it.Prev();
+    }
+    EXPECT_FALSE(it.Valid());
+
+    it.Seek(2500);
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.key(), expected.lower_bound(2500)->first);
+    it.Seek(5000);
+    EXPECT_FALSE(it.Valid());
+}
@@ -182,3 +182,53 @@ TEST_F(SSTableBuilderTest, DoubleFinishThrows) {
     EXPECT_THROW(builder.Finish(), std::runtime_error) 
         << "Calling Finish() twice should throw";
 }
+
+/**
+ * @brief 验证测试：Footer 中写入了当前格式版本（前缀压缩 Data Block + CRC32C 校验）
+ */
+TEST_F(SSTableBuilderTest, FooterRecordsFormatVersion) {
+    {
+        SSTableBuilder builder(kTestFile);
+        builder.Add("k", "v");
+        builder.Finish();
+    }
+
+    std::ifstream file(kTestFile, std::ios::binary);
+    ASSERT_TRUE(file.is_open());
+    uint64_t file_size = std::filesystem::file_size(kTestFile);
+    file.seekg(static_cast<std::streamoff>(file_size - Footer::kEncodedLength + Footer::kFormatVersionOffset));
+
+    uint32_t version = 0;
+    file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+    EXPECT_EQ(version, Footer::kFormatBlockTrailer);  // 默认写入 UserKey，不是内部 Key
+}
+
+/**
+ * @brief 验证测试：启用 Bloom Filter 时 Footer 指向 Metaindex Block，关闭时为空
+ */
+TEST_F(SSTableBuilderTest, MetaindexHandleReflectsFilterOption) {
+    auto read_metaindex_size = [] {
+        std::ifstream file(kTestFile, std::ios::binary);
+        uint64_t file_size = std::filesystem::file_size(kTestFile);
+        file.seekg(static_cast<std::streamoff>(file_size - Footer::kEncodedLength + 8));
+        uint64_t size = 0;
+        file.read(reinterpret_cast<char*>(&size), sizeof(uint64_t));
+        return size;
+    };
+
+    {
+        SSTableBuilder builder(kTestFile);
+        builder.Add("k", "v");
+        builder.Finish();
+    }
+    EXPECT_GT(read_metaindex_size(), 0u);
+
+    {
+        TableOptions options;
+        options.bloom_bits_per_key = 0;
+        SSTableBuilder builder(kTestFile, options);
+        builder.Add("k", "v");
+        builder.Finish();
+    }
+    EXPECT_EQ(read_metaindex_size(), 0u);
+}
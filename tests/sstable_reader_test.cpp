@@ -0,0 +1,888 @@
+#include <gtest/gtest.h>
+#include "block_cache.h"
+#include "coding.h"
+#include "sstable_builder.h"
+#include "sstable_reader.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @file sstable_reader_test.cpp
+ * @brief SSTableReader 的单元测试
+ *
+ * 测试目标：
+ * 1. 验证 Builder 写出的文件能被完整读回（单 Block / 多 Block / 空表）
+ * 2. 验证不存在的 Key（位于 Block 之间、小于最小值、大于最大值）返回 false
+ * 3. 验证 Magic Number、格式版本与 Block CRC 的校验
+ * 4. 验证 Block 压缩（未编译进来的算法退回不压缩）与旧格式文件的兼容读取
+ */
+
+namespace {
+    const std::string kTestDir = "./test_data_reader";
+    const std::string kTestFile = kTestDir + "/test.sst";
+
+    std::string MakeKey(int i) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "key%06d", i);
+        return buf;
+    }
+
+    std::string ReadAll(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void WriteAll(const std::string& path, const std::string& data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    /**
+     * @brief 手工写出旧格式（版本 0 / 1 / 2）的表：Block 尾部只有 4 字节 CRC，无 Filter
+     *
+     * 版本 0 的 Block 校验和为 CRC32，之后为 CRC32C；
+     * 版本 0 / 1 为平铺 Data Block，版本 2 为前缀压缩 Block。
+     */
+    void WriteLegacyTable(int n, uint32_t version) {
+        auto checksum = [version](const std::string& block) {
+            return version == Footer::kFormatLegacy ? crc32(block.data(), block.size())
+                                                    : crc32c(block.data(), block.size());
+        };
+
+        std::string file;
+        std::string index;
+        std::string block;
+        std::string last_key;
+        BlockBuilder prefix_block;
+        const bool prefix = version >= Footer::kFormatPrefixBlocks;
+        auto flush_block = [&] {
+            if (prefix && !prefix_block.empty()) {
+                block = prefix_block.Finish();
+                prefix_block.Reset();
+            }
+            if (block.empty()) return;
+            put_fixed32(block, checksum(block));
+            put_fixed32(index, static_cast<uint32_t>(last_key.size()));
+            index.append(last_key);
+            put_fixed64(index, file.size());
+            put_fixed64(index, block.size());
+            file.append(block);
+            block.clear();
+        };
+        for (int i = 0; i < n; ++i) {
+            std::string key = MakeKey(i);
+            std::string value(16, static_cast<char>('a' + i % 26));
+            last_key = key;
+            if (prefix) {
+                prefix_block.Add(key, value);
+                if (prefix_block.CurrentSizeEstimate() >= 4096) flush_block();
+                continue;
+            }
+            put_fixed32(block, static_cast<uint32_t>(key.size()));
+            put_fixed32(block, static_cast<uint32_t>(value.size()));
+            block.append(key);
+            block.append(value);
+            if (block.size() >= 4096) flush_block();
+        }
+        flush_block();
+
+        uint64_t index_offset = file.size();
+        put_fixed32(index, checksum(index));
+        file.append(index);
+
+        std::string footer(Footer::kEncodedLength, '\0');
+        encode_fixed32(&footer[Footer::kFormatVersionOffset], version);
+        encode_fixed64(&footer[20], index_offset);
+        encode_fixed64(&footer[28], index.size());
+        encode_fixed64(&footer[40], Footer::kTableMagicNumber);
+        file.append(footer);
+        WriteAll(kTestFile, file);
+    }
+}
+
+class SSTableReaderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::filesystem::create_directories(kTestDir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(kTestDir);
+    }
+
+    /// 写入 key 为 key000000 .. key<n-1>（只写偶数时 step = 2）的表
+    void BuildTable(int n, int step = 1, size_t value_size = 16,
+                    const TableOptions& options = {}) {
+        SSTableBuilder builder(kTestFile, options);
+        for (int i = 0; i < n; i += step) {
+            builder.Add(MakeKey(i), std::string(value_size, static_cast<char>('a' + i % 26)));
+        }
+        builder.Finish();
+    }
+};
+
+/**
+ * @brief 单个 Block：所有 Key 都能读回
+ */
+TEST_F(SSTableReaderTest, ReadsSingleBlock) {
+    BuildTable(10);
+
+    SSTableReader reader(kTestFile);
+    EXPECT_EQ(reader.NumBlocks(), 1u);
+    EXPECT_EQ(reader.FormatVersion(), Footer::kFormatBlockTrailer);
+
+    std::string value;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(reader.Get(MakeKey(i), &value)) << MakeKey(i);
+        EXPECT_EQ(value, std::string(16, static_cast<char>('a' + i)));
+    }
+}
+
+/**
+ * @brief 多个 Block：Index 二分查找定位到正确的 Block
+ */
+TEST_F(SSTableReaderTest, ReadsAcrossManyBlocks) {
+    BuildTable(5000, 1, 100);
+
+    SSTableReader reader(kTestFile);
+    EXPECT_GT(reader.NumBlocks(), 50u);
+
+    auto index = reader.Index();
+    for (size_t i = 1; i < index->size(); ++i) {
+        EXPECT_LT((*index)[i - 1].last_key, (*index)[i].last_key);
+    }
+
+    std::string value;
+    for (int i = 0; i < 5000; ++i) {
+        ASSERT_TRUE(reader.Get(MakeKey(i), &value)) << MakeKey(i);
+        EXPECT_EQ(value, std::string(100, static_cast<char>('a' + i % 26)));
+    }
+}
+
+/**
+ * @brief 不存在的 Key：Block 内的空隙、比最小值小、比最大值大
+ */
+TEST_F(SSTableReaderTest, MissingKeys) {
+    BuildTable(2000, 2, 50);
+
+    SSTableReader reader(kTestFile);
+    std::string value;
+    for (int i = 1; i < 2000; i += 2) {
+        EXPECT_FALSE(reader.Get(MakeKey(i), &value)) << MakeKey(i);
+    }
+    EXPECT_FALSE(reader.Get("", &value));
+    EXPECT_FALSE(reader.Get("a", &value));
+    EXPECT_FALSE(reader.Get("zzz", &value));
+    EXPECT_TRUE(reader.Get(MakeKey(0), &value));
+    EXPECT_TRUE(reader.Get(MakeKey(1998), &value));
+}
+
+/**
+ * @brief 二进制 Key（encode_int_key）按字节序有序，负数也能正确查找
+ */
+TEST_F(SSTableReaderTest, BinaryIntKeys) {
+    {
+        SSTableBuilder builder(kTestFile);
+        for (int i = -500; i < 500; ++i) {
+            builder.Add(encode_int_key(i), std::to_string(i));
+        }
+        builder.Finish();
+    }
+
+    SSTableReader reader(kTestFile);
+    std::string value;
+    for (int i = -500; i < 500; ++i) {
+        ASSERT_TRUE(reader.Get(encode_int_key(i), &value)) << i;
+        EXPECT_EQ(value, std::to_string(i));
+    }
+    EXPECT_FALSE(reader.Get(encode_int_key(500), &value));
+    EXPECT_FALSE(reader.Get(encode_int_key(-501), &value));
+}
+
+/**
+ * @brief 空表：可以打开，任何查询都返回 false
+ */
+TEST_F(SSTableReaderTest, EmptyTable) {
+    BuildTable(0);
+
+    SSTableReader reader(kTestFile);
+    EXPECT_EQ(reader.NumBlocks(), 0u);
+    std::string value;
+    EXPECT_FALSE(reader.Get(MakeKey(0), &value));
+}
+
+/**
+ * @brief Magic Number 错误 / 文件过短 / 文件不存在时构造函数抛出异常
+ */
+TEST_F(SSTableReaderTest, RejectsInvalidFiles) {
+    EXPECT_THROW(SSTableReader(kTestDir + "/missing.sst"), std::runtime_error);
+
+    WriteAll(kTestFile, "short");
+    EXPECT_THROW(SSTableReader reader(kTestFile), std::runtime_error);
+
+    BuildTable(10);
+    std::string data = ReadAll(kTestFile);
+    data[data.size() - 1] ^= 0x01;  // 破坏 Magic Number
+    WriteAll(kTestFile, data);
+    EXPECT_THROW(SSTableReader reader(kTestFile), std::runtime_error);
+}
+
+/**
+ * @brief 不支持的格式版本被拒绝
+ */
+TEST_F(SSTableReaderTest, RejectsUnknownFormatVersion) {
+    BuildTable(10);
+    std::string data = ReadAll(kTestFile);
+    size_t footer = data.size() - Footer::kEncodedLength;
+    encode_fixed32(&data[footer + Footer::kFormatVersionOffset], Footer::kCurrentFormatVersion + 1);
+    WriteAll(kTestFile, data);
+
+    EXPECT_THROW(SSTableReader reader(kTestFile), std::runtime_error);
+}
+
+/**
+ * @brief Data Block 位翻转：Get 时 CRC 校验失败并抛出异常
+ */
+TEST_F(SSTableReaderTest, DetectsCorruptedDataBlock) {
+    BuildTable(10);
+    std::string data = ReadAll(kTestFile);
+    data[10] ^= 0x40;  // 位于第一个 Data Block 内
+    WriteAll(kTestFile, data);
+
+    SSTableReader reader(kTestFile);  // Index Block 完好，可以打开
+    std::string value;
+    EXPECT_THROW(reader.Get(MakeKey(0), &value), std::runtime_error);
+}
+
+/**
+ * @brief Index Block 损坏：打开时即失败
+ */
+TEST_F(SSTableReaderTest, DetectsCorruptedIndexBlock) {
+    BuildTable(10);
+    std::string data = ReadAll(kTestFile);
+    size_t footer = data.size() - Footer::kEncodedLength;
+    uint64_t index_offset = decode_fixed64(data.data() + footer + 20);
+    data[static_cast<size_t>(index_offset) + 5] ^= 0x01;
+    WriteAll(kTestFile, data);
+
+    EXPECT_THROW(SSTableReader reader(kTestFile), std::runtime_error);
+}
+
+/**
+ * @brief 格式版本 0 的旧文件使用 CRC32 (IEEE) 校验 Block，仍可读取
+ */
+TEST_F(SSTableReaderTest, ReadsLegacyCrc32Table) {
+    WriteLegacyTable(10, Footer::kFormatLegacy);
+
+    SSTableReader reader(kTestFile);
+    EXPECT_EQ(reader.FormatVersion(), Footer::kFormatLegacy);
+    EXPECT_FALSE(reader.HasFilter());
+    std::string value;
+    ASSERT_TRUE(reader.Get(MakeKey(3), &value));
+    EXPECT_EQ(value, std::string(16, 'd'));
+    EXPECT_FALSE(reader.Get(MakeKey(10), &value));
+}
+
+/**
+ * @brief 格式版本 1 的平铺 Data Block（无前缀压缩）仍可读取
+ */
+TEST_F(SSTableReaderTest, ReadsFlatBlockTable) {
+    WriteLegacyTable(3000, Footer::kFormatCrc32c);
+
+    SSTableReader reader(kTestFile);
+    EXPECT_EQ(reader.FormatVersion(), Footer::kFormatCrc32c);
+    EXPECT_GT(reader.NumBlocks(), 1u);
+    std::string value;
+    for (int i = 0; i < 3000; i += 13) {
+        ASSERT_TRUE(reader.Get(MakeKey(i), &value)) << MakeKey(i);
+        EXPECT_EQ(value, std::string(16, static_cast<char>('a' + i % 26)));
+    }
+    EXPECT_FALSE(reader.Get(MakeKey(3000), &value));
+}
+
+/**
+ * @brief 格式版本 2（前缀压缩 Block + 4 字节 CRC32C 尾部，无压缩类型字节）仍可读取
+ */
+TEST_F(SSTableReaderTest, ReadsVersion2Table) {
+    WriteLegacyTable(3000, Footer::kFormatPrefixBlocks);
+
+    SSTableReader reader(kTestFile);
+    EXPECT_EQ(reader.FormatVersion(), Footer::kFormatPrefixBlocks);
+    EXPECT_GT(reader.NumBlocks(), 1u);
+    std::string value;
+    for (int i = 0; i < 3000; i += 13) {
+        ASSERT_TRUE(reader.Get(MakeKey(i), &value)) << MakeKey(i);
+        EXPECT_EQ(value, std::string(16, static_cast<char>('a' + i % 26)));
+    }
+    EXPECT_FALSE(reader.Get(MakeKey(3000), &value));
+}
+
+/**
+ * @brief 前缀压缩：相邻 Key 共享前缀，文件明显小于不共享（每个 Entry 都是重启点）的情况
+ */
+TEST_F(SSTableReaderTest, PrefixCompressionShrinksTable) {
+    TableOptions no_sharing;
+    no_sharing.block_restart_interval = 1;
+    BuildTable(5000, 1, 8, no_sharing);
+    uint64_t uncompressed = std::filesystem::file_size(kTestFile);
+
+    BuildTable(5000, 1, 8);
+    uint64_t compressed = std::filesystem::file_size(kTestFile);
+    EXPECT_LT(compressed * 10, uncompressed * 8) << compressed << " vs " << uncompressed;
+
+    SSTableReader reader(kTestFile);
+    std::string value;
+    for (int i = 0; i < 5000; ++i) {
+        ASSERT_TRUE(reader.Get(MakeKey(i), &value)) << MakeKey(i);
+    }
+}
+
+/**
+ * @brief Bloom Filter：不存在的 Key 绝大多数在过滤器处被拦截，存在的 Key 一定通过
+ */
+TEST_F(SSTableReaderTest, BloomFilterSkipsAbsentKeys) {
+    BuildTable(2000, 2, 50);
+
+    SSTableReader reader(kTestFile);
+    ASSERT_TRUE(reader.HasFilter());
+
+    std::string value;
+    for (int i = 0; i < 2000; i += 2) {
+        ASSERT_TRUE(reader.KeyMayMatch(MakeKey(i)));
+        ASSERT_TRUE(reader.Get(MakeKey(i), &value));
+    }
+    EXPECT_EQ(reader.FilterSkips(), 0u);
+
+    for (int i = 1; i < 2000; i += 2) {
+        EXPECT_FALSE(reader.Get(MakeKey(i), &value));
+    }
+    // 10 bits/key 的假阳性率约 1%，1000 次查询中绝大多数应被过滤器拦截
+    EXPECT_GT(reader.FilterSkips(), 950u);
+}
+
+/**
+ * @brief bloom_bits_per_key = 0 时不生成过滤器，查询仍然正确
+ */
+TEST_F(SSTableReaderTest, FilterCanBeDisabled) {
+    TableOptions no_filter;
+    no_filter.bloom_bits_per_key = 0;
+    BuildTable(100, 2, 16, no_filter);
+
+    SSTableReader reader(kTestFile);
+    EXPECT_FALSE(reader.HasFilter());
+
+    std::string value;
+    EXPECT_TRUE(reader.Get(MakeKey(10), &value));
+    EXPECT_FALSE(reader.Get(MakeKey(11), &value));
+    EXPECT_EQ(reader.FilterSkips(), 0u);
+}
+
+/**
+ * @brief Filter Block 损坏：打开时即失败
+ */
+TEST_F(SSTableReaderTest, DetectsCorruptedFilterBlock) {
+    BuildTable(10);
+    std::string data = ReadAll(kTestFile);
+    size_t footer = data.size() - Footer::kEncodedLength;
+    uint64_t metaindex_offset = decode_fixed64(data.data() + footer);
+    ASSERT_GT(metaindex_offset, 0u);
+    data[static_cast<size_t>(metaindex_offset) - 6] ^= 0x01;  // Filter Block 紧邻 Metaindex 之前
+    WriteAll(kTestFile, data);
+
+    EXPECT_THROW(SSTableReader reader(kTestFile), std::runtime_error);
+}
+
+/**
+ * @brief 块缓存：重复查询同一个 Block 时命中缓存，不再读盘
+ */
+TEST_F(SSTableReaderTest, DataBlocksAreCached) {
+    BuildTable(1000, 1, 100);
+
+    TableOptions options;
+    options.block_cache = std::make_shared<BlockCache>(1 << 20);
+    SSTableReader reader(kTestFile, options);
+
+    std::string value;
+    ASSERT_TRUE(reader.Get(MakeKey(0), &value));
+    BlockCacheStats first = options.block_cache->Stats();
+    EXPECT_EQ(first.misses, 1u);
+    EXPECT_EQ(first.inserts, 1u);
+
+    ASSERT_TRUE(reader.Get(MakeKey(1), &value));  // 同一个 Block
+    BlockCacheStats second = options.block_cache->Stats();
+    EXPECT_EQ(second.hits, 1u);
+    EXPECT_EQ(second.misses, 1u);
+
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(reader.Get(MakeKey(i), &value));
+    }
+    EXPECT_EQ(options.block_cache->Stats().inserts, reader.NumBlocks());
+}
+
+/**
+ * @brief 缓存命中后不再重新校验：读盘时的 CRC 校验只做一次
+ */
+TEST_F(SSTableReaderTest, CachedBlockSurvivesLaterCorruption) {
+    BuildTable(10);
+
+    TableOptions options;
+    options.block_cache = std::make_shared<BlockCache>(1 << 20);
+    SSTableReader reader(kTestFile, options);
+    std::string value;
+    ASSERT_TRUE(reader.Get(MakeKey(0), &value));
+
+    std::string data = ReadAll(kTestFile);
+    data[10] ^= 0x40;
+    WriteAll(kTestFile, data);
+    EXPECT_TRUE(reader.Get(MakeKey(1), &value));  // 命中缓存，不触碰磁盘
+}
+
+/**
+ * @brief Index / Filter Block 固定在缓存中：计入 pinned_usage，Reader 关闭后解除固定
+ */
+TEST_F(SSTableReaderTest, PinnedIndexAndFilterBlocks) {
+    BuildTable(1000, 1, 100);
+
+    TableOptions options;
+    options.block_cache = std::make_shared<BlockCache>(1 << 20);
+    options.cache_index_and_filter_blocks = true;
+    options.pin_index_and_filter_blocks = true;
+    {
+        SSTableReader reader(kTestFile, options);
+        EXPECT_GT(options.block_cache->Stats().pinned_usage, 0u);
+
+        std::string value;
+        for (int i = 0; i < 1000; i += 37) {
+            ASSERT_TRUE(reader.Get(MakeKey(i), &value));
+        }
+        EXPECT_FALSE(reader.Get("missing", &value));
+    }
+    EXPECT_EQ(options.block_cache->Stats().pinned_usage, 0u);
+}
+
+/**
+ * @brief 未固定的 Index / Filter Block 可以被淘汰，之后自动重新加载
+ */
+TEST_F(SSTableReaderTest, UnpinnedIndexReloadsAfterEviction) {
+    BuildTable(1000, 1, 100);
+
+    TableOptions options;
+    options.block_cache = std::make_shared<BlockCache>(16 * 1024, 0);  // 只能容纳几个 Block
+    options.cache_index_and_filter_blocks = true;
+    options.pin_index_and_filter_blocks = false;
+    SSTableReader reader(kTestFile, options);
+    EXPECT_EQ(options.block_cache->Stats().pinned_usage, 0u);
+
+    std::string value;
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 1000; i += 7) {
+            ASSERT_TRUE(reader.Get(MakeKey(i), &value)) << MakeKey(i);
+            EXPECT_EQ(value, std::string(100, static_cast<char>('a' + i % 26)));
+        }
+    }
+    BlockCacheStats stats = options.block_cache->Stats();
+    EXPECT_GT(stats.evictions, 0u);
+    EXPECT_LE(stats.usage, stats.capacity);
+}
+
+namespace {
+    /// 类 JSON 的 Value（可压缩 3 倍以上）
+    std::string JsonValue(int i) {
+        return "{\"id\":" + std::to_string(i) +
+               ",\"status\":\"active\",\"region\":\"cn-east-1\",\"tags\":[\"a\",\"b\"]}";
+    }
+}
+
+/**
+ * @brief 各压缩类型写出的表都能读回；已编译进来的算法确实压缩了 Data Block，
+ *        未编译进来的算法退回不压缩
+ */
+TEST_F(SSTableReaderTest, CompressedTableRoundTrip) {
+    constexpr int kNum = 2000;
+    uint64_t raw_size = 0;
+    for (CompressionType type :
+         {CompressionType::kNone, CompressionType::kLz4, CompressionType::kZstd}) {
+        TableOptions options;
+        options.compression = type;
+        {
+            SSTableBuilder builder(kTestFile, options);
+            for (int i = 0; i < kNum; ++i) builder.Add(MakeKey(i), JsonValue(i));
+            builder.Finish();
+            if (type == CompressionType::kNone) {
+                raw_size = builder.FileSize();
+            }
+            if (type != CompressionType::kNone && compression_supported(type)) {
+                EXPECT_GT(builder.NumCompressedBlocks(), 0u) << compression_name(type);
+                EXPECT_LT(builder.FileSize(), raw_size / 2) << compression_name(type);
+            } else {
+                EXPECT_EQ(builder.NumCompressedBlocks(), 0u) << compression_name(type);
+                EXPECT_EQ(builder.FileSize(), raw_size) << compression_name(type);
+            }
+        }
+
+        SSTableReader reader(kTestFile);
+        std::string value;
+        for (int i = 0; i < kNum; i += 7) {
+            ASSERT_TRUE(reader.Get(MakeKey(i), &value)) << compression_name(type) << " " << i;
+            EXPECT_EQ(value, JsonValue(i));
+        }
+        EXPECT_FALSE(reader.Get(MakeKey(kNum), &value));
+    }
+}
+
+/**
+ * @brief 压缩收益不足 1/8 的 Block（随机数据）以原始形式存储
+ */
+TEST_F(SSTableReaderTest, IncompressibleBlocksStoredRaw) {
+    std::mt19937 rng(7);
+    auto random_value = [&rng] {
+        std::string value(100, '\0');
+        for (char& c : value) c = static_cast<char>(rng());
+        return value;
+    };
+
+    for (CompressionType type : {CompressionType::kLz4, CompressionType::kZstd}) {
+        TableOptions options;
+        options.compression = type;
+        std::vector<std::string> values;
+        {
+            SSTableBuilder builder(kTestFile, options);
+            for (int i = 0; i < 500; ++i) {
+                values.push_back(random_value());
+                builder.Add(MakeKey(i), values.back());
+            }
+            builder.Finish();
+            EXPECT_EQ(builder.NumCompressedBlocks(), 0u) << compression_name(type);
+        }
+
+        SSTableReader reader(kTestFile);
+        std::string value;
+        for (int i = 0; i < 500; i += 11) {
+            ASSERT_TRUE(reader.Get(MakeKey(i), &value));
+            EXPECT_EQ(value, values[static_cast<size_t>(i)]);
+        }
+    }
+}
+
+/**
+ * @brief 块缓存保存的是解压后的 Block：读遍所有 Block 后缓存占用等于原始 Data Block 大小
+ */
+TEST_F(SSTableReaderTest, CacheHoldsDecompressedBlocks) {
+    TableOptions options;
+    options.compression = CompressionType::kLz4;
+    options.block_cache = std::make_shared<BlockCache>(8 << 20, 0);
+    uint64_t raw_data_bytes = 0;
+    {
+        SSTableBuilder builder(kTestFile, options);
+        for (int i = 0; i < 2000; ++i) builder.Add(MakeKey(i), JsonValue(i));
+        builder.Finish();
+        raw_data_bytes = builder.RawDataBytes();
+    }
+
+    SSTableReader reader(kTestFile, options);
+    std::string value;
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 2000; ++i) {
+            ASSERT_TRUE(reader.Get(MakeKey(i), &value));
+        }
+    }
+    BlockCacheStats stats = options.block_cache->Stats();
+    EXPECT_EQ(stats.usage, raw_data_bytes);
+    EXPECT_EQ(stats.misses, reader.NumBlocks());
+}
+
+/**
+ * @brief Block 尾部的类型字节受 CRC 保护：篡改后 Get 抛出异常
+ */
+TEST_F(SSTableReaderTest, DetectsCorruptedCompressionType) {
+    BuildTable(10);
+    BlockHandle first;
+    {
+        SSTableReader reader(kTestFile);
+        first = reader.Index()->front().handle;
+    }
+    std::string data = ReadAll(kTestFile);
+    size_t type_pos = static_cast<size_t>(first.offset + first.size) - 5;
+    ASSERT_EQ(data[type_pos], static_cast<char>(CompressionType::kNone));
+    data[type_pos] = static_cast<char>(CompressionType::kZstd);
+    WriteAll(kTestFile, data);
+
+    SSTableReader reader(kTestFile);
+    std::string value;
+    EXPECT_THROW(reader.Get(MakeKey(0), &value), std::runtime_error);
+}
+
+/**
+ * @brief 迭代器按 Key 升序遍历多个 Block 的全部条目；Seek 定位到第一个 >= target 的 Key
+ */
+TEST_F(SSTableReaderTest, IteratorScansAllBlocks) {
+    BuildTable(2000, 2);
+
+    SSTableReader reader(kTestFile);
+    ASSERT_GT(reader.NumBlocks(), 1u);
+    SSTableReader::Iterator it(reader);
+    int expected = 0;
+    for (it.SeekToFirst(); it.Valid(); it.Next()) {
+        ASSERT_EQ(it.key(), MakeKey(expected));
+        EXPECT_EQ(it.value(), std::string(16, static_cast<char>('a' + expected % 26)));
+        expected += 2;
+    }
+    EXPECT_EQ(expected, 2000);
+
+    it.Seek(MakeKey(1001));
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.key(), MakeKey(1002));
+    it.Seek(MakeKey(5000));
+    EXPECT_FALSE(it.Valid());
+}
+
+/**
+ * @brief 迭代器同样支持旧格式的平铺 Block；fill_cache = false 时不填充块缓存
+ */
+TEST_F(SSTableReaderTest, IteratorReadsLegacyTableWithoutFillingCache) {
+    WriteLegacyTable(3000, Footer::kFormatCrc32c);
+
+    TableOptions options;
+    options.block_cache = std::make_shared<BlockCache>(1 << 20);
+    SSTableReader reader(kTestFile, options);
+    SSTableReader::Iterator it(reader, /*fill_cache=*/false);
+    int count = 0;
+    for (it.SeekToFirst(); it.Valid(); it.Next()) {
+        ASSERT_EQ(it.key(), MakeKey(count));
+        ++count;
+    }
+    EXPECT_EQ(count, 3000);
+    EXPECT_EQ(options.block_cache->Stats().usage, 0u);
+}
+
+/**
+ * @brief 零拷贝点查：值钉住缓存中的 Block，Block 被淘汰后视图依然有效
+ */
+TEST_F(SSTableReaderTest, PinnedGetSurvivesCacheEviction) {
+    BuildTable(1000, 1, 100);
+
+    TableOptions options;
+    options.block_cache = std::make_shared<BlockCache>(16 * 1024, 0);  // 只能容纳几个 Block
+    SSTableReader reader(kTestFile, options);
+
+    PinnableValue value;
+    ASSERT_TRUE(reader.Get(MakeKey(0), &value));
+    EXPECT_TRUE(value.pinned());
+    for (int i = 999; i > 0; i -= 7) {
+        PinnableValue other;
+        ASSERT_TRUE(reader.Get(MakeKey(i), &other));
+    }
+    EXPECT_GT(options.block_cache->Stats().evictions, 0u);
+    EXPECT_EQ(value.view(), std::string(100, 'a'));
+
+    PinnableValue moved = std::move(value);
+    EXPECT_TRUE(value.empty());
+    EXPECT_EQ(moved.view(), std::string(100, 'a'));
+}
+
+/**
+ * @brief 反向迭代跨越 Block 边界，新旧两种 Block 格式结果一致；Prev 与 Next 可交替使用
+ */
+TEST_F(SSTableReaderTest, IteratorReverseScan) {
+    for (uint32_t version :
+         {Footer::kFormatCrc32c, Footer::kFormatPrefixBlocks, Footer::kFormatBlockTrailer}) {
+        if (version == Footer::kFormatBlockTrailer) {
+            BuildTable(3000);
+        } else {
+            WriteLegacyTable(3000, version);
+        }
+        SSTableReader reader(kTestFile);
+        ASSERT_GT(reader.NumBlocks(), 1u);
+
+        SSTableReader::Iterator it(reader);
+        int expected = 2999;
+        for (it.SeekToLast(); it.Valid(); it.Prev()) {
+            ASSERT_EQ(it.key(), MakeKey(expected)) << version;
+            --expected;
+        }
+        EXPECT_EQ(expected, -1) << version;
+
+        it.Seek(MakeKey(1500));
+        it.Prev();
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), MakeKey(1499));
+        it.Next();
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), MakeKey(1500));
+    }
+
+    BuildTable(0);
+    SSTableReader empty(kTestFile);
+    SSTableReader::Iterator it(empty);
+    it.SeekToLast();
+    EXPECT_FALSE(it.Valid());
+}
+
+/**
+ * @brief 内部 Key 格式：GetVisible 按快照返回版本（跨 Block 边界），Bloom Filter 只使用 UserKey；
+ *        旧格式表视为只有序列号 0 的版本
+ */
+TEST_F(SSTableReaderTest, GetVisibleHonoursSnapshot) {
+    TableOptions options;
+    options.internal_keys = true;
+    options.bloom_bits_per_key = 10;
+    {
+        SSTableBuilder builder(kTestFile, options);
+        for (int i = 0; i < 1000; ++i) {
+            // 每个 Key 三个版本：序列号 300 的删除标记、200 与 100 的值
+            std::string key = MakeKey(i);
+            builder.Add(make_internal_key(key, 300, ValueType::kDeletion), "");
+            builder.Add(make_internal_key(key, 200, ValueType::kValue), std::string(40, 'n'));
+            builder.Add(make_internal_key(key, 100, ValueType::kValue), std::string(40, 'o'));
+        }
+        builder.Finish();
+    }
+
+    SSTableReader reader(kTestFile, options);
+    EXPECT_TRUE(reader.HasInternalKeys());
+    EXPECT_EQ(reader.FormatVersion(), Footer::kFormatInternalKeys);
+    ASSERT_GT(reader.NumBlocks(), 1u);
+    for (int i = 0; i < 1000; i += 37) {
+        std::string key = MakeKey(i);
+        ValueType type;
+        PinnableValue value;
+        EXPECT_FALSE(reader.GetVisible(key, 99, &type, &value)) << i;
+        ASSERT_TRUE(reader.GetVisible(key, 150, &type, &value)) << i;
+        EXPECT_EQ(type, ValueType::kValue);
+        EXPECT_EQ(value.view(), std::string(40, 'o'));
+        ASSERT_TRUE(reader.GetVisible(key, 200, &type, &value)) << i;
+        EXPECT_EQ(value.view(), std::string(40, 'n'));
+        ASSERT_TRUE(reader.GetVisible(key, kMaxSequenceNumber, &type, &value)) << i;
+        EXPECT_EQ(type, ValueType::kDeletion);
+    }
+    ValueType type;
+    PinnableValue value;
+    EXPECT_FALSE(reader.GetVisible(MakeKey(5000), kMaxSequenceNumber, &type, &value));
+    EXPECT_GT(reader.FilterSkips(), 0u);
+
+    {
+        SSTableBuilder builder(kTestFile);
+        builder.Add(MakeKey(3), encode_table_value(ValueType::kValue, "legacy"));
+        builder.Add(MakeKey(4), encode_table_value(ValueType::kDeletion, ""));
+        builder.Finish();
+    }
+    SSTableReader legacy(kTestFile);
+    EXPECT_FALSE(legacy.HasInternalKeys());
+    ASSERT_TRUE(legacy.GetVisible(MakeKey(3), 0, &type, &value));
+    EXPECT_EQ(type, ValueType::kValue);
+    EXPECT_EQ(value.view(), "legacy");
+    ASSERT_TRUE(legacy.GetVisible(MakeKey(4), 0, &type, &value));
+    EXPECT_EQ(type, ValueType::kDeletion);
+}
+
+/**
+ * @brief mmap 读取：未压缩的 Block 直接在映射上解析，不进缓存；值钉住映射，比 Reader 活得久
+ */
+TEST_F(SSTableReaderTest, MmapReadsBypassBlockCache) {
+    BuildTable(1000, 1, 100);
+
+    TableOptions options;
+    options.block_cache = std::make_shared<BlockCache>(1 << 20);
+    options.use_mmap_reads = true;
+    PinnableValue pinned;
+    {
+        SSTableReader reader(kTestFile, options);
+        EXPECT_EQ(reader.MappedBytes(), reader.FileSize());
+
+        std::string value;
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_TRUE(reader.Get(MakeKey(i), &value)) << i;
+            EXPECT_EQ(value, std::string(100, static_cast<char>('a' + i % 26)));
+        }
+        EXPECT_FALSE(reader.Get(MakeKey(1000), &value));
+        EXPECT_EQ(options.block_cache->Stats().inserts, 0u);
+        EXPECT_GT(reader.ResidentBytes(), 0u);
+        EXPECT_LE(reader.ResidentBytes(), reader.MappedBytes());
+
+        int count = 0;
+        SSTableReader::Iterator iter(reader);
+        for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+            EXPECT_EQ(iter.key(), MakeKey(count));
+            ++count;
+        }
+        EXPECT_EQ(count, 1000);
+
+        ASSERT_TRUE(reader.Get(MakeKey(27), &pinned));
+        EXPECT_TRUE(pinned.pinned());
+    }
+    EXPECT_EQ(pinned.view(), std::string(100, 'b'));
+
+    SSTableReader plain(kTestFile);
+    EXPECT_EQ(plain.MappedBytes(), 0u);
+    EXPECT_EQ(plain.ResidentBytes(), 0u);
+}
+
+/**
+ * @brief mmap 读取同样校验 CRC；压缩的 Block 仍解压后放入缓存
+ */
+TEST_F(SSTableReaderTest, MmapVerifiesChecksumsAndCachesCompressedBlocks) {
+    BuildTable(10);
+    std::string data = ReadAll(kTestFile);
+    data[10] ^= 0x40;
+    WriteAll(kTestFile, data);
+    TableOptions mmap_options;
+    mmap_options.use_mmap_reads = true;
+    {
+        SSTableReader reader(kTestFile, mmap_options);
+        std::string value;
+        EXPECT_THROW(reader.Get(MakeKey(0), &value), std::runtime_error);
+    }
+
+    if (!compression_supported(CompressionType::kLz4)) return;
+    TableOptions options;
+    options.compression = CompressionType::kLz4;
+    {
+        SSTableBuilder builder(kTestFile, options);
+        for (int i = 0; i < 2000; ++i) builder.Add(MakeKey(i), JsonValue(i));
+        builder.Finish();
+        ASSERT_GT(builder.NumCompressedBlocks(), 0u);
+    }
+    mmap_options.block_cache = std::make_shared<BlockCache>(1 << 20);
+    SSTableReader reader(kTestFile, mmap_options);
+    std::string value;
+    for (int i = 0; i < 2000; i += 7) {
+        ASSERT_TRUE(reader.Get(MakeKey(i), &value)) << i;
+        EXPECT_EQ(value, JsonValue(i));
+    }
+    EXPECT_GT(mmap_options.block_cache->Stats().inserts, 0u);
+}
+
+/**
+ * @brief mmap 读取时未压缩的 Block 只在第一次访问时校验 CRC：之后映射中的改动不再被检查，
+ *        新打开的 Reader 第一次访问时仍能发现
+ */
+TEST_F(SSTableReaderTest, MmapVerifiesEachBlockOnce) {
+    BuildTable(10);
+    TableOptions options;
+    options.use_mmap_reads = true;
+    SSTableReader reader(kTestFile, options);
+    std::string value;
+    ASSERT_TRUE(reader.Get(MakeKey(0), &value));
+    EXPECT_EQ(value, std::string(16, 'a'));
+
+    // 原地改写 key0 的值的一个字节（不截断文件，映射始终有效）
+    size_t pos = ReadAll(kTestFile).find(std::string(16, 'a'));
+    ASSERT_NE(pos, std::string::npos);
+    {
+        std::fstream file(kTestFile, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(pos));
+        file.put('A');
+    }
+
+    ASSERT_TRUE(reader.Get(MakeKey(0), &value));
+    EXPECT_EQ(value, "A" + std::string(15, 'a'));
+
+    SSTableReader fresh(kTestFile, options);
+    EXPECT_THROW(fresh.Get(MakeKey(0), &value), std::runtime_error);
+}
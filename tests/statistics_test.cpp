@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "statistics.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 每个值落在下界不超过它、下一个桶下界大于它的桶中
+ */
+TEST(StatisticsTest, HistogramBucketsCoverValues) {
+    for (uint64_t v : {0ull, 1ull, 3ull, 4ull, 5ull, 7ull, 8ull, 15ull, 16ull, 17ull, 31ull, 32ull, 1000ull, 123456789ull, ~0ull >> 1, ~0ull}) {
+        size_t index = HistogramData::BucketIndex(v);
+        ASSERT_LT(index, HistogramData::kNumBuckets);
+        EXPECT_LE(HistogramData::BucketLow(index), v) << v;
+        if (index + 1 < HistogramData::kNumBuckets) {
+            EXPECT_GT(HistogramData::BucketLow(index + 1), v) << v;
+        }
+    }
+}
+
+/**
+ * @brief 分位数的误差不超过所在桶的宽度（1/16）
+ */
+TEST(StatisticsTest, HistogramPercentiles) {
+    Statistics stats;
+    for (uint64_t v = 1; v <= 10000; ++v) stats.Measure(HistogramType::kGet, v * 1000);
+
+    HistogramData h = stats.GetHistogram(HistogramType::kGet);
+    EXPECT_EQ(h.count, 10000u);
+    EXPECT_EQ(h.max, 10000u * 1000);
+    EXPECT_DOUBLE_EQ(h.Average(), 5000.5 * 1000);
+    EXPECT_NEAR(h.Percentile(0.5), 5e6, 5e6 / 16);
+    EXPECT_NEAR(h.Percentile(0.99), 9.9e6, 9.9e6 / 16);
+    EXPECT_LE(h.Percentile(1.0), 1e7);
+    EXPECT_EQ(stats.GetHistogram(HistogramType::kPut).count, 0u);
+}
+
+/**
+ * @brief 单线程直接记录的 HistogramData 合并后与 Statistics 的结果一致
+ */
+TEST(StatisticsTest, HistogramDataAddAndMerge) {
+    Statistics stats;
+    HistogramData even, odd;
+    for (uint64_t v = 1; v <= 5000; ++v) {
+        stats.Measure(HistogramType::kPut, v * 37);
+        (v % 2 == 0 ? even : odd).Add(v * 37);
+    }
+    even.Merge(odd);
+
+    HistogramData expected = stats.GetHistogram(HistogramType::kPut);
+    EXPECT_EQ(even.buckets, expected.buckets);
+    EXPECT_EQ(even.count, expected.count);
+    EXPECT_EQ(even.sum, expected.sum);
+    EXPECT_EQ(even.max, expected.max);
+    EXPECT_DOUBLE_EQ(even.Percentile(0.999), expected.Percentile(0.999));
+}
+
+/**
+ * @brief 多个线程写入各自的分片，读取时合并为总和；Reset 清零
+ */
+TEST(StatisticsTest, MergesPerThreadShards) {
+    Statistics stats;
+    constexpr int kThreads = 8;
+    constexpr int kPerThread = 10000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&stats, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                stats.Record(Ticker::kPuts);
+                stats.Record(Ticker::kBytesWritten, 10);
+                stats.Measure(HistogramType::kPut, static_cast<uint64_t>(t * 100 + 1));
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    EXPECT_EQ(stats.Get(Ticker::kPuts), uint64_t{kThreads} * kPerThread);
+    EXPECT_EQ(stats.Get(Ticker::kBytesWritten), uint64_t{kThreads} * kPerThread * 10);
+    HistogramData h = stats.GetHistogram(HistogramType::kPut);
+    EXPECT_EQ(h.count, uint64_t{kThreads} * kPerThread);
+    EXPECT_EQ(h.max, uint64_t{(kThreads - 1) * 100 + 1});
+
+    stats.Reset();
+    EXPECT_EQ(stats.Get(Ticker::kPuts), 0u);
+    EXPECT_EQ(stats.GetHistogram(HistogramType::kPut).count, 0u);
+}
+
+/**
+ * @brief 文本报告与 Prometheus 导出包含每个计数器与直方图
+ */
+TEST(StatisticsTest, ExportsTextAndPrometheus) {
+    Statistics stats;
+    stats.Record(Ticker::kGets, 3);
+    stats.Measure(HistogramType::kFlush, 2'000'000'000);
+
+    std::string text = stats.ToString();
+    EXPECT_NE(text.find("kv.gets COUNT : 3\n"), std::string::npos) << text;
+    EXPECT_NE(text.find("kv.flush.micros COUNT : 1"), std::string::npos) << text;
+
+    std::string prom = stats.ToPrometheus();
+    EXPECT_NE(prom.find("# TYPE kv_gets_total counter\nkv_gets_total 3\n"), std::string::npos) << prom;
+    EXPECT_NE(prom.find("# TYPE kv_flush_seconds summary\n"), std::string::npos) << prom;
+    EXPECT_NE(prom.find("kv_flush_seconds_sum 2.000000000\n"), std::string::npos) << prom;
+    EXPECT_NE(prom.find("kv_flush_seconds_count 1\n"), std::string::npos) << prom;
+    EXPECT_NE(prom.find("kv_put_seconds{quantile=\"0.99\"} 0.000000000\n"), std::string::npos) << prom;
+}
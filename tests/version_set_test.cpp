@@ -0,0 +1,372 @@
+#include <gtest/gtest.h>
+#include "blob_file.h"
+#include "dbformat.h"
+#include "filename.h"
+#include "sstable_builder.h"
+#include "version_edit.h"
+#include "version_set.h"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @file version_set_test.cpp
+ * @brief VersionEdit 与 VersionSet (MANIFEST) 的单元测试
+ *
+ * 测试目标：
+ * 1. 验证 VersionEdit 编解码往返，以及对截断 / 未知 Tag 的拒绝
+ * 2. 验证 LogAndApply 写入的修改在重新 Recover 后完整恢复（含 MANIFEST 切换）
+ * 3. 验证末尾不完整的记录被忽略、中间损坏的记录报错
+ * 4. 验证被淘汰的文件在最后一个引用它的 Version 释放后才删除，读取器按需打开
+ * 5. 验证 Blob 文件与垃圾统计的持久化，以及不再被引用的 Blob 文件的删除
+ */
+
+namespace fs = std::filesystem;
+
+namespace {
+    const std::string kTestDir = "./test_data_versions";
+
+    FileMetaData MakeFile(uint64_t number, int smallest, int largest, uint64_t size = 100) {
+        FileMetaData file;
+        file.number = number;
+        file.file_size = size;
+        file.smallest = encode_int_key(smallest);
+        file.largest = encode_int_key(largest);
+        return file;
+    }
+
+    /// 写出一个真实的 SSTable（Key 为 [smallest, largest]），返回其元数据
+    FileMetaData WriteTable(int level, uint64_t number, int smallest, int largest) {
+        SSTableBuilder builder((fs::path(kTestDir) / table_file_name(level, number)).string());
+        for (int k = smallest; k <= largest; ++k) {
+            builder.Add(encode_int_key(k), encode_table_value(ValueType::kValue, std::to_string(k)));
+        }
+        builder.Finish();
+        return MakeFile(number, smallest, largest, builder.FileSize());
+    }
+
+    std::string CurrentManifest() {
+        std::ifstream in(fs::path(kTestDir) / kCurrentFileName);
+        std::string name;
+        std::getline(in, name);
+        return name;
+    }
+}
+
+class VersionSetTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fs::remove_all(kTestDir);
+        fs::create_directories(kTestDir);
+    }
+
+    void TearDown() override { fs::remove_all(kTestDir); }
+};
+
+/**
+ * @brief 编码后再解码得到完全相同的内容
+ */
+TEST(VersionEditTest, EncodeDecodeRoundTrip) {
+    VersionEdit edit;
+    edit.SetComparatorName("distributedkv.BytewiseComparator");
+    edit.SetLogNumber(7);
+    edit.SetNextFileNumber(42);
+    edit.SetLastSequence(uint64_t{1} << 50);
+    edit.DeleteFile(0, 3);
+    edit.DeleteFile(2, 5);
+    edit.AddFile(1, MakeFile(9, -5, 100, 4096));
+    edit.AddFile(3, MakeFile(10, 200, 300, 1 << 20));
+
+    VersionEdit decoded;
+    ASSERT_TRUE(decoded.Decode(edit.Encode()));
+    EXPECT_TRUE(decoded.HasComparatorName());
+    EXPECT_EQ(decoded.ComparatorName(), "distributedkv.BytewiseComparator");
+    EXPECT_TRUE(decoded.HasLogNumber());
+    EXPECT_EQ(decoded.LogNumber(), 7u);
+    EXPECT_TRUE(decoded.HasNextFileNumber());
+    EXPECT_EQ(decoded.NextFileNumber(), 42u);
+    EXPECT_TRUE(decoded.HasLastSequence());
+    EXPECT_EQ(decoded.LastSequence(), uint64_t{1} << 50);
+    ASSERT_EQ(decoded.DeletedFiles().size(), 2u);
+    EXPECT_EQ(decoded.DeletedFiles()[1], std::make_pair(2, uint64_t{5}));
+    ASSERT_EQ(decoded.NewFiles().size(), 2u);
+    EXPECT_EQ(decoded.NewFiles()[0].first, 1);
+    EXPECT_EQ(decoded.NewFiles()[0].second.number, 9u);
+    EXPECT_EQ(decoded.NewFiles()[0].second.file_size, 4096u);
+    EXPECT_EQ(decoded.NewFiles()[0].second.smallest, encode_int_key(-5));
+    EXPECT_EQ(decoded.NewFiles()[1].second.largest, encode_int_key(300));
+
+    VersionEdit empty;
+    ASSERT_TRUE(decoded.Decode(empty.Encode()));
+    EXPECT_FALSE(decoded.HasLogNumber());
+    EXPECT_FALSE(decoded.HasLastSequence());
+    EXPECT_FALSE(decoded.HasComparatorName());
+    EXPECT_TRUE(decoded.NewFiles().empty());
+}
+
+/**
+ * @brief 截断的数据与未知 Tag 都被拒绝
+ */
+TEST(VersionEditTest, RejectsMalformedInput) {
+    VersionEdit edit;
+    edit.AddFile(1, MakeFile(9, 1, 2));
+    std::string encoded = edit.Encode();
+
+    VersionEdit decoded;
+    for (size_t len = 1; len < encoded.size(); ++len) {
+        EXPECT_FALSE(decoded.Decode(std::string_view(encoded.data(), len))) << "len=" << len;
+    }
+    EXPECT_FALSE(decoded.Decode(std::string(1, '\x7f')));
+}
+
+/**
+ * @brief 写入的修改在重新打开后恢复：文件集合、LogNumber、序列号、文件编号都不回退
+ */
+TEST_F(VersionSetTest, RecoversAppliedEdits) {
+    uint64_t next = 0;
+    {
+        VersionSet versions(kTestDir, 4, TableOptions{});
+        EXPECT_FALSE(versions.Recover());
+        versions.NewManifest();
+
+        VersionEdit add;
+        add.AddFile(0, MakeFile(versions.NewFileNumber(), 10, 20));
+        add.AddFile(0, MakeFile(versions.NewFileNumber(), 15, 30));
+        add.AddFile(1, MakeFile(versions.NewFileNumber(), 40, 50));
+        add.SetLogNumber(5);
+        add.SetLastSequence(900);
+        versions.LogAndApply(&add);
+
+        VersionEdit move;
+        move.DeleteFile(0, versions.current()->Files(0)[0]->Number());
+        move.AddFile(2, MakeFile(versions.NewFileNumber(), 10, 20));
+        move.SetLastSequence(800);  // 不会让已记录的序列号倒退
+        versions.LogAndApply(&move);
+        EXPECT_EQ(versions.LastSequence(), 900u);
+        next = versions.NewFileNumber();
+    }
+
+    VersionSet versions(kTestDir, 4, TableOptions{});
+    uint64_t edits = 0;
+    ASSERT_TRUE(versions.Recover(&edits));
+    EXPECT_EQ(edits, 3u);  // 快照 + 两次修改
+    auto version = versions.current();
+    ASSERT_EQ(version->NumFiles(0), 1u);
+    EXPECT_EQ(version->Files(0)[0]->Smallest(), encode_int_key(15));
+    EXPECT_EQ(version->NumFiles(1), 1u);
+    EXPECT_EQ(version->NumFiles(2), 1u);
+    EXPECT_EQ(version->LevelBytes(2), 100u);
+    EXPECT_EQ(versions.LogNumber(), 5u);
+    EXPECT_EQ(versions.LastSequence(), 900u);
+    EXPECT_GE(versions.NewFileNumber(), next);
+
+    // 读取路径的文件顺序：L0 新到旧，再逐层向下
+    auto files = version->FilesForKey(encode_int_key(17));
+    ASSERT_EQ(files.size(), 2u);
+    EXPECT_EQ(files[0]->Level(), 0);
+    EXPECT_EQ(files[1]->Level(), 2);
+    EXPECT_TRUE(version->FilesForKey(encode_int_key(35)).empty());
+}
+
+/**
+ * @brief NewManifest 写入快照、切换 CURRENT 并删除旧 MANIFEST；超过大小上限时自动切换
+ */
+TEST_F(VersionSetTest, RollsOverManifest) {
+    VersionSet versions(kTestDir, 2, TableOptions{}, /*max_manifest_file_size=*/256);
+    versions.NewManifest();
+    std::string first = CurrentManifest();
+    EXPECT_EQ(first, manifest_file_name(versions.ManifestNumber()));
+
+    for (int i = 0; i < 20; ++i) {
+        VersionEdit edit;
+        edit.AddFile(1, MakeFile(versions.NewFileNumber(), i * 10, i * 10 + 5));
+        versions.LogAndApply(&edit);
+    }
+    EXPECT_NE(CurrentManifest(), first);
+    EXPECT_FALSE(fs::exists(fs::path(kTestDir) / first));
+
+    VersionSet reopened(kTestDir, 2, TableOptions{});
+    ASSERT_TRUE(reopened.Recover());
+    EXPECT_EQ(reopened.current()->NumFiles(1), 20u);
+}
+
+/**
+ * @brief 末尾写到一半的记录被忽略；中间的记录损坏时报错
+ */
+TEST_F(VersionSetTest, HandlesTornAndCorruptedRecords) {
+    {
+        VersionSet versions(kTestDir, 2, TableOptions{});
+        versions.NewManifest();
+        for (int i = 0; i < 3; ++i) {
+            VersionEdit edit;
+            edit.AddFile(1, MakeFile(versions.NewFileNumber(), i * 10, i * 10 + 5));
+            versions.LogAndApply(&edit);
+        }
+    }
+    fs::path manifest = fs::path(kTestDir) / CurrentManifest();
+    uint64_t size = fs::file_size(manifest);
+
+    fs::resize_file(manifest, size - 3);
+    {
+        VersionSet versions(kTestDir, 2, TableOptions{});
+        ASSERT_TRUE(versions.Recover());
+        EXPECT_EQ(versions.current()->NumFiles(1), 2u);
+    }
+
+    {
+        std::fstream f(manifest, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(10);
+        f.put('\xff');
+    }
+    VersionSet versions(kTestDir, 2, TableOptions{});
+    EXPECT_THROW(versions.Recover(), std::runtime_error);
+}
+
+/**
+ * @brief MANIFEST 中的层号超出 num_levels 时报错
+ */
+TEST_F(VersionSetTest, RejectsLevelBeyondNumLevels) {
+    {
+        VersionSet versions(kTestDir, 4, TableOptions{});
+        versions.NewManifest();
+        VersionEdit edit;
+        edit.AddFile(3, MakeFile(versions.NewFileNumber(), 1, 2));
+        versions.LogAndApply(&edit);
+    }
+    VersionSet versions(kTestDir, 2, TableOptions{});
+    EXPECT_THROW(versions.Recover(), std::runtime_error);
+}
+
+/**
+ * @brief 读取器按需打开；被删除的文件在最后一个引用它的 Version 释放后才从磁盘删除
+ */
+TEST_F(VersionSetTest, ObsoleteFileDeletedAfterLastReference) {
+    VersionSet versions(kTestDir, 2, TableOptions{});
+    versions.NewManifest();
+
+    VersionEdit add;
+    add.AddFile(1, WriteTable(1, versions.NewFileNumber(), 0, 99));
+    versions.LogAndApply(&add);
+
+    std::shared_ptr<const Version> snapshot = versions.current();
+    const TableFile* file = snapshot->FindFile(1, encode_int_key(50));
+    ASSERT_NE(file, nullptr);
+    EXPECT_FALSE(file->IsOpen());
+    std::string value;
+    ASSERT_TRUE(file->Reader()->Get(encode_int_key(50), &value));
+    EXPECT_TRUE(file->IsOpen());
+    fs::path path = file->Path();
+
+    VersionEdit remove;
+    remove.DeleteFile(1, file->Number());
+    versions.LogAndApply(&remove);
+    EXPECT_EQ(versions.current()->NumFiles(1), 0u);
+
+    // 旧快照仍可读取
+    EXPECT_TRUE(fs::exists(path));
+    EXPECT_TRUE(file->Reader()->Get(encode_int_key(99), &value));
+
+    snapshot.reset();
+    EXPECT_FALSE(fs::exists(path));
+}
+
+/**
+ * @brief Blob 文件、SSTable 引用的 Blob 文件与垃圾统计的编解码往返
+ */
+TEST(VersionEditTest, EncodesBlobFiles) {
+    VersionEdit edit;
+    FileMetaData with_blobs = MakeFile(9, 1, 2);
+    with_blobs.blob_files = {3, 5};
+    edit.AddFile(1, with_blobs);
+    edit.AddFile(1, MakeFile(10, 3, 4));
+    edit.AddBlobFile(BlobFileMetaData{5, 4096, 10, 4000});
+    edit.AddBlobGarbage(3, 2, 700);
+
+    VersionEdit decoded;
+    ASSERT_TRUE(decoded.Decode(edit.Encode()));
+    ASSERT_EQ(decoded.NewFiles().size(), 2u);
+    EXPECT_EQ(decoded.NewFiles()[0].second.blob_files, (std::vector<uint64_t>{3, 5}));
+    EXPECT_TRUE(decoded.NewFiles()[1].second.blob_files.empty());
+    ASSERT_EQ(decoded.NewBlobFiles().size(), 1u);
+    EXPECT_EQ(decoded.NewBlobFiles()[0].number, 5u);
+    EXPECT_EQ(decoded.NewBlobFiles()[0].file_size, 4096u);
+    EXPECT_EQ(decoded.NewBlobFiles()[0].blob_count, 10u);
+    EXPECT_EQ(decoded.NewBlobFiles()[0].blob_bytes, 4000u);
+    ASSERT_EQ(decoded.BlobGarbageList().size(), 1u);
+    EXPECT_EQ(decoded.BlobGarbageList()[0].number, 3u);
+    EXPECT_EQ(decoded.BlobGarbageList()[0].count, 2u);
+    EXPECT_EQ(decoded.BlobGarbageList()[0].bytes, 700u);
+
+    // 截断在 Blob 文件列表中间
+    VersionEdit single;
+    single.AddFile(1, with_blobs);
+    std::string encoded = single.Encode();
+    EXPECT_FALSE(decoded.Decode(std::string_view(encoded.data(), encoded.size() - 4)));
+}
+
+/**
+ * @brief Blob 文件与垃圾统计在重新打开后恢复；不再被任何 SSTable 引用的 Blob 文件
+ *        在最后一个引用它的 Version 释放后删除
+ */
+TEST_F(VersionSetTest, TracksBlobFilesAndGarbage) {
+    uint64_t blob_number = 0;
+    uint64_t table_number = 0;
+    {
+        VersionSet versions(kTestDir, 2, TableOptions{});
+        versions.NewManifest();
+
+        blob_number = versions.NewFileNumber();
+        BlobFileBuilder blob((fs::path(kTestDir) / blob_file_name(blob_number)).string(), blob_number);
+        blob.Add(encode_int_key(1), std::string(600, 'a'));
+        blob.Add(encode_int_key(2), std::string(400, 'b'));
+        blob.Finish();
+
+        table_number = versions.NewFileNumber();
+        FileMetaData table = WriteTable(1, table_number, 0, 9);
+        table.blob_files = {blob_number};
+        VersionEdit add;
+        add.AddBlobFile(BlobFileMetaData{blob_number, blob.FileSize(), blob.BlobCount(), blob.BlobBytes()});
+        add.AddFile(1, table);
+        versions.LogAndApply(&add);
+
+        VersionEdit garbage;
+        garbage.AddBlobGarbage(blob_number, 1, 400);
+        versions.LogAndApply(&garbage);
+        const auto& blobs = versions.current()->BlobFiles();
+        ASSERT_EQ(blobs.size(), 1u);
+        EXPECT_EQ(blobs.at(blob_number).garbage_bytes, 400u);
+        EXPECT_DOUBLE_EQ(blobs.at(blob_number).GarbageRatio(), 0.4);
+    }
+
+    VersionSet versions(kTestDir, 2, TableOptions{});
+    ASSERT_TRUE(versions.Recover());
+    std::shared_ptr<const Version> snapshot = versions.current();
+    ASSERT_EQ(snapshot->BlobFiles().size(), 1u);
+    const auto& state = snapshot->BlobFiles().at(blob_number);
+    EXPECT_EQ(state.garbage_count, 1u);
+    EXPECT_EQ(state.garbage_bytes, 400u);
+    EXPECT_EQ(state.file->Meta().blob_count, 2u);
+    EXPECT_EQ(*state.file->Get(BlobIndex{blob_number, 8, 600}, encode_int_key(1)), std::string(600, 'a'));
+
+    // 快照记录同样保留垃圾统计
+    versions.NewManifest();
+    {
+        VersionSet reopened(kTestDir, 2, TableOptions{});
+        ASSERT_TRUE(reopened.Recover());
+        EXPECT_EQ(reopened.current()->BlobFiles().at(blob_number).garbage_bytes, 400u);
+    }
+
+    fs::path blob_path = state.file->Path();
+    VersionEdit remove;
+    remove.DeleteFile(1, table_number);
+    versions.LogAndApply(&remove);
+    EXPECT_TRUE(versions.current()->BlobFiles().empty());
+    EXPECT_EQ(versions.current()->FindBlobFile(blob_number), nullptr);
+    EXPECT_TRUE(fs::exists(blob_path));
+
+    snapshot.reset();
+    EXPECT_FALSE(fs::exists(blob_path));
+}
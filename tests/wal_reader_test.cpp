@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include "wal_reader.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @file wal_reader_test.cpp
+ * @brief WalReader（流式 WAL 读取器）的单元测试
+ *
+ * 重点覆盖缓冲区边界：使用很小的缓冲区，强制记录跨越缓冲区、或单条记录大于缓冲区。
+ */
+
+namespace fs = std::filesystem;
+
+class WalReaderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = "test_data_wal_reader";
+        fs::remove_all(dir_);
+        fs::create_directories(dir_);
+        path_ = fs::path(dir_) / "wal.log";
+    }
+
+    void TearDown() override { fs::remove_all(dir_); }
+
+    void write_records(const std::vector<LogRecord>& records) {
+        std::ofstream out(path_, std::ios::binary | std::ios::trunc);
+        for (const auto& r : records) {
+            std::string encoded = encode_log_record(r);
+            out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+        }
+    }
+
+    std::string dir_;
+    fs::path path_;
+};
+
+/**
+ * @brief 不存在的文件：is_open() 为 false
+ */
+TEST_F(WalReaderTest, MissingFile) {
+    WalReader reader(fs::path(dir_) / "nope.log");
+    EXPECT_FALSE(reader.is_open());
+}
+
+/**
+ * @brief 小缓冲区下，跨边界与超过缓冲区大小的记录都能被完整读出
+ */
+TEST_F(WalReaderTest, ReadsAcrossBufferBoundaries) {
+    std::vector<LogRecord> records;
+    for (int i = 0; i < 100; ++i) {
+        records.push_back({LogType::kPut, encode_int_key(i), std::string(static_cast<size_t>(i * 7), 'a' + (i % 26))});
+    }
+    records.push_back({LogType::kDelete, encode_int_key(3), ""});
+    write_records(records);
+
+    WalReader reader(path_, 64);
+    ASSERT_TRUE(reader.is_open());
+
+    LogRecordView view;
+    uint64_t expected_offset = 0;
+    for (const auto& r : records) {
+        ASSERT_EQ(reader.next(view), WalReader::Status::kRecord);
+        EXPECT_EQ(view.type, r.type);
+        EXPECT_EQ(view.key_encoding, KeyEncoding::kBinary);
+        EXPECT_EQ(view.key, r.key);
+        EXPECT_EQ(view.value, r.value);
+        EXPECT_EQ(view.offset, expected_offset);
+        expected_offset += view.size;
+    }
+    EXPECT_EQ(reader.next(view), WalReader::Status::kEof);
+    EXPECT_EQ(reader.offset(), fs::file_size(path_));
+}
+
+/**
+ * @brief 尾部半条记录：返回 kTruncated，且 offset() 停在最后一条完整记录之后
+ */
+TEST_F(WalReaderTest, DetectsTruncatedTail) {
+    write_records({{LogType::kPut, encode_int_key(1), "v1"}, {LogType::kPut, encode_int_key(2), "v2"}});
+    uint64_t full = fs::file_size(path_);
+    fs::resize_file(path_, full - 3);
+
+    WalReader reader(path_);
+    LogRecordView view;
+    ASSERT_EQ(reader.next(view), WalReader::Status::kRecord);
+    uint64_t first_end = reader.offset();
+    EXPECT_EQ(reader.next(view), WalReader::Status::kTruncated);
+    EXPECT_EQ(reader.offset(), first_end);
+}
+
+/**
+ * @brief 长度字段被破坏成巨大值时按截断处理，而不是尝试分配巨大缓冲区
+ */
+TEST_F(WalReaderTest, HugeLengthFieldIsTruncated) {
+    write_records({{LogType::kPut, encode_int_key(1), "v1"}});
+    {
+        std::fstream f(path_, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(8);
+        uint32_t huge = 0xFFFFFFF0u;
+        f.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+    }
+
+    WalReader reader(path_);
+    LogRecordView view;
+    EXPECT_EQ(reader.next(view), WalReader::Status::kTruncated);
+}
+
+/**
+ * @brief Payload 位翻转：返回 kCorrupted
+ */
+TEST_F(WalReaderTest, DetectsChecksumMismatch) {
+    write_records({{LogType::kPut, encode_int_key(1), "value"}});
+    {
+        std::fstream f(path_, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(static_cast<std::streamoff>(kLogRecordHeaderSize + 5));
+        f.put('X');
+    }
+
+    WalReader reader(path_);
+    LogRecordView view;
+    EXPECT_EQ(reader.next(view), WalReader::Status::kCorrupted);
+}
+
+/**
+ * @brief 带序列号的记录：封口后序列号随记录读出，与旧格式记录混合时旧记录的序列号为 0；
+ *        序列号字节同样受 Checksum 保护
+ */
+TEST_F(WalReaderTest, ReadsSequencedRecords) {
+    std::string first = encode_sequenced_log_record(LogType::kPut, "key", "value");
+    seal_log_record(&first, 41);
+    std::string legacy = encode_log_record({LogType::kDelete, "old", ""});
+    std::string last = encode_sequenced_log_record(LogType::kBatch, "", std::string(300, 'b'));
+    seal_log_record(&last, (uint64_t{1} << 40) + 7);
+    {
+        std::ofstream out(path_, std::ios::binary | std::ios::trunc);
+        for (const std::string* r : {&first, &legacy, &last}) {
+            out.write(r->data(), static_cast<std::streamsize>(r->size()));
+        }
+    }
+
+    WalReader reader(path_, 64);
+    LogRecordView view;
+    ASSERT_EQ(reader.next(view), WalReader::Status::kRecord);
+    EXPECT_EQ(view.type, LogType::kPut);
+    EXPECT_EQ(view.key, "key");
+    EXPECT_EQ(view.value, "value");
+    EXPECT_EQ(view.sequence, 41u);
+    EXPECT_EQ(view.size, first.size());
+    ASSERT_EQ(reader.next(view), WalReader::Status::kRecord);
+    EXPECT_EQ(view.type, LogType::kDelete);
+    EXPECT_EQ(view.sequence, 0u);
+    ASSERT_EQ(reader.next(view), WalReader::Status::kRecord);
+    EXPECT_EQ(view.type, LogType::kBatch);
+    EXPECT_EQ(view.value.size(), 300u);
+    EXPECT_EQ(view.sequence, (uint64_t{1} << 40) + 7);
+    EXPECT_EQ(reader.next(view), WalReader::Status::kEof);
+
+    // 篡改序列号
+    {
+        std::fstream f(path_, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(static_cast<std::streamoff>(first.size() - 1));
+        f.put('\x01');
+    }
+    WalReader corrupted(path_);
+    EXPECT_EQ(corrupted.next(view), WalReader::Status::kCorrupted);
+}
+
+/**
+ * @brief 预分配或复用段留下的全零区域：完整的全零 Header 与不足一个 Header 的零尾都视为 kEof
+ */
+TEST_F(WalReaderTest, ZeroPaddingIsEndOfLog) {
+    write_records({{LogType::kPut, encode_int_key(1), "v1"}});
+    uint64_t end = fs::file_size(path_);
+
+    for (uint64_t padding : {uint64_t{4096}, uint64_t{kLogRecordHeaderSize - 1}}) {
+        fs::resize_file(path_, end + padding);
+        WalReader reader(path_, 64);
+        LogRecordView view;
+        ASSERT_EQ(reader.next(view), WalReader::Status::kRecord);
+        EXPECT_EQ(reader.next(view), WalReader::Status::kEof) << "padding " << padding;
+        EXPECT_EQ(reader.offset(), end);
+    }
+}
+
+/**
+ * @brief decode_log_record：内存中的记录与文件中的格式相同，长度不足或 Checksum 不匹配时返回 false
+ */
+TEST(DecodeLogRecordTest, ParsesRecordFromMemory) {
+    std::string record = encode_sequenced_log_record(LogType::kBatch, "term", "payload");
+    seal_log_record(&record, 99);
+    std::string data = record + "trailing bytes";
+
+    LogRecordView view;
+    ASSERT_TRUE(decode_log_record(data, &view));
+    EXPECT_EQ(view.type, LogType::kBatch);
+    EXPECT_EQ(view.key, "term");
+    EXPECT_EQ(view.value, "payload");
+    EXPECT_EQ(view.sequence, 99u);
+    EXPECT_EQ(view.size, record.size());
+
+    EXPECT_FALSE(decode_log_record(std::string_view(record).substr(0, record.size() - 1), &view));
+    record[kLogRecordHeaderSize] ^= 1;
+    EXPECT_FALSE(decode_log_record(record, &view));
+}
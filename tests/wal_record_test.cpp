@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include "wal_record.h"
+#include <cstring>
+#include <limits>
+#include <string>
 #include <vector>
 
 // 验证 CRC32 算法的正确性
@@ -37,9 +40,10 @@ TEST(WALRecordTest, EncodePutRecord) {
     EXPECT_EQ(key_len, 3);
     EXPECT_EQ(val_len, 3);
 
-    // 3. 验证 Type (kPut=0)
+    // 3. 验证 Type (kPut=0)，最高位为 CRC32C 格式标志
     uint8_t type_val = static_cast<uint8_t>(encoded[12]);
-    EXPECT_EQ(type_val, 0);
+    EXPECT_EQ(type_val & kLogTypeMask, 0);
+    EXPECT_EQ(type_val & kLogTypeCrc32cFlag, kLogTypeCrc32cFlag);
 
     // 4. 验证 Payload
     std::string key_payload(encoded.data() + 13, 3);
@@ -48,11 +52,11 @@ TEST(WALRecordTest, EncodePutRecord) {
     EXPECT_EQ(val_payload, "val");
 
     // 5. 验证 Checksum
-    // Checksum 是对 encoded[4...end] 的 CRC32
+    // Checksum 是对 encoded[4...end] 的 CRC32C
     uint32_t stored_checksum = 0;
     memcpy(&stored_checksum, encoded.data(), 4);
     
-    uint32_t calculated_checksum = crc32(encoded.data() + 4, encoded.size() - 4);
+    uint32_t calculated_checksum = crc32c(encoded.data() + 4, encoded.size() - 4);
     EXPECT_EQ(stored_checksum, calculated_checksum);
 }
 
@@ -69,7 +73,7 @@ TEST(WALRecordTest, EncodeDeleteRecord) {
 
     // 验证 Type (kDelete=1)
     uint8_t type_val = static_cast<uint8_t>(encoded[12]);
-    EXPECT_EQ(type_val, 1);
+    EXPECT_EQ(type_val & kLogTypeMask, 1);
     
     // 验证 KeyLen
     uint32_t key_len = 0;
@@ -84,6 +88,112 @@ TEST(WALRecordTest, EncodeDeleteRecord) {
     // 验证 Checksum
     uint32_t stored_checksum = 0;
     memcpy(&stored_checksum, encoded.data(), 4);
-    uint32_t calculated_checksum = crc32(encoded.data() + 4, encoded.size() - 4);
+    uint32_t calculated_checksum = crc32c(encoded.data() + 4, encoded.size() - 4);
     EXPECT_EQ(stored_checksum, calculated_checksum);
 }
+
+// 旧格式（CRC32）编码仍然可用：Type 最高位为 0，Checksum 为 CRC32
+TEST(WALRecordTest, EncodeLegacyCrc32Record) {
+    LogRecord record{LogType::kPut, "key", "val"};
+    std::string encoded = encode_log_record(record, ChecksumType::kCrc32, KeyEncoding::kDecimal);
+
+    EXPECT_EQ(encoded.size(), 19);
+    EXPECT_EQ(static_cast<uint8_t>(encoded[12]), 0);
+
+    uint32_t stored_checksum = 0;
+    memcpy(&stored_checksum, encoded.data(), 4);
+    EXPECT_EQ(stored_checksum, crc32(encoded.data() + 4, encoded.size() - 4));
+}
+
+// CRC32C 标准测试向量
+TEST(CRC32CTest, StandardVectors) {
+    EXPECT_EQ(crc32c("123456789", 9), 0xE3069283u);
+    EXPECT_EQ(crc32c("", 0), 0u);
+
+    // RFC 3720 (iSCSI) B.4：32 字节全 0 / 全 0xFF
+    std::string zeros(32, '\0');
+    EXPECT_EQ(crc32c(zeros.data(), zeros.size()), 0x8A9136AAu);
+    std::string ones(32, static_cast<char>(0xFF));
+    EXPECT_EQ(crc32c(ones.data(), ones.size()), 0x62A8AB43u);
+}
+
+// 硬件实现（若可用）与 Slicing-by-8 实现在各种长度与对齐下结果一致
+TEST(CRC32CTest, ImplementationsAgree) {
+    std::string data(1024 + 7, '\0');
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>((i * 131 + 7) & 0xFF);
+    }
+    for (size_t offset = 0; offset < 8; ++offset) {
+        for (size_t len : {0u, 1u, 7u, 8u, 9u, 63u, 64u, 1000u}) {
+            uint32_t software =
+                ~crc_detail::extend_slicing8<crc_detail::kCrc32cPoly>(0xFFFFFFFF, data.data() + offset, len);
+            EXPECT_EQ(crc32c(data.data() + offset, len), software)
+                << "impl=" << crc32c_implementation() << " offset=" << offset << " len=" << len;
+        }
+    }
+}
+
+// 分段累加计算与一次性计算结果一致
+TEST(CRC32CTest, ExtendMatchesWhole) {
+    const char* data = "hello, distributed kv";
+    size_t n = std::strlen(data);
+    for (size_t split = 0; split <= n; ++split) {
+        uint32_t part = crc32c_extend(crc32c(data, split), data + split, n - split);
+        EXPECT_EQ(part, crc32c(data, n));
+    }
+}
+
+// 查表版 CRC32 与原始逐 bit 算法结果一致
+TEST(CRC32Test, TableDrivenMatchesBitwise) {
+    auto bitwise = [](const char* data, size_t length) {
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t i = 0; i < length; i++) {
+            crc ^= static_cast<uint8_t>(data[i]);
+            for (int j = 0; j < 8; j++) {
+                uint32_t mask = -(crc & 1);
+                crc = (crc >> 1) ^ (0xEDB88320 & mask);
+            }
+        }
+        return ~crc;
+    };
+    std::string data(517, '\0');
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<char>(i * 37);
+    for (size_t len = 0; len <= data.size(); len += 11) {
+        EXPECT_EQ(crc32(data.data(), len), bitwise(data.data(), len)) << "len=" << len;
+    }
+}
+
+// int Key 的二进制编码保序：memcmp 顺序与 int 大小顺序一致
+TEST(KeyCodingTest, IntKeyEncodingPreservesOrder) {
+    std::vector<int> keys = {std::numeric_limits<int>::min(), -100000, -1, 0, 1, 255, 256, 100000,
+                             std::numeric_limits<int>::max()};
+    for (size_t i = 0; i + 1 < keys.size(); ++i) {
+        EXPECT_LT(encode_int_key(keys[i]), encode_int_key(keys[i + 1]));
+    }
+    for (int k : keys) {
+        int decoded = 0;
+        ASSERT_TRUE(decode_int_key(encode_int_key(k), &decoded));
+        EXPECT_EQ(decoded, k);
+    }
+    int unused = 0;
+    EXPECT_FALSE(decode_int_key("abc", &unused));
+}
+
+// Type 字节中的 Key 编码标志位，以及旧格式十进制 Key 的解析
+TEST(KeyCodingTest, DecodeLogKeyHonoursEncoding) {
+    LogRecord record{LogType::kPut, encode_int_key(7), "v"};
+    std::string encoded = encode_log_record(record);
+    EXPECT_EQ(static_cast<uint8_t>(encoded[12]) & kLogTypeBinaryKeyFlag, kLogTypeBinaryKeyFlag);
+
+    // 二进制 Key 原样返回（指向输入，不拷贝）；旧格式的十进制 Key 转换为 encode_int_key
+    std::string scratch;
+    std::string_view key;
+    std::string binary("a\0b", 3);
+    EXPECT_TRUE(decode_log_key(binary, KeyEncoding::kBinary, &scratch, &key));
+    EXPECT_EQ(key.data(), binary.data());
+    EXPECT_EQ(key, binary);
+    EXPECT_TRUE(decode_log_key("-15", KeyEncoding::kDecimal, &scratch, &key));
+    EXPECT_EQ(key, encode_int_key(-15));
+    EXPECT_FALSE(decode_log_key("12a", KeyEncoding::kDecimal, &scratch, &key));
+    EXPECT_FALSE(decode_log_key("", KeyEncoding::kDecimal, &scratch, &key));
+}
@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include "wal_reader.h"
+#include "wal_writer.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @file wal_writer_test.cpp
+ * @brief WalWriter（WAL 段写入器）的单元测试：预分配、截断、复用段的结束标记与 O_DIRECT
+ */
+
+namespace fs = std::filesystem;
+
+class WalWriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = "test_data_wal_writer";
+        fs::remove_all(dir_);
+        fs::create_directories(dir_);
+        path_ = fs::path(dir_) / "wal.log";
+    }
+
+    void TearDown() override { fs::remove_all(dir_); }
+
+    static std::string record(int i, size_t value_size) {
+        return encode_log_record({LogType::kPut, encode_int_key(i), std::string(value_size, 'a' + (i % 26))});
+    }
+
+    /// 顺序读出全部记录的 Key，直到第一个非 kRecord 的状态
+    std::vector<std::string> read_keys(WalReader::Status* status = nullptr) const {
+        WalReader reader(path_, 64);
+        std::vector<std::string> keys;
+        LogRecordView view;
+        WalReader::Status s;
+        while ((s = reader.next(view)) == WalReader::Status::kRecord) keys.emplace_back(view.key);
+        if (status) *status = s;
+        return keys;
+    }
+
+    std::string dir_;
+    fs::path path_;
+};
+
+/**
+ * @brief 预分配后文件大小固定，读取在预分配的零处正常结束；关闭时截断到实际长度
+ */
+TEST_F(WalWriterTest, PreallocatesAndTruncatesOnClose) {
+    WalWriterOptions options;
+    options.preallocate_size = 64 * 1024;
+    uint64_t written = 0;
+    {
+        WalWriter writer(path_, 0, /*reuse=*/false, options);
+        for (int i = 0; i < 10; ++i) {
+            std::string r = record(i, 100);
+            writer.append(r);
+            written += r.size();
+        }
+        writer.sync();
+        EXPECT_EQ(writer.size(), written);
+        EXPECT_EQ(fs::file_size(path_), options.preallocate_size);
+
+        WalReader::Status status;
+        EXPECT_EQ(read_keys(&status).size(), 10u);
+        EXPECT_EQ(status, WalReader::Status::kEof);
+    }
+    EXPECT_EQ(fs::file_size(path_), written);
+    EXPECT_EQ(read_keys().size(), 10u);
+}
+
+/**
+ * @brief 从有效前缀处重新打开：之后的残留内容被截断，新记录紧接着写入
+ */
+TEST_F(WalWriterTest, ReopenAtOffsetDiscardsGarbage) {
+    std::string first = record(1, 10);
+    {
+        std::ofstream out(path_, std::ios::binary | std::ios::trunc);
+        out.write(first.data(), static_cast<std::streamsize>(first.size()));
+        out.write("garbage", 7);
+    }
+    {
+        WalWriter writer(path_, first.size(), /*reuse=*/false);
+        EXPECT_EQ(fs::file_size(path_), first.size());
+        writer.append(record(2, 10));
+    }
+    std::vector<std::string> keys = read_keys();
+    ASSERT_EQ(keys.size(), 2u);
+    EXPECT_EQ(keys[1], encode_int_key(2));
+}
+
+/**
+ * @brief truncate：丢弃后缀后重新预分配，被丢弃的记录读出为零（日志结尾），新记录从截断处写入
+ */
+TEST_F(WalWriterTest, TruncateDiscardsSuffix) {
+    WalWriterOptions options;
+    options.preallocate_size = 16 * 1024;
+    WalWriter writer(path_, 0, /*reuse=*/false, options);
+    std::vector<uint64_t> offsets;
+    for (int i = 0; i < 5; ++i) {
+        offsets.push_back(writer.size());
+        writer.append(record(i, 100));
+    }
+
+    writer.truncate(offsets[2]);
+    EXPECT_EQ(writer.size(), offsets[2]);
+    EXPECT_EQ(fs::file_size(path_), options.preallocate_size);
+    WalReader::Status status;
+    EXPECT_EQ(read_keys(&status).size(), 2u);
+    EXPECT_EQ(status, WalReader::Status::kEof);
+
+    writer.append(record(7, 10));
+    writer.sync();
+    std::vector<std::string> keys = read_keys(&status);
+    ASSERT_EQ(keys.size(), 3u);
+    EXPECT_EQ(keys[2], encode_int_key(7));
+    EXPECT_EQ(status, WalReader::Status::kEof);
+    EXPECT_THROW(writer.truncate(writer.size() + 1), std::runtime_error);
+}
+
+/**
+ * @brief 复用旧段：旧记录完整且校验通过，但结束标记让读取停在新写入的记录之后
+ */
+TEST_F(WalWriterTest, ReusedSegmentHidesStaleRecords) {
+    {
+        WalWriter writer(path_, 0, /*reuse=*/false);
+        for (int i = 0; i < 20; ++i) writer.append(record(i, 50));
+    }
+    uint64_t old_size = fs::file_size(path_);
+
+    WalWriter writer(path_, 0, /*reuse=*/true);
+    EXPECT_TRUE(writer.reused());
+    WalReader::Status status;
+    EXPECT_TRUE(read_keys(&status).empty()) << "terminator is written on open";
+    EXPECT_EQ(status, WalReader::Status::kEof);
+
+    writer.append(record(100, 50));
+    writer.append(record(101, 50));
+    std::vector<std::string> keys = read_keys(&status);
+    ASSERT_EQ(keys.size(), 2u);
+    EXPECT_EQ(keys[0], encode_int_key(100));
+    EXPECT_EQ(keys[1], encode_int_key(101));
+    EXPECT_EQ(status, WalReader::Status::kEof);
+    EXPECT_EQ(fs::file_size(path_), old_size) << "reuse does not reallocate";
+
+    writer.close(/*truncate=*/true);
+    EXPECT_EQ(fs::file_size(path_), writer.size());
+}
+
+/**
+ * @brief O_DIRECT：任意长度的记录经对齐缓冲区写入，重新打开到非对齐偏移后继续追加，内容完整
+ *
+ * 文件系统不支持 O_DIRECT 时退回普通写入，断言同样成立。
+ */
+TEST_F(WalWriterTest, DirectIoRoundTrip) {
+    WalWriterOptions options;
+    options.preallocate_size = 256 * 1024;
+    options.direct_io = true;
+
+    std::vector<std::string> expected;
+    uint64_t written = 0;
+    {
+        WalWriter writer(path_, 0, /*reuse=*/false, options);
+        for (int i = 0; i < 100; ++i) {
+            std::string r = record(i, static_cast<size_t>(i * 37 % 5000));
+            writer.append(r);
+            written += r.size();
+            expected.push_back(encode_int_key(i));
+        }
+        writer.sync();
+        EXPECT_EQ(writer.size(), written);
+    }
+    EXPECT_EQ(fs::file_size(path_), written);
+    EXPECT_NE(written % WalWriter::kDirectIoAlignment, 0u);
+
+    {
+        WalWriter writer(path_, written, /*reuse=*/false, options);
+        for (int i = 100; i < 110; ++i) {
+            writer.append(record(i, 3000));
+            expected.push_back(encode_int_key(i));
+        }
+    }
+    EXPECT_EQ(read_keys(), expected);
+}
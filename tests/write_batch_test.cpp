@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include "write_batch.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @file write_batch_test.cpp
+ * @brief WriteBatch 编解码的单元测试
+ */
+
+namespace {
+struct Op {
+    LogType type;
+    std::string key;
+    std::string value;
+};
+
+std::vector<Op> collect(const WriteBatch& batch) {
+    std::vector<Op> ops;
+    bool ok = batch.iterate([&](LogType type, std::string_view key, std::string_view value) {
+        ops.push_back({type, std::string(key), std::string(value)});
+    });
+    EXPECT_TRUE(ok);
+    return ops;
+}
+} // namespace
+
+/**
+ * @brief 新建批次为空，只有 4 字节的 Count 头
+ */
+TEST(WriteBatchTest, EmptyBatch) {
+    WriteBatch batch;
+    EXPECT_TRUE(batch.empty());
+    EXPECT_EQ(batch.count(), 0u);
+    EXPECT_EQ(batch.byte_size(), 4u);
+    EXPECT_TRUE(collect(batch).empty());
+}
+
+/**
+ * @brief Put/Delete 按追加顺序被遍历出来
+ */
+TEST(WriteBatchTest, IteratePreservesOrder) {
+    WriteBatch batch;
+    batch.put(1, "one");
+    batch.del(2);
+    batch.put(1, "uno");
+
+    EXPECT_EQ(batch.count(), 3u);
+    auto ops = collect(batch);
+    ASSERT_EQ(ops.size(), 3u);
+    EXPECT_EQ(ops[0].type, LogType::kPut);
+    EXPECT_EQ(ops[0].key, encode_int_key(1));
+    EXPECT_EQ(ops[0].value, "one");
+    EXPECT_EQ(ops[1].type, LogType::kDelete);
+    EXPECT_EQ(ops[1].key, encode_int_key(2));
+    EXPECT_EQ(ops[2].value, "uno");
+}
+
+/**
+ * @brief 任意字节串 Key（含 '\0'、空 Key）原样保存
+ */
+TEST(WriteBatchTest, BinaryKeys) {
+    std::string binary("k\0\xff", 3);
+    WriteBatch batch;
+    batch.put(binary, "v");
+    batch.put("", "empty");
+    batch.del("user:42");
+
+    auto ops = collect(batch);
+    ASSERT_EQ(ops.size(), 3u);
+    EXPECT_EQ(ops[0].key, binary);
+    EXPECT_EQ(ops[1].key, "");
+    EXPECT_EQ(ops[1].value, "empty");
+    EXPECT_EQ(ops[2].type, LogType::kDelete);
+    EXPECT_EQ(ops[2].key, "user:42");
+}
+
+/**
+ * @brief clear() 之后可以复用
+ */
+TEST(WriteBatchTest, ClearResets) {
+    WriteBatch batch;
+    batch.put(1, "one");
+    batch.clear();
+    EXPECT_TRUE(batch.empty());
+    EXPECT_EQ(batch.byte_size(), 4u);
+
+    batch.put(5, "five");
+    auto ops = collect(batch);
+    ASSERT_EQ(ops.size(), 1u);
+    EXPECT_EQ(ops[0].key, encode_int_key(5));
+}
+
+/**
+ * @brief 截断或多余字节的负载都应被 validate 拒绝
+ */
+TEST(WriteBatchTest, ValidateRejectsMalformedRep) {
+    WriteBatch batch;
+    batch.put(1, "value");
+    batch.put(2, "value2");
+    const std::string& rep = batch.rep();
+
+    EXPECT_TRUE(WriteBatch::validate(rep));
+    EXPECT_FALSE(WriteBatch::validate(std::string_view(rep).substr(0, rep.size() - 1)));
+    EXPECT_FALSE(WriteBatch::validate(rep + "x"));
+    EXPECT_FALSE(WriteBatch::validate(std::string_view(rep).substr(0, 2)));
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include "write_controller.h"
+
+#include <chrono>
+
+using namespace std::chrono_literals;
+
+/**
+ * @brief 桶内配额（1ms 的量）用完之前不等待，之后按字节数 / 速率等待
+ */
+TEST(WriteControllerTest, DelaysProportionallyToBytes) {
+    WriteController controller;
+    auto now = WriteController::Clock::now();
+    constexpr uint64_t kRate = 1 << 20;  // 1MB/s，桶容量约 1048 字节
+
+    EXPECT_EQ(controller.GetDelay(1000, kRate, now).count(), 0);
+    auto delay = controller.GetDelay(1 << 20, kRate, now);
+    EXPECT_NEAR(std::chrono::duration<double>(delay).count(), 1.0, 0.01);
+
+    // 等待结束时配额恰好补回到 0，下一批继续按自身大小等待
+    now += delay;
+    delay = controller.GetDelay(1 << 19, kRate, now);
+    EXPECT_NEAR(std::chrono::duration<double>(delay).count(), 0.5, 0.01);
+}
+
+/**
+ * @brief 空闲期间积累的配额以桶容量为上限，不会在恢复写入时放出一大批
+ */
+TEST(WriteControllerTest, IdleTimeIsCappedByBurst) {
+    WriteController controller;
+    auto now = WriteController::Clock::now();
+    constexpr uint64_t kRate = 1 << 20;
+    controller.GetDelay(1, kRate, now);
+
+    now += 10s;
+    auto delay = controller.GetDelay(1 << 20, kRate, now);
+    EXPECT_GT(std::chrono::duration<double>(delay).count(), 0.99);
+}
+
+/**
+ * @brief 速率降低后同样大小的写入等待更久
+ */
+TEST(WriteControllerTest, LowerRateMeansLongerDelay) {
+    WriteController fast;
+    WriteController slow;
+    auto now = WriteController::Clock::now();
+    auto fast_delay = fast.GetDelay(1 << 20, 4 << 20, now);
+    auto slow_delay = slow.GetDelay(1 << 20, 1 << 20, now);
+    EXPECT_GT(slow_delay, fast_delay * 3);
+}